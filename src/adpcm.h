@@ -0,0 +1,91 @@
+/**
+ * @file adpcm.h
+ * @brief IMA-ADPCM（4ビット）エンコーダー/デコーダー - ヘッダーファイル
+ *
+ * ルーパーの圧縮メモリとサンプルプレーヤーのフラッシュ上のサンプルで共通に使う。
+ * 1サンプルずつの関数だけを用意し、ブロック構造やニブルの並びは呼び出し側で決める。
+ * （tools/wav2bank.py のエンコーダーもこれと同じ計算をする）
+ */
+
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <stdint.h>
+
+#define ADPCM_MAX_INDEX  88
+
+extern const int16_t adpcm_step_table[ADPCM_MAX_INDEX + 1];
+extern const int8_t adpcm_index_table[16];
+
+/**
+ * @brief エンコーダー/デコーダーの状態
+ */
+typedef struct {
+    int32_t predictor;   // 予測値（直前の復号サンプル）
+    int32_t index;       // ステップテーブルの位置（0-88）
+} adpcm_state_t;
+
+/**
+ * @brief 4ビットコードから差分を求める（エンコード/デコード共通）
+ */
+static inline int32_t adpcm_delta(uint8_t code, int32_t step) {
+    int32_t delta = step >> 3;
+    if (code & 4) delta += step;
+    if (code & 2) delta += step >> 1;
+    if (code & 1) delta += step >> 2;
+    return (code & 8) ? -delta : delta;
+}
+
+/**
+ * @brief 予測値とステップ位置を更新
+ */
+static inline void adpcm_update(adpcm_state_t *state, uint8_t code, int32_t step) {
+    int32_t predictor = state->predictor + adpcm_delta(code, step);
+    if (predictor > 32767) predictor = 32767;
+    if (predictor < -32768) predictor = -32768;
+    state->predictor = predictor;
+
+    int32_t index = state->index + adpcm_index_table[code];
+    if (index < 0) index = 0;
+    if (index > ADPCM_MAX_INDEX) index = ADPCM_MAX_INDEX;
+    state->index = index;
+}
+
+/**
+ * @brief 1サンプルをデコード
+ * @param state 状態（更新される）
+ * @param code 4ビットコード
+ * @return 復号サンプル
+ */
+static inline int16_t adpcm_decode_sample(adpcm_state_t *state, uint8_t code) {
+    adpcm_update(state, code, adpcm_step_table[state->index]);
+    return (int16_t)state->predictor;
+}
+
+/**
+ * @brief 1サンプルをエンコード
+ *
+ * デコーダーと同じ計算で予測値を更新するので、量子化誤差は蓄積しない。
+ *
+ * @param state 状態（更新される）
+ * @param sample 入力サンプル
+ * @return 4ビットコード
+ */
+static inline uint8_t adpcm_encode_sample(adpcm_state_t *state, int16_t sample) {
+    int32_t step = adpcm_step_table[state->index];
+    int32_t diff = sample - state->predictor;
+    uint8_t code = 0;
+
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+    if (diff >= step) { code |= 4; diff -= step; }
+    if (diff >= (step >> 1)) { code |= 2; diff -= step >> 1; }
+    if (diff >= (step >> 2)) { code |= 1; }
+
+    adpcm_update(state, code, step);
+    return code;
+}
+
+#endif // ADPCM_H
@@ -0,0 +1,92 @@
+/**
+ * @file audio_block.c
+ * @brief インターリーブ/プレーナー変換カーネル
+ *
+ * 2フレーム（= 入力2ワード）ずつ読み、L と R をそれぞれ1ワードにまとめて書く。
+ * ループ内で分岐しないので、サンプルごとに16ビットアクセスするより
+ * ロード/ストアの回数が半分になる。端数の1フレームは最後に処理する。
+ */
+
+#include "audio_block.h"
+
+#include <string.h>
+
+// ============================================================================
+// ワードアクセス
+// ============================================================================
+
+// リングバッファの途中などから呼ばれると4バイト境界とは限らないので memcpy でアクセスする
+// （Cortex-M33 では1命令の非アラインロード/ストアになる）
+static inline uint32_t load_u32(const int16_t *p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline void store_u32(int16_t *p, uint32_t w) {
+    memcpy(p, &w, sizeof(w));
+}
+
+// ============================================================================
+// デインターリーブ（SBC 入力境界）
+// ============================================================================
+
+void audio_block_deinterleave(const int16_t *src, int16_t *left, int16_t *right,
+                              uint32_t num_samples) {
+    uint32_t pairs = num_samples / 2;
+
+    for (uint32_t i = 0; i < pairs; i++) {
+        // リトルエンディアン: 1ワード = R << 16 | L
+        uint32_t w0 = load_u32(&src[i * 4]);
+        uint32_t w1 = load_u32(&src[i * 4 + 2]);
+
+        store_u32(&left[i * 2], (w0 & 0xFFFFu) | (w1 << 16));
+        store_u32(&right[i * 2], (w0 >> 16) | (w1 & 0xFFFF0000u));
+    }
+
+    if (num_samples & 1) {
+        uint32_t last = num_samples - 1;
+        left[last] = src[last * 2];
+        right[last] = src[last * 2 + 1];
+    }
+}
+
+void audio_block_mono_to_planar(const int16_t *src, int16_t *left, int16_t *right,
+                                uint32_t num_samples) {
+    memcpy(left, src, num_samples * sizeof(int16_t));
+    memcpy(right, src, num_samples * sizeof(int16_t));
+}
+
+// ============================================================================
+// インターリーブ
+// ============================================================================
+
+void audio_block_interleave(const int16_t *left, const int16_t *right, int16_t *dst,
+                            uint32_t num_samples) {
+    uint32_t pairs = num_samples / 2;
+
+    for (uint32_t i = 0; i < pairs; i++) {
+        uint32_t l = load_u32(&left[i * 2]);
+        uint32_t r = load_u32(&right[i * 2]);
+
+        store_u32(&dst[i * 4], (l & 0xFFFFu) | (r << 16));
+        store_u32(&dst[i * 4 + 2], (l >> 16) | (r & 0xFFFF0000u));
+    }
+
+    if (num_samples & 1) {
+        uint32_t last = num_samples - 1;
+        dst[last * 2] = left[last];
+        dst[last * 2 + 1] = right[last];
+    }
+}
+
+// ============================================================================
+// I2S パッキング境界
+// ============================================================================
+
+void audio_block_pack_i2s_words(const int16_t *left, const int16_t *right, uint32_t *dst,
+                                uint32_t num_samples) {
+    for (uint32_t i = 0; i < num_samples; i++) {
+        dst[i] = audio_block_pack_i2s(left[i], right[i]);
+    }
+}
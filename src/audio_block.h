@@ -0,0 +1,66 @@
+/**
+ * @file audio_block.h
+ * @brief 処理チェーン内部のプレーナー（L/R分離）ブロック - ヘッダーファイル
+ *
+ * DSPチェーン内部では L と R を別々の 32バイト境界の配列で扱い、
+ * インターリーブ/デインターリーブは SBC 入力と I2S パッキングの境界だけで行う。
+ * 変換は 32ビットワード単位（2フレームずつ）で行う。
+ */
+
+#ifndef AUDIO_BLOCK_H
+#define AUDIO_BLOCK_H
+
+#include <stdint.h>
+
+// プレーナーバッファのアライメント（バイト）
+#define AUDIO_BLOCK_ALIGN  32
+#define AUDIO_ALIGNED      __attribute__((aligned(AUDIO_BLOCK_ALIGN)))
+
+/**
+ * @brief インターリーブ（LRLR...）をプレーナー（L..., R...）に分離
+ * @param src 入力（ステレオインターリーブ）
+ * @param left 左チャンネル出力
+ * @param right 右チャンネル出力
+ * @param num_samples ステレオペア数
+ */
+void audio_block_deinterleave(const int16_t *src, int16_t *left, int16_t *right,
+                              uint32_t num_samples);
+
+/**
+ * @brief モノラル入力を左右両方にコピー
+ * @param src 入力（モノラル）
+ * @param left 左チャンネル出力
+ * @param right 右チャンネル出力
+ * @param num_samples サンプル数
+ */
+void audio_block_mono_to_planar(const int16_t *src, int16_t *left, int16_t *right,
+                                uint32_t num_samples);
+
+/**
+ * @brief プレーナーをインターリーブ（LRLR...）に結合
+ * @param left 左チャンネル入力
+ * @param right 右チャンネル入力
+ * @param dst 出力（ステレオインターリーブ）
+ * @param num_samples ステレオペア数
+ */
+void audio_block_interleave(const int16_t *left, const int16_t *right, int16_t *dst,
+                            uint32_t num_samples);
+
+/**
+ * @brief L/R 1フレームを I2S のワード形式（上位16ビット=左、下位16ビット=右）にパック
+ */
+static inline uint32_t audio_block_pack_i2s(int16_t left, int16_t right) {
+    return ((uint32_t)(uint16_t)left << 16) | (uint16_t)right;
+}
+
+/**
+ * @brief プレーナーを I2S のワード形式の配列に変換
+ * @param left 左チャンネル入力
+ * @param right 右チャンネル入力
+ * @param dst 出力ワード配列
+ * @param num_samples ステレオペア数
+ */
+void audio_block_pack_i2s_words(const int16_t *left, const int16_t *right, uint32_t *dst,
+                                uint32_t num_samples);
+
+#endif // AUDIO_BLOCK_H
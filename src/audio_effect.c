@@ -8,11 +8,22 @@
 
 #include "audio_effect.h"
 #include "config.h"
+#include "compressor.h"
+#include "transient_detector.h"
+#include "audio_block.h"
+#include "mod_matrix.h"
+#include "beat_clock.h"
+#include "trace.h"
+#include "sram_layout.h"
+#include "adpcm.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <math.h>
 
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
 // ============================================================================
 // 定数定義
 // ============================================================================
@@ -21,6 +32,13 @@
 // 44100Hz * 1秒 = 44100サンプル（ステレオペア）
 #define MAX_SLICE_LENGTH  (AUDIO_SAMPLE_RATE * 1)
 
+// Beat-Slicer の履歴長（フレーム数）
+// スライスバッファの領域を IMA-ADPCM（4ビット）のニブル列として使うので PCM の4倍 = 4秒
+#define SLICER_HISTORY_FRAMES  (MAX_SLICE_LENGTH * 4)
+
+// 小節あたりの拍数（スライサーはビートクロックの小節頭から始める）
+#define BEATS_PER_BAR  4
+
 // パラメータ検証の定数
 #define MIN_SLICE_LENGTH       128     // 最小スライス長（約3ms @ 44.1kHz）
 #define MIN_REPEAT_COUNT       1       // 最小リピート回数
@@ -41,31 +59,109 @@
 #define MAX_SLICE_PROBABILITY  1.0f    // 最大スライス確率
 #define MAX_CLOCK_DIVIDER      8       // 最大クロック分周
 
+// トランジェントトリガーの検証定数
+#define MIN_TRANSIENT_THRESHOLD       1.2f     // 最小しきい値（速い/遅い の比）
+#define MAX_TRANSIENT_THRESHOLD       20.0f    // 最大しきい値
+#define MIN_TRANSIENT_REFRACTORY_MS   10.0f    // 最小不応期（チャンク 5.8ms より長く、検出はチャンクに1回まで）
+#define MAX_TRANSIENT_REFRACTORY_MS   2000.0f  // 最大不応期
+
 // オーディオ処理の定数
-#define STEREO_CHANNELS        2       // ステレオチャンネル数
-#define LEFT_CHANNEL           0       // 左チャンネルオフセット
-#define RIGHT_CHANNEL          1       // 右チャンネルオフセット
 #define SAMPLE_MAX             32767   // 16ビットPCM最大値
 #define SAMPLE_MIN             -32768  // 16ビットPCM最小値
+#define NUM_PITCH_MODES        4       // pitch_mode_t の数
+
+// 特殊化カーネルで1回に処理するフレーム数（ダッキングゲインの作業バッファ長）
+#define EFFECT_CHUNK_FRAMES    256
 
 // ============================================================================
 // 内部変数
 // ============================================================================
 
-// エフェクトパラメータ（現在の設定）
+// エフェクトパラメータ
+// base_params = 設定値、current_params = モジュレーションを適用した値（チャンクごとに更新）
+static beat_repeat_params_t base_params;
 static beat_repeat_params_t current_params;
 
-// スライスバッファ（ステレオインターリーブ形式）
+// スライス長を範囲内に丸めた回数（パラメータ更新ごとに呼ばれるのでログは出さず数える）
+static uint32_t slice_clamps = 0;
+
+// スライスバッファ（プレーナー形式、L/R 別配列）
 // メモリ使用量: 44100 * 2 * 2 = 176,400 バイト (約172 KB)
-static int16_t slice_buffer[MAX_SLICE_LENGTH * 2];  // ステレオなので2倍
+// エフェクトが無効な間はルーパーに丸ごと貸すので、L/R を1つの配列に並べておく
+static int16_t slice_buffer[2][MAX_SLICE_LENGTH] AUDIO_ALIGNED;
+#define slice_buffer_l (slice_buffer[0])
+#define slice_buffer_r (slice_buffer[1])
+static bool slice_memory_lent = false;  // ルーパーに貸している（返すまでエフェクトはスルー）
 
 // スライス状態管理
 static uint32_t slice_write_pos = 0;   // 書き込み位置
 static float slice_read_pos_f = 0.0f;  // 読み取り位置（ピッチシフト用、float）
 static uint32_t repeat_counter = 0;    // 現在のリピートカウント
 static bool is_repeating = false;      // リピート中フラグ
+static bool traced_repeating = false;  // トレースに記録したリピート状態
 static uint32_t pitch_mod_phase = 0;   // ピッチ変調用位相カウンタ
 
+// スライス長の小数部の累積（32.32 の下位32ビット）
+static uint32_t slice_frac_acc = 0;    // 累積した小数部
+static uint32_t slice_carry = 0;       // 現在のスライスに加える繰り上がり（0 or 1）
+
+// ウェットのダッキング用コンプレッサー（キー = ドライ入力）
+static compressor_t duck_comp;
+
+// チャンクごとのウェット量（Q16、モジュレーションのランプ）
+// チャンクの作業バッファはコア0のスタックに置かない
+static int32_t wet_gain_buf[EFFECT_CHUNK_FRAMES] AUDIO_ALIGNED;
+
+// マルチバンド用に残すエフェクト前のチャンク
+static int16_t dry_buf_l[EFFECT_CHUNK_FRAMES] AUDIO_ALIGNED;
+static int16_t dry_buf_r[EFFECT_CHUNK_FRAMES] AUDIO_ALIGNED;
+
+#if EFFECT_SPECIALISED_KERNELS
+// チャンクごとのダッキングゲイン（Q16）
+static int32_t duck_gain_buf[EFFECT_CHUNK_FRAMES] AUDIO_ALIGNED;
+#endif
+
+// トランジェントトリガーの状態
+static transient_detector_t transient_det;
+static bool transient_pending = false;   // スライスを取り直した（次の境界でリピート開始）
+static uint32_t last_slice_end = 0;      // 直前のスライスの長さ（取り直しで遡るときに使う）
+static uint32_t transient_triggers = 0;
+// 取り直しで遡った範囲を詰め直す作業バッファ（約1.4KB、コア0のスタックに置かない）
+static int16_t realign_buf_l[TRANSIENT_MAX_LOOKBACK_FRAMES + TRANSIENT_PREROLL_FRAMES];
+static int16_t realign_buf_r[TRANSIENT_MAX_LOOKBACK_FRAMES + TRANSIENT_PREROLL_FRAMES];
+static uint32_t transient_total_us = 0;
+static uint32_t transient_max_us = 0;
+static uint32_t transient_chunks = 0;
+
+// Beat-Slicer の状態（スライスバッファを ADPCM の循環する履歴として使う）
+static bool slicer_active = false;                   // スライサーで処理中
+static bool slicer_waiting = false;                  // 小節頭を待っている（ドライのまま通す）
+static bool slicer_has_bar = false;                  // 並べ替える小節が揃った
+static uint32_t history_pos = 0;                     // 次に書き込む履歴位置
+static uint32_t slicer_step = 0;                     // 現在のステップ
+static uint32_t slicer_step_pos = 0;                 // ステップ内の位置
+static uint32_t slicer_step_len = 0;                 // 現在のステップ長
+static uint32_t slicer_src_pos = 0;                  // 再生中スライスの次に読む履歴位置
+static uint32_t slicer_src_len = 0;                  // 再生中スライスの長さ
+static int16_t slicer_src_l = 0;                     // 再生中スライスの直前の復号サンプル
+static int16_t slicer_src_r = 0;
+static uint32_t slicer_refused_len = 0;              // 収まらないと報告したステップ長
+static adpcm_state_t slicer_enc[2];                  // 履歴のエンコーダー [L/R]
+static adpcm_state_t slicer_dec[2];                  // 再生中スライスのデコーダー [L/R]
+static uint32_t bar_start[2][SLICER_NUM_STEPS];      // [現在/直前の小節][ステップ] の履歴位置
+static uint32_t bar_len[2][SLICER_NUM_STEPS];        // [現在/直前の小節][ステップ] の長さ
+static adpcm_state_t bar_state[2][SLICER_NUM_STEPS][2];  // ステップ頭のエンコーダー状態
+
+// マルチバンド（エフェクト出力とドライ入力を帯域ごとに混ぜ直す）
+static crossover_t crossover;
+static uint32_t multiband_total_us = 0;
+static uint32_t multiband_max_us = 0;
+static uint32_t multiband_chunks = 0;
+
+// モジュレーションされたピッチ（PITCH_MODE_FIXED_REVERSE）のチャンク内ランプ
+static float pitch_ramp = 1.0f;        // 現在値
+static float pitch_ramp_step = 0.0f;   // 1フレームあたりの変化量
+
 // サンプリングレート
 static uint32_t sample_rate = AUDIO_SAMPLE_RATE;
 
@@ -93,6 +189,111 @@ static bool is_initialized = false;
 #define DEFAULT_CLOCK_DIVIDER        1                        // クロック分周なし
 #define DEFAULT_PITCH_MODE           PITCH_MODE_FIXED_REVERSE // 固定ピッチ
 #define DEFAULT_FREEZE               false                    // フリーズOFF
+#define DEFAULT_DUCK_ENABLED         EFFECT_DUCK_ENABLED      // ウェットダッキング
+#define DEFAULT_REPEAT_TRIGGER       REPEAT_TRIGGER_PROBABILITY // スライス確率で開始
+#define DEFAULT_TRANSIENT_THRESHOLD  TRANSIENT_DEFAULT_THRESHOLD
+#define DEFAULT_TRANSIENT_REFRACTORY TRANSIENT_DEFAULT_REFRACTORY_MS
+#define DEFAULT_SLICER_ENABLED       false                    // スライサーOFF
+#define DEFAULT_SLICER_PATTERN       SLICER_PATTERN_SHUFFLE   // シャッフル
+#define DEFAULT_MULTIBAND_ENABLED    false                    // マルチバンドOFF
+#define DEFAULT_BAND_MIX             100                      // 帯域ミックス 100%
+
+// ============================================================================
+// マルチバンド
+// ============================================================================
+
+/**
+ * @brief 帯域ごとのリピート有効/ミックスをクロスオーバーの重みに変換
+ *
+ * 重みはエフェクト出力（ウェットミックス適用済み）に対する割合なので、
+ * ウェットミックスのモジュレーションはそのまま全帯域に効く。
+ */
+static void update_band_gains(void) {
+    int32_t gains[CROSSOVER_MAX_BANDS];
+    for (int b = 0; b < CROSSOVER_MAX_BANDS; b++) {
+        gains[b] = base_params.band_repeat[b] ?
+            (int32_t)base_params.band_mix[b] * CROSSOVER_UNITY_GAIN / MAX_WET_MIX : 0;
+    }
+    crossover_set_band_gains(&crossover, gains);
+}
+
+/**
+ * @brief チャンクのエフェクト出力を帯域ごとにドライと混ぜ直す
+ */
+static void apply_multiband(int16_t *left, int16_t *right,
+                            const int16_t *dry_l, const int16_t *dry_r, uint32_t frames) {
+    uint32_t start_us = time_us_32();
+
+    crossover_process(&crossover, 0, dry_l, left, frames);
+    crossover_process(&crossover, 1, dry_r, right, frames);
+
+    uint32_t elapsed_us = time_us_32() - start_us;
+    multiband_total_us += elapsed_us;
+    if (elapsed_us > multiband_max_us) multiband_max_us = elapsed_us;
+    multiband_chunks++;
+}
+
+/**
+ * @brief リピートの開始/終了をトレースに記録（チャンクの終わりで状態の変化を見る）
+ */
+static inline void trace_repeat_state(void) {
+    if (is_repeating != traced_repeating) {
+        traced_repeating = is_repeating;
+        TRACE_INSTANT(is_repeating ? TRACE_EV_REPEAT_START : TRACE_EV_REPEAT_STOP, repeat_counter);
+    }
+}
+
+void audio_effect_get_multiband_cycles(uint32_t *avg_cycles, uint32_t *max_cycles) {
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    if (avg_cycles) {
+        *avg_cycles = multiband_chunks ?
+            (uint32_t)((uint64_t)multiband_total_us * cycles_per_us / multiband_chunks) : 0;
+    }
+    if (max_cycles) *max_cycles = multiband_max_us * cycles_per_us;
+}
+
+uint32_t audio_effect_get_slice_clamps(void) {
+    return slice_clamps;
+}
+
+// ============================================================================
+// スライスバッファの貸し出し
+// ============================================================================
+
+uint32_t audio_effect_get_slice_memory_bytes(void) {
+    return sizeof(slice_buffer);
+}
+
+void *audio_effect_lend_slice_memory(void) {
+    if (base_params.enabled || slice_memory_lent) {
+        return NULL;
+    }
+    slice_memory_lent = true;
+    return slice_buffer;
+}
+
+void audio_effect_return_slice_memory(void) {
+    if (!slice_memory_lent) return;
+    slice_memory_lent = false;
+    // 中身はルーパーのデータなので、スライス状態ごと作り直す
+    audio_effect_reset();
+}
+
+bool audio_effect_is_slice_memory_lent(void) {
+    return slice_memory_lent;
+}
+
+void audio_effect_get_transient_stats(uint32_t *detections, uint32_t *triggers,
+                                      uint32_t *avg_cycles, uint32_t *max_cycles) {
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    if (detections) *detections = transient_det.detections;
+    if (triggers) *triggers = transient_triggers;
+    if (avg_cycles) {
+        *avg_cycles = transient_chunks ?
+            (uint32_t)((uint64_t)transient_total_us * cycles_per_us / transient_chunks) : 0;
+    }
+    if (max_cycles) *max_cycles = transient_max_us * cycles_per_us;
+}
 
 // ============================================================================
 // エフェクト初期化
@@ -107,6 +308,7 @@ bool audio_effect_init(uint32_t sr) {
 
     // デフォルトパラメータ設定
     current_params.slice_length = DEFAULT_SLICE_LENGTH;
+    current_params.slice_length_frac = 0;
     current_params.repeat_count = DEFAULT_REPEAT_COUNT;
     current_params.wet_mix = DEFAULT_WET_MIX;
     current_params.enabled = DEFAULT_ENABLED;
@@ -123,14 +325,60 @@ bool audio_effect_init(uint32_t sr) {
     current_params.clock_divider = DEFAULT_CLOCK_DIVIDER;
     current_params.pitch_mode = DEFAULT_PITCH_MODE;
     current_params.freeze = DEFAULT_FREEZE;
+    current_params.duck_enabled = DEFAULT_DUCK_ENABLED;
+    current_params.repeat_trigger = DEFAULT_REPEAT_TRIGGER;
+    current_params.transient_threshold = DEFAULT_TRANSIENT_THRESHOLD;
+    current_params.transient_refractory_ms = DEFAULT_TRANSIENT_REFRACTORY;
+    current_params.slicer_enabled = DEFAULT_SLICER_ENABLED;
+    current_params.slicer_pattern = DEFAULT_SLICER_PATTERN;
+    current_params.multiband_enabled = DEFAULT_MULTIBAND_ENABLED;
+    for (int b = 0; b < CROSSOVER_MAX_BANDS; b++) {
+        current_params.band_repeat[b] = (b > 0);  // 低域はドライのまま
+        current_params.band_mix[b] = DEFAULT_BAND_MIX;
+    }
+    base_params = current_params;
+
+    // ダッキング用コンプレッサー
+    compressor_params_t duck_params = {
+        .threshold_db = EFFECT_DUCK_THRESHOLD_DB,
+        .ratio = EFFECT_DUCK_RATIO,
+        .knee_db = EFFECT_DUCK_KNEE_DB,
+        .attack_ms = EFFECT_DUCK_ATTACK_MS,
+        .release_ms = EFFECT_DUCK_RELEASE_MS,
+        .makeup_db = 0.0f,
+    };
+    compressor_init(&duck_comp, &duck_params, sr);
+
+    // トランジェントトリガーの検出器
+    transient_detector_init(&transient_det, current_params.transient_threshold,
+                            current_params.transient_refractory_ms, sr);
+    transient_pending = false;
+
+    // テンポ同期モジュレーション（ルートは外部から追加する）
+    mod_matrix_init(sr);
+
+    // Beat-Slicer の窓テーブル
+    slicer_init();
+    slicer_active = false;
+
+    // マルチバンドのクロスオーバー
+    const float crossover_edges[CROSSOVER_MAX_BANDS - 1] = {
+        EFFECT_CROSSOVER_LOW_HZ, EFFECT_CROSSOVER_HIGH_HZ
+    };
+    crossover_init(&crossover, EFFECT_MULTIBAND_BANDS, crossover_edges, sr);
+    update_band_gains();
 
     // バッファのクリア
-    memset(slice_buffer, 0, sizeof(slice_buffer));
+    memset(slice_buffer_l, 0, sizeof(slice_buffer_l));
+    memset(slice_buffer_r, 0, sizeof(slice_buffer_r));
     slice_write_pos = 0;
     slice_read_pos_f = 0.0f;
     repeat_counter = 0;
     is_repeating = false;
     pitch_mod_phase = 0;
+    slice_frac_acc = 0;
+    slice_carry = 0;
+    last_slice_end = 0;
 
     is_initialized = true;
 
@@ -151,9 +399,26 @@ bool audio_effect_init(uint32_t sr) {
         printf("\n");
     }
     printf("Window Shape: %.2f\n", current_params.window_shape);
+    printf("Wet Ducking: %s\n", current_params.duck_enabled ? "ON" : "OFF");
+    printf("Repeat Trigger: %s (threshold %.1f, refractory %.0f ms)\n",
+           current_params.repeat_trigger == REPEAT_TRIGGER_TRANSIENT ? "TRANSIENT" : "PROBABILITY",
+           current_params.transient_threshold, current_params.transient_refractory_ms);
+    printf("Slicer: %s (%d steps, %.1f sec ADPCM history)\n",
+           current_params.slicer_enabled ? "ON" : "OFF", SLICER_NUM_STEPS,
+           (float)SLICER_HISTORY_FRAMES / sample_rate);
+    printf("Multiband: %s (%d bands)\n", current_params.multiband_enabled ? "ON" : "OFF",
+           EFFECT_MULTIBAND_BANDS);
     printf("Effect: %s\n", current_params.enabled ? "ENABLED" : "DISABLED");
+#if EFFECT_SPECIALISED_KERNELS
+    printf("Kernels: %d specialised variants\n", NUM_PITCH_MODES * 2 * 2 * 2);
+#else
+    printf("Kernels: generic\n");
+#endif
     printf("Buffer Size: %lu samples (%lu bytes)\n",
-           (unsigned long)MAX_SLICE_LENGTH, (unsigned long)sizeof(slice_buffer));
+           (unsigned long)MAX_SLICE_LENGTH,
+           (unsigned long)(sizeof(slice_buffer_l) + sizeof(slice_buffer_r)));
+    sram_layout_log_buffer("slice_buffer_l", slice_buffer_l, sizeof(slice_buffer_l));
+    sram_layout_log_buffer("slice_buffer_r", slice_buffer_r, sizeof(slice_buffer_r));
     printf("========================================\n\n");
 
     return true;
@@ -168,11 +433,11 @@ bool audio_effect_init(uint32_t sr) {
  */
 static inline uint32_t validate_slice_length(uint32_t slice_len) {
     if (slice_len > MAX_SLICE_LENGTH) {
-        printf("WARNING: Slice length clamped to %lu\n", (unsigned long)MAX_SLICE_LENGTH);
+        slice_clamps++;
         return MAX_SLICE_LENGTH;
     }
     if (slice_len < MIN_SLICE_LENGTH) {
-        printf("WARNING: Slice length clamped to minimum %d\n", MIN_SLICE_LENGTH);
+        slice_clamps++;
         return MIN_SLICE_LENGTH;
     }
     return slice_len;
@@ -258,6 +523,51 @@ static inline uint8_t validate_clock_divider(uint8_t divider) {
     return 1;  // デフォルトは1
 }
 
+/**
+ * @brief スライサーパターンを検証
+ */
+static inline slicer_pattern_t validate_slicer_pattern(slicer_pattern_t pattern) {
+    if (pattern >= SLICER_PATTERN_SHUFFLE && pattern <= SLICER_PATTERN_RANDOM) {
+        return pattern;
+    }
+    return SLICER_PATTERN_SHUFFLE;
+}
+
+/**
+ * @brief リピートのきっかけを検証
+ */
+static inline repeat_trigger_t validate_repeat_trigger(repeat_trigger_t trigger) {
+    if (trigger == REPEAT_TRIGGER_TRANSIENT) {
+        return trigger;
+    }
+    return REPEAT_TRIGGER_PROBABILITY;
+}
+
+/**
+ * @brief トランジェントのしきい値を検証（速い/遅い の比）
+ */
+static inline float validate_transient_threshold(float threshold) {
+    if (threshold < MIN_TRANSIENT_THRESHOLD) return MIN_TRANSIENT_THRESHOLD;
+    if (threshold > MAX_TRANSIENT_THRESHOLD) return MAX_TRANSIENT_THRESHOLD;
+    return threshold;
+}
+
+/**
+ * @brief トランジェントの不応期を検証（ms）
+ */
+static inline float validate_transient_refractory(float refractory_ms) {
+    if (refractory_ms < MIN_TRANSIENT_REFRACTORY_MS) return MIN_TRANSIENT_REFRACTORY_MS;
+    if (refractory_ms > MAX_TRANSIENT_REFRACTORY_MS) return MAX_TRANSIENT_REFRACTORY_MS;
+    return refractory_ms;
+}
+
+/**
+ * @brief 帯域ミックスを検証
+ */
+static inline uint8_t validate_band_mix(uint8_t mix) {
+    return (mix > MAX_WET_MIX) ? MAX_WET_MIX : mix;
+}
+
 /**
  * @brief ピッチモードを検証
  */
@@ -272,11 +582,14 @@ static inline pitch_mode_t validate_pitch_mode(pitch_mode_t mode) {
 // パラメータ設定・取得
 // ============================================================================
 
-void audio_effect_set_params(const beat_repeat_params_t *params) {
+void audio_effect_update_params(const beat_repeat_params_t *params) {
     if (!params) return;
 
     // 各パラメータを検証
     current_params.slice_length = validate_slice_length(params->slice_length);
+    // クランプされた場合は小数部を捨てる
+    current_params.slice_length_frac = (current_params.slice_length == params->slice_length) ?
+        params->slice_length_frac : 0;
     current_params.repeat_count = validate_repeat_count(params->repeat_count);
     current_params.wet_mix = validate_wet_mix(params->wet_mix);
     current_params.pitch_shift = validate_pitch_shift(params->pitch_shift);
@@ -289,12 +602,47 @@ void audio_effect_set_params(const beat_repeat_params_t *params) {
     current_params.slice_probability = validate_slice_probability(params->slice_probability);
     current_params.clock_divider = validate_clock_divider(params->clock_divider);
     current_params.pitch_mode = validate_pitch_mode(params->pitch_mode);
+    current_params.slicer_pattern = validate_slicer_pattern(params->slicer_pattern);
+    current_params.repeat_trigger = validate_repeat_trigger(params->repeat_trigger);
+    current_params.transient_threshold = validate_transient_threshold(params->transient_threshold);
+    current_params.transient_refractory_ms =
+        validate_transient_refractory(params->transient_refractory_ms);
+    for (int b = 0; b < CROSSOVER_MAX_BANDS; b++) {
+        current_params.band_mix[b] = validate_band_mix(params->band_mix[b]);
+        current_params.band_repeat[b] = params->band_repeat[b];
+    }
 
     // ブール値はそのまま設定
     current_params.enabled = params->enabled;
     current_params.reverse = params->reverse;
     current_params.stutter_enabled = params->stutter_enabled;
     current_params.freeze = params->freeze;
+    current_params.duck_enabled = params->duck_enabled;
+    current_params.slicer_enabled = params->slicer_enabled;
+    current_params.multiband_enabled = params->multiband_enabled;
+    if (current_params.multiband_enabled && !base_params.multiband_enabled) {
+        crossover_reset(&crossover);  // 前回使ったときのフィルタ状態を残さない
+    }
+    if (current_params.transient_threshold != base_params.transient_threshold ||
+        current_params.transient_refractory_ms != base_params.transient_refractory_ms) {
+        transient_detector_configure(&transient_det, current_params.transient_threshold,
+                                     current_params.transient_refractory_ms, sample_rate);
+    }
+    if (current_params.repeat_trigger != base_params.repeat_trigger) {
+        // 前回使ったときのエンベロープと取り直しを残さない
+        transient_detector_reset(&transient_det);
+        transient_pending = false;
+    }
+    base_params = current_params;
+    update_band_gains();
+
+    TRACE_INSTANT(TRACE_EV_PARAM_CHANGE, 0);
+}
+
+void audio_effect_set_params(const beat_repeat_params_t *params) {
+    if (!params) return;
+
+    audio_effect_update_params(params);
 
     printf("Effect params updated: slice=%lu, repeat=%u, wet=%u%%, enabled=%d\n",
            current_params.slice_length, current_params.repeat_count,
@@ -305,13 +653,25 @@ void audio_effect_set_params(const beat_repeat_params_t *params) {
     printf("  loop_start=%.2f, loop_decay=%.2f, probability=%.2f\n",
            current_params.loop_start, current_params.loop_size_decay,
            current_params.slice_probability);
-    printf("  clock_div=%u, pitch_mode=%d, freeze=%d\n",
-           current_params.clock_divider, current_params.pitch_mode, current_params.freeze);
+    printf("  clock_div=%u, pitch_mode=%d, freeze=%d, duck=%d\n",
+           current_params.clock_divider, current_params.pitch_mode, current_params.freeze,
+           current_params.duck_enabled);
+    printf("  trigger=%d, transient_threshold=%.2f, refractory=%.0fms\n",
+           current_params.repeat_trigger, current_params.transient_threshold,
+           current_params.transient_refractory_ms);
+    printf("  slicer=%d, slicer_pattern=%d\n",
+           current_params.slicer_enabled, current_params.slicer_pattern);
+    printf("  multiband=%d, bands=", current_params.multiband_enabled);
+    for (int b = 0; b < EFFECT_MULTIBAND_BANDS; b++) {
+        printf("%s%s:%u%%", b ? " " : "", current_params.band_repeat[b] ? "ON" : "OFF",
+               current_params.band_mix[b]);
+    }
+    printf("\n");
 }
 
 void audio_effect_get_params(beat_repeat_params_t *params) {
     if (!params) return;
-    *params = current_params;
+    *params = base_params;
 }
 
 // ============================================================================
@@ -319,12 +679,24 @@ void audio_effect_get_params(beat_repeat_params_t *params) {
 // ============================================================================
 
 void audio_effect_reset(void) {
-    memset(slice_buffer, 0, sizeof(slice_buffer));
+    // 貸している間はルーパーのデータなので触らない（返すときにもう一度リセットする）
+    if (!slice_memory_lent) {
+        memset(slice_buffer, 0, sizeof(slice_buffer));
+    }
     slice_write_pos = 0;
     slice_read_pos_f = 0.0f;
     repeat_counter = 0;
     is_repeating = false;
     pitch_mod_phase = 0;
+    slice_frac_acc = 0;
+    slice_carry = 0;
+    last_slice_end = 0;
+    transient_pending = false;
+    transient_detector_reset(&transient_det);
+    slicer_active = false;
+    crossover_reset(&crossover);
+    compressor_reset(&duck_comp);
+    mod_matrix_reset();
     printf("Effect reset\n");
 }
 
@@ -332,7 +704,7 @@ void audio_effect_reset(void) {
 // ヘルパー関数：線形補間（ピッチシフト用）
 // ============================================================================
 
-static inline int16_t interpolate_sample(float pos, uint32_t max_length, bool is_left) {
+static inline int16_t interpolate_sample(const int16_t *buffer, float pos, uint32_t max_length) {
     // pos が範囲外の場合は0を返す
     if (pos < 0.0f || pos >= (float)max_length) {
         return 0;
@@ -341,16 +713,13 @@ static inline int16_t interpolate_sample(float pos, uint32_t max_length, bool is
     uint32_t pos_int = (uint32_t)pos;
     float frac = pos - (float)pos_int;
 
-    // チャンネルオフセット（LEFT_CHANNEL = 0, RIGHT_CHANNEL = 1）
-    uint32_t ch_offset = is_left ? LEFT_CHANNEL : RIGHT_CHANNEL;
-
     // 現在のサンプル
-    int16_t sample1 = slice_buffer[pos_int * STEREO_CHANNELS + ch_offset];
+    int16_t sample1 = buffer[pos_int];
 
     // 次のサンプル
     int16_t sample2;
     if (pos_int + 1 < max_length) {
-        sample2 = slice_buffer[(pos_int + 1) * STEREO_CHANNELS + ch_offset];
+        sample2 = buffer[pos_int + 1];
     } else {
         sample2 = sample1;  // バッファ端では同じ値を使う
     }
@@ -398,11 +767,12 @@ static inline float get_window_envelope(uint32_t pos, uint32_t length, float win
 // ヘルパー関数：ドライ/ウェットミックス
 // ============================================================================
 
-static inline int16_t mix_samples(int16_t dry, int16_t wet, uint8_t wet_percent) {
-    // 32ビット整数で計算してオーバーフロー防止
-    int32_t dry_part = (int32_t)dry * (MAX_WET_MIX - wet_percent) / MAX_WET_MIX;
-    int32_t wet_part = (int32_t)wet * wet_percent / MAX_WET_MIX;
-    int32_t result = dry_part + wet_part;
+// ウェット量は Q16（65536 = 100%）、チャンク内でランプできるようにフレームごとに渡す
+#define WET_GAIN_UNITY  65536
+
+static inline int16_t mix_samples(int16_t dry, int16_t wet, int32_t wet_q16) {
+    // 32ビット整数で計算（|dry|,|wet| <= 32768 なので和は int32_t に収まる）
+    int32_t result = ((int32_t)dry * (WET_GAIN_UNITY - wet_q16) + (int32_t)wet * wet_q16) >> 16;
 
     // クリッピング
     if (result > SAMPLE_MAX) result = SAMPLE_MAX;
@@ -419,9 +789,8 @@ static inline int16_t mix_samples(int16_t dry, int16_t wet, uint8_t wet_percent)
  * @brief スライスバッファに入力サンプルを書き込み
  */
 static inline void write_to_slice_buffer(int16_t input_l, int16_t input_r) {
-    uint32_t buf_idx = slice_write_pos * STEREO_CHANNELS;
-    slice_buffer[buf_idx + LEFT_CHANNEL] = input_l;
-    slice_buffer[buf_idx + RIGHT_CHANNEL] = input_r;
+    slice_buffer_l[slice_write_pos] = input_l;
+    slice_buffer_r[slice_write_pos] = input_r;
     slice_write_pos++;
 }
 
@@ -441,8 +810,8 @@ static inline float calculate_read_position(float slice_read_pos, uint32_t slice
 static inline void read_slice_with_pitch(int16_t *repeat_l, int16_t *repeat_r,
                                          uint32_t slice_length) {
     float read_pos = calculate_read_position(slice_read_pos_f, slice_length, current_params.reverse);
-    *repeat_l = interpolate_sample(read_pos, slice_length, true);
-    *repeat_r = interpolate_sample(read_pos, slice_length, false);
+    *repeat_l = interpolate_sample(slice_buffer_l, read_pos, slice_length);
+    *repeat_r = interpolate_sample(slice_buffer_r, read_pos, slice_length);
     slice_read_pos_f += current_params.pitch_shift;
 }
 
@@ -450,9 +819,9 @@ static inline void read_slice_with_pitch(int16_t *repeat_l, int16_t *repeat_r,
  * @brief ピッチシフトなしでスライスバッファから読み取り
  */
 static inline void read_slice_normal(int16_t *repeat_l, int16_t *repeat_r) {
-    uint32_t read_idx = (uint32_t)slice_read_pos_f * STEREO_CHANNELS;
-    *repeat_l = slice_buffer[read_idx + LEFT_CHANNEL];
-    *repeat_r = slice_buffer[read_idx + RIGHT_CHANNEL];
+    uint32_t read_idx = (uint32_t)slice_read_pos_f;
+    *repeat_l = slice_buffer_l[read_idx];
+    *repeat_r = slice_buffer_r[read_idx];
     slice_read_pos_f += 1.0f;
 }
 
@@ -509,16 +878,72 @@ static inline bool check_slice_probability(void) {
     return (random_val < current_params.slice_probability);
 }
 
+/**
+ * @brief スライス境界でリピートを始めるか判定
+ *
+ * トランジェントモードではスライスを取り直したときだけ（確率は見ない）。
+ *
+ * @return true リピート開始
+ */
+static inline bool check_repeat_trigger(void) {
+    if (current_params.repeat_trigger == REPEAT_TRIGGER_TRANSIENT) {
+        if (!transient_pending) {
+            return false;
+        }
+        transient_pending = false;
+        transient_triggers++;
+        return true;
+    }
+    return check_slice_probability();
+}
+
+/**
+ * @brief スライスの取り込みをトランジェントの位置からやり直す
+ *
+ * 書き込み位置の back フレーム前（直前のスライスの終わりにかかる分も含む）を
+ * スライスバッファの先頭に移し、そこから取り込みを続ける。
+ * スライスが埋まった境界でこのスライスのリピートが始まる。
+ *
+ * @param back 書き込み位置から遡るフレーム数（TRANSIENT_MAX_LOOKBACK_FRAMES + TRANSIENT_PREROLL_FRAMES 以下）
+ * @param active_slice_length キャプチャ中のスライス長
+ */
+static void realign_slice_capture(uint32_t back, uint32_t active_slice_length) {
+    if (back >= active_slice_length) back = active_slice_length - 1;
+
+    // 今のスライスに足りない分は直前のスライスの終わりから（まだ上書きされていない範囲だけ）
+    uint32_t from_cur = (back < slice_write_pos) ? back : slice_write_pos;
+    uint32_t from_prev = back - from_cur;
+    uint32_t prev_avail = (last_slice_end > slice_write_pos) ? last_slice_end - slice_write_pos : 0;
+    if (from_prev > prev_avail) from_prev = prev_avail;
+
+    memcpy(realign_buf_l, &slice_buffer_l[last_slice_end - from_prev], from_prev * sizeof(int16_t));
+    memcpy(realign_buf_r, &slice_buffer_r[last_slice_end - from_prev], from_prev * sizeof(int16_t));
+    memcpy(&realign_buf_l[from_prev], &slice_buffer_l[slice_write_pos - from_cur], from_cur * sizeof(int16_t));
+    memcpy(&realign_buf_r[from_prev], &slice_buffer_r[slice_write_pos - from_cur], from_cur * sizeof(int16_t));
+
+    back = from_prev + from_cur;
+    memcpy(slice_buffer_l, realign_buf_l, back * sizeof(int16_t));
+    memcpy(slice_buffer_r, realign_buf_r, back * sizeof(int16_t));
+    slice_write_pos = back;
+    transient_pending = true;
+}
+
 /**
  * @brief ピッチモードに応じたピッチ倍率を計算
+ *
+ * 特殊化カーネルからは mode を定数で渡すので、switch はコンパイル時に消える。
+ *
+ * @param mode ピッチモード
  * @param pos 現在の読み取り位置
  * @param length スライス長
+ * @param fixed_pitch 固定ピッチ（モジュレーション適用済み）
  * @return ピッチ倍率
  */
-static inline float calculate_pitch_for_mode(uint32_t pos, uint32_t length) {
+static inline __attribute__((always_inline))
+float pitch_for_mode(pitch_mode_t mode, uint32_t pos, uint32_t length, float fixed_pitch) {
     float normalized_pos = (float)pos / (float)length;  // 0.0-1.0
 
-    switch (current_params.pitch_mode) {
+    switch (mode) {
         case PITCH_MODE_DECREASING:
             // 線形減少（1.0 -> 0.5）
             return 1.0f - (normalized_pos * 0.5f);
@@ -534,11 +959,18 @@ static inline float calculate_pitch_for_mode(uint32_t pos, uint32_t length) {
 
         case PITCH_MODE_FIXED_REVERSE:
         default:
-            // 固定ピッチ（current_params.pitch_shift を使用）
-            return current_params.pitch_shift;
+            // 固定ピッチ（pitch_shift にモジュレーションを適用した値）
+            return fixed_pitch;
     }
 }
 
+/**
+ * @brief 現在のピッチモードでピッチ倍率を計算（汎用パス用）
+ */
+static inline float calculate_pitch_for_mode(uint32_t pos, uint32_t length) {
+    return pitch_for_mode(current_params.pitch_mode, pos, length, pitch_ramp);
+}
+
 /**
  * @brief ループスタート/サイズ減衰を考慮した有効なループ範囲を計算
  * @param slice_length スライス長
@@ -571,48 +1003,280 @@ static inline void calculate_loop_range(uint32_t slice_length,
 }
 
 // ============================================================================
-// メインエフェクト処理
+// スライス長（小数部の累積）
 // ============================================================================
 
-void audio_effect_process(int16_t *data, uint32_t num_samples, uint8_t num_channels) {
-    if (!is_initialized || !data || num_channels != STEREO_CHANNELS) {
-        return;  // ステレオ以外は未対応
+/**
+ * @brief クロック分周を適用したスライス長（32.32 固定小数点）
+ */
+static inline uint64_t get_slice_length_q32(void) {
+    uint64_t base_q32 = current_params.stutter_enabled ?
+        ((uint64_t)current_params.stutter_slice_length << 32) :
+        (((uint64_t)current_params.slice_length << 32) | current_params.slice_length_frac);
+    return base_q32 / current_params.clock_divider;
+}
+
+/**
+ * @brief キャプチャ中のスライス長（整数部 + 前回の境界で決まった繰り上がり）
+ */
+static inline uint32_t get_active_slice_length(void) {
+    uint32_t length = (uint32_t)(get_slice_length_q32() >> 32) + slice_carry;
+    return (length > MAX_SLICE_LENGTH) ? MAX_SLICE_LENGTH : length;
+}
+
+/**
+ * @brief スライス境界で小数部を累積し、次のスライスの繰り上がりを決める
+ *
+ * 次のスライスの終わりで小数部が繰り上がるならそのスライスを1サンプル長くする。
+ * k 番目の境界は常に floor(k × スライス長) になり、誤差は1サンプル未満のまま蓄積しない。
+ */
+static inline void advance_slice_phase(void) {
+    uint32_t frac = (uint32_t)get_slice_length_q32();
+    slice_frac_acc += frac;    // 終わったスライスの小数部（ラップは繰り上がりとして消費済み）
+    slice_carry = ((uint32_t)(slice_frac_acc + frac) < slice_frac_acc) ? 1 : 0;
+}
+
+// ============================================================================
+// Beat-Slicer
+// ============================================================================
+
+/**
+ * @brief 履歴のニブル列に1サンプル分の ADPCM コードを書く（偶数フレームが下位ニブル）
+ */
+static inline void slicer_history_write(uint8_t *history, uint32_t pos, uint8_t code) {
+    uint8_t *byte = &history[pos >> 1];
+    *byte = (pos & 1) ? (uint8_t)((*byte & 0x0F) | (code << 4)) : code;
+}
+
+static inline uint8_t slicer_history_read(const uint8_t *history, uint32_t pos) {
+    return (pos & 1) ? (uint8_t)(history[pos >> 1] >> 4) : (uint8_t)(history[pos >> 1] & 0x0F);
+}
+
+/**
+ * @brief 1小節（SLICER_NUM_STEPS ステップ）が履歴に収まるか
+ *
+ * 現在の小節を書き込みながら直前の小節を読むので、最も古い読み取り
+ * （最後のステップで先頭のスライス）は (2 × ステップ数 - 1) ステップ前になる。
+ * 収まらなければステップを減らして小節を縮めたりせず、ドライのまま通して報告する。
+ */
+static bool slicer_fits(uint32_t step_len) {
+    uint32_t needed = (2 * SLICER_NUM_STEPS - 1) * (step_len + 1);
+    if (needed <= SLICER_HISTORY_FRAMES) {
+        slicer_refused_len = 0;
+        return true;
+    }
+
+    if (step_len != slicer_refused_len) {
+        printf("[SLICER] %d steps x %lu samples need %lu frames of history (%lu): bypassed\n",
+               SLICER_NUM_STEPS, step_len, needed, (unsigned long)SLICER_HISTORY_FRAMES);
+        slicer_refused_len = step_len;
+    }
+    return false;
+}
+
+/**
+ * @brief チャンク内でビートクロックの小節頭が来る最初のフレームを探す
+ *
+ * 直前のフレームとの間で小節番号が変わるフレームを小節頭とする
+ * （チャンクの境目をまたいでも取りこぼさない）。
+ *
+ * @return true 見つかった（offset に格納）
+ */
+static bool find_bar_start(uint32_t frame_offset, uint32_t frames, uint32_t *offset) {
+    const uint64_t bar_q32 = (uint64_t)BEATS_PER_BAR << 32;
+    uint64_t start = beat_clock_get_position_at(frame_offset);
+    uint64_t increment = beat_clock_get_position_at(frame_offset + 1) - start;
+
+    if (start < increment) {
+        // ビートクロックの開始直後（先頭フレームが最初の小節頭）
+        *offset = 0;
+        return true;
+    }
+
+    uint64_t next_bar = ((start - increment) / bar_q32 + 1) * bar_q32;
+    if (next_bar > start + increment * (frames - 1)) {
+        return false;
+    }
+
+    *offset = (next_bar <= start) ? 0 : (uint32_t)((next_bar - start + increment - 1) / increment);
+    return true;
+}
+
+/**
+ * @brief ステップの頭で再生するスライスを決める（O(1)、オーディオはコピーしない）
+ *
+ * スライスの頭のエンコーダー状態を覚えておき、再生時はそこからデコーダーを始める。
+ * デコーダーはエンコーダーと同じ計算なので、復号結果は書き込み時の予測値と一致する。
+ */
+static inline void slicer_begin_step(void) {
+    bar_start[0][slicer_step] = history_pos;
+    memcpy(bar_state[0][slicer_step], slicer_enc, sizeof(slicer_enc));
+
+    if (slicer_has_bar) {
+        uint32_t slice = slicer_get_slice(slicer_step);
+        slicer_src_pos = bar_start[1][slice];
+        slicer_src_len = bar_len[1][slice];
+        memcpy(slicer_dec, bar_state[1][slice], sizeof(slicer_dec));
+    }
+}
+
+/**
+ * @brief スライサーを有効にする（次の小節頭まではドライのまま通す）
+ */
+static void slicer_arm(void) {
+    slicer_active = true;
+    slicer_waiting = true;
+    slicer_has_bar = false;
+    slicer_refused_len = 0;
+    is_repeating = false;
+}
+
+/**
+ * @brief 小節頭でスライサーを開始（最初の小節は並べ替えずにそのまま出力）
+ * @return false 1小節が履歴に収まらない（次の小節頭で再度試す）
+ */
+static bool slicer_start(void) {
+    // ステップの境界を小節頭から floor(k × スライス長) で数える
+    slice_frac_acc = 0;
+    slice_carry = 0;
+
+    uint32_t step_len = get_active_slice_length();
+    if (!slicer_fits(step_len)) {
+        return false;
     }
 
-    // エフェクトが無効な場合はスルー
-    if (!current_params.enabled) {
+    slicer_waiting = false;
+    slicer_has_bar = false;
+    history_pos = 0;
+    slicer_step = 0;
+    slicer_step_pos = 0;
+    slicer_step_len = step_len;
+    memset(slicer_enc, 0, sizeof(slicer_enc));
+    slicer_begin_step();
+    return true;
+}
+
+/**
+ * @brief ステップの終わりの処理（小節の終わりなら次の小節の並びを作る）
+ */
+static void slicer_end_step(void) {
+    bar_len[0][slicer_step] = slicer_step_len;
+    slicer_step_pos = 0;
+
+    // 次のステップの長さ（スライス長の小数部を累積してビートグリッドに合わせる）
+    advance_slice_phase();
+    slicer_step_len = get_active_slice_length();
+    if (!slicer_fits(slicer_step_len)) {
+        // スライス長が伸びて履歴に収まらない: ドライに戻して次の小節頭を待つ
+        slicer_waiting = true;
+        slicer_has_bar = false;
         return;
     }
 
-    // クロック分周を適用したスライス長
-    uint32_t base_slice_length = current_params.stutter_enabled ?
-        current_params.stutter_slice_length : current_params.slice_length;
-    uint32_t active_slice_length = base_slice_length / current_params.clock_divider;
+    if (++slicer_step >= SLICER_NUM_STEPS) {
+        // 小節の終わり: 今の小節を「直前の小節」にする（位置と長さ、状態のコピーだけ）
+        memcpy(bar_start[1], bar_start[0], sizeof(bar_start[0]));
+        memcpy(bar_len[1], bar_len[0], sizeof(bar_len[0]));
+        memcpy(bar_state[1], bar_state[0], sizeof(bar_state[0]));
+        slicer_has_bar = true;
 
+        slicer_next_bar(current_params.slicer_pattern, SLICER_NUM_STEPS, SLICER_NUM_STEPS);
+        slicer_step = 0;
+    }
+
+    slicer_begin_step();
+}
+
+/**
+ * @brief スライサーでチャンクを処理
+ * @param frame_offset ブロック先頭からのチャンク位置（小節頭の検出用）
+ */
+static void process_slicer(int16_t *left, int16_t *right, const int32_t *wet_gain,
+                           uint32_t frame_offset, uint32_t count) {
+    uint8_t *history_l = (uint8_t *)slice_buffer_l;
+    uint8_t *history_r = (uint8_t *)slice_buffer_r;
+    uint32_t i = 0;
+
+    if (slicer_waiting) {
+        // 小節頭まではドライのまま（履歴にも書かない）
+        if (!find_bar_start(frame_offset, count, &i) || !slicer_start()) {
+            return;
+        }
+    }
+
+    for (; i < count; i++) {
+        int16_t input_l = left[i];
+        int16_t input_r = right[i];
+
+        // 履歴に書き込み（常に最新の音を記録）
+        slicer_history_write(history_l, history_pos, adpcm_encode_sample(&slicer_enc[0], input_l));
+        slicer_history_write(history_r, history_pos, adpcm_encode_sample(&slicer_enc[1], input_r));
+        if (++history_pos >= SLICER_HISTORY_FRAMES) history_pos = 0;
+
+        if (slicer_has_bar) {
+            // 元のスライスより長いステップ（繰り上がりの1サンプル）は最後のサンプルを保持
+            if (slicer_step_pos < slicer_src_len) {
+                slicer_src_l = adpcm_decode_sample(&slicer_dec[0],
+                                                   slicer_history_read(history_l, slicer_src_pos));
+                slicer_src_r = adpcm_decode_sample(&slicer_dec[1],
+                                                   slicer_history_read(history_r, slicer_src_pos));
+                if (++slicer_src_pos >= SLICER_HISTORY_FRAMES) slicer_src_pos = 0;
+            }
+
+            int32_t fade = slicer_fade_gain(slicer_step_pos, slicer_step_len);
+            int16_t wet_l = (int16_t)(((int32_t)slicer_src_l * fade) >> 15);
+            int16_t wet_r = (int16_t)(((int32_t)slicer_src_r * fade) >> 15);
+
+            left[i] = mix_samples(input_l, wet_l, wet_gain[i]);
+            right[i] = mix_samples(input_r, wet_r, wet_gain[i]);
+        }
+
+        if (++slicer_step_pos >= slicer_step_len) {
+            slicer_end_step();
+            if (slicer_waiting) {
+                return;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// 汎用パス（サンプルごとに全パラメータを分岐、特殊化カーネルの検証用）
+// ============================================================================
+
+#if !EFFECT_SPECIALISED_KERNELS
+static void process_generic(int16_t *left, int16_t *right, const int32_t *wet_gain,
+                            uint32_t num_samples, uint32_t active_slice_length) {
     // Beat-Repeatアルゴリズム（Kammerl オリジナル機能統合版）
     for (uint32_t i = 0; i < num_samples; i++) {
-        // ステレオペアのインデックス
-        uint32_t l_idx = i * STEREO_CHANNELS + LEFT_CHANNEL;
-        uint32_t r_idx = i * STEREO_CHANNELS + RIGHT_CHANNEL;
-
-        int16_t input_l = data[l_idx];
-        int16_t input_r = data[r_idx];
+        int16_t input_l = left[i];
+        int16_t input_r = right[i];
         int16_t output_l, output_r;
 
         // スライスバッファに書き込み（常に最新の音を記録）
         write_to_slice_buffer(input_l, input_r);
 
+        // サイドチェイン: リピート中でなくてもエンベロープを追従させておく
+        int32_t duck_gain = COMPRESSOR_UNITY_GAIN;
+        if (current_params.duck_enabled) {
+            duck_gain = compressor_compute_gain(&duck_comp, input_l, input_r);
+        }
+
         // スライスが満杯になったらリピート開始
         if (slice_write_pos >= active_slice_length) {
+            last_slice_end = slice_write_pos;
             slice_write_pos = 0;
+            advance_slice_phase();
+            active_slice_length = get_active_slice_length();
 
             if (!is_repeating && !current_params.freeze) {
-                // スライス確率チェック
-                if (check_slice_probability()) {
+                // スライス確率 / トランジェントのチェック
+                if (check_repeat_trigger()) {
                     is_repeating = true;
                     slice_read_pos_f = 0.0f;
                     repeat_counter = 0;
                     pitch_mod_phase = 0;
+                    mod_matrix_trigger();
                 }
             }
         }
@@ -644,9 +1308,8 @@ void audio_effect_process(int16_t *data, uint32_t num_samples, uint8_t num_chann
             }
 
             if (read_idx < active_slice_length) {
-                uint32_t buf_idx = read_idx * STEREO_CHANNELS;
-                repeat_l = slice_buffer[buf_idx + LEFT_CHANNEL];
-                repeat_r = slice_buffer[buf_idx + RIGHT_CHANNEL];
+                repeat_l = slice_buffer_l[read_idx];
+                repeat_r = slice_buffer_r[read_idx];
             } else {
                 repeat_l = repeat_r = 0;
             }
@@ -660,9 +1323,15 @@ void audio_effect_process(int16_t *data, uint32_t num_samples, uint8_t num_chann
                 repeat_r = (int16_t)((float)repeat_r * envelope);
             }
 
+            // ドライのトランジェントでウェットをダッキング
+            if (current_params.duck_enabled) {
+                repeat_l = compressor_apply_gain(repeat_l, duck_gain);
+                repeat_r = compressor_apply_gain(repeat_r, duck_gain);
+            }
+
             // ドライ/ウェットミックス
-            output_l = mix_samples(input_l, repeat_l, current_params.wet_mix);
-            output_r = mix_samples(input_r, repeat_r, current_params.wet_mix);
+            output_l = mix_samples(input_l, repeat_l, wet_gain[i]);
+            output_r = mix_samples(input_r, repeat_r, wet_gain[i]);
 
             // 読み取り位置を進める（ピッチ倍率適用）
             slice_read_pos_f += pitch_mult;
@@ -691,7 +1360,445 @@ void audio_effect_process(int16_t *data, uint32_t num_samples, uint8_t num_chann
         }
 
         // 出力
-        data[l_idx] = output_l;
-        data[r_idx] = output_r;
+        left[i] = output_l;
+        right[i] = output_r;
+
+        pitch_ramp += pitch_ramp_step;
+    }
+}
+#endif
+
+// ============================================================================
+// 特殊化カーネル
+// ============================================================================
+
+#if EFFECT_SPECIALISED_KERNELS
+/**
+ * @brief リピート中の1区間を処理するカーネルの本体
+ *
+ * mode/reverse/window/freeze はコンパイル時定数として展開され、
+ * ループ内の分岐はリピート1周の終わりの判定だけになる。
+ * リピートが終わったら（is_repeating = false）その時点で戻る。
+ *
+ * @return 処理したフレーム数
+ */
+static inline __attribute__((always_inline))
+uint32_t repeat_kernel_body(int16_t *left, int16_t *right, const int32_t *duck_gain,
+                            const int32_t *wet_gain, uint32_t count, uint32_t active_slice_length,
+                            pitch_mode_t mode, bool reverse, bool window, bool freeze) {
+    const float window_shape = current_params.window_shape;
+    const float pitch_step = pitch_ramp_step;
+    float fixed_pitch = pitch_ramp;
+
+    // ループ範囲はリピートカウントが変わった時だけ再計算
+    uint32_t loop_start, loop_end;
+    calculate_loop_range(active_slice_length, &loop_start, &loop_end);
+    uint32_t effective_loop_length = loop_end - loop_start;
+
+    float read_pos = slice_read_pos_f;
+    uint32_t i = 0;
+
+    while (i < count) {
+        int16_t input_l = left[i];
+        int16_t input_r = right[i];
+
+        // スライスバッファに書き込み（常に最新の音を記録）
+        write_to_slice_buffer(input_l, input_r);
+
+        // 読み取り位置（ループ範囲内）
+        uint32_t read_idx;
+        if (reverse) {
+            read_idx = loop_end - 1 - ((uint32_t)read_pos % effective_loop_length);
+        } else {
+            float adjusted_read_pos = read_pos + (float)loop_start;
+            if (adjusted_read_pos >= (float)loop_end) {
+                adjusted_read_pos = (float)loop_start;
+            }
+            read_idx = (uint32_t)adjusted_read_pos;
+        }
+
+        float pitch_mult = pitch_for_mode(mode, (uint32_t)read_pos, effective_loop_length,
+                                          fixed_pitch);
+
+        int16_t repeat_l = 0;
+        int16_t repeat_r = 0;
+        if (read_idx < active_slice_length) {
+            repeat_l = slice_buffer_l[read_idx];
+            repeat_r = slice_buffer_r[read_idx];
+        }
+
+        // ウィンドウシェイプ（フェードイン/アウト）
+        if (window) {
+            float envelope = get_window_envelope((uint32_t)read_pos, effective_loop_length,
+                                                 window_shape);
+            repeat_l = (int16_t)((float)repeat_l * envelope);
+            repeat_r = (int16_t)((float)repeat_r * envelope);
+        }
+
+        // ダッキング（無効時はユニティゲインが入っている）
+        repeat_l = compressor_apply_gain(repeat_l, duck_gain[i]);
+        repeat_r = compressor_apply_gain(repeat_r, duck_gain[i]);
+
+        left[i] = mix_samples(input_l, repeat_l, wet_gain[i]);
+        right[i] = mix_samples(input_r, repeat_r, wet_gain[i]);
+        i++;
+
+        // モジュレーションされた固定ピッチのランプ（他のモードでは消える）
+        if (mode == PITCH_MODE_FIXED_REVERSE) {
+            fixed_pitch += pitch_step;
+        }
+
+        // 読み取り位置を進める（ピッチ倍率適用）
+        read_pos += pitch_mult;
+
+        if (read_pos >= (float)effective_loop_length) {
+            read_pos = 0.0f;
+
+            // フリーズ時はループ範囲内で巻き戻すだけ
+            if (!freeze) {
+                repeat_counter++;
+                if (repeat_counter >= current_params.repeat_count) {
+                    is_repeating = false;
+                    repeat_counter = 0;
+                    break;
+                }
+                calculate_loop_range(active_slice_length, &loop_start, &loop_end);
+                effective_loop_length = loop_end - loop_start;
+            }
+        }
+    }
+
+    slice_read_pos_f = read_pos;
+    pitch_ramp = (mode == PITCH_MODE_FIXED_REVERSE) ? fixed_pitch : pitch_ramp + pitch_step * i;
+    return i;
+}
+
+typedef uint32_t (*repeat_kernel_t)(int16_t *left, int16_t *right, const int32_t *duck_gain,
+                                    const int32_t *wet_gain, uint32_t count,
+                                    uint32_t active_slice_length);
+
+// (ピッチモード × 逆再生 × ウィンドウ × フリーズ) の組み合わせごとにカーネルを生成
+#define DEFINE_REPEAT_KERNEL(mode, rev, win, frz) \
+    static uint32_t repeat_kernel_##mode##_##rev##win##frz( \
+            int16_t *left, int16_t *right, const int32_t *duck_gain, \
+            const int32_t *wet_gain, uint32_t count, uint32_t active_slice_length) { \
+        return repeat_kernel_body(left, right, duck_gain, wet_gain, count, \
+                                  active_slice_length, mode, rev, win, frz); \
+    }
+
+#define DEFINE_REPEAT_KERNELS_FOR_MODE(mode) \
+    DEFINE_REPEAT_KERNEL(mode, 0, 0, 0) DEFINE_REPEAT_KERNEL(mode, 0, 0, 1) \
+    DEFINE_REPEAT_KERNEL(mode, 0, 1, 0) DEFINE_REPEAT_KERNEL(mode, 0, 1, 1) \
+    DEFINE_REPEAT_KERNEL(mode, 1, 0, 0) DEFINE_REPEAT_KERNEL(mode, 1, 0, 1) \
+    DEFINE_REPEAT_KERNEL(mode, 1, 1, 0) DEFINE_REPEAT_KERNEL(mode, 1, 1, 1)
+
+DEFINE_REPEAT_KERNELS_FOR_MODE(PITCH_MODE_FIXED_REVERSE)
+DEFINE_REPEAT_KERNELS_FOR_MODE(PITCH_MODE_DECREASING)
+DEFINE_REPEAT_KERNELS_FOR_MODE(PITCH_MODE_INCREASING)
+DEFINE_REPEAT_KERNELS_FOR_MODE(PITCH_MODE_SCRATCH)
+
+#define REPEAT_KERNEL_ROW(mode) { \
+    { { repeat_kernel_##mode##_000, repeat_kernel_##mode##_001 }, \
+      { repeat_kernel_##mode##_010, repeat_kernel_##mode##_011 } }, \
+    { { repeat_kernel_##mode##_100, repeat_kernel_##mode##_101 }, \
+      { repeat_kernel_##mode##_110, repeat_kernel_##mode##_111 } } }
+
+// [ピッチモード][逆再生][ウィンドウ][フリーズ]
+static const repeat_kernel_t repeat_kernels[NUM_PITCH_MODES][2][2][2] = {
+    REPEAT_KERNEL_ROW(PITCH_MODE_FIXED_REVERSE),
+    REPEAT_KERNEL_ROW(PITCH_MODE_DECREASING),
+    REPEAT_KERNEL_ROW(PITCH_MODE_INCREASING),
+    REPEAT_KERNEL_ROW(PITCH_MODE_SCRATCH),
+};
+
+/**
+ * @brief 現在のパラメータに対応するカーネルを選択（ブロックごとに1回）
+ */
+static repeat_kernel_t select_repeat_kernel(void) {
+    return repeat_kernels[current_params.pitch_mode]
+                         [current_params.reverse ? 1 : 0]
+                         [current_params.window_shape > 0.0f ? 1 : 0]
+                         [current_params.freeze ? 1 : 0];
+}
+
+/**
+ * @brief スライス境界を含まない区間を処理
+ *
+ * リピート中はカーネル、そうでなければスライスバッファへのコピーのみ（出力 = 入力）。
+ */
+static void process_segment(repeat_kernel_t kernel, int16_t *left, int16_t *right,
+                            const int32_t *duck_gain, const int32_t *wet_gain, uint32_t count,
+                            uint32_t active_slice_length) {
+    uint32_t done = 0;
+
+    while (done < count) {
+        if (is_repeating) {
+            done += kernel(left + done, right + done, duck_gain + done, wet_gain + done,
+                           count - done, active_slice_length);
+        } else {
+            uint32_t n = count - done;
+            memcpy(&slice_buffer_l[slice_write_pos], left + done, n * sizeof(int16_t));
+            memcpy(&slice_buffer_r[slice_write_pos], right + done, n * sizeof(int16_t));
+            slice_write_pos += n;
+            pitch_ramp += pitch_ramp_step * (float)n;
+            done = count;
+        }
+    }
+}
+
+/**
+ * @brief スライス境界で区切りながらフレームを処理
+ * @return 処理後のキャプチャ中のスライス長
+ */
+static uint32_t process_repeat_frames(repeat_kernel_t kernel, int16_t *left, int16_t *right,
+                                      const int32_t *duck_gain, const int32_t *wet_gain,
+                                      uint32_t count, uint32_t active_slice_length) {
+    uint32_t i = 0;
+    while (i < count) {
+        // 次のスライス境界までのフレーム数（境界のフレームを含む）
+        uint32_t to_boundary = (slice_write_pos < active_slice_length) ?
+            active_slice_length - slice_write_pos : 1;
+        uint32_t remaining = count - i;
+
+        if (remaining < to_boundary) {
+            process_segment(kernel, left + i, right + i, duck_gain + i, wet_gain + i,
+                            remaining, active_slice_length);
+            break;
+        }
+
+        // 境界の手前まで
+        process_segment(kernel, left + i, right + i, duck_gain + i, wet_gain + i,
+                        to_boundary - 1, active_slice_length);
+        i += to_boundary - 1;
+
+        // 境界のフレーム: 汎用パスと同じく、次のスライスの長さ（小数部の繰り上がりで
+        // 1サンプル長くなることがある）を先に決め、このフレームのリピートはその長さで読む。
+        // 書き込みは満杯になる位置（slice_write_pos）のまま、処理してから先頭に戻す
+        advance_slice_phase();
+        active_slice_length = get_active_slice_length();
+
+        // スライスが満杯になったらリピート開始
+        // （開始判定は書き込んだサンプルに依存しないので、先に判定してから処理する）
+        if (!is_repeating && !current_params.freeze) {
+            if (check_repeat_trigger()) {
+                is_repeating = true;
+                slice_read_pos_f = 0.0f;
+                repeat_counter = 0;
+                pitch_mod_phase = 0;
+                mod_matrix_trigger();
+            }
+        }
+        process_segment(kernel, left + i, right + i, duck_gain + i, wet_gain + i,
+                        1, active_slice_length);
+        last_slice_end = slice_write_pos;
+        slice_write_pos = 0;
+        i++;
+    }
+    return active_slice_length;
+}
+#endif
+
+// ============================================================================
+// モジュレーション
+// ============================================================================
+
+/**
+ * @brief チャンク1つ分のモジュレーションを評価して current_params に反映
+ *
+ * モジュレーションマトリクスの評価はチャンクごとに1回だけ。
+ * ウェットミックスとピッチはチャンクの開始値から終了値へ線形にランプし、
+ * スライス/ループ単位で読むパラメータはチャンク開始時の値を使う。
+ *
+ * @param frame_offset ブロック先頭からのチャンク位置（ビートクロック用）
+ * @param frames チャンクのフレーム数
+ * @param wet_gain ウェット量（Q16）の格納先（frames 個）
+ */
+static void apply_modulation(uint32_t frame_offset, uint32_t frames, int32_t *wet_gain) {
+    float start, end;
+
+    current_params = base_params;
+    mod_matrix_process(beat_clock_get_position_at(frame_offset + frames), frames);
+
+    // ピッチ（オクターブ単位で変調）
+    float pitch_start = base_params.pitch_shift;
+    float pitch_end = base_params.pitch_shift;
+    if (mod_matrix_get_ramp(MOD_DEST_PITCH_SHIFT, &start, &end)) {
+        pitch_start = validate_pitch_shift(base_params.pitch_shift * exp2f(start));
+        pitch_end = validate_pitch_shift(base_params.pitch_shift * exp2f(end));
+    }
+    current_params.pitch_shift = pitch_start;
+    pitch_ramp = pitch_start;
+    pitch_ramp_step = (pitch_end - pitch_start) / (float)frames;
+
+    // ウェットミックス（%）
+    float wet_start = (float)base_params.wet_mix;
+    float wet_end = wet_start;
+    if (mod_matrix_get_ramp(MOD_DEST_WET_MIX, &start, &end)) {
+        wet_start = fminf(fmaxf(wet_start + start, 0.0f), (float)MAX_WET_MIX);
+        wet_end = fminf(fmaxf(wet_end + end, 0.0f), (float)MAX_WET_MIX);
+    }
+    current_params.wet_mix = (uint8_t)(wet_start + 0.5f);
+
+    int32_t wet_q16 = (int32_t)(wet_start * (float)WET_GAIN_UNITY / (float)MAX_WET_MIX);
+    int32_t wet_step = (int32_t)((wet_end - wet_start) * (float)WET_GAIN_UNITY /
+                                 (float)MAX_WET_MIX / (float)frames);
+    for (uint32_t i = 0; i < frames; i++) {
+        wet_gain[i] = wet_q16;
+        wet_q16 += wet_step;
+    }
+
+    // スライス/ループ単位のパラメータ
+    if (mod_matrix_get_ramp(MOD_DEST_WINDOW_SHAPE, &start, &end)) {
+        current_params.window_shape = validate_window_shape(base_params.window_shape + start);
+    }
+    if (mod_matrix_get_ramp(MOD_DEST_LOOP_START, &start, &end)) {
+        current_params.loop_start = validate_loop_start(base_params.loop_start + start);
+    }
+    if (mod_matrix_get_ramp(MOD_DEST_LOOP_SIZE_DECAY, &start, &end)) {
+        current_params.loop_size_decay =
+            validate_loop_size_decay(base_params.loop_size_decay + start);
+    }
+    if (mod_matrix_get_ramp(MOD_DEST_SLICE_PROBABILITY, &start, &end)) {
+        current_params.slice_probability =
+            validate_slice_probability(base_params.slice_probability + start);
+    }
+}
+
+// ============================================================================
+// トランジェントトリガー
+// ============================================================================
+
+/**
+ * @brief チャンクのトランジェントを検出し、スライスを取り直す位置を求める
+ *
+ * 取り直す位置はトランジェントの TRANSIENT_PREROLL_FRAMES 前。
+ * それがチャンクより前なら、チャンクの先頭で取り直して足りない分を遡る。
+ *
+ * @param left 左チャンネル（処理前の入力）
+ * @param right 右チャンネル（処理前の入力）
+ * @param frames チャンクのフレーム数
+ * @param at 取り直すチャンク内の位置の格納先
+ * @param back そこから遡るフレーム数の格納先
+ * @return true 検出した
+ */
+static bool detect_transient(const int16_t *left, const int16_t *right, uint32_t frames,
+                             uint32_t *at, uint32_t *back) {
+    uint32_t start_us = time_us_32();
+
+    int32_t onset = 0;
+    bool found = transient_detector_process(&transient_det, left, right, frames, &onset);
+    if (found) {
+        int32_t start = onset - TRANSIENT_PREROLL_FRAMES;
+        *at = (start > 0) ? (uint32_t)start : 0;
+        *back = (uint32_t)((int32_t)*at - start);
+        TRACE_INSTANT(TRACE_EV_TRANSIENT, *at);
+    }
+
+    uint32_t elapsed_us = time_us_32() - start_us;
+    transient_total_us += elapsed_us;
+    transient_chunks++;
+    if (elapsed_us > transient_max_us) transient_max_us = elapsed_us;
+
+    return found;
+}
+
+// ============================================================================
+// メインエフェクト処理
+// ============================================================================
+
+void audio_effect_process(int16_t *left, int16_t *right, uint32_t num_samples) {
+    if (!is_initialized || !left || !right) {
+        return;
+    }
+
+    // エフェクトが無効、またはスライスバッファをルーパーに貸している場合はスルー
+    if (!base_params.enabled || slice_memory_lent) {
+        return;
+    }
+
+    // クロック分周と小数部の繰り上がりを適用したスライス長
+    uint32_t active_slice_length = get_active_slice_length();
+
+    for (uint32_t chunk_start = 0; chunk_start < num_samples; chunk_start += EFFECT_CHUNK_FRAMES) {
+        uint32_t chunk = num_samples - chunk_start;
+        if (chunk > EFFECT_CHUNK_FRAMES) chunk = EFFECT_CHUNK_FRAMES;
+
+        int16_t *chunk_l = left + chunk_start;
+        int16_t *chunk_r = right + chunk_start;
+
+        // モジュレーション（チャンクごとに1回）
+        apply_modulation(chunk_start, chunk, wet_gain_buf);
+
+        // マルチバンド: エフェクト前の入力を残しておく
+        bool multiband = current_params.multiband_enabled;
+        if (multiband) {
+            memcpy(dry_buf_l, chunk_l, chunk * sizeof(int16_t));
+            memcpy(dry_buf_r, chunk_r, chunk * sizeof(int16_t));
+        }
+
+        // Beat-Slicer（スライスバッファを履歴として使うので Beat-Repeat とは排他）
+        if (current_params.slicer_enabled) {
+            if (!slicer_active) {
+                slicer_arm();
+            }
+            process_slicer(chunk_l, chunk_r, wet_gain_buf, chunk_start, chunk);
+            if (multiband) {
+                apply_multiband(chunk_l, chunk_r, dry_buf_l, dry_buf_r, chunk);
+            }
+            trace_repeat_state();
+            continue;
+        }
+        if (slicer_active) {
+            // Beat-Repeat に戻る: スライスの取り込みからやり直す
+            slicer_active = false;
+            slice_write_pos = 0;
+            last_slice_end = 0;
+            transient_pending = false;
+            transient_detector_reset(&transient_det);
+            active_slice_length = get_active_slice_length();
+        }
+
+        // トランジェントトリガー: 処理で書き換える前の入力を解析
+        uint32_t at = chunk;
+        uint32_t back = 0;
+        bool realign = false;
+        if (current_params.repeat_trigger == REPEAT_TRIGGER_TRANSIENT) {
+            realign = detect_transient(chunk_l, chunk_r, chunk, &at, &back);
+        }
+
+#if EFFECT_SPECIALISED_KERNELS
+        // ウィンドウの有無はモジュレーションで変わりうるのでチャンクごとに選ぶ
+        repeat_kernel_t kernel = select_repeat_kernel();
+
+        // サイドチェイン: リピート中でなくてもエンベロープを追従させておく
+        for (uint32_t i = 0; i < chunk; i++) {
+            duck_gain_buf[i] = current_params.duck_enabled ?
+                compressor_compute_gain(&duck_comp, chunk_l[i], chunk_r[i]) : COMPRESSOR_UNITY_GAIN;
+        }
+
+        // トランジェントの手前までを処理してからスライスを取り直し、残りを処理
+        active_slice_length = process_repeat_frames(kernel, chunk_l, chunk_r,
+                                                    duck_gain_buf, wet_gain_buf,
+                                                    at, active_slice_length);
+        if (realign && !is_repeating && !transient_pending && !current_params.freeze) {
+            realign_slice_capture(back, active_slice_length);
+        }
+        active_slice_length = process_repeat_frames(kernel, chunk_l + at, chunk_r + at,
+                                                    duck_gain_buf + at, wet_gain_buf + at, chunk - at,
+                                                    active_slice_length);
+#else
+        process_generic(chunk_l, chunk_r, wet_gain_buf, at, active_slice_length);
+        active_slice_length = get_active_slice_length();
+        if (realign && !is_repeating && !transient_pending && !current_params.freeze) {
+            realign_slice_capture(back, active_slice_length);
+        }
+        process_generic(chunk_l + at, chunk_r + at, wet_gain_buf + at, chunk - at, active_slice_length);
+        active_slice_length = get_active_slice_length();
+#endif
+
+        if (multiband) {
+            apply_multiband(chunk_l, chunk_r, dry_buf_l, dry_buf_r, chunk);
+        }
+        trace_repeat_state();
     }
 }
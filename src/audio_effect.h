@@ -15,6 +15,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "slicer.h"
+#include "crossover.h"
+
 // ============================================================================
 // エフェクトパラメータ（将来的にロータリーエンコーダで調整予定）
 // ============================================================================
@@ -29,6 +32,14 @@ typedef enum {
     PITCH_MODE_SCRATCH,            // ビニールスクラッチ（正弦波変調）
 } pitch_mode_t;
 
+/**
+ * @brief リピートを始めるきっかけ
+ */
+typedef enum {
+    REPEAT_TRIGGER_PROBABILITY = 0,  // スライス境界ごとにスライス確率で判定
+    REPEAT_TRIGGER_TRANSIENT,        // 入力のトランジェントでスライスを取り直し、次の境界で開始
+} repeat_trigger_t;
+
 /**
  * @brief Beat-Repeatエフェクトのパラメータ
  */
@@ -38,6 +49,11 @@ typedef struct {
     // 44100Hz * 0.5秒 = 22050サンプル（8分音符 @ 120 BPM）
     uint32_t slice_length;
 
+    // スライス長の小数部（1/2^32 サンプル単位）
+    // スライス境界ごとに累積し、繰り上がった時だけ1サンプル長くする
+    // （長時間リピートしてもテンポのグリッドからずれない）
+    uint32_t slice_length_frac;
+
     // リピート回数（1-16回）
     uint8_t repeat_count;
 
@@ -103,6 +119,55 @@ typedef struct {
     // true = 現在のスライスを凍結して無限ループ
     bool freeze;
 
+    // ウェットダッキング（Sidechain Ducking）
+    // true = ドライ入力のトランジェントでリピート音を下げる
+    bool duck_enabled;
+
+    // ============================================================================
+    // トランジェントトリガー
+    // ============================================================================
+
+    // リピートのきっかけ
+    // TRANSIENT = スライス確率の代わりに、入力の強いトランジェント（スネアなど）を検出したら
+    //             その少し前（TRANSIENT_PREROLL_FRAMES）からスライスを取り直し、
+    //             スライスが満杯になった境界でそれを繰り返す（リピート中の検出は捨てる）
+    repeat_trigger_t repeat_trigger;
+
+    // 検出のしきい値（速い/遅いエンベロープの比、1.2-20.0）
+    // 小さいほどハイハットやゴーストノートでも始まる
+    float transient_threshold;
+
+    // 検出後に次を検出しない時間（ms、10-2000）
+    float transient_refractory_ms;
+
+    // ============================================================================
+    // Beat-Slicer
+    // ============================================================================
+
+    // スライサーモード
+    // true = Beat-Repeat の代わりに、直前の小節をスライス長ごとのステップに分け、
+    //        次の小節で並べ替えて再生する（スライス長 = 1ステップ）
+    bool slicer_enabled;
+
+    // 並べ替えパターン（シャッフル、逆順、ユーザー、ランダム）
+    slicer_pattern_t slicer_pattern;
+
+    // ============================================================================
+    // マルチバンド
+    // ============================================================================
+
+    // マルチバンドモード
+    // true = LR4 クロスオーバーで帯域に分け、帯域ごとにリピートを掛けるか決める
+    //        （帯域数と周波数は config.h の EFFECT_MULTIBAND_BANDS / EFFECT_CROSSOVER_*_HZ）
+    bool multiband_enabled;
+
+    // 帯域ごとのリピート有効/無効（低域から）
+    // false の帯域はドライのまま通る（例: 低域 OFF でキックを濁らせない）
+    bool band_repeat[CROSSOVER_MAX_BANDS];
+
+    // 帯域ごとのミックス（0-100%、ウェットミックスに掛ける）
+    uint8_t band_mix[CROSSOVER_MAX_BANDS];
+
 } beat_repeat_params_t;
 
 // ============================================================================
@@ -125,6 +190,15 @@ bool audio_effect_init(uint32_t sample_rate);
  */
 void audio_effect_set_params(const beat_repeat_params_t *params);
 
+/**
+ * @brief エフェクトのパラメータを設定（ログなし）
+ *
+ * 制御プロトコルからの高頻度の自動化用。検証と適用は audio_effect_set_params と同じ。
+ *
+ * @param params エフェクトパラメータ
+ */
+void audio_effect_update_params(const beat_repeat_params_t *params);
+
 /**
  * @brief 現在のパラメータを取得
  *
@@ -135,17 +209,63 @@ void audio_effect_get_params(beat_repeat_params_t *params);
 /**
  * @brief オーディオデータにエフェクトを適用
  *
- * ステレオインターリーブ形式（LRLRLR...）のデータを処理
+ * プレーナー形式（L/R 別配列）のデータをその場で処理
  *
- * @param data PCMデータバッファ（int16_t配列、ステレオインターリーブ）
- * @param num_samples ステレオペア数（total samples / 2）
- * @param num_channels チャンネル数（通常2 = ステレオ）
+ * @param left 左チャンネル（int16_t配列）
+ * @param right 右チャンネル（int16_t配列）
+ * @param num_samples ステレオペア数
  */
-void audio_effect_process(int16_t *data, uint32_t num_samples, uint8_t num_channels);
+void audio_effect_process(int16_t *left, int16_t *right, uint32_t num_samples);
 
 /**
  * @brief エフェクトのリセット（バッファクリア）
  */
 void audio_effect_reset(void);
 
+/**
+ * @brief トランジェントトリガーの統計を取得
+ * @param detections 検出回数
+ * @param triggers 検出からリピートを始めた回数
+ * @param avg_cycles 検出の平均サイクル数/チャンク（256フレーム）
+ * @param max_cycles 検出の最大サイクル数/チャンク
+ */
+void audio_effect_get_transient_stats(uint32_t *detections, uint32_t *triggers,
+                                      uint32_t *avg_cycles, uint32_t *max_cycles);
+
+/**
+ * @brief マルチバンドのクロスオーバーの処理コストを取得
+ * @param avg_cycles 平均サイクル数/チャンク（256フレーム、L+R）
+ * @param max_cycles 最大サイクル数/チャンク
+ */
+void audio_effect_get_multiband_cycles(uint32_t *avg_cycles, uint32_t *max_cycles);
+
+/**
+ * @brief スライス長が範囲外で MIN_SLICE_LENGTH〜MAX_SLICE_LENGTH に丸められた回数を取得
+ */
+uint32_t audio_effect_get_slice_clamps(void);
+
+/**
+ * @brief スライスバッファの大きさ（ルーパーに貸せるバイト数）
+ */
+uint32_t audio_effect_get_slice_memory_bytes(void);
+
+/**
+ * @brief スライスバッファをルーパーに貸す
+ *
+ * 貸している間はエフェクトを有効にしてもスルーする。
+ *
+ * @return バッファの先頭（NULL = エフェクトが有効、または貸し出し中）
+ */
+void *audio_effect_lend_slice_memory(void);
+
+/**
+ * @brief 貸していたスライスバッファを返してもらう（スライス状態をリセット）
+ */
+void audio_effect_return_slice_memory(void);
+
+/**
+ * @brief スライスバッファをルーパーに貸しているか
+ */
+bool audio_effect_is_slice_memory_lent(void);
+
 #endif // AUDIO_EFFECT_H
@@ -7,6 +7,10 @@
 
 #include "audio_out_i2s.h"
 #include "config.h"
+#include "dma_irq.h"
+#include "audio_block.h"
+#include "trace.h"
+#include "sram_layout.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -14,7 +18,6 @@
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
 #include "hardware/dma.h"
-#include "hardware/irq.h"
 #include "hardware/clocks.h"
 
 // PIOプログラムのインクルード（ビルド時に自動生成される）
@@ -33,34 +36,101 @@ static uint32_t sample_rate_hz = 44100;
 static uint8_t bits_per_sample = 16;
 static uint8_t num_channels = 2;
 
-// リングバッファ（ステレオ16ビット）
-#define I2S_BUFFER_SIZE (AUDIO_BUFFER_SIZE * 2)  // ステレオなので2倍
-static int16_t ring_buffer[I2S_BUFFER_SIZE];
-static volatile uint32_t write_pos = 0;
-static volatile uint32_t read_pos = 0;
-static volatile uint32_t buffered_samples = 0;  // ステレオペア数
+// リングバッファ（I2S のワード形式、上位16ビット=左、下位16ビット=右）
+// 書き込み時にプレーナーの L/R を直接ワードにパックするので、DMA 側はワードをコピーするだけ
+#if I2S_QUAD_OUTPUT
+// 4チャンネル: 1フレーム = [ペアA, ペアB] の2ワード、メモリ制約のためフレーム数は半分
+#define I2S_RING_FRAMES      (AUDIO_BUFFER_SIZE / 2)
+#define I2S_NUM_PAIRS        2
+#else
+#define I2S_RING_FRAMES      AUDIO_BUFFER_SIZE
+#define I2S_NUM_PAIRS        1
+#endif
+#define I2S_BUFFER_SIZE (I2S_RING_FRAMES * I2S_NUM_PAIRS)
+static uint32_t ring_buffer[I2S_BUFFER_SIZE];
+
+// DMA 割り込みが毎回触る状態はコア0のスタックと同じ scratch Y に置く
+// （DMA やストライプ領域の大きなバッファへのアクセスと調停で競合しない）
+#define I2S_HOT_STATE SRAM_HOT_STATE("i2s_state")
+static volatile uint32_t I2S_HOT_STATE write_pos = 0;
+static volatile uint32_t I2S_HOT_STATE read_pos = 0;
+static volatile uint32_t I2S_HOT_STATE buffered_samples = 0;  // ステレオペア数
 
 // DMA バッファ（2つのバッファでピンポン方式）
 // バッファサイズを512サンプル（約11.6ms@44.1kHz）に増加
 // これにより、DMA IRQ頻度が大幅に減少し、ジッター/ノイズが低減される
 // DMA IRQ優先度を0xFF（最低）に設定済みなので、Bluetooth処理を妨害しない
+// 1フレームあたりのワード数: ステレオ = 1（左右16ビットずつ）、4チャンネル = 2（左スロット、右スロット）
 #define I2S_DMA_BUFFER_SIZE 512
-static int32_t dma_buffer[2][I2S_DMA_BUFFER_SIZE];  // 32ビット（左右16ビットずつ）
-static volatile uint8_t current_dma_buffer = 0;
+#define I2S_WORDS_PER_FRAME I2S_NUM_PAIRS
+#define I2S_DMA_WORDS       (I2S_DMA_BUFFER_SIZE * I2S_WORDS_PER_FRAME)
+// ピンポン（ステレオで 4KB）は scratch X を丸ごと使い、DMA の読み出しを CPU から切り離す
+#if (2 * I2S_DMA_WORDS * 4) <= SRAM_LAYOUT_SCRATCH_BYTES
+static int32_t SRAM_DMA_BUFFER("i2s_dma") dma_buffer[2][I2S_DMA_WORDS];
+#else
+static int32_t dma_buffer[2][I2S_DMA_WORDS];
+#endif
+static volatile uint8_t I2S_HOT_STATE current_dma_buffer = 0;
 
 // 統計情報
-static uint32_t underrun_count = 0;
+static uint32_t I2S_HOT_STATE underrun_count = 0;
 static uint32_t overrun_count = 0;
 
 // 状態
 static bool is_running = false;
 
+// 深さの制御
+// 開始閾値: 停止中、またはアンダーランで空になった後は、ここまで溜まるまで無音を出す
+// （DMA バッファ2面分を足して、開始直後のリングのフィルが目標深さになるようにする）
+#define DEFAULT_START_THRESHOLD (AUDIO_BUFFER_SIZE / 5)  // 20%
+static volatile uint32_t I2S_HOT_STATE start_threshold = DEFAULT_START_THRESHOLD;
+static volatile bool I2S_HOT_STATE priming = true;
+static uint32_t target_depth = 0;       // 0 = 寄せ込みなし
+static int32_t fill_avg_q4 = 0;         // 書き込み直前のフィルの平均（Q4）
+static bool depth_hold = false;         // 寄せ込みを止める（バリスピードが原速を外れている間）
+#if I2S_QUAD_OUTPUT
+static int32_t pending_slip = 0;        // ペア0で決めた寄せ込みをペア1でも使う
+static uint32_t pending_slips = 0;
+#endif
+
 // ============================================================================
 // 内部関数（前方宣言）
 // ============================================================================
 
 static void dma_handler(void);
 static void fill_dma_buffer(int32_t *buffer, uint32_t num_samples);
+static void check_auto_start(void);
+static int32_t take_depth_slip(void);
+static uint32_t pack_slipped(uint8_t pair, const int16_t *left, const int16_t *right,
+                             uint32_t count, int32_t slip, uint32_t slips);
+
+#if I2S_QUAD_OUTPUT
+// ビット展開テーブル: 8ビット値の各ビットを偶数ビット位置に広げる（0b1011 → 0b01000101）
+// DMA 割り込みの詰め替えで毎ワード引くので、割り込みの状態と同じ scratch Y に置く
+static uint16_t I2S_HOT_STATE bit_spread_lut[256];
+
+static void init_bit_spread_lut(void) {
+    for (uint32_t v = 0; v < 256; v++) {
+        uint16_t spread = 0;
+        for (uint32_t b = 0; b < 8; b++) {
+            if (v & (1u << b)) spread |= (uint16_t)(1u << (2 * b));
+        }
+        bit_spread_lut[v] = spread;
+    }
+}
+
+/**
+ * @brief 2本のデータ線用に1スロット分をビットインターリーブ
+ * @return ビット 2k = a の第kビット（DATA_A）、ビット 2k+1 = b の第kビット（DATA_B）
+ */
+static inline uint32_t interleave_slot(int16_t a, int16_t b) {
+    uint16_t ua = (uint16_t)a;
+    uint16_t ub = (uint16_t)b;
+    uint32_t sa = bit_spread_lut[ua & 0xFF] | ((uint32_t)bit_spread_lut[ua >> 8] << 16);
+    uint32_t sb = bit_spread_lut[ub & 0xFF] | ((uint32_t)bit_spread_lut[ub >> 8] << 16);
+    return sa | (sb << 1);
+}
+#endif
 
 // ============================================================================
 // I2S オーディオ出力の初期化
@@ -79,24 +149,39 @@ bool audio_out_i2s_init(uint32_t sample_rate, uint8_t bits, uint8_t channels) {
     num_channels = channels;
 
     // PIOプログラムをロード
+#if I2S_QUAD_OUTPUT
+    init_bit_spread_lut();
+    offset = pio_add_program(pio, &i2s_output_dual_program);
+    printf("  4-channel mode: DATA_A=%d, DATA_B=%d (%s)\n",
+           I2S_QUAD_DATA_PIN_BASE, I2S_QUAD_DATA_PIN_BASE + 1,
+           I2S_QUAD_MODE == I2S_QUAD_MODE_CROSSOVER ? "crossover" : "dry/wet");
+#else
     offset = pio_add_program(pio, &i2s_output_program);
+#endif
     printf("  PIO program loaded at offset %d\n", offset);
 
     // PIOクロック設定の計算と表示
-    uint32_t pio_clk_freq = sample_rate * 66;  // 66サイクル/ステレオペア
+    uint32_t pio_clk_freq = sample_rate * PIO_CYCLES_PER_STEREO_SAMPLE;
     uint32_t sys_clk = clock_get_hz(clk_sys);
     float clk_div = (float)sys_clk / (float)pio_clk_freq;
     printf("  PIO clock: %lu Hz (divider: %.2f)\n", pio_clk_freq, clk_div);
-    printf("  BCLK frequency: %lu Hz (64 × sample rate)\n", sample_rate * 64);
+    printf("  BCLK frequency: %lu Hz (32 × sample rate)\n", pio_clk_freq / 2);
 
     // PIO State Machineを初期化
+#if I2S_QUAD_OUTPUT
+    i2s_output_dual_program_init(pio, sm, offset, I2S_QUAD_DATA_PIN_BASE, I2S_BCLK_PIN, sample_rate);
+#else
     i2s_output_program_init(pio, sm, offset, I2S_DATA_PIN, I2S_BCLK_PIN, sample_rate);
+#endif
 
     // DMA チャンネルを取得
     dma_channel = dma_claim_unused_channel(true);
     printf("I2S audio output initialized successfully\n");
     printf("  DMA channel: %d\n", dma_channel);
     printf("  PIO: pio%d, SM: %d\n", pio == pio0 ? 0 : 1, sm);
+    sram_layout_log_buffer("i2s dma_buffer", dma_buffer, sizeof(dma_buffer));
+    sram_layout_log_buffer("i2s ring_buffer", ring_buffer, sizeof(ring_buffer));
+    sram_layout_log_buffer("i2s irq state", (const void *)&read_pos, sizeof(read_pos));
 
     // DMA の設定
     dma_channel_config c = dma_channel_get_default_config(dma_channel);
@@ -110,21 +195,15 @@ bool audio_out_i2s_init(uint32_t sample_rate, uint8_t bits, uint8_t channels) {
         &c,
         &pio->txf[sm],              // 書き込み先: PIO TX FIFO
         dma_buffer[0],              // 読み込み元: DMAバッファ
-        I2S_DMA_BUFFER_SIZE,        // 転送数
+        I2S_DMA_WORDS,              // 転送数
         false                       // まだ開始しない
     );
 
-    // DMA 割り込みハンドラーを設定
-    dma_channel_set_irq0_enabled(dma_channel, true);
-    irq_set_exclusive_handler(DMA_IRQ_0, dma_handler);
-
-    // DMA割り込み優先度を絶対最低に設定（CYW43のBluetooth処理を妨害しないため）
-    // 0x00=最高優先度、0xFF=絶対最低優先度
-    // Cortex-M33では実際には2ビット優先度（0-3）で、0xFFは最低の3にマップされる
-    irq_set_priority(DMA_IRQ_0, DMA_IRQ_PRIORITY);
-
-    irq_set_enabled(DMA_IRQ_0, true);
-    printf("  DMA IRQ priority set to absolute lowest (0x%02X)\n", DMA_IRQ_PRIORITY);
+    // DMA 完了ハンドラーを共有ディスパッチャーに登録
+    // （DMA_IRQ_0 の優先度は dma_irq モジュールが DMA_IRQ_PRIORITY に設定する）
+    if (!dma_irq_register(dma_channel, dma_handler)) {
+        return false;
+    }
 
     // バッファをクリア
     audio_out_i2s_clear_buffer();
@@ -136,46 +215,42 @@ bool audio_out_i2s_init(uint32_t sample_rate, uint8_t bits, uint8_t channels) {
 // PCM データをバッファに書き込む
 // ============================================================================
 
-uint32_t audio_out_i2s_write(const int16_t *pcm_data, uint32_t num_samples) {
-    uint32_t samples_written = 0;
-
+uint32_t audio_out_i2s_write(const int16_t *left, const int16_t *right, uint32_t num_samples) {
+#if I2S_QUAD_OUTPUT
+    // 4チャンネル出力時は両方のペアに同じデータを書き込む
+    audio_out_i2s_write_pair(0, left, right, num_samples);
+    return audio_out_i2s_write_pair(1, left, right, num_samples);
+#else
     static uint32_t write_call_count = 0;
     static uint32_t total_written = 0;
     uint32_t buffered_before = buffered_samples;
 
     write_call_count++;
+    TRACE_BEGIN(TRACE_EV_RING_WRITE, num_samples);
 
     // num_samplesはステレオペア数として扱う
-    for (uint32_t i = 0; i < num_samples; i++) {
-        uint32_t free_space = I2S_BUFFER_SIZE / 2 - buffered_samples;
+    uint32_t free_space = I2S_RING_FRAMES - buffered_samples;
+    uint32_t count = num_samples;
+    int32_t slip = take_depth_slip();
+    if (count > free_space) {
+        // バッファがいっぱい（オーバーラン）
+        count = free_space;
+        overrun_count++;
+        slip = 0;
+    }
 
-        if (free_space == 0) {
-            // バッファがいっぱい（オーバーラン）
-            overrun_count++;
-            break;
-        }
+    // 目標深さへの寄せ込み（区間ごとに1フレーム間引く / 重複させる）
+    uint32_t slips = (slip != 0) ? (count + I2S_DEPTH_SLIP_SPACING - 1) / I2S_DEPTH_SLIP_SPACING : 0;
+    if (slip > 0 && count + slips > free_space) slips = 0;
 
-        // ステレオデータをリングバッファに書き込み
-        ring_buffer[write_pos * 2] = pcm_data[i * 2];       // 左チャンネル
-        ring_buffer[write_pos * 2 + 1] = pcm_data[i * 2 + 1]; // 右チャンネル
+    uint32_t written = pack_slipped(0, left, right, count, slip, slips);
 
-        write_pos = (write_pos + 1) % (I2S_BUFFER_SIZE / 2);
-        buffered_samples++;
-        samples_written++;
-    }
+    write_pos = (write_pos + written) % I2S_RING_FRAMES;
+    buffered_samples += written;
+    total_written += written;
 
-    total_written += samples_written;
-
-    // 自動開始: バッファがある程度埋まったらDMAを開始
-    // buffered_samplesはステレオペア数なので、AUDIO_BUFFER_SIZEと比較
-    // 20%でスタート（バッファに余裕を持たせてUnderrunsを防止）
-    #define AUTO_START_THRESHOLD (AUDIO_BUFFER_SIZE / 5)  // 20%
-    if (!is_running && buffered_samples >= AUTO_START_THRESHOLD) {
-        float buffer_percent = (float)buffered_samples * 100.0f / AUDIO_BUFFER_SIZE;
-        printf("[I2S] Auto-starting DMA (buffer: %lu/%u samples, %.1f%%)\n",
-               buffered_samples, AUDIO_BUFFER_SIZE, buffer_percent);
-        audio_out_i2s_start();
-    }
+    check_auto_start();
+    TRACE_END(TRACE_EV_RING_WRITE, buffered_samples);
 
     // N回ごとにログ出力（頻度はconfig.hで設定）
     if (write_call_count % STATS_LOG_FREQUENCY == 0) {
@@ -183,7 +258,174 @@ uint32_t audio_out_i2s_write(const int16_t *pcm_data, uint32_t num_samples) {
                write_call_count, total_written, buffered_before, buffered_samples);
     }
 
-    return samples_written;
+    return count;
+#endif
+}
+
+// ============================================================================
+// 4チャンネル出力: ペア単位の書き込み
+// ============================================================================
+
+uint32_t audio_out_i2s_write_pair(uint8_t pair, const int16_t *left, const int16_t *right,
+                                  uint32_t num_samples) {
+#if I2S_QUAD_OUTPUT
+    if (pair >= I2S_NUM_PAIRS) return 0;
+    TRACE_BEGIN(TRACE_EV_RING_WRITE, num_samples);
+
+    // 空き容量はDMA側が読み進めるだけ増えるので、ペア0で書いた範囲は
+    // 同じブロックのペア1の書き込み時にも必ず空いている
+    uint32_t free_space = I2S_RING_FRAMES - buffered_samples;
+    uint32_t count = num_samples;
+
+    // 寄せ込みはペア0で決めて、両方のペアに同じ位置で掛ける
+    if (pair == 0) {
+        pending_slip = take_depth_slip();
+        pending_slips = (pending_slip != 0) ?
+            (count + I2S_DEPTH_SLIP_SPACING - 1) / I2S_DEPTH_SLIP_SPACING : 0;
+        if (count > free_space ||
+            (pending_slip > 0 && count + pending_slips > free_space)) {
+            pending_slips = 0;
+        }
+    }
+    if (count > free_space) {
+        count = free_space;
+        if (pair == I2S_NUM_PAIRS - 1) overrun_count++;
+    }
+
+    uint32_t written = pack_slipped(pair, left, right, count, pending_slip, pending_slips);
+
+    // 最後のペアの書き込みでフレームを確定する（それまでは書き込み位置の先に仮置き）
+    if (pair == I2S_NUM_PAIRS - 1) {
+        write_pos = (write_pos + written) % I2S_RING_FRAMES;
+        buffered_samples += written;
+        check_auto_start();
+    }
+    TRACE_END(TRACE_EV_RING_WRITE, buffered_samples);
+
+    return count;
+#else
+    // ステレオ出力ではペア0のみ
+    return (pair == 0) ? audio_out_i2s_write(left, right, num_samples) : 0;
+#endif
+}
+
+// ============================================================================
+// リングへのパック（目標深さへの寄せ込み付き）
+// ============================================================================
+
+/**
+ * @brief 書き込み位置 pos から n フレームをパック（リング末尾で折り返す）
+ */
+static void pack_frames(uint8_t pair, const int16_t *left, const int16_t *right,
+                        uint32_t pos, uint32_t n) {
+#if I2S_QUAD_OUTPUT
+    for (uint32_t i = 0; i < n; i++) {
+        ring_buffer[pos * I2S_NUM_PAIRS + pair] = audio_block_pack_i2s(left[i], right[i]);
+        pos = (pos + 1) % I2S_RING_FRAMES;
+    }
+#else
+    (void)pair;
+    // リングの末尾で折り返すので最大2区間に分けてパック
+    uint32_t first = I2S_RING_FRAMES - pos;
+    if (first > n) first = n;
+    audio_block_pack_i2s_words(left, right, &ring_buffer[pos], first);
+    audio_block_pack_i2s_words(left + first, right + first, &ring_buffer[0], n - first);
+#endif
+}
+
+/**
+ * @brief count フレームを slips 個の区間に分け、各区間の中央で1フレーム間引く（slip < 0）
+ *        または重複させる（slip > 0）
+ * @return リングに書いたフレーム数（count + slip × slips）
+ */
+static uint32_t pack_slipped(uint8_t pair, const int16_t *left, const int16_t *right,
+                             uint32_t count, int32_t slip, uint32_t slips) {
+    if (slip == 0 || slips == 0 || count < 2) {
+        pack_frames(pair, left, right, write_pos, count);
+        return count;
+    }
+
+    uint32_t src = 0;
+    uint32_t pos = write_pos;
+    for (uint32_t s = 0; s < slips; s++) {
+        uint32_t mid = (2 * s + 1) * count / (2 * slips);
+        // 間引き: [src, mid) を書いて mid を飛ばす / 重複: [src, mid] を書いて次も mid から
+        uint32_t n = (slip < 0) ? mid - src : mid - src + 1;
+        pack_frames(pair, left + src, right + src, pos, n);
+        pos = (pos + n) % I2S_RING_FRAMES;
+        src = (slip < 0) ? mid + 1 : mid;
+    }
+    pack_frames(pair, left + src, right + src, pos, count - src);
+
+    return (slip < 0) ? count - slips : count + slips;
+}
+
+/**
+ * @brief 書き込み直前のフィルと目標深さを比べて寄せ込みの向きを決める
+ * @return -1 間引く, +1 重複させる, 0 そのまま
+ */
+static int32_t take_depth_slip(void) {
+    if (!is_running || priming || target_depth == 0) {
+        return 0;
+    }
+
+    // フィルは DMA の消費とバースト受信で揺れるので平均で比べる（1/64 の指数移動平均）
+    fill_avg_q4 += ((int32_t)(buffered_samples << 4) - fill_avg_q4) / 64;
+    int32_t fill = fill_avg_q4 >> 4;
+
+    // バリスピード中のフィルの伸び縮みは意図したものなので寄せ戻さない
+    // （平均は更新し続け、原速に戻ったところから寄せ込みを再開する）
+    if (depth_hold) return 0;
+
+    // DMA バッファ半面分の不感帯
+    int32_t tolerance = I2S_DMA_BUFFER_SIZE / 2;
+    if (fill > (int32_t)target_depth + tolerance) return -1;
+    if (fill + tolerance < (int32_t)target_depth) return 1;
+    return 0;
+}
+
+// ============================================================================
+// 目標深さの設定
+// ============================================================================
+
+void audio_out_i2s_set_target_depth(uint32_t frames) {
+    uint32_t max_depth = I2S_RING_FRAMES * 3 / 4;
+    if (frames < I2S_DMA_BUFFER_SIZE) frames = I2S_DMA_BUFFER_SIZE;
+    if (frames > max_depth) frames = max_depth;
+
+    if (target_depth == 0) {
+        // 寄せ込みの開始時は平均を目標から始める
+        fill_avg_q4 = (int32_t)(frames << 4);
+    }
+    target_depth = frames;
+
+    // 開始直後に DMA バッファ2面分がリングから出ていくので、その分を足す
+    uint32_t threshold = frames + 2 * I2S_DMA_BUFFER_SIZE;
+    start_threshold = (threshold < I2S_RING_FRAMES) ? threshold : I2S_RING_FRAMES;
+}
+
+uint32_t audio_out_i2s_get_target_depth(void) {
+    return target_depth;
+}
+
+void audio_out_i2s_hold_depth(bool hold) {
+    depth_hold = hold;
+}
+
+// ============================================================================
+// 自動開始
+// ============================================================================
+
+static void check_auto_start(void) {
+    // 自動開始: バッファが開始閾値まで埋まったらDMAを開始
+    // buffered_samplesはステレオペア数なので、ステレオペア数の閾値と比較
+    // （既定は AUDIO_BUFFER_SIZE の 20%、適応バッファでは目標深さから決まる）
+    if (!is_running && buffered_samples >= start_threshold) {
+        float buffer_percent = (float)buffered_samples * 100.0f / I2S_RING_FRAMES;
+        printf("[I2S] Auto-starting DMA (buffer: %lu/%u samples, %.1f%%)\n",
+               buffered_samples, I2S_RING_FRAMES, buffer_percent);
+        audio_out_i2s_start();
+    }
 }
 
 // ============================================================================
@@ -191,7 +433,7 @@ uint32_t audio_out_i2s_write(const int16_t *pcm_data, uint32_t num_samples) {
 // ============================================================================
 
 uint32_t audio_out_i2s_get_free_space(void) {
-    return (I2S_BUFFER_SIZE / 2) - buffered_samples;
+    return I2S_RING_FRAMES - buffered_samples;
 }
 
 // ============================================================================
@@ -202,6 +444,18 @@ uint32_t audio_out_i2s_get_buffered_samples(void) {
     return buffered_samples;
 }
 
+// ============================================================================
+// DMA バッファ内のデータ量を取得
+// ============================================================================
+
+uint32_t audio_out_i2s_get_dma_frames(void) {
+    if (!is_running) return 0;
+
+    // 転送中のバッファの残り（転送カウンタはワード数）+ 充填済みの次のバッファ
+    uint32_t remaining_words = dma_channel_hw_addr(dma_channel)->transfer_count;
+    return remaining_words / I2S_WORDS_PER_FRAME + I2S_DMA_BUFFER_SIZE;
+}
+
 // ============================================================================
 // オーディオ出力を開始
 // ============================================================================
@@ -259,6 +513,9 @@ void audio_out_i2s_clear_buffer(void) {
     underrun_count = 0;
     overrun_count = 0;
 
+    // 次のストリームも開始閾値まで溜めてから鳴らす
+    priming = true;
+
     // 無音で埋める
     memset(ring_buffer, 0, sizeof(ring_buffer));
     memset(dma_buffer, 0, sizeof(dma_buffer));
@@ -278,21 +535,38 @@ void audio_out_i2s_get_stats(uint32_t *underruns, uint32_t *overruns) {
 // ============================================================================
 
 static void fill_dma_buffer(int32_t *buffer, uint32_t num_samples) {
-    for (uint32_t i = 0; i < num_samples; i++) {
-        if (buffered_samples > 0) {
-            // リングバッファからステレオデータを読み出す
-            int16_t left = ring_buffer[read_pos * 2];
-            int16_t right = ring_buffer[read_pos * 2 + 1];
-
-            // 32ビットワードにパック（上位16ビット=左、下位16ビット=右）
-            buffer[i] = ((uint32_t)(uint16_t)left << 16) | (uint16_t)right;
+    // 空になった後は開始閾値まで溜まるのを待つ（少量ずつ鳴らしてはすぐ途切れるのを防ぐ）
+    if (priming && buffered_samples >= start_threshold) {
+        priming = false;
+    }
 
-            read_pos = (read_pos + 1) % (I2S_BUFFER_SIZE / 2);
+    for (uint32_t i = 0; i < num_samples; i++) {
+        if (!priming && buffered_samples > 0) {
+#if I2S_QUAD_OUTPUT
+            // 左スロット、右スロットの順に2本のデータ線分をインターリーブ
+            uint32_t a = ring_buffer[read_pos * I2S_NUM_PAIRS];
+            uint32_t b = ring_buffer[read_pos * I2S_NUM_PAIRS + 1];
+            buffer[i * 2] = (int32_t)interleave_slot((int16_t)(a >> 16), (int16_t)(b >> 16));
+            buffer[i * 2 + 1] = (int32_t)interleave_slot((int16_t)a, (int16_t)b);
+#else
+            // 書き込み時にワード形式にパック済み
+            buffer[i] = (int32_t)ring_buffer[read_pos];
+#endif
+
+            read_pos = (read_pos + 1) % I2S_RING_FRAMES;
             buffered_samples--;
         } else {
             // データがない場合は無音を出力（アンダーラン）
-            buffer[i] = 0;
-            underrun_count++;
+            for (uint32_t w = 0; w < I2S_WORDS_PER_FRAME; w++) {
+                buffer[i * I2S_WORDS_PER_FRAME + w] = 0;
+            }
+            // 再生中に空になったときだけアンダーランと数え、以降は溜め直しの無音
+            if (!priming) {
+                underrun_count++;
+                priming = true;
+                TRACE_INSTANT(TRACE_EV_UNDERRUN, underrun_count);
+                TRACE_TRIGGER();
+            }
         }
     }
 }
@@ -301,23 +575,25 @@ static void fill_dma_buffer(int32_t *buffer, uint32_t num_samples) {
 // DMA 割り込みハンドラー
 // ============================================================================
 
+// 割り込みフラグのクリアは dma_irq ディスパッチャーが行う
 static void dma_handler(void) {
-    if (dma_channel_get_irq0_status(dma_channel)) {
-        dma_channel_acknowledge_irq0(dma_channel);
+    TRACE_BEGIN(TRACE_EV_DMA_IRQ, buffered_samples);
 
-        // ピンポンバッファの正しい実装:
-        // 1. 次のバッファ（すでに埋まっている）でDMAを即座に再開
-        // 2. 今終わったバッファを再充填（次回のために）
-        uint8_t finished_buffer = current_dma_buffer;
-        uint8_t next_buffer = 1 - current_dma_buffer;
+    // ピンポンバッファの正しい実装:
+    // 1. 次のバッファ（すでに埋まっている）でDMAを即座に再開
+    // 2. 今終わったバッファを再充填（次回のために）
+    uint8_t finished_buffer = current_dma_buffer;
+    uint8_t next_buffer = 1 - current_dma_buffer;
 
-        // DMAを次のバッファで即座に再起動（遅延を最小化）
-        dma_channel_set_read_addr(dma_channel, dma_buffer[next_buffer], true);
+    // DMAを次のバッファで即座に再起動（遅延を最小化）
+    dma_channel_set_read_addr(dma_channel, dma_buffer[next_buffer], true);
 
-        // 終わったバッファを再充填（次回の使用のため）
-        fill_dma_buffer(dma_buffer[finished_buffer], I2S_DMA_BUFFER_SIZE);
+    // 終わったバッファを再充填（次回の使用のため）
+    fill_dma_buffer(dma_buffer[finished_buffer], I2S_DMA_BUFFER_SIZE);
 
-        // 現在のバッファインデックスを更新
-        current_dma_buffer = next_buffer;
-    }
+    // 現在のバッファインデックスを更新
+    current_dma_buffer = next_buffer;
+
+    TRACE_COUNTER(TRACE_EV_RING_FILL, buffered_samples);
+    TRACE_END(TRACE_EV_DMA_IRQ, buffered_samples);
 }
@@ -19,12 +19,28 @@
 bool audio_out_i2s_init(uint32_t sample_rate, uint8_t bits_per_sample, uint8_t channels);
 
 /**
- * @brief PCM データをバッファに書き込む
- * @param pcm_data PCM データ（16bit signed, インターリーブ形式）
- * @param num_samples サンプル数（ステレオの場合、L/Rペアの数）
+ * @brief PCM データをバッファに書き込む（I2S のワード形式にパック）
+ * @param left 左チャンネル（16bit signed, プレーナー）
+ * @param right 右チャンネル（16bit signed, プレーナー）
+ * @param num_samples サンプル数（L/Rペアの数）
  * @return 書き込んだサンプル数
  */
-uint32_t audio_out_i2s_write(const int16_t *pcm_data, uint32_t num_samples);
+uint32_t audio_out_i2s_write(const int16_t *left, const int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief 4チャンネル出力時に1組の DAC（ステレオペア）分だけ書き込む
+ *
+ * I2S_QUAD_OUTPUT = 1 の場合、ペア0を先に書いて仮置きし、同じフレーム数の
+ * ペア1の書き込みでフレームを確定する。ステレオ出力ではペア0のみ有効。
+ *
+ * @param pair ステレオペア番号（0 = DATA_A, 1 = DATA_B）
+ * @param left 左チャンネル（16bit signed, プレーナー）
+ * @param right 右チャンネル（16bit signed, プレーナー）
+ * @param num_samples サンプル数（L/Rペアの数）
+ * @return 書き込んだサンプル数
+ */
+uint32_t audio_out_i2s_write_pair(uint8_t pair, const int16_t *left, const int16_t *right,
+                                  uint32_t num_samples);
 
 /**
  * @brief バッファの空き容量を取得
@@ -38,6 +54,43 @@ uint32_t audio_out_i2s_get_free_space(void);
  */
 uint32_t audio_out_i2s_get_buffered_samples(void);
 
+/**
+ * @brief DMA バッファに積まれて出力待ちのフレーム数を取得
+ *
+ * 転送中のバッファの残り + 次に送るバッファ。停止中は 0。
+ *
+ * @return フレーム数
+ */
+uint32_t audio_out_i2s_get_dma_frames(void);
+
+/**
+ * @brief 出力リングの目標深さを設定
+ *
+ * 開始閾値（停止中やアンダーランで空になった後、鳴らし始めるフィル）も
+ * この深さから決まる。再生中は書き込み時に少しずつフレームを間引く / 重複させて
+ * フィルを目標に寄せる（I2S_DEPTH_SLIP_SPACING フレームごとに最大1フレーム）。
+ *
+ * @param frames 目標深さ（フレーム数、DMA バッファ1面分〜リングの 3/4 でクランプ）
+ */
+void audio_out_i2s_set_target_depth(uint32_t frames);
+
+/**
+ * @brief 出力リングの目標深さを取得
+ * @return フレーム数（0 = 未設定、固定の開始閾値で動作）
+ */
+uint32_t audio_out_i2s_get_target_depth(void);
+
+/**
+ * @brief 目標深さへの寄せ込みを止める / 再開する
+ *
+ * バリスピードが原速を外れている間は、フィルの伸び縮みをバリスピード側が
+ * リングの余裕の中に収めるので、寄せ込みで打ち消さない（varispeed_process() が呼ぶ）。
+ * 止めている間もフィルの平均は更新する。
+ *
+ * @param hold true: 止める, false: 再開する
+ */
+void audio_out_i2s_hold_depth(bool hold);
+
 /**
  * @brief オーディオ出力を開始
  */
@@ -1,10 +1,22 @@
 /**
  * @file audio_out_pwm.c
- * @brief PWM 簡易 DAC オーディオ出力モジュール（DMA + リングバッファ）
+ * @brief PWM Σ-Δ オーディオ出力モジュール（ステレオ、DMA + リングバッファ）
+ *
+ * ヘッドホン/キュー用の安価なサブ出力。
+ * 1つの PWM スライスの A/B チャンネルを L/R に使い、サンプルレートの
+ * PWM_OVERSAMPLE 倍のキャリアで駆動する。16ビット入力は2次ノイズシェーピング
+ * （NTF = (1 - z^-1)^2）で PWM レベル数まで再量子化し、量子化ノイズを
+ * 可聴帯域外へ追い出すことで 12-14 ビット相当の SNR を得る。
+ *
+ * リングバッファとピンポン DMA の構成は I2S 出力と同じ。
+ * DMA は 32ビットワード（下位16ビット=A/L, 上位16ビット=B/R）を
+ * PWM の CC レジスタへ PWM ラップごとに1回書き込む。
  */
 
 #include "audio_out_pwm.h"
 #include "config.h"
+#include "dma_irq.h"
+#include "audio_block.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -12,7 +24,6 @@
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
 #include "hardware/dma.h"
-#include "hardware/irq.h"
 #include "hardware/clocks.h"
 
 // ============================================================================
@@ -20,21 +31,44 @@
 // ============================================================================
 
 static uint slice_num;
-static uint channel;
 static int dma_channel = -1;
 
 static uint32_t sample_rate_hz = 44100;
 
-// リングバッファ（モノラル）
-#define PWM_BUFFER_SIZE (AUDIO_BUFFER_SIZE)
-static uint8_t ring_buffer[PWM_BUFFER_SIZE];
+// PWM ラップ値（レベル数 = pwm_top + 1）
+static uint32_t pwm_top = 0;
+
+// 入力スケール（Q16）: 16ビット入力を [2, pwm_top - 1] LSB に写像する
+// 上下2 LSBの余裕は誤差フィードバック（最大1.5 LSB）分
+static int32_t pwm_scale = 0;
+
+// リングバッファ（ステレオ16ビット）
+static int16_t ring_buffer[PWM_BUFFER_SIZE * 2];
 static volatile uint32_t write_pos = 0;
 static volatile uint32_t read_pos = 0;
-static volatile uint32_t buffered_samples = 0;
+static volatile uint32_t buffered_samples = 0;  // ステレオペア数
+
+// DMA バッファ（ピンポン方式、1ステレオペアあたり PWM_OVERSAMPLE ワード）
+#define PWM_DMA_WORDS (PWM_DMA_BUFFER_SIZE * PWM_OVERSAMPLE)
+static uint32_t dma_buffer[2][PWM_DMA_WORDS];
+static volatile uint8_t current_dma_buffer = 0;
+
+// Σ-Δ モジュレータの状態（チャンネルごと）
+typedef struct {
+    int32_t prev;  // 前サンプルの入力（Q16、オーバーサンプル間の線形補間用）
+    int32_t e1;    // 1ステップ前の量子化誤差（Q16）
+    int32_t e2;    // 2ステップ前の量子化誤差（Q16）
+} sd_state_t;
 
-// DMA バッファ
-#define PWM_DMA_BUFFER_SIZE 512
-static uint8_t dma_buffer[PWM_DMA_BUFFER_SIZE];
+static sd_state_t sd_state[2];
+
+// 自動開始の閾値（50%）
+#define PWM_AUTO_START_THRESHOLD  (PWM_BUFFER_SIZE / 2)
+
+// キャリア周波数は整数分周なので I2S と僅かにレートがずれる
+// バッファ残量がこの範囲を外れたら DMA ブロックごとに1サンプルずつ補正する
+#define PWM_SLIP_LOW_THRESHOLD    (PWM_BUFFER_SIZE / 4)
+#define PWM_SLIP_HIGH_THRESHOLD   (PWM_BUFFER_SIZE * 3 / 4)
 
 // 統計情報
 static uint32_t underrun_count = 0;
@@ -48,50 +82,103 @@ static bool is_running = false;
 // ============================================================================
 
 static void dma_handler(void);
-static void fill_dma_buffer(uint8_t *buffer, uint32_t num_samples);
+static void fill_dma_buffer(uint32_t *buffer, uint32_t num_samples);
+static void reset_modulator(void);
+
+// ============================================================================
+// Σ-Δ モジュレータ
+// ============================================================================
+
+/**
+ * @brief 16ビット PCM を Q16 の PWM レベルに変換
+ */
+static inline int32_t pcm_to_level_q16(int16_t sample) {
+    return ((int32_t)sample + 32768) * pwm_scale + (2 << 16);
+}
+
+/**
+ * @brief 2次誤差フィードバック型ノイズシェーパー（1ステップ）
+ *
+ * u = x - 2·e[n-1] + e[n-2], y = round(u), e = y - u
+ * → y = x + (1 - z^-1)^2 · e
+ */
+static inline uint32_t sd_modulate(sd_state_t *st, int32_t x_q16) {
+    int32_t u = x_q16 - 2 * st->e1 + st->e2;
+    int32_t y = (u + 0x8000) >> 16;
+
+    if (y < 0) y = 0;
+    if (y > (int32_t)pwm_top) y = (int32_t)pwm_top;
+
+    int32_t e = (y << 16) - u;
+
+    // クランプ時も誤差を ±1 LSB に抑えて発振を防ぐ
+    if (e > (1 << 16)) e = (1 << 16);
+    if (e < -(1 << 16)) e = -(1 << 16);
+
+    st->e2 = st->e1;
+    st->e1 = e;
+
+    return (uint32_t)y;
+}
+
+static void reset_modulator(void) {
+    for (int ch = 0; ch < 2; ch++) {
+        sd_state[ch].prev = pcm_to_level_q16(0);
+        sd_state[ch].e1 = 0;
+        sd_state[ch].e2 = 0;
+    }
+}
 
 // ============================================================================
 // PWM オーディオ出力の初期化
 // ============================================================================
 
 bool audio_out_pwm_init(uint32_t sample_rate) {
-    printf("Initializing PWM audio output...\n");
+    printf("Initializing PWM sigma-delta audio output...\n");
     printf("  Sample rate: %lu Hz\n", sample_rate);
-    printf("  Resolution: %d bits\n", PWM_RESOLUTION_BITS);
-    printf("  Output pin: GPIO %d\n", PWM_AUDIO_PIN);
+    printf("  Oversampling: x%d\n", PWM_OVERSAMPLE);
+    printf("  Output pins: L=GPIO %d, R=GPIO %d\n", PWM_AUDIO_PIN_L, PWM_AUDIO_PIN_R);
 
     sample_rate_hz = sample_rate;
 
-    // PWM ピンの初期化
-    gpio_set_function(PWM_AUDIO_PIN, GPIO_FUNC_PWM);
-
-    // PWM スライスとチャンネルを取得
-    slice_num = pwm_gpio_to_slice_num(PWM_AUDIO_PIN);
-    channel = pwm_gpio_to_channel(PWM_AUDIO_PIN);
+    // L/R は同じスライスの A/B チャンネルである必要がある（CC レジスタを1ワードで更新するため）
+    slice_num = pwm_gpio_to_slice_num(PWM_AUDIO_PIN_L);
+    if (pwm_gpio_to_slice_num(PWM_AUDIO_PIN_R) != slice_num ||
+        pwm_gpio_to_channel(PWM_AUDIO_PIN_L) != 0 ||
+        pwm_gpio_to_channel(PWM_AUDIO_PIN_R) != 1) {
+        printf("ERROR: PWM L/R pins must be channel A/B of the same slice\n");
+        return false;
+    }
 
-    // PWM 設定
-    pwm_config config = pwm_get_default_config();
+    gpio_set_function(PWM_AUDIO_PIN_L, GPIO_FUNC_PWM);
+    gpio_set_function(PWM_AUDIO_PIN_R, GPIO_FUNC_PWM);
 
-    // PWM の周波数を設定
-    // PWM 周波数 = システムクロック / (wrap + 1) / div
-    // サンプリングレートに合わせる
-    uint32_t wrap = (1 << PWM_RESOLUTION_BITS) - 1;  // 8bit なら 255
-    float div = (float)clock_get_hz(clk_sys) / (sample_rate * (wrap + 1));
+    // PWM キャリア = システムクロック / (top + 1)（整数分周、ジッターなし）
+    uint32_t sys_clk = clock_get_hz(clk_sys);
+    uint32_t top = sys_clk / (sample_rate * PWM_OVERSAMPLE) - 1;
+    if (top > 0xFFFF) top = 0xFFFF;
+    pwm_top = top;
+    pwm_scale = (int32_t)pwm_top - 3;
 
-    pwm_config_set_clkdiv(&config, div);
-    pwm_config_set_wrap(&config, wrap);
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv_int(&config, 1);
+    pwm_config_set_wrap(&config, (uint16_t)pwm_top);
+    pwm_init(slice_num, &config, false);
 
-    pwm_init(slice_num, &config, true);
+    uint32_t carrier_hz = sys_clk / (pwm_top + 1);
+    printf("  PWM carrier: %lu Hz, levels: %lu\n", carrier_hz, pwm_top + 1);
+    printf("  Effective sample rate: %lu Hz (drift compensated by sample slip)\n",
+           carrier_hz / PWM_OVERSAMPLE);
 
     // DMA チャンネルを取得
     dma_channel = dma_claim_unused_channel(true);
 
     printf("  DMA channel: %d\n", dma_channel);
-    printf("  PWM slice: %d, channel: %d\n", slice_num, channel);
+    printf("  PWM slice: %d\n", slice_num);
 
-    // DMA の設定
+    // DMA の設定（32ビットで A/B 両チャンネルの比較値を同時に更新）
     dma_channel_config c = dma_channel_get_default_config(dma_channel);
-    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
     channel_config_set_read_increment(&c, true);
     channel_config_set_write_increment(&c, false);
     channel_config_set_dreq(&c, DREQ_PWM_WRAP0 + slice_num);
@@ -99,16 +186,16 @@ bool audio_out_pwm_init(uint32_t sample_rate) {
     dma_channel_configure(
         dma_channel,
         &c,
-        &pwm_hw->slice[slice_num].cc,  // PWM カウンタ比較レジスタ
-        dma_buffer,
-        PWM_DMA_BUFFER_SIZE,
+        &pwm_hw->slice[slice_num].cc,  // PWM カウンタ比較レジスタ（A/B）
+        dma_buffer[0],
+        PWM_DMA_WORDS,
         false
     );
 
-    // DMA 割り込みハンドラーを設定
-    dma_channel_set_irq0_enabled(dma_channel, true);
-    irq_set_exclusive_handler(DMA_IRQ_0, dma_handler);
-    irq_set_enabled(DMA_IRQ_0, true);
+    // DMA 完了ハンドラーを共有ディスパッチャーに登録（I2S と同じ DMA_IRQ_0）
+    if (!dma_irq_register(dma_channel, dma_handler)) {
+        return false;
+    }
 
     // バッファをクリア
     audio_out_pwm_clear_buffer();
@@ -122,38 +209,30 @@ bool audio_out_pwm_init(uint32_t sample_rate) {
 // PCM データをバッファに書き込む
 // ============================================================================
 
-uint32_t audio_out_pwm_write(const int16_t *pcm_data, uint32_t num_samples, uint8_t channels) {
-    uint32_t samples_written = 0;
-
-    for (uint32_t i = 0; i < num_samples; i++) {
-        uint32_t free_space = PWM_BUFFER_SIZE - buffered_samples;
-
-        if (free_space == 0) {
-            // バッファがいっぱい（オーバーラン）
-            overrun_count++;
-            break;
-        }
-
-        // 16bit signed PCM を 8bit unsigned PWM 値に変換
-        int16_t sample;
+uint32_t audio_out_pwm_write(const int16_t *left, const int16_t *right, uint32_t num_samples) {
+    // num_samplesはステレオペア数として扱う
+    uint32_t free_space = PWM_BUFFER_SIZE - buffered_samples;
+    uint32_t samples_written = num_samples;
+    if (samples_written > free_space) {
+        // バッファがいっぱい（オーバーラン）
+        samples_written = free_space;
+        overrun_count++;
+    }
 
-        if (channels == 2) {
-            // ステレオの場合、L と R を平均化してモノラルに変換
-            int32_t left = pcm_data[i * 2];
-            int32_t right = pcm_data[i * 2 + 1];
-            sample = (int16_t)((left + right) / 2);
-        } else {
-            // モノラル
-            sample = pcm_data[i];
-        }
+    // リングの末尾で折り返すので最大2区間に分けてインターリーブ
+    uint32_t first = PWM_BUFFER_SIZE - write_pos;
+    if (first > samples_written) first = samples_written;
+    audio_block_interleave(left, right, &ring_buffer[write_pos * 2], first);
+    audio_block_interleave(left + first, right + first, &ring_buffer[0], samples_written - first);
 
-        // -32768 ~ 32767 を 0 ~ 255 に変換
-        uint8_t pwm_value = (uint8_t)((sample + 32768) >> (16 - PWM_RESOLUTION_BITS));
+    write_pos = (write_pos + samples_written) % PWM_BUFFER_SIZE;
+    buffered_samples += samples_written;
 
-        ring_buffer[write_pos] = pwm_value;
-        write_pos = (write_pos + 1) % PWM_BUFFER_SIZE;
-        buffered_samples++;
-        samples_written++;
+    // 自動開始: バッファが半分埋まったらDMAを開始
+    if (!is_running && buffered_samples >= PWM_AUTO_START_THRESHOLD) {
+        printf("[PWM] Auto-starting DMA (buffer: %lu/%u samples)\n",
+               buffered_samples, PWM_BUFFER_SIZE);
+        audio_out_pwm_start();
     }
 
     return samples_written;
@@ -184,10 +263,13 @@ void audio_out_pwm_start(void) {
 
     printf("Starting PWM audio output...\n");
 
-    // 最初の DMA バッファを埋める
-    fill_dma_buffer(dma_buffer, PWM_DMA_BUFFER_SIZE);
+    // ピンポンバッファ: 両方のバッファを事前に埋める
+    fill_dma_buffer(dma_buffer[0], PWM_DMA_BUFFER_SIZE);
+    fill_dma_buffer(dma_buffer[1], PWM_DMA_BUFFER_SIZE);
+    current_dma_buffer = 0;
 
-    // DMA を開始
+    // DMA を開始（buffer[0]から）
+    dma_channel_set_read_addr(dma_channel, dma_buffer[0], false);
     dma_channel_start(dma_channel);
 
     // PWM を開始
@@ -227,9 +309,16 @@ void audio_out_pwm_clear_buffer(void) {
     underrun_count = 0;
     overrun_count = 0;
 
-    // 中間値（128）で埋める
-    memset(ring_buffer, 128, sizeof(ring_buffer));
-    memset(dma_buffer, 128, sizeof(dma_buffer));
+    memset(ring_buffer, 0, sizeof(ring_buffer));
+    reset_modulator();
+
+    // 無音（中間レベル）で埋める
+    uint32_t mid = (uint32_t)(pcm_to_level_q16(0) >> 16);
+    uint32_t silence = (mid << 16) | mid;
+    for (uint32_t i = 0; i < PWM_DMA_WORDS; i++) {
+        dma_buffer[0][i] = silence;
+        dma_buffer[1][i] = silence;
+    }
 }
 
 // ============================================================================
@@ -242,22 +331,60 @@ void audio_out_pwm_get_stats(uint32_t *underruns, uint32_t *overruns) {
 }
 
 // ============================================================================
-// DMA バッファを埋める
+// DMA バッファを埋める（Σ-Δ 変調）
 // ============================================================================
 
-static void fill_dma_buffer(uint8_t *buffer, uint32_t num_samples) {
+static void fill_dma_buffer(uint32_t *buffer, uint32_t num_samples) {
+    // I2S とのレート差を1サンプル単位のスリップで吸収
+    bool hold_one = false;
+    if (buffered_samples > PWM_SLIP_HIGH_THRESHOLD) {
+        read_pos = (read_pos + 1) % PWM_BUFFER_SIZE;
+        buffered_samples--;
+    } else if (buffered_samples > 0 && buffered_samples < PWM_SLIP_LOW_THRESHOLD) {
+        hold_one = true;
+    }
+
+    uint32_t w = 0;
     for (uint32_t i = 0; i < num_samples; i++) {
-        if (buffered_samples > 0) {
-            // リングバッファからデータを読み出す
-            buffer[i] = ring_buffer[read_pos];
+        int16_t left = 0;
+        int16_t right = 0;
 
-            read_pos = (read_pos + 1) % PWM_BUFFER_SIZE;
-            buffered_samples--;
+        if (buffered_samples > 0) {
+            left = ring_buffer[read_pos * 2];
+            right = ring_buffer[read_pos * 2 + 1];
+
+            if (hold_one) {
+                // 同じサンプルをもう一度出力（読み取り位置を進めない）
+                hold_one = false;
+            } else {
+                read_pos = (read_pos + 1) % PWM_BUFFER_SIZE;
+                buffered_samples--;
+            }
         } else {
-            // データがない場合は無音（中間値）を出力（アンダーラン）
-            buffer[i] = 128;
+            // データがない場合は無音を出力（アンダーラン）
             underrun_count++;
         }
+
+        // オーバーサンプル間は前サンプルから線形補間（ゼロ次ホールドのイメージを抑える）
+        int32_t x_l = pcm_to_level_q16(left);
+        int32_t x_r = pcm_to_level_q16(right);
+        int32_t step_l = (x_l - sd_state[0].prev) / PWM_OVERSAMPLE;
+        int32_t step_r = (x_r - sd_state[1].prev) / PWM_OVERSAMPLE;
+        int32_t acc_l = sd_state[0].prev;
+        int32_t acc_r = sd_state[1].prev;
+
+        for (uint32_t k = 0; k < PWM_OVERSAMPLE; k++) {
+            acc_l += step_l;
+            acc_r += step_r;
+            uint32_t level_l = sd_modulate(&sd_state[0], acc_l);
+            uint32_t level_r = sd_modulate(&sd_state[1], acc_r);
+
+            // CC レジスタ: 下位16ビット=A（左）、上位16ビット=B（右）
+            buffer[w++] = (level_r << 16) | level_l;
+        }
+
+        sd_state[0].prev = x_l;
+        sd_state[1].prev = x_r;
     }
 }
 
@@ -265,14 +392,16 @@ static void fill_dma_buffer(uint8_t *buffer, uint32_t num_samples) {
 // DMA 割り込みハンドラー
 // ============================================================================
 
+// 割り込みフラグのクリアは dma_irq ディスパッチャーが行う
 static void dma_handler(void) {
-    if (dma_channel_get_irq0_status(dma_channel)) {
-        dma_channel_acknowledge_irq0(dma_channel);
+    // 次のバッファ（すでに埋まっている）でDMAを即座に再開し、
+    // 終わったバッファを次回のために再充填する
+    uint8_t finished_buffer = current_dma_buffer;
+    uint8_t next_buffer = 1 - current_dma_buffer;
 
-        // DMA バッファを再充填
-        fill_dma_buffer(dma_buffer, PWM_DMA_BUFFER_SIZE);
+    dma_channel_set_read_addr(dma_channel, dma_buffer[next_buffer], true);
 
-        // DMA を再起動
-        dma_channel_set_read_addr(dma_channel, dma_buffer, true);
-    }
+    fill_dma_buffer(dma_buffer[finished_buffer], PWM_DMA_BUFFER_SIZE);
+
+    current_dma_buffer = next_buffer;
 }
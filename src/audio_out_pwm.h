@@ -1,6 +1,6 @@
 /**
  * @file audio_out_pwm.h
- * @brief PWM 簡易 DAC オーディオ出力モジュール - ヘッダーファイル
+ * @brief PWM Σ-Δ オーディオ出力モジュール（ステレオ、ヘッドホン/キュー用）- ヘッダーファイル
  */
 
 #ifndef AUDIO_OUT_PWM_H
@@ -18,12 +18,12 @@ bool audio_out_pwm_init(uint32_t sample_rate);
 
 /**
  * @brief PCM データをバッファに書き込む
- * @param pcm_data PCM データ（16bit signed, ステレオの場合は L+R を平均化してモノラルに変換）
- * @param num_samples サンプル数
- * @param channels チャンネル数（1: モノラル, 2: ステレオ）
+ * @param left 左チャンネル（16bit signed, プレーナー）
+ * @param right 右チャンネル（16bit signed, プレーナー）
+ * @param num_samples サンプル数（L/Rペアの数）
  * @return 書き込んだサンプル数
  */
-uint32_t audio_out_pwm_write(const int16_t *pcm_data, uint32_t num_samples, uint8_t channels);
+uint32_t audio_out_pwm_write(const int16_t *left, const int16_t *right, uint32_t num_samples);
 
 /**
  * @brief バッファの空き容量を取得
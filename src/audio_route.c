@@ -0,0 +1,136 @@
+/**
+ * @file audio_route.c
+ * @brief オーディオ出力ルーティング
+ *
+ * 出力ごとに1つのタップポイントを持つルーティング表。
+ * タップは処理チェーンの中で処理順に呼ばれるため、エフェクト前のタップは
+ * エフェクトがデータをその場で書き換える前に出力のリングへ書き込まれる。
+ *
+ * タップより後ろのノードに遅延がある場合（latency.h）、そのタップのデータは
+ * 補償遅延を通してから書き込み、エフェクト後タップと時刻をそろえる。
+ */
+
+#include "audio_route.h"
+#include "config.h"
+#include "latency.h"
+#include "audio_block.h"
+
+#include <stdio.h>
+
+// 遅延補償時に1回に処理するフレーム数（スタック上の作業バッファのサイズ）
+#define ROUTE_CHUNK_FRAMES  128
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+typedef struct {
+    const char *name;
+    audio_route_write_t write;
+    audio_tap_t tap;
+    uint32_t dropped;
+} audio_route_output_t;
+
+static audio_route_output_t outputs[AUDIO_ROUTE_MAX_OUTPUTS];
+static int num_outputs = 0;
+
+static const char *const tap_names[AUDIO_TAP_COUNT + 1] = {
+    "pre-effect",
+    "post-effect",
+    "none",
+};
+
+// ============================================================================
+// 出力の登録・設定
+// ============================================================================
+
+int audio_route_add_output(const char *name, audio_route_write_t write, audio_tap_t tap) {
+    if (!write || num_outputs >= AUDIO_ROUTE_MAX_OUTPUTS) {
+        printf("ERROR: Cannot register audio output '%s'\n", name ? name : "?");
+        return -1;
+    }
+    if (tap > AUDIO_TAP_NONE) tap = AUDIO_TAP_NONE;
+
+    int id = num_outputs++;
+    outputs[id].name = name;
+    outputs[id].write = write;
+    outputs[id].tap = tap;
+    outputs[id].dropped = 0;
+
+    printf("[ROUTE] Output #%d '%s' <- %s\n", id, name, tap_names[tap]);
+
+    return id;
+}
+
+void audio_route_set_tap(int output_id, audio_tap_t tap) {
+    if (output_id < 0 || output_id >= num_outputs) return;
+    if (tap > AUDIO_TAP_NONE) tap = AUDIO_TAP_NONE;
+
+    outputs[output_id].tap = tap;
+    printf("[ROUTE] Output #%d '%s' <- %s\n",
+           output_id, outputs[output_id].name, tap_names[tap]);
+}
+
+audio_tap_t audio_route_get_tap(int output_id) {
+    if (output_id < 0 || output_id >= num_outputs) return AUDIO_TAP_NONE;
+    return outputs[output_id].tap;
+}
+
+// ============================================================================
+// タップ処理
+// ============================================================================
+
+/**
+ * @brief タップに接続されている全出力に書き込む
+ */
+static uint32_t write_outputs(audio_tap_t tap, const int16_t *left, const int16_t *right,
+                              uint32_t num_samples) {
+    uint32_t dropped_total = 0;
+
+    for (int i = 0; i < num_outputs; i++) {
+        audio_route_output_t *out = &outputs[i];
+        if (out->tap != tap) continue;
+
+        uint32_t written = out->write(left, right, num_samples);
+        if (written < num_samples) {
+            uint32_t dropped = num_samples - written;
+            out->dropped += dropped;
+            dropped_total += dropped;
+        }
+    }
+
+    return dropped_total;
+}
+
+uint32_t audio_route_process(audio_tap_t tap, const int16_t *left, const int16_t *right,
+                             uint32_t num_samples) {
+    bool connected = false;
+    for (int i = 0; i < num_outputs; i++) {
+        connected |= (outputs[i].tap == tap);
+    }
+    if (!connected) return 0;
+
+    if (latency_get_compensation(tap) == 0) {
+        return write_outputs(tap, left, right, num_samples);
+    }
+
+    // 遅延補償: 遅延線を通したデータを全出力で共有する
+    int16_t delayed_l[ROUTE_CHUNK_FRAMES] AUDIO_ALIGNED;
+    int16_t delayed_r[ROUTE_CHUNK_FRAMES] AUDIO_ALIGNED;
+    uint32_t dropped_total = 0;
+
+    for (uint32_t offset = 0; offset < num_samples; offset += ROUTE_CHUNK_FRAMES) {
+        uint32_t n = num_samples - offset;
+        if (n > ROUTE_CHUNK_FRAMES) n = ROUTE_CHUNK_FRAMES;
+
+        latency_compensate_tap(tap, left + offset, right + offset, delayed_l, delayed_r, n);
+        dropped_total += write_outputs(tap, delayed_l, delayed_r, n);
+    }
+
+    return dropped_total;
+}
+
+uint32_t audio_route_get_dropped(int output_id) {
+    if (output_id < 0 || output_id >= num_outputs) return 0;
+    return outputs[output_id].dropped;
+}
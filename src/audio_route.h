@@ -0,0 +1,80 @@
+/**
+ * @file audio_route.h
+ * @brief オーディオ出力ルーティング - ヘッダーファイル
+ *
+ * 処理チェーン上のタップポイント（エフェクト前/後）と出力モジュールを結ぶ。
+ * 各出力はどれか1つのタップに接続され、タップのバッファから自分の
+ * リングバッファへ直接書き込む（中間バッファへのコピーは行わない）。
+ */
+
+#ifndef AUDIO_ROUTE_H
+#define AUDIO_ROUTE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 登録できる出力の最大数
+#define AUDIO_ROUTE_MAX_OUTPUTS  4
+
+/**
+ * @brief 処理チェーン上のタップポイント
+ */
+typedef enum {
+    AUDIO_TAP_PRE_EFFECT = 0,   // ボリューム適用後、エフェクト前（キュー/ドライ）
+    AUDIO_TAP_POST_EFFECT,      // エフェクト後（メインミックス）
+    AUDIO_TAP_COUNT,
+    AUDIO_TAP_NONE = AUDIO_TAP_COUNT,  // どのタップにも接続しない（ミュート）
+} audio_tap_t;
+
+/**
+ * @brief 出力モジュールの書き込み関数の型定義
+ * @param left 左チャンネル（16bit signed, プレーナー）
+ * @param right 右チャンネル（16bit signed, プレーナー）
+ * @param num_samples サンプル数（L/Rペアの数）
+ * @return 書き込んだサンプル数
+ */
+typedef uint32_t (*audio_route_write_t)(const int16_t *left, const int16_t *right,
+                                        uint32_t num_samples);
+
+/**
+ * @brief 出力を登録
+ * @param name 出力名（ログ用）
+ * @param write 書き込み関数
+ * @param tap 接続するタップポイント
+ * @return 出力ID（0以上）, 失敗時は -1
+ */
+int audio_route_add_output(const char *name, audio_route_write_t write, audio_tap_t tap);
+
+/**
+ * @brief 出力の接続先タップを変更
+ * @param output_id 出力ID
+ * @param tap 接続するタップポイント（AUDIO_TAP_NONE でミュート）
+ */
+void audio_route_set_tap(int output_id, audio_tap_t tap);
+
+/**
+ * @brief 出力の接続先タップを取得
+ * @param output_id 出力ID
+ * @return タップポイント
+ */
+audio_tap_t audio_route_get_tap(int output_id);
+
+/**
+ * @brief タップポイントのデータを接続されている全出力に渡す
+ * @param tap タップポイント
+ * @param left 左チャンネル（16bit signed, プレーナー）
+ * @param right 右チャンネル（16bit signed, プレーナー）
+ * @param num_samples サンプル数（L/Rペアの数）
+ * @return このタップで書き込めなかったサンプル数の合計
+ */
+uint32_t audio_route_process(audio_tap_t tap, const int16_t *left, const int16_t *right,
+                             uint32_t num_samples);
+
+/**
+ * @brief 出力ごとのドロップ数を取得（デバッグ用）
+ * @param output_id 出力ID
+ * @return ドロップしたサンプル数の累計
+ */
+uint32_t audio_route_get_dropped(int output_id);
+
+#endif // AUDIO_ROUTE_H
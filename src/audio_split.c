@@ -0,0 +1,131 @@
+/**
+ * @file audio_split.c
+ * @brief 4チャンネル I2S 出力用の振り分けノード
+ *
+ * クロスオーバーは1次ローパスを2段重ねた低域と、入力から低域を引いた高域の
+ * 相補型。高域 + 低域 は入力と完全に一致するので、2組の DAC の出力を
+ * 足し合わせるとフラットになる。1フレームあたり乗算2回（チャンネルごと）。
+ */
+
+#include "audio_split.h"
+#include "audio_out_i2s.h"
+#include "audio_block.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <math.h>
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+// 1回に処理するフレーム数（スタック上の作業バッファのサイズ）
+#define SPLIT_CHUNK_FRAMES  128
+
+// フィルタ係数と状態の小数ビット数
+#define SPLIT_COEFF_BITS    15
+#define SPLIT_STATE_BITS    15
+
+#define SAMPLE_MAX          32767
+#define SAMPLE_MIN          -32768
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// 1次ローパス係数（Q15）: a = 1 - exp(-2π·fc/fs)
+static int32_t lpf_coeff = 0;
+
+// チャンネルごとの2段ローパス状態（Q15拡張、[ch][段]）
+static int32_t lpf_state[2][2];
+
+// ============================================================================
+// 初期化
+// ============================================================================
+
+void audio_split_init(uint32_t sample_rate, uint32_t crossover_hz) {
+    float a = 1.0f - expf(-2.0f * 3.14159265f * (float)crossover_hz / (float)sample_rate);
+    lpf_coeff = (int32_t)(a * (float)(1 << SPLIT_COEFF_BITS) + 0.5f);
+
+    audio_split_reset();
+
+    printf("[SPLIT] Crossover: %lu Hz (coeff %ld/32768)\n",
+           (unsigned long)crossover_hz, (long)lpf_coeff);
+}
+
+void audio_split_reset(void) {
+    for (int ch = 0; ch < 2; ch++) {
+        lpf_state[ch][0] = 0;
+        lpf_state[ch][1] = 0;
+    }
+}
+
+// ============================================================================
+// ドライ/ウェット
+// ============================================================================
+
+uint32_t audio_split_write_dry(const int16_t *left, const int16_t *right, uint32_t num_samples) {
+    return audio_out_i2s_write_pair(0, left, right, num_samples);
+}
+
+uint32_t audio_split_write_wet(const int16_t *left, const int16_t *right, uint32_t num_samples) {
+    return audio_out_i2s_write_pair(1, left, right, num_samples);
+}
+
+// ============================================================================
+// クロスオーバー
+// ============================================================================
+
+static inline int32_t one_pole(int32_t *state, int32_t x_q) {
+    *state += (int32_t)(((int64_t)(x_q - *state) * lpf_coeff) >> SPLIT_COEFF_BITS);
+    return *state;
+}
+
+static inline int16_t clip16(int32_t v) {
+    if (v > SAMPLE_MAX) return SAMPLE_MAX;
+    if (v < SAMPLE_MIN) return SAMPLE_MIN;
+    return (int16_t)v;
+}
+
+/**
+ * @brief 1チャンネル分を帯域分割
+ */
+static void split_channel(int32_t *st, const int16_t *in, int16_t *high, int16_t *low, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t x = in[i];
+        int32_t x_q = x << SPLIT_STATE_BITS;
+
+        // 低域 = 1次ローパス × 2段（-12dB/oct）
+        int32_t lp = one_pole(&st[1], one_pole(&st[0], x_q)) >> SPLIT_STATE_BITS;
+
+        // 高域 = 入力 - 低域（相補型、和は入力と一致）
+        low[i] = clip16(lp);
+        high[i] = clip16(x - lp);
+    }
+}
+
+uint32_t audio_split_write_crossover(const int16_t *left, const int16_t *right,
+                                     uint32_t num_samples) {
+    int16_t high_l[SPLIT_CHUNK_FRAMES] AUDIO_ALIGNED;
+    int16_t high_r[SPLIT_CHUNK_FRAMES] AUDIO_ALIGNED;
+    int16_t low_l[SPLIT_CHUNK_FRAMES] AUDIO_ALIGNED;
+    int16_t low_r[SPLIT_CHUNK_FRAMES] AUDIO_ALIGNED;
+    uint32_t written = 0;
+
+    while (written < num_samples) {
+        uint32_t n = num_samples - written;
+        if (n > SPLIT_CHUNK_FRAMES) n = SPLIT_CHUNK_FRAMES;
+
+        split_channel(lpf_state[0], &left[written], high_l, low_l, n);
+        split_channel(lpf_state[1], &right[written], high_r, low_r, n);
+
+        // ペアAを仮置きしてからペアBで確定
+        audio_out_i2s_write_pair(0, high_l, high_r, n);
+        uint32_t w = audio_out_i2s_write_pair(1, low_l, low_r, n);
+        written += w;
+
+        if (w < n) break;  // バッファがいっぱい
+    }
+
+    return written;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file audio_split.h
+ * @brief 4チャンネル I2S 出力用の振り分けノード - ヘッダーファイル
+ *
+ * ルーティング（audio_route）の出力として登録し、ステレオのタップ信号を
+ * I2S の2組のステレオペアへ振り分ける。
+ *   - ドライ/ウェット: エフェクト前タップ → ペアA、エフェクト後タップ → ペアB
+ *   - クロスオーバー: エフェクト後タップを高域 → ペアA、低域 → ペアB に分割
+ */
+
+#ifndef AUDIO_SPLIT_H
+#define AUDIO_SPLIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 振り分けノードを初期化
+ * @param sample_rate サンプリングレート（Hz）
+ * @param crossover_hz クロスオーバー周波数（Hz）
+ */
+void audio_split_init(uint32_t sample_rate, uint32_t crossover_hz);
+
+/**
+ * @brief ドライ信号をペアAに書き込む（エフェクト前タップに接続）
+ * @return 書き込んだサンプル数
+ */
+uint32_t audio_split_write_dry(const int16_t *left, const int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief ウェット信号をペアBに書き込む（エフェクト後タップに接続）
+ * @return 書き込んだサンプル数
+ */
+uint32_t audio_split_write_wet(const int16_t *left, const int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief 帯域分割して高域をペアA、低域をペアBに書き込む
+ * @return 書き込んだサンプル数
+ */
+uint32_t audio_split_write_crossover(const int16_t *left, const int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief クロスオーバーのフィルタ状態をリセット
+ */
+void audio_split_reset(void);
+
+#endif // AUDIO_SPLIT_H
@@ -0,0 +1,78 @@
+/**
+ * @file beat_clock.c
+ * @brief オーディオサンプル基準のビートクロックの実装
+ *
+ * 1フレームあたりの拍位置の増分を 0.32 固定小数点で持つので、
+ * 何分再生しても累積誤差は増分の丸め（1フレームあたり 2^-32 拍未満）だけになる。
+ */
+
+#include "beat_clock.h"
+#include "config.h"
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static uint32_t sample_rate = AUDIO_SAMPLE_RATE;
+static float base_bpm = 120.0f;       // 原速のテンポ
+static float speed = 1.0f;            // 再生速度（バリスピード）
+static uint64_t position_q32 = 0;     // ブロック先頭の拍位置
+static uint32_t increment_q32 = 0;    // 1フレームあたりの拍数（0.32 固定小数点）
+
+// ============================================================================
+// 内部関数
+// ============================================================================
+
+static void update_increment(void) {
+    // 拍/フレーム = BPM / 60 / サンプルレート（1未満なので下位32ビットに収まる）
+    double bpm = (double)base_bpm * (double)speed;
+    increment_q32 = (uint32_t)(bpm / 60.0 / (double)sample_rate * 4294967296.0 + 0.5);
+}
+
+// ============================================================================
+// 初期化・設定
+// ============================================================================
+
+void beat_clock_init(uint32_t sr) {
+    sample_rate = sr;
+    position_q32 = 0;
+    speed = 1.0f;
+    beat_clock_set_bpm(120.0f);
+}
+
+void beat_clock_set_bpm(float bpm) {
+    if (bpm <= 0.0f) return;
+
+    base_bpm = bpm / speed;
+    update_increment();
+}
+
+float beat_clock_get_bpm(void) {
+    return base_bpm * speed;
+}
+
+void beat_clock_set_speed(float s) {
+    if (s <= 0.0f) return;
+
+    speed = s;
+    update_increment();
+}
+
+void beat_clock_sync(void) {
+    // 拍の途中なら次の拍番号の頭へ
+    if ((uint32_t)position_q32 != 0) {
+        position_q32 = ((position_q32 >> 32) + 1) << 32;
+    }
+}
+
+// ============================================================================
+// 拍位置
+// ============================================================================
+
+void beat_clock_advance(uint32_t frames) {
+    position_q32 += (uint64_t)increment_q32 * frames;
+}
+
+uint64_t beat_clock_get_position_at(uint32_t frame_offset) {
+    return position_q32 + (uint64_t)increment_q32 * frame_offset;
+}
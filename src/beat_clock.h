@@ -0,0 +1,60 @@
+/**
+ * @file beat_clock.h
+ * @brief オーディオサンプル基準のビートクロック - ヘッダーファイル
+ *
+ * 処理したフレーム数から拍位置を 32.32 固定小数点（上位 = 拍番号、下位 = 拍内の位相）で数える。
+ * テンポはタップテンポから設定し、タップ時に拍頭へ合わせ直す。
+ * モジュレーション（LFO）などのテンポ同期はすべてこの拍位置を基準にする。
+ *
+ * バリスピード中は拍位置を出力のフレームで数えるので、テンポは「原速のテンポ × 速度」になる。
+ * BPM の設定・取得はどちらも出力（聞こえている）のテンポ。
+ */
+
+#ifndef BEAT_CLOCK_H
+#define BEAT_CLOCK_H
+
+#include <stdint.h>
+
+/**
+ * @brief ビートクロックの初期化（120 BPM、拍位置 0）
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void beat_clock_init(uint32_t sample_rate);
+
+/**
+ * @brief テンポを設定（拍位置はそのまま）
+ * @param bpm 出力のテンポ（BPM、原速のテンポは bpm / 速度）
+ */
+void beat_clock_set_bpm(float bpm);
+
+/**
+ * @brief 現在のテンポを取得
+ * @return 出力のテンポ（BPM）
+ */
+float beat_clock_get_bpm(void);
+
+/**
+ * @brief 再生速度を設定（バリスピード、原速のテンポはそのまま）
+ * @param speed 速度（1.0 = 原速）
+ */
+void beat_clock_set_speed(float speed);
+
+/**
+ * @brief 拍頭に合わせ直す（次の拍の位相 0 から数え直す）
+ */
+void beat_clock_sync(void);
+
+/**
+ * @brief 処理したフレーム数だけ拍位置を進める（オーディオブロックごとに1回）
+ * @param frames ステレオペア数
+ */
+void beat_clock_advance(uint32_t frames);
+
+/**
+ * @brief 現在のブロック先頭から frame_offset フレーム後の拍位置
+ * @param frame_offset ブロック先頭からのフレーム数
+ * @return uint64_t 拍位置（32.32 固定小数点）
+ */
+uint64_t beat_clock_get_position_at(uint32_t frame_offset);
+
+#endif // BEAT_CLOCK_H
@@ -6,6 +6,18 @@
 #include "bt_audio.h"
 #include "config.h"
 #include "audio_effect.h"
+#include "audio_route.h"
+#include "loudness.h"
+#include "compressor.h"
+#include "audio_block.h"
+#include "beat_clock.h"
+#include "looper.h"
+#include "sampler.h"
+#include "latency.h"
+#include "link_monitor.h"
+#include "trace.h"
+#include "varispeed.h"
+#include "trance_gate.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -24,6 +36,28 @@ static pcm_data_callback_t pcm_callback = NULL;
 static bool is_connected = false;
 static uint32_t current_sample_rate = AUDIO_SAMPLE_RATE;
 
+#if COMPRESSOR_BUS_ENABLED
+// エフェクト後のバスコンプレッサー
+static compressor_t bus_comp;
+#if COMPRESSOR_BUS_LOOKAHEAD_FRAMES > 0
+static latency_delay_t bus_lookahead;
+static bool bus_lookahead_ready = false;
+#endif
+#endif
+
+// デコード済みPCMのバッチバッファ（1メディアパケット分のSBCフレームをまとめる）
+// 処理チェーン内部はプレーナー形式（SBC 入力時にデインターリーブ）
+static int16_t pcm_batch_l[PCM_BATCH_MAX_FRAMES] AUDIO_ALIGNED;
+static int16_t pcm_batch_r[PCM_BATCH_MAX_FRAMES] AUDIO_ALIGNED;
+static uint32_t pcm_batch_frames = 0;
+static int pcm_batch_sample_rate = AUDIO_SAMPLE_RATE;
+
+#if VARISPEED_ENABLED
+// バリスピードの出力（遅くすると入力より長くなる）
+static int16_t varispeed_out_l[VARISPEED_MAX_OUTPUT(PCM_BATCH_MAX_FRAMES)] AUDIO_ALIGNED;
+static int16_t varispeed_out_r[VARISPEED_MAX_OUTPUT(PCM_BATCH_MAX_FRAMES)] AUDIO_ALIGNED;
+#endif
+
 // A2DP SBC デコーダー
 static btstack_sbc_decoder_state_t sbc_decoder_state;
 static btstack_sbc_mode_t sbc_mode = SBC_MODE_STANDARD;
@@ -43,6 +77,13 @@ static uint8_t media_sbc_codec_configuration[4];
 static uint8_t sdp_avdtp_sink_service_buffer[SDP_AVDTP_SINK_BUFFER_SIZE];
 static uint16_t a2dp_cid = 0;
 static uint8_t local_seid = 1;
+static hci_con_handle_t a2dp_con_handle = HCI_CON_HANDLE_INVALID;
+
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+// リンク品質の監視
+static uint32_t packet_frames = 0;       // 受信中のメディアパケットをデコードしたフレーム数
+static uint32_t last_rssi_poll_ms = 0;
+#endif
 
 // ============================================================================
 // イベントハンドラー（前方宣言）
@@ -107,14 +148,88 @@ bool bt_audio_init(void) {
     local_seid = avdtp_local_seid(local_stream_endpoint);
     printf("A2DP stream endpoint created (SEID: %d)\n", local_seid);
 
+#if DELAY_REPORT_ENABLED
+    // 遅延レポートに対応していることを capabilities で通知
+    avdtp_sink_register_delay_reporting_category(local_seid);
+#endif
+
     // SBC デコーダーの初期化
     btstack_sbc_decoder_init(&sbc_decoder_state, sbc_mode, &handle_pcm_data, NULL);
 
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    // リンク品質の監視（目標バッファ深さの制御）
+    link_monitor_init(AUDIO_SAMPLE_RATE);
+#endif
+
+    // レイテンシー管理（遅延を持つノードは初期化時に申告する）
+    latency_init();
+
+    // ビートクロック（テンポ同期モジュレーションの基準）
+    beat_clock_init(AUDIO_SAMPLE_RATE);
+
     // オーディオエフェクトの初期化
     if (!audio_effect_init(AUDIO_SAMPLE_RATE)) {
         printf("WARNING: Failed to initialize audio effect\n");
     }
 
+#if LOOPER_ENABLED
+    // ルーパーの初期化
+    if (!looper_init(AUDIO_SAMPLE_RATE)) {
+        printf("WARNING: Failed to initialize looper\n");
+    }
+    // 圧縮メモリは Beat-Repeat のスライスバッファを無効な間だけ借りる
+    looper_set_memory(audio_effect_get_slice_memory_bytes(),
+                      audio_effect_lend_slice_memory, audio_effect_return_slice_memory);
+#endif
+
+#if SAMPLER_ENABLED
+    // サンプルプレーヤーの初期化（先読み用 DMA チャンネルを確保）
+    if (!sampler_init()) {
+        printf("WARNING: Failed to initialize sampler\n");
+    }
+#endif
+
+#if COMPRESSOR_BUS_ENABLED
+    // バスコンプレッサーの初期化
+    compressor_params_t bus_params = {
+        .threshold_db = COMPRESSOR_BUS_THRESHOLD_DB,
+        .ratio = COMPRESSOR_BUS_RATIO,
+        .knee_db = COMPRESSOR_BUS_KNEE_DB,
+        .attack_ms = COMPRESSOR_BUS_ATTACK_MS,
+        .release_ms = COMPRESSOR_BUS_RELEASE_MS,
+        .makeup_db = COMPRESSOR_BUS_MAKEUP_DB,
+    };
+    compressor_init(&bus_comp, &bus_params, AUDIO_SAMPLE_RATE);
+
+#if COMPRESSOR_BUS_LOOKAHEAD_FRAMES > 0
+    // 先読みの遅延を申告し、ドライのタップを同じだけ遅らせる
+    if (latency_delay_alloc(&bus_lookahead, COMPRESSOR_BUS_LOOKAHEAD_FRAMES)) {
+        latency_delay_set(&bus_lookahead, COMPRESSOR_BUS_LOOKAHEAD_FRAMES);
+        latency_declare(LATENCY_NODE_BUS_COMPRESSOR, COMPRESSOR_BUS_LOOKAHEAD_FRAMES);
+        bus_lookahead_ready = true;
+    }
+#endif
+#endif
+
+#if LOUDNESS_METER_ENABLED
+    // ラウドネスメーターの初期化
+    if (!loudness_init(AUDIO_SAMPLE_RATE)) {
+        printf("WARNING: Failed to initialize loudness meter\n");
+    }
+#endif
+
+#if TRANCE_GATE_ENABLED
+    // トランスゲートの初期化（ランプのテーブルと既定のパターン）
+    trance_gate_init();
+#endif
+
+#if VARISPEED_ENABLED
+    // バリスピードの初期化（係数表を作り、リサンプラーの遅延を申告）
+    if (!varispeed_init(AUDIO_SAMPLE_RATE)) {
+        printf("WARNING: Failed to initialize varispeed\n");
+    }
+#endif
+
     // GAP（Generic Access Profile）の設定
     gap_discoverable_control(1);
     gap_set_class_of_device(BT_DEVICE_CLASS);
@@ -147,6 +262,16 @@ void bt_audio_run(void) {
     // 非同期コンテキストのポーリング（BTstackイベント処理）
     // これがないとメディアパケットが処理されない！
     async_context_poll(cyw43_arch_async_context());
+
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    // RSSI を定期的に読む（結果は GAP_EVENT_RSSI_MEASUREMENT で届く）
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    if (is_connected && a2dp_con_handle != HCI_CON_HANDLE_INVALID &&
+        (now_ms - last_rssi_poll_ms) >= LINK_RSSI_INTERVAL_MS) {
+        last_rssi_poll_ms = now_ms;
+        gap_read_rssi(a2dp_con_handle);
+    }
+#endif
 }
 
 // ============================================================================
@@ -165,6 +290,22 @@ uint32_t bt_audio_get_sample_rate(void) {
     return current_sample_rate;
 }
 
+// ============================================================================
+// 遅延レポート
+// ============================================================================
+
+bool bt_audio_send_delay_report(uint16_t delay_100us) {
+    if (!is_connected || a2dp_cid == 0) {
+        return false;
+    }
+    uint8_t status = a2dp_sink_send_delay_report(a2dp_cid, local_seid, delay_100us);
+    if (status != ERROR_CODE_SUCCESS) {
+        printf("WARNING: Delay report failed (status 0x%02x)\n", status);
+        return false;
+    }
+    return true;
+}
+
 // ============================================================================
 // PCM コールバックの設定
 // ============================================================================
@@ -173,6 +314,96 @@ void bt_audio_set_pcm_callback(pcm_data_callback_t callback) {
     pcm_callback = callback;
 }
 
+// ============================================================================
+// PCM ブロック処理（ボリューム → ラウドネス → エフェクト → 出力）
+// ============================================================================
+
+static void process_pcm_block(int16_t *left, int16_t *right, uint32_t num_samples, int sample_rate) {
+    // ソフトウェアボリューム調整（クリッピング防止）
+    #if SOFTWARE_VOLUME_PERCENT < 100
+    for (uint32_t i = 0; i < num_samples; i++) {
+        // 音量を調整（オーバーフロー防止のため32ビットで計算）
+        left[i] = (int16_t)(((int32_t)left[i] * SOFTWARE_VOLUME_PERCENT) / 100);
+        right[i] = (int16_t)(((int32_t)right[i] * SOFTWARE_VOLUME_PERCENT) / 100);
+    }
+    #endif
+
+    // ラウドネス計測と AGC（エフェクト前の信号レベルを揃える）
+    #if LOUDNESS_METER_ENABLED
+    loudness_process(left, right, num_samples);
+    #endif
+
+    // エフェクト前タップ（キュー出力など）
+    // エフェクトはデータをその場で書き換えるので、その前に各出力のリングへ書き込む
+    audio_route_process(AUDIO_TAP_PRE_EFFECT, left, right, num_samples);
+
+    // オーディオエフェクト適用（Beat-Repeat）
+    TRACE_BEGIN(TRACE_EV_EFFECT, num_samples);
+    audio_effect_process(left, right, num_samples);
+    TRACE_END(TRACE_EV_EFFECT, num_samples);
+
+    // トランスゲート（エフェクト後の音をステップで刻む）
+    #if TRANCE_GATE_ENABLED
+    trance_gate_process(left, right, num_samples);
+    #endif
+
+    // ルーパー（エフェクト後の音を録音し、ループを重ねる）
+    #if LOOPER_ENABLED
+    looper_process(left, right, num_samples);
+    #endif
+
+    // ワンショットサンプル（エフェクトやルーパーに掛けずに重ねる）
+    #if SAMPLER_ENABLED
+    sampler_process(left, right, num_samples);
+    #endif
+
+    // バスコンプレッサー（ドライとウェットが重なったピークを抑える）
+    #if COMPRESSOR_BUS_ENABLED
+    #if COMPRESSOR_BUS_LOOKAHEAD_FRAMES > 0
+    if (bus_lookahead_ready) {
+        compressor_process_lookahead(&bus_comp, &bus_lookahead, left, right, num_samples);
+    } else {
+        compressor_process(&bus_comp, left, right, num_samples);
+    }
+    #else
+    compressor_process(&bus_comp, left, right, num_samples);
+    #endif
+    #endif
+
+    // 拍位置を進める（エフェクトはブロック先頭の拍位置を基準に評価済み）
+    beat_clock_advance(num_samples);
+
+    // PCMコールバックに渡す（num_samples はステレオペア数）
+    if (pcm_callback) {
+        pcm_callback(left, right, num_samples, (uint32_t)sample_rate);
+    }
+}
+
+// ============================================================================
+// PCM バッチ処理
+// ============================================================================
+
+/**
+ * @brief バッチに溜まったPCMをまとめて処理
+ */
+static void flush_pcm_batch(void) {
+    if (pcm_batch_frames == 0) {
+        return;
+    }
+
+#if VARISPEED_ENABLED
+    // ストリーム全体の速度を変えてから処理チェーンへ
+    uint32_t frames = varispeed_process(pcm_batch_l, pcm_batch_r, pcm_batch_frames,
+                                        varispeed_out_l, varispeed_out_r);
+    if (frames > 0) {
+        process_pcm_block(varispeed_out_l, varispeed_out_r, frames, pcm_batch_sample_rate);
+    }
+#else
+    process_pcm_block(pcm_batch_l, pcm_batch_r, pcm_batch_frames, pcm_batch_sample_rate);
+#endif
+    pcm_batch_frames = 0;
+}
+
 // ============================================================================
 // PCM データハンドラー（SBC デコーダーから呼ばれる）
 // ============================================================================
@@ -183,6 +414,10 @@ static void handle_pcm_data(int16_t *data, int num_samples, int num_channels, in
     static uint32_t pcm_callback_count = 0;
     pcm_callback_count++;
 
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    packet_frames += (uint32_t)num_samples;
+#endif
+
     // 最初の数回だけログ出力（デバッグ用）
     if (pcm_callback_count <= INITIAL_PCM_LOG_COUNT) {
         printf("[PCM] Received: %d samples, %d ch, %d Hz\n", num_samples, num_channels, sample_rate);
@@ -194,30 +429,34 @@ static void handle_pcm_data(int16_t *data, int num_samples, int num_channels, in
         printf("Sample rate: %lu Hz\n", current_sample_rate);
     }
 
-    // ソフトウェアボリューム調整（クリッピング防止）
-    #if SOFTWARE_VOLUME_PERCENT < 100
-    {
-        // num_samples はステレオペア数なので、実際のサンプル数は num_samples * num_channels
-        int total_samples = num_samples * num_channels;
-        for (int i = 0; i < total_samples; i++) {
-            // 音量を調整（オーバーフロー防止のため32ビットで計算）
-            int32_t sample = data[i];
-            sample = (sample * SOFTWARE_VOLUME_PERCENT) / 100;
-            data[i] = (int16_t)sample;
-        }
+    // サンプルレートが変わったら、それまでの分を先に処理
+    if (sample_rate != pcm_batch_sample_rate) {
+        flush_pcm_batch();
+        pcm_batch_sample_rate = sample_rate;
     }
-    #endif
 
-    // オーディオエフェクト適用（Beat-Repeat）
-    audio_effect_process(data, (uint32_t)num_samples, (uint8_t)num_channels);
+    // バッチバッファにデインターリーブして追記（この時点では処理しない）
+    // 処理はメディアパケットのデコード完了時、またはバッファが満杯になった時
+    uint32_t remaining = (uint32_t)num_samples;
+    while (remaining > 0) {
+        uint32_t space = PCM_BATCH_MAX_FRAMES - pcm_batch_frames;
+        uint32_t chunk = (remaining < space) ? remaining : space;
+
+        if (num_channels == 2) {
+            audio_block_deinterleave(data, &pcm_batch_l[pcm_batch_frames],
+                                     &pcm_batch_r[pcm_batch_frames], chunk);
+        } else {
+            // モノラルは左右に複製
+            audio_block_mono_to_planar(data, &pcm_batch_l[pcm_batch_frames],
+                                       &pcm_batch_r[pcm_batch_frames], chunk);
+        }
+        pcm_batch_frames += chunk;
+        data += chunk * num_channels;
+        remaining -= chunk;
 
-    // PCMコールバックに渡す
-    // 重要: BTstackのSBCデコーダーは num_samples を「ステレオペア数」として渡す
-    // つまり num_samples=128 は 128ステレオペア = 256個のint16_t (左128+右128)
-    // audio_out_i2s_write()も「ステレオペア数」を期待しているので、そのまま渡す
-    if (pcm_callback) {
-        // 2で割らない！そのまま渡す
-        pcm_callback(data, (uint32_t)num_samples, (uint8_t)num_channels, (uint32_t)sample_rate);
+        if (pcm_batch_frames >= PCM_BATCH_MAX_FRAMES) {
+            flush_pcm_batch();
+        }
     }
 }
 
@@ -249,6 +488,7 @@ static void a2dp_sink_packet_handler(uint8_t packet_type, uint16_t channel, uint
                     }
 
                     a2dp_cid = cid;
+                    a2dp_con_handle = a2dp_subevent_signaling_connection_established_get_con_handle(packet);
                     printf("A2DP connection established: %s (CID: 0x%04x)\n",
                            bd_addr_to_str(address), cid);
                     break;
@@ -256,6 +496,7 @@ static void a2dp_sink_packet_handler(uint8_t packet_type, uint16_t channel, uint
                 case A2DP_SUBEVENT_SIGNALING_CONNECTION_RELEASED:
                     printf("A2DP connection released\n");
                     a2dp_cid = 0;
+                    a2dp_con_handle = HCI_CON_HANDLE_INVALID;
                     is_connected = false;
                     break;
 
@@ -275,6 +516,10 @@ static void a2dp_sink_packet_handler(uint8_t packet_type, uint16_t channel, uint
 
                 case A2DP_SUBEVENT_STREAM_STARTED:
                     printf("Stream started - Audio playback begins\n");
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+                    // 停止中の間隔をギャップと数えないよう、到着の基準からやり直す
+                    link_monitor_reset(current_sample_rate);
+#endif
                     break;
 
                 case A2DP_SUBEVENT_STREAM_SUSPENDED:
@@ -339,6 +584,19 @@ static void packet_handler(uint8_t packet_type, uint16_t channel, uint8_t *packe
             break;
         }
 
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+        case GAP_EVENT_RSSI_MEASUREMENT:
+            link_monitor_on_rssi(gap_event_rssi_measurement_get_rssi(packet));
+            break;
+
+        // コントローラーが受信を取りこぼした / 帯域を保てなかった
+        case HCI_EVENT_QOS_VIOLATION:
+        case HCI_EVENT_FLUSH_OCCURRED:
+        case HCI_EVENT_DATA_BUFFER_OVERFLOW:
+            link_monitor_on_flow_event(time_us_32());
+            break;
+#endif
+
         default:
             break;
     }
@@ -378,8 +636,25 @@ static void a2dp_sink_media_packet_handler(uint8_t seid, uint8_t *packet, uint16
         return;
     }
 
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    uint32_t arrival_us = time_us_32();
+    packet_frames = 0;
+#endif
+
+    TRACE_INSTANT(TRACE_EV_MEDIA_PACKET, size - SBC_MEDIA_PACKET_HEADER_OFFSET);
+
     // SBCデコーダーにデータを渡す（ヘッダー13バイトをスキップ）
+    TRACE_BEGIN(TRACE_EV_DECODE, 0);
     btstack_sbc_decoder_process_data(&sbc_decoder_state, 0,
                                       packet + SBC_MEDIA_PACKET_HEADER_OFFSET,
                                       size - SBC_MEDIA_PACKET_HEADER_OFFSET);
+    TRACE_END(TRACE_EV_DECODE, pcm_batch_frames);
+
+    // パケット内の全SBCフレームを1ブロックとして処理
+    flush_pcm_batch();
+
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    // 到着間隔とパケットの再生時間からリンク品質を見る
+    link_monitor_on_packet(arrival_us, packet_frames);
+#endif
 }
@@ -33,15 +33,25 @@ bool bt_audio_is_connected(void);
  */
 uint32_t bt_audio_get_sample_rate(void);
 
+/**
+ * @brief ソースに遅延を報告（AVDTP Delay Report）
+ * @param delay_100us 遅延（1/10 ms 単位）
+ * @return true 送信した, false 未接続または送信失敗
+ */
+bool bt_audio_send_delay_report(uint16_t delay_100us);
+
 /**
  * @brief PCM データコールバック関数の型定義
- * @param pcm_data PCM データ（16bit signed, インターリーブ形式）
- * @param num_samples サンプル数（ステレオの場合、L/Rペアの数）
- * @param channels チャンネル数（1: モノラル, 2: ステレオ）
+ *
+ * モノラルのストリームは SBC 入力時に左右へ複製されるので、常にステレオで渡される。
+ *
+ * @param left 左チャンネル（16bit signed, プレーナー）
+ * @param right 右チャンネル（16bit signed, プレーナー）
+ * @param num_samples サンプル数（L/Rペアの数）
  * @param sample_rate サンプリングレート（Hz）
  */
-typedef void (*pcm_data_callback_t)(const int16_t *pcm_data, uint32_t num_samples,
-                                     uint8_t channels, uint32_t sample_rate);
+typedef void (*pcm_data_callback_t)(const int16_t *left, const int16_t *right,
+                                     uint32_t num_samples, uint32_t sample_rate);
 
 /**
  * @brief PCM データコールバックを設定
@@ -0,0 +1,223 @@
+/**
+ * @file compressor.c
+ * @brief フィードフォワード・コンプレッサーの実装
+ *
+ * 信号の流れ（1サンプルあたり）:
+ *   |L|,|R| の最大値 → log2 LUT で dBFS → 静的カーブ（ソフトニー） →
+ *   アタック/リリースの1次平滑化 → メイクアップ加算 → exp2 LUT で線形ゲイン
+ */
+
+#include "compressor.h"
+
+#include <stdio.h>
+#include <math.h>
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+// LUT のサイズ（仮数部の上位6ビットで引き、残りで線形補間）
+#define LUT_BITS         6
+#define LUT_SIZE         (1 << LUT_BITS)
+
+// dB <-> log2 の変換係数（Q16）
+#define DB_PER_LOG2_Q16  394566   // 20*log10(2) = 6.0206 dB
+#define LOG2_PER_DB_Q16  10885    // 1 / 6.0206
+
+// 無音時のレベル（dBFS Q16）
+#define LEVEL_FLOOR_Q16  (-120 * 65536)
+
+// ゲインの範囲（2^-16 .. 2^7）
+#define GAIN_MIN_LOG2    -16
+#define GAIN_MAX_LOG2    7
+
+// 先読み処理で1回にゲインを求めるフレーム数（スタック上の作業バッファのサイズ）
+#define LOOKAHEAD_CHUNK_FRAMES  128
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// log2(1 + i/64) と 2^(i/64)（Q16）、補間用に1要素多く持つ
+static int32_t log2_lut[LUT_SIZE + 1];
+static int32_t exp2_lut[LUT_SIZE + 1];
+static bool tables_ready = false;
+
+// ============================================================================
+// ルックアップテーブル
+// ============================================================================
+
+static void build_tables(void) {
+    for (int i = 0; i <= LUT_SIZE; i++) {
+        float x = (float)i / (float)LUT_SIZE;
+        log2_lut[i] = (int32_t)lroundf(log2f(1.0f + x) * 65536.0f);
+        exp2_lut[i] = (int32_t)lroundf(exp2f(x) * 65536.0f);
+    }
+    tables_ready = true;
+}
+
+/**
+ * @brief ピーク値（0-32768）を dBFS Q16 に変換
+ */
+static inline int32_t level_to_db_q16(uint32_t peak) {
+    if (peak == 0) return LEVEL_FLOOR_Q16;
+
+    // peak = 2^msb * (1 + m)、m は仮数部
+    int msb = 31 - __builtin_clz(peak);
+    uint32_t norm = peak << (31 - msb);          // 先頭の1をビット31へ
+    uint32_t idx = (norm >> (31 - LUT_BITS)) & (LUT_SIZE - 1);
+    uint32_t frac = (norm >> (31 - LUT_BITS - 16)) & 0xFFFF;
+
+    int32_t a = log2_lut[idx];
+    int32_t b = log2_lut[idx + 1];
+    int32_t log2_q16 = ((msb - 15) << 16) + a + (int32_t)(((int64_t)(b - a) * frac) >> 16);
+
+    return (int32_t)(((int64_t)log2_q16 * DB_PER_LOG2_Q16) >> 16);
+}
+
+/**
+ * @brief dB Q16 を線形ゲイン Q16 に変換
+ */
+static inline int32_t db_to_gain_q16(int32_t db_q16) {
+    int32_t log2_q16 = (int32_t)(((int64_t)db_q16 * LOG2_PER_DB_Q16) >> 16);
+    int32_t ip = log2_q16 >> 16;                 // 算術シフトで floor
+    uint32_t f = (uint32_t)log2_q16 & 0xFFFF;
+
+    if (ip < GAIN_MIN_LOG2) return 0;
+    if (ip > GAIN_MAX_LOG2) ip = GAIN_MAX_LOG2;
+
+    uint32_t idx = f >> (16 - LUT_BITS);
+    uint32_t frac = f & ((1 << (16 - LUT_BITS)) - 1);
+    int32_t a = exp2_lut[idx];
+    int32_t b = exp2_lut[idx + 1];
+    int32_t mant = a + (int32_t)(((b - a) * (int32_t)frac) >> (16 - LUT_BITS));
+
+    return (ip >= 0) ? (mant << ip) : (mant >> -ip);
+}
+
+/**
+ * @brief 時定数（ms）から1次平滑化係数（Q24）を計算
+ */
+static int32_t time_to_coeff(float time_ms, uint32_t sample_rate) {
+    if (time_ms <= 0.0f) return 1 << 24;
+    float samples = time_ms * 0.001f * (float)sample_rate;
+    return (int32_t)lroundf((1.0f - expf(-1.0f / samples)) * 16777216.0f);
+}
+
+// ============================================================================
+// 初期化・リセット
+// ============================================================================
+
+void compressor_init(compressor_t *comp, const compressor_params_t *params, uint32_t sample_rate) {
+    if (!comp || !params) return;
+
+    if (!tables_ready) {
+        build_tables();
+    }
+
+    float ratio = (params->ratio < 1.0f) ? 1.0f : params->ratio;
+    float knee = (params->knee_db < 0.0f) ? 0.0f : params->knee_db;
+
+    comp->threshold_q16 = (int32_t)lroundf(params->threshold_db * 65536.0f);
+    comp->knee_q16 = (int32_t)lroundf(knee * 65536.0f);
+    comp->slope_q16 = (int32_t)lroundf((1.0f - 1.0f / ratio) * 65536.0f);
+    comp->makeup_q16 = (int32_t)lroundf(params->makeup_db * 65536.0f);
+    comp->attack_coeff = time_to_coeff(params->attack_ms, sample_rate);
+    comp->release_coeff = time_to_coeff(params->release_ms, sample_rate);
+    comp->env_q16 = 0;
+
+    printf("[COMP] thr=%.1fdB ratio=%.1f:1 knee=%.1fdB att=%.1fms rel=%.1fms makeup=%.1fdB\n",
+           params->threshold_db, ratio, knee, params->attack_ms, params->release_ms,
+           params->makeup_db);
+}
+
+void compressor_reset(compressor_t *comp) {
+    if (comp) comp->env_q16 = 0;
+}
+
+// ============================================================================
+// ゲイン計算
+// ============================================================================
+
+int32_t compressor_static_curve(const compressor_t *comp, int32_t level_db_q16) {
+    int32_t over = level_db_q16 - comp->threshold_q16;
+    int32_t half_knee = comp->knee_q16 / 2;
+
+    // スレッショルド未満（ニーの下端より下）
+    if (over <= -half_knee) {
+        return 0;
+    }
+
+    // ニー区間: gr = -slope * (over + W/2)^2 / (2W)
+    if (over < half_knee) {
+        int64_t x = (int64_t)(over + half_knee);
+        int64_t sq = (x * x) / (2 * (int64_t)comp->knee_q16);  // dB Q16
+        return -(int32_t)((sq * comp->slope_q16) >> 16);
+    }
+
+    // ニーより上: gr = -slope * over
+    return -(int32_t)(((int64_t)over * comp->slope_q16) >> 16);
+}
+
+int32_t compressor_compute_gain(compressor_t *comp, int16_t key_l, int16_t key_r) {
+    // ステレオリンクのピーク検出
+    uint32_t peak_l = (key_l < 0) ? (uint32_t)(-(int32_t)key_l) : (uint32_t)key_l;
+    uint32_t peak_r = (key_r < 0) ? (uint32_t)(-(int32_t)key_r) : (uint32_t)key_r;
+    uint32_t peak = (peak_l > peak_r) ? peak_l : peak_r;
+
+    int32_t target = compressor_static_curve(comp, level_to_db_q16(peak));
+
+    // リダクションが深くなる方向はアタック、戻る方向はリリース
+    int32_t coeff = (target < comp->env_q16) ? comp->attack_coeff : comp->release_coeff;
+    comp->env_q16 += (int32_t)(((int64_t)(target - comp->env_q16) * coeff) >> 24);
+
+    return db_to_gain_q16(comp->env_q16 + comp->makeup_q16);
+}
+
+// ============================================================================
+// ブロック処理
+// ============================================================================
+
+void compressor_process(compressor_t *comp, int16_t *left, int16_t *right, uint32_t num_samples) {
+    compressor_process_sidechain(comp, left, right, left, right, num_samples);
+}
+
+void compressor_process_sidechain(compressor_t *comp, int16_t *left, int16_t *right,
+                                  const int16_t *key_l, const int16_t *key_r,
+                                  uint32_t num_samples) {
+    if (!comp || !left || !right || !key_l || !key_r) return;
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        int32_t gain = compressor_compute_gain(comp, key_l[i], key_r[i]);
+        left[i] = compressor_apply_gain(left[i], gain);
+        right[i] = compressor_apply_gain(right[i], gain);
+    }
+}
+
+void compressor_process_lookahead(compressor_t *comp, latency_delay_t *delay,
+                                  int16_t *left, int16_t *right, uint32_t num_samples) {
+    if (!comp || !delay || !left || !right) return;
+
+    int32_t gains[LOOKAHEAD_CHUNK_FRAMES];
+
+    for (uint32_t offset = 0; offset < num_samples; offset += LOOKAHEAD_CHUNK_FRAMES) {
+        uint32_t n = num_samples - offset;
+        if (n > LOOKAHEAD_CHUNK_FRAMES) n = LOOKAHEAD_CHUNK_FRAMES;
+        int16_t *l = left + offset;
+        int16_t *r = right + offset;
+
+        // 遅延前の入力でゲインを求めてから、信号を遅延線に通す
+        for (uint32_t i = 0; i < n; i++) {
+            gains[i] = compressor_compute_gain(comp, l[i], r[i]);
+        }
+        latency_delay_process(delay, l, r, l, r, n);
+        for (uint32_t i = 0; i < n; i++) {
+            l[i] = compressor_apply_gain(l[i], gains[i]);
+            r[i] = compressor_apply_gain(r[i], gains[i]);
+        }
+    }
+}
+
+float compressor_get_gain_reduction_db(const compressor_t *comp) {
+    return comp ? (float)comp->env_q16 / 65536.0f : 0.0f;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file compressor.h
+ * @brief フィードフォワード・コンプレッサー（固定小数点、ステレオリンク、サイドチェイン対応）- ヘッダーファイル
+ *
+ * レベル検出・ゲイン計算・エンベロープはすべて dB の Q16 固定小数点で行い、
+ * log2/exp2 はルックアップテーブル + 線形補間で求める（サンプルごとの超越関数なし）。
+ * 1つの構造体が1インスタンスで、バスコンプとウェットのダッキングで別々に使える。
+ */
+
+#ifndef COMPRESSOR_H
+#define COMPRESSOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "latency.h"
+
+// ゲイン 1.0（Q16）
+#define COMPRESSOR_UNITY_GAIN  (1 << 16)
+
+/**
+ * @brief コンプレッサーのパラメータ（設定時のみ使用、float）
+ */
+typedef struct {
+    float threshold_db;  // スレッショルド（dBFS）
+    float ratio;         // レシオ（1.0 以上、例: 4.0 = 4:1）
+    float knee_db;       // ニー幅（dB、0 = ハードニー）
+    float attack_ms;     // アタック時間
+    float release_ms;    // リリース時間
+    float makeup_db;     // メイクアップゲイン
+} compressor_params_t;
+
+/**
+ * @brief コンプレッサーの状態（固定小数点に変換済みの係数を含む）
+ */
+typedef struct {
+    int32_t threshold_q16;   // dB Q16
+    int32_t knee_q16;        // dB Q16
+    int32_t slope_q16;       // 1 - 1/ratio（Q16）
+    int32_t makeup_q16;      // dB Q16
+    int32_t attack_coeff;    // 1 - exp(-1/(t*fs))（Q24）
+    int32_t release_coeff;   // 同上（Q24）
+    int32_t env_q16;         // 平滑化後のゲインリダクション（dB Q16、0 以下）
+} compressor_t;
+
+/**
+ * @brief コンプレッサーを初期化
+ * @param comp コンプレッサー状態
+ * @param params パラメータ
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void compressor_init(compressor_t *comp, const compressor_params_t *params, uint32_t sample_rate);
+
+/**
+ * @brief キー信号1フレームからゲインを計算（エンベロープを1サンプル進める）
+ *
+ * L/R の大きい方で検出する（ステレオリンク）。
+ *
+ * @param comp コンプレッサー状態
+ * @param key_l キー信号（左）
+ * @param key_r キー信号（右）
+ * @return 適用するゲイン（Q16、メイクアップ込み）
+ */
+int32_t compressor_compute_gain(compressor_t *comp, int16_t key_l, int16_t key_r);
+
+/**
+ * @brief サンプルにゲインを適用（飽和付き）
+ * @param sample 入力サンプル
+ * @param gain_q16 ゲイン（Q16）
+ * @return 出力サンプル
+ */
+static inline int16_t compressor_apply_gain(int16_t sample, int32_t gain_q16) {
+    int32_t out = (int32_t)(((int64_t)sample * gain_q16) >> 16);
+    if (out > 32767) out = 32767;
+    if (out < -32768) out = -32768;
+    return (int16_t)out;
+}
+
+/**
+ * @brief ブロックを圧縮（キー = 入力自身）
+ * @param comp コンプレッサー状態
+ * @param left 左チャンネル（プレーナー、上書き）
+ * @param right 右チャンネル（プレーナー、上書き）
+ * @param num_samples ステレオペア数
+ */
+void compressor_process(compressor_t *comp, int16_t *left, int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief 別のキー信号でブロックを圧縮（サイドチェイン）
+ * @param comp コンプレッサー状態
+ * @param left 圧縮する信号の左チャンネル（上書き）
+ * @param right 圧縮する信号の右チャンネル（上書き）
+ * @param key_l キー信号の左チャンネル
+ * @param key_r キー信号の右チャンネル
+ * @param num_samples ステレオペア数
+ */
+void compressor_process_sidechain(compressor_t *comp, int16_t *left, int16_t *right,
+                                  const int16_t *key_l, const int16_t *key_r,
+                                  uint32_t num_samples);
+
+/**
+ * @brief 先読み付きでブロックを圧縮（キー = 遅延前の入力）
+ *
+ * ゲインは遅延線を通した信号に掛けるので、アタックが遅延量だけ先に始まる。
+ * 遅延線の遅延量がそのままこのノードのレイテンシーになる。
+ *
+ * @param comp コンプレッサー状態
+ * @param delay 先読み用の遅延線
+ * @param left 左チャンネル（プレーナー、上書き）
+ * @param right 右チャンネル（プレーナー、上書き）
+ * @param num_samples ステレオペア数
+ */
+void compressor_process_lookahead(compressor_t *comp, latency_delay_t *delay,
+                                  int16_t *left, int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief 静的カーブ（エンベロープなし）のゲインリダクションを計算（検証用）
+ * @param comp コンプレッサー状態
+ * @param level_db_q16 入力レベル（dBFS Q16）
+ * @return ゲインリダクション（dB Q16、0 以下）
+ */
+int32_t compressor_static_curve(const compressor_t *comp, int32_t level_db_q16);
+
+/**
+ * @brief 現在のゲインリダクションを取得（メーター用）
+ * @param comp コンプレッサー状態
+ * @return ゲインリダクション（dB、0 以下）
+ */
+float compressor_get_gain_reduction_db(const compressor_t *comp);
+
+/**
+ * @brief エンベロープをリセット
+ * @param comp コンプレッサー状態
+ */
+void compressor_reset(compressor_t *comp);
+
+#endif // COMPRESSOR_H
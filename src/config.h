@@ -20,18 +20,42 @@
 // オーディオ出力モード選択
 // ============================================================================
 
-// I2S DAC 出力専用モード（PWM出力は廃止）
+// I2S DAC 出力（メイン出力）
 #define USE_I2S_OUTPUT     1
 
+// PWM Σ-Δ 出力（ヘッドホン/キュー用のサブ出力、I2Sと同時使用可能）
+// 0 = 無効、1 = 有効
+#define USE_PWM_OUTPUT     0
+
 // ============================================================================
 // I2S DAC 設定（PCM5102A などの I2S DAC を使用する場合）
 // ============================================================================
 
+// I2S 出力の接続先タップ（audio_route.h の audio_tap_t）
+#define I2S_OUTPUT_TAP  AUDIO_TAP_POST_EFFECT
+
 // I2S ピン配置
 #define I2S_DATA_PIN    26    // DIN (Data)
 #define I2S_BCLK_PIN    27    // BCK (Bit Clock)
 #define I2S_LRCLK_PIN   28    // LCK (Left/Right Clock / Word Select)
 
+// I2S 4チャンネル出力（2本のデータ線、BCLK/LRCLK は共通）
+// 0 = 通常のステレオ I2S（I2S_DATA_PIN を使用）
+// 1 = 2組の DAC に 4チャンネル出力（I2S_QUAD_DATA_PIN_BASE, +1 を使用）
+//     リングバッファは4チャンネル分になるため、フレーム数は半分になる
+#define I2S_QUAD_OUTPUT         0
+
+// 4チャンネル出力のデータピン（連続2ピン: ベース = ペアA, ベース+1 = ペアB）
+#define I2S_QUAD_DATA_PIN_BASE  20
+
+// 4チャンネル出力の振り分け方
+#define I2S_QUAD_MODE_DRY_WET   0   // ペアA = エフェクト前（ドライ）、ペアB = エフェクト後（ウェット）
+#define I2S_QUAD_MODE_CROSSOVER 1   // ペアA = 高域（メイン）、ペアB = 低域（サブウーファー）
+#define I2S_QUAD_MODE           I2S_QUAD_MODE_DRY_WET
+
+// クロスオーバー周波数（Hz、I2S_QUAD_MODE_CROSSOVER の場合）
+#define I2S_CROSSOVER_FREQ_HZ   120
+
 // サンプリングレート（Hz）
 #define AUDIO_SAMPLE_RATE    44100
 
@@ -41,6 +65,32 @@
 // チャンネル数（ステレオ）
 #define AUDIO_CHANNELS        2
 
+// ============================================================================
+// PWM Σ-Δ 出力設定（USE_PWM_OUTPUT = 1 の場合）
+// ============================================================================
+
+// PWM 出力の接続先タップ（audio_route.h の audio_tap_t）
+// AUDIO_TAP_PRE_EFFECT  = エフェクト前のドライ音（キュー用）
+// AUDIO_TAP_POST_EFFECT = I2S と同じエフェクト後のミックス
+#define PWM_OUTPUT_TAP       AUDIO_TAP_PRE_EFFECT
+
+// PWM 出力ピン（L/R は同じ PWM スライスの A/B チャンネルにすること）
+// GPIO 18 = スライス1 A, GPIO 19 = スライス1 B
+#define PWM_AUDIO_PIN_L      18
+#define PWM_AUDIO_PIN_R      19
+
+// オーバーサンプリング比（PWM キャリア = サンプルレート × この値）
+// 2次ノイズシェーピングと組み合わせて 12-14 ビット相当の SNR を得る
+// 150MHz / (44100 × 8) ≈ 425 レベル（約8.7ビット）
+#define PWM_OVERSAMPLE       8
+
+// PWM リングバッファサイズ（ステレオペア数）
+// キュー出力用なので I2S より小さい（125ms分）
+#define PWM_BUFFER_SIZE      (AUDIO_SAMPLE_RATE / 8)
+
+// PWM DMA バッファサイズ（ステレオペア数、DMA転送数はこの × PWM_OVERSAMPLE）
+#define PWM_DMA_BUFFER_SIZE  128
+
 // ============================================================================
 // オーディオバッファ設定
 // ============================================================================
@@ -54,6 +104,10 @@
 // DMA バッファサイズ（サンプル数）
 #define DMA_BUFFER_SIZE      512
 
+// 目標深さへの寄せ込み: 書き込み I2S_DEPTH_SLIP_SPACING フレームごとに最大1フレームを
+// 間引く / 重複させる（256 で約 0.4%）
+#define I2S_DEPTH_SLIP_SPACING  256
+
 // バッファアンダーラン/オーバーラン検出の閾値
 #define BUFFER_LOW_THRESHOLD    (AUDIO_BUFFER_SIZE / 4)
 #define BUFFER_HIGH_THRESHOLD   (AUDIO_BUFFER_SIZE * 3 / 4)
@@ -96,6 +150,12 @@
 // A2DPパケットの最初13バイトはヘッダーで、実際のSBCデータはその後
 #define SBC_MEDIA_PACKET_HEADER_OFFSET  13
 
+// SBC デコード結果をまとめて処理するブロックの最大長（ステレオペア数）
+// 1メディアパケット分（通常5-8 SBCフレーム = 640-1024ペア）を1ブロックにまとめ、
+// ボリューム・エフェクト・出力をパケットあたり1回だけ実行する
+// これを超えるとパケットの途中でも処理する（128 = 従来のフレームごとの処理）
+#define PCM_BATCH_MAX_FRAMES  1024
+
 // SDP AVDTP Sink サービスバッファサイズ（バイト）
 #define SDP_AVDTP_SINK_BUFFER_SIZE  150
 
@@ -104,8 +164,9 @@
 // ============================================================================
 
 // PIO クロックサイクル数（1ステレオペアあたり）
-// 左チャンネル33サイクル + 右チャンネル33サイクル = 66サイクル
-#define PIO_CYCLES_PER_STEREO_SAMPLE  66
+// 左チャンネル32サイクル + 右チャンネル32サイクル = 64サイクル（1ビット = 2サイクル）
+// i2s.pio を変えたら tools/pio_emu.py でタイミングとビット配置を確認する
+#define PIO_CYCLES_PER_STEREO_SAMPLE  64
 
 // ============================================================================
 // オーディオボリューム設定
@@ -116,6 +177,354 @@
 // スマホ側で音量を上げて調整してください
 #define SOFTWARE_VOLUME_PERCENT  85  // 85%
 
+// ============================================================================
+// ラウドネスメーター / AGC 設定
+// ============================================================================
+
+// Kウェイティングのラウドネスメーター（EBU R128 モーメンタリー/ショートターム）
+// SOFTWARE_VOLUME_PERCENT の後、エフェクトの前で計測する
+#define LOUDNESS_METER_ENABLED  1
+
+// 低速 AGC（スマホやアプリごとの音量差を目標ラウドネスに揃える）
+#define LOUDNESS_AGC_ENABLED          0
+#define LOUDNESS_AGC_TARGET_LUFS      -16.0f  // 目標ラウドネス（LUFS）
+#define LOUDNESS_AGC_MAX_GAIN_DB      12.0f   // 最大ブースト
+#define LOUDNESS_AGC_MIN_GAIN_DB      -12.0f  // 最大カット
+#define LOUDNESS_AGC_SLEW_DB_PER_SEC  1.0f    // ゲイン変化速度（ポンピング防止）
+#define LOUDNESS_AGC_GATE_LUFS        -45.0f  // これ未満（無音・曲間）ではゲインを保持
+
+// ============================================================================
+// コンプレッサー設定
+// ============================================================================
+
+// ウェット（リピート音）のダッキング: ドライ入力のトランジェントをキーにウェットを下げる
+#define EFFECT_DUCK_ENABLED        1
+#define EFFECT_DUCK_THRESHOLD_DB   -24.0f
+#define EFFECT_DUCK_RATIO          4.0f
+#define EFFECT_DUCK_KNEE_DB        6.0f
+#define EFFECT_DUCK_ATTACK_MS      2.0f
+#define EFFECT_DUCK_RELEASE_MS     150.0f
+
+// Beat-Repeat の内部ループを (ピッチモード × 逆再生 × ウィンドウ × フリーズ) ごとに
+// 特殊化したカーネルで処理する（0 = サンプルごとに分岐する汎用パス、比較用）
+#define EFFECT_SPECIALISED_KERNELS  1
+
+// Beat-Slicer: 直前の小節を何ステップに分けて並べ替えるか
+// 履歴はスライスバッファの領域を ADPCM で使う（4秒）。(2 × ステップ数 - 1) × ステップ長が
+// 4秒に収まらない時はステップを減らさずにドライのまま通す（8ステップなら 11759 サンプル、
+// 60 BPM の16分音符 / 120 BPM の8分音符まで）。開始はビートクロックの小節頭に合わせる
+#define SLICER_NUM_STEPS    8
+// スライス両端のマイクロフェード長（サンプル数、クリック防止）
+#define SLICER_FADE_FRAMES  64
+
+// マルチバンド Beat-Repeat: Linkwitz-Riley（LR4）クロスオーバーで帯域ごとにリピートを掛ける
+// 帯域数（2 または 3）とクロスオーバー周波数（3帯域のときは LOW < HIGH）
+// 例: 低域をドライのまま通し、中高域だけリピートしてキックを濁らせない
+#define EFFECT_MULTIBAND_BANDS    3
+#define EFFECT_CROSSOVER_LOW_HZ   200
+#define EFFECT_CROSSOVER_HIGH_HZ  2500
+
+// トランジェントトリガー: スライス確率の代わりに、入力の強いトランジェント（スネアなど）で
+// リピートを始める。トランジェントの少し前からスライスを取り直し、次の境界でそれを繰り返す
+// (L+R)/2 を帯域通過させた |x| の平均を TRANSIENT_HOP_FRAMES ごとに速い/遅いエンベロープで追い、
+// 比がしきい値（パラメータ、既定 TRANSIENT_DEFAULT_THRESHOLD）を越えたら候補にする
+#define TRANSIENT_HOP_FRAMES              32       // 解析の単位（0.73ms）
+#define TRANSIENT_HIGHPASS_HZ             500.0f   // 帯域の下端（ベースでエンベロープが揺れない）
+#define TRANSIENT_LOWPASS_HZ              5000.0f  // 帯域の上端（ハイハットよりスネアを拾う）
+#define TRANSIENT_FAST_MS                 6.0f     // 速いエンベロープの時定数
+#define TRANSIENT_SLOW_MS                 200.0f   // 遅いエンベロープの時定数
+#define TRANSIENT_STRENGTH_DB             -9.0f    // 最近のピークよりこれ以上小さいもの（ゴースト、ハット）は無視
+#define TRANSIENT_PEAK_RELEASE_MS         2000.0f  // ピークの戻り時間
+#define TRANSIENT_FLOOR_DB                -42.0f   // これより小さい音では検出しない（dBFS、平均 |x|）
+#define TRANSIENT_DEFAULT_THRESHOLD       2.0f     // 速い/遅い の比
+#define TRANSIENT_DEFAULT_REFRACTORY_MS   100.0f   // 検出後に次を検出しない時間
+#define TRANSIENT_PREROLL_FRAMES          44       // スライスをトランジェントの何フレーム前から取るか（1ms）
+
+// バスコンプレッサー: エフェクト後の信号のピークを抑える
+#define COMPRESSOR_BUS_ENABLED       0
+#define COMPRESSOR_BUS_THRESHOLD_DB  -12.0f
+#define COMPRESSOR_BUS_RATIO         4.0f
+#define COMPRESSOR_BUS_KNEE_DB       6.0f
+#define COMPRESSOR_BUS_ATTACK_MS     5.0f
+#define COMPRESSOR_BUS_RELEASE_MS    200.0f
+#define COMPRESSOR_BUS_MAKEUP_DB     3.0f
+// 先読み（フレーム、0 = なし）: キーは遅延前の入力で、ゲインは遅延後の信号に掛ける
+// 遅延はレイテンシーとして申告され、エフェクト前タップ（ドライ出力）も同じだけ遅らせる
+// LATENCY_MAX_COMPENSATION 以下にすること（例: 88 = 2ms）
+#define COMPRESSOR_BUS_LOOKAHEAD_FRAMES  0
+
+// ============================================================================
+// レイテンシー補償設定
+// ============================================================================
+
+// 遅延線に使う共有履歴メモリ（ステレオフレーム数、4バイト/フレーム）
+#define LATENCY_POOL_FRAMES       1024
+
+// タップごとの補償遅延の最大値（フレーム、これを超える遅延は補償しきれない）
+#define LATENCY_MAX_COMPENSATION  256
+
+// ============================================================================
+// 遅延レポート設定
+// ============================================================================
+
+// AVDTP Delay Reporting（出力遅延をソースに報告し、映像との同期に使ってもらう）
+#define DELAY_REPORT_ENABLED          1
+
+// バッファ状態のサンプリング間隔（ms）
+#define DELAY_REPORT_SAMPLE_MS        20
+
+// 平滑化（指数移動平均の 1/N、リングのフィルの揺れを均す）
+#define DELAY_REPORT_SMOOTHING        16
+
+// 報告し直す変化量（ms）と報告の最小間隔（ms）
+#define DELAY_REPORT_HYSTERESIS_MS    10
+#define DELAY_REPORT_MIN_INTERVAL_MS  1000
+
+// ============================================================================
+// 適応バッファ設定
+// ============================================================================
+
+// リンク品質（到着ジッター、ギャップ、RSSI、HCI イベント）から出力リングの
+// 目標深さと開始閾値を決める（0 = 固定: AUDIO_BUFFER_SIZE の 20% で開始）
+#define LINK_ADAPTIVE_BUFFER_ENABLED  1
+
+// 目標深さの範囲と初期値（ms、最大はリングの 3/4 でクランプされる）
+#define LINK_TARGET_MIN_MS       60
+#define LINK_TARGET_MAX_MS       500
+#define LINK_TARGET_INITIAL_MS   200
+
+// 必要だった深さ（ドローダウンのピーク）に掛ける余裕（%）
+#define LINK_MARGIN_PERCENT      150
+
+// ピークを取る窓（ms）と覚えておく窓の数
+#define LINK_WINDOW_MS           1000
+#define LINK_HISTORY_WINDOWS     8
+
+// この間隔を超えた到着はギャップとして数える（ms）
+#define LINK_GAP_MS              60
+
+// RSSI がこれを下回ったら上乗せするマージン
+#define LINK_RSSI_WEAK_DBM       -75
+#define LINK_RSSI_MARGIN_MS      40
+#define LINK_RSSI_INTERVAL_MS    1000
+
+// ギャップ / フロー系イベント / アンダーランの後に上乗せするマージンと保持時間
+#define LINK_EVENT_MARGIN_MS     80
+#define LINK_EVENT_HOLD_MS       10000
+
+// 下げるのは最後に上げてから LINK_LOWER_HOLD_MS 後、窓ごとに LINK_LOWER_STEP_MS ずつ
+#define LINK_LOWER_HOLD_MS       8000
+#define LINK_LOWER_STEP_MS       10
+
+// ソースとのクロック差の許容（ppm、これ以下のずれはドローダウンに積まない）
+#define LINK_DRIFT_PPM           300
+
+// 目標深さを出力に反映する間隔（ms）
+#define LINK_UPDATE_MS           100
+
+// ============================================================================
+// バリスピード設定
+// ============================================================================
+
+// ストリーム全体のピッチ/テンポフェーダー（デコード直後のリサンプラー）
+// 原速のときは遅延を合わせたコピーだけになる（遅延 VARISPEED_TAPS/2 フレーム）
+#define VARISPEED_ENABLED           1
+
+// 速度の範囲（1/1000、80 = ±8%）
+#define VARISPEED_RANGE_PERMILLE    80
+
+// リサンプラーのタップ数（偶数）と位相数（2^VARISPEED_PHASE_BITS、位相間は線形補間）
+#define VARISPEED_TAPS              32
+#define VARISPEED_PHASE_BITS        6
+
+// ローパスのカットオフ（ナイキスト比）と Kaiser 窓の β
+// +8% で入力の 20.4kHz 以上が折り返すので、0.88（19.4kHz）で切る
+#define VARISPEED_CUTOFF            0.88
+#define VARISPEED_KAISER_BETA       7.0
+
+// フェーダーの動きを滑らかにする一次遅れの時定数（ms）
+#define VARISPEED_SMOOTHING_MS      150
+
+// リングの余裕を使い切るまでの時定数（ms）
+// 余裕 H フレームのとき、ずれを H / (fs × τ) までに抑える
+#define VARISPEED_HEADROOM_TAU_MS   2000
+
+// 遅くするとき残しておく空き（ms）と、速くするときに割らないフィル（ms）
+#define VARISPEED_HIGH_MARGIN_MS    100
+#define VARISPEED_LOW_FLOOR_MS      80
+
+// ============================================================================
+// 制御プロトコル設定
+// ============================================================================
+
+// USB CDC のバイナリ制御・テレメトリープロトコル（COBS + CRC-16）
+// printf のログと同じ CDC に流れる（ホスト側は CRC の合わない断片を捨てる）
+#define CONTROL_ENABLED                    1
+
+// メインループ1回あたりに読む最大バイト数
+#define CONTROL_RX_BUDGET                  256
+
+// RAM 上のプリセット数（電源を切ると消える）
+#define CONTROL_NUM_PRESETS                8
+
+// テレメトリーの最短間隔（ms）
+#define CONTROL_TELEMETRY_MIN_INTERVAL_MS  1
+
+// ============================================================================
+// トレース設定
+// ============================================================================
+
+// オーディオ経路のタイムライントレース（パケット・デコード・エフェクト・DMA 割り込みなど）
+// 制御プロトコルの TRACE_DUMP でシリアルにダンプし、tools/trace2json.py で変換する
+#define TRACE_ENABLED              1
+
+// コアごとのイベント数（2のべき乗、1イベント 8バイト）
+// 1024 ≈ 再生中の約 0.7 秒分
+#define TRACE_EVENTS_PER_CORE      1024
+
+// アンダーランでトリガーした後に記録するイベント数（これで記録を止めて保持する）
+#define TRACE_POST_TRIGGER_EVENTS  128
+
+// トリガーで止まったら自動でダンプする（0 = TRACE_DUMP を待つ）
+#define TRACE_AUTO_DUMP            0
+
+// メインループ1回あたりにダンプする行数
+#define TRACE_DUMP_LINES_PER_POLL  16
+
+// 起動時のオーバーヘッド計測に使うイベント数
+#define TRACE_CALIBRATION_EVENTS   1000
+
+// ============================================================================
+// SRAM 配置設定
+// ============================================================================
+
+// DMA の読むバッファと割り込みの状態を専用バンクに置く（src/sram_layout.h）
+// I2S DMA のピンポンバッファ → scratch X、DMA 割り込みの状態 → scratch Y
+// 4チャンネル出力ではピンポンが 8KB になり scratch X に入らないので通常の配置になる
+#define SRAM_PLACEMENT_ENABLED     1
+
+// BUSCTRL の性能カウンタでバンクごとのアクセス数と競合数を数える
+#define SRAM_BUS_COUNTERS_ENABLED  1
+
+// 性能カウンタを読み出す間隔（ms、24ビットで飽和する前に読む）
+#define SRAM_BUS_SAMPLE_MS         100
+
+// コア0のスタック（scratch Y の上側、大きさは CMakeLists.txt の PICO_STACK_SIZE）の
+// 最大使用量がこの残りを切ったら警告する（バイト）
+#define SRAM_STACK_WARN_MARGIN     256
+
+// ============================================================================
+// SD カード録音設定
+// ============================================================================
+
+// 処理後の出力を SD カードの事前確保ファイル（RECnn.WAV）にストリーミング録音する
+// ファイルは tools/sd_prealloc.py で FAT32 のカードに作る（録音中は FAT を更新しない）
+#define RECORDER_ENABLED        1
+
+// 録音するタップ
+#define RECORDER_TAP            AUDIO_TAP_POST_EFFECT
+
+// ストリームの接続で録音を始め、切断で止める（0 = 制御プロトコルの TRIGGER で操作）
+#define RECORDER_AUTO_START     1
+
+// ステージングリングのバイト数（RECORDER_WRITE_BLOCKS × 512 の倍数）
+// 32KB = 約 186ms: カードの書き込みがこれ以上止まると録音だけを捨てる
+#define RECORDER_STAGING_BYTES  (32 * 1024)
+
+// 1回のマルチブロック書き込みのブロック数（16 = 8KB ≈ 46ms 分）
+#define RECORDER_WRITE_BLOCKS   16
+
+// 録音ファイル名の先頭（ルートディレクトリの 8.3 形式、拡張子は WAV）と最大数
+#define RECORDER_FILE_PREFIX    "REC"
+#define RECORDER_MAX_FILES      16
+
+// SD カードの SPI（SPI1 の既定ピン）
+#define SD_SPI_INSTANCE         spi1
+#define SD_SCK_PIN              10
+#define SD_MOSI_PIN             11
+#define SD_MISO_PIN             12
+#define SD_CS_PIN               13
+
+// SPI クロック（初期化中は 400kHz 以下、その後は最大 25MHz）
+#define SD_SPI_INIT_BAUD        400000
+#define SD_SPI_BAUD             25000000
+
+// タイムアウト（ms）
+#define SD_INIT_TIMEOUT_MS      1000
+#define SD_READ_TIMEOUT_MS      100
+#define SD_WRITE_TIMEOUT_MS     500
+
+// ============================================================================
+// モジュレーション設定
+// ============================================================================
+
+// テンポ同期モジュレーター（LFO / エンベロープ）の数とルートの最大数
+#define MOD_MATRIX_NUM_SOURCES  4
+#define MOD_MATRIX_MAX_ROUTES   8
+
+// 起動時にデモ用のルートを設定する（0 = ルートなし）
+// LFO1: 三角波 1小節周期 → ウェットミックス ±30%
+// LFO2: S&H 8分音符周期 → ループ開始位置 ±0.25
+#define MOD_MATRIX_DEMO_ROUTES  0
+
+// ============================================================================
+// トランスゲート設定
+// ============================================================================
+
+// テンポ同期のステップ音量シェイパー（エフェクトの後、ルーパーの前）
+// 起動時は無効。制御プロトコルの GATE_ENABLED で有効にする
+#define TRANCE_GATE_ENABLED        1
+
+// パターンの最大ステップ数（16 = 1小節、32 = 2小節 @ 16分音符）
+#define TRANCE_GATE_MAX_STEPS      32
+
+// ゲインが変わるところのランプ長（フレーム、64 ≈ 1.5ms）
+#define TRANCE_GATE_RAMP_FRAMES    64
+
+// 既定のデプス、1拍あたりのステップ数、デューティー
+#define TRANCE_GATE_DEFAULT_DEPTH  1.0f
+#define TRANCE_GATE_DEFAULT_RATE   4
+#define TRANCE_GATE_DEFAULT_DUTY   0.75f
+
+// ============================================================================
+// ルーパー設定
+// ============================================================================
+
+// 小節単位のルーパー（エフェクト後の音を録音し、ビートクロックに合わせてループ再生）
+// 専用のメモリは持たず、Beat-Repeat が無効の間だけスライスバッファ（172KB）を借りる。
+// ループがある間は Beat-Repeat を有効にしても素通りになり、ループを消すと戻る。
+// IMA-ADPCM モノラルで原レートなら 7.7秒（90 BPM で2小節、120 BPM で3小節）、
+// 半レートなら 15.5秒（90 BPM で5小節、120 BPM で7小節）
+#define LOOPER_ENABLED        1
+
+// 原レートで収まらないループを半レート（22.05kHz）で保存する
+// 帯域は約 9.4kHz（-1dB）になり、ループは間引き/補間フィルタの分（30フレーム ≈ 0.7ms）遅れて鳴る
+#define LOOPER_HALF_RATE_ENABLED  1
+
+// 録音チャンネル数（1 = L+R をモノラルで保存して容量を2倍にする、2 = ステレオ）
+#define LOOPER_CHANNELS       1
+
+// 圧縮ブロック長（保存するサンプル数、ブロックごとにデコード/再エンコードする）
+#define LOOPER_BLOCK_FRAMES   256
+
+// オーバーダブ時のフィードバック（既存のループに掛けるゲイン）
+#define LOOPER_FEEDBACK       0.9f
+
+// ============================================================================
+// サンプルプレーヤー設定
+// ============================================================================
+
+// フラッシュ上のサンプルバンク（samples/*.wav）のワンショット再生
+#define SAMPLER_ENABLED         1
+
+// 同時発音数（足りないときは最も古いボイスを止めて使う）
+#define SAMPLER_NUM_VOICES      4
+
+// ボイスごとの先読みバッファ（バイト、4の倍数、これを2面持つ）
+// 512バイト = ADPCM で1024フレーム（23ms）、PCM で256フレーム（5.8ms）
+// 1面を再生し切る前にもう1面の DMA 転送が終わればよい
+#define SAMPLER_PREFETCH_BYTES  512
+
 // ============================================================================
 // タップテンポボタン設定
 // ============================================================================
@@ -0,0 +1,570 @@
+/**
+ * @file control.c
+ * @brief USB CDC のバイナリ制御・テレメトリープロトコルの実装
+ *
+ * stdio の USB CDC をそのまま使う。受信は getchar_timeout_us(0) でメインループから
+ * 読めるだけ読み（1回あたり CONTROL_RX_BUDGET バイトまで）、送信は改行変換のない
+ * putchar_raw で行う（バイナリに 0x0A があっても 0x0D が挿入されない）。
+ */
+
+#include "control.h"
+#include "control_frame.h"
+#include "config.h"
+#include "audio_effect.h"
+#include "audio_out_i2s.h"
+#include "bt_audio.h"
+#include "beat_clock.h"
+#include "tap_tempo.h"
+#include "mod_matrix.h"
+#include "loudness.h"
+#include "looper.h"
+#include "sampler.h"
+#include "link_monitor.h"
+#include "delay_report.h"
+#include "trace.h"
+#include "recorder.h"
+#include "varispeed.h"
+#include "trance_gate.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static control_decoder_t decoder;
+
+static beat_repeat_params_t presets[CONTROL_NUM_PRESETS];
+
+static uint32_t telemetry_interval_ms = 0;   // 0 = 停止
+static absolute_time_t last_telemetry_time;
+
+static uint32_t length_errors = 0;           // CRC は合ったがペイロード長が不正
+
+// ============================================================================
+// 送信
+// ============================================================================
+
+static void send_message(const uint8_t *msg, uint16_t len) {
+    uint8_t frame[CONTROL_FRAME_MAX_ENCODED];
+    uint32_t n = control_frame_encode(msg, len, frame);
+    for (uint32_t i = 0; i < n; i++) {
+        putchar_raw(frame[i]);
+    }
+}
+
+static void send_status(uint8_t type, uint8_t seq, control_status_t status) {
+    uint8_t msg[3] = { type, seq, (uint8_t)status };
+    send_message(msg, sizeof(msg));
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline int32_t get_i32(const uint8_t *p) {
+    return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                     ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+// ============================================================================
+// パラメータ
+// ============================================================================
+
+static inline int32_t to_milli(float v) {
+    return (int32_t)lroundf(v * 1000.0f);
+}
+
+static inline float from_milli(int32_t v) {
+    return (float)v / 1000.0f;
+}
+
+/**
+ * @brief エフェクトのパラメータを構造体に書き込む（検証は audio_effect が行う）
+ * @return true パラメータ ID がエフェクトのもの
+ */
+static bool set_effect_param(beat_repeat_params_t *p, uint8_t id, int32_t value) {
+    switch (id) {
+        case CONTROL_PARAM_EFFECT_ENABLED:    p->enabled = (value != 0); break;
+        case CONTROL_PARAM_WET_MIX:           p->wet_mix = (uint8_t)((value < 0) ? 0 : (value > 100) ? 100 : value); break;
+        case CONTROL_PARAM_REPEAT_COUNT:      p->repeat_count = (uint8_t)((value < 0) ? 0 : (value > 255) ? 255 : value); break;
+        case CONTROL_PARAM_SLICE_LENGTH:      p->slice_length = (uint32_t)((value < 0) ? 0 : value); p->slice_length_frac = 0; break;
+        case CONTROL_PARAM_PITCH_SHIFT:       p->pitch_shift = from_milli(value); break;
+        case CONTROL_PARAM_REVERSE:           p->reverse = (value != 0); break;
+        case CONTROL_PARAM_STUTTER_ENABLED:   p->stutter_enabled = (value != 0); break;
+        case CONTROL_PARAM_STUTTER_LENGTH:    p->stutter_slice_length = (uint32_t)((value < 0) ? 0 : value); break;
+        case CONTROL_PARAM_WINDOW_SHAPE:      p->window_shape = from_milli(value); break;
+        case CONTROL_PARAM_LOOP_START:        p->loop_start = from_milli(value); break;
+        case CONTROL_PARAM_LOOP_SIZE_DECAY:   p->loop_size_decay = from_milli(value); break;
+        case CONTROL_PARAM_SLICE_PROBABILITY: p->slice_probability = from_milli(value); break;
+        case CONTROL_PARAM_CLOCK_DIVIDER:     p->clock_divider = (uint8_t)((value < 0) ? 0 : (value > 255) ? 255 : value); break;
+        case CONTROL_PARAM_PITCH_MODE:        p->pitch_mode = (pitch_mode_t)value; break;
+        case CONTROL_PARAM_FREEZE:            p->freeze = (value != 0); break;
+        case CONTROL_PARAM_DUCK_ENABLED:      p->duck_enabled = (value != 0); break;
+        case CONTROL_PARAM_SLICER_ENABLED:    p->slicer_enabled = (value != 0); break;
+        case CONTROL_PARAM_SLICER_PATTERN:    p->slicer_pattern = (slicer_pattern_t)value; break;
+        case CONTROL_PARAM_MULTIBAND_ENABLED: p->multiband_enabled = (value != 0); break;
+        case CONTROL_PARAM_REPEAT_TRIGGER:    p->repeat_trigger = (repeat_trigger_t)value; break;
+        case CONTROL_PARAM_TRANSIENT_THRESHOLD: p->transient_threshold = from_milli(value); break;
+        case CONTROL_PARAM_TRANSIENT_REFRACTORY: p->transient_refractory_ms = (float)value; break;
+        default:
+            if (id >= CONTROL_PARAM_BAND_REPEAT_0 && id < CONTROL_PARAM_BAND_REPEAT_0 + CROSSOVER_MAX_BANDS) {
+                p->band_repeat[id - CONTROL_PARAM_BAND_REPEAT_0] = (value != 0);
+                break;
+            }
+            if (id >= CONTROL_PARAM_BAND_MIX_0 && id < CONTROL_PARAM_BAND_MIX_0 + CROSSOVER_MAX_BANDS) {
+                p->band_mix[id - CONTROL_PARAM_BAND_MIX_0] = (uint8_t)((value < 0) ? 0 : (value > 100) ? 100 : value);
+                break;
+            }
+            return false;
+    }
+    return true;
+}
+
+static bool get_param(const beat_repeat_params_t *p, uint8_t id, int32_t *value) {
+    switch (id) {
+        case CONTROL_PARAM_EFFECT_ENABLED:    *value = p->enabled; break;
+        case CONTROL_PARAM_WET_MIX:           *value = p->wet_mix; break;
+        case CONTROL_PARAM_REPEAT_COUNT:      *value = p->repeat_count; break;
+        case CONTROL_PARAM_SLICE_LENGTH:      *value = (int32_t)p->slice_length; break;
+        case CONTROL_PARAM_PITCH_SHIFT:       *value = to_milli(p->pitch_shift); break;
+        case CONTROL_PARAM_REVERSE:           *value = p->reverse; break;
+        case CONTROL_PARAM_STUTTER_ENABLED:   *value = p->stutter_enabled; break;
+        case CONTROL_PARAM_STUTTER_LENGTH:    *value = (int32_t)p->stutter_slice_length; break;
+        case CONTROL_PARAM_WINDOW_SHAPE:      *value = to_milli(p->window_shape); break;
+        case CONTROL_PARAM_LOOP_START:        *value = to_milli(p->loop_start); break;
+        case CONTROL_PARAM_LOOP_SIZE_DECAY:   *value = to_milli(p->loop_size_decay); break;
+        case CONTROL_PARAM_SLICE_PROBABILITY: *value = to_milli(p->slice_probability); break;
+        case CONTROL_PARAM_CLOCK_DIVIDER:     *value = p->clock_divider; break;
+        case CONTROL_PARAM_PITCH_MODE:        *value = (int32_t)p->pitch_mode; break;
+        case CONTROL_PARAM_FREEZE:            *value = p->freeze; break;
+        case CONTROL_PARAM_DUCK_ENABLED:      *value = p->duck_enabled; break;
+        case CONTROL_PARAM_SLICER_ENABLED:    *value = p->slicer_enabled; break;
+        case CONTROL_PARAM_SLICER_PATTERN:    *value = (int32_t)p->slicer_pattern; break;
+        case CONTROL_PARAM_MULTIBAND_ENABLED: *value = p->multiband_enabled; break;
+        case CONTROL_PARAM_REPEAT_TRIGGER:    *value = (int32_t)p->repeat_trigger; break;
+        case CONTROL_PARAM_TRANSIENT_THRESHOLD: *value = to_milli(p->transient_threshold); break;
+        case CONTROL_PARAM_TRANSIENT_REFRACTORY: *value = (int32_t)lroundf(p->transient_refractory_ms); break;
+        case CONTROL_PARAM_BPM:               *value = (int32_t)lroundf(beat_clock_get_bpm() * 100.0f); break;
+        case CONTROL_PARAM_NOTE_DIVISION:     *value = (int32_t)tap_tempo_get_note_division(); break;
+#if LOUDNESS_METER_ENABLED
+        case CONTROL_PARAM_AGC_ENABLED:       *value = loudness_get_agc_enabled(); break;
+#endif
+#if VARISPEED_ENABLED
+        case CONTROL_PARAM_VARISPEED:         *value = to_milli(varispeed_get_speed()); break;
+#endif
+#if TRANCE_GATE_ENABLED
+        case CONTROL_PARAM_GATE_ENABLED:      *value = trance_gate_get_enabled(); break;
+        case CONTROL_PARAM_GATE_DEPTH:        *value = to_milli(trance_gate_get_depth()); break;
+        case CONTROL_PARAM_GATE_RATE:         *value = (int32_t)trance_gate_get_rate(); break;
+        case CONTROL_PARAM_GATE_DUTY:         *value = to_milli(trance_gate_get_duty()); break;
+#endif
+        default:
+            if (id >= CONTROL_PARAM_BAND_REPEAT_0 && id < CONTROL_PARAM_BAND_REPEAT_0 + CROSSOVER_MAX_BANDS) {
+                *value = p->band_repeat[id - CONTROL_PARAM_BAND_REPEAT_0];
+                break;
+            }
+            if (id >= CONTROL_PARAM_BAND_MIX_0 && id < CONTROL_PARAM_BAND_MIX_0 + CROSSOVER_MAX_BANDS) {
+                *value = p->band_mix[id - CONTROL_PARAM_BAND_MIX_0];
+                break;
+            }
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief テンポを設定し、スライス長を現在の音符の長さに合わせる
+ */
+static void apply_tempo(beat_repeat_params_t *p, float bpm, note_division_t division) {
+    if (bpm < MIN_BPM || bpm > MAX_BPM) return;
+
+    beat_clock_set_bpm(bpm);
+    uint64_t slice_length_q32 = tap_tempo_bpm_to_slice_length_q32(bpm, division, AUDIO_SAMPLE_RATE);
+    p->slice_length = (uint32_t)(slice_length_q32 >> 32);
+    p->slice_length_frac = (uint32_t)slice_length_q32;
+}
+
+// ============================================================================
+// メッセージ処理
+// ============================================================================
+
+static void handle_param_set(uint8_t seq, const uint8_t *payload, uint16_t len) {
+    if (len == 0 || len % 5 != 0) {
+        send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_LENGTH);
+        return;
+    }
+
+    // フレーム内の設定をまとめて適用する（エフェクトの検証・再計算は1回）
+    beat_repeat_params_t params;
+    audio_effect_get_params(&params);
+    bool effect_changed = false;
+    control_status_t status = CONTROL_STATUS_OK;
+
+    for (uint16_t i = 0; i < len; i += 5) {
+        uint8_t id = payload[i];
+        int32_t value = get_i32(&payload[i + 1]);
+
+        if (set_effect_param(&params, id, value)) {
+            effect_changed = true;
+        } else if (id == CONTROL_PARAM_BPM) {
+            apply_tempo(&params, (float)value / 100.0f, tap_tempo_get_note_division());
+            effect_changed = true;
+        } else if (id == CONTROL_PARAM_NOTE_DIVISION) {
+            if (value < NOTE_WHOLE || value > NOTE_THIRTY_SECOND) {
+                status = CONTROL_STATUS_UNKNOWN_PARAM;
+                continue;
+            }
+            tap_tempo_set_note_division((note_division_t)value);
+            apply_tempo(&params, beat_clock_get_bpm(), (note_division_t)value);
+            effect_changed = true;
+#if LOUDNESS_METER_ENABLED
+        } else if (id == CONTROL_PARAM_AGC_ENABLED) {
+            loudness_set_agc_enabled(value != 0);
+#endif
+#if VARISPEED_ENABLED
+        } else if (id == CONTROL_PARAM_VARISPEED) {
+            // スライス長とビートクロックは速度の変化に合わせてメインループで追従する
+            varispeed_set_speed(from_milli(value));
+#endif
+#if TRANCE_GATE_ENABLED
+        } else if (id == CONTROL_PARAM_GATE_ENABLED) {
+            trance_gate_set_enabled(value != 0);
+        } else if (id == CONTROL_PARAM_GATE_DEPTH) {
+            trance_gate_set_depth(from_milli(value));
+        } else if (id == CONTROL_PARAM_GATE_RATE) {
+            trance_gate_set_rate((uint32_t)value);
+        } else if (id == CONTROL_PARAM_GATE_DUTY) {
+            trance_gate_set_duty(from_milli(value));
+#endif
+        } else {
+            status = CONTROL_STATUS_UNKNOWN_PARAM;
+        }
+    }
+
+    if (effect_changed) {
+        audio_effect_update_params(&params);
+    }
+    // 自動化の帯域を使わないよう、成功時は応答しない
+    if (status != CONTROL_STATUS_OK) {
+        send_status(CONTROL_MSG_NACK, seq, status);
+    }
+}
+
+static void handle_param_get(uint8_t seq, const uint8_t *payload, uint16_t len) {
+    if (len == 0 || len > (CONTROL_FRAME_MAX_MSG - 2) / 5) {
+        send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_LENGTH);
+        return;
+    }
+
+    beat_repeat_params_t params;
+    audio_effect_get_params(&params);
+
+    uint8_t msg[CONTROL_FRAME_MAX_MSG];
+    msg[0] = CONTROL_MSG_PARAM_VALUE;
+    msg[1] = seq;
+    uint16_t o = 2;
+    for (uint16_t i = 0; i < len; i++) {
+        int32_t value;
+        if (!get_param(&params, payload[i], &value)) {
+            send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_UNKNOWN_PARAM);
+            return;
+        }
+        msg[o] = payload[i];
+        put_u32(&msg[o + 1], (uint32_t)value);
+        o += 5;
+    }
+    send_message(msg, o);
+}
+
+static void handle_preset(uint8_t type, uint8_t seq, const uint8_t *payload, uint16_t len) {
+    if (len != 1) {
+        send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_LENGTH);
+        return;
+    }
+    uint8_t slot = payload[0];
+    if (slot >= CONTROL_NUM_PRESETS) {
+        send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_SLOT);
+        return;
+    }
+
+    if (type == CONTROL_MSG_PRESET_STORE) {
+        audio_effect_get_params(&presets[slot]);
+    } else {
+        // テンポは現在のものを保つ（プリセットは音色、テンポは曲に従う）
+        beat_repeat_params_t params = presets[slot];
+        apply_tempo(&params, beat_clock_get_bpm(), tap_tempo_get_note_division());
+        audio_effect_set_params(&params);
+    }
+    send_status(CONTROL_MSG_ACK, seq, CONTROL_STATUS_OK);
+}
+
+static control_status_t handle_trigger(uint8_t event, uint8_t arg, int16_t value) {
+    (void)arg;     // サンプラー / ルーパーが無効な構成では使わない
+    (void)value;
+
+    switch (event) {
+#if SAMPLER_ENABLED
+        case CONTROL_EVENT_SAMPLER_TRIGGER:
+            return (sampler_trigger(arg, (float)value / 1000.0f) >= 0) ?
+                CONTROL_STATUS_OK : CONTROL_STATUS_UNAVAILABLE;
+        case CONTROL_EVENT_SAMPLER_STOP:
+            sampler_stop_all();
+            return CONTROL_STATUS_OK;
+#endif
+#if LOOPER_ENABLED
+        case CONTROL_EVENT_LOOPER_RECORD:
+            return looper_record(arg) ? CONTROL_STATUS_OK : CONTROL_STATUS_UNAVAILABLE;
+        case CONTROL_EVENT_LOOPER_OVERDUB:
+            looper_set_overdub(arg != 0);
+            return CONTROL_STATUS_OK;
+        case CONTROL_EVENT_LOOPER_CLEAR:
+            looper_clear();
+            return CONTROL_STATUS_OK;
+#endif
+        case CONTROL_EVENT_MOD_TRIGGER:
+            mod_matrix_trigger();
+            return CONTROL_STATUS_OK;
+        case CONTROL_EVENT_BEAT_SYNC:
+            beat_clock_sync();
+            return CONTROL_STATUS_OK;
+#if RECORDER_ENABLED
+        case CONTROL_EVENT_RECORD_START:
+            return recorder_start() ? CONTROL_STATUS_OK : CONTROL_STATUS_UNAVAILABLE;
+        case CONTROL_EVENT_RECORD_STOP:
+            recorder_stop();
+            return CONTROL_STATUS_OK;
+#endif
+#if !SAMPLER_ENABLED
+        case CONTROL_EVENT_SAMPLER_TRIGGER:
+        case CONTROL_EVENT_SAMPLER_STOP:
+            return CONTROL_STATUS_UNAVAILABLE;
+#endif
+#if !LOOPER_ENABLED
+        case CONTROL_EVENT_LOOPER_RECORD:
+        case CONTROL_EVENT_LOOPER_OVERDUB:
+        case CONTROL_EVENT_LOOPER_CLEAR:
+            return CONTROL_STATUS_UNAVAILABLE;
+#endif
+#if !RECORDER_ENABLED
+        case CONTROL_EVENT_RECORD_START:
+        case CONTROL_EVENT_RECORD_STOP:
+            return CONTROL_STATUS_UNAVAILABLE;
+#endif
+        default:
+            return CONTROL_STATUS_UNKNOWN_EVENT;
+    }
+}
+
+static void handle_message(const uint8_t *msg, uint16_t len) {
+    if (len < 2) {
+        length_errors++;
+        return;
+    }
+    uint8_t type = msg[0];
+    uint8_t seq = msg[1];
+    const uint8_t *payload = &msg[2];
+    uint16_t payload_len = len - 2;
+
+    switch (type) {
+        case CONTROL_MSG_PARAM_SET:
+            handle_param_set(seq, payload, payload_len);
+            break;
+
+        case CONTROL_MSG_PARAM_GET:
+            handle_param_get(seq, payload, payload_len);
+            break;
+
+        case CONTROL_MSG_PRESET_RECALL:
+        case CONTROL_MSG_PRESET_STORE:
+            handle_preset(type, seq, payload, payload_len);
+            break;
+
+        case CONTROL_MSG_TRIGGER: {
+            if (payload_len != 4) {
+                send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_LENGTH);
+                break;
+            }
+            control_status_t status = handle_trigger(payload[0], payload[1], (int16_t)get_u16(&payload[2]));
+            send_status((status == CONTROL_STATUS_OK) ? CONTROL_MSG_ACK : CONTROL_MSG_NACK, seq, status);
+            break;
+        }
+
+        case CONTROL_MSG_TELEMETRY:
+            if (payload_len != 2) {
+                send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_LENGTH);
+                break;
+            }
+            telemetry_interval_ms = get_u16(payload);
+            if (telemetry_interval_ms > 0 && telemetry_interval_ms < CONTROL_TELEMETRY_MIN_INTERVAL_MS) {
+                telemetry_interval_ms = CONTROL_TELEMETRY_MIN_INTERVAL_MS;
+            }
+            last_telemetry_time = get_absolute_time();
+            send_status(CONTROL_MSG_ACK, seq, CONTROL_STATUS_OK);
+            break;
+
+        case CONTROL_MSG_PING: {
+            uint8_t pong[3] = { CONTROL_MSG_PONG, seq, CONTROL_PROTOCOL_VERSION };
+            send_message(pong, sizeof(pong));
+            break;
+        }
+
+        case CONTROL_MSG_TRACE_DUMP:
+#if TRACE_ENABLED
+            if (trace_is_dumping()) {
+                send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_UNAVAILABLE);
+                break;
+            }
+            send_status(CONTROL_MSG_ACK, seq, CONTROL_STATUS_OK);
+            trace_dump_start();
+#else
+            send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_UNAVAILABLE);
+#endif
+            break;
+
+        case CONTROL_MSG_GATE_PATTERN:
+#if TRANCE_GATE_ENABLED
+            if (payload_len == 0 || payload_len > TRANCE_GATE_MAX_STEPS) {
+                send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_BAD_LENGTH);
+                break;
+            }
+            trance_gate_set_pattern(payload, payload_len);
+            send_status(CONTROL_MSG_ACK, seq, CONTROL_STATUS_OK);
+#else
+            send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_UNAVAILABLE);
+#endif
+            break;
+
+        default:
+            send_status(CONTROL_MSG_NACK, seq, CONTROL_STATUS_UNKNOWN_MSG);
+            break;
+    }
+}
+
+// ============================================================================
+// テレメトリー
+// ============================================================================
+
+static void collect_telemetry(control_telemetry_t *t) {
+    memset(t, 0, sizeof(*t));
+
+    t->time_ms = to_ms_since_boot(get_absolute_time());
+    t->ring_frames = audio_out_i2s_get_buffered_samples();
+    t->target_frames = audio_out_i2s_get_target_depth();
+    audio_out_i2s_get_stats(&t->underruns, &t->overruns);
+#if DELAY_REPORT_ENABLED
+    t->delay_100us = delay_report_get_last_sent();
+#endif
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    link_monitor_stats_t link;
+    link_monitor_get_stats(&link);
+    t->jitter_us = (uint16_t)((link.jitter_us > 0xFFFF) ? 0xFFFF : link.jitter_us);
+    t->rssi_dbm = link.rssi_dbm;
+#endif
+
+    beat_repeat_params_t params;
+    audio_effect_get_params(&params);
+    t->flags = (uint8_t)((bt_audio_is_connected() ? 0x01 : 0) |
+                         (params.enabled ? 0x02 : 0) |
+                         (params.freeze ? 0x04 : 0) |
+                         (recorder_get_state() == RECORDER_STATE_RECORDING ? 0x08 : 0));
+    t->bpm_x100 = (uint16_t)lroundf(beat_clock_get_bpm() * 100.0f);
+#if LOUDNESS_METER_ENABLED
+    float lufs = loudness_get_short_term();
+    if (lufs < -3000.0f || lufs != lufs) lufs = -3000.0f;
+    t->loudness_x10 = (int16_t)lroundf(lufs * 10.0f);
+#endif
+    control_get_stats(&t->rx_frames, &t->rx_errors);
+}
+
+static void send_telemetry(void) {
+    control_telemetry_t t;
+    collect_telemetry(&t);
+
+    uint8_t msg[CONTROL_FRAME_MAX_MSG];
+    uint16_t o = 0;
+    msg[o++] = CONTROL_MSG_TELEMETRY_DATA;
+    msg[o++] = 0;
+    put_u32(&msg[o], t.time_ms);         o += 4;
+    put_u32(&msg[o], t.ring_frames);     o += 4;
+    put_u32(&msg[o], t.target_frames);   o += 4;
+    put_u32(&msg[o], t.underruns);       o += 4;
+    put_u32(&msg[o], t.overruns);        o += 4;
+    put_u16(&msg[o], t.delay_100us);     o += 2;
+    put_u16(&msg[o], t.jitter_us);       o += 2;
+    msg[o++] = (uint8_t)t.rssi_dbm;
+    msg[o++] = t.flags;
+    put_u16(&msg[o], t.bpm_x100);        o += 2;
+    put_u16(&msg[o], (uint16_t)t.loudness_x10); o += 2;
+    put_u32(&msg[o], t.rx_frames);       o += 4;
+    put_u32(&msg[o], t.rx_errors);       o += 4;
+    send_message(msg, o);
+}
+
+// ============================================================================
+// 公開関数
+// ============================================================================
+
+void control_init(void) {
+    control_decoder_init(&decoder);
+
+    beat_repeat_params_t params;
+    audio_effect_get_params(&params);
+    for (int i = 0; i < CONTROL_NUM_PRESETS; i++) {
+        presets[i] = params;
+    }
+
+    telemetry_interval_ms = 0;
+    last_telemetry_time = get_absolute_time();
+    length_errors = 0;
+
+    printf("[CONTROL] Binary protocol v%d on USB CDC (COBS + CRC-16, %d presets)\n",
+           CONTROL_PROTOCOL_VERSION, CONTROL_NUM_PRESETS);
+}
+
+void control_poll(void) {
+    for (int i = 0; i < CONTROL_RX_BUDGET; i++) {
+        int c = getchar_timeout_us(0);
+        if (c == PICO_ERROR_TIMEOUT || c < 0) {
+            break;
+        }
+
+        const uint8_t *msg;
+        uint16_t len;
+        if (control_decoder_feed(&decoder, (uint8_t)c, &msg, &len)) {
+            handle_message(msg, len);
+        }
+    }
+
+    if (telemetry_interval_ms > 0) {
+        absolute_time_t now = get_absolute_time();
+        if (absolute_time_diff_us(last_telemetry_time, now) >= (int64_t)telemetry_interval_ms * 1000) {
+            last_telemetry_time = now;
+            send_telemetry();
+        }
+    }
+}
+
+void control_get_stats(uint32_t *frames, uint32_t *errors) {
+    if (frames) *frames = decoder.stats.frames;
+    if (errors) {
+        *errors = decoder.stats.crc_errors + decoder.stats.overflows +
+                  decoder.stats.framing_errors + length_errors;
+    }
+}
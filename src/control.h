@@ -0,0 +1,159 @@
+/**
+ * @file control.h
+ * @brief USB CDC のバイナリ制御・テレメトリープロトコル - ヘッダーファイル
+ *
+ * フレーミングは control_frame（COBS + CRC-16）。メッセージは
+ *   [type:u8] [seq:u8] [payload...]
+ * 数値はすべてリトルエンディアン。応答は要求の seq を返す。
+ *
+ * ホスト → デバイス:
+ *   PARAM_SET      { id:u8, value:i32 } × N（1フレームに最大 12 個、応答なし・エラー時のみ NACK）
+ *   PARAM_GET      { id:u8 } × N       → PARAM_VALUE
+ *   PRESET_RECALL  { slot:u8 }          → ACK
+ *   PRESET_STORE   { slot:u8 }          → ACK
+ *   TRIGGER        { event:u8, arg:u8, value:i16 } → ACK
+ *   TELEMETRY      { interval_ms:u16 }  → ACK（0 = 停止）
+ *   PING           {}                   → PONG { protocol_version:u8 }
+ *   TRACE_DUMP     {}                   → ACK、続けてトレースをテキストでダンプ（trace.h）
+ *   GATE_PATTERN   { level:u8 } × N     → ACK（トランスゲートのステップごとの開き具合 0-100 %）
+ * デバイス → ホスト:
+ *   ACK / NACK { status:u8 }、PARAM_VALUE { id:u8, value:i32 } × N、
+ *   TELEMETRY_DATA（control_telemetry_t の順にパック）
+ *
+ * 受信と処理はメインループ（control_poll）で行い、オーディオの処理経路には入らない。
+ * PARAM_SET はフレーム単位でまとめて適用するので、kHz 単位の自動化でもログや
+ * 再計算はフレームごとに1回で済む。
+ */
+
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CONTROL_PROTOCOL_VERSION  1
+
+/**
+ * @brief メッセージの種類
+ */
+typedef enum {
+    CONTROL_MSG_PARAM_SET      = 0x01,
+    CONTROL_MSG_PARAM_GET      = 0x02,
+    CONTROL_MSG_PRESET_RECALL  = 0x03,
+    CONTROL_MSG_PRESET_STORE   = 0x04,
+    CONTROL_MSG_TRIGGER        = 0x05,
+    CONTROL_MSG_TELEMETRY      = 0x06,
+    CONTROL_MSG_PING           = 0x07,
+    CONTROL_MSG_TRACE_DUMP     = 0x08,
+    CONTROL_MSG_GATE_PATTERN   = 0x09,
+
+    CONTROL_MSG_ACK            = 0x80,
+    CONTROL_MSG_NACK           = 0x81,
+    CONTROL_MSG_PARAM_VALUE    = 0x82,
+    CONTROL_MSG_TELEMETRY_DATA = 0x83,
+    CONTROL_MSG_PONG           = 0x84,
+} control_msg_t;
+
+/**
+ * @brief NACK の理由
+ */
+typedef enum {
+    CONTROL_STATUS_OK = 0,
+    CONTROL_STATUS_UNKNOWN_MSG,
+    CONTROL_STATUS_BAD_LENGTH,
+    CONTROL_STATUS_UNKNOWN_PARAM,
+    CONTROL_STATUS_BAD_SLOT,
+    CONTROL_STATUS_UNKNOWN_EVENT,
+    CONTROL_STATUS_UNAVAILABLE,      // 機能が無効（config.h）または実行できない状態
+} control_status_t;
+
+/**
+ * @brief パラメータ ID（値は i32、比率は 1/1000 単位）
+ */
+typedef enum {
+    CONTROL_PARAM_EFFECT_ENABLED    = 0x01,
+    CONTROL_PARAM_WET_MIX           = 0x02,   // 0-100 %
+    CONTROL_PARAM_REPEAT_COUNT      = 0x03,
+    CONTROL_PARAM_SLICE_LENGTH      = 0x04,   // フレーム
+    CONTROL_PARAM_PITCH_SHIFT       = 0x05,   // 1/1000（1000 = 原音）
+    CONTROL_PARAM_REVERSE           = 0x06,
+    CONTROL_PARAM_STUTTER_ENABLED   = 0x07,
+    CONTROL_PARAM_STUTTER_LENGTH    = 0x08,   // フレーム
+    CONTROL_PARAM_WINDOW_SHAPE      = 0x09,   // 1/1000
+    CONTROL_PARAM_LOOP_START        = 0x0A,   // 1/1000
+    CONTROL_PARAM_LOOP_SIZE_DECAY   = 0x0B,   // 1/1000
+    CONTROL_PARAM_SLICE_PROBABILITY = 0x0C,   // 1/1000
+    CONTROL_PARAM_CLOCK_DIVIDER     = 0x0D,
+    CONTROL_PARAM_PITCH_MODE        = 0x0E,
+    CONTROL_PARAM_FREEZE            = 0x0F,
+    CONTROL_PARAM_DUCK_ENABLED      = 0x10,
+    CONTROL_PARAM_SLICER_ENABLED    = 0x11,
+    CONTROL_PARAM_SLICER_PATTERN    = 0x12,
+    CONTROL_PARAM_MULTIBAND_ENABLED = 0x13,
+    CONTROL_PARAM_BAND_REPEAT_0     = 0x14,   // 0x14-0x16: 帯域ごと（低域から）
+    CONTROL_PARAM_BAND_MIX_0        = 0x17,   // 0x17-0x19: 帯域ごと 0-100 %
+    CONTROL_PARAM_REPEAT_TRIGGER    = 0x1A,   // 0 = 確率, 1 = トランジェント
+    CONTROL_PARAM_TRANSIENT_THRESHOLD = 0x1B, // 1/1000（速い/遅い エンベロープの比）
+    CONTROL_PARAM_TRANSIENT_REFRACTORY = 0x1C, // ms
+    CONTROL_PARAM_BPM               = 0x20,   // 1/100 BPM（スライス長も音符の長さに合わせる）
+    CONTROL_PARAM_NOTE_DIVISION     = 0x21,
+    CONTROL_PARAM_AGC_ENABLED       = 0x22,
+    CONTROL_PARAM_VARISPEED         = 0x23,   // 1/1000（1000 = 原速、±VARISPEED_RANGE_PERMILLE）
+    CONTROL_PARAM_GATE_ENABLED      = 0x24,
+    CONTROL_PARAM_GATE_DEPTH        = 0x25,   // 1/1000
+    CONTROL_PARAM_GATE_RATE         = 0x26,   // 1拍あたりのステップ数（1, 2, 4, 8）
+    CONTROL_PARAM_GATE_DUTY         = 0x27,   // 1/1000
+} control_param_t;
+
+/**
+ * @brief トリガーイベント
+ */
+typedef enum {
+    CONTROL_EVENT_SAMPLER_TRIGGER = 0x01,   // arg = サンプル番号, value = ゲイン 1/1000
+    CONTROL_EVENT_SAMPLER_STOP    = 0x02,
+    CONTROL_EVENT_LOOPER_RECORD   = 0x03,   // arg = 小節数
+    CONTROL_EVENT_LOOPER_OVERDUB  = 0x04,   // arg = 0/1
+    CONTROL_EVENT_LOOPER_CLEAR    = 0x05,
+    CONTROL_EVENT_MOD_TRIGGER     = 0x06,   // エンベロープの再トリガー
+    CONTROL_EVENT_BEAT_SYNC       = 0x07,   // ビートクロックの位相を小節頭にそろえる
+    CONTROL_EVENT_RECORD_START    = 0x08,   // SD カード録音を次の未使用ファイルに開始
+    CONTROL_EVENT_RECORD_STOP     = 0x09,
+} control_event_t;
+
+/**
+ * @brief テレメトリー（TELEMETRY_DATA のペイロード、この順に LE でパック）
+ */
+typedef struct {
+    uint32_t time_ms;
+    uint32_t ring_frames;        // 出力リングのフィル
+    uint32_t target_frames;      // 目標深さ（0 = 固定）
+    uint32_t underruns;
+    uint32_t overruns;
+    uint16_t delay_100us;        // ソースに報告した遅延
+    uint16_t jitter_us;          // 到着ジッター
+    int8_t rssi_dbm;
+    uint8_t flags;               // bit0 接続中, bit1 エフェクト有効, bit2 フリーズ, bit3 録音中
+    uint16_t bpm_x100;
+    int16_t loudness_x10;        // ショートターム LUFS × 10
+    uint32_t rx_frames;          // 受信した制御フレーム
+    uint32_t rx_errors;          // CRC / 長さ / COBS のエラー
+} control_telemetry_t;
+
+/**
+ * @brief 初期化（プリセットは全スロットを現在のパラメータで埋める）
+ */
+void control_init(void);
+
+/**
+ * @brief 受信したバイトを処理し、テレメトリーの送信時刻なら送る（メインループから呼ぶ）
+ */
+void control_poll(void);
+
+/**
+ * @brief 受信統計を取得
+ * @param frames 正しく受信したフレーム数
+ * @param errors CRC / 長さ / COBS のエラー数
+ */
+void control_get_stats(uint32_t *frames, uint32_t *errors);
+
+#endif // CONTROL_H
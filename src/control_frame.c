@@ -0,0 +1,145 @@
+/**
+ * @file control_frame.c
+ * @brief 制御プロトコルのフレーミング（COBS + CRC-16）の実装
+ *
+ * COBS: データを「次の 0x00 までの距離」を表すコードバイトで始まるブロックに分ける。
+ * コード 0xFF のブロックは 254 バイトのデータだけで、後ろに 0x00 を伴わない。
+ * それ以外のブロックの後ろには 0x00 があるが、メッセージ末尾の分は存在しない。
+ */
+
+#include "control_frame.h"
+
+#include <string.h>
+
+// ============================================================================
+// CRC-16/CCITT-FALSE
+// ============================================================================
+
+// 4ビットずつのテーブル（32バイト、フレームが短いのでこれで十分）
+static const uint16_t crc_nibble_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t control_crc16(const uint8_t *data, uint32_t len) {
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ crc_nibble_table[((crc >> 12) ^ (data[i] >> 4)) & 0x0F]);
+        crc = (uint16_t)((crc << 4) ^ crc_nibble_table[((crc >> 12) ^ (data[i] & 0x0F)) & 0x0F]);
+    }
+    return crc;
+}
+
+// ============================================================================
+// デコーダー
+// ============================================================================
+
+void control_decoder_init(control_decoder_t *dec) {
+    memset(dec, 0, sizeof(*dec));
+}
+
+static void restart_frame(control_decoder_t *dec) {
+    dec->len = 0;
+    dec->code = 0;
+    dec->remaining = 0;
+    dec->pending_zero = false;
+    dec->discard = false;
+}
+
+static bool append(control_decoder_t *dec, uint8_t byte) {
+    if (dec->len >= sizeof(dec->buf)) {
+        dec->stats.overflows++;
+        dec->discard = true;
+        return false;
+    }
+    dec->buf[dec->len++] = byte;
+    return true;
+}
+
+bool control_decoder_feed(control_decoder_t *dec, uint8_t byte, const uint8_t **msg, uint16_t *len) {
+    if (byte == 0x00) {
+        // 区切り: フレームの終わり（末尾ブロックの 0x00 は存在しないので捨てる）
+        bool ok = false;
+        if (dec->discard) {
+            // オーバーフローしたフレームは数え済み
+        } else if (dec->remaining != 0) {
+            dec->stats.framing_errors++;
+        } else if (dec->len >= 3) {
+            uint16_t body = dec->len - 2;
+            uint16_t rx_crc = (uint16_t)(dec->buf[body] | (dec->buf[body + 1] << 8));
+            if (control_crc16(dec->buf, body) == rx_crc) {
+                dec->stats.frames++;
+                *msg = dec->buf;
+                *len = body;
+                ok = true;
+            } else {
+                dec->stats.crc_errors++;
+            }
+        } else if (dec->len > 0) {
+            dec->stats.crc_errors++;
+        }
+        restart_frame(dec);
+        return ok;
+    }
+
+    if (dec->discard) {
+        return false;
+    }
+
+    if (dec->remaining == 0) {
+        // コードバイト: 前のブロックの 0x00 を確定してから新しいブロックへ
+        if (dec->pending_zero && !append(dec, 0x00)) {
+            return false;
+        }
+        dec->code = byte;
+        dec->remaining = (uint8_t)(byte - 1);
+        dec->pending_zero = (dec->remaining == 0) && (byte != 0xFF);
+        return false;
+    }
+
+    if (!append(dec, byte)) {
+        return false;
+    }
+    if (--dec->remaining == 0) {
+        dec->pending_zero = (dec->code != 0xFF);
+    }
+    return false;
+}
+
+// ============================================================================
+// エンコーダー
+// ============================================================================
+
+uint32_t control_frame_encode(const uint8_t *msg, uint16_t len, uint8_t *out) {
+    if (len > CONTROL_FRAME_MAX_MSG) {
+        return 0;
+    }
+
+    uint16_t crc = control_crc16(msg, len);
+    uint32_t total = (uint32_t)len + 2;
+
+    uint32_t o = 0;
+    out[o++] = 0x00;
+
+    uint32_t code_pos = o++;
+    uint8_t code = 1;
+    for (uint32_t i = 0; i < total; i++) {
+        uint8_t b = (i < len) ? msg[i] : (uint8_t)((i == len) ? crc : crc >> 8);
+        if (b == 0x00) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        } else {
+            out[o++] = b;
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+
+    out[o++] = 0x00;
+    return o;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file control_frame.h
+ * @brief 制御プロトコルのフレーミング（COBS + CRC-16） - ヘッダーファイル
+ *
+ * 回線上のフレーム:
+ *   0x00 | COBS( メッセージ | CRC-16 (LE) ) | 0x00
+ * CRC は CRC-16/CCITT-FALSE（多項式 0x1021、初期値 0xFFFF）。
+ * 先頭にも区切りの 0x00 を置くので、同じ USB CDC に流れる printf のテキスト
+ * （0x00 を含まない）は壊れたフレーム（ほとんどは COBS のフレーミングエラー）として
+ * 捨てられ、次のフレームは必ず拾える。
+ *
+ * デコーダーは1バイトずつ受け取って COBS をその場で戻すインクリメンタル方式。
+ * 状態はすべて control_decoder_t の中にあり、動的メモリは使わない。
+ * SDK に依存しない（ホストでもそのままビルドできる）。
+ */
+
+#ifndef CONTROL_FRAME_H
+#define CONTROL_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// メッセージの最大長（CRC を含まない）
+#define CONTROL_FRAME_MAX_MSG      64
+
+// エンコード後の最大長（COBS のオーバーヘッド + CRC + 区切り2つ）
+#define CONTROL_FRAME_MAX_ENCODED  (CONTROL_FRAME_MAX_MSG + 2 + (CONTROL_FRAME_MAX_MSG + 2) / 254 + 1 + 2)
+
+/**
+ * @brief デコーダーの統計
+ */
+typedef struct {
+    uint32_t frames;         // 正しく受信したフレーム数
+    uint32_t crc_errors;     // CRC 不一致
+    uint32_t overflows;      // 最大長を超えたフレーム
+    uint32_t framing_errors; // COBS のブロックが途中で終わったフレーム（テキストの断片の多く）
+} control_decoder_stats_t;
+
+/**
+ * @brief インクリメンタルデコーダーの状態
+ */
+typedef struct {
+    uint8_t buf[CONTROL_FRAME_MAX_MSG + 2];   // 戻したメッセージ + CRC
+    uint16_t len;
+    uint8_t code;            // 現在の COBS ブロックのコード
+    uint8_t remaining;       // ブロックの残りバイト数
+    bool pending_zero;       // ブロックの終わりの 0x00（次のブロックが来たら確定）
+    bool discard;            // 次の区切りまで捨てる（オーバーフロー後）
+    control_decoder_stats_t stats;
+} control_decoder_t;
+
+/**
+ * @brief CRC-16/CCITT-FALSE を計算
+ */
+uint16_t control_crc16(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief デコーダーを初期化
+ */
+void control_decoder_init(control_decoder_t *dec);
+
+/**
+ * @brief 1バイトを取り込む
+ * @param dec デコーダー
+ * @param byte 受信バイト
+ * @param msg 完成したメッセージ（CRC を除く、dec->buf を指す。次の呼び出しまで有効）
+ * @param len メッセージ長
+ * @return true CRC の合ったフレームが完成した
+ */
+bool control_decoder_feed(control_decoder_t *dec, uint8_t byte, const uint8_t **msg, uint16_t *len);
+
+/**
+ * @brief メッセージをフレームにエンコード（CRC の付加、COBS、前後の区切り）
+ * @param msg メッセージ
+ * @param len メッセージ長（CONTROL_FRAME_MAX_MSG 以下）
+ * @param out 出力（CONTROL_FRAME_MAX_ENCODED バイト以上）
+ * @return 出力したバイト数（len が長すぎれば 0）
+ */
+uint32_t control_frame_encode(const uint8_t *msg, uint16_t len, uint8_t *out);
+
+#endif // CONTROL_FRAME_H
@@ -0,0 +1,100 @@
+/**
+ * @file crossover.h
+ * @brief Linkwitz-Riley（LR4）クロスオーバーによる帯域別ミックス（固定小数点）- ヘッダーファイル
+ *
+ * エフェクト出力（ドライ/ウェットのミックス）とドライ入力から、帯域ごとに
+ * エフェクトの掛かり具合を変えた出力を作る。
+ *   出力 = Σ_b [ ドライ_b + 重み_b × (エフェクト出力_b - ドライ_b) ]
+ *
+ * LR4 のローパス（2次バターワース × 2段）と同じ極を持つ2次オールパスを使い、
+ * ハイパス = オールパス - ローパス とする。帯域の和は構造上オールパスと一致するので、
+ * 係数の量子化に関係なく振幅特性はフラットになる（重みがすべて 0 でも 1 でも）。
+ *
+ * 線形性を使って計算量を減らしている（チャンネルあたりのバイクアッド数）:
+ *   2帯域: 出力 = AP1(ドライ + w_H·d) + (w_L - w_H)·LP1(d)                     → 3
+ *   3帯域: 出力 = AP2(AP1(ドライ + w_H·d) + (w_L - w_H)·LP1(d)) + (w_M - w_H)·LP2(残り)  → 7
+ *   （d = エフェクト出力 - ドライ、残り = AP1(d) - LP1(d)）
+ */
+
+#ifndef CROSSOVER_H
+#define CROSSOVER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CROSSOVER_MAX_BANDS  3
+
+// 帯域の重み 1.0（Q16）
+#define CROSSOVER_UNITY_GAIN  (1 << 16)
+
+/**
+ * @brief バイクアッド係数（Q28）
+ */
+typedef struct {
+    int32_t b0, b1, b2;
+    int32_t a1, a2;
+} crossover_coeffs_t;
+
+/**
+ * @brief バイクアッドの状態（Direct Form I、信号は Q12 拡張）
+ */
+typedef struct {
+    int32_t x1, x2;
+    int32_t y1, y2;
+} crossover_biquad_t;
+
+/**
+ * @brief 1チャンネル分のフィルタ状態
+ */
+typedef struct {
+    crossover_biquad_t lp1[2];   // 低域側エッジの LR4 ローパス（d）
+    crossover_biquad_t ap1_diff; // 低域側エッジのオールパス（d、3帯域のみ）
+    crossover_biquad_t ap1_mix;  // 低域側エッジのオールパス（ドライ + w_H·d）
+    crossover_biquad_t lp2[2];   // 高域側エッジの LR4 ローパス（残り、3帯域のみ）
+    crossover_biquad_t ap2;      // 高域側エッジのオールパス（3帯域のみ）
+} crossover_channel_t;
+
+/**
+ * @brief クロスオーバーの状態
+ */
+typedef struct {
+    uint8_t num_bands;                             // 2 または 3
+    crossover_coeffs_t lp[CROSSOVER_MAX_BANDS - 1];  // エッジごとのローパス
+    crossover_coeffs_t ap[CROSSOVER_MAX_BANDS - 1];  // エッジごとのオールパス
+    int32_t band_gain_q16[CROSSOVER_MAX_BANDS];    // 帯域の重み（低域から、Q16）
+    crossover_channel_t channel[2];
+} crossover_t;
+
+/**
+ * @brief クロスオーバーを初期化（重みはすべて 1.0）
+ * @param xo クロスオーバー状態
+ * @param num_bands 帯域数（2 または 3）
+ * @param edges_hz クロスオーバー周波数（num_bands - 1 個、昇順）
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void crossover_init(crossover_t *xo, uint8_t num_bands, const float *edges_hz, uint32_t sample_rate);
+
+/**
+ * @brief 帯域の重みを設定
+ * @param xo クロスオーバー状態
+ * @param gain_q16 重み（num_bands 個、低域から、Q16: 0 = ドライ、65536 = エフェクト出力のまま）
+ */
+void crossover_set_band_gains(crossover_t *xo, const int32_t *gain_q16);
+
+/**
+ * @brief 帯域ごとに重み付けしたミックスを作る
+ * @param xo クロスオーバー状態
+ * @param ch チャンネル（0 = L, 1 = R）
+ * @param dry ドライ入力
+ * @param mix エフェクト出力（上書き）
+ * @param num_samples サンプル数
+ */
+void crossover_process(crossover_t *xo, int ch, const int16_t *dry, int16_t *mix,
+                       uint32_t num_samples);
+
+/**
+ * @brief フィルタ状態をリセット
+ */
+void crossover_reset(crossover_t *xo);
+
+#endif // CROSSOVER_H
@@ -0,0 +1,96 @@
+/**
+ * @file delay_report.c
+ * @brief A2DP 遅延レポートの遅延計算の実装
+ */
+
+#include "delay_report.h"
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define DELAY_MAX_100US   0xFFFF
+
+// 平滑化した遅延の小数ビット数
+#define SMOOTH_BITS       8
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static uint32_t hysteresis = 0;        // 1/10 ms
+static uint32_t min_interval = 0;      // ms
+static uint32_t smoothing_n = 1;
+
+static bool has_sample = false;
+static uint32_t smoothed_q8 = 0;       // 平滑化した遅延（1/10 ms、Q8）
+
+static bool has_sent = false;
+static uint16_t last_sent = 0;
+static uint32_t last_sent_ms = 0;
+
+// ============================================================================
+// 公開関数
+// ============================================================================
+
+void delay_report_init(uint32_t hysteresis_100us, uint32_t min_interval_ms, uint32_t smoothing) {
+    hysteresis = hysteresis_100us;
+    min_interval = min_interval_ms;
+    smoothing_n = (smoothing > 0) ? smoothing : 1;
+    delay_report_reset();
+}
+
+void delay_report_reset(void) {
+    has_sample = false;
+    smoothed_q8 = 0;
+    has_sent = false;
+    last_sent = 0;
+    last_sent_ms = 0;
+}
+
+uint16_t delay_report_compute(const delay_report_state_t *state, uint32_t sample_rate) {
+    if (!state || sample_rate == 0) return 0;
+
+    uint64_t frames = (uint64_t)state->ring_frames + state->dma_frames + state->pipeline_frames;
+
+    // フレーム → 1/10 ms（四捨五入）
+    uint64_t delay = (frames * 10000 + sample_rate / 2) / sample_rate;
+    return (delay > DELAY_MAX_100US) ? DELAY_MAX_100US : (uint16_t)delay;
+}
+
+bool delay_report_update(const delay_report_state_t *state, uint32_t sample_rate,
+                         uint32_t now_ms, uint16_t *delay_100us) {
+    uint32_t sample_q8 = (uint32_t)delay_report_compute(state, sample_rate) << SMOOTH_BITS;
+
+    // 指数移動平均（最初のサンプルで初期化）
+    if (!has_sample) {
+        smoothed_q8 = sample_q8;
+        has_sample = true;
+    } else {
+        int32_t diff = (int32_t)sample_q8 - (int32_t)smoothed_q8;
+        smoothed_q8 = (uint32_t)((int32_t)smoothed_q8 + diff / (int32_t)smoothing_n);
+    }
+
+    uint16_t current = delay_report_get_current();
+
+    if (has_sent) {
+        uint32_t change = (current > last_sent) ? current - last_sent : last_sent - current;
+        if (change < hysteresis || (now_ms - last_sent_ms) < min_interval) {
+            return false;
+        }
+    }
+
+    has_sent = true;
+    last_sent = current;
+    last_sent_ms = now_ms;
+    if (delay_100us) *delay_100us = current;
+    return true;
+}
+
+uint16_t delay_report_get_current(void) {
+    return (uint16_t)((smoothed_q8 + (1 << (SMOOTH_BITS - 1))) >> SMOOTH_BITS);
+}
+
+uint16_t delay_report_get_last_sent(void) {
+    return last_sent;
+}
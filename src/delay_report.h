@@ -0,0 +1,72 @@
+/**
+ * @file delay_report.h
+ * @brief A2DP 遅延レポート（AVDTP Delay Reporting）の遅延計算 - ヘッダーファイル
+ *
+ * デコードしてから DAC に出るまでの遅延を、バッファの状態から求める。
+ *   出力リングのフィル + DMA バッファ + 処理チェーンの遅延
+ * パケット1つ分のデコード結果（bt_audio の PCM バッチ）はパケットハンドラーの中で
+ * 処理チェーンに流しきるので、メインループから見ると常に空で、項に含めない。
+ * リングのフィルは DMA の消費と BT のバースト受信で大きく揺れるので、指数移動平均で
+ * 平滑化し、前回の報告からヒステリシス以上変わったときだけ（最小間隔付きで）報告する。
+ *
+ * SDK に依存しない計算だけのモジュール（送信は bt_audio が行う）。
+ */
+
+#ifndef DELAY_REPORT_H
+#define DELAY_REPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief ある時点のバッファ状態（すべてフレーム数）
+ */
+typedef struct {
+    uint32_t ring_frames;       // 出力リングバッファのフィル（ジッターバッファを兼ねる）
+    uint32_t dma_frames;        // DMA バッファに積まれて出力待ちのフレーム
+    uint32_t pipeline_frames;   // 処理チェーンの遅延（先読みなど、latency_get_total）
+} delay_report_state_t;
+
+/**
+ * @brief 初期化
+ * @param hysteresis_100us 報告し直す変化量（1/10 ms 単位）
+ * @param min_interval_ms 報告の最小間隔（ms）
+ * @param smoothing 平滑化の強さ（指数移動平均の 1/N、1 = 平滑化なし）
+ */
+void delay_report_init(uint32_t hysteresis_100us, uint32_t min_interval_ms, uint32_t smoothing);
+
+/**
+ * @brief 平滑化と送信履歴をリセット（ストリーム開始時、次の更新で必ず報告する）
+ */
+void delay_report_reset(void);
+
+/**
+ * @brief バッファ状態の遅延を計算
+ * @param state バッファ状態
+ * @param sample_rate サンプリングレート（Hz）
+ * @return 遅延（1/10 ms 単位、AVDTP の単位、0xFFFF でクランプ）
+ */
+uint16_t delay_report_compute(const delay_report_state_t *state, uint32_t sample_rate);
+
+/**
+ * @brief バッファ状態を取り込み、報告すべきか判定
+ * @param state バッファ状態
+ * @param sample_rate サンプリングレート（Hz）
+ * @param now_ms 現在時刻（ms）
+ * @param delay_100us 報告する遅延の格納先（true のときのみ有効）
+ * @return true 報告する（送信済みとして記録する）
+ */
+bool delay_report_update(const delay_report_state_t *state, uint32_t sample_rate,
+                         uint32_t now_ms, uint16_t *delay_100us);
+
+/**
+ * @brief 平滑化後の現在の遅延（1/10 ms 単位、テレメトリー用）
+ */
+uint16_t delay_report_get_current(void);
+
+/**
+ * @brief 最後に報告した遅延（1/10 ms 単位、未報告なら 0）
+ */
+uint16_t delay_report_get_last_sent(void);
+
+#endif // DELAY_REPORT_H
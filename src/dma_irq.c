@@ -0,0 +1,116 @@
+/**
+ * @file dma_irq.c
+ * @brief DMA 割り込みディスパッチャー
+ *
+ * DMA_IRQ_0 の排他ハンドラーをこのモジュールだけが持ち、
+ * INTS0 のビットごとに登録済みのハンドラーへ振り分ける。
+ * 同じ割り込みで複数チャンネルが完了していた場合は、
+ * チャンネル番号の小さい順にすべて処理する。
+ * 未登録のチャンネルのフラグ（他のコードが DMA_IRQ_0 を有効にしたもの）は
+ * クリアして数えるだけにし、割り込みが鳴りっぱなしにならないようにする。
+ */
+
+#include "dma_irq.h"
+#include "config.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// チャンネルごとのハンドラー（NULL = 未登録）
+static dma_irq_handler_t handlers[NUM_DMA_CHANNELS];
+
+// ハンドラー登録済みのチャンネルのビットマップ（INTS0 と同じ並び）
+static uint32_t registered_mask = 0;
+
+// 未登録のチャンネルで立っていたフラグの数
+static volatile uint32_t stray_count = 0;
+
+// ディスパッチャーを IRQ に設定済みか
+static bool is_installed = false;
+
+// ============================================================================
+// ディスパッチャー本体
+// ============================================================================
+
+static void dma_irq_dispatch(void) {
+    uint32_t status = dma_hw->ints0;
+
+    // 未登録のチャンネルのフラグ: クリアしないと割り込みが再発し続ける
+    uint32_t stray = status & ~registered_mask;
+    while (stray) {
+        uint32_t ch = (uint32_t)__builtin_ctz(stray);
+        stray &= stray - 1;
+        dma_channel_acknowledge_irq0(ch);
+        stray_count++;
+    }
+
+    // 登録済みチャンネルの完了フラグだけを処理する
+    uint32_t pending = status & registered_mask;
+
+    while (pending) {
+        uint32_t ch = (uint32_t)__builtin_ctz(pending);
+        pending &= pending - 1;
+
+        // 先に処理したハンドラーが登録解除していたら飛ばす（IRQ0 も無効化済み）
+        dma_irq_handler_t handler = handlers[ch];
+        if (!handler) continue;
+
+        // フラグを先にクリアしてからハンドラーを呼ぶ
+        // （ハンドラー内で DMA を再起動して即座に完了しても取りこぼさない）
+        dma_channel_acknowledge_irq0(ch);
+        handler();
+    }
+}
+
+// ============================================================================
+// 登録・登録解除
+// ============================================================================
+
+bool dma_irq_register(int channel, dma_irq_handler_t handler) {
+    if (channel < 0 || channel >= NUM_DMA_CHANNELS || !handler) {
+        printf("ERROR: Invalid DMA IRQ registration (channel %d)\n", channel);
+        return false;
+    }
+    if (handlers[channel]) {
+        printf("ERROR: DMA channel %d already has an IRQ handler\n", channel);
+        return false;
+    }
+
+    handlers[channel] = handler;
+    registered_mask |= 1u << channel;
+
+    if (!is_installed) {
+        irq_set_exclusive_handler(DMA_IRQ_0, dma_irq_dispatch);
+
+        // DMA割り込み優先度を絶対最低に設定（CYW43のBluetooth処理を妨害しないため）
+        // Cortex-M33では実際には2ビット優先度（0-3）で、0xFFは最低の3にマップされる
+        irq_set_priority(DMA_IRQ_0, DMA_IRQ_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        is_installed = true;
+        printf("  DMA IRQ dispatcher installed (priority 0x%02X)\n", DMA_IRQ_PRIORITY);
+    }
+
+    dma_channel_set_irq0_enabled((uint)channel, true);
+    printf("  DMA IRQ handler registered for channel %d\n", channel);
+
+    return true;
+}
+
+void dma_irq_unregister(int channel) {
+    if (channel < 0 || channel >= NUM_DMA_CHANNELS) return;
+
+    dma_channel_set_irq0_enabled((uint)channel, false);
+    registered_mask &= ~(1u << channel);
+    handlers[channel] = NULL;
+}
+
+uint32_t dma_irq_get_stray_count(void) {
+    return stray_count;
+}
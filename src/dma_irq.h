@@ -0,0 +1,48 @@
+/**
+ * @file dma_irq.h
+ * @brief DMA 割り込みディスパッチャー - ヘッダーファイル
+ *
+ * DMA_IRQ_0 を複数の出力モジュールで共有するための仕組み。
+ * 各モジュールは自分の DMA チャンネルとハンドラーを登録するだけでよく、
+ * irq_set_exclusive_handler() を直接呼ばない。
+ */
+
+#ifndef DMA_IRQ_H
+#define DMA_IRQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief DMA 完了ハンドラーの型定義
+ * @note 割り込みフラグはディスパッチャーがクリアしてから呼び出す
+ */
+typedef void (*dma_irq_handler_t)(void);
+
+/**
+ * @brief DMA チャンネルの完了ハンドラーを登録
+ *
+ * 初回登録時に DMA_IRQ_0 にディスパッチャーを設定し、優先度を DMA_IRQ_PRIORITY にする。
+ * チャンネルの DMA_IRQ_0 割り込みも有効化する。
+ *
+ * @param channel DMA チャンネル番号
+ * @param handler 完了ハンドラー
+ * @return true: 成功, false: 失敗（チャンネル番号不正または登録済み）
+ */
+bool dma_irq_register(int channel, dma_irq_handler_t handler);
+
+/**
+ * @brief DMA チャンネルの完了ハンドラーを登録解除
+ * @param channel DMA チャンネル番号
+ */
+void dma_irq_unregister(int channel);
+
+/**
+ * @brief 未登録のチャンネルで立っていた DMA_IRQ_0 のフラグの数を取得
+ *
+ * ディスパッチャーはこれらのフラグをクリアするだけでハンドラーは呼ばない。
+ * 0 以外なら、どこかで登録せずに dma_channel_set_irq0_enabled() を呼んでいる。
+ */
+uint32_t dma_irq_get_stray_count(void);
+
+#endif // DMA_IRQ_H
@@ -0,0 +1,227 @@
+/**
+ * @file fat32.c
+ * @brief FAT32 の連続した事前確保ファイルを探す実装
+ *
+ * セクタバッファは1つだけで、最後に読んだ LBA を覚えておく
+ * （チェーンをたどるときに同じ FAT セクタを何度も読まない）。
+ */
+
+#include "fat32.h"
+#include "sd_card.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// 定数
+// ============================================================================
+
+#define FAT32_EOC_MIN        0x0FFFFFF8u   // チェーンの終端
+#define FAT32_ENTRY_MASK     0x0FFFFFFFu
+
+#define DIR_ENTRY_SIZE       32
+#define DIR_ATTR_VOLUME_ID   0x08
+#define DIR_ATTR_DIRECTORY   0x10
+#define DIR_ATTR_LONG_NAME   0x0F
+#define DIR_DELETED          0xE5
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static uint8_t sector[SD_BLOCK_SIZE];
+static uint32_t sector_lba = 0xFFFFFFFFu;   // sector に入っている LBA
+
+static bool mounted = false;
+static uint32_t fat_lba;             // 最初の FAT
+static uint32_t data_lba;            // クラスタ 2 の先頭
+static uint32_t sectors_per_cluster;
+static uint32_t root_cluster;
+static uint32_t cluster_count;
+
+// ============================================================================
+// 内部関数
+// ============================================================================
+
+static inline uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool read_sector(uint32_t lba) {
+    if (lba == sector_lba) {
+        return true;
+    }
+    if (!sd_card_read_block(lba, sector)) {
+        sector_lba = 0xFFFFFFFFu;
+        return false;
+    }
+    sector_lba = lba;
+    return true;
+}
+
+static bool is_fat32_boot_sector(const uint8_t *s) {
+    return (s[0] == 0xEB || s[0] == 0xE9) && memcmp(&s[0x52], "FAT32   ", 8) == 0 &&
+           s[510] == 0x55 && s[511] == 0xAA;
+}
+
+static inline uint32_t cluster_to_lba(uint32_t cluster) {
+    return data_lba + (cluster - 2) * sectors_per_cluster;
+}
+
+/**
+ * @brief FAT のエントリ（次のクラスタ）を読む、失敗時は 0
+ */
+static uint32_t next_cluster(uint32_t cluster) {
+    uint32_t offset = cluster * 4;
+    if (!read_sector(fat_lba + offset / SD_BLOCK_SIZE)) {
+        return 0;
+    }
+    return get_u32(&sector[offset % SD_BLOCK_SIZE]) & FAT32_ENTRY_MASK;
+}
+
+/**
+ * @brief クラスタが first から clusters 個連続しているか
+ */
+static bool is_contiguous(uint32_t first, uint32_t clusters) {
+    uint32_t c = first;
+    for (uint32_t i = 1; i < clusters; i++) {
+        uint32_t next = next_cluster(c);
+        if (next != c + 1) {
+            return false;
+        }
+        c = next;
+    }
+    return true;
+}
+
+/**
+ * @brief 8.3 のディレクトリエントリ名を "NAME.EXT" にする
+ */
+static void format_name(const uint8_t *entry, char *out) {
+    int n = 0;
+    for (int i = 0; i < 8 && entry[i] != ' '; i++) {
+        out[n++] = (char)entry[i];
+    }
+    out[n++] = '.';
+    for (int i = 8; i < 11 && entry[i] != ' '; i++) {
+        out[n++] = (char)entry[i];
+    }
+    out[n] = '\0';
+}
+
+// ============================================================================
+// 公開関数
+// ============================================================================
+
+bool fat32_mount(void) {
+    mounted = false;
+    sector_lba = 0xFFFFFFFFu;
+
+    // セクタ 0 は MBR かブートセクタ（パーティションなし）
+    if (!read_sector(0)) {
+        printf("[FAT] Cannot read sector 0\n");
+        return false;
+    }
+    uint32_t part_lba = 0;
+    if (!is_fat32_boot_sector(sector)) {
+        uint8_t type = sector[0x1C2];
+        if (sector[510] != 0x55 || sector[511] != 0xAA || (type != 0x0B && type != 0x0C)) {
+            printf("[FAT] No FAT32 partition (type 0x%02x)\n", type);
+            return false;
+        }
+        part_lba = get_u32(&sector[0x1C6]);
+        if (!read_sector(part_lba) || !is_fat32_boot_sector(sector)) {
+            printf("[FAT] Invalid FAT32 boot sector at %lu\n", part_lba);
+            return false;
+        }
+    }
+
+    if (get_u16(&sector[0x0B]) != SD_BLOCK_SIZE) {
+        printf("[FAT] Unsupported sector size %u\n", get_u16(&sector[0x0B]));
+        return false;
+    }
+    sectors_per_cluster = sector[0x0D];
+    uint32_t reserved = get_u16(&sector[0x0E]);
+    uint32_t num_fats = sector[0x10];
+    uint32_t total_sectors = get_u32(&sector[0x20]);
+    uint32_t fat_size = get_u32(&sector[0x24]);
+    root_cluster = get_u32(&sector[0x2C]);
+
+    fat_lba = part_lba + reserved;
+    data_lba = fat_lba + num_fats * fat_size;
+    cluster_count = (total_sectors - (data_lba - part_lba)) / sectors_per_cluster;
+
+    mounted = true;
+    printf("[FAT] FAT32 at LBA %lu, %lu KB clusters, %lu clusters\n",
+           part_lba, sectors_per_cluster * SD_BLOCK_SIZE / 1024, cluster_count);
+    return true;
+}
+
+int fat32_find_extents(const char *prefix, const char *ext,
+                       fat32_extent_t *extents, int max_extents) {
+    if (!mounted) {
+        return 0;
+    }
+
+    size_t prefix_len = strlen(prefix);
+    size_t ext_len = strlen(ext);
+    int found = 0;
+    uint32_t cluster = root_cluster;
+
+    // ルートディレクトリのクラスタチェーンをたどる
+    while (cluster >= 2 && cluster < FAT32_EOC_MIN && found < max_extents) {
+        for (uint32_t s = 0; s < sectors_per_cluster; s++) {
+            if (!read_sector(cluster_to_lba(cluster) + s)) {
+                return found;
+            }
+            for (uint32_t off = 0; off < SD_BLOCK_SIZE; off += DIR_ENTRY_SIZE) {
+                // 後で FAT を読むと sector が上書きされるので、エントリを写しておく
+                uint8_t entry[DIR_ENTRY_SIZE];
+                memcpy(entry, &sector[off], DIR_ENTRY_SIZE);
+
+                if (entry[0] == 0x00) {
+                    return found;   // これ以降は未使用
+                }
+                uint8_t attr = entry[11];
+                if (entry[0] == DIR_DELETED || attr == DIR_ATTR_LONG_NAME ||
+                    (attr & (DIR_ATTR_VOLUME_ID | DIR_ATTR_DIRECTORY))) {
+                    continue;
+                }
+                if (memcmp(entry, prefix, prefix_len) != 0 ||
+                    memcmp(&entry[8], ext, ext_len) != 0) {
+                    continue;
+                }
+
+                fat32_extent_t *e = &extents[found];
+                format_name(entry, e->name);
+                uint32_t first = ((uint32_t)get_u16(&entry[0x14]) << 16) | get_u16(&entry[0x1A]);
+                uint32_t size = get_u32(&entry[0x1C]);
+                uint32_t cluster_bytes = sectors_per_cluster * SD_BLOCK_SIZE;
+                uint32_t clusters = (size + cluster_bytes - 1) / cluster_bytes;
+
+                if (first < 2 || size < SD_BLOCK_SIZE) {
+                    printf("[FAT] %s: empty, skipped\n", e->name);
+                } else if (!is_contiguous(first, clusters)) {
+                    printf("[FAT] %s: fragmented, skipped (re-create it on an empty card)\n", e->name);
+                } else {
+                    e->first_lba = cluster_to_lba(first);
+                    e->blocks = size / SD_BLOCK_SIZE;
+                    if (++found == max_extents) {
+                        return found;
+                    }
+                }
+
+                // FAT を読んだ場合はディレクトリのセクタを読み直す
+                if (!read_sector(cluster_to_lba(cluster) + s)) {
+                    return found;
+                }
+            }
+        }
+        cluster = next_cluster(cluster);
+    }
+    return found;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file fat32.h
+ * @brief FAT32 の連続した事前確保ファイルを探す（読み出し専用）- ヘッダーファイル
+ *
+ * 録音はファイルシステムを書き換えない: ホスト側で事前に確保したファイル
+ * （tools/sd_prealloc.py）のクラスタが連続していることを確かめ、
+ * その先頭ブロックと長さだけを使ってブロックデバイスに直接書く。
+ * FAT もディレクトリエントリも更新しないので、録音中にメタデータの書き込みは起きない。
+ *
+ * 対応: MBR の最初のパーティション、またはパーティションなしの FAT32、
+ * 512バイトセクタ、ルートディレクトリの 8.3 形式の名前。exFAT（64GB 以上の SDXC の
+ * 既定）は非対応なので、カードを FAT32 でフォーマットする。
+ */
+
+#ifndef FAT32_H
+#define FAT32_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 連続したファイルの範囲
+ */
+typedef struct {
+    char name[13];          // "REC00.WAV"
+    uint32_t first_lba;     // 先頭ブロック
+    uint32_t blocks;        // ファイルサイズ（ブロック、端数は切り捨て）
+} fat32_extent_t;
+
+/**
+ * @brief ボリュームをマウント（ブートセクタを読む、同期）
+ * @return true FAT32 のボリュームが見つかった
+ */
+bool fat32_mount(void);
+
+/**
+ * @brief ルートディレクトリから名前が prefix で始まり拡張子が ext のファイルを探す
+ *
+ * クラスタチェーンをたどり、連続していないファイルは警告を出して除く。
+ * @param prefix 名前の先頭（大文字、例: "REC"）
+ * @param ext 拡張子（大文字、例: "WAV"）
+ * @param extents 見つかったファイル（ディレクトリ順）
+ * @param max_extents extents の要素数
+ * @return 見つかった連続ファイルの数
+ */
+int fat32_find_extents(const char *prefix, const char *ext,
+                       fat32_extent_t *extents, int max_extents);
+
+#endif // FAT32_H
@@ -0,0 +1,155 @@
+/**
+ * @file latency.c
+ * @brief 処理チェーンのレイテンシー管理と遅延補償の実装
+ *
+ * タップの位置は処理順で固定: エフェクト前タップはラウドネスの後、
+ * エフェクト後タップはチェーンの最後。補償量 = 合計 - タップまでの遅延。
+ */
+
+#include "latency.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// 共有履歴メモリ（L/R を並べて確保する）
+static int16_t pool[LATENCY_POOL_FRAMES * 2];
+static uint32_t pool_used = 0;   // フレーム数
+
+static uint32_t node_latency[LATENCY_NODE_COUNT];
+
+// タップの直後にあるノード（そのノード以降の遅延を補償する）
+static const latency_node_t tap_position[AUDIO_TAP_COUNT] = {
+    LATENCY_NODE_EFFECT,   // AUDIO_TAP_PRE_EFFECT
+    LATENCY_NODE_COUNT,    // AUDIO_TAP_POST_EFFECT
+};
+
+static uint32_t tap_compensation[AUDIO_TAP_COUNT];
+static latency_delay_t tap_delay[AUDIO_TAP_COUNT];
+static bool tap_delay_allocated[AUDIO_TAP_COUNT];
+
+// ============================================================================
+// 遅延線
+// ============================================================================
+
+bool latency_delay_alloc(latency_delay_t *line, uint32_t max_frames) {
+    uint32_t size = max_frames + 1;
+    if (pool_used + size > LATENCY_POOL_FRAMES) {
+        printf("ERROR: Latency pool exhausted (%lu + %lu > %d frames)\n",
+               pool_used, size, LATENCY_POOL_FRAMES);
+        return false;
+    }
+
+    line->buf_l = &pool[pool_used * 2];
+    line->buf_r = &pool[pool_used * 2 + size];
+    line->size = size;
+    line->delay = 0;
+    line->pos = 0;
+    memset(line->buf_l, 0, size * 2 * sizeof(int16_t));
+    pool_used += size;
+    return true;
+}
+
+void latency_delay_set(latency_delay_t *line, uint32_t frames) {
+    line->delay = (frames < line->size) ? frames : line->size - 1;
+}
+
+void latency_delay_process(latency_delay_t *line, const int16_t *in_l, const int16_t *in_r,
+                           int16_t *out_l, int16_t *out_r, uint32_t num_samples) {
+    uint32_t size = line->size;
+    uint32_t pos = line->pos;
+    uint32_t rd = (pos >= line->delay) ? pos - line->delay : pos + size - line->delay;
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        // 書いてから読む（遅延 0 なら同じ位置）
+        line->buf_l[pos] = in_l[i];
+        line->buf_r[pos] = in_r[i];
+        out_l[i] = line->buf_l[rd];
+        out_r[i] = line->buf_r[rd];
+        if (++pos == size) pos = 0;
+        if (++rd == size) rd = 0;
+    }
+    line->pos = pos;
+}
+
+// ============================================================================
+// レイテンシーの申告と補償量
+// ============================================================================
+
+static void update_compensation(void) {
+    uint32_t total = latency_get_total();
+
+    for (int tap = 0; tap < AUDIO_TAP_COUNT; tap++) {
+        uint32_t before = 0;
+        for (int node = 0; node < (int)tap_position[tap]; node++) {
+            before += node_latency[node];
+        }
+        uint32_t comp = total - before;
+
+        if (comp > LATENCY_MAX_COMPENSATION) {
+            printf("WARNING: Tap %d needs %lu frames of compensation (max %d)\n",
+                   tap, comp, LATENCY_MAX_COMPENSATION);
+            comp = LATENCY_MAX_COMPENSATION;
+        }
+        if (comp > 0 && !tap_delay_allocated[tap]) {
+            tap_delay_allocated[tap] = latency_delay_alloc(&tap_delay[tap], LATENCY_MAX_COMPENSATION);
+        }
+        if (!tap_delay_allocated[tap]) {
+            comp = 0;
+        } else {
+            latency_delay_set(&tap_delay[tap], comp);
+        }
+        tap_compensation[tap] = comp;
+    }
+}
+
+void latency_init(void) {
+    memset(node_latency, 0, sizeof(node_latency));
+    memset(tap_compensation, 0, sizeof(tap_compensation));
+    memset(tap_delay_allocated, 0, sizeof(tap_delay_allocated));
+    pool_used = 0;
+}
+
+void latency_declare(latency_node_t node, uint32_t frames) {
+    if (node >= LATENCY_NODE_COUNT) return;
+    node_latency[node] = frames;
+    update_compensation();
+
+    printf("[LATENCY] Node %d: %lu frames | Total: %lu frames (%.2f ms) | Dry tap compensation: %lu\n",
+           node, frames, latency_get_total(),
+           (float)latency_get_total() * 1000.0f / AUDIO_SAMPLE_RATE,
+           tap_compensation[AUDIO_TAP_PRE_EFFECT]);
+}
+
+uint32_t latency_get_node(latency_node_t node) {
+    return (node < LATENCY_NODE_COUNT) ? node_latency[node] : 0;
+}
+
+uint32_t latency_get_total(void) {
+    uint32_t total = 0;
+    for (int node = 0; node < LATENCY_NODE_COUNT; node++) {
+        total += node_latency[node];
+    }
+    return total;
+}
+
+uint32_t latency_get_compensation(audio_tap_t tap) {
+    return (tap < AUDIO_TAP_COUNT) ? tap_compensation[tap] : 0;
+}
+
+bool latency_compensate_tap(audio_tap_t tap, const int16_t *left, const int16_t *right,
+                            int16_t *out_l, int16_t *out_r, uint32_t num_samples) {
+    if (tap >= AUDIO_TAP_COUNT || tap_compensation[tap] == 0) {
+        return false;
+    }
+    latency_delay_process(&tap_delay[tap], left, right, out_l, out_r, num_samples);
+    return true;
+}
+
+uint32_t latency_get_pool_used(void) {
+    return pool_used;
+}
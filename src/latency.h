@@ -0,0 +1,114 @@
+/**
+ * @file latency.h
+ * @brief 処理チェーンのレイテンシー管理と遅延補償 - ヘッダーファイル
+ *
+ * 先読みや解析窓を持つノードは、自分が入れる遅延（フレーム数）を申告する。
+ * タップ（audio_route）ごとに「そのタップより後ろのノードの遅延の合計」を
+ * 補償量として求め、エフェクト前タップの出力（ドライ）をエフェクト後タップと
+ * 同じ時刻にそろえる。並列に鳴らす経路（4ch 出力のドライ/ウェット）で
+ * 櫛形フィルタにならないようにするため。
+ *
+ * 遅延線はすべて1つの共有履歴メモリ（LATENCY_POOL_FRAMES）から確保する。
+ * 解放はしない（起動時と設定変更時にだけ確保する）。
+ */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "audio_route.h"
+
+/**
+ * @brief 処理チェーンのノード（bt_audio の処理順）
+ */
+typedef enum {
+    LATENCY_NODE_VARISPEED = 0,    // バリスピード（リサンプラーの半分のタップ）
+    LATENCY_NODE_LOUDNESS,         // ラウドネス AGC（エフェクト前タップより前）
+    LATENCY_NODE_EFFECT,           // Beat-Repeat / スライサー / マルチバンド
+    LATENCY_NODE_LOOPER,           // ルーパー
+    LATENCY_NODE_SAMPLER,          // サンプルプレーヤー
+    LATENCY_NODE_BUS_COMPRESSOR,   // バスコンプレッサー（先読み）
+    LATENCY_NODE_COUNT,
+} latency_node_t;
+
+/**
+ * @brief ステレオの遅延線（共有履歴メモリ上）
+ */
+typedef struct {
+    int16_t *buf_l;
+    int16_t *buf_r;
+    uint32_t size;     // リングのフレーム数（最大遅延 + 1）
+    uint32_t delay;    // 現在の遅延（フレーム）
+    uint32_t pos;      // 書き込み位置
+} latency_delay_t;
+
+/**
+ * @brief 初期化（全ノードの遅延 0、共有メモリを空にする）
+ */
+void latency_init(void);
+
+/**
+ * @brief ノードの遅延を申告（タップの補償量を更新する）
+ * @param node ノード
+ * @param frames 遅延（フレーム）
+ */
+void latency_declare(latency_node_t node, uint32_t frames);
+
+/**
+ * @brief ノードの遅延を取得
+ */
+uint32_t latency_get_node(latency_node_t node);
+
+/**
+ * @brief デコーダー出力からエフェクト後タップまでの遅延の合計（フレーム）
+ */
+uint32_t latency_get_total(void);
+
+/**
+ * @brief タップに加える補償遅延（エフェクト後タップにそろえる量、フレーム）
+ */
+uint32_t latency_get_compensation(audio_tap_t tap);
+
+/**
+ * @brief タップのデータに補償遅延を掛ける
+ *
+ * 補償量が 0 なら何もせず false を返す（呼び出し側は元のデータをそのまま使う）。
+ *
+ * @param tap タップ
+ * @param left 入力（左）
+ * @param right 入力（右）
+ * @param out_l 出力（左、num_samples 個）
+ * @param out_r 出力（右、num_samples 個）
+ * @param num_samples ステレオペア数
+ * @return true 出力に遅延後のデータを書いた
+ */
+bool latency_compensate_tap(audio_tap_t tap, const int16_t *left, const int16_t *right,
+                            int16_t *out_l, int16_t *out_r, uint32_t num_samples);
+
+/**
+ * @brief 共有履歴メモリから遅延線を確保
+ * @param line 遅延線
+ * @param max_frames 最大遅延（フレーム）
+ * @return true 成功, false メモリ不足
+ */
+bool latency_delay_alloc(latency_delay_t *line, uint32_t max_frames);
+
+/**
+ * @brief 遅延量を設定（履歴はそのまま、最大遅延でクランプ）
+ */
+void latency_delay_set(latency_delay_t *line, uint32_t frames);
+
+/**
+ * @brief 遅延線を通す（in と out は同じ配列でもよい）
+ */
+void latency_delay_process(latency_delay_t *line, const int16_t *in_l, const int16_t *in_r,
+                           int16_t *out_l, int16_t *out_r, uint32_t num_samples);
+
+/**
+ * @brief 共有履歴メモリの使用量（フレーム）
+ */
+uint32_t latency_get_pool_used(void);
+
+#endif // LATENCY_H
@@ -0,0 +1,226 @@
+/**
+ * @file link_monitor.c
+ * @brief Bluetooth リンク品質の監視と適応バッファ深さの制御の実装
+ *
+ * ドローダウンは Q4 マイクロ秒で積算する（1パケットの丸め誤差 1/16 us 未満）。
+ * ピークは LINK_WINDOW_MS ごとの窓で取り、LINK_HISTORY_WINDOWS 個の窓を覚えておく。
+ */
+
+#include "link_monitor.h"
+#include "config.h"
+
+#include <string.h>
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define US_FRAC_BITS    4
+
+#define MS_TO_US(ms)    ((uint32_t)(ms) * 1000u)
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static uint32_t rate = AUDIO_SAMPLE_RATE;
+
+static bool has_packet = false;
+static uint32_t last_arrival_us = 0;
+static uint32_t now_cached_us = 0;
+
+static uint64_t drawdown_q4 = 0;                  // 現在のドローダウン（Q4 us）
+static uint64_t window_peak_q4 = 0;               // 現在の窓のピーク
+static uint64_t history_q4[LINK_HISTORY_WINDOWS]; // 過去の窓のピーク
+static uint32_t history_pos = 0;
+static uint32_t window_start_us = 0;
+
+static uint32_t jitter_q4 = 0;                    // ジッター（Q4 us）
+
+static uint32_t gap_count = 0;
+static uint32_t flow_event_count = 0;
+static uint32_t underrun_count = 0;
+static bool has_event = false;
+static uint32_t last_event_us = 0;
+
+static int8_t rssi = 0;
+static bool has_rssi = false;
+
+static uint32_t target_frames = 0;
+static uint32_t last_raise_us = 0;
+
+// ============================================================================
+// 内部関数
+// ============================================================================
+
+static uint32_t ms_to_frames(uint32_t ms) {
+    return (uint32_t)((uint64_t)ms * rate / 1000);
+}
+
+static uint32_t q4_us_to_frames(uint64_t q4) {
+    return (uint32_t)((q4 * rate / 1000000) >> US_FRAC_BITS);
+}
+
+static uint64_t peak_drawdown_q4(void) {
+    uint64_t peak = window_peak_q4;
+    for (int i = 0; i < LINK_HISTORY_WINDOWS; i++) {
+        if (history_q4[i] > peak) peak = history_q4[i];
+    }
+    return peak;
+}
+
+/**
+ * @brief リンクの状態から目標深さを求める
+ */
+static uint32_t desired_target(uint32_t now_us) {
+    uint32_t need = q4_us_to_frames(peak_drawdown_q4());
+    uint32_t target = (uint32_t)((uint64_t)need * LINK_MARGIN_PERCENT / 100);
+
+    uint32_t min_frames = ms_to_frames(LINK_TARGET_MIN_MS);
+    if (target < min_frames) target = min_frames;
+
+    // 電波が弱いと急な劣化が起きやすいので先に深くしておく
+    if (has_rssi && rssi < LINK_RSSI_WEAK_DBM) {
+        target += ms_to_frames(LINK_RSSI_MARGIN_MS);
+    }
+    // ギャップ / フロー系イベント / アンダーランの直後
+    if (has_event && (now_us - last_event_us) < MS_TO_US(LINK_EVENT_HOLD_MS)) {
+        target += ms_to_frames(LINK_EVENT_MARGIN_MS);
+    }
+
+    uint32_t max_frames = ms_to_frames(LINK_TARGET_MAX_MS);
+    return (target > max_frames) ? max_frames : target;
+}
+
+/**
+ * @brief 目標深さを更新（上げるのは常に、下げるのは窓の区切りでのみ）
+ */
+static void update_target(uint32_t now_us, bool window_end) {
+    uint32_t desired = desired_target(now_us);
+
+    if (desired > target_frames) {
+        target_frames = desired;
+        last_raise_us = now_us;
+        return;
+    }
+
+    if (window_end && desired < target_frames &&
+        (now_us - last_raise_us) >= MS_TO_US(LINK_LOWER_HOLD_MS)) {
+        uint32_t step = ms_to_frames(LINK_LOWER_STEP_MS);
+        target_frames = (target_frames - desired > step) ? target_frames - step : desired;
+    }
+}
+
+static void record_event(uint32_t now_us) {
+    has_event = true;
+    last_event_us = now_us;
+    update_target(now_us, false);
+}
+
+// ============================================================================
+// 公開関数
+// ============================================================================
+
+void link_monitor_init(uint32_t sample_rate) {
+    gap_count = 0;
+    flow_event_count = 0;
+    underrun_count = 0;
+    has_rssi = false;
+    rssi = 0;
+    link_monitor_reset(sample_rate);
+}
+
+void link_monitor_reset(uint32_t sample_rate) {
+    rate = (sample_rate > 0) ? sample_rate : AUDIO_SAMPLE_RATE;
+    has_packet = false;
+    drawdown_q4 = 0;
+    window_peak_q4 = 0;
+    memset(history_q4, 0, sizeof(history_q4));
+    history_pos = 0;
+    jitter_q4 = 0;
+    has_event = false;
+    target_frames = ms_to_frames(LINK_TARGET_INITIAL_MS);
+}
+
+void link_monitor_on_packet(uint32_t now_us, uint32_t frames) {
+    now_cached_us = now_us;
+
+    if (!has_packet) {
+        // 最初のパケットは基準時刻だけ
+        has_packet = true;
+        last_arrival_us = now_us;
+        window_start_us = now_us;
+        last_raise_us = now_us;
+        return;
+    }
+
+    uint32_t interval_us = now_us - last_arrival_us;
+    last_arrival_us = now_us;
+
+    // ドローダウン: 到着間隔だけ消費し、パケットの再生時間だけ補充される
+    uint64_t consumed_q4 = (uint64_t)interval_us << US_FRAC_BITS;
+    uint64_t refilled_q4 = ((uint64_t)frames * 1000000 << US_FRAC_BITS) / rate;
+    uint64_t drift_q4 = (consumed_q4 * LINK_DRIFT_PPM) / 1000000;
+    uint64_t credit_q4 = refilled_q4 + drift_q4;
+    uint64_t prev_peak_q4 = peak_drawdown_q4();
+    drawdown_q4 = (drawdown_q4 + consumed_q4 > credit_q4) ? drawdown_q4 + consumed_q4 - credit_q4 : 0;
+    if (drawdown_q4 > window_peak_q4) window_peak_q4 = drawdown_q4;
+
+    // ジッター（期待間隔からのずれの平均、1/16 の指数移動平均）
+    uint32_t expected_q4 = (uint32_t)refilled_q4;
+    uint32_t actual_q4 = (uint32_t)consumed_q4;
+    uint32_t deviation_q4 = (actual_q4 > expected_q4) ? actual_q4 - expected_q4 : expected_q4 - actual_q4;
+    jitter_q4 = (uint32_t)((int32_t)jitter_q4 + ((int32_t)deviation_q4 - (int32_t)jitter_q4) / 16);
+
+    // ギャップ: 履歴より深いドローダウンを生んだもの（規則的なバースト受信ではない）は
+    // リンクの劣化とみなしてマージンを上乗せする
+    if (interval_us > MS_TO_US(LINK_GAP_MS)) {
+        gap_count++;
+        if (drawdown_q4 > prev_peak_q4) {
+            record_event(now_us);
+        }
+    }
+
+    // 窓の区切り: ピークを履歴に移す
+    bool window_end = (now_us - window_start_us) >= MS_TO_US(LINK_WINDOW_MS);
+    if (window_end) {
+        history_q4[history_pos] = window_peak_q4;
+        history_pos = (history_pos + 1) % LINK_HISTORY_WINDOWS;
+        window_peak_q4 = drawdown_q4;
+        window_start_us = now_us;
+    }
+
+    update_target(now_us, window_end);
+}
+
+void link_monitor_on_rssi(int8_t rssi_dbm) {
+    rssi = rssi_dbm;
+    has_rssi = true;
+    if (has_packet) {
+        update_target(now_cached_us, false);
+    }
+}
+
+void link_monitor_on_flow_event(uint32_t now_us) {
+    flow_event_count++;
+    record_event(now_us);
+}
+
+void link_monitor_on_underrun(uint32_t now_us) {
+    underrun_count++;
+    record_event(now_us);
+}
+
+uint32_t link_monitor_get_target_frames(void) {
+    return target_frames;
+}
+
+void link_monitor_get_stats(link_monitor_stats_t *stats) {
+    stats->jitter_us = jitter_q4 >> US_FRAC_BITS;
+    stats->drawdown_frames = q4_us_to_frames(peak_drawdown_q4());
+    stats->gaps = gap_count;
+    stats->flow_events = flow_event_count;
+    stats->underruns = underrun_count;
+    stats->rssi_dbm = has_rssi ? rssi : 0;
+    stats->target_frames = target_frames;
+}
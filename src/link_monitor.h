@@ -0,0 +1,86 @@
+/**
+ * @file link_monitor.h
+ * @brief Bluetooth リンク品質の監視と適応バッファ深さの制御 - ヘッダーファイル
+ *
+ * メディアパケットの到着間隔から「受信が消費にどれだけ遅れたか」（ドローダウン）を
+ * 求め、過去数秒のピークに余裕を掛けて出力リングの目標深さにする。
+ *   L = max(0, L + 到着間隔 - パケットの再生時間 - ドリフト許容)
+ * L は一定速度で消費するバッファが途切れずに済むために必要だった深さそのもの。
+ * RSSI の低下、履歴より深いドローダウンを生んだギャップ、HCI のフロー系イベント
+ * （QoS 違反・フラッシュ・バッファオーバーフロー）、アンダーランは一定時間マージンを
+ * 上乗せする。
+ *
+ * 目標は上げるときは即座に、下げるときは上げてから一定時間たってから少しずつ。
+ * クリーンなリンクでは遅延を小さく、悪いリンクでは途切れにくくする。
+ *
+ * SDK に依存しない計算だけのモジュール（時刻は呼び出し側が渡す）。
+ */
+
+#ifndef LINK_MONITOR_H
+#define LINK_MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief リンク品質の統計
+ */
+typedef struct {
+    uint32_t jitter_us;          // 到着間隔のジッター（RFC 3550 方式の平均偏差）
+    uint32_t drawdown_frames;    // 履歴中のドローダウンのピーク（必要だった深さ）
+    uint32_t gaps;               // LINK_GAP_MS を超えた到着間隔の回数
+    uint32_t flow_events;        // HCI のフロー系イベントの回数
+    uint32_t underruns;          // 出力のアンダーラン（通知された回数）
+    int8_t rssi_dbm;             // 最新の RSSI（未測定なら 0）
+    uint32_t target_frames;      // 現在の目標深さ
+} link_monitor_stats_t;
+
+/**
+ * @brief 初期化
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void link_monitor_init(uint32_t sample_rate);
+
+/**
+ * @brief ストリームの開始（再開）時にリセット（目標深さは初期値に戻る）
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void link_monitor_reset(uint32_t sample_rate);
+
+/**
+ * @brief メディアパケットの到着を記録
+ * @param now_us 到着時刻（us）
+ * @param frames パケットをデコードしたフレーム数
+ */
+void link_monitor_on_packet(uint32_t now_us, uint32_t frames);
+
+/**
+ * @brief RSSI の測定結果を記録
+ * @param rssi_dbm RSSI（dBm）
+ */
+void link_monitor_on_rssi(int8_t rssi_dbm);
+
+/**
+ * @brief HCI のフロー系イベント（QoS 違反・フラッシュ・バッファオーバーフロー）を記録
+ * @param now_us 時刻（us）
+ */
+void link_monitor_on_flow_event(uint32_t now_us);
+
+/**
+ * @brief 出力のアンダーランを記録
+ * @param now_us 時刻（us）
+ */
+void link_monitor_on_underrun(uint32_t now_us);
+
+/**
+ * @brief 出力リングの目標深さを取得
+ * @return フレーム数
+ */
+uint32_t link_monitor_get_target_frames(void);
+
+/**
+ * @brief 統計を取得
+ */
+void link_monitor_get_stats(link_monitor_stats_t *stats);
+
+#endif // LINK_MONITOR_H
@@ -0,0 +1,530 @@
+/**
+ * @file looper.c
+ * @brief 小節単位のルーパーの実装
+ *
+ * 圧縮は IMA-ADPCM（adpcm.h、4ビット/サンプル + ブロックヘッダー4バイト）。
+ * LOOPER_BLOCK_FRAMES = 256 ならチャンネルあたり 132 バイト/ブロック（約4.1ビット/サンプル）で、
+ * 16ビット PCM の約 1/3.9 のメモリで済む。
+ *
+ * 再生中はブロックの頭で1ブロック分をデコードし、録音/オーバーダブ中は
+ * ブロックの終わりで1ブロック分をエンコードして書き戻す。
+ * オーバーダブの切り替えはブロック境界でだけ反映する（書き戻すブロックが欠けないように）。
+ *
+ * 半レートのループは、入力をハーフバンドの FIR で間引いて偶数フレームごとに1サンプル保存し、
+ * 再生時は同じフィルタで補間する（1ブロック = 2 × LOOPER_BLOCK_FRAMES フレーム）。
+ * オーバーダブのフィードバックは保存したサンプルどうしで足すので、
+ * 重ねるたびにフィルタの遅延やロールオフが溜まることはない。
+ */
+
+#include "looper.h"
+#include "config.h"
+#include "beat_clock.h"
+#include "adpcm.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define ADPCM_HEADER_BYTES   4
+#define ADPCM_BLOCK_BYTES    (ADPCM_HEADER_BYTES + LOOPER_BLOCK_FRAMES / 2)   // 1チャンネル分
+#define LOOPER_BLOCK_STRIDE  (ADPCM_BLOCK_BYTES * LOOPER_CHANNELS)
+
+#if LOOPER_HALF_RATE_ENABLED
+#define MAX_DECIMATION       2
+#else
+#define MAX_DECIMATION       1
+#endif
+
+// 半レートの間引き/補間フィルタ（ハーフバンド、Kaiser 窓、遅延は (RS_TAPS - 1) / 2 フレームずつ）
+#define RS_TAPS              31
+#define RS_HIST_SAMPLES      ((RS_TAPS + 1) / 2)    // 補間に使う保存サンプル数
+#define RS_KAISER_BETA       5.0
+
+#define BEATS_PER_BAR        4
+
+#define SAMPLE_MAX           32767
+#define SAMPLE_MIN           -32768
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// 圧縮メモリ（借りている間だけ有効）:
+// [ブロック][チャンネル] = ヘッダー（予測値 int16 + ステップ番号）+ 4ビット × BLOCK_FRAMES
+static uint8_t *looper_memory = NULL;
+static uint32_t memory_bytes = 0;
+static uint32_t num_blocks = 0;
+static looper_memory_acquire_t memory_acquire = NULL;
+static looper_memory_release_t memory_release = NULL;
+
+// 1ブロック分の作業バッファ（保存したサンプル）
+static int16_t decode_buf[LOOPER_CHANNELS][LOOPER_BLOCK_FRAMES];
+static int16_t record_buf[LOOPER_CHANNELS][LOOPER_BLOCK_FRAMES];
+
+// 半レートのフィルタ: 係数（Q15、和は 32768）と、入力/保存サンプルの履歴（2周分並べたリング）
+static int16_t rs_coeffs[RS_TAPS];
+static int16_t dec_hist[LOOPER_CHANNELS][2 * RS_TAPS];
+static int16_t up_hist[LOOPER_CHANNELS][2 * RS_HIST_SAMPLES];
+static uint32_t dec_pos = 0;
+static uint32_t up_pos = 0;
+
+static looper_state_t state = LOOPER_IDLE;
+static bool overdub_requested = false;
+
+static uint32_t decimation = 1;        // 現在のループの保存間隔（1 = 原レート、2 = 半レート）
+static uint32_t loop_frames = 0;       // ループ長（フレーム数）
+static uint32_t loop_blocks = 0;       // ループが使うブロック数
+static uint32_t current_block = 0;     // 現在のブロック
+static uint32_t block_pos = 0;         // ブロック内の位置（フレーム）
+static uint8_t encode_index[LOOPER_CHANNELS];  // エンコーダーのステップ番号（ブロック間で引き継ぐ）
+
+static int32_t feedback_q15 = (int32_t)(LOOPER_FEEDBACK * 32768.0f);
+static int32_t level_q15 = 32768;
+
+static uint32_t sample_rate = AUDIO_SAMPLE_RATE;
+static bool is_initialized = false;
+
+// 処理コスト
+static uint32_t encode_total_us = 0;
+static uint32_t encode_blocks = 0;
+static uint32_t decode_total_us = 0;
+static uint32_t decode_blocks = 0;
+
+// ============================================================================
+// ヘルパー関数
+// ============================================================================
+
+static inline int16_t saturate(int32_t v) {
+    if (v > SAMPLE_MAX) return SAMPLE_MAX;
+    if (v < SAMPLE_MIN) return SAMPLE_MIN;
+    return (int16_t)v;
+}
+
+static inline uint8_t *block_ptr(uint32_t block, uint32_t channel) {
+    return &looper_memory[block * LOOPER_BLOCK_STRIDE + channel * ADPCM_BLOCK_BYTES];
+}
+
+/**
+ * @brief 第1種0次の変形ベッセル関数（Kaiser 窓用、べき級数）
+ */
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+/**
+ * @brief ハーフバンドの係数を作る（カットオフ = 原レートの 1/4）
+ *
+ * 偶数番目と奇数番目の係数の和をそれぞれ 16384 にそろえる
+ * （補間で2倍したときにどちらの位相もゲイン 1 になる）。
+ */
+static void build_rs_coeffs(void) {
+    const int center = (RS_TAPS - 1) / 2;
+    double i0_beta = bessel_i0(RS_KAISER_BETA);
+    double h[RS_TAPS];
+    double sum = 0.0;
+
+    for (int j = 0; j < RS_TAPS; j++) {
+        int n = j - center;
+        double sinc = (n == 0) ? 0.5 : sin(M_PI * n / 2.0) / (M_PI * n);
+        double r = (double)n / center;
+        h[j] = sinc * bessel_i0(RS_KAISER_BETA * sqrt(1.0 - r * r)) / i0_beta;
+        sum += h[j];
+    }
+
+    int32_t phase_sum[2] = { 0, 0 };
+    for (int j = 0; j < RS_TAPS; j++) {
+        rs_coeffs[j] = (int16_t)lround(h[j] / sum * 32768.0);
+        phase_sum[j & 1] += rs_coeffs[j];
+    }
+    // 丸めの残りは各位相で中心に最も近い係数に足す
+    rs_coeffs[center] += (int16_t)(16384 - phase_sum[center & 1]);
+    rs_coeffs[center - 1] += (int16_t)(16384 - phase_sum[(center - 1) & 1]);
+}
+
+/**
+ * @brief 入力を1フレーム履歴に積む（半レートの間引き用）
+ */
+static inline void push_decimator(const int32_t *in) {
+    for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) {
+        dec_hist[ch][dec_pos] = dec_hist[ch][dec_pos + RS_TAPS] = (int16_t)in[ch];
+    }
+    if (++dec_pos >= RS_TAPS) dec_pos = 0;
+}
+
+/**
+ * @brief 履歴から保存するサンプルを1つ作る（直前に積んだフレームが最新）
+ */
+static inline int16_t decimate(uint32_t ch) {
+    // dec_pos は最も古いフレームを指している
+    const int16_t *x = &dec_hist[ch][dec_pos];
+    int32_t acc = 0;
+    for (uint32_t j = 0; j < RS_TAPS; j++) {
+        acc += (int32_t)rs_coeffs[RS_TAPS - 1 - j] * x[j];
+    }
+    return saturate((acc + 16384) >> 15);
+}
+
+/**
+ * @brief 保存したサンプルを補間の履歴に積む（偶数フレーム）
+ */
+static inline void push_interpolator(uint32_t ch, int16_t sample) {
+    up_hist[ch][up_pos] = up_hist[ch][up_pos + RS_HIST_SAMPLES] = sample;
+}
+
+/**
+ * @brief 補間した出力を1フレーム作る
+ * @param phase 0 = 偶数フレーム（最新の保存サンプルの位置）、1 = その次のフレーム
+ */
+static inline int16_t interpolate(uint32_t ch, uint32_t phase) {
+    // up_pos は最新の保存サンプル、k 個前が up_hist[up_pos + RS_HIST_SAMPLES - k]
+    const int16_t *y = &up_hist[ch][up_pos + RS_HIST_SAMPLES];
+    int32_t acc = 0;
+    for (uint32_t j = phase; j < RS_TAPS; j += 2) {
+        acc += (int32_t)rs_coeffs[j] * y[-(int32_t)(j >> 1)];
+    }
+    // ゼロ挿入の分、ゲインを2倍にする
+    return saturate((acc + 8192) >> 14);
+}
+
+static void reset_resampler(void) {
+    memset(dec_hist, 0, sizeof(dec_hist));
+    memset(up_hist, 0, sizeof(up_hist));
+    dec_pos = 0;
+    up_pos = 0;
+}
+
+/**
+ * @brief 1ブロックを IMA-ADPCM でエンコード
+ * @param src 入力（n サンプル）
+ * @param n サンプル数（LOOPER_BLOCK_FRAMES 以下）
+ * @param dst 出力（ヘッダー + データ）
+ * @param index エンコーダーのステップ番号（更新される）
+ */
+static void adpcm_encode_block(const int16_t *src, uint32_t n, uint8_t *dst, uint8_t *index) {
+    // ヘッダー: 先頭サンプルをそのまま予測値にする
+    adpcm_state_t st = { .predictor = src[0], .index = *index };
+    dst[0] = (uint8_t)(st.predictor & 0xFF);
+    dst[1] = (uint8_t)((st.predictor >> 8) & 0xFF);
+    dst[2] = (uint8_t)st.index;
+    dst[3] = 0;
+
+    uint8_t *data = dst + ADPCM_HEADER_BYTES;
+    memset(data, 0, LOOPER_BLOCK_FRAMES / 2);
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t code = adpcm_encode_sample(&st, src[i]);
+        data[i >> 1] |= (i & 1) ? (uint8_t)(code << 4) : code;
+    }
+
+    *index = (uint8_t)st.index;
+}
+
+/**
+ * @brief 1ブロックを IMA-ADPCM からデコード
+ */
+static void adpcm_decode_block(const uint8_t *src, uint32_t n, int16_t *dst) {
+    adpcm_state_t st = {
+        .predictor = (int16_t)((uint16_t)src[0] | ((uint16_t)src[1] << 8)),
+        .index = src[2],
+    };
+    const uint8_t *data = src + ADPCM_HEADER_BYTES;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t code = (i & 1) ? (data[i >> 1] >> 4) : (data[i >> 1] & 0x0F);
+        dst[i] = adpcm_decode_sample(&st, code);
+    }
+}
+
+/**
+ * @brief 現在のブロックのフレーム数（最後のブロックは短い）
+ */
+static inline uint32_t current_block_frames(void) {
+    uint32_t span = LOOPER_BLOCK_FRAMES * decimation;
+    uint32_t remaining = loop_frames - current_block * span;
+    return (remaining < span) ? remaining : span;
+}
+
+/**
+ * @brief フレーム数 → 保存するサンプル数
+ */
+static inline uint32_t stored_samples(uint32_t frames) {
+    return (frames + decimation - 1) / decimation;
+}
+
+static void decode_current_block(void) {
+    uint32_t start_us = time_us_32();
+    uint32_t n = stored_samples(current_block_frames());
+    for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) {
+        adpcm_decode_block(block_ptr(current_block, ch), n, decode_buf[ch]);
+    }
+    decode_total_us += time_us_32() - start_us;
+    decode_blocks++;
+}
+
+static void encode_current_block(uint32_t n) {
+    uint32_t start_us = time_us_32();
+    for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) {
+        adpcm_encode_block(record_buf[ch], n, block_ptr(current_block, ch), &encode_index[ch]);
+    }
+    encode_total_us += time_us_32() - start_us;
+    encode_blocks++;
+}
+
+/**
+ * @brief ブロック内で次の小節頭が来るフレーム位置を探す
+ * @return true 見つかった（offset に格納）
+ */
+static bool find_bar_start(uint32_t num_samples, uint32_t *offset) {
+    const uint64_t bar_q32 = (uint64_t)BEATS_PER_BAR << 32;
+    uint64_t start = beat_clock_get_position_at(0);
+    uint64_t end = beat_clock_get_position_at(num_samples);
+    uint64_t next_bar = ((start + bar_q32 - 1) / bar_q32) * bar_q32;
+
+    if (next_bar >= end) {
+        return false;
+    }
+
+    // 拍位置はブロック内で線形なので、割合からフレーム位置を求める（切り上げ）
+    uint64_t span = end - start;
+    *offset = (uint32_t)(((next_bar - start) * num_samples + span - 1) / span);
+    return true;
+}
+
+static inline double bar_frames(float bpm) {
+    return (double)BEATS_PER_BAR * 60.0 / (double)bpm * (double)sample_rate;
+}
+
+// ============================================================================
+// 初期化・操作
+// ============================================================================
+
+bool looper_init(uint32_t sr) {
+    sample_rate = sr;
+    build_rs_coeffs();
+    looper_clear();
+    is_initialized = true;
+
+    printf("[LOOPER] %d ch IMA-ADPCM, %d-sample blocks, half rate %s, memory borrowed on record\n",
+           LOOPER_CHANNELS, LOOPER_BLOCK_FRAMES, LOOPER_HALF_RATE_ENABLED ? "ON" : "OFF");
+    return true;
+}
+
+void looper_set_memory(uint32_t bytes, looper_memory_acquire_t acquire, looper_memory_release_t release) {
+    looper_clear();
+    memory_bytes = bytes;
+    num_blocks = bytes / LOOPER_BLOCK_STRIDE;
+    memory_acquire = acquire;
+    memory_release = release;
+
+    float full_sec = (float)(num_blocks * LOOPER_BLOCK_FRAMES) / (float)sample_rate;
+    printf("[LOOPER] Memory: %lu bytes, %lu blocks x %d bytes\n",
+           bytes, num_blocks, LOOPER_BLOCK_STRIDE);
+    printf("[LOOPER] Capacity: %.2f sec (%.2f sec at half rate): %lu bars @ 90 BPM, %lu bars @ 120 BPM\n",
+           full_sec, full_sec * MAX_DECIMATION, looper_get_max_bars(90.0f), looper_get_max_bars(120.0f));
+}
+
+bool looper_record(uint32_t bars) {
+    if (!is_initialized || bars == 0) return false;
+
+    uint32_t max_bars = looper_get_max_bars(beat_clock_get_bpm());
+    if (max_bars == 0) {
+        printf("[LOOPER] 1 bar does not fit at %.1f BPM\n", beat_clock_get_bpm());
+        return false;
+    }
+    if (bars > max_bars) {
+        printf("[LOOPER] %lu bars do not fit, recording %lu bars\n", bars, max_bars);
+        bars = max_bars;
+    }
+
+    state = LOOPER_IDLE;   // 予約が完了するまでオーディオ側は触らない
+
+    if (!looper_memory) {
+        looper_memory = memory_acquire ? (uint8_t *)memory_acquire() : NULL;
+        if (!looper_memory) {
+            printf("[LOOPER] Memory is in use (disable Beat-Repeat to record)\n");
+            return false;
+        }
+    }
+
+    loop_frames = (uint32_t)(bar_frames(beat_clock_get_bpm()) * (double)bars + 0.5);
+    decimation = (loop_frames <= num_blocks * LOOPER_BLOCK_FRAMES) ? 1 : MAX_DECIMATION;
+    loop_blocks = (loop_frames + LOOPER_BLOCK_FRAMES * decimation - 1) / (LOOPER_BLOCK_FRAMES * decimation);
+    current_block = 0;
+    block_pos = 0;
+    overdub_requested = false;
+    memset(encode_index, 0, sizeof(encode_index));
+    reset_resampler();
+    state = LOOPER_ARMED;
+
+    printf("[LOOPER] Armed: %lu bars = %lu frames (%lu bytes, %s rate)\n",
+           bars, loop_frames, loop_blocks * LOOPER_BLOCK_STRIDE, decimation > 1 ? "half" : "full");
+    return true;
+}
+
+void looper_set_overdub(bool enabled) {
+    overdub_requested = enabled;
+}
+
+void looper_clear(void) {
+    state = LOOPER_IDLE;
+    overdub_requested = false;
+    loop_frames = 0;
+    loop_blocks = 0;
+    current_block = 0;
+    block_pos = 0;
+    decimation = 1;
+
+    if (looper_memory) {
+        looper_memory = NULL;
+        if (memory_release) memory_release();
+    }
+}
+
+void looper_set_feedback(float feedback) {
+    if (feedback < 0.0f) feedback = 0.0f;
+    if (feedback > 1.0f) feedback = 1.0f;
+    feedback_q15 = (int32_t)(feedback * 32768.0f);
+}
+
+void looper_set_level(float level) {
+    if (level < 0.0f) level = 0.0f;
+    if (level > 1.0f) level = 1.0f;
+    level_q15 = (int32_t)(level * 32768.0f);
+}
+
+looper_state_t looper_get_state(void) {
+    return state;
+}
+
+uint32_t looper_get_max_bars(float bpm) {
+    if (bpm <= 0.0f) return 0;
+    return (uint32_t)((double)(num_blocks * LOOPER_BLOCK_FRAMES * MAX_DECIMATION) / bar_frames(bpm));
+}
+
+void looper_get_stats(looper_stats_t *stats) {
+    if (!stats) return;
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+
+    stats->memory_bytes = memory_bytes;
+    stats->used_bytes = loop_blocks * LOOPER_BLOCK_STRIDE;
+    stats->capacity_frames = num_blocks * LOOPER_BLOCK_FRAMES * MAX_DECIMATION;
+    stats->loop_frames = loop_frames;
+    stats->memory_held = (looper_memory != NULL);
+    stats->half_rate = (decimation > 1);
+    stats->encode_cycles = encode_blocks ?
+        (uint32_t)((uint64_t)encode_total_us * cycles_per_us / encode_blocks) : 0;
+    stats->decode_cycles = decode_blocks ?
+        (uint32_t)((uint64_t)decode_total_us * cycles_per_us / decode_blocks) : 0;
+}
+
+// ============================================================================
+// メイン処理
+// ============================================================================
+
+void looper_process(int16_t *left, int16_t *right, uint32_t num_samples) {
+    if (!is_initialized || state == LOOPER_IDLE) return;
+
+    uint32_t i = 0;
+
+    // 録音待ち: 小節頭から録音開始
+    if (state == LOOPER_ARMED) {
+        if (!find_bar_start(num_samples, &i)) {
+            return;
+        }
+        state = LOOPER_RECORDING;
+    }
+
+    for (; i < num_samples; i++) {
+        // ブロックの頭: オーバーダブの切り替えと再生ブロックのデコード
+        if (block_pos == 0 && state != LOOPER_RECORDING) {
+            state = overdub_requested ? LOOPER_OVERDUB : LOOPER_PLAYING;
+            decode_current_block();
+        }
+
+        // 入力（モノラルなら L+R の平均）
+        int32_t in[LOOPER_CHANNELS];
+#if LOOPER_CHANNELS == 1
+        in[0] = ((int32_t)left[i] + right[i]) >> 1;
+#else
+        in[0] = left[i];
+        in[1] = right[i];
+#endif
+
+        // 保存するサンプルの位置（半レートでは偶数フレームでだけ保存する）
+        uint32_t s = block_pos;
+        bool store = true;
+        uint32_t phase = 0;
+        if (decimation > 1) {
+            s = block_pos >> 1;
+            phase = block_pos & 1;
+            store = (phase == 0);
+            push_decimator(in);
+            if (store) {
+                for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) in[ch] = decimate(ch);
+                if (++up_pos >= RS_HIST_SAMPLES) up_pos = 0;
+            }
+        }
+
+        if (state == LOOPER_RECORDING) {
+            if (store) {
+                for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) {
+                    record_buf[ch][s] = (int16_t)in[ch];
+                    // 録音の終わりがそのまま再生の頭の補間の履歴になる
+                    if (decimation > 1) push_interpolator(ch, (int16_t)in[ch]);
+                }
+            }
+        } else {
+            int32_t play[LOOPER_CHANNELS];
+            for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) {
+                if (decimation > 1) {
+                    if (store) push_interpolator(ch, decode_buf[ch][s]);
+                    play[ch] = interpolate(ch, phase);
+                } else {
+                    play[ch] = decode_buf[ch][s];
+                }
+
+                // オーバーダブ: 保存済みのサンプル × フィードバック + 入力 を書き戻す
+                if (state == LOOPER_OVERDUB && store) {
+                    record_buf[ch][s] = saturate(((decode_buf[ch][s] * feedback_q15) >> 15) + in[ch]);
+                }
+            }
+
+            left[i] = saturate(left[i] + ((play[0] * level_q15) >> 15));
+            right[i] = saturate(right[i] + ((play[LOOPER_CHANNELS - 1] * level_q15) >> 15));
+        }
+
+        // ブロックの終わり: 録音/オーバーダブなら書き戻して次のブロックへ
+        uint32_t block_frames = current_block_frames();
+        if (++block_pos >= block_frames) {
+            if (state == LOOPER_RECORDING || state == LOOPER_OVERDUB) {
+                encode_current_block(stored_samples(block_frames));
+            }
+            block_pos = 0;
+
+            if (++current_block >= loop_blocks) {
+                current_block = 0;
+                if (state == LOOPER_RECORDING) {
+                    state = LOOPER_PLAYING;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/**
+ * @file looper.h
+ * @brief 小節単位のルーパー（ADPCM 圧縮メモリ、オーバーダブ対応） - ヘッダーファイル
+ *
+ * ビートクロックの小節頭から指定小節数を録音し、以降はビートクロックに合わせて
+ * ループ再生する。オーバーダブ中は再生音 × フィードバック + 入力を書き戻す。
+ *
+ * 音声は LOOPER_BLOCK_FRAMES サンプルごとに IMA-ADPCM（4ビット）で圧縮して保存する。
+ * ブロックごとに予測値とステップ番号をヘッダーに持つので、ブロック単位で
+ * 独立にデコード/再エンコードできる（オーバーダブはブロックごとに書き戻す）。
+ *
+ * 圧縮メモリは専用に持たず、録音の開始時に looper_set_memory() で登録した提供元から借り、
+ * looper_clear() で返す（Beat-Repeat のスライスバッファを使い回す）。
+ * 原レートで収まらないループは半レートで保存する（LOOPER_HALF_RATE_ENABLED）。
+ */
+
+#ifndef LOOPER_H
+#define LOOPER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief ルーパーの状態
+ */
+typedef enum {
+    LOOPER_IDLE = 0,      // ループなし
+    LOOPER_ARMED,         // 次の小節頭で録音開始
+    LOOPER_RECORDING,     // 録音中（ループ長に達したら再生へ）
+    LOOPER_PLAYING,       // 再生中
+    LOOPER_OVERDUB,       // 再生しながら重ね録り
+} looper_state_t;
+
+/**
+ * @brief ルーパーの統計
+ */
+typedef struct {
+    uint32_t memory_bytes;       // 圧縮メモリの総量（借りられる量）
+    uint32_t used_bytes;         // 現在のループが使っているメモリ
+    uint32_t capacity_frames;    // 録音できる最大フレーム数（半レートを含む）
+    uint32_t loop_frames;        // 現在のループ長
+    bool memory_held;            // 圧縮メモリを借りている
+    bool half_rate;              // 現在のループを半レートで保存している
+    uint32_t encode_cycles;      // 1ブロックのエンコード平均サイクル数
+    uint32_t decode_cycles;      // 1ブロックのデコード平均サイクル数
+} looper_stats_t;
+
+/**
+ * @brief 圧縮メモリを借りる関数の型定義
+ * @return メモリの先頭（NULL = 今は貸せない）
+ */
+typedef void *(*looper_memory_acquire_t)(void);
+
+/**
+ * @brief 借りた圧縮メモリを返す関数の型定義
+ */
+typedef void (*looper_memory_release_t)(void);
+
+/**
+ * @brief ルーパーの初期化
+ * @param sample_rate サンプリングレート（Hz）
+ * @return true 成功
+ */
+bool looper_init(uint32_t sample_rate);
+
+/**
+ * @brief 圧縮メモリの提供元を登録
+ * @param bytes 借りられるメモリの大きさ（バイト）
+ * @param acquire 録音の開始時に呼ぶ（メモリをまだ借りていないとき）
+ * @param release looper_clear() で呼ぶ（メモリを借りているとき）
+ */
+void looper_set_memory(uint32_t bytes, looper_memory_acquire_t acquire, looper_memory_release_t release);
+
+/**
+ * @brief 次の小節頭から録音を開始する
+ *
+ * 現在のテンポで収まらない場合は収まる小節数に減らす。
+ * 原レートで収まらなければ半レートで保存する。
+ *
+ * @param bars 小節数（4/4拍子）
+ * @return true 録音を予約した、false 1小節も収まらない、または圧縮メモリを借りられない
+ */
+bool looper_record(uint32_t bars);
+
+/**
+ * @brief オーバーダブの開始/終了（再生中のみ）
+ * @param enabled true = 重ね録り
+ */
+void looper_set_overdub(bool enabled);
+
+/**
+ * @brief ループを消去して停止（借りていた圧縮メモリを返す）
+ */
+void looper_clear(void);
+
+/**
+ * @brief オーバーダブ時に既存のループに掛けるフィードバック（0.0-1.0）
+ */
+void looper_set_feedback(float feedback);
+
+/**
+ * @brief ループ再生音のレベル（0.0-1.0）
+ */
+void looper_set_level(float level);
+
+/**
+ * @brief 現在の状態を取得
+ */
+looper_state_t looper_get_state(void);
+
+/**
+ * @brief 指定テンポで録音できる最大小節数（半レートを含む）
+ * @param bpm BPM
+ */
+uint32_t looper_get_max_bars(float bpm);
+
+/**
+ * @brief 統計を取得
+ */
+void looper_get_stats(looper_stats_t *stats);
+
+/**
+ * @brief ブロックを処理（録音/再生、出力に再生音をミックス）
+ *
+ * ビートクロックを進める前に呼ぶこと（ブロック先頭の拍位置で小節頭を探す）。
+ *
+ * @param left 左チャンネル（プレーナー、上書き）
+ * @param right 右チャンネル（プレーナー、上書き）
+ * @param num_samples ステレオペア数
+ */
+void looper_process(int16_t *left, int16_t *right, uint32_t num_samples);
+
+#endif // LOOPER_H
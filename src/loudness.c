@@ -0,0 +1,313 @@
+/**
+ * @file loudness.c
+ * @brief ラウドネスメーター（EBU R128）と低速 AGC の実装
+ *
+ * Kウェイティング係数は ITU-R BS.1770 のアナログ原型（libebur128 と同じ値）から
+ * 初期化時に双一次変換で求めるので、44.1kHz 以外のサンプルレートでも正しい。
+ * フィルタは単精度 float（RP2350 の FPU）で計算する。
+ */
+
+#include "loudness.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+// サブブロック長（100ms）と窓の長さ（サブブロック数）
+#define SUBBLOCKS_PER_SECOND   10
+#define MOMENTARY_SUBBLOCKS    4    // 400ms
+#define SHORT_TERM_SUBBLOCKS   30   // 3秒
+
+// EBU R128 の絶対ゲート（これ未満のブロックは無音扱い）
+#define ABSOLUTE_GATE_LUFS     -70.0f
+
+#define SAMPLE_MAX             32767
+#define SAMPLE_MIN             -32768
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+typedef struct {
+    float b0, b1, b2, a1, a2;
+} biquad_coeffs_t;
+
+typedef struct {
+    float z1, z2;
+} biquad_state_t;
+
+// Kウェイティング: 段1 = ハイシェルフ、段2 = RLB ハイパス
+static biquad_coeffs_t k_shelf;
+static biquad_coeffs_t k_highpass;
+static biquad_state_t k_state[2][2];  // [チャンネル][段]
+
+// サブブロックの集計
+static uint32_t subblock_frames = AUDIO_SAMPLE_RATE / SUBBLOCKS_PER_SECOND;
+static uint32_t subblock_pos = 0;
+static float subblock_energy = 0.0f;
+
+// サブブロックごとの平均二乗値の履歴と移動和
+static double subblock_history[SHORT_TERM_SUBBLOCKS];
+static uint32_t history_pos = 0;
+static uint32_t history_count = 0;
+static double momentary_sum = 0.0;
+static double short_term_sum = 0.0;
+
+static float momentary_lufs = LOUDNESS_SILENCE_LUFS;
+static float short_term_lufs = LOUDNESS_SILENCE_LUFS;
+
+// AGC
+static bool agc_enabled = LOUDNESS_AGC_ENABLED;
+static float agc_gain_db = 0.0f;
+static float agc_gain_lin = 1.0f;         // 現在ブロックの開始ゲイン
+static float agc_target_gain_lin = 1.0f;  // サブブロックごとに更新される目標ゲイン
+
+// 処理コスト
+static uint32_t cost_total_us = 0;
+static uint32_t cost_max_us = 0;
+static uint32_t cost_blocks = 0;
+
+static bool is_initialized = false;
+
+// ============================================================================
+// Kウェイティングフィルタ
+// ============================================================================
+
+static void design_k_weighting(uint32_t sample_rate) {
+    double rate = (double)sample_rate;
+
+    // 段1: ハイシェルフ（+4dB @ 高域）
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10.0, gain / 20.0);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+
+    k_shelf.b0 = (float)((vh + vb * k / q + k * k) / a0);
+    k_shelf.b1 = (float)(2.0 * (k * k - vh) / a0);
+    k_shelf.b2 = (float)((vh - vb * k / q + k * k) / a0);
+    k_shelf.a1 = (float)(2.0 * (k * k - 1.0) / a0);
+    k_shelf.a2 = (float)((1.0 - k / q + k * k) / a0);
+
+    // 段2: RLB ハイパス（約38Hz）
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+
+    k_highpass.b0 = 1.0f;
+    k_highpass.b1 = -2.0f;
+    k_highpass.b2 = 1.0f;
+    k_highpass.a1 = (float)(2.0 * (k * k - 1.0) / a0);
+    k_highpass.a2 = (float)((1.0 - k / q + k * k) / a0);
+}
+
+// 転置直接形 II
+static inline float biquad_run(const biquad_coeffs_t *c, biquad_state_t *s, float x) {
+    float y = c->b0 * x + s->z1;
+    s->z1 = c->b1 * x - c->a1 * y + s->z2;
+    s->z2 = c->b2 * x - c->a2 * y;
+    return y;
+}
+
+// ============================================================================
+// ヘルパー関数
+// ============================================================================
+
+static inline float energy_to_lufs(double mean_square) {
+    if (mean_square <= 0.0) return LOUDNESS_SILENCE_LUFS;
+    float lufs = -0.691f + 10.0f * log10f((float)mean_square);
+    return (lufs < LOUDNESS_SILENCE_LUFS) ? LOUDNESS_SILENCE_LUFS : lufs;
+}
+
+/**
+ * @brief サブブロック（100ms）の確定: 移動和の更新と AGC 目標ゲインの計算
+ */
+static void finish_subblock(void) {
+    // L + R の二乗和をフレーム数で割る（チャンネル重み 1.0）
+    double mean_square = (double)subblock_energy / (double)subblock_frames;
+    subblock_energy = 0.0f;
+
+    // 3秒窓: 最も古いサブブロックを引いて新しいものを足す
+    double oldest = subblock_history[history_pos];
+    short_term_sum += mean_square - oldest;
+
+    // 400ms窓: 4つ前のサブブロックを引く
+    uint32_t m_old_pos = (history_pos + SHORT_TERM_SUBBLOCKS - MOMENTARY_SUBBLOCKS) % SHORT_TERM_SUBBLOCKS;
+    momentary_sum += mean_square - subblock_history[m_old_pos];
+
+    subblock_history[history_pos] = mean_square;
+    history_pos = (history_pos + 1) % SHORT_TERM_SUBBLOCKS;
+    if (history_count < SHORT_TERM_SUBBLOCKS) history_count++;
+
+    // 浮動小数点の引き算で負になるのを防ぐ
+    if (momentary_sum < 0.0) momentary_sum = 0.0;
+    if (short_term_sum < 0.0) short_term_sum = 0.0;
+
+    uint32_t m_count = (history_count < MOMENTARY_SUBBLOCKS) ? history_count : MOMENTARY_SUBBLOCKS;
+    momentary_lufs = energy_to_lufs(momentary_sum / m_count);
+    short_term_lufs = energy_to_lufs(short_term_sum / history_count);
+
+    // AGC: 無音や曲間ではゲインを動かさない（ゲート）
+    if (short_term_lufs < ABSOLUTE_GATE_LUFS || short_term_lufs < LOUDNESS_AGC_GATE_LUFS) {
+        return;
+    }
+
+    float desired_db = LOUDNESS_AGC_TARGET_LUFS - short_term_lufs;
+    if (desired_db > LOUDNESS_AGC_MAX_GAIN_DB) desired_db = LOUDNESS_AGC_MAX_GAIN_DB;
+    if (desired_db < LOUDNESS_AGC_MIN_GAIN_DB) desired_db = LOUDNESS_AGC_MIN_GAIN_DB;
+
+    // スルーレート制限（dB/秒 → dB/サブブロック）
+    float max_step = LOUDNESS_AGC_SLEW_DB_PER_SEC / (float)SUBBLOCKS_PER_SECOND;
+    float delta = desired_db - agc_gain_db;
+    if (delta > max_step) delta = max_step;
+    if (delta < -max_step) delta = -max_step;
+
+    agc_gain_db += delta;
+    agc_target_gain_lin = powf(10.0f, agc_gain_db / 20.0f);
+}
+
+// ============================================================================
+// 初期化・リセット
+// ============================================================================
+
+bool loudness_init(uint32_t sample_rate) {
+    subblock_frames = sample_rate / SUBBLOCKS_PER_SECOND;
+    design_k_weighting(sample_rate);
+    loudness_reset();
+
+    is_initialized = true;
+
+    printf("[LOUDNESS] K-weighted meter: %lu frames/subblock, M=400ms, S=3s\n",
+           subblock_frames);
+    printf("[LOUDNESS] AGC: %s (target %.1f LUFS, %.1f..%.1f dB, %.1f dB/s)\n",
+           agc_enabled ? "ON" : "OFF", LOUDNESS_AGC_TARGET_LUFS,
+           LOUDNESS_AGC_MIN_GAIN_DB, LOUDNESS_AGC_MAX_GAIN_DB, LOUDNESS_AGC_SLEW_DB_PER_SEC);
+
+    return true;
+}
+
+void loudness_reset(void) {
+    memset(k_state, 0, sizeof(k_state));
+    memset(subblock_history, 0, sizeof(subblock_history));
+    subblock_pos = 0;
+    subblock_energy = 0.0f;
+    history_pos = 0;
+    history_count = 0;
+    momentary_sum = 0.0;
+    short_term_sum = 0.0;
+    momentary_lufs = LOUDNESS_SILENCE_LUFS;
+    short_term_lufs = LOUDNESS_SILENCE_LUFS;
+    agc_gain_db = 0.0f;
+    agc_gain_lin = 1.0f;
+    agc_target_gain_lin = 1.0f;
+}
+
+// ============================================================================
+// メイン処理
+// ============================================================================
+
+void loudness_process(int16_t *left, int16_t *right, uint32_t num_samples) {
+    if (!is_initialized || !left || !right) return;
+
+    uint32_t start_us = time_us_32();
+
+    const float scale = 1.0f / 32768.0f;
+
+    // ブロック内のゲインランプ（目標はサブブロック境界でしか変わらない）
+    float gain = agc_gain_lin;
+    float gain_step = agc_enabled ?
+        (agc_target_gain_lin - agc_gain_lin) / (float)num_samples : 0.0f;
+
+    for (uint32_t i = 0; i < num_samples; i++) {
+        int16_t in_l = left[i];
+        int16_t in_r = right[i];
+
+        // 計測（AGC 適用前）
+        float kl = biquad_run(&k_highpass, &k_state[0][1],
+                              biquad_run(&k_shelf, &k_state[0][0], (float)in_l * scale));
+        float kr = biquad_run(&k_highpass, &k_state[1][1],
+                              biquad_run(&k_shelf, &k_state[1][0], (float)in_r * scale));
+        subblock_energy += kl * kl + kr * kr;
+
+        if (++subblock_pos >= subblock_frames) {
+            subblock_pos = 0;
+            finish_subblock();
+        }
+
+        // AGC ゲイン適用
+        if (agc_enabled) {
+            gain += gain_step;
+            int32_t out_l = (int32_t)((float)in_l * gain);
+            int32_t out_r = (int32_t)((float)in_r * gain);
+            if (out_l > SAMPLE_MAX) out_l = SAMPLE_MAX;
+            if (out_l < SAMPLE_MIN) out_l = SAMPLE_MIN;
+            if (out_r > SAMPLE_MAX) out_r = SAMPLE_MAX;
+            if (out_r < SAMPLE_MIN) out_r = SAMPLE_MIN;
+            left[i] = (int16_t)out_l;
+            right[i] = (int16_t)out_r;
+        }
+    }
+
+    if (agc_enabled) {
+        agc_gain_lin = gain;
+    }
+
+    // 処理コストの記録
+    uint32_t elapsed_us = time_us_32() - start_us;
+    cost_total_us += elapsed_us;
+    cost_blocks++;
+    if (elapsed_us > cost_max_us) cost_max_us = elapsed_us;
+}
+
+// ============================================================================
+// 状態取得・設定
+// ============================================================================
+
+float loudness_get_momentary(void) {
+    return momentary_lufs;
+}
+
+float loudness_get_short_term(void) {
+    return short_term_lufs;
+}
+
+float loudness_get_agc_gain_db(void) {
+    return agc_enabled ? agc_gain_db : 0.0f;
+}
+
+void loudness_set_agc_enabled(bool enabled) {
+    agc_enabled = enabled;
+    if (!enabled) {
+        agc_gain_db = 0.0f;
+        agc_gain_lin = 1.0f;
+        agc_target_gain_lin = 1.0f;
+    }
+    printf("[LOUDNESS] AGC %s\n", enabled ? "ON" : "OFF");
+}
+
+bool loudness_get_agc_enabled(void) {
+    return agc_enabled;
+}
+
+void loudness_get_cycles(uint32_t *avg_cycles, uint32_t *max_cycles) {
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    if (avg_cycles) {
+        *avg_cycles = cost_blocks ? (uint32_t)((uint64_t)cost_total_us * cycles_per_us / cost_blocks) : 0;
+    }
+    if (max_cycles) *max_cycles = cost_max_us * cycles_per_us;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file loudness.h
+ * @brief ラウドネスメーター（EBU R128 モーメンタリー/ショートターム）と低速 AGC - ヘッダーファイル
+ *
+ * Kウェイティング（シェルフ + ハイパスの2段バイカッド）をかけた信号の二乗平均を
+ * 100ms のサブブロックごとに集計し、400ms / 3秒の窓を移動和で求める（ブロックあたり O(1)）。
+ * AGC はショートタームラウドネスを目標 LUFS に近づけるよう、ゆっくりとゲインを動かす。
+ */
+
+#ifndef LOUDNESS_H
+#define LOUDNESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 無音時に返すラウドネス値（LUFS）
+#define LOUDNESS_SILENCE_LUFS  -120.0f
+
+/**
+ * @brief ラウドネスメーターの初期化
+ * @param sample_rate サンプリングレート（Hz）
+ * @return true 成功
+ */
+bool loudness_init(uint32_t sample_rate);
+
+/**
+ * @brief ブロックを計測し、AGC が有効ならゲインを適用
+ *
+ * 計測は AGC 適用前の信号で行う。ゲインはブロック内で線形にランプする。
+ *
+ * @param left 左チャンネル（プレーナー、上書き）
+ * @param right 右チャンネル（プレーナー、上書き）
+ * @param num_samples ステレオペア数
+ */
+void loudness_process(int16_t *left, int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief モーメンタリーラウドネス（400ms窓）を取得
+ * @return LUFS
+ */
+float loudness_get_momentary(void);
+
+/**
+ * @brief ショートタームラウドネス（3秒窓）を取得
+ * @return LUFS
+ */
+float loudness_get_short_term(void);
+
+/**
+ * @brief 現在の AGC ゲインを取得
+ * @return ゲイン（dB）
+ */
+float loudness_get_agc_gain_db(void);
+
+/**
+ * @brief AGC の有効/無効を設定
+ * @param enabled true = 有効
+ */
+void loudness_set_agc_enabled(bool enabled);
+
+/**
+ * @brief AGC が有効か確認
+ * @return true 有効
+ */
+bool loudness_get_agc_enabled(void);
+
+/**
+ * @brief 処理コストを取得（デバッグ用）
+ * @param avg_cycles ブロックあたりの平均サイクル数
+ * @param max_cycles ブロックあたりの最大サイクル数
+ */
+void loudness_get_cycles(uint32_t *avg_cycles, uint32_t *max_cycles);
+
+/**
+ * @brief 計測窓と AGC ゲインをリセット
+ */
+void loudness_reset(void);
+
+#endif // LOUDNESS_H
@@ -8,6 +8,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include "pico/stdlib.h"
 #include "pico/cyw43_arch.h"
@@ -15,8 +16,26 @@
 #include "config.h"
 #include "bt_audio.h"
 #include "audio_out_i2s.h"
+#include "audio_out_pwm.h"
 #include "audio_effect.h"
+#include "audio_route.h"
+#include "dma_irq.h"
+#include "audio_split.h"
+#include "loudness.h"
+#include "beat_clock.h"
+#include "mod_matrix.h"
+#include "looper.h"
+#include "sampler.h"
+#include "latency.h"
 #include "tap_tempo.h"
+#include "delay_report.h"
+#include "link_monitor.h"
+#include "control.h"
+#include "trace.h"
+#include "sram_layout.h"
+#include "recorder.h"
+#include "varispeed.h"
+#include "trance_gate.h"
 
 // ============================================================================
 // グローバル変数
@@ -24,14 +43,17 @@
 
 static absolute_time_t last_status_log_time;
 static float last_bpm = 0.0f;  // 前回のBPM（変更検出用）
+static float last_speed = 1.0f;  // スライス長を合わせたバリスピードの速度
+static int i2s_output_id = -1;  // ルーティング上のI2S出力ID
+static absolute_time_t last_delay_sample_time;
+static absolute_time_t last_link_update_time;
 
 // ============================================================================
 // PCM データ受信コールバック
 // ============================================================================
 
-static void pcm_data_handler(const int16_t *pcm_data, uint32_t num_samples,
-                              uint8_t channels, uint32_t sample_rate) {
-    (void)channels;      // I2Sはステレオ固定
+static void pcm_data_handler(const int16_t *left, const int16_t *right,
+                              uint32_t num_samples, uint32_t sample_rate) {
     (void)sample_rate;   // サンプルレートは設定済み
 
     static uint32_t pcm_total_count = 0;
@@ -41,11 +63,10 @@ static void pcm_data_handler(const int16_t *pcm_data, uint32_t num_samples,
     pcm_total_count++;
     pcm_total_samples += num_samples;
 
-    // I2S 出力にPCMデータを書き込み
-    uint32_t written = audio_out_i2s_write(pcm_data, num_samples);
+    // エフェクト後タップに接続された出力（通常は I2S）にPCMデータを書き込み
+    uint32_t dropped = audio_route_process(AUDIO_TAP_POST_EFFECT, left, right, num_samples);
 
-    if (written < num_samples) {
-        uint32_t dropped = num_samples - written;
+    if (dropped > 0) {
         pcm_dropped += dropped;
 #ifdef ENABLE_DEBUG_LOG
         printf("WARNING: Audio buffer full, dropped %lu samples (total dropped: %lu)\n",
@@ -60,6 +81,71 @@ static void pcm_data_handler(const int16_t *pcm_data, uint32_t num_samples,
     }
 }
 
+// ============================================================================
+// 適応バッファの更新
+// ============================================================================
+
+static void update_link_buffering(void) {
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    static uint32_t last_underruns = 0;
+
+    absolute_time_t now = get_absolute_time();
+    if (absolute_time_diff_us(last_link_update_time, now) < LINK_UPDATE_MS * 1000) {
+        return;
+    }
+    last_link_update_time = now;
+
+    // アンダーランもリンク劣化の兆候として扱う（カウンタは切断時にクリアされる）
+    uint32_t underruns, overruns;
+    audio_out_i2s_get_stats(&underruns, &overruns);
+    if (underruns < last_underruns) {
+        last_underruns = 0;
+    }
+    if (underruns > last_underruns) {
+        link_monitor_on_underrun(time_us_32());
+        last_underruns = underruns;
+    }
+
+    // 目標深さと開始閾値を出力に反映
+    audio_out_i2s_set_target_depth(link_monitor_get_target_frames());
+#endif
+}
+
+// ============================================================================
+// 遅延レポートの更新
+// ============================================================================
+
+static void update_delay_report(void) {
+#if DELAY_REPORT_ENABLED
+    absolute_time_t now = get_absolute_time();
+    if (absolute_time_diff_us(last_delay_sample_time, now) < DELAY_REPORT_SAMPLE_MS * 1000) {
+        return;
+    }
+    last_delay_sample_time = now;
+
+    // DMA が動き出すまで（プリロール中）は遅延が定まらない
+    uint32_t dma_frames = audio_out_i2s_get_dma_frames();
+    if (dma_frames == 0) {
+        return;
+    }
+
+    // I2S のリングバッファがジッターバッファを兼ねる
+    delay_report_state_t state = {
+        .ring_frames = audio_out_i2s_get_buffered_samples(),
+        .dma_frames = dma_frames,
+        .pipeline_frames = latency_get_total(),
+    };
+
+    uint16_t delay_100us;
+    if (delay_report_update(&state, bt_audio_get_sample_rate(),
+                            to_ms_since_boot(now), &delay_100us)) {
+        if (bt_audio_send_delay_report(delay_100us)) {
+            printf("[DELAY] Reported %u.%u ms to source\n", delay_100us / 10, delay_100us % 10);
+        }
+    }
+#endif
+}
+
 // ============================================================================
 // バッファ状態のログ出力
 // ============================================================================
@@ -80,8 +166,31 @@ static void log_buffer_status(void) {
     uint32_t underruns, overruns;
     audio_out_i2s_get_stats(&underruns, &overruns);
 
-    printf("[I2S] Buffer: %lu/%u samples | Free: %lu | Underruns: %lu | Overruns: %lu\n",
-           buffered, AUDIO_BUFFER_SIZE, free_space, underruns, overruns);
+    printf("[I2S] Buffer: %lu/%u samples | Free: %lu | Underruns: %lu | Overruns: %lu | Dropped: %lu\n",
+           buffered, AUDIO_BUFFER_SIZE, free_space, underruns, overruns,
+           audio_route_get_dropped(i2s_output_id));
+
+    // 登録せずに DMA_IRQ_0 を有効にしたチャンネルがある
+    uint32_t stray_irqs = dma_irq_get_stray_count();
+    if (stray_irqs > 0) {
+        printf("  WARNING: %lu DMA IRQ flags on unregistered channels\n", stray_irqs);
+    }
+
+#if LINK_ADAPTIVE_BUFFER_ENABLED
+    link_monitor_stats_t link;
+    link_monitor_get_stats(&link);
+    printf("[LINK] Target: %lu frames (%.1f ms) | Drawdown: %lu | Jitter: %lu us | Gaps: %lu | Flow events: %lu | Underruns: %lu | RSSI: %d dBm\n",
+           link.target_frames, (float)link.target_frames * 1000.0f / AUDIO_SAMPLE_RATE,
+           link.drawdown_frames, link.jitter_us, link.gaps, link.flow_events, link.underruns,
+           link.rssi_dbm);
+#endif
+
+#if DELAY_REPORT_ENABLED
+    uint16_t delay_now = delay_report_get_current();
+    uint16_t delay_sent = delay_report_get_last_sent();
+    printf("[DELAY] Measured: %u.%u ms | Reported: %u.%u ms\n",
+           delay_now / 10, delay_now % 10, delay_sent / 10, delay_sent % 10);
+#endif
 
     // バッファ状態の警告
     if (buffered < BUFFER_LOW_THRESHOLD) {
@@ -89,6 +198,125 @@ static void log_buffer_status(void) {
     } else if (buffered > BUFFER_HIGH_THRESHOLD) {
         printf("  WARNING: Buffer level high!\n");
     }
+
+#if USE_PWM_OUTPUT
+    uint32_t pwm_underruns, pwm_overruns;
+    audio_out_pwm_get_stats(&pwm_underruns, &pwm_overruns);
+    printf("[PWM] Buffer: %lu/%u samples | Underruns: %lu | Overruns: %lu\n",
+           audio_out_pwm_get_buffered_samples(), PWM_BUFFER_SIZE,
+           pwm_underruns, pwm_overruns);
+#endif
+
+#if LOUDNESS_METER_ENABLED
+    uint32_t avg_cycles, max_cycles;
+    loudness_get_cycles(&avg_cycles, &max_cycles);
+    printf("[LOUDNESS] M: %.1f LUFS | S: %.1f LUFS | AGC: %+.1f dB | Cost: %lu avg / %lu max cycles/block\n",
+           loudness_get_momentary(), loudness_get_short_term(),
+           loudness_get_agc_gain_db(), avg_cycles, max_cycles);
+#endif
+
+#if VARISPEED_ENABLED
+    varispeed_stats_t vs;
+    varispeed_get_stats(&vs);
+    if (vs.requested != 1.0f || vs.current != 1.0f) {
+        printf("[VARISPEED] Requested: %+.1f%% | Current: %+.2f%% | Limit: %+.2f%% | Capped: %lu blocks | Cost: %lu avg / %lu max cycles/block\n",
+               (vs.requested - 1.0f) * 100.0f, (vs.current - 1.0f) * 100.0f, (vs.limit - 1.0f) * 100.0f,
+               vs.capped_blocks, vs.avg_cycles, vs.max_cycles);
+    }
+#endif
+
+#if LOOPER_ENABLED
+    looper_stats_t looper_stats;
+    looper_get_stats(&looper_stats);
+    printf("[LOOPER] State: %d | Loop: %lu frames (%s rate) | Memory: %lu/%lu bytes%s | Encode: %lu / Decode: %lu cycles/block\n",
+           looper_get_state(), looper_stats.loop_frames, looper_stats.half_rate ? "half" : "full",
+           looper_stats.used_bytes, looper_stats.memory_bytes,
+           looper_stats.memory_held ? " (Beat-Repeat bypassed)" : "",
+           looper_stats.encode_cycles, looper_stats.decode_cycles);
+#endif
+
+#if SAMPLER_ENABLED
+    if (sampler_get_bank_size() > 0) {
+        sampler_stats_t sampler_stats;
+        sampler_get_stats(&sampler_stats);
+        printf("[SAMPLER] Bank: %lu | Triggers: %lu | DMA transfers: %lu | Underruns: %lu frames | Max queue: %lu\n",
+               sampler_get_bank_size(), sampler_stats.triggers, sampler_stats.transfers,
+               sampler_stats.underruns, sampler_stats.max_queue_depth);
+    }
+#endif
+
+    uint32_t pipeline_latency = latency_get_total();
+    if (pipeline_latency > 0) {
+        printf("[LATENCY] Pipeline: %lu frames (%.2f ms) | Dry tap compensation: %lu frames | Pool: %lu/%d frames\n",
+               pipeline_latency, (float)pipeline_latency * 1000.0f / AUDIO_SAMPLE_RATE,
+               latency_get_compensation(AUDIO_TAP_PRE_EFFECT), latency_get_pool_used(),
+               LATENCY_POOL_FRAMES);
+    }
+
+    beat_repeat_params_t effect_params;
+    audio_effect_get_params(&effect_params);
+    uint32_t slice_clamps = audio_effect_get_slice_clamps();
+    if (slice_clamps > 0) {
+        printf("[EFFECT] Slice length clamped: %lu times\n", slice_clamps);
+    }
+    if (effect_params.multiband_enabled) {
+        uint32_t mb_avg, mb_max;
+        audio_effect_get_multiband_cycles(&mb_avg, &mb_max);
+        printf("[MULTIBAND] %d bands | Crossover: %lu avg / %lu max cycles/chunk (256 frames, L+R)\n",
+               EFFECT_MULTIBAND_BANDS, mb_avg, mb_max);
+    }
+    if (effect_params.repeat_trigger == REPEAT_TRIGGER_TRANSIENT) {
+        uint32_t td_detections, td_triggers, td_avg, td_max;
+        audio_effect_get_transient_stats(&td_detections, &td_triggers, &td_avg, &td_max);
+        printf("[TRANSIENT] Detected: %lu | Triggered: %lu | Threshold: %.2f | Cost: %lu avg / %lu max cycles/chunk\n",
+               td_detections, td_triggers, effect_params.transient_threshold, td_avg, td_max);
+    }
+
+#if TRANCE_GATE_ENABLED
+    if (trance_gate_get_enabled()) {
+        uint32_t gate_avg, gate_max;
+        trance_gate_get_cycles(&gate_avg, &gate_max);
+        printf("[GATE] Depth: %.0f%% | %lu steps/beat | Duty: %.0f%% | Cost: %lu avg / %lu max cycles/block\n",
+               trance_gate_get_depth() * 100.0f, trance_gate_get_rate(),
+               trance_gate_get_duty() * 100.0f, gate_avg, gate_max);
+    }
+#endif
+
+#if RECORDER_ENABLED
+    if (recorder_get_state() >= RECORDER_STATE_RECORDING) {
+        recorder_stats_t rec;
+        recorder_get_stats(&rec);
+        printf("[REC] Written: %lu KB | Dropped: %lu frames (%lu events) | Staging peak: %lu/%d | Max write: %lu us | Errors: %lu\n",
+               rec.data_bytes / 1024, rec.dropped_frames, rec.drop_events, rec.staging_peak,
+               RECORDER_STAGING_BYTES, rec.max_write_us, rec.write_errors);
+    }
+#endif
+
+#if SRAM_BUS_COUNTERS_ENABLED
+    // 競合率 = 調停で待たされたアクセス / 全アクセス（起動からの積算）
+    sram_bus_stats_t bus;
+    sram_layout_get_bus_stats(&bus);
+    printf("[BUS] Scratch X: %llu acc, %.3f%% contested | SRAM0: %llu acc, %.3f%% contested | Saturated: %lu\n",
+           bus.count[0], bus.count[0] ? 100.0 * (double)bus.count[1] / (double)bus.count[0] : 0.0,
+           bus.count[2], bus.count[2] ? 100.0 * (double)bus.count[3] / (double)bus.count[2] : 0.0,
+           bus.saturated);
+#endif
+
+    // スタックの最大使用量（scratch Y の .scratch_y の上、MSPLIM で越えるとフォールト）
+    sram_stack_stats_t stack;
+    sram_layout_get_stack_stats(&stack);
+    printf("[STACK] High water: %lu/%lu bytes (%lu free)%s\n",
+           stack.high_water, stack.size, stack.size - stack.high_water,
+           !stack.canary_intact ? " - OVERFLOWED"
+           : (stack.size - stack.high_water < SRAM_STACK_WARN_MARGIN) ? " - LOW" : "");
+
+    uint32_t mod_routes = mod_matrix_get_active_routes();
+    if (mod_routes > 0) {
+        uint32_t mod_cycles, route_cycles;
+        mod_matrix_get_cycles(&mod_cycles, &route_cycles);
+        printf("[MOD] Routes: %lu | Cost: %lu cycles/sub-block (%lu per route) | Tempo: %.1f BPM\n",
+               mod_routes, mod_cycles, route_cycles, beat_clock_get_bpm());
+    }
 }
 
 // ============================================================================
@@ -106,29 +334,67 @@ static void update_effect_from_tap_tempo(void) {
     // BPMが変更されたらエフェクトパラメータを更新
     if (current_bpm != last_bpm) {
         note_division_t division = tap_tempo_get_note_division();
-        uint32_t slice_length = tap_tempo_bpm_to_slice_length(
+        uint64_t slice_length_q32 = tap_tempo_bpm_to_slice_length_q32(
             current_bpm, division, AUDIO_SAMPLE_RATE);
+        double slice_length = (double)slice_length_q32 / 4294967296.0;
 
-        // エフェクトパラメータを更新
+        // エフェクトパラメータを更新（小数部も渡してビートからのずれを防ぐ）
         beat_repeat_params_t params;
         audio_effect_get_params(&params);
-        params.slice_length = slice_length;
+        params.slice_length = (uint32_t)(slice_length_q32 >> 32);
+        params.slice_length_frac = (uint32_t)slice_length_q32;
         audio_effect_set_params(&params);
 
+        // モジュレーションのテンポを合わせ、最後のタップを拍頭にする
+        beat_clock_set_bpm(current_bpm);
+        beat_clock_sync();
+
         printf("\n[EFFECT] Updated from tap tempo:\n");
         printf("  BPM: %.1f\n", current_bpm);
-        printf("  Slice length: %lu samples (%.2f ms)\n",
-               slice_length, (float)slice_length * 1000.0f / AUDIO_SAMPLE_RATE);
+        printf("  Slice length: %.2f samples (%.2f ms)\n",
+               slice_length, slice_length * 1000.0 / AUDIO_SAMPLE_RATE);
 
         last_bpm = current_bpm;
     }
 }
 
+// ============================================================================
+// バリスピードに合わせたスライス長の更新
+// ============================================================================
+
+#if VARISPEED_ENABLED
+/**
+ * @brief 速度が変わったらスライス長を出力の拍の長さに合わせる
+ *
+ * バリスピードはエフェクトの前に掛かるので、1拍の出力フレーム数は 1/速度 倍になる。
+ * ランプ中に毎ブロック設定し直さないよう、0.1% 以上変わったときだけ更新する。
+ */
+static void update_effect_from_varispeed(void) {
+    float speed = varispeed_get_current_speed();
+    if (fabsf(speed - last_speed) < 0.001f * last_speed && (speed != 1.0f || last_speed == 1.0f)) {
+        return;
+    }
+
+    beat_repeat_params_t params;
+    audio_effect_get_params(&params);
+    uint64_t slice_length_q32 = ((uint64_t)params.slice_length << 32) | params.slice_length_frac;
+    slice_length_q32 = (uint64_t)((double)slice_length_q32 * (double)last_speed / (double)speed);
+    params.slice_length = (uint32_t)(slice_length_q32 >> 32);
+    params.slice_length_frac = (uint32_t)slice_length_q32;
+    audio_effect_update_params(&params);
+
+    last_speed = speed;
+}
+#endif
+
 // ============================================================================
 // メイン関数
 // ============================================================================
 
 int main(void) {
+    // スタックの監視（使用量を測るためにまだ使っていない部分を塗る）
+    sram_layout_stack_init();
+
     // 標準入出力の初期化
     stdio_init_all();
 
@@ -144,7 +410,7 @@ int main(void) {
     // 設定情報を表示
     printf("Configuration:\n");
     printf("  Device name: %s\n", BT_DEVICE_NAME);
-    printf("  Output mode: I2S DAC\n");
+    printf("  Output mode: I2S DAC%s\n", USE_PWM_OUTPUT ? " + PWM cue" : "");
     printf("  I2S pins: DATA=%d, BCLK=%d, LRCLK=%d\n",
            I2S_DATA_PIN, I2S_BCLK_PIN, I2S_LRCLK_PIN);
     printf("  Sample rate: %d Hz\n", AUDIO_SAMPLE_RATE);
@@ -160,6 +426,36 @@ int main(void) {
         return 1;
     }
     // 注意: audio_out_i2s_start() はバッファが十分に埋まったら自動的に開始されます
+#if I2S_QUAD_OUTPUT
+    // 4チャンネル出力: 振り分けノード経由で2組の DAC に書き込む
+    audio_split_init(AUDIO_SAMPLE_RATE, I2S_CROSSOVER_FREQ_HZ);
+#if I2S_QUAD_MODE == I2S_QUAD_MODE_CROSSOVER
+    i2s_output_id = audio_route_add_output("I2S A/B (crossover)", audio_split_write_crossover,
+                                           I2S_OUTPUT_TAP);
+#else
+    audio_route_add_output("I2S A (dry)", audio_split_write_dry, AUDIO_TAP_PRE_EFFECT);
+    i2s_output_id = audio_route_add_output("I2S B (wet)", audio_split_write_wet,
+                                           AUDIO_TAP_POST_EFFECT);
+#endif
+#else
+    i2s_output_id = audio_route_add_output("I2S", audio_out_i2s_write, I2S_OUTPUT_TAP);
+#endif
+
+#if USE_PWM_OUTPUT
+    // PWM キュー出力の初期化（失敗しても I2S 再生は続行）
+    if (audio_out_pwm_init(AUDIO_SAMPLE_RATE)) {
+        audio_route_add_output("PWM", audio_out_pwm_write, PWM_OUTPUT_TAP);
+    } else {
+        printf("WARNING: Failed to initialize PWM audio output\n");
+    }
+#endif
+
+#if RECORDER_ENABLED
+    // SD カード録音（カードや録音ファイルがなくても再生は続行）
+    if (recorder_init()) {
+        audio_route_add_output("SD recorder", recorder_write, RECORDER_TAP);
+    }
+#endif
 
     printf("\n");
 
@@ -172,6 +468,12 @@ int main(void) {
     // PCM データコールバックを設定
     bt_audio_set_pcm_callback(pcm_data_handler);
 
+#if DELAY_REPORT_ENABLED
+    // 遅延レポート（ヒステリシスは 1/10 ms 単位で渡す）
+    delay_report_init(DELAY_REPORT_HYSTERESIS_MS * 10, DELAY_REPORT_MIN_INTERVAL_MS,
+                      DELAY_REPORT_SMOOTHING);
+#endif
+
     printf("\n");
 
     // タップテンポの初期化
@@ -183,18 +485,48 @@ int main(void) {
     printf("\n");
     printf("Setting default BPM: 120\n");
     note_division_t default_division = tap_tempo_get_note_division();
-    uint32_t default_slice_length = tap_tempo_bpm_to_slice_length(
+    uint64_t default_slice_length_q32 = tap_tempo_bpm_to_slice_length_q32(
         120.0f, default_division, AUDIO_SAMPLE_RATE);
 
     beat_repeat_params_t params;
     audio_effect_get_params(&params);
-    params.slice_length = default_slice_length;
+    params.slice_length = (uint32_t)(default_slice_length_q32 >> 32);
+    params.slice_length_frac = (uint32_t)default_slice_length_q32;
     audio_effect_set_params(&params);
 
     last_bpm = 120.0f;  // BPM 120で初期化
+    beat_clock_set_bpm(120.0f);
+
+#if MOD_MATRIX_DEMO_ROUTES
+    // デモ用のモジュレーションルート
+    mod_source_params_t lfo_wet = {
+        .shape = MOD_SHAPE_TRIANGLE, .period_beats = 4.0f, .phase = 0.0f,
+    };
+    mod_source_params_t lfo_loop = {
+        .shape = MOD_SHAPE_SAMPLE_HOLD, .period_beats = 0.5f, .phase = 0.0f,
+    };
+    mod_matrix_set_source(0, &lfo_wet);
+    mod_matrix_set_source(1, &lfo_loop);
+    mod_matrix_add_route(0, MOD_DEST_WET_MIX, 30.0f);
+    mod_matrix_add_route(1, MOD_DEST_LOOP_START, 0.25f);
+    printf("Modulation demo routes: %lu\n", mod_matrix_get_active_routes());
+#endif
 
     printf("Effect initialized with BPM 120 (%.2f ms slice)\n",
-           (float)default_slice_length * 1000.0f / AUDIO_SAMPLE_RATE);
+           (double)default_slice_length_q32 / 4294967296.0 * 1000.0 / AUDIO_SAMPLE_RATE);
+
+#if CONTROL_ENABLED
+    // 制御プロトコル（プリセットは起動時のパラメータで埋める）
+    control_init();
+#endif
+
+#if TRACE_ENABLED
+    // タイムライントレース（記録のオーバーヘッドを計測してから記録を始める）
+    trace_init();
+#endif
+
+    // SRAM バンク配置とバス競合カウンタ
+    sram_layout_init();
 
     printf("\n");
     printf("================================================\n");
@@ -215,6 +547,8 @@ int main(void) {
 
     // 最後のログ時刻を初期化
     last_status_log_time = get_absolute_time();
+    last_delay_sample_time = last_status_log_time;
+    last_link_update_time = last_status_log_time;
 
     // メインループ
     bool was_connected = false;
@@ -229,21 +563,74 @@ int main(void) {
         // タップテンポからエフェクトパラメータを更新
         update_effect_from_tap_tempo();
 
+#if VARISPEED_ENABLED
+        // バリスピードの速度に合わせてスライス長を更新
+        update_effect_from_varispeed();
+#endif
+
         // 接続状態の監視
         bool is_connected = bt_audio_is_connected();
 
         if (is_connected && !was_connected) {
             printf("\n>>> Audio stream connected!\n\n");
+#if DELAY_REPORT_ENABLED
+            // 新しいストリームでは最初の測定値を必ず報告する
+            delay_report_reset();
+#endif
+#if RECORDER_ENABLED && RECORDER_AUTO_START
+            recorder_start();
+#endif
             was_connected = true;
         } else if (!is_connected && was_connected) {
             printf("\n>>> Audio stream disconnected\n\n");
+#if RECORDER_ENABLED && RECORDER_AUTO_START
+            recorder_stop();
+#endif
 
             // バッファをクリア
             audio_out_i2s_clear_buffer();
+#if I2S_QUAD_OUTPUT
+            audio_split_reset();
+#endif
+#if LOUDNESS_METER_ENABLED
+            loudness_reset();
+#endif
+#if VARISPEED_ENABLED
+            varispeed_reset();
+#endif
+#if USE_PWM_OUTPUT
+            audio_out_pwm_clear_buffer();
+#endif
 
             was_connected = false;
         }
 
+#if CONTROL_ENABLED
+        // USB CDC の制御プロトコル（パラメータ、トリガー、テレメトリー）
+        control_poll();
+#endif
+
+#if TRACE_ENABLED
+        // トレースのダンプ（要求されたとき、少しずつ出力）
+        trace_poll();
+#endif
+
+#if RECORDER_ENABLED
+        // SD カードへの書き込み（ステージングリングからマルチブロックで書き出す）
+        recorder_poll();
+#endif
+
+#if SRAM_BUS_COUNTERS_ENABLED
+        // バス競合カウンタ（飽和する前に読み出して積算）
+        sram_layout_poll();
+#endif
+
+        // 適応バッファ（リンク品質から目標深さを決める）と遅延レポート
+        if (is_connected) {
+            update_link_buffering();
+            update_delay_report();
+        }
+
         // バッファ状態のログ出力（定期的）
 #ifdef ENABLE_DEBUG_LOG
         if (is_connected) {
@@ -0,0 +1,345 @@
+/**
+ * @file mod_matrix.c
+ * @brief テンポ同期モジュレーションマトリクスの実装
+ *
+ * サイン/三角/ノコギリは初期化時に作る Q15 ウェーブテーブルを線形補間で読む。
+ * 評価コストはルートに使われているモジュレーターの数 + ルート数に比例し、
+ * サブブロック（256フレーム）ごとに1回なので、サンプルあたりではほぼゼロになる。
+ */
+
+#include "mod_matrix.h"
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define WAVETABLE_BITS   8
+#define WAVETABLE_SIZE   (1u << WAVETABLE_BITS)
+#define NUM_WAVETABLES   3    // サイン、三角、ノコギリ
+
+#define MIN_PERIOD_BEATS 0.0625f   // 64分音符
+#define MAX_PERIOD_BEATS 64.0f     // 16小節
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+typedef struct {
+    mod_source_params_t params;
+    uint64_t period_q32;      // 周期（拍、32.32 固定小数点）
+    uint64_t offset_q32;      // 位相オフセット（拍、32.32 固定小数点）
+    uint64_t cycle_index;     // S&H: 現在の周期番号
+    float held_value;         // S&H: ホールド中の値
+    float env_level;          // エンベロープ: 現在値
+    bool env_attack;          // エンベロープ: アタック中
+    float value;              // 最新の評価値
+} mod_source_t;
+
+typedef struct {
+    bool active;
+    uint8_t source;
+    mod_dest_t dest;
+    float depth;
+} mod_route_t;
+
+// ウェーブテーブル（末尾に先頭のコピーを置き、補間で折り返さなくて済むようにする）
+static int16_t wavetables[NUM_WAVETABLES][WAVETABLE_SIZE + 1];
+
+static mod_source_t sources[MOD_MATRIX_NUM_SOURCES];
+static mod_route_t routes[MOD_MATRIX_MAX_ROUTES];
+
+// ルートから参照されているモジュレーター/行き先（ルート変更時に更新）
+static uint32_t used_sources = 0;
+static uint32_t used_dests = 0;
+static uint32_t active_route_count = 0;
+
+// 行き先ごとのサブブロック開始値/終了値
+static float dest_start[MOD_NUM_DESTS];
+static float dest_end[MOD_NUM_DESTS];
+static bool is_primed = false;   // 最初の評価では開始値 = 終了値
+
+static uint32_t random_state = 22222;
+static uint32_t sample_rate = AUDIO_SAMPLE_RATE;
+static bool is_initialized = false;
+
+// 評価コスト（time_us_32() の差の合計）
+// 1回の評価は 1us 未満で差はほとんど 0 か 1 だが、評価の開始位置は 1us の刻みに対して
+// ばらばらなので、多数回の合計は実際の時間の合計に近づく（平均だけを報告する）
+static uint64_t cost_total_us = 0;
+static uint32_t cost_evals = 0;
+
+// ============================================================================
+// ヘルパー関数
+// ============================================================================
+
+static void build_wavetables(void) {
+    for (uint32_t i = 0; i <= WAVETABLE_SIZE; i++) {
+        uint32_t idx = i & (WAVETABLE_SIZE - 1);
+        float phase = (float)idx / (float)WAVETABLE_SIZE;  // 0.0-1.0
+
+        float sine = sinf(2.0f * (float)M_PI * phase);
+        float tri = (phase < 0.5f) ? (4.0f * phase - 1.0f) : (3.0f - 4.0f * phase);
+        float saw = 2.0f * phase - 1.0f;
+
+        wavetables[MOD_SHAPE_SINE][i] = (int16_t)lrintf(sine * 32767.0f);
+        wavetables[MOD_SHAPE_TRIANGLE][i] = (int16_t)lrintf(tri * 32767.0f);
+        wavetables[MOD_SHAPE_SAW][i] = (int16_t)lrintf(saw * 32767.0f);
+    }
+}
+
+/**
+ * @brief ウェーブテーブルを線形補間で読む
+ * @param phase_q32 位相（0.32 固定小数点）
+ * @return -1.0〜1.0
+ */
+static inline float read_wavetable(const int16_t *table, uint32_t phase_q32) {
+    uint32_t idx = phase_q32 >> (32 - WAVETABLE_BITS);
+    int32_t frac = (int32_t)((phase_q32 >> (16 - WAVETABLE_BITS)) & 0xFFFF);
+    int32_t a = table[idx];
+    int32_t b = table[idx + 1];
+    int32_t v = a + (((b - a) * frac) >> 16);
+    return (float)v * (1.0f / 32767.0f);
+}
+
+static inline float next_random(void) {
+    // xorshift32 → -1.0〜1.0
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (float)(int32_t)random_state * (1.0f / 2147483648.0f);
+}
+
+static void update_route_masks(void) {
+    used_sources = 0;
+    used_dests = 0;
+    active_route_count = 0;
+
+    for (uint32_t i = 0; i < MOD_MATRIX_MAX_ROUTES; i++) {
+        if (!routes[i].active) continue;
+        used_sources |= 1u << routes[i].source;
+        used_dests |= 1u << routes[i].dest;
+        active_route_count++;
+    }
+}
+
+/**
+ * @brief モジュレーターをサブブロック終端まで進めて評価
+ */
+static float evaluate_source(mod_source_t *src, uint64_t beat_pos_q32, uint32_t frames) {
+    const mod_source_params_t *p = &src->params;
+
+    if (p->shape == MOD_SHAPE_ENVELOPE) {
+        // AD エンベロープ（線形）
+        if (src->env_attack) {
+            float attack_frames = p->attack_ms * (float)sample_rate / 1000.0f;
+            src->env_level = (attack_frames > 0.0f) ?
+                src->env_level + (float)frames / attack_frames : 1.0f;
+            if (src->env_level >= 1.0f) {
+                src->env_level = 1.0f;
+                src->env_attack = false;
+            }
+        } else if (src->env_level > 0.0f) {
+            float decay_frames = p->decay_ms * (float)sample_rate / 1000.0f;
+            src->env_level = (decay_frames > 0.0f) ?
+                src->env_level - (float)frames / decay_frames : 0.0f;
+            if (src->env_level < 0.0f) src->env_level = 0.0f;
+        }
+        return src->env_level;
+    }
+
+    // 周期内の位置（拍位置 → 0.0-1.0 の位相）
+    uint64_t pos = beat_pos_q32 + src->offset_q32;
+    uint64_t cycle = pos / src->period_q32;
+    uint64_t in_cycle = pos - cycle * src->period_q32;
+    float phase = (float)in_cycle / (float)src->period_q32;
+    uint32_t phase_q32 = (phase < 1.0f) ? (uint32_t)(phase * 4294967296.0f) : 0xFFFFFFFFu;
+
+    if (p->shape == MOD_SHAPE_SAMPLE_HOLD) {
+        if (cycle != src->cycle_index) {
+            src->cycle_index = cycle;
+            src->held_value = next_random();
+        }
+        return src->held_value;
+    }
+
+    return read_wavetable(wavetables[p->shape], phase_q32);
+}
+
+// ============================================================================
+// 初期化・設定
+// ============================================================================
+
+bool mod_matrix_init(uint32_t sr) {
+    sample_rate = sr;
+    build_wavetables();
+
+    mod_source_params_t defaults = {
+        .shape = MOD_SHAPE_SINE,
+        .period_beats = 1.0f,
+        .phase = 0.0f,
+        .attack_ms = 5.0f,
+        .decay_ms = 200.0f,
+    };
+    for (uint32_t i = 0; i < MOD_MATRIX_NUM_SOURCES; i++) {
+        mod_matrix_set_source(i, &defaults);
+    }
+
+    memset(routes, 0, sizeof(routes));
+    update_route_masks();
+    mod_matrix_reset();
+
+    is_initialized = true;
+
+    printf("[MOD] Sources: %d, Routes: %d, Wavetables: %u x %u (%u bytes)\n",
+           MOD_MATRIX_NUM_SOURCES, MOD_MATRIX_MAX_ROUTES, NUM_WAVETABLES, WAVETABLE_SIZE,
+           (unsigned)sizeof(wavetables));
+
+    return true;
+}
+
+bool mod_matrix_set_source(uint32_t index, const mod_source_params_t *params) {
+    if (index >= MOD_MATRIX_NUM_SOURCES || !params) return false;
+
+    mod_source_t *src = &sources[index];
+    src->params = *params;
+
+    if (src->params.shape > MOD_SHAPE_ENVELOPE) src->params.shape = MOD_SHAPE_SINE;
+    if (src->params.period_beats < MIN_PERIOD_BEATS) src->params.period_beats = MIN_PERIOD_BEATS;
+    if (src->params.period_beats > MAX_PERIOD_BEATS) src->params.period_beats = MAX_PERIOD_BEATS;
+    if (src->params.phase < 0.0f) src->params.phase = 0.0f;
+    if (src->params.phase > 1.0f) src->params.phase = 1.0f;
+    if (src->params.attack_ms < 0.0f) src->params.attack_ms = 0.0f;
+    if (src->params.decay_ms < 0.0f) src->params.decay_ms = 0.0f;
+
+    src->period_q32 = (uint64_t)((double)src->params.period_beats * 4294967296.0);
+    src->offset_q32 = (uint64_t)((double)src->params.phase * (double)src->period_q32);
+
+    return true;
+}
+
+int mod_matrix_add_route(uint32_t source, mod_dest_t dest, float depth) {
+    if (source >= MOD_MATRIX_NUM_SOURCES || dest >= MOD_NUM_DESTS) return -1;
+
+    for (uint32_t i = 0; i < MOD_MATRIX_MAX_ROUTES; i++) {
+        if (!routes[i].active) {
+            routes[i].source = (uint8_t)source;
+            routes[i].dest = dest;
+            routes[i].depth = depth;
+            routes[i].active = true;
+            update_route_masks();
+            return (int)i;
+        }
+    }
+
+    printf("WARNING: Modulation matrix full (%d routes)\n", MOD_MATRIX_MAX_ROUTES);
+    return -1;
+}
+
+void mod_matrix_remove_route(int route_id) {
+    if (route_id < 0 || route_id >= MOD_MATRIX_MAX_ROUTES) return;
+    routes[route_id].active = false;
+    update_route_masks();
+}
+
+void mod_matrix_clear_routes(void) {
+    memset(routes, 0, sizeof(routes));
+    update_route_masks();
+}
+
+uint32_t mod_matrix_get_active_routes(void) {
+    return active_route_count;
+}
+
+void mod_matrix_trigger(void) {
+    for (uint32_t i = 0; i < MOD_MATRIX_NUM_SOURCES; i++) {
+        if (sources[i].params.shape == MOD_SHAPE_ENVELOPE) {
+            sources[i].env_attack = true;
+        }
+    }
+}
+
+// ============================================================================
+// 評価
+// ============================================================================
+
+void mod_matrix_process(uint64_t beat_pos_q32, uint32_t frames) {
+    if (!is_initialized || active_route_count == 0) return;
+
+    uint32_t start = time_us_32();
+
+    // ルートに使われているモジュレーターだけ評価
+    for (uint32_t i = 0; i < MOD_MATRIX_NUM_SOURCES; i++) {
+        if (used_sources & (1u << i)) {
+            sources[i].value = evaluate_source(&sources[i], beat_pos_q32, frames);
+        }
+    }
+
+    // 前回の終了値を開始値にして、終了値を集計し直す
+    memcpy(dest_start, dest_end, sizeof(dest_start));
+    memset(dest_end, 0, sizeof(dest_end));
+
+    for (uint32_t i = 0; i < MOD_MATRIX_MAX_ROUTES; i++) {
+        const mod_route_t *route = &routes[i];
+        if (route->active) {
+            dest_end[route->dest] += route->depth * sources[route->source].value;
+        }
+    }
+
+    if (!is_primed) {
+        memcpy(dest_start, dest_end, sizeof(dest_start));
+        is_primed = true;
+    }
+
+    cost_total_us += time_us_32() - start;
+    cost_evals++;
+}
+
+bool mod_matrix_get_ramp(mod_dest_t dest, float *start, float *end) {
+    if (dest >= MOD_NUM_DESTS || !(used_dests & (1u << dest))) {
+        *start = 0.0f;
+        *end = 0.0f;
+        return false;
+    }
+    *start = dest_start[dest];
+    *end = dest_end[dest];
+    return true;
+}
+
+// ============================================================================
+// 状態取得・リセット
+// ============================================================================
+
+void mod_matrix_get_cycles(uint32_t *avg_cycles, uint32_t *per_route_cycles) {
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    uint32_t avg = cost_evals ? (uint32_t)(cost_total_us * cycles_per_us / cost_evals) : 0;
+
+    if (avg_cycles) *avg_cycles = avg;
+    if (per_route_cycles) *per_route_cycles = active_route_count ? avg / active_route_count : 0;
+}
+
+void mod_matrix_reset(void) {
+    for (uint32_t i = 0; i < MOD_MATRIX_NUM_SOURCES; i++) {
+        sources[i].cycle_index = UINT64_MAX;
+        sources[i].held_value = 0.0f;
+        sources[i].env_level = 0.0f;
+        sources[i].env_attack = false;
+        sources[i].value = 0.0f;
+    }
+    memset(dest_start, 0, sizeof(dest_start));
+    memset(dest_end, 0, sizeof(dest_end));
+    is_primed = false;
+    cost_total_us = 0;
+    cost_evals = 0;
+}
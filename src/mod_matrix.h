@@ -0,0 +1,141 @@
+/**
+ * @file mod_matrix.h
+ * @brief テンポ同期モジュレーションマトリクス - ヘッダーファイル
+ *
+ * MOD_MATRIX_NUM_SOURCES 個のモジュレーター（LFO / エンベロープ）を
+ * MOD_MATRIX_MAX_ROUTES 本のルートで任意のパラメータにデプス付きで接続する。
+ * LFO の位相はビートクロックの拍位置から求めるので、常にテンポに位相ロックしている。
+ *
+ * 評価はサブブロック（エフェクトのチャンク）ごとに1回だけ行い、サンプルごとには行わない。
+ * 受け側はサブブロックの開始値と終了値の間を線形にランプするか、
+ * イベント単位のパラメータなら開始値をそのまま使う。
+ */
+
+#ifndef MOD_MATRIX_H
+#define MOD_MATRIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief モジュレーターの波形
+ */
+typedef enum {
+    MOD_SHAPE_SINE = 0,     // サイン（-1.0〜1.0）
+    MOD_SHAPE_TRIANGLE,     // 三角（-1.0〜1.0）
+    MOD_SHAPE_SAW,          // ノコギリ（-1.0〜1.0、上昇）
+    MOD_SHAPE_SAMPLE_HOLD,  // サンプル&ホールド（周期ごとにランダム、-1.0〜1.0）
+    MOD_SHAPE_ENVELOPE,     // AD エンベロープ（mod_matrix_trigger で開始、0.0〜1.0）
+} mod_shape_t;
+
+/**
+ * @brief モジュレーターの設定
+ */
+typedef struct {
+    mod_shape_t shape;
+
+    // LFO の周期（拍数）
+    // 0.25 = 16分音符、1.0 = 4分音符、4.0 = 1小節（4/4）
+    float period_beats;
+
+    // LFO の位相オフセット（0.0-1.0）
+    float phase;
+
+    // エンベロープのアタック/ディケイ時間（ミリ秒、MOD_SHAPE_ENVELOPE の場合）
+    float attack_ms;
+    float decay_ms;
+} mod_source_params_t;
+
+/**
+ * @brief モジュレーション先
+ *
+ * デプスは各パラメータの単位で指定する（モジュレーター出力 ±1.0 あたりの変化量）。
+ * ノードを追加したらここに行き先を足し、ノード側で mod_matrix_get_ramp() を読む。
+ */
+typedef enum {
+    MOD_DEST_PITCH_SHIFT = 0,     // ピッチシフト（オクターブ）
+    MOD_DEST_WET_MIX,             // ウェットミックス（%）
+    MOD_DEST_WINDOW_SHAPE,        // ウィンドウシェイプ（0.0-1.0）
+    MOD_DEST_LOOP_START,          // ループ開始位置（0.0-1.0）
+    MOD_DEST_LOOP_SIZE_DECAY,     // ループサイズ減衰（0.0-1.0）
+    MOD_DEST_SLICE_PROBABILITY,   // スライス処理確率（0.0-1.0）
+    MOD_NUM_DESTS
+} mod_dest_t;
+
+/**
+ * @brief モジュレーションマトリクスの初期化（ウェーブテーブルの生成、ルートなし）
+ * @param sample_rate サンプリングレート（Hz）
+ * @return true 成功
+ */
+bool mod_matrix_init(uint32_t sample_rate);
+
+/**
+ * @brief モジュレーターを設定
+ * @param index モジュレーター番号（0 〜 MOD_MATRIX_NUM_SOURCES-1）
+ * @param params 設定
+ * @return true 成功、false 番号が範囲外
+ */
+bool mod_matrix_set_source(uint32_t index, const mod_source_params_t *params);
+
+/**
+ * @brief ルートを追加
+ * @param source モジュレーター番号
+ * @param dest モジュレーション先
+ * @param depth デプス（行き先の単位、負の値で反転）
+ * @return int ルートID（0以上）、空きがなければ -1
+ */
+int mod_matrix_add_route(uint32_t source, mod_dest_t dest, float depth);
+
+/**
+ * @brief ルートを削除
+ * @param route_id mod_matrix_add_route() の戻り値
+ */
+void mod_matrix_remove_route(int route_id);
+
+/**
+ * @brief すべてのルートを削除
+ */
+void mod_matrix_clear_routes(void);
+
+/**
+ * @brief 有効なルート数を取得
+ */
+uint32_t mod_matrix_get_active_routes(void);
+
+/**
+ * @brief エンベロープを先頭から開始（リピート開始時などに呼ぶ）
+ */
+void mod_matrix_trigger(void);
+
+/**
+ * @brief サブブロック1つ分モジュレーターを進めて評価（サブブロックごとに1回）
+ *
+ * 前回の終了値が今回の開始値になり、終了値を beat_pos_q32 の拍位置で評価する。
+ *
+ * @param beat_pos_q32 サブブロック終端の拍位置（32.32 固定小数点）
+ * @param frames サブブロックのフレーム数
+ */
+void mod_matrix_process(uint64_t beat_pos_q32, uint32_t frames);
+
+/**
+ * @brief 行き先ごとのモジュレーション量（サブブロックの開始値と終了値）
+ * @param dest モジュレーション先
+ * @param start 開始値の格納先（行き先の単位のオフセット）
+ * @param end 終了値の格納先
+ * @return true この行き先にルートが接続されている
+ */
+bool mod_matrix_get_ramp(mod_dest_t dest, float *start, float *end);
+
+/**
+ * @brief 評価コストを取得
+ * @param avg_cycles サブブロックあたりの平均サイクル数
+ * @param per_route_cycles 有効なルート1本あたりの平均サイクル数
+ */
+void mod_matrix_get_cycles(uint32_t *avg_cycles, uint32_t *per_route_cycles);
+
+/**
+ * @brief モジュレーターの状態をリセット（ルートと設定は保持）
+ */
+void mod_matrix_reset(void);
+
+#endif // MOD_MATRIX_H
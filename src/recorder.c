@@ -0,0 +1,384 @@
+/**
+ * @file recorder.c
+ * @brief 処理後の出力の SD カード録音の実装
+ *
+ * ステージングリングの位置（head / tail）はバイト単位の単調増加カウンタ。
+ * リング長は書き込み単位（RECORDER_WRITE_BLOCKS ブロック）の倍数なので、
+ * tail から1単位分は常にリング内で連続し、そのまま DMA の送信元にできる。
+ * 書き込みは同時に1つだけで、完了してから tail を進める（それまで領域は上書きされない）。
+ */
+
+#include "recorder.h"
+#include "config.h"
+#include "sd_card.h"
+#include "fat32.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#define CHUNK_BYTES       (RECORDER_WRITE_BLOCKS * SD_BLOCK_SIZE)
+#define BYTES_PER_FRAME   4       // ステレオ 16ビット
+
+#if (RECORDER_STAGING_BYTES % CHUNK_BYTES) != 0
+#error "RECORDER_STAGING_BYTES must be a multiple of RECORDER_WRITE_BLOCKS * 512"
+#endif
+
+// WAV ヘッダー（1ブロック）: RIFF / fmt / JUNK（埋め草）/ data の順で、data の中身が 512 から始まる
+#define WAV_JUNK_BYTES    460
+#define WAV_DATA_OFFSET   SD_BLOCK_SIZE
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// ステージングリング（1ワード = 1フレーム、下位16ビット = 左）
+static uint32_t staging[RECORDER_STAGING_BYTES / 4] __attribute__((aligned(4)));
+static volatile uint32_t head = 0;      // 書き込んだバイト数
+static volatile uint32_t tail = 0;      // カードに書き終えたバイト数
+
+static fat32_extent_t files[RECORDER_MAX_FILES];
+static bool file_used[RECORDER_MAX_FILES];
+static int num_files = 0;
+
+static volatile recorder_state_t state = RECORDER_STATE_NO_CARD;
+static int file_index = -1;
+static uint32_t next_lba;               // 次に書くブロック
+static uint32_t end_lba;                // ファイルの終わり（この手前まで書ける）
+
+// 書き込み中のリクエスト
+static bool write_in_flight = false;
+static bool header_in_flight = false;
+static bool header_written = false;
+static uint32_t in_flight_bytes;        // リングから消費するバイト数（ブロック境界）
+static uint32_t in_flight_payload;      // そのうちの PCM データ
+static uint32_t write_start_us;
+
+static uint8_t header_block[SD_BLOCK_SIZE] __attribute__((aligned(4)));
+
+// 統計
+static uint32_t data_bytes = 0;
+static uint32_t dropped_frames = 0;
+static uint32_t drop_events = 0;
+static uint32_t staging_peak = 0;
+static uint32_t max_write_us = 0;
+static uint32_t write_errors = 0;
+
+// ============================================================================
+// WAV ヘッダー
+// ============================================================================
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief ヘッダーのブロックを作る（tools/sd_prealloc.py と同じ形）
+ */
+static void build_wav_header(uint8_t *block, uint32_t pcm_bytes) {
+    memset(block, 0, SD_BLOCK_SIZE);
+    memcpy(&block[0], "RIFF", 4);
+    put_u32(&block[4], WAV_DATA_OFFSET - 8 + pcm_bytes);
+    memcpy(&block[8], "WAVE", 4);
+
+    memcpy(&block[12], "fmt ", 4);
+    put_u32(&block[16], 16);
+    put_u16(&block[20], 1);                                   // PCM
+    put_u16(&block[22], 2);                                   // チャンネル数
+    put_u32(&block[24], AUDIO_SAMPLE_RATE);
+    put_u32(&block[28], AUDIO_SAMPLE_RATE * BYTES_PER_FRAME);
+    put_u16(&block[32], BYTES_PER_FRAME);
+    put_u16(&block[34], 16);                                  // ビット数
+
+    memcpy(&block[36], "JUNK", 4);
+    put_u32(&block[40], WAV_JUNK_BYTES);
+
+    memcpy(&block[WAV_DATA_OFFSET - 8], "data", 4);
+    put_u32(&block[WAV_DATA_OFFSET - 4], pcm_bytes);
+}
+
+/**
+ * @brief 事前確保したままの（まだ録音していない）ファイルか
+ */
+static bool is_unused_header(const uint8_t *block) {
+    return memcmp(&block[0], "RIFF", 4) == 0 &&
+           memcmp(&block[WAV_DATA_OFFSET - 8], "data", 4) == 0 &&
+           block[WAV_DATA_OFFSET - 4] == 0 && block[WAV_DATA_OFFSET - 3] == 0 &&
+           block[WAV_DATA_OFFSET - 2] == 0 && block[WAV_DATA_OFFSET - 1] == 0;
+}
+
+static uint32_t count_free_files(void) {
+    uint32_t count = 0;
+    for (int i = 0; i < num_files; i++) {
+        if (!file_used[i]) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// ============================================================================
+// 初期化
+// ============================================================================
+
+bool recorder_init(void) {
+    state = RECORDER_STATE_NO_CARD;
+    num_files = 0;
+
+    if (!sd_card_init()) {
+        printf("[REC] Recording unavailable (no card)\n");
+        return false;
+    }
+    if (!fat32_mount()) {
+        printf("[REC] Recording unavailable (no FAT32 volume)\n");
+        sd_card_deinit();
+        return false;
+    }
+
+    num_files = fat32_find_extents(RECORDER_FILE_PREFIX, "WAV", files, RECORDER_MAX_FILES);
+    for (int i = 0; i < num_files; i++) {
+        // ヘッダーのデータ長が 0 のファイルだけを使う（録音済みは上書きしない）
+        file_used[i] = !(sd_card_read_block(files[i].first_lba, header_block) &&
+                         is_unused_header(header_block));
+        printf("[REC] %s: %lu KB (%.1f min)%s\n", files[i].name,
+               files[i].blocks / 2, (float)((files[i].blocks - 1) * SD_BLOCK_SIZE) /
+               (AUDIO_SAMPLE_RATE * BYTES_PER_FRAME) / 60.0f,
+               file_used[i] ? ", recorded" : "");
+    }
+
+    uint32_t free_files = count_free_files();
+    if (free_files == 0) {
+        printf("[REC] No unused %s*.WAV file (create them with tools/sd_prealloc.py)\n",
+               RECORDER_FILE_PREFIX);
+        sd_card_deinit();
+        return false;
+    }
+
+    state = RECORDER_STATE_IDLE;
+    printf("[REC] Ready: %lu free files, staging %d KB, %d blocks per write\n",
+           free_files, RECORDER_STAGING_BYTES / 1024, RECORDER_WRITE_BLOCKS);
+    return true;
+}
+
+// ============================================================================
+// ステージング（オーディオ処理から呼ばれる）
+// ============================================================================
+
+uint32_t recorder_write(const int16_t *left, const int16_t *right, uint32_t num_samples) {
+    if (state != RECORDER_STATE_RECORDING) {
+        return num_samples;
+    }
+
+    // 入りきらないときはブロックごと捨てる（再生は待たせない）
+    uint32_t bytes = num_samples * BYTES_PER_FRAME;
+    uint32_t fill = head - tail;
+    if (fill + bytes > RECORDER_STAGING_BYTES) {
+        dropped_frames += num_samples;
+        drop_events++;
+        return 0;
+    }
+
+    uint32_t pos = (head % RECORDER_STAGING_BYTES) / 4;
+    for (uint32_t i = 0; i < num_samples; i++) {
+        staging[pos] = (uint16_t)left[i] | ((uint32_t)(uint16_t)right[i] << 16);
+        if (++pos == RECORDER_STAGING_BYTES / 4) {
+            pos = 0;
+        }
+    }
+    head += bytes;
+
+    fill += bytes;
+    if (fill > staging_peak) {
+        staging_peak = fill;
+    }
+    return num_samples;
+}
+
+// ============================================================================
+// 開始 / 停止
+// ============================================================================
+
+bool recorder_start(void) {
+    if (state != RECORDER_STATE_IDLE) {
+        return false;
+    }
+
+    int index = -1;
+    for (int i = 0; i < num_files; i++) {
+        if (!file_used[i]) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        printf("[REC] No free file left\n");
+        return false;
+    }
+
+    file_index = index;
+    next_lba = files[index].first_lba + WAV_DATA_OFFSET / SD_BLOCK_SIZE;
+    end_lba = files[index].first_lba + files[index].blocks;
+    head = tail = 0;
+    write_in_flight = header_in_flight = header_written = false;
+    data_bytes = dropped_frames = drop_events = 0;
+    staging_peak = max_write_us = write_errors = 0;
+
+    state = RECORDER_STATE_RECORDING;
+    printf("[REC] Recording to %s\n", files[index].name);
+    return true;
+}
+
+void recorder_stop(void) {
+    if (state == RECORDER_STATE_RECORDING) {
+        state = RECORDER_STATE_STOPPING;
+    }
+}
+
+// ============================================================================
+// カードへの書き込み
+// ============================================================================
+
+/**
+ * @brief リングの tail から bytes（ブロック境界に切り上げ済み）を書き始める
+ */
+static void issue_write(uint32_t bytes, uint32_t payload) {
+    uint32_t blocks = bytes / SD_BLOCK_SIZE;
+    if (next_lba + blocks > end_lba) {
+        // ファイルの終わり: ここまでで止める
+        printf("[REC] %s is full\n", files[file_index].name);
+        head = tail;
+        state = RECORDER_STATE_STOPPING;
+        return;
+    }
+
+    const uint8_t *src = (const uint8_t *)staging + (tail % RECORDER_STAGING_BYTES);
+    if (!sd_card_write_start(next_lba, src, blocks)) {
+        // カードが書き込みを受け付けない: 書けなかった時と同じく残りを捨てて止める
+        write_errors++;
+        printf("[REC] Could not start a write at LBA %lu, stopping\n", next_lba);
+        head = tail;
+        state = RECORDER_STATE_STOPPING;
+        return;
+    }
+    write_in_flight = true;
+    in_flight_bytes = bytes;
+    in_flight_payload = payload;
+    write_start_us = time_us_32();
+}
+
+static void finish_take(void) {
+    file_used[file_index] = true;
+    state = RECORDER_STATE_IDLE;
+    printf("[REC] Stopped %s: %lu bytes (%.1f s), dropped %lu frames in %lu events, "
+           "peak staging %lu/%d, max write %lu us, errors %lu\n",
+           files[file_index].name, data_bytes,
+           (float)data_bytes / (AUDIO_SAMPLE_RATE * BYTES_PER_FRAME),
+           dropped_frames, drop_events, staging_peak, RECORDER_STAGING_BYTES,
+           max_write_us, write_errors);
+    if (count_free_files() == 0) {
+        printf("[REC] No free file left\n");
+    }
+}
+
+void recorder_poll(void) {
+    if (state != RECORDER_STATE_RECORDING && state != RECORDER_STATE_STOPPING) {
+        return;
+    }
+
+    // 書き込み中なら完了を待つ
+    if (write_in_flight) {
+        sd_write_status_t status = sd_card_write_poll();
+        if (status == SD_WRITE_BUSY) {
+            return;
+        }
+        write_in_flight = false;
+        uint32_t elapsed_us = time_us_32() - write_start_us;
+        if (elapsed_us > max_write_us) {
+            max_write_us = elapsed_us;
+        }
+
+        if (header_in_flight) {
+            header_in_flight = false;
+            if (status != SD_WRITE_DONE) {
+                write_errors++;
+                printf("[REC] Failed to write the WAV header\n");
+            }
+            header_written = true;
+            finish_take();
+            return;
+        }
+
+        if (status == SD_WRITE_DONE) {
+            tail += in_flight_bytes;
+            next_lba += in_flight_bytes / SD_BLOCK_SIZE;
+            data_bytes += in_flight_payload;
+        } else {
+            // 書けなかった: 残りは捨ててヘッダーだけ書く
+            write_errors++;
+            printf("[REC] Write error at LBA %lu, stopping\n", next_lba);
+            head = tail;
+            state = RECORDER_STATE_STOPPING;
+        }
+    }
+
+    uint32_t fill = head - tail;
+
+    if (state == RECORDER_STATE_RECORDING) {
+        if (fill >= CHUNK_BYTES) {
+            issue_write(CHUNK_BYTES, CHUNK_BYTES);
+        }
+        return;
+    }
+
+    // 停止中: 残りを書き出してからヘッダーを書く
+    if (fill >= CHUNK_BYTES) {
+        issue_write(CHUNK_BYTES, CHUNK_BYTES);
+    } else if (fill > 0) {
+        // 端数はブロック境界まで 0 で埋める（ヘッダーのデータ長には含めない）
+        uint32_t padded = (fill + SD_BLOCK_SIZE - 1) / SD_BLOCK_SIZE * SD_BLOCK_SIZE;
+        memset((uint8_t *)staging + (head % RECORDER_STAGING_BYTES), 0, padded - fill);
+        head = tail + padded;
+        issue_write(padded, fill);
+    } else if (!header_written) {
+        build_wav_header(header_block, data_bytes);
+        if (!sd_card_write_start(files[file_index].first_lba, header_block, 1)) {
+            write_errors++;
+            printf("[REC] Failed to write the WAV header\n");
+            header_written = true;
+            finish_take();
+            return;
+        }
+        write_in_flight = true;
+        header_in_flight = true;
+        write_start_us = time_us_32();
+    }
+}
+
+// ============================================================================
+// 状態
+// ============================================================================
+
+recorder_state_t recorder_get_state(void) {
+    return state;
+}
+
+void recorder_get_stats(recorder_stats_t *stats) {
+    stats->state = state;
+    stats->file_index = file_index;
+    stats->free_files = count_free_files();
+    stats->data_bytes = data_bytes;
+    stats->dropped_frames = dropped_frames;
+    stats->drop_events = drop_events;
+    stats->staging_peak = staging_peak;
+    stats->max_write_us = max_write_us;
+    stats->write_errors = write_errors;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file recorder.h
+ * @brief 処理後の出力を SD カードにストリーミング録音 - ヘッダーファイル
+ *
+ * RECORDER_TAP のタップにつないだ出力として、ステレオ 16ビットのフレームを
+ * ステージングリング（RECORDER_STAGING_BYTES）にためる。メインループの recorder_poll() が
+ * RECORDER_WRITE_BLOCKS ブロックたまるごとにリングから直接マルチブロック書き込みを出す
+ * （書き込みは DMA、リングの領域はブロック境界にそろっているのでコピーしない）。
+ *
+ * 書き先はホストで事前に確保した連続ファイル（tools/sd_prealloc.py の RECnn.WAV）で、
+ * 先頭ブロックが WAV ヘッダー、2ブロック目からが PCM データ。録音中は FAT も
+ * ディレクトリも書かず、停止時にヘッダーのブロックだけを書き直してデータ長を入れる。
+ *
+ * 背圧: カードの書き込みが遅れてリングがあふれそうなときは、そのブロックの録音を捨てて
+ * 数える（dropped_frames / drop_events）。再生側を待たせることはない。
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief 録音の状態
+ */
+typedef enum {
+    RECORDER_STATE_NO_CARD = 0,   // カードまたは録音ファイルがない
+    RECORDER_STATE_IDLE,          // 録音できる
+    RECORDER_STATE_RECORDING,     // 録音中
+    RECORDER_STATE_STOPPING,      // 残りのデータとヘッダーを書いている
+} recorder_state_t;
+
+/**
+ * @brief 録音の統計（現在または直前のテイク）
+ */
+typedef struct {
+    recorder_state_t state;
+    int file_index;             // 書いているファイル（-1 = なし）
+    uint32_t free_files;        // 未使用の録音ファイルの数
+    uint32_t data_bytes;        // カードに書いた PCM のバイト数
+    uint32_t dropped_frames;    // リングが満杯で捨てたフレーム数
+    uint32_t drop_events;       // 捨てた回数
+    uint32_t staging_peak;      // リングの最大フィル（バイト）
+    uint32_t max_write_us;      // 1回のマルチブロック書き込みの最大時間
+    uint32_t write_errors;      // 書き込みの失敗
+} recorder_stats_t;
+
+/**
+ * @brief 初期化（カードを初期化し、録音ファイルを探して未使用のものを数える、同期）
+ * @return true 録音できる
+ */
+bool recorder_init(void);
+
+/**
+ * @brief 出力の書き込み関数（audio_route_write_t、録音中でなければ何もしない）
+ * @param left 左チャンネル（プレーナー）
+ * @param right 右チャンネル（プレーナー）
+ * @param num_samples ステレオペア数
+ * @return リングに入れたフレーム数（あふれたときは 0、録音中でなければ num_samples）
+ */
+uint32_t recorder_write(const int16_t *left, const int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief 次の未使用ファイルに録音を始める
+ * @return true 開始した
+ */
+bool recorder_start(void);
+
+/**
+ * @brief 録音を止める（残りのデータとヘッダーは recorder_poll() で書く）
+ */
+void recorder_stop(void);
+
+/**
+ * @brief カードへの書き込みを進める（メインループから呼ぶ）
+ */
+void recorder_poll(void);
+
+/**
+ * @brief 録音の状態を取得
+ */
+recorder_state_t recorder_get_state(void);
+
+/**
+ * @brief 統計を取得
+ */
+void recorder_get_stats(recorder_stats_t *stats);
+
+#endif // RECORDER_H
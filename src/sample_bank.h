@@ -0,0 +1,38 @@
+/**
+ * @file sample_bank.h
+ * @brief フラッシュ上のサンプルバンク - ヘッダーファイル
+ *
+ * バンクはビルド時に tools/wav2bank.py が samples/ の WAV から生成する（sample_bank_data.c）。
+ * データは const 配列なのでフラッシュ（XIP 領域）に置かれ、SRAM は使わない。
+ * サンプルプレーヤーは XIP から直接読まず、DMA で小さなバッファに先読みしてから再生する。
+ */
+
+#ifndef SAMPLE_BANK_H
+#define SAMPLE_BANK_H
+
+#include <stdint.h>
+
+/**
+ * @brief サンプルの格納形式（どちらもモノラル、AUDIO_SAMPLE_RATE）
+ */
+typedef enum {
+    SAMPLE_FORMAT_PCM16 = 0,    // 16ビット PCM（リトルエンディアン）
+    SAMPLE_FORMAT_IMA_ADPCM,    // IMA-ADPCM 4ビット（下位ニブルが先、予測値 0 / ステップ位置 0 から開始）
+} sample_format_t;
+
+/**
+ * @brief バンク内の1サンプル
+ */
+typedef struct {
+    const char *name;           // 元のファイル名（拡張子なし）
+    const uint8_t *data;        // フラッシュ上のデータ（4バイト境界）
+    uint32_t num_bytes;         // データのバイト数（4の倍数に切り上げ済み）
+    uint32_t num_frames;        // フレーム数
+    sample_format_t format;     // 格納形式
+} sample_t;
+
+// 生成されたバンク（sample_bank_data.c）
+extern const sample_t sample_bank[];
+extern const uint32_t sample_bank_count;
+
+#endif // SAMPLE_BANK_H
@@ -0,0 +1,437 @@
+/**
+ * @file sampler.c
+ * @brief フラッシュからストリーミングするワンショットサンプルプレーヤーの実装
+ *
+ * ボイスごとにピンポンバッファ（SAMPLER_PREFETCH_BYTES × 2）を持つ。
+ * トリガー時に両方の面の転送を要求し、1面を再生し終えたらその面の次の転送を要求する。
+ * 転送は FIFO 順に1本の DMA チャンネルで行い、完了割り込みで次の要求を開始する。
+ *
+ * 再生する面の転送がまだ終わっていないときは、そのボイスを進めずに無音を出す（アンダーラン）。
+ * 読み飛ばすと ADPCM の予測値が崩れるので、遅れても必ず続きから鳴らす。
+ *
+ * ボイスを奪ったときに古い転送が残っていても、世代番号が合わない要求は捨て、
+ * 転送中のものは完了しても ready にしない。新しい要求は FIFO でその後に転送されるので上書きされる。
+ */
+
+#include "sampler.h"
+#include "sample_bank.h"
+#include "config.h"
+#include "adpcm.h"
+#include "dma_irq.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define SAMPLER_CHUNK_FRAMES  256
+#define SAMPLER_QUEUE_SIZE    (SAMPLER_NUM_VOICES * 2)   // ボイスあたり最大2面分
+
+#define SAMPLE_MAX            32767
+#define SAMPLE_MIN            -32768
+
+// ============================================================================
+// 型定義
+// ============================================================================
+
+typedef struct {
+    const sample_t *sample;
+    bool active;
+    uint32_t generation;           // トリガーごとに増やす（古い転送の判別用）
+    int32_t gain_q15;
+
+    uint8_t buf[2][SAMPLER_PREFETCH_BYTES] __attribute__((aligned(4)));
+    volatile bool ready[2];        // 転送完了（DMA 割り込みで true、再生し終えたら false）
+    uint32_t buf_frames[2];        // 各面に入っているフレーム数
+
+    uint32_t fetch_offset;         // 次に転送するバイト位置
+    uint32_t frames_assigned;      // 面に割り当て済みのフレーム数
+    uint32_t frames_played;        // 再生済みのフレーム数
+
+    uint8_t play_buf;              // 再生中の面
+    uint32_t play_pos;             // 面内の位置（フレーム）
+    adpcm_state_t adpcm;
+} sampler_voice_t;
+
+typedef struct {
+    uint8_t voice;
+    uint8_t buf;
+    uint32_t generation;
+    const uint8_t *src;
+    uint32_t num_bytes;
+} prefetch_request_t;
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static sampler_voice_t voices[SAMPLER_NUM_VOICES];
+static uint32_t next_generation = 1;
+
+// 先読みキュー（FIFO、割り込みを止めて操作する）
+static prefetch_request_t queue[SAMPLER_QUEUE_SIZE];
+static uint32_t queue_head = 0;
+static uint32_t queue_count = 0;
+
+static int dma_channel = -1;
+static volatile bool dma_busy = false;
+static prefetch_request_t in_flight;
+
+static int32_t mix_buf[SAMPLER_CHUNK_FRAMES];
+
+static volatile uint32_t stat_transfers = 0;
+static uint32_t stat_triggers = 0;
+static uint32_t stat_underruns = 0;
+static uint32_t stat_max_queue = 0;
+
+static bool is_initialized = false;
+
+// ============================================================================
+// DMA 先読み
+// ============================================================================
+
+/**
+ * @brief フラッシュ上のアドレスをキャッシュを使わない XIP の別名に変換
+ *
+ * 一度しか読まないサンプルデータでコードのキャッシュラインを追い出さないようにする。
+ */
+static const void *flash_read_address(const uint8_t *src) {
+#ifdef XIP_NOCACHE_NOALLOC_BASE
+    uintptr_t addr = (uintptr_t)src;
+    if (addr >= XIP_BASE && addr < XIP_NOCACHE_NOALLOC_BASE) {
+        return (const void *)(addr - XIP_BASE + XIP_NOCACHE_NOALLOC_BASE);
+    }
+#endif
+    return src;
+}
+
+/**
+ * @brief キューの先頭から転送を開始（割り込み禁止中に呼ぶ）
+ *
+ * 奪われたボイスの古い要求はここで捨てる。
+ */
+static void start_next_transfer(void) {
+    while (queue_count > 0) {
+        prefetch_request_t req = queue[queue_head];
+        queue_head = (queue_head + 1) % SAMPLER_QUEUE_SIZE;
+        queue_count--;
+
+        if (req.generation != voices[req.voice].generation) {
+            continue;
+        }
+
+        in_flight = req;
+        dma_busy = true;
+
+        dma_channel_config c = dma_channel_get_default_config(dma_channel);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, true);
+        channel_config_set_dreq(&c, DREQ_FORCE);   // ペーシングなし（フラッシュの速さで転送）
+
+        dma_channel_configure(
+            dma_channel,
+            &c,
+            voices[req.voice].buf[req.buf],
+            flash_read_address(req.src),
+            req.num_bytes / 4,
+            true
+        );
+        return;
+    }
+    dma_busy = false;
+}
+
+/**
+ * @brief DMA 完了ハンドラー
+ */
+static void dma_handler(void) {
+    sampler_voice_t *v = &voices[in_flight.voice];
+    if (in_flight.generation == v->generation) {
+        v->ready[in_flight.buf] = true;
+    }
+    stat_transfers++;
+    start_next_transfer();
+}
+
+/**
+ * @brief 奪われたボイスの要求をキューから取り除く（割り込み禁止中に呼ぶ）
+ *
+ * 有効な要求はボイスあたり最大2つなので、古い要求を除けば必ず空きができる。
+ */
+static void drop_stale_requests(void) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < queue_count; i++) {
+        prefetch_request_t req = queue[(queue_head + i) % SAMPLER_QUEUE_SIZE];
+        if (req.generation == voices[req.voice].generation) {
+            queue[(queue_head + kept) % SAMPLER_QUEUE_SIZE] = req;
+            kept++;
+        }
+    }
+    queue_count = kept;
+}
+
+/**
+ * @brief ボイスの面に次のデータを割り当てて転送を要求
+ * @return true 要求した, false もうデータがない
+ */
+static bool request_fill(uint32_t voice_index, uint8_t buf) {
+    sampler_voice_t *v = &voices[voice_index];
+    const sample_t *s = v->sample;
+
+    if (v->frames_assigned >= s->num_frames || v->fetch_offset >= s->num_bytes) {
+        return false;
+    }
+
+    uint32_t num_bytes = s->num_bytes - v->fetch_offset;
+    if (num_bytes > SAMPLER_PREFETCH_BYTES) {
+        num_bytes = SAMPLER_PREFETCH_BYTES;
+    }
+
+    uint32_t frames = (s->format == SAMPLE_FORMAT_IMA_ADPCM) ? num_bytes * 2 : num_bytes / 2;
+    if (frames > s->num_frames - v->frames_assigned) {
+        frames = s->num_frames - v->frames_assigned;   // 末尾のパディング分は鳴らさない
+    }
+
+    v->ready[buf] = false;
+    v->buf_frames[buf] = frames;
+
+    prefetch_request_t req = {
+        .voice = (uint8_t)voice_index,
+        .buf = buf,
+        .generation = v->generation,
+        .src = s->data + v->fetch_offset,
+        .num_bytes = num_bytes,
+    };
+    v->fetch_offset += num_bytes;
+    v->frames_assigned += frames;
+
+    uint32_t irq_state = save_and_disable_interrupts();
+    if (queue_count >= SAMPLER_QUEUE_SIZE) {
+        drop_stale_requests();
+    }
+    queue[(queue_head + queue_count) % SAMPLER_QUEUE_SIZE] = req;
+    queue_count++;
+    if (queue_count > stat_max_queue) {
+        stat_max_queue = queue_count;
+    }
+    if (!dma_busy) {
+        start_next_transfer();
+    }
+    restore_interrupts(irq_state);
+    return true;
+}
+
+// ============================================================================
+// 再生
+// ============================================================================
+
+static inline int16_t saturate(int32_t v) {
+    if (v > SAMPLE_MAX) return SAMPLE_MAX;
+    if (v < SAMPLE_MIN) return SAMPLE_MIN;
+    return (int16_t)v;
+}
+
+/**
+ * @brief 1面の一部をデコードして mix_buf に加算
+ */
+static void render_run(sampler_voice_t *v, int32_t *out, uint32_t frames) {
+    const uint8_t *data = v->buf[v->play_buf];
+    uint32_t pos = v->play_pos;
+    int32_t gain = v->gain_q15;
+
+    if (v->sample->format == SAMPLE_FORMAT_IMA_ADPCM) {
+        for (uint32_t i = 0; i < frames; i++, pos++) {
+            uint8_t byte = data[pos >> 1];
+            uint8_t code = (pos & 1) ? (byte >> 4) : (byte & 0x0F);
+            int32_t s = adpcm_decode_sample(&v->adpcm, code);
+            out[i] += (s * gain) >> 15;
+        }
+    } else {
+        const int16_t *pcm = (const int16_t *)data;
+        for (uint32_t i = 0; i < frames; i++, pos++) {
+            out[i] += (pcm[pos] * gain) >> 15;
+        }
+    }
+}
+
+/**
+ * @brief 1ボイスをチャンクに加算
+ */
+static void render_voice(uint32_t voice_index, int32_t *out, uint32_t frames) {
+    sampler_voice_t *v = &voices[voice_index];
+    uint32_t i = 0;
+
+    while (i < frames && v->active) {
+        if (!v->ready[v->play_buf]) {
+            // 先読みが間に合っていない: 進めずに待つ
+            stat_underruns += frames - i;
+            return;
+        }
+
+        uint32_t run = v->buf_frames[v->play_buf] - v->play_pos;
+        if (run > frames - i) {
+            run = frames - i;
+        }
+
+        render_run(v, out + i, run);
+        v->play_pos += run;
+        v->frames_played += run;
+        i += run;
+
+        if (v->play_pos >= v->buf_frames[v->play_buf]) {
+            // 面を使い切った: 次のデータを要求して、もう一方の面へ
+            uint8_t done = v->play_buf;
+            v->ready[done] = false;
+            v->play_pos = 0;
+            v->play_buf ^= 1;
+            request_fill(voice_index, done);
+
+            if (v->frames_played >= v->sample->num_frames) {
+                v->active = false;
+            }
+        }
+    }
+}
+
+// ============================================================================
+// 公開関数
+// ============================================================================
+
+bool sampler_init(void) {
+    memset(voices, 0, sizeof(voices));
+    queue_head = 0;
+    queue_count = 0;
+
+    dma_channel = dma_claim_unused_channel(false);
+    if (dma_channel < 0) {
+        printf("ERROR: No free DMA channel for sampler\n");
+        return false;
+    }
+
+    if (!dma_irq_register(dma_channel, dma_handler)) {
+        printf("ERROR: Failed to register sampler DMA handler\n");
+        dma_channel_unclaim(dma_channel);
+        dma_channel = -1;
+        return false;
+    }
+
+    is_initialized = true;
+
+    printf("Sampler initialized: %d voices, %d bytes x 2 prefetch, DMA ch %d\n",
+           SAMPLER_NUM_VOICES, SAMPLER_PREFETCH_BYTES, dma_channel);
+    for (uint32_t i = 0; i < sample_bank_count; i++) {
+        const sample_t *s = &sample_bank[i];
+        printf("  [%lu] %s: %lu frames, %lu bytes (%s)\n",
+               i, s->name, s->num_frames, s->num_bytes,
+               s->format == SAMPLE_FORMAT_IMA_ADPCM ? "ADPCM" : "PCM16");
+    }
+    return true;
+}
+
+int sampler_trigger(uint32_t index, float gain) {
+    if (!is_initialized || index >= sample_bank_count) {
+        return -1;
+    }
+    const sample_t *s = &sample_bank[index];
+    if (s->num_frames == 0) {
+        return -1;
+    }
+
+    // 空きボイス、なければ最も古いボイス（世代番号が最小）
+    uint32_t voice_index = 0;
+    bool found = false;
+    for (uint32_t i = 0; i < SAMPLER_NUM_VOICES; i++) {
+        if (!voices[i].active) {
+            voice_index = i;
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        for (uint32_t i = 1; i < SAMPLER_NUM_VOICES; i++) {
+            if (voices[i].generation < voices[voice_index].generation) {
+                voice_index = i;
+            }
+        }
+    }
+
+    if (gain < 0.0f) gain = 0.0f;
+    if (gain > 1.0f) gain = 1.0f;
+
+    sampler_voice_t *v = &voices[voice_index];
+    v->active = false;
+    v->generation = next_generation++;   // 転送中・キュー中の古い要求を無効にする
+    v->sample = s;
+    v->gain_q15 = (int32_t)(gain * 32767.0f);
+    v->ready[0] = false;
+    v->ready[1] = false;
+    v->fetch_offset = 0;
+    v->frames_assigned = 0;
+    v->frames_played = 0;
+    v->play_buf = 0;
+    v->play_pos = 0;
+    v->adpcm.predictor = 0;
+    v->adpcm.index = 0;
+
+    request_fill(voice_index, 0);
+    request_fill(voice_index, 1);
+
+    v->active = true;
+    stat_triggers++;
+    return (int)voice_index;
+}
+
+void sampler_stop_all(void) {
+    for (uint32_t i = 0; i < SAMPLER_NUM_VOICES; i++) {
+        voices[i].active = false;
+        voices[i].generation = next_generation++;
+    }
+}
+
+uint32_t sampler_get_bank_size(void) {
+    return sample_bank_count;
+}
+
+void sampler_get_stats(sampler_stats_t *stats) {
+    if (!stats) return;
+    stats->triggers = stat_triggers;
+    stats->transfers = stat_transfers;
+    stats->underruns = stat_underruns;
+    stats->max_queue_depth = stat_max_queue;
+}
+
+void sampler_process(int16_t *left, int16_t *right, uint32_t num_samples) {
+    if (!is_initialized) return;
+
+    bool any_active = false;
+    for (uint32_t v = 0; v < SAMPLER_NUM_VOICES; v++) {
+        any_active |= voices[v].active;
+    }
+    if (!any_active) return;
+
+    for (uint32_t offset = 0; offset < num_samples; offset += SAMPLER_CHUNK_FRAMES) {
+        uint32_t frames = num_samples - offset;
+        if (frames > SAMPLER_CHUNK_FRAMES) {
+            frames = SAMPLER_CHUNK_FRAMES;
+        }
+
+        memset(mix_buf, 0, frames * sizeof(int32_t));
+        for (uint32_t v = 0; v < SAMPLER_NUM_VOICES; v++) {
+            if (voices[v].active) {
+                render_voice(v, mix_buf, frames);
+            }
+        }
+
+        for (uint32_t i = 0; i < frames; i++) {
+            left[offset + i] = saturate(left[offset + i] + mix_buf[i]);
+            right[offset + i] = saturate(right[offset + i] + mix_buf[i]);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file sampler.h
+ * @brief フラッシュからストリーミングするワンショットサンプルプレーヤー - ヘッダーファイル
+ *
+ * SAMPLER_NUM_VOICES ボイスのポリフォニー。各ボイスは SAMPLER_PREFETCH_BYTES × 2 の
+ * ピンポンバッファを持ち、再生中のバッファを使い切ったら、もう一方を再生している間に
+ * 使い切った方へ次のデータを DMA で先読みする。
+ * オーディオ処理は XIP を直接読まないので、フラッシュのキャッシュミスで止まらない。
+ *
+ * 先読み要求は FIFO に積み、1本の DMA チャンネルで順番に転送する
+ * （完了割り込みで次の要求を開始する）。
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief サンプルプレーヤーの統計
+ */
+typedef struct {
+    uint32_t triggers;         // トリガー回数
+    uint32_t transfers;        // 完了した DMA 転送数
+    uint32_t underruns;        // 先読みが間に合わず無音にしたフレーム数
+    uint32_t max_queue_depth;  // 先読みキューの最大長
+} sampler_stats_t;
+
+/**
+ * @brief サンプルプレーヤーの初期化（DMA チャンネルの確保、バンクの表示）
+ * @return true 成功
+ */
+bool sampler_init(void);
+
+/**
+ * @brief サンプルを再生（空きボイスがなければ最も古いボイスを奪う）
+ * @param index バンク内の番号
+ * @param gain ゲイン（0.0-1.0）
+ * @return int ボイス番号、失敗時は -1
+ */
+int sampler_trigger(uint32_t index, float gain);
+
+/**
+ * @brief すべてのボイスを停止
+ */
+void sampler_stop_all(void);
+
+/**
+ * @brief バンク内のサンプル数
+ */
+uint32_t sampler_get_bank_size(void);
+
+/**
+ * @brief 統計を取得
+ */
+void sampler_get_stats(sampler_stats_t *stats);
+
+/**
+ * @brief 再生中のボイスをブロックにミックス（L/R に同じ音を加算）
+ * @param left 左チャンネル（プレーナー、上書き）
+ * @param right 右チャンネル（プレーナー、上書き）
+ * @param num_samples ステレオペア数
+ */
+void sampler_process(int16_t *left, int16_t *right, uint32_t num_samples);
+
+#endif // SAMPLER_H
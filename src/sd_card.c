@@ -0,0 +1,457 @@
+/**
+ * @file sd_card.c
+ * @brief SPI モードの SD カードのブロックデバイスの実装
+ *
+ * 書き込みの流れ（CMD25 のマルチブロック書き込み）:
+ *   ビジー待ち → CMD25 → [0xFC トークン → 512バイト（DMA）→ CRC → データ応答 → ビジー待ち] × N
+ *         → Stop Tran トークン（0xFD）→ ビジー待ち
+ * 失敗した書き込みも Stop Tran で打ち切り、ビジーの終わりを待ってから ERROR を返す。
+ * DMA は送信（データ → SPI）と受信（SPI → 読み捨て）の2チャンネルを同時に動かす。
+ * どのビジー待ちも1回の呼び出しで SD_BUSY_POLL_BYTES バイトまで読んで戻る
+ * （メインループを止めない。同期で待つのは初期化と読み出しだけ）。
+ * CRC は SPI モードの既定どおり無効（CMD0 / CMD8 だけ固定の CRC を付ける）。
+ */
+
+#include "sd_card.h"
+#include "config.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+
+// ============================================================================
+// 定数
+// ============================================================================
+
+// コマンド
+#define CMD0    0    // GO_IDLE_STATE
+#define CMD8    8    // SEND_IF_COND
+#define CMD16   16   // SET_BLOCKLEN
+#define CMD17   17   // READ_SINGLE_BLOCK
+#define CMD25   25   // WRITE_MULTIPLE_BLOCK
+#define CMD55   55   // APP_CMD
+#define CMD58   58   // READ_OCR
+#define ACMD41  41   // SD_SEND_OP_COND
+
+// トークン
+#define TOKEN_START_BLOCK  0xFE   // 読み出しデータの開始
+#define TOKEN_START_MULTI  0xFC   // マルチブロック書き込みの各ブロックの開始
+#define TOKEN_STOP_TRAN    0xFD   // マルチブロック書き込みの終了
+#define DATA_ACCEPTED      0x05   // データ応答（下位5ビット）
+
+// R1 応答
+#define R1_IDLE            0x01
+#define R1_ILLEGAL_CMD     0x04
+
+// 1回のポーリングでビジーを確認する最大バイト数（25MHz で約 20us）
+#define SD_BUSY_POLL_BYTES 64
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static bool initialized = false;
+static bool block_addressing = false;   // SDHC/SDXC: ブロック番号、SDSC: バイトアドレス
+
+static int dma_tx = -1;
+static int dma_rx = -1;
+static uint8_t dma_rx_discard;
+
+// 非同期書き込みの段階
+typedef enum {
+    PHASE_IDLE = 0,
+    PHASE_COMMAND,     // CMD25 の前にカードのビジーが終わるのを待つ
+    PHASE_DATA,        // 1ブロックを DMA で送信中
+    PHASE_BUSY,        // ブロックの書き込み中（ビジー）
+    PHASE_STOP_BUSY,   // Stop Tran 後のビジー
+    PHASE_ABORT_BUSY,  // 失敗した書き込みを打ち切った Stop Tran 後のビジー
+    PHASE_ERROR,       // 失敗（次のポーリングで ERROR を返す）
+} write_phase_t;
+
+static write_phase_t phase = PHASE_IDLE;
+static uint32_t write_address;          // CMD25 の引数
+static const uint8_t *write_data;
+static uint32_t write_blocks_left;
+static uint32_t busy_start_us;
+
+// ============================================================================
+// SPI の基本操作
+// ============================================================================
+
+static inline void cs_select(void) {
+    gpio_put(SD_CS_PIN, 0);
+}
+
+static inline void cs_deselect(void) {
+    gpio_put(SD_CS_PIN, 1);
+}
+
+static uint8_t xfer(uint8_t out) {
+    uint8_t in;
+    spi_write_read_blocking(SD_SPI_INSTANCE, &out, &in, 1);
+    return in;
+}
+
+static void release(void) {
+    cs_deselect();
+    xfer(0xFF);     // CS を上げた後に1バイト送ってカードに MISO を離させる
+}
+
+static bool wait_ready(uint32_t timeout_ms) {
+    uint32_t start_us = time_us_32();
+    while (xfer(0xFF) != 0xFF) {
+        if (time_us_32() - start_us > timeout_ms * 1000) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief コマンドのフレームを送り R1 応答を返す（カードのビジーが終わっていること、0xFF = 応答なし）
+ */
+static uint8_t send_command_frame(uint8_t cmd, uint32_t arg) {
+    // CRC が要るのは CMD0 と CMD8 だけ（以降は CRC チェックが無効）
+    uint8_t crc = (cmd == CMD0) ? 0x95 : (cmd == CMD8) ? 0x87 : 0x01;
+
+    uint8_t frame[6] = {
+        (uint8_t)(0x40 | cmd),
+        (uint8_t)(arg >> 24), (uint8_t)(arg >> 16), (uint8_t)(arg >> 8), (uint8_t)arg,
+        crc,
+    };
+    spi_write_blocking(SD_SPI_INSTANCE, frame, sizeof(frame));
+
+    // 応答は 0-8 バイト後（最上位ビットが 0 のバイト）
+    uint8_t r1 = 0xFF;
+    for (int i = 0; i < 10; i++) {
+        r1 = xfer(0xFF);
+        if ((r1 & 0x80) == 0) {
+            break;
+        }
+    }
+    return r1;
+}
+
+/**
+ * @brief コマンドを送り R1 応答を返す（同期、CS は選択したまま、0xFF = 応答なし）
+ */
+static uint8_t send_command(uint8_t cmd, uint32_t arg) {
+    release();
+    cs_select();
+    if (cmd != CMD0 && !wait_ready(SD_WRITE_TIMEOUT_MS)) {
+        return 0xFF;
+    }
+    return send_command_frame(cmd, arg);
+}
+
+static uint8_t send_app_command(uint8_t cmd, uint32_t arg) {
+    uint8_t r1 = send_command(CMD55, 0);
+    if (r1 > R1_IDLE) {
+        return r1;
+    }
+    return send_command(cmd, arg);
+}
+
+// ============================================================================
+// 初期化
+// ============================================================================
+
+bool sd_card_init(void) {
+    spi_init(SD_SPI_INSTANCE, SD_SPI_INIT_BAUD);
+    spi_set_format(SD_SPI_INSTANCE, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+    gpio_set_function(SD_SCK_PIN, GPIO_FUNC_SPI);
+    gpio_set_function(SD_MOSI_PIN, GPIO_FUNC_SPI);
+    gpio_set_function(SD_MISO_PIN, GPIO_FUNC_SPI);
+    gpio_pull_up(SD_MISO_PIN);
+    gpio_init(SD_CS_PIN);
+    gpio_set_dir(SD_CS_PIN, GPIO_OUT);
+    cs_deselect();
+
+    // CS = high のまま 80 クロック以上送ってカードを起こす
+    for (int i = 0; i < 10; i++) {
+        xfer(0xFF);
+    }
+
+    // CMD0 で SPI モードのアイドル状態へ
+    uint8_t r1 = 0xFF;
+    for (int i = 0; i < 10 && r1 != R1_IDLE; i++) {
+        r1 = send_command(CMD0, 0);
+    }
+    if (r1 != R1_IDLE) {
+        printf("[SD] No card (CMD0: 0x%02x)\n", r1);
+        release();
+        return false;
+    }
+
+    // CMD8 に応答すれば v2 以降（SDHC/SDXC の可能性）、不正コマンドなら v1
+    bool v2 = false;
+    r1 = send_command(CMD8, 0x1AA);
+    if (r1 == R1_IDLE) {
+        uint8_t r7[4];
+        for (int i = 0; i < 4; i++) {
+            r7[i] = xfer(0xFF);
+        }
+        if ((r7[2] & 0x0F) != 0x01 || r7[3] != 0xAA) {
+            printf("[SD] Unsupported voltage range (CMD8: %02x %02x)\n", r7[2], r7[3]);
+            release();
+            return false;
+        }
+        v2 = true;
+    } else if (!(r1 & R1_ILLEGAL_CMD)) {
+        printf("[SD] CMD8 failed (0x%02x)\n", r1);
+        release();
+        return false;
+    }
+
+    // ACMD41 で初期化の完了を待つ（v2 では HCS = 1 で大容量カードを受け付ける）
+    uint32_t start_us = time_us_32();
+    do {
+        r1 = send_app_command(ACMD41, v2 ? 0x40000000 : 0);
+        if (time_us_32() - start_us > SD_INIT_TIMEOUT_MS * 1000) {
+            printf("[SD] Initialization timeout (ACMD41: 0x%02x)\n", r1);
+            release();
+            return false;
+        }
+    } while (r1 != 0x00);
+
+    // OCR の CCS ビットでアドレスの単位を決める
+    block_addressing = false;
+    if (v2) {
+        if (send_command(CMD58, 0) != 0x00) {
+            printf("[SD] CMD58 failed\n");
+            release();
+            return false;
+        }
+        uint8_t ocr[4];
+        for (int i = 0; i < 4; i++) {
+            ocr[i] = xfer(0xFF);
+        }
+        block_addressing = (ocr[0] & 0x40) != 0;
+    }
+    if (!block_addressing && send_command(CMD16, SD_BLOCK_SIZE) != 0x00) {
+        printf("[SD] CMD16 failed\n");
+        release();
+        return false;
+    }
+    release();
+
+    uint32_t baud = spi_set_baudrate(SD_SPI_INSTANCE, SD_SPI_BAUD);
+
+    dma_tx = dma_claim_unused_channel(false);
+    dma_rx = dma_claim_unused_channel(false);
+    if (dma_tx < 0 || dma_rx < 0) {
+        printf("[SD] No free DMA channel\n");
+        if (dma_tx >= 0) {
+            dma_channel_unclaim(dma_tx);
+        }
+        if (dma_rx >= 0) {
+            dma_channel_unclaim(dma_rx);
+        }
+        dma_tx = dma_rx = -1;
+        return false;
+    }
+
+    initialized = true;
+    phase = PHASE_IDLE;
+    printf("[SD] %s card, SPI %lu Hz, DMA channels %d/%d\n",
+           block_addressing ? "SDHC/SDXC" : "SDSC", baud, dma_tx, dma_rx);
+    return true;
+}
+
+void sd_card_deinit(void) {
+    if (dma_tx >= 0) {
+        dma_channel_unclaim(dma_tx);
+    }
+    if (dma_rx >= 0) {
+        dma_channel_unclaim(dma_rx);
+    }
+    dma_tx = dma_rx = -1;
+    if (initialized) {
+        release();
+        spi_deinit(SD_SPI_INSTANCE);
+    }
+    initialized = false;
+    phase = PHASE_IDLE;
+}
+
+// ============================================================================
+// 読み出し
+// ============================================================================
+
+bool sd_card_read_block(uint32_t lba, uint8_t *data) {
+    if (!initialized || phase != PHASE_IDLE) {
+        return false;
+    }
+
+    bool ok = false;
+    if (send_command(CMD17, block_addressing ? lba : lba * SD_BLOCK_SIZE) == 0x00) {
+        uint32_t start_us = time_us_32();
+        uint8_t token;
+        do {
+            token = xfer(0xFF);
+        } while (token == 0xFF && time_us_32() - start_us < SD_READ_TIMEOUT_MS * 1000);
+
+        if (token == TOKEN_START_BLOCK) {
+            spi_read_blocking(SD_SPI_INSTANCE, 0xFF, data, SD_BLOCK_SIZE);
+            xfer(0xFF);     // CRC（読み捨て）
+            xfer(0xFF);
+            ok = true;
+        }
+    }
+    release();
+    return ok;
+}
+
+// ============================================================================
+// 非同期のマルチブロック書き込み
+// ============================================================================
+
+/**
+ * @brief 次のブロックの開始トークンを送り、データの DMA を始める
+ */
+static void start_block(void) {
+    xfer(0xFF);
+    xfer(TOKEN_START_MULTI);
+
+    // 受信側: SPI → 読み捨て（受信 FIFO をあふれさせない）
+    dma_channel_config c = dma_channel_get_default_config(dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(SD_SPI_INSTANCE, false));
+    dma_channel_configure(dma_rx, &c, &dma_rx_discard, &spi_get_hw(SD_SPI_INSTANCE)->dr,
+                          SD_BLOCK_SIZE, false);
+
+    // 送信側: データ → SPI
+    c = dma_channel_get_default_config(dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(SD_SPI_INSTANCE, true));
+    dma_channel_configure(dma_tx, &c, &spi_get_hw(SD_SPI_INSTANCE)->dr, write_data,
+                          SD_BLOCK_SIZE, false);
+
+    dma_start_channel_mask((1u << dma_tx) | (1u << dma_rx));
+    phase = PHASE_DATA;
+}
+
+/**
+ * @brief Stop Tran を送る（その1バイト後からビジーになる、終わりは next で待つ）
+ */
+static void stop_transmission(write_phase_t next) {
+    xfer(TOKEN_STOP_TRAN);
+    xfer(0xFF);
+    busy_start_us = time_us_32();
+    phase = next;
+}
+
+/**
+ * @brief ビジーが終わったか（MISO が 0xFF に戻ったか）を少しだけ見る
+ */
+static bool busy_done(void) {
+    for (int i = 0; i < SD_BUSY_POLL_BYTES; i++) {
+        if (xfer(0xFF) == 0xFF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool sd_card_write_start(uint32_t lba, const uint8_t *data, uint32_t blocks) {
+    if (!initialized || phase != PHASE_IDLE || blocks == 0) {
+        return false;
+    }
+
+    // CMD25 は前の書き込みのビジーが終わってから（sd_card_write_poll() で待つ）
+    release();
+    cs_select();
+    write_address = block_addressing ? lba : lba * SD_BLOCK_SIZE;
+    write_data = data;
+    write_blocks_left = blocks;
+    busy_start_us = time_us_32();
+    phase = PHASE_COMMAND;
+    return true;
+}
+
+sd_write_status_t sd_card_write_poll(void) {
+    switch (phase) {
+        case PHASE_IDLE:
+            return SD_WRITE_IDLE;
+
+        case PHASE_COMMAND:
+            if (!busy_done()) {
+                if (time_us_32() - busy_start_us > SD_WRITE_TIMEOUT_MS * 1000) {
+                    printf("[SD] Card busy before write\n");
+                    release();
+                    phase = PHASE_ERROR;
+                }
+                return SD_WRITE_BUSY;
+            }
+            if (send_command_frame(CMD25, write_address) != 0x00) {
+                release();
+                phase = PHASE_ERROR;
+                return SD_WRITE_BUSY;
+            }
+            start_block();
+            return SD_WRITE_BUSY;
+
+        case PHASE_DATA: {
+            // 受信側が終われば送信も終わっている
+            if (dma_channel_is_busy(dma_rx)) {
+                return SD_WRITE_BUSY;
+            }
+            xfer(0xFF);     // CRC（無効なのでダミー）
+            xfer(0xFF);
+            uint8_t response = xfer(0xFF);
+            if ((response & 0x1F) != DATA_ACCEPTED) {
+                printf("[SD] Write rejected (response 0x%02x)\n", response);
+                stop_transmission(PHASE_ABORT_BUSY);
+                return SD_WRITE_BUSY;
+            }
+            write_data += SD_BLOCK_SIZE;
+            write_blocks_left--;
+            busy_start_us = time_us_32();
+            phase = PHASE_BUSY;
+            return SD_WRITE_BUSY;
+        }
+
+        case PHASE_BUSY:
+            if (!busy_done()) {
+                if (time_us_32() - busy_start_us > SD_WRITE_TIMEOUT_MS * 1000) {
+                    printf("[SD] Write timeout\n");
+                    stop_transmission(PHASE_ABORT_BUSY);
+                }
+                return SD_WRITE_BUSY;
+            }
+            if (write_blocks_left > 0) {
+                start_block();
+                return SD_WRITE_BUSY;
+            }
+            stop_transmission(PHASE_STOP_BUSY);
+            return SD_WRITE_BUSY;
+
+        case PHASE_STOP_BUSY:
+        case PHASE_ABORT_BUSY: {
+            if (!busy_done()) {
+                if (time_us_32() - busy_start_us > SD_WRITE_TIMEOUT_MS * 1000) {
+                    printf("[SD] Stop timeout\n");
+                    release();
+                    phase = PHASE_ERROR;
+                }
+                return SD_WRITE_BUSY;
+            }
+            release();
+            bool aborted = (phase == PHASE_ABORT_BUSY);
+            phase = PHASE_IDLE;
+            return aborted ? SD_WRITE_ERROR : SD_WRITE_DONE;
+        }
+
+        case PHASE_ERROR:
+        default:
+            phase = PHASE_IDLE;
+            return SD_WRITE_ERROR;
+    }
+}
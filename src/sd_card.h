@@ -0,0 +1,67 @@
+/**
+ * @file sd_card.h
+ * @brief SPI モードの SD カードのブロックデバイス - ヘッダーファイル
+ *
+ * ハードウェア SPI（SD_SPI_INSTANCE）で SD / SDHC カードを 512バイトのブロック単位で読み書きする。
+ * - 初期化と1ブロックの読み出しは同期（起動時と録音開始前だけ使う）
+ * - 書き込みは非同期のマルチブロック（CMD25）: 各ブロックのデータは DMA で送り、
+ *   CMD25 の前のビジー待ち、データ応答、ビジー待ち、失敗時の打ち切りは
+ *   sd_card_write_poll() でメインループから進める（BTstack のポーリングを止めない）
+ */
+
+#ifndef SD_CARD_H
+#define SD_CARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SD_BLOCK_SIZE  512
+
+/**
+ * @brief 非同期書き込みの状態
+ */
+typedef enum {
+    SD_WRITE_IDLE = 0,   // 書き込みなし
+    SD_WRITE_BUSY,       // 書き込み中
+    SD_WRITE_DONE,       // 完了（読んだら IDLE に戻る）
+    SD_WRITE_ERROR,      // 失敗（読んだら IDLE に戻る）
+} sd_write_status_t;
+
+/**
+ * @brief 初期化（SPI と DMA チャンネルの確保、カードの初期化）
+ * @return true カードを認識した
+ */
+bool sd_card_init(void);
+
+/**
+ * @brief SPI を止めて DMA チャンネルを返す（録音しないとき）
+ */
+void sd_card_deinit(void);
+
+/**
+ * @brief 1ブロックを読む（同期）
+ * @param lba ブロック番号
+ * @param data 読み込み先（SD_BLOCK_SIZE バイト）
+ * @return true 成功
+ */
+bool sd_card_read_block(uint32_t lba, uint8_t *data);
+
+/**
+ * @brief 連続するブロックの書き込みを開始（非同期）
+ *
+ * data は完了（sd_card_write_poll が DONE / ERROR を返す）まで変更しないこと。
+ * コマンドの失敗も sd_card_write_poll() の ERROR で返す。
+ * @param lba 先頭ブロック番号
+ * @param data 書き込むデータ（blocks × SD_BLOCK_SIZE バイト）
+ * @param blocks ブロック数
+ * @return true 開始した（未初期化または書き込み中なら false）
+ */
+bool sd_card_write_start(uint32_t lba, const uint8_t *data, uint32_t blocks);
+
+/**
+ * @brief 非同期書き込みを進める（メインループから呼ぶ、長く待たずに戻る）
+ * @return 書き込みの状態
+ */
+sd_write_status_t sd_card_write_poll(void);
+
+#endif // SD_CARD_H
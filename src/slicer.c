@@ -0,0 +1,140 @@
+/**
+ * @file slicer.c
+ * @brief Beat-Slicer の並べ替えパターンとスライス窓の実装
+ */
+
+#include "slicer.h"
+
+#include <string.h>
+#include <math.h>
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define FADE_GAIN_UNITY  32768
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// ステップ → スライス番号（小節の頭で作り直す）
+static uint8_t slicer_order[SLICER_NUM_STEPS];
+
+// ユーザーパターン
+static uint8_t user_pattern[SLICER_NUM_STEPS];
+static uint32_t user_pattern_length = SLICER_NUM_STEPS;
+
+// フェードイン用のレイズドコサイン窓（Q15、0 → ほぼ 1.0）
+// フェードアウトは同じテーブルを逆から読む
+static int16_t fade_table[SLICER_FADE_FRAMES];
+
+static uint32_t random_state = 54321;
+
+// ============================================================================
+// ヘルパー関数
+// ============================================================================
+
+static inline uint32_t next_random(uint32_t range) {
+    // xorshift32
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state % range;
+}
+
+// ============================================================================
+// 初期化・設定
+// ============================================================================
+
+void slicer_init(void) {
+    for (uint32_t i = 0; i < SLICER_FADE_FRAMES; i++) {
+        float w = 0.5f - 0.5f * cosf((float)M_PI * (float)i / (float)SLICER_FADE_FRAMES);
+        fade_table[i] = (int16_t)(w * 32767.0f);
+    }
+
+    for (uint32_t i = 0; i < SLICER_NUM_STEPS; i++) {
+        slicer_order[i] = (uint8_t)i;
+        user_pattern[i] = (uint8_t)i;
+    }
+    user_pattern_length = SLICER_NUM_STEPS;
+}
+
+void slicer_set_user_pattern(const uint8_t *pattern, uint32_t num_steps) {
+    if (!pattern || num_steps == 0) return;
+    if (num_steps > SLICER_NUM_STEPS) num_steps = SLICER_NUM_STEPS;
+
+    for (uint32_t i = 0; i < num_steps; i++) {
+        user_pattern[i] = (pattern[i] < SLICER_NUM_STEPS) ? pattern[i] : 0;
+    }
+    user_pattern_length = num_steps;
+}
+
+// ============================================================================
+// 並べ替え
+// ============================================================================
+
+void slicer_next_bar(slicer_pattern_t mode, uint32_t num_slices, uint32_t num_steps) {
+    if (num_slices == 0) num_slices = 1;
+    if (num_steps > SLICER_NUM_STEPS) num_steps = SLICER_NUM_STEPS;
+
+    switch (mode) {
+        case SLICER_PATTERN_SHUFFLE:
+            // Fisher-Yates（ステップ数とスライス数が違う時は繰り返してから混ぜる）
+            for (uint32_t i = 0; i < num_steps; i++) {
+                slicer_order[i] = (uint8_t)(i % num_slices);
+            }
+            for (uint32_t i = num_steps - 1; i > 0; i--) {
+                uint32_t j = next_random(i + 1);
+                uint8_t tmp = slicer_order[i];
+                slicer_order[i] = slicer_order[j];
+                slicer_order[j] = tmp;
+            }
+            break;
+
+        case SLICER_PATTERN_REVERSE:
+            for (uint32_t i = 0; i < num_steps; i++) {
+                slicer_order[i] = (uint8_t)(num_slices - 1 - (i % num_slices));
+            }
+            break;
+
+        case SLICER_PATTERN_USER:
+            for (uint32_t i = 0; i < num_steps; i++) {
+                slicer_order[i] = (uint8_t)(user_pattern[i % user_pattern_length] % num_slices);
+            }
+            break;
+
+        case SLICER_PATTERN_RANDOM:
+        default:
+            for (uint32_t i = 0; i < num_steps; i++) {
+                slicer_order[i] = (uint8_t)next_random(num_slices);
+            }
+            break;
+    }
+}
+
+uint32_t slicer_get_slice(uint32_t step) {
+    return slicer_order[step];
+}
+
+// ============================================================================
+// スライス窓
+// ============================================================================
+
+int32_t slicer_fade_gain(uint32_t pos, uint32_t length) {
+    // 短いスライスではフェード長を半分までに縮める
+    uint32_t fade = SLICER_FADE_FRAMES;
+    if (fade > length / 2) fade = length / 2;
+    if (fade == 0) return FADE_GAIN_UNITY;
+
+    uint32_t from_end = length - 1 - pos;
+    uint32_t edge = (pos < from_end) ? pos : from_end;
+    if (edge >= fade) return FADE_GAIN_UNITY;
+
+    // 縮めた場合はテーブルを間引いて読む
+    return fade_table[edge * SLICER_FADE_FRAMES / fade];
+}
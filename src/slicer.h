@@ -0,0 +1,64 @@
+/**
+ * @file slicer.h
+ * @brief Beat-Slicer の並べ替えパターンとスライス窓 - ヘッダーファイル
+ *
+ * 直前の小節をビートグリッドで N 個のスライスに分け、次の小節の各ステップで
+ * どのスライスを再生するかを決める。並びはバーの頭で1回だけ作るので、
+ * ステップごとの参照はテーブルを1回引くだけ（O(1)）。
+ * オーディオ自体はエフェクトの履歴バッファから直接読み、コピーしない。
+ */
+
+#ifndef SLICER_H
+#define SLICER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+/**
+ * @brief 並べ替えパターン
+ */
+typedef enum {
+    SLICER_PATTERN_SHUFFLE = 0,   // 小節ごとに並べ替え（各スライス1回ずつ）
+    SLICER_PATTERN_REVERSE,       // スライスの順番を逆にする（スライス内は順再生）
+    SLICER_PATTERN_USER,          // slicer_set_user_pattern() で指定した並び
+    SLICER_PATTERN_RANDOM,        // ステップごとにランダム（重複あり）
+} slicer_pattern_t;
+
+/**
+ * @brief スライサーの初期化（窓テーブルの生成、並びは順番通り）
+ */
+void slicer_init(void);
+
+/**
+ * @brief ユーザーパターンを設定
+ * @param pattern ステップごとのスライス番号（0 〜 SLICER_NUM_STEPS-1）
+ * @param num_steps パターンの長さ（SLICER_NUM_STEPS 以下、足りない分は繰り返す）
+ */
+void slicer_set_user_pattern(const uint8_t *pattern, uint32_t num_steps);
+
+/**
+ * @brief 次の小節の並びを作る（小節の頭で1回）
+ * @param mode 並べ替えパターン
+ * @param num_slices 直前の小節のスライス数
+ * @param num_steps 次の小節のステップ数
+ */
+void slicer_next_bar(slicer_pattern_t mode, uint32_t num_slices, uint32_t num_steps);
+
+/**
+ * @brief ステップで再生するスライス番号
+ * @param step ステップ番号
+ * @return スライス番号
+ */
+uint32_t slicer_get_slice(uint32_t step);
+
+/**
+ * @brief スライスの両端のマイクロフェード（窓テーブル参照）
+ * @param pos スライス内の位置
+ * @param length スライス長
+ * @return ゲイン（Q15、32768 = 1.0）
+ */
+int32_t slicer_fade_gain(uint32_t pos, uint32_t length);
+
+#endif // SLICER_H
@@ -0,0 +1,182 @@
+/**
+ * @file sram_layout.c
+ * @brief SRAM バンク配置の確認とバス競合カウンタの実装
+ *
+ * 性能カウンタは 24ビットで飽和し、読み出すまで止まったままになる。
+ * メインループから SRAM_BUS_SAMPLE_MS ごとに読んでゼロに戻し、64ビットに積算する。
+ * 読み出しからクリアまでの間の数カウントは失われるが、比率を見る分には問題ない。
+ */
+
+#include "sram_layout.h"
+
+#include <stdio.h>
+
+#include "hardware/structs/busctrl.h"
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// 数えるイベント（BUSCTRL のアービタごとのイベント）
+// scratch X（I2S DMA のピンポン）と SRAM0（ストライプ領域の代表）のアクセスと競合
+// SRAM_PLACEMENT_ENABLED を切り替えて、SRAM0 の競合率がどう変わるかを比べる
+typedef struct {
+    const char *name;
+    bus_ctrl_perf_counter_t event;
+} bus_counter_def_t;
+
+static const bus_counter_def_t counter_defs[SRAM_BUS_NUM_COUNTERS] = {
+    { "scratch_x access",    arbiter_sram8_perf_event_access },
+    { "scratch_x contested", arbiter_sram8_perf_event_access_contested },
+    { "sram0 access",        arbiter_sram0_perf_event_access },
+    { "sram0 contested",     arbiter_sram0_perf_event_access_contested },
+};
+
+#define COUNTER_MAX  0x00FFFFFFu   // 24ビットで飽和
+
+static uint64_t totals[SRAM_BUS_NUM_COUNTERS];
+static uint32_t saturated = 0;
+static absolute_time_t last_sample_time;
+
+// リンカースクリプトが定義する境界（スタックは __StackBottom から __StackTop まで）
+extern uint32_t __StackBottom[];
+extern uint32_t __StackTop[];
+extern uint32_t __scratch_y_start__[];
+extern uint32_t __scratch_y_end__[];
+
+#define STACK_PAINT   0xC5C5C5C5u   // 使っていないスタックを塗るパターン
+#define STACK_CANARY  0x5EA1ED00u   // 最下端の番兵
+#define STACK_PAINT_GAP_WORDS  16   // 今のフレームの下は少し空けて塗る
+
+// ============================================================================
+// スタックの監視
+// ============================================================================
+
+void sram_layout_stack_init(void) {
+    uint32_t *bottom = __StackBottom;
+    uint32_t *top = __StackTop;
+    volatile uint32_t marker = 0;
+    uint32_t *sp = (uint32_t *)(uintptr_t)&marker;
+
+    // 今のスタックポインタより下だけ塗る（スタックの外で呼ばれた時は全体）
+    uint32_t *end = (sp > bottom && sp <= top) ? sp - STACK_PAINT_GAP_WORDS : top;
+    for (uint32_t *p = bottom + 1; p < end; p++) {
+        *p = STACK_PAINT;
+    }
+    bottom[0] = STACK_CANARY;
+
+#if defined(__ARM_ARCH_8M_MAIN__)
+    // これより下へ伸びると、書き込む前に UsageFault（.scratch_y の割り込みの状態を守る）
+    __asm volatile ("msr msplim, %0" : : "r"(bottom) : "memory");
+#endif
+}
+
+void sram_layout_get_stack_stats(sram_stack_stats_t *stats) {
+    const uint32_t *bottom = __StackBottom;
+    const uint32_t *top = __StackTop;
+    const uint32_t *p = bottom + 1;
+    while (p < top && *p == STACK_PAINT) {
+        p++;
+    }
+
+    stats->size = (uint32_t)((uintptr_t)top - (uintptr_t)bottom);
+    stats->high_water = (uint32_t)((uintptr_t)top - (uintptr_t)p);
+    stats->scratch_y_bytes = (uint32_t)((uintptr_t)__scratch_y_end__ - (uintptr_t)__scratch_y_start__);
+    stats->canary_intact = (bottom[0] == STACK_CANARY);
+}
+
+// ============================================================================
+// 初期化
+// ============================================================================
+
+void sram_layout_init(void) {
+#if SRAM_BUS_COUNTERS_ENABLED
+    for (int i = 0; i < SRAM_BUS_NUM_COUNTERS; i++) {
+        bus_ctrl_hw->counter[i].sel = counter_defs[i].event;
+        bus_ctrl_hw->counter[i].value = 0;   // 書き込みでクリア
+        totals[i] = 0;
+    }
+    bus_ctrl_hw->perfctr_en = 1;
+    last_sample_time = get_absolute_time();
+    printf("[SRAM] Bus counters: %s, %s, %s, %s (sampled every %d ms)\n",
+           counter_defs[0].name, counter_defs[1].name, counter_defs[2].name,
+           counter_defs[3].name, SRAM_BUS_SAMPLE_MS);
+#endif
+    printf("[SRAM] Placement: %s\n",
+           SRAM_PLACEMENT_ENABLED ? "DMA buffers in scratch X, IRQ state in scratch Y"
+                                  : "linker default");
+
+    sram_stack_stats_t stack;
+    sram_layout_get_stack_stats(&stack);
+    printf("[SRAM] Stack: %lu bytes (limit 0x%08lx), .scratch_y: %lu bytes, used so far: %lu bytes\n",
+           stack.size, (uint32_t)(uintptr_t)__StackBottom, stack.scratch_y_bytes, stack.high_water);
+}
+
+// ============================================================================
+// 配置の確認
+// ============================================================================
+
+const char *sram_layout_region_name(const void *addr) {
+    uint32_t a = (uint32_t)(uintptr_t)addr;
+    if (a < SRAM_LAYOUT_STRIPED_LO_BASE) {
+        return "flash";
+    }
+    if (a < SRAM_LAYOUT_STRIPED_HI_BASE) {
+        return "SRAM0-3";
+    }
+    if (a < SRAM_LAYOUT_SCRATCH_X_BASE) {
+        return "SRAM4-7";
+    }
+    if (a < SRAM_LAYOUT_SCRATCH_Y_BASE) {
+        return "scratch X";
+    }
+    if (a < SRAM_LAYOUT_END) {
+        return "scratch Y";
+    }
+    return "other";
+}
+
+void sram_layout_log_buffer(const char *name, const void *addr, uint32_t bytes) {
+    const char *first = sram_layout_region_name(addr);
+    const char *last = sram_layout_region_name((const uint8_t *)addr + (bytes ? bytes - 1 : 0));
+
+    if (first == last) {
+        printf("[SRAM] %-16s 0x%08lx %7lu bytes  %s\n",
+               name, (uint32_t)(uintptr_t)addr, bytes, first);
+    } else {
+        // 領域の境界をまたぐ（ストライプ領域の上下にまたがる大きなバッファなど）
+        printf("[SRAM] %-16s 0x%08lx %7lu bytes  %s + %s\n",
+               name, (uint32_t)(uintptr_t)addr, bytes, first, last);
+    }
+}
+
+// ============================================================================
+// バス競合カウンタ
+// ============================================================================
+
+void sram_layout_poll(void) {
+#if SRAM_BUS_COUNTERS_ENABLED
+    absolute_time_t now = get_absolute_time();
+    if (absolute_time_diff_us(last_sample_time, now) < SRAM_BUS_SAMPLE_MS * 1000) {
+        return;
+    }
+    last_sample_time = now;
+
+    for (int i = 0; i < SRAM_BUS_NUM_COUNTERS; i++) {
+        uint32_t value = bus_ctrl_hw->counter[i].value;
+        bus_ctrl_hw->counter[i].value = 0;
+        if (value >= COUNTER_MAX) {
+            saturated++;
+        }
+        totals[i] += value;
+    }
+#endif
+}
+
+void sram_layout_get_bus_stats(sram_bus_stats_t *stats) {
+    for (int i = 0; i < SRAM_BUS_NUM_COUNTERS; i++) {
+        stats->name[i] = counter_defs[i].name;
+        stats->count[i] = totals[i];
+    }
+    stats->saturated = saturated;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file sram_layout.h
+ * @brief SRAM バンクを意識したバッファ配置とバス競合カウンタ - ヘッダーファイル
+ *
+ * RP2350 の SRAM（520KB）は10バンク:
+ *   0x20000000 - 0x2003FFFF  SRAM0-3（ワード単位でストライプ、256KB）
+ *   0x20040000 - 0x2007FFFF  SRAM4-7（ワード単位でストライプ、256KB）
+ *   0x20080000 - 0x20080FFF  SRAM8 = scratch X（ストライプなし、4KB）
+ *   0x20081000 - 0x20081FFF  SRAM9 = scratch Y（ストライプなし、4KB、コア0のスタック）
+ * バスファブリックはバンクごとに調停するので、DMA が読むバッファを
+ * CPU がほとんど触らないバンクに置けば、互いに待たされなくなる。
+ *
+ * 配置:
+ *   - I2S DMA のピンポンバッファ → scratch X（DMA 以外は割り込みでの詰め替えだけ）
+ *   - DMA 割り込みが毎回触る状態（リングの読み書き位置など）→ scratch Y
+ *   - スライスバッファ / I2S リングなどの大きなバッファ → ストライプ領域（リンカー任せ）
+ *
+ * scratch Y はコア0のスタック（上端から下へ伸びる、PICO_STACK_SIZE）と .scratch_y を
+ * 分け合う。両方が 4KB に収まることを src/sram_layout.ld でリンク時に確かめ、実行時は
+ * スタックの下限を MSPLIM に設定して（越えると書き込む前にフォールト）、.scratch_y の
+ * 状態が黙って壊れないようにする。起動時にスタックをパターンで塗り、最大使用量を報告する。
+ *
+ * BUSCTRL の性能カウンタ（4本、24ビット飽和）で各バンクのアクセス数と
+ * 競合（調停で待たされた）数を数え、飽和する前に定期的に読み出して積算する。
+ * ビルド後の配置は tools/sram_map.py でリンカーマップから確認できる。
+ */
+
+#ifndef SRAM_LAYOUT_H
+#define SRAM_LAYOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico/stdlib.h"
+
+#include "config.h"
+
+// SRAM の領域（RP2350）
+#define SRAM_LAYOUT_STRIPED_LO_BASE  0x20000000u
+#define SRAM_LAYOUT_STRIPED_HI_BASE  0x20040000u
+#define SRAM_LAYOUT_SCRATCH_X_BASE   0x20080000u
+#define SRAM_LAYOUT_SCRATCH_Y_BASE   0x20081000u
+#define SRAM_LAYOUT_END              0x20082000u
+#define SRAM_LAYOUT_SCRATCH_BYTES    4096u
+
+// 配置用の属性（SRAM_PLACEMENT_ENABLED = 0 なら通常の .bss / .data に置く）
+// scratch のセクションは起動時にフラッシュからコピーされる（ゼロ初期化でもイメージに含まれる）
+#if SRAM_PLACEMENT_ENABLED
+#define SRAM_DMA_BUFFER(group)  __scratch_x(group)
+#define SRAM_HOT_STATE(group)   __scratch_y(group)
+#else
+#define SRAM_DMA_BUFFER(group)
+#define SRAM_HOT_STATE(group)
+#endif
+
+// 性能カウンタの本数
+#define SRAM_BUS_NUM_COUNTERS  4
+
+/**
+ * @brief バス競合カウンタの積算値
+ */
+typedef struct {
+    const char *name[SRAM_BUS_NUM_COUNTERS];    // 例: "scratch_x access"
+    uint64_t count[SRAM_BUS_NUM_COUNTERS];      // 起動からの積算
+    uint32_t saturated;                         // 読み出し前に飽和した回数（値は下限）
+} sram_bus_stats_t;
+
+/**
+ * @brief コア0のスタックの使用状況
+ */
+typedef struct {
+    uint32_t size;             // スタックの大きさ（PICO_STACK_SIZE）
+    uint32_t high_water;       // 起動からの最大使用量（バイト、塗ったパターンが消えた深さ）
+    uint32_t scratch_y_bytes;  // スタックの下にある .scratch_y の大きさ
+    bool canary_intact;        // 最下端の番兵が残っている（false = スタックを使い切った）
+} sram_stack_stats_t;
+
+/**
+ * @brief スタックの監視を始める（main() の最初に呼ぶ）
+ *
+ * 今のスタックポインタより下をパターンで塗り、最下端に番兵を置き、
+ * スタックの下限を MSPLIM に設定する。
+ */
+void sram_layout_stack_init(void);
+
+/**
+ * @brief スタックの使用状況を取得（塗ったパターンを下から数える）
+ */
+void sram_layout_get_stack_stats(sram_stack_stats_t *stats);
+
+/**
+ * @brief 初期化（性能カウンタを設定して計数を始める）
+ */
+void sram_layout_init(void);
+
+/**
+ * @brief バッファがどのバンクにあるかをログに出す（各モジュールの初期化から呼ぶ）
+ * @param name 表示名
+ * @param addr 先頭アドレス
+ * @param bytes サイズ
+ */
+void sram_layout_log_buffer(const char *name, const void *addr, uint32_t bytes);
+
+/**
+ * @brief アドレスを含む領域の名前（"SRAM0-3", "SRAM4-7", "scratch X", "scratch Y", "flash" など）
+ */
+const char *sram_layout_region_name(const void *addr);
+
+/**
+ * @brief 性能カウンタを読み出して積算する（メインループから呼ぶ、SRAM_BUS_SAMPLE_MS ごと）
+ */
+void sram_layout_poll(void);
+
+/**
+ * @brief バス競合カウンタの積算値を取得
+ */
+void sram_layout_get_bus_stats(sram_bus_stats_t *stats);
+
+#endif // SRAM_LAYOUT_H
@@ -228,39 +228,43 @@ note_division_t tap_tempo_get_note_division(void) {
 // BPMからスライス長への変換
 // ============================================================================
 
-uint32_t tap_tempo_bpm_to_slice_length(float bpm, note_division_t division, uint32_t sample_rate) {
+uint64_t tap_tempo_bpm_to_slice_length_q32(float bpm, note_division_t division, uint32_t sample_rate) {
     if (bpm <= 0) bpm = DEFAULT_BPM;
 
     // 4分音符の長さ（秒）
-    float quarter_note_sec = 60.0f / bpm;
+    // 小数部を 2^-32 サンプルまで残すため double で計算する（初期化/BPM変更時のみ）
+    double quarter_note_sec = 60.0 / (double)bpm;
 
     // 音符分解能に応じて調整
-    float note_sec = quarter_note_sec;
+    double note_sec = quarter_note_sec;
     switch (division) {
         case NOTE_WHOLE:
-            note_sec = quarter_note_sec * 4.0f;
+            note_sec = quarter_note_sec * 4.0;
             break;
         case NOTE_HALF:
-            note_sec = quarter_note_sec * 2.0f;
+            note_sec = quarter_note_sec * 2.0;
             break;
         case NOTE_QUARTER:
             note_sec = quarter_note_sec;
             break;
         case NOTE_EIGHTH:
-            note_sec = quarter_note_sec / 2.0f;
+            note_sec = quarter_note_sec / 2.0;
             break;
         case NOTE_SIXTEENTH:
-            note_sec = quarter_note_sec / 4.0f;
+            note_sec = quarter_note_sec / 4.0;
             break;
         case NOTE_THIRTY_SECOND:
-            note_sec = quarter_note_sec / 8.0f;
+            note_sec = quarter_note_sec / 8.0;
             break;
     }
 
-    // サンプル数に変換
-    uint32_t slice_length = (uint32_t)(note_sec * sample_rate);
+    // サンプル数（32.32 固定小数点）に変換
+    return (uint64_t)(note_sec * (double)sample_rate * 4294967296.0 + 0.5);
+}
 
-    return slice_length;
+uint32_t tap_tempo_bpm_to_slice_length(float bpm, note_division_t division, uint32_t sample_rate) {
+    // 整数部のみ（小数部は切り捨て）
+    return (uint32_t)(tap_tempo_bpm_to_slice_length_q32(bpm, division, sample_rate) >> 32);
 }
 
 // ============================================================================
@@ -114,6 +114,20 @@ note_division_t tap_tempo_get_note_division(void);
  */
 uint32_t tap_tempo_bpm_to_slice_length(float bpm, note_division_t division, uint32_t sample_rate);
 
+/**
+ * @brief BPMと音符分解能からスライス長を 32.32 固定小数点で計算
+ *
+ * 133 BPM の16分音符 = 4973.68 サンプルのように、スライス長は整数にならない。
+ * 小数部を捨てると1小節ごとにビートからずれていくので、エフェクト側で
+ * 小数部を累積してスライス境界を決めるために使う。
+ *
+ * @param bpm BPM
+ * @param division 音符分解能
+ * @param sample_rate サンプリングレート（Hz）
+ * @return uint64_t スライス長（上位32ビット = 整数部、下位32ビット = 小数部）
+ */
+uint64_t tap_tempo_bpm_to_slice_length_q32(float bpm, note_division_t division, uint32_t sample_rate);
+
 /**
  * @brief タップテンポをリセット
  */
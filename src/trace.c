@@ -0,0 +1,209 @@
+/**
+ * @file trace.c
+ * @brief オーディオ経路のタイムライントレースの実装
+ *
+ * 書き込み位置（head）は単調増加のカウンタで、レコードの位置はその下位ビット。
+ * head がバッファ長を超えた分は上書きされた古いイベント（ダンプで lost と表示）。
+ * ダンプ中は記録を止めるので、読み出しと書き込みは重ならない。
+ */
+
+#include "trace.h"
+
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+#if (TRACE_EVENTS_PER_CORE & (TRACE_EVENTS_PER_CORE - 1)) != 0
+#error "TRACE_EVENTS_PER_CORE must be a power of two"
+#endif
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+typedef struct {
+    trace_record_t records[TRACE_EVENTS_PER_CORE];
+    volatile uint32_t head;     // 記録したイベントの総数
+} trace_buffer_t;
+
+static trace_buffer_t buffers[NUM_CORES];
+
+static volatile bool recording = false;
+static volatile bool triggered = false;
+static volatile uint32_t post_trigger_remaining = 0;
+
+// ダンプの進行状態
+typedef enum {
+    DUMP_IDLE = 0,
+    DUMP_HEADER,
+    DUMP_RECORDS,
+} dump_state_t;
+
+static dump_state_t dump_state = DUMP_IDLE;
+static uint32_t dump_core;
+static uint32_t dump_head;      // ダンプ開始時の head
+static uint32_t dump_index;     // 次に出すイベントの通し番号
+static bool frozen_logged = false;
+
+// イベント名（trace_event_t の順、ダンプに含めて変換ツールと共有する）
+static const char *const event_names[TRACE_EV_COUNT] = {
+    "media_packet",
+    "decode",
+    "effect",
+    "ring_write",
+    "dma_irq",
+    "underrun",
+    "repeat_start",
+    "repeat_stop",
+    "param_change",
+    "ring_fill",
+    "transient",
+};
+
+// ============================================================================
+// 記録
+// ============================================================================
+
+void trace_record(uint8_t event, uint8_t phase, uint32_t arg) {
+    if (!recording) {
+        return;
+    }
+
+    uint32_t ts = time_us_32();
+    trace_buffer_t *buf = &buffers[get_core_num()];
+
+    // 同じコアの割り込みに割り込まれても別のレコードを予約できる
+    uint32_t index = __atomic_fetch_add(&buf->head, 1, __ATOMIC_RELAXED);
+    trace_record_t *r = &buf->records[index & (TRACE_EVENTS_PER_CORE - 1)];
+    r->ts_us = ts;
+    r->event = event;
+    r->flags = phase | (__get_current_exception() ? TRACE_FLAG_IRQ : 0);
+    r->arg = (arg > 0xFFFF) ? 0xFFFF : (uint16_t)arg;
+
+    // トリガー後の残り数（1回だけ読んで書き戻すので、割り込みが挟まっても 0 を下回らない）
+    uint32_t remaining = post_trigger_remaining;
+    if (remaining > 0) {
+        post_trigger_remaining = remaining - 1;
+        if (remaining == 1) {
+            recording = false;
+        }
+    }
+}
+
+void trace_trigger(void) {
+    if (triggered || !recording) {
+        return;
+    }
+    triggered = true;
+    post_trigger_remaining = TRACE_POST_TRIGGER_EVENTS;
+    if (TRACE_POST_TRIGGER_EVENTS == 0) {
+        recording = false;
+    }
+}
+
+// ============================================================================
+// 初期化
+// ============================================================================
+
+static void clear_buffers(void) {
+    for (int c = 0; c < NUM_CORES; c++) {
+        buffers[c].head = 0;
+    }
+    triggered = false;
+    post_trigger_remaining = 0;
+    frozen_logged = false;
+}
+
+void trace_init(void) {
+    clear_buffers();
+
+    // 1イベントあたりのオーバーヘッドを計測（呼び出しを含む）
+    recording = true;
+    uint32_t start_us = time_us_32();
+    for (int i = 0; i < TRACE_CALIBRATION_EVENTS; i++) {
+        trace_record(TRACE_EV_PARAM_CHANGE, TRACE_PHASE_INSTANT, (uint32_t)i);
+    }
+    uint32_t elapsed_us = time_us_32() - start_us;
+    recording = false;
+
+    clear_buffers();
+    recording = true;
+
+    printf("[TRACE] %d events/core x %d cores (%u bytes), %lu ns/event\n",
+           TRACE_EVENTS_PER_CORE, NUM_CORES, (unsigned)sizeof(buffers),
+           elapsed_us * 1000 / TRACE_CALIBRATION_EVENTS);
+}
+
+// ============================================================================
+// ダンプ
+// ============================================================================
+
+void trace_dump_start(void) {
+    if (dump_state != DUMP_IDLE) {
+        return;
+    }
+    recording = false;
+    dump_state = DUMP_HEADER;
+}
+
+bool trace_is_dumping(void) {
+    return dump_state != DUMP_IDLE;
+}
+
+/**
+ * @brief コアのダンプを始める（見出しを出し、残っている最古のイベントから）
+ */
+static void begin_core(uint32_t core) {
+    dump_core = core;
+    dump_head = buffers[core].head;
+    uint32_t count = (dump_head < TRACE_EVENTS_PER_CORE) ? dump_head : TRACE_EVENTS_PER_CORE;
+    dump_index = dump_head - count;
+    printf("[TRACE] core %lu events %lu lost %lu\n", core, count, dump_index);
+}
+
+void trace_poll(void) {
+    if (dump_state == DUMP_IDLE) {
+        // トリガーで止まった記録はダンプまで保持する
+        if (triggered && !recording && !frozen_logged) {
+            frozen_logged = true;
+            printf("[TRACE] Frozen after trigger (%d events kept)\n", TRACE_EVENTS_PER_CORE);
+#if TRACE_AUTO_DUMP
+            trace_dump_start();
+#endif
+        }
+        if (dump_state == DUMP_IDLE) {
+            return;
+        }
+    }
+
+    if (dump_state == DUMP_HEADER) {
+        printf("[TRACE] begin now=%08lx cores=%d\n", time_us_32(), NUM_CORES);
+        for (int e = 0; e < TRACE_EV_COUNT; e++) {
+            printf("[TRACE] event %d %s\n", e, event_names[e]);
+        }
+        begin_core(0);
+        dump_state = DUMP_RECORDS;
+        return;
+    }
+
+    // 1回の呼び出しで出す行数を制限して、メインループ（BTstack）を止めない
+    for (int line = 0; line < TRACE_DUMP_LINES_PER_POLL; line++) {
+        if (dump_index == dump_head) {
+            if (dump_core + 1 < NUM_CORES) {
+                begin_core(dump_core + 1);
+                continue;
+            }
+            printf("[TRACE] end\n");
+            clear_buffers();
+            dump_state = DUMP_IDLE;
+            recording = true;
+            return;
+        }
+
+        const trace_record_t *r =
+            &buffers[dump_core].records[dump_index & (TRACE_EVENTS_PER_CORE - 1)];
+        printf("[TR] %lu %08lx %02x %02x %04x\n",
+               dump_core, r->ts_us, r->event, r->flags, r->arg);
+        dump_index++;
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file trace.h
+ * @brief オーディオ経路のタイムライントレース - ヘッダーファイル
+ *
+ * パケット到着 → デコード → エフェクト → リング書き込み → DMA 割り込みの
+ * 「順序」を見るためのフライトレコーダー。コアごとのリングバッファに
+ * タイムスタンプ付きの開始/終了・瞬間・カウンターのイベントを上書きで記録する。
+ *
+ * 書き込みはロックなし: 同じコアのメインループと割り込みの両方から呼ばれるので、
+ * 書き込み位置を LDREX/STREX のアトミック加算で予約してから1レコードを書く。
+ * 割り込み中の記録には IRQ フラグが付き、変換ツールでは別トラックになる。
+ *
+ * アンダーランでトリガーすると、その後 TRACE_POST_TRIGGER_EVENTS 個で記録を止め、
+ * アンダーランに至る前後の流れをダンプまで保持する。
+ * ダンプはシリアル（printf）にテキストで少しずつ出す。
+ *   [TRACE] begin now=<us> cores=<n>
+ *   [TRACE] event <id> <name>             （イベント名の表）
+ *   [TRACE] core <n> events <count> lost <count>
+ *   [TR] <core> <ts_us> <id> <flags> <arg>   （16進、古い順）
+ *   [TRACE] end
+ * ホスト側は tools/trace2json.py で Chrome / Perfetto のトレース JSON に変換する。
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+/**
+ * @brief トレースイベント（名前の表は trace.c、ダンプに含まれる）
+ */
+typedef enum {
+    TRACE_EV_MEDIA_PACKET = 0,   // 瞬間: arg = SBC データのバイト数
+    TRACE_EV_DECODE,             // 開始/終了: メディアパケットの SBC デコード
+    TRACE_EV_EFFECT,             // 開始/終了: arg = フレーム数
+    TRACE_EV_RING_WRITE,         // 開始: arg = フレーム数 / 終了: arg = リングのフィル
+    TRACE_EV_DMA_IRQ,            // 開始/終了: arg = リングのフィル
+    TRACE_EV_UNDERRUN,           // 瞬間: arg = アンダーランの回数
+    TRACE_EV_REPEAT_START,       // 瞬間: Beat-Repeat のリピート開始
+    TRACE_EV_REPEAT_STOP,        // 瞬間: リピート終了（arg = リピートカウンタ）
+    TRACE_EV_PARAM_CHANGE,       // 瞬間: エフェクトパラメータの更新
+    TRACE_EV_RING_FILL,          // カウンター: リングのフィル（DMA 割り込みごと）
+    TRACE_EV_TRANSIENT,          // 瞬間: トランジェント検出（arg = スライスを取り直すチャンク内の位置）
+    TRACE_EV_COUNT,
+} trace_event_t;
+
+// レコードのフラグ（下位2ビットがフェーズ）
+#define TRACE_PHASE_BEGIN    0
+#define TRACE_PHASE_END      1
+#define TRACE_PHASE_INSTANT  2
+#define TRACE_PHASE_COUNTER  3
+#define TRACE_FLAG_IRQ       0x80   // 割り込みハンドラー内で記録した
+
+/**
+ * @brief 1イベントのレコード（8バイト）
+ */
+typedef struct {
+    uint32_t ts_us;     // time_us_32()
+    uint8_t event;      // trace_event_t
+    uint8_t flags;      // フェーズ | TRACE_FLAG_IRQ
+    uint16_t arg;       // 65535 で飽和
+} trace_record_t;
+
+// 記録用マクロ（TRACE_ENABLED = 0 なら何も残らない）
+#if TRACE_ENABLED
+#define TRACE_BEGIN(ev, arg)    trace_record((ev), TRACE_PHASE_BEGIN, (arg))
+#define TRACE_END(ev, arg)      trace_record((ev), TRACE_PHASE_END, (arg))
+#define TRACE_INSTANT(ev, arg)  trace_record((ev), TRACE_PHASE_INSTANT, (arg))
+#define TRACE_COUNTER(ev, arg)  trace_record((ev), TRACE_PHASE_COUNTER, (arg))
+#define TRACE_TRIGGER()         trace_trigger()
+#else
+#define TRACE_BEGIN(ev, arg)    ((void)0)
+#define TRACE_END(ev, arg)      ((void)0)
+#define TRACE_INSTANT(ev, arg)  ((void)0)
+#define TRACE_COUNTER(ev, arg)  ((void)0)
+#define TRACE_TRIGGER()         ((void)0)
+#endif
+
+/**
+ * @brief 初期化（記録のオーバーヘッドを計測してログに出し、記録を開始する）
+ */
+void trace_init(void);
+
+/**
+ * @brief イベントを記録（割り込みからも呼べる）
+ * @param event イベント
+ * @param phase TRACE_PHASE_*
+ * @param arg 引数（65535 で飽和）
+ */
+void trace_record(uint8_t event, uint8_t phase, uint32_t arg);
+
+/**
+ * @brief トリガー（TRACE_POST_TRIGGER_EVENTS 個後に記録を止める、割り込みからも呼べる）
+ *
+ * 止まった記録は次のダンプまで保持される。2回目以降のトリガーは無視する。
+ */
+void trace_trigger(void);
+
+/**
+ * @brief ダンプを開始（記録を止め、trace_poll() で少しずつ出力する）
+ */
+void trace_dump_start(void);
+
+/**
+ * @brief ダンプの出力を進める（メインループから呼ぶ）
+ *
+ * TRACE_AUTO_DUMP なら、トリガーで記録が止まったときに自動でダンプを始める。
+ * ダンプが終わると記録を空にして再開する。
+ */
+void trace_poll(void);
+
+/**
+ * @brief ダンプ中か
+ */
+bool trace_is_dumping(void);
+
+#endif // TRACE_H
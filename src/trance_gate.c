@@ -0,0 +1,250 @@
+/**
+ * @file trance_gate.c
+ * @brief テンポ同期のトランスゲートの実装
+ *
+ * ブロックを「同じ目標ゲインの区間」（ステップの開いている部分 / 閉じている部分）に分け、
+ * 区間の頭で1回だけパターンを引く。区間の境目のフレームは拍位置の増分から
+ * 切り上げで求めるので、ブロックの長さやテンポの端数によらずサンプル単位でそろう。
+ * 区間内は L/R に同じ Q15 ゲインを掛けるだけ（開いた区間は何もしない、無音の区間は 0 で埋める）。
+ */
+
+#include "trance_gate.h"
+#include "beat_clock.h"
+
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+#define GAIN_UNITY  32768
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// 既定のパターン（16ステップ、開き具合 %）
+static const uint8_t default_pattern[16] = {
+    100, 0, 100, 0, 100, 100, 0, 100,
+    100, 0, 100, 0, 100, 100, 0, 60,
+};
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+static bool enabled = false;
+
+static uint8_t pattern[TRANCE_GATE_MAX_STEPS];
+static uint32_t num_steps = 16;
+static float depth = TRANCE_GATE_DEFAULT_DEPTH;
+static uint32_t steps_per_beat = TRANCE_GATE_DEFAULT_RATE;
+static float duty = TRANCE_GATE_DEFAULT_DUTY;
+
+// ステップごとの開いている部分のゲインと閉じている部分のゲイン（Q15、設定時に計算）
+static int32_t step_gain[TRANCE_GATE_MAX_STEPS];
+static int32_t closed_gain = 0;
+static uint32_t duty_q32 = 0;          // ステップ内の閉じる位置（ステップ長に対する 0.32）
+
+// ランプ（レイズドコサイン、0 → 32768 の手前）
+static int16_t ramp_table[TRANCE_GATE_RAMP_FRAMES];
+static int32_t gain_from = GAIN_UNITY;
+static int32_t gain_to = GAIN_UNITY;
+static int32_t gain_now = GAIN_UNITY;
+static uint32_t ramp_pos = TRANCE_GATE_RAMP_FRAMES;   // TRANCE_GATE_RAMP_FRAMES = ランプなし
+
+static uint32_t cost_total_us = 0;
+static uint32_t cost_max_us = 0;
+static uint32_t cost_blocks = 0;
+
+// ============================================================================
+// 内部関数
+// ============================================================================
+
+/**
+ * @brief ステップのゲインを作り直す（パターン・デプス・デューティーの変更時）
+ */
+static void update_gains(void) {
+    closed_gain = (int32_t)lroundf((1.0f - depth) * GAIN_UNITY);
+    for (uint32_t i = 0; i < num_steps; i++) {
+        float open = (float)pattern[i] / 100.0f;
+        step_gain[i] = (int32_t)lroundf((1.0f - depth * (1.0f - open)) * GAIN_UNITY);
+    }
+    duty_q32 = (duty >= 1.0f) ? 0 : (uint32_t)(duty * 4294967296.0f);
+}
+
+/**
+ * @brief 目標ゲインを変える（今のゲインからランプを始める）
+ */
+static inline void set_target(int32_t gain) {
+    if (gain == gain_to) return;
+    gain_from = gain_now;
+    gain_to = gain;
+    ramp_pos = 0;
+}
+
+/**
+ * @brief 区間にゲインを掛ける（ランプが残っていれば先にランプ、残りは一定）
+ */
+static void apply_gain(int16_t *left, int16_t *right, uint32_t frames) {
+    uint32_t i = 0;
+
+    if (ramp_pos < TRANCE_GATE_RAMP_FRAMES) {
+        int32_t delta = gain_to - gain_from;
+        for (; i < frames && ramp_pos < TRANCE_GATE_RAMP_FRAMES; i++, ramp_pos++) {
+            int32_t g = gain_from + ((delta * ramp_table[ramp_pos]) >> 15);
+            left[i] = (int16_t)((left[i] * g) >> 15);
+            right[i] = (int16_t)((right[i] * g) >> 15);
+        }
+        gain_now = (ramp_pos < TRANCE_GATE_RAMP_FRAMES) ?
+            gain_from + ((delta * ramp_table[ramp_pos]) >> 15) : gain_to;
+    }
+    if (i == frames) return;
+
+    int32_t g = gain_to;
+    uint32_t n = frames - i;
+    if (g == GAIN_UNITY) {
+        return;
+    }
+    if (g == 0) {
+        memset(&left[i], 0, n * sizeof(int16_t));
+        memset(&right[i], 0, n * sizeof(int16_t));
+        return;
+    }
+    for (; i < frames; i++) {
+        left[i] = (int16_t)((left[i] * g) >> 15);
+        right[i] = (int16_t)((right[i] * g) >> 15);
+    }
+}
+
+// ============================================================================
+// 初期化・設定
+// ============================================================================
+
+void trance_gate_init(void) {
+    for (uint32_t i = 0; i < TRANCE_GATE_RAMP_FRAMES; i++) {
+        float w = 0.5f - 0.5f * cosf((float)M_PI * (float)i / (float)TRANCE_GATE_RAMP_FRAMES);
+        ramp_table[i] = (int16_t)(w * 32767.0f);
+    }
+
+    enabled = false;
+    gain_from = gain_to = gain_now = GAIN_UNITY;
+    ramp_pos = TRANCE_GATE_RAMP_FRAMES;
+    trance_gate_set_pattern(default_pattern, 16);
+}
+
+void trance_gate_set_enabled(bool en) {
+    enabled = en;
+}
+
+bool trance_gate_get_enabled(void) {
+    return enabled;
+}
+
+void trance_gate_set_pattern(const uint8_t *levels, uint32_t steps) {
+    if (!levels || steps == 0) return;
+    if (steps > TRANCE_GATE_MAX_STEPS) steps = TRANCE_GATE_MAX_STEPS;
+
+    for (uint32_t i = 0; i < steps; i++) {
+        pattern[i] = (levels[i] > 100) ? 100 : levels[i];
+    }
+    num_steps = steps;
+    update_gains();
+}
+
+void trance_gate_set_depth(float d) {
+    if (d < 0.0f) d = 0.0f;
+    if (d > 1.0f) d = 1.0f;
+    depth = d;
+    update_gains();
+}
+
+float trance_gate_get_depth(void) {
+    return depth;
+}
+
+void trance_gate_set_rate(uint32_t rate) {
+    if (rate != 1 && rate != 2 && rate != 4 && rate != 8) return;
+    steps_per_beat = rate;
+}
+
+uint32_t trance_gate_get_rate(void) {
+    return steps_per_beat;
+}
+
+void trance_gate_set_duty(float d) {
+    if (d < 0.05f) d = 0.05f;
+    if (d > 1.0f) d = 1.0f;
+    duty = d;
+    update_gains();
+}
+
+float trance_gate_get_duty(void) {
+    return duty;
+}
+
+// ============================================================================
+// 処理
+// ============================================================================
+
+void trance_gate_process(int16_t *left, int16_t *right, uint32_t num_samples) {
+    // 無効で、開き切っていれば何もしない
+    if (!enabled && gain_to == GAIN_UNITY && ramp_pos >= TRANCE_GATE_RAMP_FRAMES) {
+        return;
+    }
+    if (num_samples == 0) return;
+
+    uint32_t start_us = time_us_32();
+
+    if (!enabled) {
+        set_target(GAIN_UNITY);
+        apply_gain(left, right, num_samples);
+    } else {
+        uint64_t start = beat_clock_get_position_at(0);
+        uint64_t increment = (beat_clock_get_position_at(num_samples) - start) / num_samples;
+        uint64_t step_q32 = ((uint64_t)1 << 32) / steps_per_beat;
+        uint64_t open_q32 = (step_q32 * duty_q32) >> 32;
+
+        uint32_t i = 0;
+        while (i < num_samples) {
+            // 区間の頭でパターンを1回引く
+            uint64_t pos = start + increment * i;
+            uint64_t step = pos / step_q32;
+            uint64_t step_start = step * step_q32;
+            uint64_t seg_end;
+            if (open_q32 == 0 || pos < step_start + open_q32) {
+                set_target(step_gain[step % num_steps]);
+                seg_end = step_start + (open_q32 ? open_q32 : step_q32);
+            } else {
+                set_target(closed_gain);
+                seg_end = step_start + step_q32;
+            }
+
+            // 区間の終わり = 拍位置が seg_end に届く最初のフレーム
+            uint32_t end = num_samples;
+            if (increment > 0) {
+                uint64_t frames = (seg_end - start + increment - 1) / increment;
+                if (frames < end) end = (uint32_t)frames;
+            }
+            apply_gain(&left[i], &right[i], end - i);
+            i = end;
+        }
+    }
+
+    uint32_t elapsed_us = time_us_32() - start_us;
+    cost_total_us += elapsed_us;
+    cost_blocks++;
+    if (elapsed_us > cost_max_us) cost_max_us = elapsed_us;
+}
+
+void trance_gate_get_cycles(uint32_t *avg_cycles, uint32_t *max_cycles) {
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+    if (avg_cycles) {
+        *avg_cycles = cost_blocks ? (uint32_t)((uint64_t)cost_total_us * cycles_per_us / cost_blocks) : 0;
+    }
+    if (max_cycles) *max_cycles = cost_max_us * cycles_per_us;
+}
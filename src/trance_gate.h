@@ -0,0 +1,94 @@
+/**
+ * @file trance_gate.h
+ * @brief テンポ同期のトランスゲート（ステップ音量シェイパー）- ヘッダーファイル
+ *
+ * ビートクロックの拍位置から 1拍を TRANCE_GATE_DEFAULT_RATE 個のステップに分け、
+ * 最大 TRANCE_GATE_MAX_STEPS ステップのパターンでエフェクト後の音量を刻む。
+ * ステップごとに開き具合（0-100 %）を持ち、全体のデプスで掛かり方を決める。
+ * ステップの後ろ（デューティー以降）は閉じる。
+ *
+ * パターンはステップ（とデューティーの位置）ごとに1回だけ評価し、その区間は
+ * 一定のゲインを掛ける。ゲインが変わるところは事前計算したレイズドコサインの
+ * テーブル（TRANCE_GATE_RAMP_FRAMES）でつなぐのでクリックが出ない。
+ */
+
+#ifndef TRANCE_GATE_H
+#define TRANCE_GATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+/**
+ * @brief 初期化（ランプのテーブルと既定のパターン、ゲートは無効）
+ */
+void trance_gate_init(void);
+
+/**
+ * @brief ゲートの有効/無効（切り替えもランプでつなぐ）
+ * @param enabled true = 有効
+ */
+void trance_gate_set_enabled(bool enabled);
+
+/**
+ * @brief ゲートが有効か確認
+ */
+bool trance_gate_get_enabled(void);
+
+/**
+ * @brief パターンを設定
+ * @param levels ステップごとの開き具合（0-100 %、100 = 開く）
+ * @param num_steps ステップ数（1 〜 TRANCE_GATE_MAX_STEPS、パターンはこの長さで繰り返す）
+ */
+void trance_gate_set_pattern(const uint8_t *levels, uint32_t num_steps);
+
+/**
+ * @brief デプスを設定
+ * @param depth 0.0 = 掛からない、1.0 = 閉じたステップは無音
+ */
+void trance_gate_set_depth(float depth);
+
+/**
+ * @brief デプスを取得
+ */
+float trance_gate_get_depth(void);
+
+/**
+ * @brief ステップの長さを設定
+ * @param steps_per_beat 1拍あたりのステップ数（1, 2, 4, 8、4 = 16分音符）
+ */
+void trance_gate_set_rate(uint32_t steps_per_beat);
+
+/**
+ * @brief 1拍あたりのステップ数を取得
+ */
+uint32_t trance_gate_get_rate(void);
+
+/**
+ * @brief デューティーを設定
+ * @param duty ステップのうち開いている割合（0.05 〜 1.0、1.0 なら隣り合う開いたステップはつながる）
+ */
+void trance_gate_set_duty(float duty);
+
+/**
+ * @brief デューティーを取得
+ */
+float trance_gate_get_duty(void);
+
+/**
+ * @brief ブロックにゲートを掛ける（ブロック先頭の拍位置は beat_clock から取る）
+ * @param left 左チャンネル（プレーナー、上書き）
+ * @param right 右チャンネル（プレーナー、上書き）
+ * @param num_samples ステレオペア数
+ */
+void trance_gate_process(int16_t *left, int16_t *right, uint32_t num_samples);
+
+/**
+ * @brief 処理コストを取得（デバッグ用）
+ * @param avg_cycles ブロックあたりの平均サイクル数
+ * @param max_cycles ブロックあたりの最大サイクル数
+ */
+void trance_gate_get_cycles(uint32_t *avg_cycles, uint32_t *max_cycles);
+
+#endif // TRANCE_GATE_H
@@ -0,0 +1,177 @@
+/**
+ * @file transient_detector.c
+ * @brief 速い/遅いエンベロープの比によるトランジェント検出の実装
+ *
+ * サンプルごとの処理は一次のハイパス/ローパス（Q15）と |x| の足し算だけで、
+ * エンベロープの更新としきい値の比較（float）はホップごとに1回。
+ */
+
+#include "transient_detector.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// ============================================================================
+// 定数定義
+// ============================================================================
+
+// ホップ内の |x| の和をフルスケール 1.0 の平均に直す係数
+#define HOP_SCALE  (1.0f / ((float)TRANSIENT_HOP_FRAMES * 32768.0f))
+
+// ============================================================================
+// 内部関数
+// ============================================================================
+
+/**
+ * @brief 時定数をホップあたりの係数に変換
+ */
+static float hop_coeff(float time_ms, uint32_t sample_rate) {
+    float hops = time_ms * 0.001f * (float)sample_rate / (float)TRANSIENT_HOP_FRAMES;
+    return (hops > 0.0f) ? 1.0f - expf(-1.0f / hops) : 1.0f;
+}
+
+/**
+ * @brief ホップ1つ分のエンベロープを進め、検出したか判定
+ *
+ * 比がしきい値を越えたら候補にし、速いエンベロープが上がり切った（か
+ * TRANSIENT_MAX_PEAK_HOPS たった）ところで、最近のピークと比べて強さを判定する。
+ * 越えた瞬間はまだ上がりかけなので、強さはピークで比べないとハイハットと区別できない。
+ */
+static bool end_hop(transient_detector_t *det) {
+    float level = (float)det->hop_sum * HOP_SCALE;
+    det->hop_sum = 0;
+    det->hop_pos = 0;
+
+    // 上がり始めを覚えておく（検出したらここまで遡る）
+    bool rising = level > det->fast_env;
+    if (rising) {
+        if (det->rise_hops < TRANSIENT_MAX_RISE_HOPS) det->rise_hops++;
+    } else {
+        det->rise_hops = 0;
+    }
+    det->fast_env += det->fast_coeff * (level - det->fast_env);
+
+    // 遅いエンベロープは直前のホップまでの値と比べる（トランジェント自身で下駄を履かせない）
+    bool over = det->fast_env > det->floor && det->fast_env > det->threshold * det->slow_env;
+    det->slow_env += det->slow_coeff * (level - det->slow_env);
+
+    if (det->hold_hops > 0) det->hold_hops--;
+    if (!det->candidate && over && !det->above && det->hold_hops == 0) {
+        det->candidate = true;
+        det->onset_hops = det->rise_hops;
+        det->peak_hops = 0;
+    } else if (det->candidate) {
+        det->onset_hops++;
+        det->peak_hops++;
+    }
+    det->above = over;
+
+    // 候補がピークに達したら強さを判定（ピークより TRANSIENT_STRENGTH_DB 以上小さいもの
+    // = ゴーストノートやハイハットは数えない）
+    bool detected = false;
+    det->peak_env *= det->peak_decay;
+    if (det->candidate && (!rising || det->peak_hops >= TRANSIENT_MAX_PEAK_HOPS)) {
+        det->candidate = false;
+        if (det->fast_env >= det->strength * det->peak_env) {
+            detected = true;
+            det->hold_hops = det->refractory_hops;
+            det->detections++;
+        }
+    }
+    if (det->fast_env > det->peak_env) det->peak_env = det->fast_env;
+
+    return detected;
+}
+
+// ============================================================================
+// 初期化・設定
+// ============================================================================
+
+void transient_detector_init(transient_detector_t *det, float threshold, float refractory_ms,
+                             uint32_t sample_rate) {
+    det->fast_coeff = hop_coeff(TRANSIENT_FAST_MS, sample_rate);
+    det->slow_coeff = hop_coeff(TRANSIENT_SLOW_MS, sample_rate);
+    det->hp_coeff = (int32_t)(expf(-2.0f * (float)M_PI * TRANSIENT_HIGHPASS_HZ / (float)sample_rate) *
+                              32768.0f);
+    det->lp_coeff = (int32_t)((1.0f - expf(-2.0f * (float)M_PI * TRANSIENT_LOWPASS_HZ /
+                                           (float)sample_rate)) * 32768.0f);
+    det->peak_decay = 1.0f - hop_coeff(TRANSIENT_PEAK_RELEASE_MS, sample_rate);
+    det->floor = powf(10.0f, TRANSIENT_FLOOR_DB / 20.0f);
+    det->strength = powf(10.0f, TRANSIENT_STRENGTH_DB / 20.0f);
+    det->detections = 0;
+    transient_detector_configure(det, threshold, refractory_ms, sample_rate);
+    transient_detector_reset(det);
+}
+
+void transient_detector_configure(transient_detector_t *det, float threshold, float refractory_ms,
+                                  uint32_t sample_rate) {
+    det->threshold = threshold;
+    det->refractory_hops = (uint32_t)(refractory_ms * 0.001f * (float)sample_rate /
+                                      (float)TRANSIENT_HOP_FRAMES + 0.5f);
+}
+
+void transient_detector_reset(transient_detector_t *det) {
+    det->fast_env = 0.0f;
+    det->slow_env = 0.0f;
+    det->peak_env = 0.0f;
+    det->hold_hops = 0;
+    det->rise_hops = 0;
+    det->above = false;
+    det->candidate = false;
+    det->hop_pos = 0;
+    det->hop_sum = 0;
+    det->hp_state = 0;
+    det->lp_state = 0;
+    det->hp_prev = 0;
+}
+
+// ============================================================================
+// 処理
+// ============================================================================
+
+bool transient_detector_process(transient_detector_t *det, const int16_t *left,
+                                const int16_t *right, uint32_t num_samples, int32_t *onset) {
+    bool found = false;
+    uint32_t i = 0;
+
+    while (i < num_samples) {
+        // ホップの終わりかブロックの終わりまで足す
+        uint32_t n = TRANSIENT_HOP_FRAMES - det->hop_pos;
+        if (n > num_samples - i) n = num_samples - i;
+
+        // (L + R) / 2 を一次のハイパスとローパスに通して |x| を足す
+        uint32_t sum = det->hop_sum;
+        int32_t hp = det->hp_state;
+        int32_t lp = det->lp_state;
+        int32_t prev = det->hp_prev;
+        for (uint32_t k = 0; k < n; k++) {
+            int32_t x = ((int32_t)left[i + k] + (int32_t)right[i + k]) >> 1;
+            hp = (det->hp_coeff * (hp + x - prev)) >> 15;
+            lp += (det->lp_coeff * (hp - lp)) >> 15;
+            prev = x;
+            sum += (uint32_t)abs(lp);
+        }
+        det->hop_sum = sum;
+        det->hp_state = hp;
+        det->lp_state = lp;
+        det->hp_prev = prev;
+        det->hop_pos += n;
+        i += n;
+
+        if (det->hop_pos < TRANSIENT_HOP_FRAMES) break;
+
+        // 位置 = 速いエンベロープが上がり始めたホップの頭
+        if (end_hop(det) && !found) {
+            found = true;
+            if (onset) {
+                *onset = (int32_t)i - (int32_t)(det->onset_hops * TRANSIENT_HOP_FRAMES);
+            }
+        }
+    }
+
+    return found;
+}
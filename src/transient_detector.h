@@ -0,0 +1,108 @@
+/**
+ * @file transient_detector.h
+ * @brief 速い/遅いエンベロープの比によるトランジェント検出 - ヘッダーファイル
+ *
+ * (L+R)/2 を一次のハイパス（TRANSIENT_HIGHPASS_HZ）とローパス（TRANSIENT_LOWPASS_HZ）に通し、
+ * サンプルごとにはその |x| を足すだけ。TRANSIENT_HOP_FRAMES フレーム（ホップ）ごとに
+ * 平均を速いエンベロープと遅いエンベロープで追い、速い方が遅い方（直前のホップまで）の
+ * しきい値倍を下から上へ越えたら候補にする。速い方が上がり切ったところで最近のピークと比べ、
+ * TRANSIENT_STRENGTH_DB より小さくなければ検出とし、不応期の間は次を検出しない。
+ *
+ * トランジェントの位置は速いエンベロープが上がり始めたホップの頭とする
+ * （判定はしきい値を越えてピークを待つまで数ホップ遅れる）。
+ * 位置はブロック先頭からのフレーム数で返し、前のブロックにかかるときは負になる。
+ *
+ * 1つの構造体が1インスタンス。
+ */
+
+#ifndef TRANSIENT_DETECTOR_H
+#define TRANSIENT_DETECTOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+// 速いエンベロープの上がり始めとして遡る最大のホップ数
+#define TRANSIENT_MAX_RISE_HOPS  4
+
+// しきい値を越えてからピークを待つ最大のホップ数
+#define TRANSIENT_MAX_PEAK_HOPS  6
+
+// 返す位置が検出したホップの終わりから遡る最大フレーム数
+#define TRANSIENT_MAX_LOOKBACK_FRAMES \
+    ((TRANSIENT_MAX_RISE_HOPS + TRANSIENT_MAX_PEAK_HOPS) * TRANSIENT_HOP_FRAMES)
+
+/**
+ * @brief トランジェント検出の状態
+ */
+typedef struct {
+    float fast_coeff;           // ホップあたりの係数 1 - exp(-hop/(t*fs))
+    float slow_coeff;
+    float fast_env;             // 平均 |x|（フルスケール = 1.0）
+    float slow_env;
+    float peak_env;             // 速いエンベロープのピーク（TRANSIENT_PEAK_RELEASE_MS で下がる）
+    float peak_decay;           // ホップあたりのピークの減衰
+    float threshold;            // 速い/遅い の比
+    float floor;                // これより小さい速いエンベロープでは検出しない
+    float strength;             // ピークに対してこれより小さいものは検出しない
+    uint32_t refractory_hops;   // 不応期（ホップ数）
+    uint32_t hold_hops;         // 残りの不応期
+    uint32_t rise_hops;         // 速いエンベロープが上がり続けているホップ数
+    bool above;                 // しきい値を越えている（下がるまで次の候補にしない）
+    bool candidate;             // しきい値を越え、ピークを待っている
+    uint32_t onset_hops;        // 候補の上がり始めから今までのホップ数
+    uint32_t peak_hops;         // しきい値を越えてからのホップ数
+    uint32_t hop_pos;           // ホップ内の位置（ブロックをまたいで続く）
+    uint32_t hop_sum;           // ホップ内の |x| の和
+    int32_t hp_coeff;           // ハイパスの係数（Q15）
+    int32_t lp_coeff;           // ローパスの係数（Q15）
+    int32_t hp_state;           // ハイパスの出力
+    int32_t lp_state;           // ローパスの出力
+    int32_t hp_prev;            // ハイパスの直前の入力
+    uint32_t detections;        // 検出回数
+} transient_detector_t;
+
+/**
+ * @brief 初期化
+ * @param det 検出器の状態
+ * @param threshold 速い/遅い の比（1.0 より大きいこと）
+ * @param refractory_ms 不応期（ms）
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void transient_detector_init(transient_detector_t *det, float threshold, float refractory_ms,
+                             uint32_t sample_rate);
+
+/**
+ * @brief しきい値と不応期を変える（エンベロープはそのまま）
+ * @param det 検出器の状態
+ * @param threshold 速い/遅い の比（1.0 より大きいこと）
+ * @param refractory_ms 不応期（ms）
+ * @param sample_rate サンプリングレート（Hz）
+ */
+void transient_detector_configure(transient_detector_t *det, float threshold, float refractory_ms,
+                                  uint32_t sample_rate);
+
+/**
+ * @brief エンベロープと不応期を消す（エンベロープは無音から追い直す）
+ * @param det 検出器の状態
+ */
+void transient_detector_reset(transient_detector_t *det);
+
+/**
+ * @brief ブロックを解析する（入力は変えない）
+ *
+ * 不応期がブロックより長ければ検出はブロックに高々1回。2回以上あったときは最初のものを返す。
+ * 返す位置は検出したホップの終わりから最大 TRANSIENT_MAX_LOOKBACK_FRAMES 前まで。
+ *
+ * @param det 検出器の状態
+ * @param left 左チャンネル（プレーナー）
+ * @param right 右チャンネル（プレーナー）
+ * @param num_samples ステレオペア数
+ * @param onset トランジェントの位置の格納先（ブロック先頭からのフレーム数、負 = 前のブロック）
+ * @return true このブロックで検出した
+ */
+bool transient_detector_process(transient_detector_t *det, const int16_t *left,
+                                const int16_t *right, uint32_t num_samples, int32_t *onset);
+
+#endif // TRANSIENT_DETECTOR_H
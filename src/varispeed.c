@@ -0,0 +1,345 @@
+/**
+ * @file varispeed.c
+ * @brief ストリーム全体のバリスピードの実装
+ *
+ * 履歴バッファは線形で、先頭に前回の残り（VARISPEED_TAPS - 1 フレーム以下）、
+ * その後ろに今回の入力を置く。読み位置は履歴先頭からの 32.32 固定小数点で、
+ * 整数部がフィルタの中心（左に VARISPEED_TAPS/2 - 1、右に VARISPEED_TAPS/2 フレームを使う）。
+ * 右側のタップがそろうまで出力しないので、遅延は VARISPEED_TAPS/2 フレーム。
+ */
+
+#include "varispeed.h"
+#include "audio_out_i2s.h"
+#include "beat_clock.h"
+#include "latency.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+
+// ============================================================================
+// 定数
+// ============================================================================
+
+#define HALF_TAPS        (VARISPEED_TAPS / 2)
+#define NUM_PHASES       (1u << VARISPEED_PHASE_BITS)
+#define HIST_FRAMES      (PCM_BATCH_MAX_FRAMES + VARISPEED_TAPS)
+#define Q32_ONE          ((int64_t)1 << 32)
+
+// 原速に戻ったとみなす速度の差（これ以下になったら 1.0 にそろえてコピーに戻る）
+#define SNAP_EPSILON     0.0001f
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#if VARISPEED_TAPS % 2 != 0
+#error "VARISPEED_TAPS must be even"
+#endif
+
+// ============================================================================
+// 内部変数
+// ============================================================================
+
+// 位相 p の係数（Q15、位相ごとの和は 32768）。p = NUM_PHASES は次のフレームへの1つずれ
+static int16_t coeffs[NUM_PHASES + 1][VARISPEED_TAPS];
+
+static int16_t hist_l[HIST_FRAMES];
+static int16_t hist_r[HIST_FRAMES];
+static uint32_t hist_frames = 0;
+static uint64_t read_pos = 0;          // 履歴先頭からの読み位置（32.32）
+
+static uint32_t sample_rate = AUDIO_SAMPLE_RATE;
+static float requested_speed = 1.0f;
+static float current_speed = 1.0f;
+static float speed_limit = 1.0f;
+static float clock_speed = 1.0f;       // ビートクロックに渡した速度
+static bool depth_held = false;        // 出力リングの寄せ込みを止めているか
+static uint32_t capped_blocks = 0;
+
+static uint32_t cost_total_us = 0;
+static uint32_t cost_max_us = 0;
+static uint32_t cost_blocks = 0;
+
+// ============================================================================
+// 係数表
+// ============================================================================
+
+/**
+ * @brief 第1種0次の変形ベッセル関数（Kaiser 窓用、べき級数）
+ */
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+/**
+ * @brief ポリフェーズの係数表を作る（位相ごとに DC ゲインを 1 にそろえて量子化）
+ */
+static void build_coeffs(void) {
+    double i0_beta = bessel_i0(VARISPEED_KAISER_BETA);
+
+    for (uint32_t p = 0; p <= NUM_PHASES; p++) {
+        double phase = (double)p / NUM_PHASES;
+        double h[VARISPEED_TAPS];
+        double sum = 0.0;
+
+        for (int j = 0; j < VARISPEED_TAPS; j++) {
+            // タップ j の入力は中心から (j - (HALF_TAPS - 1)) フレーム、出力は中心から phase
+            double t = (double)(j - (HALF_TAPS - 1)) - phase;
+            double x = M_PI * VARISPEED_CUTOFF * t;
+            double sinc = (fabs(t) < 1e-9) ? 1.0 : sin(x) / x;
+            double r = t / HALF_TAPS;
+            double w = (fabs(r) < 1.0) ? bessel_i0(VARISPEED_KAISER_BETA * sqrt(1.0 - r * r)) / i0_beta : 0.0;
+            h[j] = sinc * w;
+            sum += h[j];
+        }
+
+        // 丸めの誤差は中心のタップに寄せて、和をちょうど 32768 にする
+        int32_t qsum = 0;
+        for (int j = 0; j < VARISPEED_TAPS; j++) {
+            coeffs[p][j] = (int16_t)lround(h[j] / sum * 32768.0);
+            qsum += coeffs[p][j];
+        }
+        int center = HALF_TAPS - 1 + (int)(p * 2 >= NUM_PHASES);
+        coeffs[p][center] = (int16_t)(coeffs[p][center] + (32768 - qsum));
+    }
+}
+
+// ============================================================================
+// 速度の制御
+// ============================================================================
+
+static inline uint32_t ms_to_frames(uint32_t ms) {
+    return (uint32_t)((uint64_t)ms * sample_rate / 1000);
+}
+
+/**
+ * @brief リングの余裕から速度の範囲を求める
+ *
+ * 速度 s でのリングの伸び（1秒あたり）は fs × (1/s - 1)。
+ * これが 余裕 / τ 以下になるように s を抑えると、余裕は時定数 τ で指数的に減り、0 には届かない。
+ */
+static void get_speed_range(float *min_speed, float *max_speed) {
+    float tau_frames = (float)sample_rate * VARISPEED_HEADROOM_TAU_MS / 1000.0f;
+
+    // 遅くする側: 空きのうち VARISPEED_HIGH_MARGIN_MS を残す
+    int32_t space = (int32_t)audio_out_i2s_get_free_space() - (int32_t)ms_to_frames(VARISPEED_HIGH_MARGIN_MS);
+    float grow = (space > 0) ? (float)space / tau_frames : 0.0f;
+    *min_speed = 1.0f / (1.0f + grow);
+
+    // 速くする側: フィルが VARISPEED_LOW_FLOOR_MS を割らない
+    int32_t excess = (int32_t)audio_out_i2s_get_buffered_samples() - (int32_t)ms_to_frames(VARISPEED_LOW_FLOOR_MS);
+    float drain = (excess > 0) ? (float)excess / tau_frames : 0.0f;
+    *max_speed = (drain < 0.5f) ? 1.0f / (1.0f - drain) : 2.0f;
+}
+
+/**
+ * @brief このブロックの終わりの速度（目標へ一次遅れで寄せ、リングの範囲に収める）
+ */
+static float next_speed(uint32_t num_frames) {
+    float min_speed, max_speed;
+    get_speed_range(&min_speed, &max_speed);
+
+    float target = requested_speed;
+    speed_limit = (target < 1.0f) ? min_speed : (target > 1.0f) ? max_speed : 1.0f;
+    if (target < min_speed || target > max_speed) {
+        target = (target < min_speed) ? min_speed : max_speed;
+        capped_blocks++;
+    }
+
+    float alpha = 1.0f - expf(-(float)num_frames * 1000.0f / ((float)sample_rate * VARISPEED_SMOOTHING_MS));
+    float speed = current_speed + (target - current_speed) * alpha;
+
+    // 逆向きに残っている速度も含めて、範囲は一次遅れの後にも守る
+    if (speed < min_speed) speed = min_speed;
+    if (speed > max_speed) speed = max_speed;
+
+    if (requested_speed == 1.0f && fabsf(speed - 1.0f) < SNAP_EPSILON) {
+        speed = 1.0f;
+    }
+    return speed;
+}
+
+// ============================================================================
+// リサンプリング
+// ============================================================================
+
+/**
+ * @brief 読み位置の1フレームを補間する（位相間は係数を線形補間）
+ */
+static inline void interpolate_frame(uint64_t pos, int16_t *out_l, int16_t *out_r) {
+    uint32_t center = (uint32_t)(pos >> 32);
+    uint32_t frac = (uint32_t)pos;
+    uint32_t phase = frac >> (32 - VARISPEED_PHASE_BITS);
+    int32_t t = (int32_t)((frac >> (32 - VARISPEED_PHASE_BITS - 15)) & 0x7FFF);
+
+    const int16_t *c0 = coeffs[phase];
+    const int16_t *c1 = coeffs[phase + 1];
+    const int16_t *xl = &hist_l[center - (HALF_TAPS - 1)];
+    const int16_t *xr = &hist_r[center - (HALF_TAPS - 1)];
+
+    // 係数の絶対値の和は 1.3 × 32768 未満なので 32ビットに収まる
+    int32_t acc_l = 1 << 14;
+    int32_t acc_r = 1 << 14;
+    for (int j = 0; j < VARISPEED_TAPS; j++) {
+        int32_t c = c0[j] + (((c1[j] - c0[j]) * t) >> 15);
+        acc_l += c * xl[j];
+        acc_r += c * xr[j];
+    }
+    acc_l >>= 15;
+    acc_r >>= 15;
+
+    if (acc_l > 32767) acc_l = 32767;
+    if (acc_l < -32768) acc_l = -32768;
+    if (acc_r > 32767) acc_r = 32767;
+    if (acc_r < -32768) acc_r = -32768;
+    *out_l = (int16_t)acc_l;
+    *out_r = (int16_t)acc_r;
+}
+
+// ============================================================================
+// 公開関数
+// ============================================================================
+
+bool varispeed_init(uint32_t sr) {
+    sample_rate = sr;
+    build_coeffs();
+    varispeed_reset();
+
+    latency_declare(LATENCY_NODE_VARISPEED, HALF_TAPS);
+
+    printf("[VARISPEED] %d taps x %u phases, cutoff %.2f, range +/-%d.%d%%\n",
+           VARISPEED_TAPS, NUM_PHASES, (double)VARISPEED_CUTOFF,
+           VARISPEED_RANGE_PERMILLE / 10, VARISPEED_RANGE_PERMILLE % 10);
+    return true;
+}
+
+void varispeed_set_speed(float speed) {
+    float range = VARISPEED_RANGE_PERMILLE / 1000.0f;
+    if (speed < 1.0f - range) speed = 1.0f - range;
+    if (speed > 1.0f + range) speed = 1.0f + range;
+    requested_speed = speed;
+}
+
+float varispeed_get_speed(void) {
+    return requested_speed;
+}
+
+float varispeed_get_current_speed(void) {
+    return current_speed;
+}
+
+uint32_t varispeed_process(const int16_t *in_l, const int16_t *in_r, uint32_t num_frames,
+                           int16_t *out_l, int16_t *out_r) {
+    uint32_t start_us = time_us_32();
+
+    if (num_frames > HIST_FRAMES - hist_frames) {
+        num_frames = HIST_FRAMES - hist_frames;
+    }
+    memcpy(&hist_l[hist_frames], in_l, num_frames * sizeof(int16_t));
+    memcpy(&hist_r[hist_frames], in_r, num_frames * sizeof(int16_t));
+    hist_frames += num_frames;
+
+    float begin = current_speed;
+    float end = next_speed(num_frames);
+    if (begin == 1.0f && end == 1.0f && (uint32_t)read_pos != 0) {
+        // 原速に戻ったら端数の位相を捨てる（1フレーム未満の時間のずれ）
+        read_pos = (read_pos + (Q32_ONE >> 1)) & ~(uint64_t)0xFFFFFFFFu;
+    }
+
+    uint32_t max_out = VARISPEED_MAX_OUTPUT(num_frames);
+    uint32_t end_center = hist_frames - HALF_TAPS;   // 中心がここに来たら右のタップが足りない
+    uint32_t out = 0;
+
+    if (begin == 1.0f && end == 1.0f) {
+        // 原速: 遅延を合わせたコピー
+        uint32_t center = (uint32_t)(read_pos >> 32);
+        out = (end_center > center) ? end_center - center : 0;
+        if (out > max_out) out = max_out;
+        memcpy(out_l, &hist_l[center], out * sizeof(int16_t));
+        memcpy(out_r, &hist_r[center], out * sizeof(int16_t));
+        read_pos += (uint64_t)out << 32;
+    } else {
+        // 速度はブロック内で begin から end へ線形にランプする（出力フレーム数で割り振る）
+        int64_t step = (int64_t)((double)begin * (double)Q32_ONE);
+        int64_t step_end = (int64_t)((double)end * (double)Q32_ONE);
+        uint32_t expected = (uint32_t)((float)num_frames * 2.0f / (begin + end)) + 1;
+        int64_t step_delta = (step_end - step) / (int64_t)expected;
+
+        while ((uint32_t)(read_pos >> 32) < end_center && out < max_out) {
+            interpolate_frame(read_pos, &out_l[out], &out_r[out]);
+            out++;
+            read_pos += (uint64_t)step;
+            step += step_delta;
+            if ((step_delta > 0 && step > step_end) || (step_delta < 0 && step < step_end)) {
+                step = step_end;
+            }
+        }
+    }
+    current_speed = end;
+
+    // 原速を外れている間は出力リングの目標深さへの寄せ込みを止める
+    // （速度で伸び縮みさせたフィルを、寄せ込みが 1/I2S_DEPTH_SLIP_SPACING ずつ打ち消さない）
+    bool hold = (begin != 1.0f || end != 1.0f);
+    if (hold != depth_held) {
+        audio_out_i2s_hold_depth(hold);
+        depth_held = hold;
+    }
+
+    // 使い終わった履歴を詰める（次の中心の左側のタップから残す）
+    uint32_t drop = (uint32_t)(read_pos >> 32) - (HALF_TAPS - 1);
+    if (drop > hist_frames) drop = hist_frames;
+    hist_frames -= drop;
+    memmove(hist_l, &hist_l[drop], hist_frames * sizeof(int16_t));
+    memmove(hist_r, &hist_r[drop], hist_frames * sizeof(int16_t));
+    read_pos -= (uint64_t)drop << 32;
+
+    // 拍位置は出力のフレームで数えるので、テンポに速度を掛ける
+    float speed = 0.5f * (begin + end);
+    if (speed != clock_speed) {
+        beat_clock_set_speed(speed);
+        clock_speed = speed;
+    }
+
+    uint32_t elapsed_us = time_us_32() - start_us;
+    cost_total_us += elapsed_us;
+    cost_blocks++;
+    if (elapsed_us > cost_max_us) cost_max_us = elapsed_us;
+
+    return out;
+}
+
+void varispeed_reset(void) {
+    // 中心の左側のタップ分を無音で埋めておく
+    memset(hist_l, 0, sizeof(hist_l));
+    memset(hist_r, 0, sizeof(hist_r));
+    hist_frames = HALF_TAPS - 1;
+    read_pos = (uint64_t)(HALF_TAPS - 1) << 32;
+    current_speed = 1.0f;
+    speed_limit = 1.0f;
+    clock_speed = 1.0f;
+    beat_clock_set_speed(1.0f);
+    depth_held = false;
+    audio_out_i2s_hold_depth(false);
+}
+
+void varispeed_get_stats(varispeed_stats_t *stats) {
+    uint32_t cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+
+    stats->requested = requested_speed;
+    stats->current = current_speed;
+    stats->limit = speed_limit;
+    stats->capped_blocks = capped_blocks;
+    stats->avg_cycles = cost_blocks ? (uint32_t)((uint64_t)cost_total_us * cycles_per_us / cost_blocks) : 0;
+    stats->max_cycles = cost_max_us * cycles_per_us;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file varispeed.h
+ * @brief ストリーム全体のバリスピード（ピッチ/テンポフェーダー）- ヘッダーファイル
+ *
+ * デコード直後のバッチを Kaiser 窓付き sinc のポリフェーズ FIR でリサンプリングする
+ * （VARISPEED_TAPS タップ × VARISPEED_PHASES 位相、位相間は係数を線形補間）。
+ * 速度 s は「出力1フレームあたりに進む入力フレーム数」で、s > 1 でテンポもピッチも上がる。
+ * 速度はブロックごとに一次遅れで目標へ寄せ、ブロック内では線形にランプするので段差は出ない。
+ *
+ * 出力リングとの協調: 速度を下げると出力が入力より多くなりリングが伸び、
+ * 上げるとリングを食う。ずれの上限をリングの余裕（空き、またはフィルの床より上）から
+ * 決め、余裕が VARISPEED_HEADROOM_TAU_MS で指数的に減るようにする。
+ * 余裕がなくなる前に速度は原速へ戻っていくので、オーバーラン / アンダーランは起きない
+ * （長く掛け続けたときは要求どおりの速度にならず、capped として数える）。
+ * 原速を外れている間は出力リングの目標深さへの寄せ込みを止め（audio_out_i2s_hold_depth()）、
+ * 原速に戻ってから寄せ込みでフィルを目標深さへ戻す。
+ *
+ * ビートクロックには現在の速度を渡し、拍位置は出力の時間で数える。
+ */
+
+#ifndef VARISPEED_H
+#define VARISPEED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+// 入力 num_frames フレームから出る最大の出力フレーム数（出力バッファの大きさ）
+#define VARISPEED_MAX_OUTPUT(num_frames) \
+    ((num_frames) * 1000 / (1000 - VARISPEED_RANGE_PERMILLE) + 2)
+
+/**
+ * @brief バリスピードの統計
+ */
+typedef struct {
+    float requested;         // 要求された速度
+    float current;           // 現在の速度（ブロック末尾）
+    float limit;             // リングの余裕から決まる速度の限界（要求の向き）
+    uint32_t capped_blocks;  // 要求を限界で抑えたブロック数
+    uint32_t avg_cycles;     // ブロックあたりの平均サイクル数
+    uint32_t max_cycles;     // ブロックあたりの最大サイクル数
+} varispeed_stats_t;
+
+/**
+ * @brief 初期化（係数表を作り、遅延を申告する）
+ * @param sample_rate サンプリングレート（Hz）
+ * @return true 成功
+ */
+bool varispeed_init(uint32_t sample_rate);
+
+/**
+ * @brief 目標の速度を設定（1 ± VARISPEED_RANGE_PERMILLE/1000 にクランプ）
+ * @param speed 速度（1.0 = 原速）
+ */
+void varispeed_set_speed(float speed);
+
+/**
+ * @brief 要求されている速度を取得
+ */
+float varispeed_get_speed(void);
+
+/**
+ * @brief 現在の速度を取得（スムージングと限界の後）
+ */
+float varispeed_get_current_speed(void);
+
+/**
+ * @brief バッチをリサンプリングする
+ *
+ * 原速で落ち着いているときは遅延を合わせたコピーだけになる。
+ *
+ * @param in_l 入力の左チャンネル（プレーナー）
+ * @param in_r 入力の右チャンネル（プレーナー）
+ * @param num_frames 入力のステレオペア数（PCM_BATCH_MAX_FRAMES 以下）
+ * @param out_l 出力の左チャンネル（VARISPEED_MAX_OUTPUT(num_frames) 以上）
+ * @param out_r 出力の右チャンネル
+ * @return 出力したステレオペア数
+ */
+uint32_t varispeed_process(const int16_t *in_l, const int16_t *in_r, uint32_t num_frames,
+                           int16_t *out_l, int16_t *out_r);
+
+/**
+ * @brief 履歴を消して原速に戻す（切断時、要求された速度は保つ）
+ */
+void varispeed_reset(void);
+
+/**
+ * @brief 統計を取得
+ */
+void varispeed_get_stats(varispeed_stats_t *stats);
+
+#endif // VARISPEED_H
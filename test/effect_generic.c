@@ -0,0 +1,27 @@
+/**
+ * @file effect_generic.c
+ * @brief 汎用パス（EFFECT_SPECIALISED_KERNELS = 0）の audio_effect.c
+ *
+ * test_effect_kernels で特殊化カーネルの出力と比べるため、公開関数の名前を
+ * generic_ に付け替えて同じプログラムにもう1つ取り込む。
+ */
+
+#include "config.h"
+#undef EFFECT_SPECIALISED_KERNELS
+#define EFFECT_SPECIALISED_KERNELS 0
+
+#define audio_effect_init                 generic_effect_init
+#define audio_effect_set_params           generic_effect_set_params
+#define audio_effect_update_params        generic_effect_update_params
+#define audio_effect_get_params           generic_effect_get_params
+#define audio_effect_process              generic_effect_process
+#define audio_effect_reset                generic_effect_reset
+#define audio_effect_get_transient_stats  generic_effect_get_transient_stats
+#define audio_effect_get_multiband_cycles generic_effect_get_multiband_cycles
+#define audio_effect_get_slice_clamps     generic_effect_get_slice_clamps
+#define audio_effect_get_slice_memory_bytes generic_effect_get_slice_memory_bytes
+#define audio_effect_lend_slice_memory    generic_effect_lend_slice_memory
+#define audio_effect_return_slice_memory  generic_effect_return_slice_memory
+#define audio_effect_is_slice_memory_lent generic_effect_is_slice_memory_lent
+
+#include "../src/audio_effect.c"
@@ -0,0 +1,113 @@
+/**
+ * @file btstack.h
+ * @brief ホストテスト用の BTstack 代替
+ *
+ * bt_audio.c をホストでビルドするための最小限の型と関数（何もしない）。
+ * テストは SBC デコーダーのコールバック（handle_pcm_data）から先だけを動かす。
+ */
+
+#ifndef HOST_BTSTACK_H
+#define HOST_BTSTACK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UNUSED(x) (void)(x)
+
+typedef uint8_t bd_addr_t[6];
+typedef uint16_t hci_con_handle_t;
+typedef void (*btstack_packet_handler_t)(uint8_t packet_type, uint16_t channel, uint8_t *packet, uint16_t size);
+
+typedef struct {
+    void *item;
+    btstack_packet_handler_t callback;
+} btstack_packet_callback_registration_t;
+
+typedef struct avdtp_stream_endpoint { uint8_t seid; } avdtp_stream_endpoint_t;
+
+enum {
+    ERROR_CODE_SUCCESS = 0,
+    HCI_POWER_ON = 1,
+    HCI_EVENT_PACKET = 4,
+    HCI_EVENT_PIN_CODE_REQUEST = 0x16,
+    HCI_EVENT_QOS_VIOLATION = 0x1E,
+    HCI_EVENT_FLUSH_OCCURRED = 0x11,
+    HCI_EVENT_DATA_BUFFER_OVERFLOW = 0x1A,
+    GAP_EVENT_RSSI_MEASUREMENT = 0xD5,
+    HCI_EVENT_AVDTP_META = 0xED,
+    HCI_EVENT_A2DP_META = 0xEE,
+};
+
+enum {
+    A2DP_SUBEVENT_SIGNALING_CONNECTION_ESTABLISHED = 1,
+    A2DP_SUBEVENT_SIGNALING_CONNECTION_RELEASED,
+    A2DP_SUBEVENT_STREAM_ESTABLISHED,
+    A2DP_SUBEVENT_STREAM_STARTED,
+    A2DP_SUBEVENT_STREAM_SUSPENDED,
+    A2DP_SUBEVENT_STREAM_RELEASED,
+    A2DP_SUBEVENT_SIGNALING_MEDIA_CODEC_SBC_CONFIGURATION,
+    AVDTP_SUBEVENT_STREAMING_CAN_SEND_MEDIA_PACKET_NOW,
+};
+
+enum {
+    AVDTP_AUDIO = 0,
+    AVDTP_CODEC_SBC = 0,
+    AVDTP_SBC_44100 = 2,
+    AVDTP_SBC_STEREO = 1,
+    AVDTP_SINK_FEATURE_MASK_SPEAKER = 1,
+    AVDTP_SINK_FEATURE_MASK_AMPLIFIER = 2,
+};
+
+#define HCI_CON_HANDLE_INVALID          0xffff
+#define SDP_AVDTP_SINK_BUFFER_SIZE      150
+#define SBC_MEDIA_PACKET_HEADER_OFFSET  13
+
+static inline void l2cap_init(void) {}
+static inline void sdp_init(void) {}
+static inline void sdp_register_service(const uint8_t *record) { (void)record; }
+static inline void a2dp_sink_init(void) {}
+static inline void a2dp_sink_register_packet_handler(btstack_packet_handler_t h) { (void)h; }
+static inline void a2dp_sink_register_media_handler(void (*h)(uint8_t, uint8_t *, uint16_t)) { (void)h; }
+static inline void a2dp_sink_create_sdp_record(uint8_t *buf, uint32_t handle, uint16_t features,
+                                               const char *name, const char *provider) {
+    (void)buf; (void)handle; (void)features; (void)name; (void)provider;
+}
+static inline avdtp_stream_endpoint_t *a2dp_sink_create_stream_endpoint(int type, int codec,
+                                                                         uint8_t *caps, uint16_t caps_len,
+                                                                         uint8_t *conf, uint16_t conf_len) {
+    (void)type; (void)codec; (void)caps; (void)caps_len; (void)conf; (void)conf_len;
+    static avdtp_stream_endpoint_t endpoint;
+    return &endpoint;
+}
+static inline uint8_t avdtp_local_seid(avdtp_stream_endpoint_t *ep) { (void)ep; return 1; }
+static inline void avdtp_sink_register_delay_reporting_category(uint8_t seid) { (void)seid; }
+static inline uint8_t a2dp_sink_send_delay_report(uint16_t cid, uint8_t seid, uint16_t delay_100us) {
+    (void)cid; (void)seid; (void)delay_100us;
+    return ERROR_CODE_SUCCESS;
+}
+
+static inline void gap_discoverable_control(int enable) { (void)enable; }
+static inline void gap_set_class_of_device(uint32_t cod) { (void)cod; }
+static inline void gap_set_local_name(const char *name) { (void)name; }
+static inline int gap_read_rssi(hci_con_handle_t h) { (void)h; return 0; }
+static inline void gap_pin_code_response(const bd_addr_t addr, const char *pin) { (void)addr; (void)pin; }
+static inline void hci_add_event_handler(btstack_packet_callback_registration_t *r) { (void)r; }
+static inline void hci_power_control(int mode) { (void)mode; }
+
+static inline uint8_t hci_event_packet_get_type(const uint8_t *p) { return p[0]; }
+static inline uint8_t hci_event_a2dp_meta_get_subevent_code(const uint8_t *p) { return p[2]; }
+static inline void hci_event_pin_code_request_get_bd_addr(const uint8_t *p, bd_addr_t a) { (void)p; (void)a; }
+static inline int8_t gap_event_rssi_measurement_get_rssi(const uint8_t *p) { return (int8_t)p[5]; }
+static inline const char *bd_addr_to_str(const bd_addr_t a) { (void)a; return "00:00:00:00:00:00"; }
+
+static inline void a2dp_subevent_signaling_connection_established_get_bd_addr(const uint8_t *p, bd_addr_t a) { (void)p; (void)a; }
+static inline uint16_t a2dp_subevent_signaling_connection_established_get_a2dp_cid(const uint8_t *p) { (void)p; return 1; }
+static inline uint16_t a2dp_subevent_signaling_connection_established_get_con_handle(const uint8_t *p) { (void)p; return 1; }
+static inline uint8_t a2dp_subevent_signaling_connection_established_get_status(const uint8_t *p) { (void)p; return 0; }
+static inline void a2dp_subevent_stream_established_get_bd_addr(const uint8_t *p, bd_addr_t a) { (void)p; (void)a; }
+static inline uint8_t a2dp_subevent_stream_established_get_status(const uint8_t *p) { (void)p; return 0; }
+static inline uint8_t a2dp_subevent_signaling_media_codec_sbc_configuration_get_reconfigure(const uint8_t *p) { (void)p; return 0; }
+static inline uint8_t a2dp_subevent_signaling_media_codec_sbc_configuration_get_num_channels(const uint8_t *p) { (void)p; return 2; }
+static inline uint32_t a2dp_subevent_signaling_media_codec_sbc_configuration_get_sampling_frequency(const uint8_t *p) { (void)p; return 44100; }
+
+#endif // HOST_BTSTACK_H
@@ -0,0 +1,35 @@
+/**
+ * @file btstack_sbc.h
+ * @brief ホストテスト用の BTstack SBC デコーダー代替（デコードしない）
+ */
+
+#ifndef HOST_BTSTACK_SBC_H
+#define HOST_BTSTACK_SBC_H
+
+#include <stdint.h>
+
+typedef enum {
+    SBC_MODE_STANDARD = 0,
+} btstack_sbc_mode_t;
+
+typedef void (*btstack_sbc_handle_pcm_t)(int16_t *data, int num_samples, int num_channels,
+                                         int sample_rate, void *context);
+
+typedef struct {
+    btstack_sbc_handle_pcm_t handle_pcm;
+    void *context;
+} btstack_sbc_decoder_state_t;
+
+static inline void btstack_sbc_decoder_init(btstack_sbc_decoder_state_t *state, btstack_sbc_mode_t mode,
+                                            btstack_sbc_handle_pcm_t callback, void *context) {
+    (void)mode;
+    state->handle_pcm = callback;
+    state->context = context;
+}
+
+static inline void btstack_sbc_decoder_process_data(btstack_sbc_decoder_state_t *state, int packet_status_flag,
+                                                    const uint8_t *buffer, int size) {
+    (void)state; (void)packet_status_flag; (void)buffer; (void)size;
+}
+
+#endif // HOST_BTSTACK_SBC_H
@@ -0,0 +1,17 @@
+/**
+ * @file hardware/clocks.h
+ * @brief ホストテスト用の Pico SDK 代替（クロック、host_clock_hz を返す）
+ */
+
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif // HOST_HARDWARE_CLOCKS_H
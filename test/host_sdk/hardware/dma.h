@@ -0,0 +1,72 @@
+/**
+ * @file hardware/dma.h
+ * @brief ホストテスト用の Pico SDK 代替（DMA）
+ *
+ * 転送は行わない。チャンネルの設定と INTS0（書き込みでクリア）だけを模擬し、
+ * 完了は host_dma_complete() で起こす（host_sdk.h）。
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS  16
+
+#define DREQ_PIO0_TX0   0
+#define DREQ_SPI1_TX    26
+#define DREQ_SPI1_RX    27
+#define DREQ_PWM_WRAP0  32
+#define DREQ_FORCE      63
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+
+typedef struct {
+    volatile uint32_t ints0;
+    volatile uint32_t inte0;
+} dma_hw_t;
+
+extern dma_hw_t host_dma_hw;
+#define dma_hw  (&host_dma_hw)
+
+// チャンネルのレジスタ（転送カウンタは設定した値のまま、停止中は 0）
+typedef struct {
+    volatile uint32_t transfer_count;
+} dma_channel_hw_t;
+
+dma_channel_hw_t *dma_channel_hw_addr(uint channel);
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config *c, bool incr);
+void channel_config_set_write_increment(dma_channel_config *c, bool incr);
+void channel_config_set_dreq(dma_channel_config *c, uint dreq);
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to);
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+void dma_channel_start(uint channel);
+void dma_start_channel_mask(uint32_t chan_mask);
+void dma_channel_abort(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_wait_for_finish_blocking(uint channel);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+
+static inline void dma_channel_acknowledge_irq0(uint channel) {
+    // INTS0 は1を書いたビットだけクリアされる
+    dma_hw->ints0 &= ~(1u << channel);
+}
+
+#endif // HOST_HARDWARE_DMA_H
@@ -0,0 +1,11 @@
+/**
+ * @file hardware/gpio.h
+ * @brief ホストテスト用の Pico SDK 代替（GPIO は pico/stdlib.h で宣言）
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+#endif // HOST_HARDWARE_GPIO_H
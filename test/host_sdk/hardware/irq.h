@@ -0,0 +1,25 @@
+/**
+ * @file hardware/irq.h
+ * @brief ホストテスト用の Pico SDK 代替（割り込みハンドラーの表）
+ *
+ * 割り込みは host_irq_service() で同期的に呼び出す（host_sdk.h）。
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include "pico/stdlib.h"
+
+#define DMA_IRQ_0  10
+#define DMA_IRQ_1  11
+#define HOST_NUM_IRQS  32
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY  0x80
+
+typedef void (*irq_handler_t)(void);
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_priority(uint num, uint8_t hardware_priority);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif // HOST_HARDWARE_IRQ_H
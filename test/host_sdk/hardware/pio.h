@@ -0,0 +1,36 @@
+/**
+ * @file hardware/pio.h
+ * @brief ホストテスト用の Pico SDK 代替（PIO）
+ *
+ * ステートマシンは動かさない。TX FIFO のアドレス（DMA の書き込み先）と
+ * 有効/無効の状態だけを持つ。PIO のタイミングは tools/pio_emu.py で検証する。
+ */
+
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t txf[4];
+    bool sm_enabled[4];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t host_pio0_hw;
+extern pio_hw_t host_pio1_hw;
+#define pio0  (&host_pio0_hw)
+#define pio1  (&host_pio1_hw)
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+
+#endif // HOST_HARDWARE_PIO_H
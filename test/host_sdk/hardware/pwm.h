@@ -0,0 +1,46 @@
+/**
+ * @file hardware/pwm.h
+ * @brief ホストテスト用の Pico SDK 代替（PWM、設定を記録するだけ）
+ */
+
+#ifndef HOST_HARDWARE_PWM_H
+#define HOST_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t div;
+    volatile uint32_t ctr;
+    volatile uint32_t cc;
+    volatile uint32_t top;
+} pwm_slice_hw_t;
+
+typedef struct {
+    pwm_slice_hw_t slice[12];
+} pwm_hw_t;
+
+extern pwm_hw_t host_pwm_hw;
+#define pwm_hw  (&host_pwm_hw)
+
+typedef struct {
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) {
+    return (gpio >> 1) & 7u;
+}
+
+static inline uint pwm_gpio_to_channel(uint gpio) {
+    return gpio & 1u;
+}
+
+pwm_config pwm_get_default_config(void);
+void pwm_config_set_clkdiv_int(pwm_config *c, uint div);
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap);
+void pwm_init(uint slice_num, pwm_config *c, bool start);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+#endif // HOST_HARDWARE_PWM_H
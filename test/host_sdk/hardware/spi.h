@@ -0,0 +1,43 @@
+/**
+ * @file hardware/spi.h
+ * @brief ホストテスト用の Pico SDK 代替（SPI、1バイトずつ host_spi_set_device() のデバイスとやりとりする）
+ */
+
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include <stddef.h>
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t cr0;
+    volatile uint32_t cr1;
+    volatile uint32_t dr;
+    volatile uint32_t sr;
+} spi_hw_t;
+
+typedef struct spi_inst spi_inst_t;
+
+extern spi_hw_t host_spi_hw[2];
+#define spi0  ((spi_inst_t *)&host_spi_hw[0])
+#define spi1  ((spi_inst_t *)&host_spi_hw[1])
+
+typedef enum { SPI_CPOL_0 = 0, SPI_CPOL_1 = 1 } spi_cpol_t;
+typedef enum { SPI_CPHA_0 = 0, SPI_CPHA_1 = 1 } spi_cpha_t;
+typedef enum { SPI_LSB_FIRST = 0, SPI_MSB_FIRST = 1 } spi_order_t;
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+void spi_deinit(spi_inst_t *spi);
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+uint spi_get_dreq(spi_inst_t *spi, bool is_tx);
+
+static inline spi_hw_t *spi_get_hw(spi_inst_t *spi) {
+    return (spi_hw_t *)spi;
+}
+
+#endif // HOST_HARDWARE_SPI_H
@@ -0,0 +1,35 @@
+/**
+ * @file hardware/structs/busctrl.h
+ * @brief ホストテスト用の Pico SDK 代替（バスファブリックの性能カウンタ）
+ *
+ * カウンタは数えない（常に 0）。
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_BUSCTRL_H
+#define HOST_HARDWARE_STRUCTS_BUSCTRL_H
+
+#include <stdint.h>
+
+typedef enum {
+    arbiter_sram0_perf_event_access,
+    arbiter_sram0_perf_event_access_contested,
+    arbiter_sram8_perf_event_access,
+    arbiter_sram8_perf_event_access_contested,
+} bus_ctrl_perf_counter_t;
+
+typedef struct {
+    volatile uint32_t value;
+    volatile uint32_t sel;
+} bus_ctrl_perf_hw_t;
+
+typedef struct {
+    volatile uint32_t priority;
+    volatile uint32_t priority_ack;
+    volatile uint32_t perfctr_en;
+    bus_ctrl_perf_hw_t counter[4];
+} busctrl_hw_t;
+
+extern busctrl_hw_t host_bus_ctrl_hw;
+#define bus_ctrl_hw  (&host_bus_ctrl_hw)
+
+#endif // HOST_HARDWARE_STRUCTS_BUSCTRL_H
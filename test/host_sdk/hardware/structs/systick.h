@@ -0,0 +1,29 @@
+/**
+ * @file hardware/structs/systick.h
+ * @brief ホストテスト用の Pico SDK 代替（SysTick）
+ *
+ * カウンタは数えない（cvr は書いた値のまま）。ホストのサイクル数は bench_cycles() で測る。
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_SYSTICK_H
+#define HOST_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+#define M33_SYST_CSR_ENABLE_BITS     0x00000001u
+#define M33_SYST_CSR_TICKINT_BITS    0x00000002u
+#define M33_SYST_CSR_CLKSOURCE_BITS  0x00000004u
+#define M33_SYST_RVR_RELOAD_BITS     0x00ffffffu
+#define M33_SYST_CVR_CURRENT_BITS    0x00ffffffu
+
+typedef struct {
+    volatile uint32_t csr;
+    volatile uint32_t rvr;
+    volatile uint32_t cvr;
+    volatile uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t host_systick_hw;
+#define systick_hw  (&host_systick_hw)
+
+#endif // HOST_HARDWARE_STRUCTS_SYSTICK_H
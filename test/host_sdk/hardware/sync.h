@@ -0,0 +1,11 @@
+/**
+ * @file hardware/sync.h
+ * @brief ホストテスト用の Pico SDK 代替（割り込み禁止は pico/stdlib.h で宣言）
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+#endif // HOST_HARDWARE_SYNC_H
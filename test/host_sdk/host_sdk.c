@@ -0,0 +1,401 @@
+/**
+ * @file host_sdk.c
+ * @brief ホストテスト用の Pico SDK 代替の実装
+ */
+
+#include "host_sdk.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/pwm.h"
+#include "hardware/spi.h"
+#include "hardware/structs/busctrl.h"
+#include "hardware/structs/systick.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// 時刻・クロック
+// ============================================================================
+
+uint32_t host_clock_hz = 150000000;
+
+static bool time_virtual = false;
+static uint64_t virtual_us = 0;
+
+static uint64_t real_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+void host_time_set_virtual(bool enabled) {
+    time_virtual = enabled;
+}
+
+void host_time_set_us(uint64_t us) {
+    virtual_us = us;
+}
+
+void host_time_advance_us(uint64_t us) {
+    virtual_us += us;
+}
+
+uint64_t time_us_64(void) {
+    return time_virtual ? virtual_us : real_time_us();
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+void sleep_us(uint64_t us) {
+    if (time_virtual) {
+        virtual_us += us;
+        return;
+    }
+    uint64_t end = real_time_us() + us;
+    while (real_time_us() < end) {
+    }
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    (void)clk_index;
+    return host_clock_hz;
+}
+
+// ============================================================================
+// 標準入出力・GPIO・コア
+// ============================================================================
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+int putchar_raw(int c) {
+    return putchar(c);
+}
+
+void gpio_init(uint gpio) { (void)gpio; }
+void gpio_set_dir(uint gpio, bool out) { (void)gpio; (void)out; }
+void gpio_pull_up(uint gpio) { (void)gpio; }
+bool gpio_get(uint gpio) { (void)gpio; return true; }
+static bool gpio_out[48];
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < 48) gpio_out[gpio] = value;
+}
+
+bool host_gpio_get_out(uint gpio) {
+    return gpio < 48 && gpio_out[gpio];
+}
+void gpio_set_function(uint gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+
+uint get_core_num(void) {
+    return 0;
+}
+
+// host_irq_service() がハンドラーを呼んでいる間だけ 16 + 割り込み番号
+static uint current_exception = 0;
+
+uint __get_current_exception(void) {
+    return current_exception;
+}
+
+uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+// ============================================================================
+// DMA
+// ============================================================================
+
+dma_hw_t host_dma_hw;
+host_dma_channel_t host_dma[NUM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required) {
+    for (int ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (!host_dma[ch].claimed) {
+            host_dma[ch].claimed = true;
+            return ch;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "host_sdk: no free DMA channel\n");
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    host_dma[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    dma_channel_config c = { 0 };
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    (void)c; (void)size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) { (void)c; (void)incr; }
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) { (void)c; (void)incr; }
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) { (void)c; (void)dreq; }
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) { (void)c; (void)chain_to; }
+
+static void trigger(uint channel) {
+    host_dma[channel].busy = true;
+    host_dma[channel].starts++;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trig) {
+    (void)config;
+    host_dma[channel].write_addr = write_addr;
+    host_dma[channel].read_addr = read_addr;
+    host_dma[channel].trans_count = transfer_count;
+    if (trig) trigger(channel);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trig) {
+    host_dma[channel].read_addr = read_addr;
+    if (trig) trigger(channel);
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trig) {
+    host_dma[channel].write_addr = write_addr;
+    if (trig) trigger(channel);
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trig) {
+    host_dma[channel].trans_count = trans_count;
+    if (trig) trigger(channel);
+}
+
+void dma_channel_start(uint channel) {
+    trigger(channel);
+}
+
+void dma_start_channel_mask(uint32_t chan_mask) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (chan_mask & (1u << ch)) trigger(ch);
+    }
+}
+
+void dma_channel_abort(uint channel) {
+    host_dma[channel].busy = false;
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return host_dma[channel].busy;
+}
+
+void dma_channel_wait_for_finish_blocking(uint channel) {
+    host_dma[channel].busy = false;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    host_dma[channel].irq0_enabled = enabled;
+    if (enabled) {
+        host_dma_hw.inte0 |= 1u << channel;
+    } else {
+        host_dma_hw.inte0 &= ~(1u << channel);
+    }
+}
+
+dma_channel_hw_t *dma_channel_hw_addr(uint channel) {
+    static dma_channel_hw_t regs[NUM_DMA_CHANNELS];
+    regs[channel].transfer_count = host_dma[channel].busy ? host_dma[channel].trans_count : 0;
+    return &regs[channel];
+}
+
+void host_dma_complete(uint channel) {
+    host_dma[channel].busy = false;
+    if (host_dma[channel].irq0_enabled) {
+        host_dma_hw.ints0 |= 1u << channel;
+    }
+}
+
+// ============================================================================
+// SPI
+// ============================================================================
+
+spi_hw_t host_spi_hw[2];
+static host_spi_device_t spi_device = NULL;
+
+void host_spi_set_device(host_spi_device_t device) {
+    spi_device = device;
+}
+
+static uint8_t spi_xfer(uint8_t out) {
+    return spi_device ? spi_device(out) : 0xFF;
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) { (void)spi; return baudrate; }
+void spi_deinit(spi_inst_t *spi) { (void)spi; }
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) { (void)spi; return baudrate; }
+
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order) {
+    (void)spi; (void)data_bits; (void)cpol; (void)cpha; (void)order;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) dst[i] = spi_xfer(src[i]);
+    return (int)len;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) spi_xfer(src[i]);
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) dst[i] = spi_xfer(repeated_tx_data);
+    return (int)len;
+}
+
+uint spi_get_dreq(spi_inst_t *spi, bool is_tx) {
+    return (spi == spi0 ? 24 : 26) + (is_tx ? 0 : 1);
+}
+
+// ============================================================================
+// 割り込み
+// ============================================================================
+
+static irq_handler_t irq_handlers[HOST_NUM_IRQS];
+static bool irq_enabled[HOST_NUM_IRQS];
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    if (irq_handlers[num]) {
+        fprintf(stderr, "host_sdk: IRQ %u already has an exclusive handler\n", num);
+    }
+    irq_handlers[num] = handler;
+}
+
+void irq_set_priority(uint num, uint8_t hardware_priority) {
+    (void)num; (void)hardware_priority;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    irq_enabled[num] = enabled;
+}
+
+static bool irq_pending(uint num) {
+    if (num == DMA_IRQ_0) {
+        return (host_dma_hw.ints0 & host_dma_hw.inte0) != 0;
+    }
+    return false;
+}
+
+uint32_t host_irq_service(uint num, uint32_t max_calls) {
+    uint32_t calls = 0;
+    while (irq_enabled[num] && irq_handlers[num] && irq_pending(num) && calls < max_calls) {
+        uint saved = current_exception;
+        current_exception = 16 + num;
+        irq_handlers[num]();
+        current_exception = saved;
+        calls++;
+    }
+    return calls;
+}
+
+// ============================================================================
+// PWM（設定を記録するだけ）
+// ============================================================================
+
+pwm_hw_t host_pwm_hw;
+
+pwm_config pwm_get_default_config(void) {
+    pwm_config c = { 0, 1, 0xFFFF };
+    return c;
+}
+
+void pwm_config_set_clkdiv_int(pwm_config *c, uint div) {
+    c->div = div;
+}
+
+void pwm_config_set_wrap(pwm_config *c, uint16_t wrap) {
+    c->top = wrap;
+}
+
+void pwm_init(uint slice_num, pwm_config *c, bool start) {
+    host_pwm_hw.slice[slice_num].div = c->div;
+    host_pwm_hw.slice[slice_num].top = c->top;
+    host_pwm_hw.slice[slice_num].csr = start ? 1u : 0u;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled) {
+    host_pwm_hw.slice[slice_num].csr = enabled ? 1u : 0u;
+}
+
+// ============================================================================
+// PIO・バスファブリック・SysTick（設定を記録するだけ）
+// ============================================================================
+
+pio_hw_t host_pio0_hw;
+pio_hw_t host_pio1_hw;
+busctrl_hw_t host_bus_ctrl_hw;
+
+// リンカースクリプトが定義する scratch Y の境界（ホストではこの配列の中を指す）
+// 下側 1KB が .scratch_y、上側 3KB がスタック（PICO_STACK_SIZE = 0xC00）
+uint32_t host_scratch_y[1024];
+__asm__(".globl __scratch_y_start__\n.set __scratch_y_start__, host_scratch_y\n"
+        ".globl __scratch_y_end__\n.set __scratch_y_end__, host_scratch_y + 64\n"
+        ".globl __StackBottom\n.set __StackBottom, host_scratch_y + 1024\n"
+        ".globl __StackTop\n.set __StackTop, host_scratch_y + 4096\n");
+systick_hw_t host_systick_hw;
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio;
+    return 32u - program->length;
+}
+
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return (pio == pio0 ? 0u : 8u) + sm + (is_tx ? 0u : 4u);
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    pio->sm_enabled[sm] = enabled;
+}
+
+// ============================================================================
+// リセット
+// ============================================================================
+
+void host_sdk_reset(void) {
+    memset(host_dma, 0, sizeof(host_dma));
+    memset(&host_dma_hw, 0, sizeof(host_dma_hw));
+    memset(&host_pio0_hw, 0, sizeof(host_pio0_hw));
+    memset(&host_pio1_hw, 0, sizeof(host_pio1_hw));
+    memset(&host_systick_hw, 0, sizeof(host_systick_hw));
+    memset(irq_handlers, 0, sizeof(irq_handlers));
+    memset(irq_enabled, 0, sizeof(irq_enabled));
+    time_virtual = false;
+    virtual_us = 0;
+    memset(gpio_out, 0, sizeof(gpio_out));
+    spi_device = NULL;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file host_sdk.h
+ * @brief ホストテスト用の偽ハードウェアの操作
+ *
+ * Pico SDK 代替（pico/, hardware/）の裏にある状態をテストから動かす。
+ *   - 時刻: 既定は実時間。host_time_set_virtual(true) で仮想時刻にし、host_time_advance_us() で進める
+ *   - DMA: host_dma_complete() で転送完了（INTS0 のビットを立てる）
+ *   - 割り込み: host_irq_service() で、フラグが残っている間ハンドラーを呼ぶ（レベル割り込み）。
+ *     ハンドラーの中では __get_current_exception() が 16 + 割り込み番号を返す
+ *   - SPI: host_spi_set_device() のデバイスが1バイトごとに応答する（DMA の転送は動かさない）
+ */
+
+#ifndef HOST_SDK_H
+#define HOST_SDK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+
+// ============================================================================
+// 時刻・クロック
+// ============================================================================
+
+extern uint32_t host_clock_hz;   // clock_get_hz(clk_sys) の値（既定 150MHz）
+
+void host_time_set_virtual(bool enabled);
+void host_time_set_us(uint64_t us);
+void host_time_advance_us(uint64_t us);
+
+// ============================================================================
+// DMA
+// ============================================================================
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    bool irq0_enabled;
+    const volatile void *read_addr;
+    volatile void *write_addr;
+    uint32_t trans_count;
+    uint32_t starts;          // 起動（トリガー）回数
+} host_dma_channel_t;
+
+extern host_dma_channel_t host_dma[NUM_DMA_CHANNELS];
+
+/**
+ * @brief チャンネルの転送を完了させる（IRQ0 が有効なら INTS0 のビットを立てる）
+ */
+void host_dma_complete(uint channel);
+
+// ============================================================================
+// GPIO・SPI
+// ============================================================================
+
+/**
+ * @brief gpio_put() で最後に出した値（初期値 false）
+ */
+bool host_gpio_get_out(uint gpio);
+
+/**
+ * @brief SPI のデバイス: 送ったバイトを受け取り、同時に返すバイトを返す
+ */
+typedef uint8_t (*host_spi_device_t)(uint8_t out);
+
+/**
+ * @brief SPI につなぐデバイス（NULL = なし、常に 0xFF を返す）
+ */
+void host_spi_set_device(host_spi_device_t device);
+
+// ============================================================================
+// 割り込み
+// ============================================================================
+
+/**
+ * @brief 割り込みを処理する
+ *
+ * DMA_IRQ_0 は INTS0 にビットが残っている間ハンドラーを呼び続ける（ハードウェアの
+ * レベル割り込みと同じ）。ハンドラーが何もクリアしないときは max_calls で打ち切る。
+ *
+ * @return ハンドラーを呼んだ回数
+ */
+uint32_t host_irq_service(uint num, uint32_t max_calls);
+
+/**
+ * @brief 偽ハードウェアを初期状態に戻す（DMA、割り込み、時刻、GPIO、SPI）
+ */
+void host_sdk_reset(void);
+
+#endif // HOST_SDK_H
@@ -0,0 +1,31 @@
+/**
+ * @file i2s.pio.h
+ * @brief ホストテスト用の i2s.pio の代わり（ファームウェアでは pioasm が生成する）
+ *
+ * 命令列は持たない（tools/pio_emu.py が src/i2s.pio をアセンブルして検証する）。
+ */
+
+#ifndef HOST_I2S_PIO_H
+#define HOST_I2S_PIO_H
+
+#include "hardware/pio.h"
+
+#define i2s_output_offset_entry_point       7u
+#define i2s_output_dual_offset_entry_point  7u
+
+static const pio_program_t i2s_output_program = { NULL, 8, -1 };
+static const pio_program_t i2s_output_dual_program = { NULL, 8, -1 };
+
+static inline void i2s_output_program_init(PIO pio, uint sm, uint offset, uint data_pin,
+                                           uint clock_pin_base, uint sample_rate) {
+    (void)offset; (void)data_pin; (void)clock_pin_base; (void)sample_rate;
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+static inline void i2s_output_dual_program_init(PIO pio, uint sm, uint offset, uint data_pin_base,
+                                                uint clock_pin_base, uint sample_rate) {
+    (void)offset; (void)data_pin_base; (void)clock_pin_base; (void)sample_rate;
+    pio_sm_set_enabled(pio, sm, true);
+}
+
+#endif // HOST_I2S_PIO_H
@@ -0,0 +1,17 @@
+/**
+ * @file pico/cyw43_arch.h
+ * @brief ホストテスト用の CYW43 代替（何もしない）
+ */
+
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+#define CYW43_WL_GPIO_LED_PIN  0
+
+static inline int cyw43_arch_init(void) { return 0; }
+static inline void cyw43_arch_poll(void) {}
+static inline void *cyw43_arch_async_context(void) { return 0; }
+static inline void async_context_poll(void *context) { (void)context; }
+static inline void cyw43_arch_gpio_put(int pin, int value) { (void)pin; (void)value; }
+
+#endif // HOST_PICO_CYW43_ARCH_H
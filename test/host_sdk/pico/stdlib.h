@@ -0,0 +1,106 @@
+/**
+ * @file pico/stdlib.h
+ * @brief ホストテスト用の Pico SDK 代替（pico/stdlib.h）
+ *
+ * ファームウェアのソースをそのままホストでビルドするための最小限の宣言。
+ * 時刻は既定で実時間（ベンチマーク用）、host_time_set_virtual() で仮想時刻に切り替える。
+ * 偽ハードウェアの操作は host_sdk.h を参照。
+ */
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+// ============================================================================
+// 時刻
+// ============================================================================
+
+typedef uint64_t absolute_time_t;
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+absolute_time_t get_absolute_time(void);
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+    return t;
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+static inline void tight_loop_contents(void) {
+}
+
+// ============================================================================
+// 標準入出力
+// ============================================================================
+
+#define PICO_ERROR_TIMEOUT  (-1)
+
+bool stdio_init_all(void);
+int getchar_timeout_us(uint32_t timeout_us);
+int putchar_raw(int c);
+
+// ============================================================================
+// GPIO（出力の値だけ覚える、host_gpio_get_out()）
+// ============================================================================
+
+#define GPIO_IN   0
+#define GPIO_OUT  1
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_pull_up(uint gpio);
+bool gpio_get(uint gpio);
+void gpio_put(uint gpio, bool value);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+
+// ============================================================================
+// コア・割り込み
+// ============================================================================
+
+#define NUM_CORES  2
+
+uint get_core_num(void);
+uint __get_current_exception(void);
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+// ============================================================================
+// 属性・マクロ
+// ============================================================================
+
+#define __not_in_flash_func(f)  f
+#define __time_critical_func(f) f
+#define __scratch_x(group)      __attribute__((section(".scratch_x." group)))
+#define __scratch_y(group)      __attribute__((section(".scratch_y." group)))
+#define __in_flash(group)
+#define __aligned(n)            __attribute__((aligned(n)))
+#define count_of(a)             (sizeof(a) / sizeof((a)[0]))
+#define hard_assert(x)          ((void)(x))
+
+#define XIP_BASE                  0x10000000u
+#define XIP_NOCACHE_NOALLOC_BASE  0x14000000u
+#define PICO_FLASH_SIZE_BYTES     (4u * 1024u * 1024u)
+
+#endif // HOST_PICO_STDLIB_H
@@ -0,0 +1,201 @@
+/**
+ * @file test_audio_block.c
+ * @brief プレーナー/インターリーブ変換カーネルのホストテストとレイアウト別のベンチマーク
+ *
+ * - audio_block_deinterleave / interleave の往復が、奇数長と4バイト境界でない位置を含めて
+ *   ビット単位で一致すること、mono_to_planar と pack_i2s_words が1サンプルずつの参照と
+ *   一致することを確かめる
+ * - 典型的な段（ボリューム、バイクアッド、ゲイン乗算）を3段通すブロック処理を
+ *   インターリーブ（LRLR... のまま各段がストライド2で読む）とプレーナー（入口で分離し、
+ *   各段は L/R を連続で読み、出口で I2S ワードに詰める）で比べる。
+ *   プレーナー側は境界の変換コストを含めた数字で比べる
+ */
+
+#include "../src/audio_block.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <stdlib.h>
+
+#define MAX_FRAMES   1024
+#define BENCH_BLOCK  1024
+
+// ============================================================================
+// 変換カーネル
+// ============================================================================
+
+static void test_round_trip(void) {
+    printf("Deinterleave / interleave round trip (odd lengths, unaligned offsets):\n");
+
+    static int16_t src[MAX_FRAMES * 2 + 8], back[MAX_FRAMES * 2 + 8];
+    static int16_t left[MAX_FRAMES + 8], right[MAX_FRAMES + 8];
+    uint32_t rng = 5;
+    for (uint32_t i = 0; i < MAX_FRAMES * 2 + 8; i++) src[i] = (int16_t)test_rand(&rng);
+
+    uint32_t errors = 0;
+    uint32_t cases = 0;
+    for (uint32_t n = 0; n <= 300; n++) {
+        for (uint32_t off = 0; off < 4; off++) {
+            memset(left, 0x55, sizeof(left));
+            memset(right, 0x55, sizeof(right));
+            memset(back, 0x55, sizeof(back));
+
+            audio_block_deinterleave(&src[off], &left[off], &right[off], n);
+            for (uint32_t i = 0; i < n; i++) {
+                if (left[off + i] != src[off + 2 * i] || right[off + i] != src[off + 2 * i + 1]) errors++;
+            }
+            // 範囲外に書いていない
+            if (left[off + n] != 0x5555 || right[off + n] != 0x5555) errors++;
+
+            audio_block_interleave(&left[off], &right[off], &back[off], n);
+            if (memcmp(&back[off], &src[off], n * 2 * sizeof(int16_t)) != 0) errors++;
+            if (back[off + 2 * n] != 0x5555) errors++;
+            cases++;
+        }
+    }
+    printf("  %u cases, %u mismatches\n", cases, errors);
+    CHECK(errors == 0);
+}
+
+static void test_mono_and_pack(void) {
+    printf("Mono to planar, I2S word packing:\n");
+
+    static int16_t src[MAX_FRAMES], left[MAX_FRAMES], right[MAX_FRAMES];
+    static uint32_t words[MAX_FRAMES];
+    uint32_t rng = 77;
+    for (uint32_t i = 0; i < MAX_FRAMES; i++) src[i] = (int16_t)test_rand(&rng);
+
+    uint32_t errors = 0;
+    for (uint32_t n = 1; n <= MAX_FRAMES; n = n * 3 + 1) {
+        audio_block_mono_to_planar(src, left, right, n);
+        for (uint32_t i = 0; i < n; i++) {
+            if (left[i] != src[i] || right[i] != src[i]) errors++;
+        }
+        audio_block_pack_i2s_words(src, left, words, n);
+        for (uint32_t i = 0; i < n; i++) {
+            if ((int16_t)(words[i] >> 16) != src[i] || (int16_t)(words[i] & 0xFFFF) != left[i]) errors++;
+        }
+    }
+    CHECK(errors == 0);
+    CHECK(audio_block_pack_i2s(-1, 0) == 0xFFFF0000u);
+    CHECK(audio_block_pack_i2s(0, -2) == 0x0000FFFEu);
+}
+
+// ============================================================================
+// ベンチマーク用の段（同じ計算をレイアウトだけ変えて書く）
+// ============================================================================
+
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;   // Q14
+    int32_t x1, x2, y1, y2;
+} biquad_q14_t;
+
+static inline int16_t sat16(int32_t v) {
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+static inline int16_t biquad_step(biquad_q14_t *f, int16_t x) {
+    int32_t y = (f->b0 * x + f->b1 * f->x1 + f->b2 * f->x2 - f->a1 * f->y1 - f->a2 * f->y2) >> 14;
+    f->x2 = f->x1; f->x1 = x;
+    f->y2 = f->y1; f->y1 = y;
+    return sat16(y);
+}
+
+// インターリーブ: 各段が LRLR... をストライド2で読み書きする
+static void chain_interleaved(int16_t *lr, uint32_t *words, uint32_t n,
+                              biquad_q14_t *fl, biquad_q14_t *fr, int32_t gain_q15) {
+    for (uint32_t i = 0; i < n * 2; i++) {
+        lr[i] = (int16_t)((lr[i] * 90) / 100);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        lr[2 * i] = biquad_step(fl, lr[2 * i]);
+        lr[2 * i + 1] = biquad_step(fr, lr[2 * i + 1]);
+    }
+    for (uint32_t i = 0; i < n * 2; i++) {
+        lr[i] = sat16((lr[i] * gain_q15) >> 15);
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        words[i] = audio_block_pack_i2s(lr[2 * i], lr[2 * i + 1]);
+    }
+}
+
+// プレーナー: 入口で分離し、各段は L と R を別々に連続で読む
+static void chain_planar(const int16_t *lr, int16_t *left, int16_t *right, uint32_t *words, uint32_t n,
+                         biquad_q14_t *fl, biquad_q14_t *fr, int32_t gain_q15) {
+    audio_block_deinterleave(lr, left, right, n);
+    for (uint32_t i = 0; i < n; i++) {
+        left[i] = (int16_t)((left[i] * 90) / 100);
+        right[i] = (int16_t)((right[i] * 90) / 100);
+    }
+    for (uint32_t i = 0; i < n; i++) left[i] = biquad_step(fl, left[i]);
+    for (uint32_t i = 0; i < n; i++) right[i] = biquad_step(fr, right[i]);
+    for (uint32_t i = 0; i < n; i++) {
+        left[i] = sat16((left[i] * gain_q15) >> 15);
+        right[i] = sat16((right[i] * gain_q15) >> 15);
+    }
+    audio_block_pack_i2s_words(left, right, words, n);
+}
+
+static void bench(void) {
+    printf("Three-stage chain per %d-frame block (host):\n", BENCH_BLOCK);
+
+    static int16_t src[BENCH_BLOCK * 2], lr[BENCH_BLOCK * 2];
+    static int16_t left[BENCH_BLOCK] AUDIO_ALIGNED, right[BENCH_BLOCK] AUDIO_ALIGNED;
+    static uint32_t words_i[BENCH_BLOCK], words_p[BENCH_BLOCK];
+    uint32_t rng = 3;
+    for (uint32_t i = 0; i < BENCH_BLOCK * 2; i++) src[i] = (int16_t)(test_rand(&rng) >> 2);
+
+    // 1kHz 付近のローパス（Q14）
+    const biquad_q14_t proto = { 318, 636, 318, -29133, 13021, 0, 0, 0, 0 };
+    const int32_t gain_q15 = 26000;
+
+    // 同じ計算なので結果は一致する
+    biquad_q14_t fl = proto, fr = proto, gl = proto, gr = proto;
+    memcpy(lr, src, sizeof(lr));
+    chain_interleaved(lr, words_i, BENCH_BLOCK, &fl, &fr, gain_q15);
+    chain_planar(src, left, right, words_p, BENCH_BLOCK, &gl, &gr, gain_q15);
+    CHECK(memcmp(words_i, words_p, sizeof(words_i)) == 0);
+
+    const int blocks = 20000;
+    double cycles[3], ns[3];
+    for (int mode = 0; mode < 3; mode++) {
+        fl = fr = proto;
+        uint64_t t0 = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        for (int b = 0; b < blocks; b++) {
+            if (mode == 0) {
+                memcpy(lr, src, sizeof(lr));
+                chain_interleaved(lr, words_i, BENCH_BLOCK, &fl, &fr, gain_q15);
+            } else if (mode == 1) {
+                chain_planar(src, left, right, words_p, BENCH_BLOCK, &fl, &fr, gain_q15);
+            } else {
+                // 境界の変換だけ（分離 + I2S パッキング）
+                audio_block_deinterleave(src, left, right, BENCH_BLOCK);
+                audio_block_pack_i2s_words(left, right, words_p, BENCH_BLOCK);
+            }
+        }
+        uint64_t c1 = bench_cycles();
+        uint64_t t1 = bench_now_ns();
+        bench_sink(words_i, sizeof(words_i));
+        bench_sink(words_p, sizeof(words_p));
+        cycles[mode] = (double)(c1 - c0) / blocks / BENCH_BLOCK;
+        ns[mode] = (double)(t1 - t0) / blocks / BENCH_BLOCK;
+    }
+
+    // インターリーブ側にも入口のコピー（memcpy）が入っている。デコーダーの出力を
+    // その場で書き換えられない実機の条件と同じ
+    printf("  interleaved (stride 2)          : %.2f ns, %.2f host cycles/frame\n", ns[0], cycles[0]);
+    printf("  planar (incl. boundary convert) : %.2f ns, %.2f host cycles/frame\n", ns[1], cycles[1]);
+    printf("  boundary only (deinterleave+pack): %.2f ns, %.2f host cycles/frame\n", ns[2], cycles[2]);
+    printf("  (target cycles: effect/loudness *_get_cycles() in the status log on the device)\n");
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_round_trip();
+    test_mono_and_pack();
+    bench();
+    return test_summary("test_audio_block");
+}
@@ -0,0 +1,196 @@
+/**
+ * @file test_compressor.c
+ * @brief コンプレッサーのホストテスト（静的カーブ、時定数、サイクル）
+ *
+ * - compressor_static_curve() を浮動小数点のソフトニーの式と -90..+6 dBFS で比べる
+ * - 直流の入力をアタック/リリース 0 で通し、出力レベルが（入力 + カーブ + メイクアップ）に
+ *   なることを確かめる（log2/exp2 の LUT 近似を含めた全体の誤差）
+ * - ステップ入力で、アタック/リリースの時定数（63%）が設定どおりか確かめる
+ * - 通常処理と先読み処理のフレームあたりのコストを測る
+ */
+
+#include "../src/compressor.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FS     44100
+#define BLOCK  256
+
+/**
+ * @brief ソフトニーの静的カーブ（浮動小数点の参照）
+ * @return ゲインリダクション（dB、0 以下）
+ */
+static double reference_curve(double level_db, double threshold, double ratio, double knee) {
+    double over = level_db - threshold;
+    double slope = 1.0 - 1.0 / ratio;
+    if (knee > 0.0 && 2.0 * fabs(over) < knee) {
+        double x = over + knee / 2.0;
+        return -slope * x * x / (2.0 * knee);
+    }
+    return (over <= 0.0) ? 0.0 : -slope * over;
+}
+
+static compressor_t make(double threshold, double ratio, double knee, double makeup,
+                         double attack_ms, double release_ms) {
+    compressor_params_t p = {
+        .threshold_db = (float)threshold,
+        .ratio = (float)ratio,
+        .knee_db = (float)knee,
+        .attack_ms = (float)attack_ms,
+        .release_ms = (float)release_ms,
+        .makeup_db = (float)makeup,
+    };
+    compressor_t c;
+    compressor_init(&c, &p, FS);
+    return c;
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static const struct {
+    double threshold, ratio, knee, makeup;
+} curves[] = {
+    { -12.0, 4.0, 6.0, 3.0 },     // バスコンプの既定値
+    { -20.0, 2.0, 0.0, 0.0 },     // ハードニー
+    { -30.0, 10.0, 12.0, 6.0 },   // 深いソフトニー
+    { -6.0, 1.5, 3.0, 0.0 },
+    { -18.0, 100.0, 0.0, 0.0 },   // リミッター相当
+};
+#define NUM_CURVES (sizeof(curves) / sizeof(curves[0]))
+
+static void test_static_curve(void) {
+    printf("Static curve vs. floating-point reference:\n");
+
+    for (unsigned k = 0; k < NUM_CURVES; k++) {
+        compressor_t c = make(curves[k].threshold, curves[k].ratio, curves[k].knee, curves[k].makeup, 0, 0);
+        double worst = 0.0;
+        for (double level = -90.0; level <= 6.0; level += 0.05) {
+            int32_t gr = compressor_static_curve(&c, (int32_t)lround(level * 65536.0));
+            double expected = reference_curve(level, curves[k].threshold, curves[k].ratio, curves[k].knee);
+            double err = fabs(gr / 65536.0 - expected);
+            if (err > worst) worst = err;
+        }
+        printf("  thr %6.1f ratio %5.1f knee %4.1f: max error %.5f dB\n",
+               curves[k].threshold, curves[k].ratio, curves[k].knee, worst);
+        CHECK(worst < 0.001);
+    }
+}
+
+static void test_level_chain(void) {
+    printf("Static transfer (DC input, instant attack/release):\n");
+
+    for (unsigned k = 0; k < NUM_CURVES; k++) {
+        compressor_t c = make(curves[k].threshold, curves[k].ratio, curves[k].knee, curves[k].makeup, 0, 0);
+        double worst = 0.0;
+        for (double level = -60.0; level <= -0.1; level += 0.37) {
+            int16_t v = (int16_t)lround(pow(10.0, level / 20.0) * 32768.0);
+            double in_db = 20.0 * log10(v / 32768.0);
+            double expected_db = in_db + curves[k].makeup +
+                reference_curve(in_db, curves[k].threshold, curves[k].ratio, curves[k].knee);
+
+            int16_t l[8], r[8];
+            for (int i = 0; i < 8; i++) { l[i] = v; r[i] = (int16_t)-v; }
+            compressor_reset(&c);
+            compressor_process(&c, l, r, 8);
+
+            double expected = pow(10.0, expected_db / 20.0) * 32768.0;
+            if (expected > 32767.0) continue;   // クリップ
+            // 出力の量子化（1 LSB）を除いた誤差を dB で
+            double excess = fabs(l[7] - expected) - 1.0;
+            double err = (excess > 0.0) ? 20.0 * log10(1.0 + excess / expected) : 0.0;
+            if (err > worst) worst = err;
+            CHECK(abs(l[7] + r[7]) <= 1);
+        }
+        printf("  thr %6.1f ratio %5.1f knee %4.1f makeup %3.1f: max error %.4f dB\n",
+               curves[k].threshold, curves[k].ratio, curves[k].knee, curves[k].makeup, worst);
+        CHECK(worst < 0.02);
+    }
+}
+
+/**
+ * @brief 0 → 目標の変化の 63% に達するまでのフレーム数
+ */
+static uint32_t frames_to_63(compressor_t *c, int16_t level, int32_t from_q16, int32_t to_q16) {
+    int32_t mark = from_q16 + (int32_t)((to_q16 - from_q16) * 0.632);
+    for (uint32_t n = 1; n < FS * 2; n++) {
+        compressor_compute_gain(c, level, level);
+        if ((to_q16 < from_q16) ? (c->env_q16 <= mark) : (c->env_q16 >= mark)) return n;
+    }
+    return UINT32_MAX;
+}
+
+static void test_time_constants(void) {
+    printf("Attack / release time constants:\n");
+
+    const double attack_ms = 5.0, release_ms = 200.0;
+    compressor_t c = make(-20.0, 4.0, 0.0, 0.0, attack_ms, release_ms);
+
+    // -2 dBFS → 18dB 超過 × 0.75 = 13.5dB のリダクション
+    int16_t loud = (int16_t)lround(pow(10.0, -2.0 / 20.0) * 32768.0);
+    int32_t target = compressor_static_curve(&c, level_to_db_q16((uint32_t)loud));
+    uint32_t attack = frames_to_63(&c, loud, 0, target);
+    uint32_t release = frames_to_63(&c, 0, c.env_q16, 0);
+
+    double attack_meas = attack * 1000.0 / FS;
+    double release_meas = release * 1000.0 / FS;
+    printf("  attack %.2f ms (set %.1f), release %.2f ms (set %.1f)\n",
+           attack_meas, attack_ms, release_meas, release_ms);
+    CHECK_NEAR(attack_meas, attack_ms, attack_ms * 0.05);
+    CHECK_NEAR(release_meas, release_ms, release_ms * 0.05);
+}
+
+static void bench(void) {
+    printf("Cost per frame (host, %d-frame blocks):\n", BLOCK);
+
+    int16_t src_l[BLOCK], src_r[BLOCK], l[BLOCK], r[BLOCK];
+    uint32_t rng = 99;
+    for (int i = 0; i < BLOCK; i++) {
+        src_l[i] = (int16_t)test_rand(&rng);
+        src_r[i] = (int16_t)test_rand(&rng);
+    }
+
+    compressor_t c = make(-12.0, 4.0, 6.0, 3.0, 5.0, 200.0);
+    static latency_delay_t delay;
+    latency_init();
+    latency_delay_alloc(&delay, 64);
+    latency_delay_set(&delay, 64);
+
+    for (int mode = 0; mode < 2; mode++) {
+        const int blocks = 20000;
+        uint64_t t0 = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        for (int b = 0; b < blocks; b++) {
+            memcpy(l, src_l, sizeof(l));
+            memcpy(r, src_r, sizeof(r));
+            if (mode == 0) {
+                compressor_process(&c, l, r, BLOCK);
+            } else {
+                compressor_process_lookahead(&c, &delay, l, r, BLOCK);
+            }
+        }
+        uint64_t c1 = bench_cycles();
+        uint64_t t1 = bench_now_ns();
+        bench_sink(l, sizeof(l));
+        double frames = (double)blocks * BLOCK;
+        printf("  %-22s %.2f ns/frame, %.1f host cycles/frame\n",
+               mode == 0 ? "compressor_process" : "process_lookahead (64)",
+               (double)(t1 - t0) / frames, (double)(c1 - c0) / frames);
+    }
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_static_curve();
+    test_level_chain();
+    test_time_constants();
+    bench();
+    return test_summary("test_compressor");
+}
@@ -0,0 +1,362 @@
+/**
+ * @file test_control_frame.c
+ * @brief 制御プロトコルのフレーミング（COBS + CRC-16）のファズテストとスループットのベンチマーク
+ *
+ * - CRC-16/CCITT-FALSE のチェック値
+ * - 往復: 長さ・0x00 の密度がランダムなメッセージをエンコードし、printf のテキストと
+ *   混ぜたバイト列を1バイトずつデコードして、全メッセージが順に元どおり戻ること
+ * - 破損: ビット反転 / バイトの挿入・削除 / 途中で切れたフレームを混ぜても
+ *   - 壊れていないフレームはすべて受信できる（次のフレームで必ず同期が戻る）
+ *   - 壊れたフレームを受け入れる率が CRC-16 の見逃し率（2^-16）程度に収まる
+ *   - データバイトの1ビット反転は必ず検出する
+ * - ランダムなバイト列と長すぎるフレームで、バッファを越えて書かないこと
+ * - エンコード/デコードのバイトあたりのホストサイクル数
+ */
+
+#include "control_frame.h"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <string.h>
+
+#define NUM_MESSAGES    20000
+#define STREAM_BYTES    (NUM_MESSAGES * (CONTROL_FRAME_MAX_ENCODED + 24))
+
+static uint8_t messages[NUM_MESSAGES][CONTROL_FRAME_MAX_MSG];
+static uint16_t message_len[NUM_MESSAGES];
+static uint8_t stream[STREAM_BYTES];
+static bool corrupted[NUM_MESSAGES];
+
+// ============================================================================
+// ヘルパー
+// ============================================================================
+
+/**
+ * @brief ランダムなメッセージ（ランダムな割合のバイトが 0x00、先頭2バイトは通し番号）
+ */
+static void make_message(uint32_t i, uint32_t *rng) {
+    uint16_t len = (uint16_t)(2 + test_rand(rng) % (CONTROL_FRAME_MAX_MSG - 1));
+    static const uint32_t densities[] = { 0, 5, 30, 100 };
+    uint32_t zero_percent = densities[test_rand(rng) % 4];
+    for (uint16_t k = 0; k < len; k++) {
+        uint8_t b = (uint8_t)(1 + test_rand(rng) % 255);
+        messages[i][k] = (test_rand(rng) % 100 < zero_percent) ? 0x00 : b;
+    }
+    // 同じ内容のメッセージが続くと突き合わせで区別できないので通し番号を入れる
+    messages[i][0] = (uint8_t)i;
+    messages[i][1] = (uint8_t)(i >> 8);
+    message_len[i] = len;
+}
+
+/**
+ * @brief printf のテキストの断片（0x00 を含まない）
+ */
+static uint32_t append_text(uint8_t *out, uint32_t *rng) {
+    static const char *const lines[] = {
+        "[LATENCY] Node 5: 88 frames\n", "Buffer: 8820/44100\r\n", "[LINK] target 60.0 ms\n",
+    };
+    const char *s = lines[test_rand(rng) % 3];
+    uint32_t n = (uint32_t)strlen(s);
+    memcpy(out, s, n);
+    return n;
+}
+
+typedef struct {
+    uint32_t received;       // 受信したメッセージ数
+    uint32_t in_order;       // 次に来るはずのメッセージと一致した数
+    uint32_t intact_missed;  // 壊れていないのに受信できなかったメッセージ
+    uint32_t false_accepts;  // 送ったどのメッセージとも一致しないのに受け入れた
+} decode_result_t;
+
+/**
+ * @brief バイト列をデコードし、送ったメッセージと順に突き合わせる
+ */
+static decode_result_t decode_stream(control_decoder_t *dec, const uint8_t *bytes, uint32_t n) {
+    decode_result_t res = { 0, 0, 0, 0 };
+    uint32_t next = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        const uint8_t *msg;
+        uint16_t len;
+        if (!control_decoder_feed(dec, bytes[i], &msg, &len)) continue;
+        res.received++;
+
+        // 次以降で最初に一致するメッセージ（それより前の壊れていないメッセージは取りこぼし）
+        uint32_t k = next;
+        while (k < NUM_MESSAGES && !(message_len[k] == len && memcmp(messages[k], msg, len) == 0)) {
+            k++;
+        }
+        if (k < NUM_MESSAGES) {
+            for (uint32_t j = next; j < k; j++) {
+                if (!corrupted[j]) res.intact_missed++;
+            }
+            res.in_order++;
+            next = k + 1;
+        } else {
+            res.false_accepts++;
+        }
+    }
+    for (uint32_t j = next; j < NUM_MESSAGES; j++) {
+        if (!corrupted[j]) res.intact_missed++;
+    }
+    return res;
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_crc(void) {
+    printf("CRC-16/CCITT-FALSE:\n");
+    const uint8_t check[] = "123456789";
+    uint16_t crc = control_crc16(check, 9);
+    printf("  check(\"123456789\") = 0x%04X\n", crc);
+    CHECK(crc == 0x29B1);
+    CHECK(control_crc16(check, 0) == 0xFFFF);
+}
+
+static void test_round_trip(void) {
+    printf("Round trip (%d messages of 2-%d bytes, 0-100%% zeros, text between frames):\n",
+           NUM_MESSAGES, CONTROL_FRAME_MAX_MSG);
+
+    uint32_t rng = 3;
+    uint32_t n = 0, max_encoded = 0, zeros_inside = 0, texts = 0;
+    for (uint32_t i = 0; i < NUM_MESSAGES; i++) {
+        make_message(i, &rng);
+        corrupted[i] = false;
+        if (test_rand(&rng) % 4 == 0) {
+            n += append_text(&stream[n], &rng);
+            texts++;
+        }
+
+        uint32_t e = control_frame_encode(messages[i], message_len[i], &stream[n]);
+        CHECK(e > 0 && e <= CONTROL_FRAME_MAX_ENCODED);
+        if (e > max_encoded) max_encoded = e;
+        // 区切りは先頭と末尾だけ
+        for (uint32_t k = 1; k + 1 < e; k++) {
+            if (stream[n + k] == 0x00) zeros_inside++;
+        }
+        CHECK(stream[n] == 0x00 && stream[n + e - 1] == 0x00);
+        n += e;
+    }
+
+    control_decoder_t dec;
+    control_decoder_init(&dec);
+    decode_result_t res = decode_stream(&dec, stream, n);
+    printf("  %lu bytes, %lu of %d received in order, longest frame %lu of %d bytes, "
+           "%lu text fragments dropped (crc %lu, framing %lu)\n",
+           n, res.in_order, NUM_MESSAGES, max_encoded, CONTROL_FRAME_MAX_ENCODED, texts,
+           dec.stats.crc_errors, dec.stats.framing_errors);
+    CHECK(zeros_inside == 0);
+    CHECK(res.in_order == NUM_MESSAGES);
+    CHECK(res.false_accepts == 0);
+    CHECK(dec.stats.frames == NUM_MESSAGES);
+    // テキストの断片は1つにつき1回だけ捨てられる（次のフレームを巻き込まない）
+    CHECK(dec.stats.crc_errors + dec.stats.framing_errors == texts && dec.stats.overflows == 0);
+
+    // 1バイトのメッセージ（最短）
+    static const uint8_t shortest[][1] = { { 0x00 }, { 0xFF } };
+    for (uint32_t i = 0; i < 2; i++) {
+        uint8_t frame[CONTROL_FRAME_MAX_ENCODED];
+        uint32_t e = control_frame_encode(shortest[i], 1, frame);
+        bool got = false;
+        for (uint32_t k = 0; k < e; k++) {
+            const uint8_t *msg;
+            uint16_t len;
+            if (control_decoder_feed(&dec, frame[k], &msg, &len)) {
+                got = (len == 1 && msg[0] == shortest[i][0]);
+            }
+        }
+        CHECK(got);
+    }
+
+    // 長すぎるメッセージはエンコードしない
+    static uint8_t big[CONTROL_FRAME_MAX_MSG + 1];
+    CHECK(control_frame_encode(big, sizeof(big), stream) == 0);
+}
+
+static void test_corruption(void) {
+    printf("Corruption (1 in 4 frames damaged):\n");
+
+    static const char *const kinds[] = {
+        "data bit flip", "any bit flip", "1-3 bit flips", "byte inserted", "byte deleted", "truncated",
+    };
+    uint32_t rng = 77;
+    uint32_t total_corrupted = 0, total_false = 0;
+
+    for (uint32_t kind = 0; kind < 6; kind++) {
+        uint32_t n = 0, damaged = 0;
+        for (uint32_t i = 0; i < NUM_MESSAGES; i++) {
+            make_message(i, &rng);
+            uint8_t frame[CONTROL_FRAME_MAX_ENCODED + 1];
+            uint32_t e = control_frame_encode(messages[i], message_len[i], frame);
+
+            corrupted[i] = (test_rand(&rng) % 4 == 0);
+            if (corrupted[i]) {
+                damaged++;
+                // 先頭と末尾の区切りは壊さない（区切りの破損は前後のフレームとの結合になる）
+                uint32_t pos = 1 + test_rand(&rng) % (e - 2);
+                switch (kind) {
+                case 0:
+                    // COBS のコードバイトでも 0x00 になる反転でもないデータバイト
+                    for (uint32_t tries = 0; tries < 64; tries++) {
+                        uint32_t bit = test_rand(&rng) % 8;
+                        uint32_t p = 1 + test_rand(&rng) % (e - 2);
+                        uint32_t c = 1;
+                        bool is_code = false;
+                        while (c < e - 1) {
+                            if (c == p) is_code = true;
+                            c += frame[c];
+                        }
+                        if (!is_code && (frame[p] ^ (1u << bit)) != 0) {
+                            frame[p] ^= (uint8_t)(1u << bit);
+                            break;
+                        }
+                    }
+                    break;
+                case 1:
+                    frame[pos] ^= (uint8_t)(1u << (test_rand(&rng) % 8));
+                    break;
+                case 2: {
+                    uint32_t flips = 1 + test_rand(&rng) % 3;
+                    for (uint32_t f = 0; f < flips; f++) {
+                        frame[1 + test_rand(&rng) % (e - 2)] ^= (uint8_t)(1u << (test_rand(&rng) % 8));
+                    }
+                    break;
+                }
+                case 3:
+                    memmove(&frame[pos + 1], &frame[pos], e - pos);
+                    frame[pos] = (uint8_t)(1 + test_rand(&rng) % 255);
+                    e++;
+                    break;
+                case 4:
+                    memmove(&frame[pos], &frame[pos + 1], e - pos - 1);
+                    e--;
+                    break;
+                default:
+                    // 途中で切れて次のフレームの区切りが来る
+                    e = pos;
+                    break;
+                }
+            }
+            memcpy(&stream[n], frame, e);
+            n += e;
+        }
+
+        control_decoder_t dec;
+        control_decoder_init(&dec);
+        decode_result_t res = decode_stream(&dec, stream, n);
+        printf("  %-14s: %5lu damaged, %lu intact missed, %lu false accepts "
+               "(crc %lu, framing %lu, overflow %lu)\n",
+               kinds[kind], damaged, res.intact_missed, res.false_accepts,
+               dec.stats.crc_errors, dec.stats.framing_errors, dec.stats.overflows);
+        CHECK(res.intact_missed == 0);
+        if (kind == 0) CHECK(res.false_accepts == 0);
+        total_corrupted += damaged;
+        total_false += res.false_accepts;
+    }
+
+    // CRC-16 の見逃しは 1/65536 程度（構造の壊れたフレームは COBS でも捨てられる）
+    double expected = total_corrupted / 65536.0;
+    printf("  total: %lu damaged frames, %lu false accepts (CRC-16 bound ~%.1f)\n",
+           total_corrupted, total_false, expected);
+    CHECK(total_false <= 3.0 * expected + 3.0);
+}
+
+static void test_garbage(void) {
+    printf("Random bytes and oversized frames:\n");
+
+    control_decoder_t dec;
+    control_decoder_init(&dec);
+    uint32_t rng = 12345;
+    uint32_t accepted = 0;
+    const uint32_t n = 2000000;
+    for (uint32_t i = 0; i < n; i++) {
+        // 0x00 を少なめにして長いフレームも作る
+        uint8_t b = (test_rand(&rng) % 64 == 0) ? 0x00 : (uint8_t)test_rand(&rng);
+        const uint8_t *msg;
+        uint16_t len;
+        if (control_decoder_feed(&dec, b, &msg, &len)) {
+            accepted++;
+            CHECK(len <= CONTROL_FRAME_MAX_MSG);
+            CHECK(msg == dec.buf);
+        }
+        CHECK(dec.len <= sizeof(dec.buf));
+    }
+    printf("  %lu random bytes: %lu accepted by chance, %lu crc, %lu framing, %lu overflow\n",
+           n, accepted, dec.stats.crc_errors, dec.stats.framing_errors, dec.stats.overflows);
+    CHECK(dec.stats.overflows > 0);
+
+    // 直後の正しいフレームは受信できる
+    const uint8_t hello[] = { 0x01, 0x00, 0x02, 0x00 };
+    uint8_t frame[CONTROL_FRAME_MAX_ENCODED];
+    uint32_t e = control_frame_encode(hello, sizeof(hello), frame);
+    bool got = false;
+    for (uint32_t i = 0; i < e; i++) {
+        const uint8_t *msg;
+        uint16_t len;
+        if (control_decoder_feed(&dec, frame[i], &msg, &len)) {
+            got = (len == sizeof(hello) && memcmp(msg, hello, len) == 0);
+        }
+    }
+    CHECK(got);
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    printf("Throughput (host):\n");
+
+    static const uint16_t sizes[] = { 8, CONTROL_FRAME_MAX_MSG };
+    for (uint32_t s = 0; s < 2; s++) {
+        uint16_t len = sizes[s];
+        uint32_t rng = 9;
+        uint8_t msg[CONTROL_FRAME_MAX_MSG];
+        for (uint16_t k = 0; k < len; k++) msg[k] = (uint8_t)test_rand(&rng);
+
+        uint8_t frame[CONTROL_FRAME_MAX_ENCODED];
+        uint32_t e = control_frame_encode(msg, len, frame);
+
+        const int reps = 200000;
+        uint64_t best_enc = UINT64_MAX, best_dec = UINT64_MAX;
+        for (int round = 0; round < 5; round++) {
+            uint64_t c0 = bench_cycles();
+            for (int r = 0; r < reps; r++) {
+                msg[0] = (uint8_t)r;
+                control_frame_encode(msg, len, frame);
+                bench_sink(frame, 1);
+            }
+            uint64_t c1 = bench_cycles();
+            control_decoder_t dec;
+            control_decoder_init(&dec);
+            for (int r = 0; r < reps; r++) {
+                for (uint32_t i = 0; i < e; i++) {
+                    const uint8_t *m;
+                    uint16_t l;
+                    control_decoder_feed(&dec, frame[i], &m, &l);
+                }
+            }
+            uint64_t c2 = bench_cycles();
+            bench_sink(&dec.stats, sizeof(dec.stats));
+            if (c1 - c0 < best_enc) best_enc = c1 - c0;
+            if (c2 - c1 < best_dec) best_dec = c2 - c1;
+        }
+        printf("  %2u-byte message (%lu bytes on the wire): encode %.1f, decode %.1f host cycles/byte\n",
+               len, e, (double)best_enc / reps / e, (double)best_dec / reps / e);
+    }
+    printf("  (the CRC uses a 16-entry nibble table: two lookups per byte)\n");
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_crc();
+    test_round_trip();
+    test_corruption();
+    test_garbage();
+    bench();
+    return test_summary("test_control_frame");
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_crossover.c
+ * @brief LR4 クロスオーバーのホストテスト（帯域の振幅特性、和のフラットさ）とベンチマーク
+ *
+ * crossover.c を取り込み、ドライ = 0、エフェクト出力 = 正弦波として帯域の重みを
+ * 1つだけ 1.0 にすると、その帯域だけの応答が出る（出力 = Σ 重み_b × 帯域_b）。
+ * - 各帯域がクロスオーバー周波数で -6 dB、1オクターブ/2オクターブ離れたところで LR4
+ *   （1 / (1 + (f/fc)^4)）どおりに減衰すること
+ * - 重みをすべて 1.0 にした和（= オールパス）が 20 Hz〜20 kHz でフラットなこと
+ * - ドライとエフェクト出力が同じなら、重みに関係なくフラットなこと
+ * を 2帯域 / 3帯域（config.h のエッジ）で確かめ、チャンネルあたりのフレームごとのコストを測る。
+ */
+
+#include "../src/crossover.c"
+#include "config.h"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#define FS          44100
+#define SETTLE      (FS / 2)
+#define MEASURE     FS
+#define AMPLITUDE   10000.0
+#define NUM_FREQS   31
+
+static int16_t dry[SETTLE + MEASURE];
+static int16_t mix[SETTLE + MEASURE];
+
+/**
+ * @brief 重みを与えて正弦波を通し、出力の振幅（dB、入力比）を返す
+ * @param dry_too true ならドライにも同じ正弦波を入れる
+ */
+static double response_db(crossover_t *xo, const int32_t *gains, double freq, bool dry_too) {
+    crossover_reset(xo);
+    crossover_set_band_gains(xo, gains);
+
+    const uint32_t n = SETTLE + MEASURE;
+    for (uint32_t i = 0; i < n; i++) {
+        int16_t s = (int16_t)lrint(AMPLITUDE * sin(2.0 * M_PI * freq * i / FS));
+        mix[i] = s;
+        dry[i] = dry_too ? s : 0;
+    }
+    for (uint32_t i = 0; i < n; i += 256) {
+        uint32_t len = (n - i < 256) ? n - i : 256;
+        crossover_process(xo, 0, &dry[i], &mix[i], len);
+    }
+
+    // ハン窓を掛けた1ビンの DFT
+    double re = 0.0, im = 0.0, wsum = 0.0;
+    for (uint32_t i = 0; i < MEASURE; i++) {
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / MEASURE);
+        double ph = 2.0 * M_PI * freq * (SETTLE + i) / FS;
+        re += w * mix[SETTLE + i] * cos(ph);
+        im += w * mix[SETTLE + i] * sin(ph);
+        wsum += w;
+    }
+    double amp = 2.0 * sqrt(re * re + im * im) / wsum;
+    return 20.0 * log10(amp / AMPLITUDE + 1e-12);
+}
+
+static double lr4_db(double f, double fc, bool high) {
+    double r = pow(f / fc, 4.0);
+    return 20.0 * log10(high ? r / (1.0 + r) : 1.0 / (1.0 + r));
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void check_flat(crossover_t *xo) {
+    const int32_t all[CROSSOVER_MAX_BANDS] = { CROSSOVER_UNITY_GAIN, CROSSOVER_UNITY_GAIN,
+                                               CROSSOVER_UNITY_GAIN };
+    const int32_t mixed[CROSSOVER_MAX_BANDS] = { 0, CROSSOVER_UNITY_GAIN / 2, CROSSOVER_UNITY_GAIN };
+
+    double worst_sum = 0.0, worst_same = 0.0;
+    for (int k = 0; k < NUM_FREQS; k++) {
+        double f = 20.0 * pow(1000.0, (double)k / (NUM_FREQS - 1));   // 20 Hz - 20 kHz
+        double sum = fabs(response_db(xo, all, f, false));
+        double same = fabs(response_db(xo, mixed, f, true));
+        if (sum > worst_sum) worst_sum = sum;
+        if (same > worst_same) worst_same = same;
+    }
+    printf("  sum of bands: max |deviation| %.4f dB; dry == effect with weights 0/0.5/1: %.4f dB\n",
+           worst_sum, worst_same);
+    CHECK(worst_sum < 0.01);
+    CHECK(worst_same < 0.01);
+}
+
+static void test_two_bands(void) {
+    const float edges[1] = { EFFECT_CROSSOVER_LOW_HZ };
+    const int32_t low[2] = { CROSSOVER_UNITY_GAIN, 0 };
+    const int32_t high[2] = { 0, CROSSOVER_UNITY_GAIN };
+    const double fc = edges[0];
+
+    printf("2 bands, LR4 at %.0f Hz:\n", fc);
+    static crossover_t xo;
+    crossover_init(&xo, 2, edges, FS);
+    static const double ratios[] = { 0.25, 0.5, 1.0, 2.0, 4.0 };
+    double worst = 0.0;
+    for (uint32_t i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++) {
+        double f = fc * ratios[i];
+        double l = response_db(&xo, low, f, false);
+        double h = response_db(&xo, high, f, false);
+        printf("  %6.0f Hz: low %7.2f dB (LR4 %7.2f), high %7.2f dB (LR4 %7.2f)\n",
+               f, l, lr4_db(f, fc, false), h, lr4_db(f, fc, true));
+        // 双一次変換の周波数の歪みは 800 Hz まででは 0.1 dB 未満
+        if (fabs(l - lr4_db(f, fc, false)) > worst) worst = fabs(l - lr4_db(f, fc, false));
+        if (fabs(h - lr4_db(f, fc, true)) > worst) worst = fabs(h - lr4_db(f, fc, true));
+    }
+    printf("  max deviation from analog LR4: %.3f dB\n", worst);
+    CHECK(worst < 0.5);
+    CHECK_NEAR(response_db(&xo, low, fc, false), -6.02, 0.1);
+    CHECK_NEAR(response_db(&xo, high, fc, false), -6.02, 0.1);
+
+    check_flat(&xo);
+}
+
+static void test_three_bands(void) {
+    const float edges[2] = { EFFECT_CROSSOVER_LOW_HZ, EFFECT_CROSSOVER_HIGH_HZ };
+    const int32_t low[3] = { CROSSOVER_UNITY_GAIN, 0, 0 };
+    const int32_t mid[3] = { 0, CROSSOVER_UNITY_GAIN, 0 };
+    const int32_t high[3] = { 0, 0, CROSSOVER_UNITY_GAIN };
+
+    printf("3 bands, LR4 at %.0f Hz / %.0f Hz:\n", edges[0], edges[1]);
+    static crossover_t xo;
+    crossover_init(&xo, 3, edges, FS);
+    double l_edge = response_db(&xo, low, edges[0], false);
+    double m_low = response_db(&xo, mid, edges[0], false);
+    double m_high = response_db(&xo, mid, edges[1], false);
+    double h_edge = response_db(&xo, high, edges[1], false);
+    double m_center = response_db(&xo, mid, sqrt((double)edges[0] * edges[1]), false);
+    printf("  at %.0f Hz: low %.2f, mid %.2f dB; at %.0f Hz: mid %.2f, high %.2f dB; mid center %.2f dB\n",
+           edges[0], l_edge, m_low, edges[1], m_high, h_edge, m_center);
+    CHECK_NEAR(l_edge, -6.02, 0.1);
+    CHECK_NEAR(h_edge, -6.02, 0.1);
+    // 中域はもう一方のエッジの影響が少し残る（1オクターブ以上離れているので 0.3 dB 以内）
+    CHECK_NEAR(m_low, -6.02, 0.3);
+    CHECK_NEAR(m_high, -6.02, 0.3);
+    CHECK(m_center > -0.5);
+
+    // 2オクターブ外側での減衰（LR4 で約 -48 dB）
+    double l_far = response_db(&xo, low, edges[0] * 4.0, false);
+    double h_far = response_db(&xo, high, edges[1] / 4.0, false);
+    printf("  two octaves out: low %.1f dB at %.0f Hz, high %.1f dB at %.0f Hz (LR4 %.1f)\n",
+           l_far, edges[0] * 4.0, h_far, edges[1] / 4.0, lr4_db(4.0, 1.0, false));
+    CHECK_NEAR(l_far, lr4_db(4.0, 1.0, false), 1.0);
+    CHECK_NEAR(h_far, lr4_db(4.0, 1.0, false), 1.5);
+
+    check_flat(&xo);
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    printf("crossover_process() cost per frame per channel (host, 256-frame chunks):\n");
+
+    static int16_t src[256], work[256], dry_in[256];
+    uint32_t rng = 11;
+    for (uint32_t i = 0; i < 256; i++) {
+        src[i] = (int16_t)(test_rand(&rng) >> 3);
+        dry_in[i] = (int16_t)(test_rand(&rng) >> 3);
+    }
+
+    for (uint8_t bands = 2; bands <= 3; bands++) {
+        const float edges[2] = { EFFECT_CROSSOVER_LOW_HZ, EFFECT_CROSSOVER_HIGH_HZ };
+        static crossover_t xo;
+        crossover_init(&xo, bands, edges, FS);
+        const int32_t gains[3] = { 0, CROSSOVER_UNITY_GAIN / 2, CROSSOVER_UNITY_GAIN };
+        crossover_set_band_gains(&xo, gains);
+
+        const int chunks = 20000;
+        uint64_t best = UINT64_MAX;
+        for (int round = 0; round < 5; round++) {
+            uint64_t c0 = bench_cycles();
+            for (int c = 0; c < chunks; c++) {
+                memcpy(work, src, sizeof(work));
+                crossover_process(&xo, 0, dry_in, work, 256);
+            }
+            uint64_t c1 = bench_cycles();
+            bench_sink(work, sizeof(work));
+            if (c1 - c0 < best) best = c1 - c0;
+        }
+        printf("  %u bands (%d biquads): %.1f host cycles/frame/channel\n",
+               bands, bands == 2 ? 3 : 7, (double)best / chunks / 256);
+    }
+    printf("  (target cycles: audio_effect_get_multiband_cycles() in the status log)\n");
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_two_bands();
+    test_three_bands();
+    bench();
+    return test_summary("test_crossover");
+}
@@ -0,0 +1,229 @@
+/**
+ * @file test_delay_report.c
+ * @brief A2DP 遅延レポートの遅延計算とヒステリシスのホストテスト（模擬したバッファ状態）
+ *
+ * - フレーム数 → 1/10 ms の換算（四捨五入、0xFFFF でクランプ）
+ * - 最初の更新は必ず報告し、以降はヒステリシスと最小間隔を満たした時だけ報告すること
+ * - BT のパケットが揺れて届き（時々まとめて届く）、DMA が 512 フレームずつ消費する
+ *   リングを 1 ms 刻みで模擬し、main.c と同じ間隔でサンプリングした時に
+ *   - パケット単位の揺れでは報告しない（平滑化なしと報告の数を比べる）
+ *   - 報告値が実際の平均遅延からヒステリシス以内
+ *   - 目標深さが 100 ms 増えた時に、報告が数秒以内に追従する
+ * ことを config.h の設定で確かめる。
+ */
+
+#include "delay_report.h"
+#include "config.h"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS               44100
+#define DMA_BLOCK        512      // audio_out_i2s の I2S_DMA_BUFFER_SIZE
+#define PACKET_FRAMES    640      // SBC 1パケット分（128 フレーム × 5）
+#define PIPELINE_FRAMES  88       // 処理チェーンの遅延（例: バスコンプレッサーの先読み）
+#define BASE_FILL        (AUDIO_BUFFER_SIZE / 5)   // 開始閾値（200 ms）
+#define HYSTERESIS       (DELAY_REPORT_HYSTERESIS_MS * 10)
+
+// ============================================================================
+// 換算
+// ============================================================================
+
+static void test_compute(void) {
+    printf("Frames to 1/10 ms:\n");
+
+    delay_report_state_t st = { 441, 0, 0 };
+    CHECK(delay_report_compute(&st, 44100) == 100);            // 10 ms ちょうど
+    st = (delay_report_state_t){ 8820, 1024, 88 };
+    CHECK(delay_report_compute(&st, 44100) == 2252);           // 9932 フレーム = 225.22 ms
+    st = (delay_report_state_t){ 2, 0, 0 };
+    CHECK(delay_report_compute(&st, 44100) == 0);              // 0.045 → 0
+    st = (delay_report_state_t){ 3, 0, 0 };
+    CHECK(delay_report_compute(&st, 44100) == 1);              // 0.068 → 0.1（四捨五入）
+    st = (delay_report_state_t){ 480, 0, 0 };
+    CHECK(delay_report_compute(&st, 48000) == 100);
+    st = (delay_report_state_t){ 44100 * 7, 0, 0 };
+    CHECK(delay_report_compute(&st, 44100) == 0xFFFF);         // 7 秒 → クランプ
+    st = (delay_report_state_t){ UINT32_MAX, UINT32_MAX, UINT32_MAX };
+    CHECK(delay_report_compute(&st, 44100) == 0xFFFF);         // 桁あふれしない
+    CHECK(delay_report_compute(&st, 0) == 0);
+    CHECK(delay_report_compute(NULL, 44100) == 0);
+
+    printf("  exact at 10 ms, rounds to nearest 0.1 ms, clamps at 0xFFFF\n");
+}
+
+// ============================================================================
+// ヒステリシスと最小間隔
+// ============================================================================
+
+static void test_hysteresis(void) {
+    printf("Hysteresis %u.%u ms, minimum interval %u ms (no smoothing):\n",
+           HYSTERESIS / 10, HYSTERESIS % 10, DELAY_REPORT_MIN_INTERVAL_MS);
+
+    delay_report_init(HYSTERESIS, DELAY_REPORT_MIN_INTERVAL_MS, 1);
+    delay_report_state_t st = { 4410, 0, 0 };   // 100 ms
+    uint16_t d = 0;
+
+    // 最初の更新は必ず報告
+    CHECK(delay_report_update(&st, FS, 0, &d) && d == 1000);
+    CHECK(delay_report_get_last_sent() == 1000);
+
+    // ヒステリシス未満の変化は、時間が経っても報告しない
+    st.ring_frames = 4410 + 441 * HYSTERESIS / 100 - 5;   // 1/10 ms に丸めて HYSTERESIS - 1
+    CHECK(!delay_report_update(&st, FS, 5000, &d));
+    CHECK(delay_report_get_current() == 1000 + HYSTERESIS - 1);
+
+    // ヒステリシス以上の変化でも最小間隔までは報告しない
+    delay_report_init(HYSTERESIS, DELAY_REPORT_MIN_INTERVAL_MS, 1);
+    st.ring_frames = 4410;
+    CHECK(delay_report_update(&st, FS, 100, &d));
+    st.ring_frames = 4410 + 441 * 3;   // +30 ms
+    CHECK(!delay_report_update(&st, FS, 100 + DELAY_REPORT_MIN_INTERVAL_MS - 1, &d));
+    CHECK(delay_report_update(&st, FS, 100 + DELAY_REPORT_MIN_INTERVAL_MS, &d) && d == 1300);
+
+    // 減る方向も同じ
+    st.ring_frames = 4410;
+    CHECK(delay_report_update(&st, FS, 100 + 2 * DELAY_REPORT_MIN_INTERVAL_MS, &d) && d == 1000);
+
+    // リセット後の最初の更新は変化がなくても報告
+    delay_report_reset();
+    CHECK(delay_report_get_last_sent() == 0);
+    CHECK(delay_report_update(&st, FS, 100 + 2 * DELAY_REPORT_MIN_INTERVAL_MS + 1, &d) && d == 1000);
+
+    printf("  first update reported, sub-hysteresis change and early change suppressed\n");
+}
+
+// ============================================================================
+// バッファ状態の模擬
+// ============================================================================
+
+typedef struct {
+    uint32_t reports;
+    uint32_t min_gap_ms;          // 報告の最短間隔
+    double mean_error_ms;         // 最後の報告と、その後の実際の平均遅延の差
+    int32_t settle_ms;            // 目標深さを変えてから、報告がヒステリシス以内に入るまで（-1 = 入らない）
+} sim_result_t;
+
+/**
+ * @brief リングを 1 ms 刻みで模擬し、DELAY_REPORT_SAMPLE_MS ごとに遅延を更新する
+ * @param smoothing 平滑化（指数移動平均の 1/N）
+ * @param step_at_ms この時刻に目標深さを 100 ms 増やす（0 = 増やさない）
+ */
+static sim_result_t simulate(uint32_t smoothing, uint32_t duration_ms, uint32_t step_at_ms) {
+    sim_result_t res = { 0, UINT32_MAX, 0.0, -1 };
+    delay_report_init(HYSTERESIS, DELAY_REPORT_MIN_INTERVAL_MS, smoothing);
+
+    uint32_t rng = 31;
+    double ring = BASE_FILL;
+    double dma_left = DMA_BLOCK;      // 転送中のバッファの残り
+    double extra_target = 0.0;        // 目標深さの増分（リングに少しずつ溜まる）
+    double next_nominal_ms = 0.0;     // 次のパケットが揺れなしで届く時刻
+    uint32_t gap_end_ms = 0;          // 途切れている間に遅れたパケットはここでまとめて届く
+    uint32_t last_report_ms = 0;
+    uint16_t last_value = 0;
+
+    double sum_true = 0.0;
+    uint32_t n_true = 0;
+
+    for (uint32_t t = 0; t < duration_ms; t++) {
+        if (step_at_ms && t == step_at_ms) {
+            extra_target = FS / 10;   // +100 ms
+        }
+
+        // BT の受信: 平均してパケット長ごとに ±4 ms 揺れて届く。
+        // 時々 60〜120 ms 途切れ、その間のパケットは途切れの終わりにまとめて届く
+        if (t >= gap_end_ms && test_rand(&rng) % 3000 == 0) {
+            gap_end_ms = t + 60 + test_rand(&rng) % 60;
+        }
+        while (t >= gap_end_ms) {
+            double jitter = ((double)(test_rand(&rng) % 1000) / 1000.0 - 0.5) * 8.0;
+            if ((double)t < next_nominal_ms + jitter) break;
+            ring += PACKET_FRAMES;
+            next_nominal_ms += PACKET_FRAMES * 1000.0 / FS;
+        }
+        // 目標深さを上げると、ソースは一時的に多めに送る（1秒かけて追いつく）
+        if (extra_target > 0.0) {
+            double add = FS / 10.0 / 1000.0;
+            ring += add;
+            extra_target -= add;
+        }
+
+        // DMA の消費（512 フレームのバッファを使い切るとリングから次を取る）
+        dma_left -= FS / 1000.0;
+        while (dma_left <= 0.0) {
+            dma_left += DMA_BLOCK;
+            ring -= DMA_BLOCK;
+            if (ring < 0.0) ring = 0.0;
+        }
+
+        uint32_t truth_frames = (uint32_t)ring + (uint32_t)dma_left + DMA_BLOCK + PIPELINE_FRAMES;
+        bool measuring = !step_at_ms || t >= step_at_ms + 3000;
+        if (t >= 5000 && measuring) {
+            sum_true += truth_frames * 1000.0 / FS;
+            n_true++;
+        }
+
+        if (t % DELAY_REPORT_SAMPLE_MS != 0) continue;
+
+        // main.c の update_delay_report() と同じ項
+        delay_report_state_t st = {
+            .ring_frames = (uint32_t)ring,
+            .dma_frames = (uint32_t)dma_left + DMA_BLOCK,
+            .pipeline_frames = PIPELINE_FRAMES,
+        };
+        uint16_t d;
+        if (delay_report_update(&st, FS, t, &d)) {
+            if (res.reports > 0 && t - last_report_ms < res.min_gap_ms) {
+                res.min_gap_ms = t - last_report_ms;
+            }
+            res.reports++;
+            last_report_ms = t;
+            last_value = d;
+        }
+
+        // 目標深さを変えた後、報告値が新しい平均（+100 ms）に入った時刻
+        if (step_at_ms && t > step_at_ms && res.settle_ms < 0 &&
+            last_value >= (BASE_FILL + FS / 10 + DMA_BLOCK + PIPELINE_FRAMES) * 10000.0 / FS - HYSTERESIS) {
+            res.settle_ms = (int32_t)(t - step_at_ms);
+        }
+    }
+
+    res.mean_error_ms = last_value / 10.0 - sum_true / n_true;
+    return res;
+}
+
+static void test_simulated_stream(void) {
+    printf("Simulated stream (%d-frame packets with jitter and gaps, %d-frame DMA blocks, sampled every %d ms):\n",
+           PACKET_FRAMES, DMA_BLOCK, DELAY_REPORT_SAMPLE_MS);
+
+    sim_result_t raw = simulate(1, 60000, 0);
+    sim_result_t smooth = simulate(DELAY_REPORT_SMOOTHING, 60000, 0);
+    printf("  60 s steady: %lu reports without smoothing, %lu with 1/%d smoothing "
+           "(last report %+.1f ms from the true mean)\n",
+           raw.reports, smooth.reports, DELAY_REPORT_SMOOTHING, smooth.mean_error_ms);
+    // 途切れ（平均 3 秒に1回）の後の 100 ms 前後の落ち込みは本当の変化なので報告は残るが、
+    // パケット単位の揺れでは報告しない
+    CHECK(smooth.reports * 4 <= raw.reports);
+    if (smooth.reports > 1) CHECK(smooth.min_gap_ms >= DELAY_REPORT_MIN_INTERVAL_MS);
+    CHECK(fabs(smooth.mean_error_ms) <= DELAY_REPORT_HYSTERESIS_MS);
+    if (raw.reports > 1) CHECK(raw.min_gap_ms >= DELAY_REPORT_MIN_INTERVAL_MS);
+
+    sim_result_t step = simulate(DELAY_REPORT_SMOOTHING, 30000, 10000);
+    printf("  +100 ms target at 10 s: reported within %u ms after %ld ms, %lu reports, "
+           "last report %+.1f ms from the true mean\n",
+           DELAY_REPORT_HYSTERESIS_MS, (long)step.settle_ms, step.reports, step.mean_error_ms);
+    CHECK(step.settle_ms >= 0 && step.settle_ms < 3000);
+    CHECK(fabs(step.mean_error_ms) <= DELAY_REPORT_HYSTERESIS_MS);
+    if (step.reports > 1) CHECK(step.min_gap_ms >= DELAY_REPORT_MIN_INTERVAL_MS);
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_compute();
+    test_hysteresis();
+    test_simulated_stream();
+    return test_summary("test_delay_report");
+}
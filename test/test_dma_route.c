@@ -0,0 +1,459 @@
+/**
+ * @file test_dma_route.c
+ * @brief DMA 割り込みディスパッチとオーディオルーティングのホストテスト
+ *
+ * 偽の DMA 出力（リング + ピンポン転送）を3つ登録し、メインループ側の
+ * audio_route_process() と DMA 完了をランダムに入れ違わせて、
+ *   - 完了1回につきハンドラーがちょうど1回呼ばれる（同時完了、ハンドラー中の完了を含む）
+ *   - 1回のディスパッチ内ではチャンネル番号の小さい順に呼ばれる
+ *   - 各出力が再生したフレームは接続したタップの列の順どおりで、抜けはドロップ数と一致する
+ *   - 登録せずに IRQ0 を有効にしたチャンネルのフラグはクリアされ、割り込みが鳴り続けない
+ * を確かめる。ルーティングの個別の動作（ゼロコピー、タップ切り替え、遅延補償）も検証する。
+ */
+
+#include "dma_irq.h"
+#include "audio_route.h"
+#include "latency.h"
+#include "config.h"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/irq.h"
+
+#include <string.h>
+
+#define NUM_FAKE        3
+#define FAKE_RING       1024     // フレーム（2のべき）
+#define FAKE_BLOCK      64       // 1回の DMA 転送で送るフレーム数
+#define MAX_BLOCK       300      // 1回の audio_route_process のフレーム数の上限
+#define TAP_MARK_PRE    1000
+#define TAP_MARK_POST   (-1000)
+
+// ============================================================================
+// 偽の DMA 出力
+// ============================================================================
+
+typedef struct {
+    int ch;
+    audio_tap_t tap;
+    int route_id;
+
+    // リング（書き込みはメインループ、読み出しは DMA ハンドラー）
+    int16_t ring_l[FAKE_RING];
+    int16_t ring_r[FAKE_RING];
+    uint32_t wr;
+    uint32_t rd;
+
+    // 再生したフレームの検査
+    uint32_t played;
+    uint32_t underrun_blocks;
+    uint32_t gaps;           // 通し番号の抜け（ドロップされたフレーム）
+    int32_t last_index;
+    uint32_t order_errors;
+
+    // DMA
+    uint32_t completions;    // 起こした完了の数
+    uint32_t handled;        // ハンドラーが呼ばれた数
+    bool restart_completes;  // 次のハンドラーで再起動した転送がすぐ完了する
+    int chain_to;            // 次のハンドラー中に完了させる別の出力（-1 = なし）
+} fake_out_t;
+
+static fake_out_t fakes[NUM_FAKE];
+static int16_t dma_dummy[FAKE_BLOCK * 2];
+
+// ディスパッチの通し番号と、その中で最後に呼ばれたチャンネル
+static uint32_t dispatch_seq = 0;
+static uint32_t log_seq = UINT32_MAX;
+static int log_last_ch = -1;
+static uint32_t dispatch_order_errors = 0;
+
+/**
+ * @brief 通し番号 index のフレームを作る（L = 番号、R = タップの印）
+ */
+static void encode_frame(audio_tap_t tap, uint32_t index, int16_t *l, int16_t *r) {
+    *l = (int16_t)(index & 0x7FFF);
+    *r = (tap == AUDIO_TAP_PRE_EFFECT) ? TAP_MARK_PRE : TAP_MARK_POST;
+}
+
+static void complete(fake_out_t *f) {
+    if (!host_dma[f->ch].busy) return;
+    f->completions++;
+    host_dma_complete((uint)f->ch);
+}
+
+static uint32_t fake_write(fake_out_t *f, const int16_t *left, const int16_t *right, uint32_t n) {
+    uint32_t space = FAKE_RING - (f->wr - f->rd);
+    if (n > space) n = space;
+    for (uint32_t i = 0; i < n; i++) {
+        f->ring_l[(f->wr + i) & (FAKE_RING - 1)] = left[i];
+        f->ring_r[(f->wr + i) & (FAKE_RING - 1)] = right[i];
+    }
+    f->wr += n;
+    return n;
+}
+
+static void fake_handler(fake_out_t *f) {
+    f->handled++;
+
+    // 1回のディスパッチの中ではチャンネルの小さい順
+    if (log_seq == dispatch_seq && f->ch <= log_last_ch) {
+        dispatch_order_errors++;
+    }
+    log_seq = dispatch_seq;
+    log_last_ch = f->ch;
+
+    // 1ブロック分を再生する（足りなければアンダーラン）
+    uint32_t avail = f->wr - f->rd;
+    if (avail < FAKE_BLOCK) {
+        f->underrun_blocks++;
+    } else {
+        for (uint32_t i = 0; i < FAKE_BLOCK; i++) {
+            uint32_t pos = (f->rd + i) & (FAKE_RING - 1);
+            int16_t mark = (f->tap == AUDIO_TAP_PRE_EFFECT) ? TAP_MARK_PRE : TAP_MARK_POST;
+            if (f->ring_r[pos] != mark) f->order_errors++;
+
+            int32_t index = f->ring_l[pos];
+            if (f->last_index >= 0) {
+                uint32_t step = (uint32_t)(index - f->last_index) & 0x7FFF;
+                if (step == 0) f->order_errors++;   // 重複
+                f->gaps += step - 1;
+            }
+            f->last_index = index;
+        }
+        f->rd += FAKE_BLOCK;
+        f->played += FAKE_BLOCK;
+    }
+
+    // 次の転送を起動
+    dma_channel_set_read_addr((uint)f->ch, dma_dummy, true);
+
+    if (f->restart_completes) {
+        f->restart_completes = false;
+        complete(f);
+    }
+    if (f->chain_to >= 0) {
+        complete(&fakes[f->chain_to]);
+        f->chain_to = -1;
+    }
+}
+
+static uint32_t fake_write_0(const int16_t *l, const int16_t *r, uint32_t n) { return fake_write(&fakes[0], l, r, n); }
+static uint32_t fake_write_1(const int16_t *l, const int16_t *r, uint32_t n) { return fake_write(&fakes[1], l, r, n); }
+static uint32_t fake_write_2(const int16_t *l, const int16_t *r, uint32_t n) { return fake_write(&fakes[2], l, r, n); }
+static void fake_handler_0(void) { fake_handler(&fakes[0]); }
+static void fake_handler_1(void) { fake_handler(&fakes[1]); }
+static void fake_handler_2(void) { fake_handler(&fakes[2]); }
+
+static const audio_route_write_t fake_writes[NUM_FAKE] = { fake_write_0, fake_write_1, fake_write_2 };
+static const dma_irq_handler_t fake_handlers[NUM_FAKE] = { fake_handler_0, fake_handler_1, fake_handler_2 };
+
+/**
+ * @brief DMA_IRQ_0 を処理する（1回のハンドラー呼び出し = 1回のディスパッチ）
+ */
+static uint32_t service_irq(void) {
+    uint32_t calls = 0;
+    while (host_irq_service(DMA_IRQ_0, 1)) {
+        dispatch_seq++;
+        if (++calls > 64) break;   // 割り込みが止まらない
+    }
+    return calls;
+}
+
+// ============================================================================
+// 記録用の出力（DMA なし）
+// ============================================================================
+
+static const int16_t *capture_ptr_l;
+static const int16_t *capture_ptr_r;
+static int16_t capture_l[4096];
+static int16_t capture_r[4096];
+static uint32_t capture_count = 0;
+static uint32_t capture_limit = UINT32_MAX;   // 1回に受け取るフレーム数の上限
+
+static uint32_t capture_write(const int16_t *left, const int16_t *right, uint32_t n) {
+    capture_ptr_l = left;
+    capture_ptr_r = right;
+    if (n > capture_limit) n = capture_limit;
+    for (uint32_t i = 0; i < n && capture_count < 4096; i++) {
+        capture_l[capture_count] = left[i];
+        capture_r[capture_count] = right[i];
+        capture_count++;
+    }
+    return n;
+}
+
+static int capture_id = -1;
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_register(void) {
+    printf("Registration:\n");
+
+    static const audio_tap_t taps[NUM_FAKE] = {
+        AUDIO_TAP_PRE_EFFECT, AUDIO_TAP_POST_EFFECT, AUDIO_TAP_POST_EFFECT,
+    };
+    static const char *const names[NUM_FAKE] = { "fake-cue", "fake-main", "fake-rec" };
+
+    for (int i = 0; i < NUM_FAKE; i++) {
+        fake_out_t *f = &fakes[i];
+        memset(f, 0, sizeof(*f));
+        f->ch = dma_claim_unused_channel(true);
+        f->tap = taps[i];
+        f->last_index = -1;
+        f->chain_to = -1;
+        CHECK(dma_irq_register(f->ch, fake_handlers[i]));
+        f->route_id = audio_route_add_output(names[i], fake_writes[i], taps[i]);
+        CHECK(f->route_id == i);
+    }
+    capture_id = audio_route_add_output("capture", capture_write, AUDIO_TAP_NONE);
+    CHECK(capture_id == NUM_FAKE);
+
+    // 登録の失敗
+    CHECK(!dma_irq_register(fakes[0].ch, fake_handler_1));     // 登録済み
+    CHECK(!dma_irq_register(-1, fake_handler_1));
+    CHECK(!dma_irq_register(NUM_DMA_CHANNELS, fake_handler_1));
+    CHECK(!dma_irq_register(15, NULL));
+    CHECK(audio_route_add_output("overflow", capture_write, AUDIO_TAP_POST_EFFECT) < 0);
+    CHECK(audio_route_add_output("null", NULL, AUDIO_TAP_POST_EFFECT) < 0);
+
+    // 範囲外のタップはミュート扱い
+    audio_route_set_tap(capture_id, (audio_tap_t)7);
+    CHECK(audio_route_get_tap(capture_id) == AUDIO_TAP_NONE);
+    CHECK(audio_route_get_tap(99) == AUDIO_TAP_NONE);
+}
+
+static void test_dispatch_order(void) {
+    printf("Dispatch:\n");
+
+    for (int i = 0; i < NUM_FAKE; i++) {
+        dma_channel_set_read_addr((uint)fakes[i].ch, dma_dummy, true);
+    }
+
+    // 同時完了: 逆順に完了させても1回のディスパッチで小さい順に処理される
+    uint32_t before[NUM_FAKE];
+    for (int i = 0; i < NUM_FAKE; i++) before[i] = fakes[i].handled;
+    for (int i = NUM_FAKE - 1; i >= 0; i--) complete(&fakes[i]);
+    uint32_t errors_before = dispatch_order_errors;
+    uint32_t seq_before = dispatch_seq;
+    service_irq();
+    CHECK(dispatch_seq - seq_before == 1);
+    CHECK(dispatch_order_errors == errors_before);
+    for (int i = 0; i < NUM_FAKE; i++) CHECK(fakes[i].handled == before[i] + 1);
+    CHECK(dma_hw->ints0 == 0);
+
+    // ハンドラー中に同じチャンネルが再び完了: フラグは先にクリア済みなので取りこぼさない
+    fakes[0].restart_completes = true;
+    complete(&fakes[0]);
+    seq_before = dispatch_seq;
+    service_irq();
+    CHECK(fakes[0].handled == before[0] + 3);
+    CHECK(dispatch_seq - seq_before == 2);
+    CHECK(dma_hw->ints0 == 0);
+
+    // ハンドラー中に別のチャンネルが完了: 処理済みのビットだけがクリアされ、次の割り込みで処理される
+    fakes[1].chain_to = 2;
+    fakes[0].chain_to = 1;
+    complete(&fakes[0]);
+    service_irq();
+    CHECK(fakes[0].handled == before[0] + 4);
+    CHECK(fakes[1].handled == before[1] + 2);
+    CHECK(fakes[2].handled == before[2] + 2);
+    CHECK(dma_hw->ints0 == 0);
+
+    // 登録解除したチャンネルの完了は割り込みにならない
+    dma_irq_unregister(fakes[2].ch);
+    complete(&fakes[2]);
+    CHECK(service_irq() == 0);
+    CHECK(fakes[2].handled == before[2] + 2);
+    fakes[2].completions--;   // 数えない
+    CHECK(dma_irq_register(fakes[2].ch, fake_handler_2));
+    dma_channel_set_read_addr((uint)fakes[2].ch, dma_dummy, true);
+
+    // 登録せずに IRQ0 を有効にしたチャンネル: フラグをクリアして数えるだけ（ハンドラーは呼ばない）
+    int foreign = dma_claim_unused_channel(true);
+    dma_channel_set_irq0_enabled((uint)foreign, true);
+    dma_channel_set_read_addr((uint)foreign, dma_dummy, true);
+    uint32_t stray_before = dma_irq_get_stray_count();
+    host_dma_complete((uint)foreign);
+    complete(&fakes[1]);
+    CHECK(service_irq() == 1);
+    CHECK(dma_hw->ints0 == 0);
+    CHECK(dma_irq_get_stray_count() - stray_before == 1);
+    CHECK(fakes[1].handled == before[1] + 3);
+    printf("  foreign ch %d: %u stray flags cleared\n", foreign, dma_irq_get_stray_count() - stray_before);
+    dma_channel_set_irq0_enabled((uint)foreign, false);
+    dma_channel_unclaim((uint)foreign);
+
+    for (int i = 0; i < NUM_FAKE; i++) {
+        printf("  ch %d: %u completions, %u handler calls\n",
+               fakes[i].ch, fakes[i].completions, fakes[i].handled);
+        CHECK(fakes[i].handled == fakes[i].completions);
+    }
+}
+
+static void test_interleaving(void) {
+    printf("Interleaving (random completions vs. audio_route_process):\n");
+
+    uint32_t rng = 0xC0FFEE;
+    uint32_t produced = 0;
+    int16_t pre_l[MAX_BLOCK], pre_r[MAX_BLOCK];
+    int16_t post_l[MAX_BLOCK], post_r[MAX_BLOCK];
+    uint32_t simultaneous = 0;
+    uint32_t nested = 0;
+
+    // ここまでの再生は数えない
+    for (int i = 0; i < NUM_FAKE; i++) {
+        fakes[i].rd = fakes[i].wr;
+        fakes[i].played = 0;
+        fakes[i].underrun_blocks = 0;
+        fakes[i].last_index = -1;
+        fakes[i].gaps = 0;
+    }
+    uint32_t dropped_before[NUM_FAKE];
+    for (int i = 0; i < NUM_FAKE; i++) dropped_before[i] = audio_route_get_dropped(fakes[i].route_id);
+
+    for (int step = 0; step < 200000; step++) {
+        uint32_t r = test_rand(&rng);
+
+        // 生成が消費より多い区間と少ない区間を交互に（ドロップとアンダーランの両方を起こす）
+        uint32_t produce_odds = ((step / 5000) & 1) ? 2 : 1;
+        if ((r & 7) < produce_odds) {
+            // メインループ: 処理チェーンの順にタップを呼ぶ
+            uint32_t n = 1 + (r >> 8) % MAX_BLOCK;
+            for (uint32_t i = 0; i < n; i++) {
+                encode_frame(AUDIO_TAP_PRE_EFFECT, produced + i, &pre_l[i], &pre_r[i]);
+                encode_frame(AUDIO_TAP_POST_EFFECT, produced + i, &post_l[i], &post_r[i]);
+            }
+            audio_route_process(AUDIO_TAP_PRE_EFFECT, pre_l, pre_r, n);
+            audio_route_process(AUDIO_TAP_POST_EFFECT, post_l, post_r, n);
+            produced += n;
+            continue;
+        }
+
+        // DMA: 動いているチャンネルをランダムに完了させる（割り込みを待たせて同時完了も作る）
+        uint32_t count = 0;
+        for (int i = 0; i < NUM_FAKE; i++) {
+            uint32_t bits = r >> (8 + i * 4);
+            if (bits & 1) {
+                if (host_dma[fakes[i].ch].busy) count++;
+                complete(&fakes[i]);
+            }
+            if ((bits & 0xE) == 0xE) {
+                fakes[i].restart_completes = true;
+                nested++;
+            } else if ((bits & 0xE) == 0xC) {
+                fakes[i].chain_to = (i + 1 + (int)((r >> 24) & 1)) % NUM_FAKE;
+                nested++;
+            }
+        }
+        if (count > 1) simultaneous++;
+        if ((r >> 28) < 11) service_irq();
+    }
+    service_irq();
+
+    printf("  %u frames produced, %u dispatches, %u simultaneous completions, %u nested\n",
+           produced, dispatch_seq, simultaneous, nested);
+    CHECK(dispatch_order_errors == 0);
+    CHECK(dma_hw->ints0 == 0);
+
+    for (int i = 0; i < NUM_FAKE; i++) {
+        fake_out_t *f = &fakes[i];
+        uint32_t dropped = audio_route_get_dropped(f->route_id) - dropped_before[i];
+        uint32_t queued = f->wr - f->rd;
+        printf("  ch %d (%s): %u completions, %u handled, %u played, %u queued, %u dropped, %u underruns\n",
+               f->ch, f->tap == AUDIO_TAP_PRE_EFFECT ? "pre" : "post",
+               f->completions, f->handled, f->played, queued, dropped, f->underrun_blocks);
+
+        // 完了1回につきハンドラー1回
+        CHECK(f->handled == f->completions);
+        // 再生した列はタップの列の順どおりで、抜けはドロップしたフレームだけ
+        CHECK(f->order_errors == 0);
+        CHECK(f->gaps <= dropped);
+        CHECK(f->played + queued + dropped == produced);
+        // 転送は毎回再起動されている
+        CHECK(host_dma[f->ch].busy);
+    }
+}
+
+static void test_routing(void) {
+    printf("Routing:\n");
+
+    // 記録用の出力だけを残す
+    for (int i = 0; i < NUM_FAKE; i++) audio_route_set_tap(fakes[i].route_id, AUDIO_TAP_NONE);
+
+    int16_t in_l[MAX_BLOCK], in_r[MAX_BLOCK];
+    for (uint32_t i = 0; i < MAX_BLOCK; i++) encode_frame(AUDIO_TAP_PRE_EFFECT, i, &in_l[i], &in_r[i]);
+
+    // 未接続のタップは何もしない
+    capture_count = 0;
+    CHECK(audio_route_process(AUDIO_TAP_PRE_EFFECT, in_l, in_r, 64) == 0);
+    CHECK(capture_count == 0);
+
+    // 補償なし: タップのバッファをそのまま渡す（コピーしない）
+    audio_route_set_tap(capture_id, AUDIO_TAP_PRE_EFFECT);
+    CHECK(audio_route_process(AUDIO_TAP_PRE_EFFECT, in_l, in_r, 64) == 0);
+    CHECK(capture_ptr_l == in_l && capture_ptr_r == in_r);
+    CHECK(capture_count == 64);
+    CHECK(audio_route_process(AUDIO_TAP_POST_EFFECT, in_l, in_r, 64) == 0);
+    CHECK(capture_count == 64);
+
+    // ドロップの計上
+    uint32_t dropped_before = audio_route_get_dropped(capture_id);
+    capture_limit = 40;
+    CHECK(audio_route_process(AUDIO_TAP_PRE_EFFECT, in_l, in_r, 64) == 24);
+    CHECK(audio_route_get_dropped(capture_id) - dropped_before == 24);
+    capture_limit = UINT32_MAX;
+
+    // 遅延補償: エフェクトの遅延分だけエフェクト前タップを遅らせる（ブロックの大きさによらない）
+    latency_init();
+    latency_declare(LATENCY_NODE_EFFECT, 100);
+    CHECK(latency_get_compensation(AUDIO_TAP_PRE_EFFECT) == 100);
+    CHECK(latency_get_compensation(AUDIO_TAP_POST_EFFECT) == 0);
+
+    capture_count = 0;
+    static const uint32_t sizes[] = { 37, 300, 1, 128, 129, 255 };
+    uint32_t index = 0;
+    for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (uint32_t i = 0; i < sizes[s]; i++) {
+            encode_frame(AUDIO_TAP_PRE_EFFECT, index + 1 + i, &in_l[i], &in_r[i]);
+        }
+        CHECK(audio_route_process(AUDIO_TAP_PRE_EFFECT, in_l, in_r, sizes[s]) == 0);
+        CHECK(capture_ptr_l != in_l);
+        index += sizes[s];
+    }
+    CHECK(capture_count == index);
+    uint32_t misaligned = 0;
+    for (uint32_t i = 0; i < capture_count; i++) {
+        int16_t l, r;
+        if (i < 100) {
+            l = 0;
+            r = 0;
+        } else {
+            encode_frame(AUDIO_TAP_PRE_EFFECT, i - 100 + 1, &l, &r);
+        }
+        if (capture_l[i] != l || capture_r[i] != r) misaligned++;
+    }
+    printf("  pre-effect tap, 100 frames compensation: %u frames, %u misaligned\n",
+           capture_count, misaligned);
+    CHECK(misaligned == 0);
+
+    // 補償ありでのドロップ（チャンクごとに数える）
+    dropped_before = audio_route_get_dropped(capture_id);
+    capture_limit = 100;
+    CHECK(audio_route_process(AUDIO_TAP_PRE_EFFECT, in_l, in_r, 300) == 28 + 28);
+    CHECK(audio_route_get_dropped(capture_id) - dropped_before == 56);
+    capture_limit = UINT32_MAX;
+}
+
+int main(void) {
+    host_sdk_reset();
+    latency_init();
+
+    test_register();
+    test_dispatch_order();
+    test_interleaving();
+    test_routing();
+    return test_summary("test_dma_route");
+}
@@ -0,0 +1,397 @@
+/**
+ * @file test_effect_kernels.c
+ * @brief Beat-Repeat の特殊化カーネルと汎用パスの一致テストとベンチマーク
+ *
+ * audio_effect.c を特殊化カーネル（EFFECT_SPECIALISED_KERNELS = 1）で取り込み、
+ * 汎用パスでビルドしたもの（effect_generic.c、関数名 generic_*）と同じ入力を流して
+ * 出力をビット単位で比べる。
+ *   - (ピッチモード × 逆再生 × ウィンドウ × フリーズ × ダッキング) の 64 通り
+ *   - スライス長: 整数、小数部あり、クロック分周で半端になるもの
+ *   - ブロック長はランダム（チャンク 256 をまたぐ長さを含む）、フリーズは途中で掛けて外す
+ * スライスの境界が 10 分間テンポのグリッド（k 番目の境界 = floor(k × スライス長)）から
+ * ずれないことを、半端な BPM の16分音符で確かめる。
+ * スライスバッファをルーパーに貸している間は、エフェクトを有効にしても素通りで
+ * バッファに触れず、返した後は元どおり動くことを確かめる。
+ * あわせて、常にリピートしている状態で両方のフレームあたりのコストを測る。
+ * カーネル表のコードサイズは tools/code_size.py（ctest の test_effect_kernels_size）で見る。
+ */
+
+#include "../src/audio_effect.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+// 汎用パス（effect_generic.c）
+bool generic_effect_init(uint32_t sample_rate);
+void generic_effect_update_params(const beat_repeat_params_t *params);
+void generic_effect_get_params(beat_repeat_params_t *params);
+void generic_effect_process(int16_t *left, int16_t *right, uint32_t num_samples);
+void generic_effect_reset(void);
+
+#define FS          44100
+#define MAX_BLOCK   1024
+#define RUN_FRAMES  (FS * 2)
+
+// ============================================================================
+// 入力信号（ドラム風のノイズバースト + 正弦波、フレーム位置だけで決まる）
+// ============================================================================
+
+static void render_input(uint32_t pos, int16_t *l, int16_t *r, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t t = pos + i;
+        uint32_t since_hit = t % 5513;
+        uint32_t h = t * 2654435761u;
+        double burst = (since_hit < 2000) ? exp(-(double)since_hit / 400.0) : 0.0;
+        double noise = ((double)(h >> 16) / 32768.0 - 1.0) * 20000.0 * burst;
+        double tone = 6000.0 * sin(2.0 * M_PI * 220.0 * t / FS);
+        l[i] = (int16_t)lrint(noise + tone);
+        r[i] = (int16_t)lrint(noise * 0.7 - tone);
+    }
+}
+
+// ============================================================================
+// パラメータ
+// ============================================================================
+
+typedef struct {
+    uint32_t slice_length;
+    double frac;
+    uint8_t clock_divider;
+} slice_case_t;
+
+static const slice_case_t slice_cases[] = {
+    { 2205, 0.0, 1 },      // 整数
+    { 1837, 0.6, 1 },      // 小数部あり（境界ごとに繰り上がりで長さが変わる）
+    { 2001, 0.0, 2 },      // 分周で 1000.5
+};
+#define NUM_SLICE_CASES (sizeof(slice_cases) / sizeof(slice_cases[0]))
+
+static beat_repeat_params_t make_params(int mode, int rev, int win, int duck,
+                                        const slice_case_t *sc, float probability) {
+    beat_repeat_params_t p;
+    audio_effect_get_params(&p);
+    p.enabled = true;
+    p.slice_length = sc->slice_length;
+    p.slice_length_frac = (uint32_t)(sc->frac * 4294967296.0);
+    p.clock_divider = sc->clock_divider;
+    p.repeat_count = 3;
+    p.wet_mix = 70;
+    p.pitch_mode = (pitch_mode_t)mode;
+    p.reverse = rev;
+    p.window_shape = win ? 0.2f : 0.0f;
+    p.freeze = false;
+    p.duck_enabled = duck;
+    p.loop_start = 0.1f;
+    p.loop_size_decay = 0.3f;
+    p.slice_probability = probability;
+    p.stutter_enabled = false;
+    p.slicer_enabled = false;
+    p.multiband_enabled = false;
+    p.repeat_trigger = REPEAT_TRIGGER_PROBABILITY;
+    return p;
+}
+
+// ============================================================================
+// 一致テスト
+// ============================================================================
+
+static void test_equivalence(void) {
+    printf("Specialised kernels vs. generic path (64 combinations x %u slice lengths):\n",
+           (unsigned)NUM_SLICE_CASES);
+
+    static int16_t in_l[MAX_BLOCK], in_r[MAX_BLOCK];
+    static int16_t sl[MAX_BLOCK], sr[MAX_BLOCK], gl[MAX_BLOCK], gr[MAX_BLOCK];
+    uint32_t mismatched_runs = 0;
+    uint64_t frames_total = 0;
+
+    for (uint32_t c = 0; c < NUM_SLICE_CASES; c++) {
+        for (int combo = 0; combo < 64; combo++) {
+            int mode = combo >> 4, rev = (combo >> 3) & 1, win = (combo >> 2) & 1;
+            int frz = (combo >> 1) & 1, duck = combo & 1;
+
+            beat_repeat_params_t p = make_params(mode, rev, win, duck, &slice_cases[c], 0.7f);
+            audio_effect_reset();
+            generic_effect_reset();
+            audio_effect_update_params(&p);
+            generic_effect_update_params(&p);
+
+            uint32_t rng = 1000u + (uint32_t)combo * 7u + c;
+            uint32_t pos = 0;
+            uint32_t mismatches = 0;
+            uint32_t first = 0;
+            bool frozen = false;
+
+            while (pos < RUN_FRAMES) {
+                // フリーズを 30% で掛け、70% で外す
+                bool want_frozen = frz && pos >= RUN_FRAMES * 3 / 10 && pos < RUN_FRAMES * 7 / 10;
+                if (want_frozen != frozen) {
+                    frozen = want_frozen;
+                    p.freeze = frozen;
+                    audio_effect_update_params(&p);
+                    generic_effect_update_params(&p);
+                }
+
+                uint32_t n = 1 + test_rand(&rng) % MAX_BLOCK;
+                if (n > RUN_FRAMES - pos) n = RUN_FRAMES - pos;
+                render_input(pos, in_l, in_r, n);
+                memcpy(sl, in_l, n * sizeof(int16_t));
+                memcpy(sr, in_r, n * sizeof(int16_t));
+                memcpy(gl, in_l, n * sizeof(int16_t));
+                memcpy(gr, in_r, n * sizeof(int16_t));
+
+                audio_effect_process(sl, sr, n);
+                generic_effect_process(gl, gr, n);
+
+                for (uint32_t i = 0; i < n; i++) {
+                    if (sl[i] != gl[i] || sr[i] != gr[i]) {
+                        if (mismatches++ == 0) first = pos + i;
+                    }
+                }
+                pos += n;
+            }
+            frames_total += pos;
+
+            if (mismatches) {
+                mismatched_runs++;
+                if (mismatched_runs <= 5) {
+                    printf("  slice %u+%.2f /%u, mode %d rev %d win %d frz %d duck %d: "
+                           "%u frames differ (first at %u)\n",
+                           slice_cases[c].slice_length, slice_cases[c].frac, slice_cases[c].clock_divider,
+                           mode, rev, win, frz, duck, mismatches, first);
+                }
+            }
+        }
+    }
+    printf("  %u runs, %llu frames each path, %u runs with differences\n",
+           (unsigned)(NUM_SLICE_CASES * 64), (unsigned long long)frames_total, mismatched_runs);
+    CHECK(mismatched_runs == 0);
+}
+
+// ============================================================================
+// テンポのグリッド
+// ============================================================================
+
+static void test_grid_drift(void) {
+    printf("Slice grid over 10 minutes (16th notes, random blocks, repeating, vs. generic):\n");
+
+    static const double bpms[] = { 93.7, 127.3, 174.2 };
+    static const uint8_t dividers[] = { 1, 1, 2 };
+    static int16_t l[MAX_BLOCK], r[MAX_BLOCK], gl[MAX_BLOCK], gr[MAX_BLOCK];
+    static int16_t loop_l[FS + MAX_BLOCK], loop_r[FS + MAX_BLOCK];
+    const uint64_t total = (uint64_t)FS * 600;
+
+    // 入力は1秒分を繰り返す（位置の計算はフレーム数だけで決まる）
+    render_input(0, loop_l, loop_r, FS + MAX_BLOCK);
+
+    for (unsigned b = 0; b < sizeof(bpms) / sizeof(bpms[0]); b++) {
+        // 16分音符（分周前）を 32.32 で
+        double frames = 60.0 * FS / bpms[b] / 4.0 * dividers[b];
+        uint64_t q32 = (uint64_t)llround(frames * 4294967296.0);
+        slice_case_t sc = { (uint32_t)(q32 >> 32), (double)(uint32_t)q32 / 4294967296.0, dividers[b] };
+
+        beat_repeat_params_t p = make_params(PITCH_MODE_DECREASING, 0, 1, 0, &sc, 1.0f);
+        audio_effect_reset();
+        generic_effect_reset();
+        audio_effect_update_params(&p);
+        generic_effect_update_params(&p);
+        uint64_t step_q32 = get_slice_length_q32();
+
+        uint32_t rng = 42 + b;
+        uint64_t pos = 0;
+        uint64_t k = 0;
+        int64_t worst = 0;
+        uint64_t mismatches = 0;
+        while (pos < total) {
+            uint32_t n = 1 + test_rand(&rng) % MAX_BLOCK;
+            memcpy(l, &loop_l[pos % FS], n * sizeof(int16_t));
+            memcpy(r, &loop_r[pos % FS], n * sizeof(int16_t));
+            memcpy(gl, l, n * sizeof(int16_t));
+            memcpy(gr, r, n * sizeof(int16_t));
+            audio_effect_process(l, r, n);
+            generic_effect_process(gl, gr, n);
+            if (memcmp(l, gl, n * sizeof(int16_t)) || memcmp(r, gr, n * sizeof(int16_t))) mismatches++;
+            pos += n;
+
+            // ここまでに終わったスライスの数と、キャプチャ中の位置の期待値
+            while ((((k + 1) * step_q32) >> 32) <= pos) k++;
+            int64_t expected = (int64_t)(pos - ((k * step_q32) >> 32));
+            int64_t err = (int64_t)slice_write_pos - expected;
+            if (llabs(err) > llabs(worst)) worst = err;
+        }
+        printf("  %.1f BPM (%.4f frames): %llu slices, worst grid error %lld frames, "
+               "%llu blocks differ from generic\n",
+               bpms[b], frames / dividers[b], (unsigned long long)k, (long long)worst,
+               (unsigned long long)mismatches);
+        CHECK(worst == 0);
+        CHECK(mismatches == 0);
+    }
+}
+
+// ============================================================================
+// スライス長のクランプ
+// ============================================================================
+
+static void test_slice_clamps(void) {
+    printf("Slice length clamps:\n");
+
+    // 範囲外は黙って丸めて数える（パラメータ更新は毎ループ呼ばれるのでログは出さない）
+    beat_repeat_params_t p = make_params(PITCH_MODE_FIXED_REVERSE, 0, 0, 0, &slice_cases[1], 1.0f);
+    uint32_t before = audio_effect_get_slice_clamps();
+    for (int i = 0; i < 1000; i++) audio_effect_update_params(&p);
+    CHECK(audio_effect_get_slice_clamps() == before);
+
+    beat_repeat_params_t got;
+    p.slice_length = MAX_SLICE_LENGTH + 1;
+    for (int i = 0; i < 1000; i++) audio_effect_update_params(&p);
+    audio_effect_get_params(&got);
+    CHECK(got.slice_length == MAX_SLICE_LENGTH);
+    CHECK(got.slice_length_frac == 0);
+
+    p.slice_length = MIN_SLICE_LENGTH - 1;
+    audio_effect_update_params(&p);
+    audio_effect_get_params(&got);
+    CHECK(got.slice_length == MIN_SLICE_LENGTH);
+
+    printf("  %u clamps counted\n", audio_effect_get_slice_clamps() - before);
+    CHECK(audio_effect_get_slice_clamps() - before == 1001);
+}
+
+// ============================================================================
+// スライスバッファの貸し出し
+// ============================================================================
+
+/**
+ * @brief n フレーム流し、入力から変わったフレーム数を返す
+ */
+static uint32_t run_changed(uint32_t n) {
+    static int16_t l[256], r[256], in_l[256], in_r[256];
+    uint32_t changed = 0;
+    for (uint32_t pos = 0; pos < n; pos += 256) {
+        render_input(pos, in_l, in_r, 256);
+        memcpy(l, in_l, sizeof(l));
+        memcpy(r, in_r, sizeof(r));
+        audio_effect_process(l, r, 256);
+        for (uint32_t i = 0; i < 256; i++) {
+            if (l[i] != in_l[i] || r[i] != in_r[i]) changed++;
+        }
+    }
+    return changed;
+}
+
+static void test_slice_memory_lending(void) {
+    printf("Slice memory lending:\n");
+
+    beat_repeat_params_t p = make_params(PITCH_MODE_FIXED_REVERSE, 0, 0, 0, &slice_cases[0], 1.0f);
+    audio_effect_reset();
+    audio_effect_update_params(&p);
+
+    // 有効な間は貸さない
+    CHECK(audio_effect_lend_slice_memory() == NULL);
+
+    p.enabled = false;
+    audio_effect_update_params(&p);
+    uint8_t *mem = audio_effect_lend_slice_memory();
+    CHECK(mem == (uint8_t *)slice_buffer);
+    CHECK(audio_effect_get_slice_memory_bytes() == 2 * MAX_SLICE_LENGTH * sizeof(int16_t));
+    CHECK(audio_effect_is_slice_memory_lent());
+    CHECK(audio_effect_lend_slice_memory() == NULL);   // 二重には貸さない
+
+    // 貸している間は有効にしても素通りで、リセットでも中身に触れない
+    uint32_t bytes = audio_effect_get_slice_memory_bytes();
+    for (uint32_t i = 0; i < bytes; i++) mem[i] = (uint8_t)(i * 31 + 7);
+    p.enabled = true;
+    audio_effect_update_params(&p);
+    audio_effect_reset();
+    uint32_t changed_lent = run_changed(FS);
+    uint32_t corrupted = 0;
+    for (uint32_t i = 0; i < bytes; i++) {
+        if (mem[i] != (uint8_t)(i * 31 + 7)) corrupted++;
+    }
+
+    // 返した後は元どおり動く
+    audio_effect_return_slice_memory();
+    CHECK(!audio_effect_is_slice_memory_lent());
+    uint32_t changed_returned = run_changed(FS);
+
+    printf("  while lent: %u frames changed, %u bytes touched; after return: %u frames changed\n",
+           changed_lent, corrupted, changed_returned);
+    CHECK(changed_lent == 0);
+    CHECK(corrupted == 0);
+    CHECK(changed_returned > 0);
+    audio_effect_reset();
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    printf("Cost per frame while repeating (host, %d-frame blocks):\n", 256);
+
+    const uint32_t frames = FS * 5;
+    const uint32_t block = 256;
+    static int16_t src_l[FS * 5], src_r[FS * 5];
+    static int16_t l[256], r[256];
+    render_input(0, src_l, src_r, frames);
+
+    static const struct { int mode, rev, win, duck; const char *name; } cases[] = {
+        { PITCH_MODE_FIXED_REVERSE, 0, 0, 0, "fixed" },
+        { PITCH_MODE_FIXED_REVERSE, 1, 1, 0, "fixed, reverse, window" },
+        { PITCH_MODE_DECREASING, 0, 1, 1, "decreasing, window, duck" },
+        { PITCH_MODE_SCRATCH, 1, 1, 1, "scratch, reverse, window, duck" },
+    };
+
+    for (unsigned k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        double cycles[2];
+        for (int path = 0; path < 2; path++) {
+            // 確率 1.0、リピート 16 回: ほぼ常にリピート中
+            beat_repeat_params_t p = make_params(cases[k].mode, cases[k].rev, cases[k].win, cases[k].duck,
+                                                 &slice_cases[0], 1.0f);
+            p.repeat_count = 16;
+            void (*process)(int16_t *, int16_t *, uint32_t) =
+                path ? generic_effect_process : audio_effect_process;
+            if (path) {
+                generic_effect_reset();
+                generic_effect_update_params(&p);
+            } else {
+                audio_effect_reset();
+                audio_effect_update_params(&p);
+            }
+
+            uint64_t best = UINT64_MAX;
+            for (int rep = 0; rep < 3; rep++) {
+                uint64_t c0 = bench_cycles();
+                for (uint32_t pos = 0; pos + block <= frames; pos += block) {
+                    memcpy(l, &src_l[pos], sizeof(l));
+                    memcpy(r, &src_r[pos], sizeof(r));
+                    process(l, r, block);
+                }
+                uint64_t c1 = bench_cycles();
+                bench_sink(l, sizeof(l));
+                if (c1 - c0 < best) best = c1 - c0;
+            }
+            cycles[path] = (double)best / frames;
+        }
+        printf("  %-32s specialised %.1f, generic %.1f host cycles/frame (%.2fx)\n",
+               cases[k].name, cycles[0], cycles[1], cycles[0] / cycles[1]);
+    }
+    printf("  (target cycles: effect block time in the [EFFECT] status log on the device)\n");
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    if (!audio_effect_init(FS) || !generic_effect_init(FS)) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    test_equivalence();
+    test_grid_drift();
+    test_slice_clamps();
+    test_slice_memory_lending();
+    bench();
+    return test_summary("test_effect_kernels");
+}
@@ -0,0 +1,303 @@
+/**
+ * @file test_i2s_quad.c
+ * @brief 4チャンネル（2データ線）I2S ストリームのフレーム整列のホストテスト
+ *
+ * audio_out_i2s.c を I2S_QUAD_OUTPUT = 1 で取り込み、ペアA/ペアB に別々の通し番号付き
+ * サンプルを書き込んで、DMA が PIO に送るワード列を取り出す。ワード列をビット展開の逆で
+ * 4チャンネルに戻し、
+ *   - 各フレームの4チャンネルが同じ通し番号を持つ（または4チャンネルとも無音）
+ *   - 通し番号は1ずつ進み、飛びや重複は目標深さへの寄せ込み（両ペア同じ位置）だけ
+ * を、DMA バッファの境目、リングの折り返し、寄せ込み、アンダーラン、オーバーランを含めて確かめる。
+ *
+ * 引数にファイル名を渡すと、寄せ込みを含む 1024 フレーム分のワード列を書き出す
+ * （tools/pio_emu.py --words で PIO の波形まで通して4チャンネルの整列を確かめる）。
+ */
+
+#include "config.h"
+#undef I2S_QUAD_OUTPUT
+#define I2S_QUAD_OUTPUT 1
+#include "../src/audio_out_i2s.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/irq.h"
+
+#include <stdlib.h>
+
+#define MAX_BLOCK        512
+#define DUMP_FRAMES      1024
+#define MAX_CAPTURE      (600 * I2S_DMA_BUFFER_SIZE)
+
+// ============================================================================
+// 通し番号付きのサンプル（下位2ビット = チャンネル: 0 A_L, 1 A_R, 2 B_L, 3 B_R）
+// ============================================================================
+
+static int16_t tagged(uint32_t index, uint32_t channel) {
+    return (int16_t)(((index & 0x1FFF) << 2) | channel);
+}
+
+/**
+ * @brief 偶数ビット（DATA_A）または奇数ビット（DATA_B）を16ビットに詰め直す
+ */
+static uint16_t unspread(uint32_t w) {
+    uint16_t v = 0;
+    for (uint32_t b = 0; b < 16; b++) {
+        if (w & (1u << (2 * b))) v |= (uint16_t)(1u << b);
+    }
+    return v;
+}
+
+// DMA が送ったワード列（1フレーム = 2ワード）
+static uint32_t *captured;
+static uint32_t captured_frames = 0;
+
+static void decode_frame(uint32_t frame, uint16_t ch[4]) {
+    uint32_t left = captured[frame * 2];
+    uint32_t right = captured[frame * 2 + 1];
+    ch[0] = unspread(left);
+    ch[1] = unspread(right);
+    ch[2] = unspread(left >> 1);
+    ch[3] = unspread(right >> 1);
+}
+
+/**
+ * @brief 転送中の DMA バッファを記録してから完了させる
+ */
+static void complete_dma(void) {
+    const uint32_t *words = (const uint32_t *)host_dma[dma_channel].read_addr;
+    if (captured_frames + I2S_DMA_BUFFER_SIZE <= MAX_CAPTURE) {
+        memcpy(&captured[captured_frames * 2], words, I2S_DMA_WORDS * sizeof(uint32_t));
+        captured_frames += I2S_DMA_BUFFER_SIZE;
+    }
+    host_dma_complete((uint)dma_channel);
+    host_irq_service(DMA_IRQ_0, 4);
+}
+
+// ============================================================================
+// 生成側
+// ============================================================================
+
+static uint32_t next_index = 1;   // 次に書き込むフレームの通し番号
+
+/**
+ * @brief n フレームを両ペアに書き込む（受け取られなかった分は次回また書く）
+ */
+static uint32_t produce(uint32_t n) {
+    static int16_t al[MAX_BLOCK], ar[MAX_BLOCK], bl[MAX_BLOCK], br[MAX_BLOCK];
+    for (uint32_t i = 0; i < n; i++) {
+        al[i] = tagged(next_index + i, 0);
+        ar[i] = tagged(next_index + i, 1);
+        bl[i] = tagged(next_index + i, 2);
+        br[i] = tagged(next_index + i, 3);
+    }
+    // ルーティングと同じく、エフェクト前タップ（ペアA）、エフェクト後タップ（ペアB）の順
+    uint32_t a = audio_out_i2s_write_pair(0, al, ar, n);
+    uint32_t b = audio_out_i2s_write_pair(1, bl, br, n);
+    CHECK(a == b);
+    next_index += b;
+    return b;
+}
+
+// ============================================================================
+// 検証
+// ============================================================================
+
+typedef struct {
+    uint32_t frames;
+    uint32_t silent;
+    uint32_t misaligned;     // 4チャンネルの通し番号やタグが合わない
+    uint32_t repeats;        // 寄せ込みの重複
+    uint32_t skips;          // 寄せ込みの間引き
+    uint32_t discontinuities;
+    uint32_t first_slip;     // 最初に寄せ込みがあったフレーム（0 = なし）
+} stream_check_t;
+
+static stream_check_t check_stream(void) {
+    stream_check_t s = { 0 };
+    int32_t last = -1;
+
+    for (uint32_t f = 0; f < captured_frames; f++) {
+        uint16_t ch[4];
+        decode_frame(f, ch);
+        s.frames++;
+
+        if (ch[0] == 0 && ch[1] == 0 && ch[2] == 0 && ch[3] == 0) {
+            s.silent++;
+            continue;
+        }
+
+        bool aligned = true;
+        for (uint32_t c = 0; c < 4; c++) {
+            if ((ch[c] & 3) != c || (ch[c] >> 2) != (ch[0] >> 2)) aligned = false;
+        }
+        if (!aligned) {
+            if (s.misaligned++ < 5) {
+                printf("  frame %u misaligned: %04x %04x %04x %04x\n", f, ch[0], ch[1], ch[2], ch[3]);
+            }
+            continue;
+        }
+
+        int32_t index = ch[0] >> 2;
+        if (last >= 0) {
+            uint32_t step = (uint32_t)(index - last) & 0x1FFF;
+            if (step == 0 || step == 2) {
+                if (step == 0) s.repeats++; else s.skips++;
+                if (!s.first_slip) s.first_slip = f;
+            } else if (step != 1) {
+                s.discontinuities++;
+            }
+        }
+        last = index;
+    }
+    return s;
+}
+
+static void dump_words(const char *path, uint32_t center) {
+    uint32_t start = (center > DUMP_FRAMES / 2) ? center - DUMP_FRAMES / 2 : 0;
+    if (start + DUMP_FRAMES > captured_frames) start = captured_frames - DUMP_FRAMES;
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        printf("  cannot write %s\n", path);
+        test_failures++;
+        return;
+    }
+    fprintf(fp, "# audio_out_i2s 4-channel DMA words, frames %u..%u (word0 = left slot, word1 = right slot)\n",
+            start, start + DUMP_FRAMES - 1);
+    for (uint32_t f = start; f < start + DUMP_FRAMES; f++) {
+        fprintf(fp, "%08x %08x\n", captured[f * 2], captured[f * 2 + 1]);
+    }
+    fclose(fp);
+    printf("  wrote %s (frames %u..%u)\n", path, start, start + DUMP_FRAMES - 1);
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_interleave(void) {
+    printf("Bit interleave:\n");
+
+    // ワードの偶数ビットがペアA、奇数ビットがペアB（MSB の組がビット31/30）
+    uint32_t w = interleave_slot((int16_t)0x8001, (int16_t)0x0000);
+    CHECK(w == 0x40000001u);
+    w = interleave_slot((int16_t)0x0000, (int16_t)0x8001);
+    CHECK(w == 0x80000002u);
+
+    uint32_t rng = 1;
+    uint32_t errors = 0;
+    for (int i = 0; i < 100000; i++) {
+        int16_t a = (int16_t)test_rand(&rng);
+        int16_t b = (int16_t)test_rand(&rng);
+        w = interleave_slot(a, b);
+        if (unspread(w) != (uint16_t)a || unspread(w >> 1) != (uint16_t)b) errors++;
+    }
+    CHECK(errors == 0);
+}
+
+static void test_stereo_write(void) {
+    printf("Stereo write (same data on both pairs):\n");
+
+    audio_out_i2s_stop();
+    audio_out_i2s_clear_buffer();
+    captured_frames = 0;
+
+    int16_t l[64], r[64];
+    for (int i = 0; i < 64; i++) {
+        l[i] = (int16_t)(i * 311);
+        r[i] = (int16_t)(-i * 173);
+    }
+    CHECK(audio_out_i2s_write(l, r, 64) == 64);
+    CHECK(audio_out_i2s_get_buffered_samples() == 64);
+
+    uint32_t buf[2 * 64];
+    priming = false;
+    fill_dma_buffer((int32_t *)buf, 64);
+    uint32_t errors = 0;
+    for (int i = 0; i < 64; i++) {
+        if (unspread(buf[2 * i]) != (uint16_t)l[i] || unspread(buf[2 * i] >> 1) != (uint16_t)l[i]) errors++;
+        if (unspread(buf[2 * i + 1]) != (uint16_t)r[i] || unspread(buf[2 * i + 1] >> 1) != (uint16_t)r[i]) errors++;
+    }
+    CHECK(errors == 0);
+}
+
+static void test_alignment(const char *dump_path) {
+    printf("Frame alignment (4-channel DMA stream):\n");
+
+    audio_out_i2s_stop();
+    audio_out_i2s_clear_buffer();
+    captured_frames = 0;
+    next_index = 1;
+
+    // 目標深さありで、生成レートを DMA より速く / 遅くして寄せ込みを起こす
+    audio_out_i2s_set_target_depth(4096);
+
+    uint32_t rng = 0xBEEF;
+    double consumed = 0.0;
+    double produced_target = 0.0;
+    uint32_t overruns_expected = 0;
+
+    for (int phase = 0; phase < 5 && captured_frames < MAX_CAPTURE; phase++) {
+        // 0: 遅い, 1: 速い, 2: 一時停止（アンダーラン）, 3: バースト（オーバーラン）, 4: ほぼ一致
+        static const double ratio[5] = { 0.99, 1.01, 0.0, 4.0, 1.0005 };
+        static const uint32_t completions_per_phase[5] = { 100, 200, 30, 40, 100 };
+        uint32_t completions = completions_per_phase[phase];
+
+        for (uint32_t c = 0; c < completions; c++) {
+            produced_target += ratio[phase] * I2S_DMA_BUFFER_SIZE;
+            while ((double)next_index - 1.0 < produced_target) {
+                uint32_t n = 1 + test_rand(&rng) % MAX_BLOCK;
+                if (produce(n) < n) {
+                    overruns_expected++;
+                    produced_target = (double)next_index - 1.0;
+                    break;
+                }
+            }
+            if (is_running) {
+                complete_dma();
+                consumed += I2S_DMA_BUFFER_SIZE;
+            }
+        }
+        if (phase == 2) {
+            // 止めていた分は取り戻さない
+            produced_target = (double)next_index - 1.0;
+        }
+    }
+
+    uint32_t underruns, overruns;
+    audio_out_i2s_get_stats(&underruns, &overruns);
+    stream_check_t s = check_stream();
+
+    printf("  %u frames (%u DMA buffers), %u silent, %u written\n",
+           s.frames, s.frames / I2S_DMA_BUFFER_SIZE, s.silent, next_index - 1);
+    printf("  slips: %u repeated, %u skipped | underruns %u, overruns %u\n",
+           s.repeats, s.skips, underruns, overruns);
+    printf("  misaligned frames: %u, discontinuities: %u\n", s.misaligned, s.discontinuities);
+
+    CHECK(s.misaligned == 0);
+    CHECK(s.discontinuities == 0);
+    CHECK(s.repeats > 0 && s.skips > 0);
+    CHECK(underruns > 0);
+    CHECK(overruns > 0 && overruns == overruns_expected);
+    CHECK(s.frames > 2 * I2S_RING_FRAMES);   // リングを何周もしている
+
+    if (dump_path) dump_words(dump_path, s.first_slip);
+}
+
+int main(int argc, char **argv) {
+    host_sdk_reset();
+    host_time_set_virtual(true);
+
+    captured = malloc(MAX_CAPTURE * 2 * sizeof(uint32_t));
+    if (!captured || !audio_out_i2s_init(44100, 16, 4)) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    test_interleave();
+    test_stereo_write();
+    test_alignment(argc > 1 ? argv[1] : NULL);
+
+    free(captured);
+    return test_summary("test_i2s_quad");
+}
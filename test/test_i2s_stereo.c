@@ -0,0 +1,221 @@
+/**
+ * @file test_i2s_stereo.c
+ * @brief ステレオ（1データ線）I2S ストリームのフレーム整列のホストテスト
+ *
+ * audio_out_i2s.c を I2S_QUAD_OUTPUT = 0 で取り込み、L/R に通し番号付きのサンプルを
+ * 書き込んで、DMA が PIO に送るワード列（上位16ビット = 左、下位16ビット = 右）を取り出す。
+ *   - 各フレームの L/R が同じ通し番号を持つ（または両方とも無音）
+ *   - 通し番号は1ずつ進み、飛びや重複は目標深さへの寄せ込みだけ
+ * を、DMA バッファの境目、リングの折り返し、寄せ込み、アンダーラン、オーバーランを含めて確かめる。
+ *
+ * 引数にファイル名を渡すと、寄せ込みを含む 1024 フレーム分のワード列を書き出す
+ * （tools/pio_emu.py --program i2s_output --words で PIO の波形まで通して L/R の整列、
+ *   LRCLK/BCLK/データの位置関係、64サイクル/フレームを確かめる）。
+ */
+
+#include "config.h"
+#undef I2S_QUAD_OUTPUT
+#define I2S_QUAD_OUTPUT 0
+#include "../src/audio_out_i2s.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/irq.h"
+
+#include <stdlib.h>
+
+#define MAX_BLOCK        512
+#define DUMP_FRAMES      1024
+#define MAX_CAPTURE      (600 * I2S_DMA_BUFFER_SIZE)
+
+// ============================================================================
+// 通し番号付きのサンプル（下位2ビット = チャンネル: 0 L, 1 R）
+// ============================================================================
+
+static int16_t tagged(uint32_t index, uint32_t channel) {
+    return (int16_t)(((index & 0x1FFF) << 2) | channel);
+}
+
+// DMA が送ったワード列（1フレーム = 1ワード）
+static uint32_t *captured;
+static uint32_t captured_frames = 0;
+
+/**
+ * @brief 転送中の DMA バッファを記録してから完了させる
+ */
+static void complete_dma(void) {
+    const uint32_t *words = (const uint32_t *)host_dma[dma_channel].read_addr;
+    if (captured_frames + I2S_DMA_BUFFER_SIZE <= MAX_CAPTURE) {
+        memcpy(&captured[captured_frames], words, I2S_DMA_WORDS * sizeof(uint32_t));
+        captured_frames += I2S_DMA_BUFFER_SIZE;
+    }
+    host_dma_complete((uint)dma_channel);
+    host_irq_service(DMA_IRQ_0, 4);
+}
+
+// ============================================================================
+// 生成側
+// ============================================================================
+
+static uint32_t next_index = 1;   // 次に書き込むフレームの通し番号
+
+/**
+ * @brief n フレームを書き込む（受け取られなかった分は次回また書く）
+ */
+static uint32_t produce(uint32_t n) {
+    static int16_t l[MAX_BLOCK], r[MAX_BLOCK];
+    for (uint32_t i = 0; i < n; i++) {
+        l[i] = tagged(next_index + i, 0);
+        r[i] = tagged(next_index + i, 1);
+    }
+    uint32_t written = audio_out_i2s_write(l, r, n);
+    next_index += written;
+    return written;
+}
+
+// ============================================================================
+// 検証
+// ============================================================================
+
+typedef struct {
+    uint32_t frames;
+    uint32_t silent;
+    uint32_t misaligned;     // L/R の通し番号やタグが合わない
+    uint32_t repeats;        // 寄せ込みの重複
+    uint32_t skips;          // 寄せ込みの間引き
+    uint32_t discontinuities;
+    uint32_t first_slip;     // 最初に寄せ込みがあったフレーム（0 = なし）
+} stream_check_t;
+
+static stream_check_t check_stream(void) {
+    stream_check_t s = { 0 };
+    int32_t last = -1;
+
+    for (uint32_t f = 0; f < captured_frames; f++) {
+        uint16_t l = (uint16_t)(captured[f] >> 16);
+        uint16_t r = (uint16_t)captured[f];
+        s.frames++;
+
+        if (l == 0 && r == 0) {
+            s.silent++;
+            continue;
+        }
+        if ((l & 3) != 0 || (r & 3) != 1 || (l >> 2) != (r >> 2)) {
+            if (s.misaligned++ < 5) {
+                printf("  frame %u misaligned: %04x %04x\n", f, l, r);
+            }
+            continue;
+        }
+
+        int32_t index = l >> 2;
+        if (last >= 0) {
+            uint32_t step = (uint32_t)(index - last) & 0x1FFF;
+            if (step == 0 || step == 2) {
+                if (step == 0) s.repeats++; else s.skips++;
+                if (!s.first_slip) s.first_slip = f;
+            } else if (step != 1) {
+                s.discontinuities++;
+            }
+        }
+        last = index;
+    }
+    return s;
+}
+
+static void dump_words(const char *path, uint32_t center) {
+    uint32_t start = (center > DUMP_FRAMES / 2) ? center - DUMP_FRAMES / 2 : 0;
+    if (start + DUMP_FRAMES > captured_frames) start = captured_frames - DUMP_FRAMES;
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        printf("  cannot write %s\n", path);
+        test_failures++;
+        return;
+    }
+    fprintf(fp, "# audio_out_i2s stereo DMA words, frames %u..%u (left << 16 | right)\n",
+            start, start + DUMP_FRAMES - 1);
+    for (uint32_t f = start; f < start + DUMP_FRAMES; f++) {
+        fprintf(fp, "%08x\n", captured[f]);
+    }
+    fclose(fp);
+    printf("  wrote %s (frames %u..%u)\n", path, start, start + DUMP_FRAMES - 1);
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_alignment(const char *dump_path) {
+    printf("Frame alignment (stereo DMA stream):\n");
+
+    audio_out_i2s_stop();
+    audio_out_i2s_clear_buffer();
+    captured_frames = 0;
+    next_index = 1;
+
+    // 目標深さありで、生成レートを DMA より速く / 遅くして寄せ込みを起こす
+    audio_out_i2s_set_target_depth(4096);
+
+    uint32_t rng = 0xBEEF;
+    double produced_target = 0.0;
+    uint32_t overruns_expected = 0;
+
+    for (int phase = 0; phase < 5 && captured_frames < MAX_CAPTURE; phase++) {
+        // 0: 遅い, 1: 速い, 2: 一時停止（アンダーラン）, 3: バースト（オーバーラン）, 4: ほぼ一致
+        static const double ratio[5] = { 0.99, 1.01, 0.0, 4.0, 1.0005 };
+        static const uint32_t completions_per_phase[5] = { 100, 200, 30, 40, 100 };
+        uint32_t completions = completions_per_phase[phase];
+
+        for (uint32_t c = 0; c < completions; c++) {
+            produced_target += ratio[phase] * I2S_DMA_BUFFER_SIZE;
+            while ((double)next_index - 1.0 < produced_target) {
+                uint32_t n = 1 + test_rand(&rng) % MAX_BLOCK;
+                if (produce(n) < n) {
+                    overruns_expected++;
+                    produced_target = (double)next_index - 1.0;
+                    break;
+                }
+            }
+            if (is_running) complete_dma();
+        }
+        if (phase == 2) {
+            // 止めていた分は取り戻さない
+            produced_target = (double)next_index - 1.0;
+        }
+    }
+
+    uint32_t underruns, overruns;
+    audio_out_i2s_get_stats(&underruns, &overruns);
+    stream_check_t s = check_stream();
+
+    printf("  %u frames (%u DMA buffers), %u silent, %u written\n",
+           s.frames, s.frames / I2S_DMA_BUFFER_SIZE, s.silent, next_index - 1);
+    printf("  slips: %u repeated, %u skipped | underruns %u, overruns %u\n",
+           s.repeats, s.skips, underruns, overruns);
+    printf("  misaligned frames: %u, discontinuities: %u\n", s.misaligned, s.discontinuities);
+
+    CHECK(s.misaligned == 0);
+    CHECK(s.discontinuities == 0);
+    CHECK(s.repeats > 0 && s.skips > 0);
+    CHECK(underruns > 0);
+    CHECK(overruns > 0 && overruns == overruns_expected);
+    CHECK(s.frames > 2 * I2S_RING_FRAMES);   // リングを何周もしている
+
+    if (dump_path) dump_words(dump_path, s.first_slip);
+}
+
+int main(int argc, char **argv) {
+    host_sdk_reset();
+    host_time_set_virtual(true);
+
+    captured = malloc(MAX_CAPTURE * sizeof(uint32_t));
+    if (!captured || !audio_out_i2s_init(44100, 16, 2)) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    test_alignment(argc > 1 ? argv[1] : NULL);
+
+    free(captured);
+    return test_summary("test_i2s_stereo");
+}
@@ -0,0 +1,226 @@
+/**
+ * @file test_latency.c
+ * @brief レイテンシー補償のホストテスト（全ノードの組み合わせでドライ/ウェットの整列）
+ *
+ * bt_audio の処理順どおりにノードを並べ、各ノードを申告した遅延と同じだけの
+ * 純粋な遅延線（共有履歴メモリから確保、バスコンプレッサーの先読みと同じ使い方）で模擬する。
+ *   バリスピード → ラウドネス → [エフェクト前タップ] → エフェクト → ルーパー
+ *   → サンプラー → バスコンプレッサー → [エフェクト後タップ]
+ * 2つのタップを audio_route の記録用出力（ドライ/ウェット）で受け、
+ * - 遅延を持つノードの 64 通りの組み合わせすべてで、ドライとウェットがサンプル単位で一致し、
+ *   どちらも入力を合計遅延だけ遅らせたものになること（ブロックの大きさはランダム）
+ * - 補償しきれない遅延（LATENCY_MAX_COMPENSATION 超）では、補償の上限で止まること
+ * を確かめる。バリスピードは速度 1.0（入力と出力のフレーム数が同じ）の場合。
+ */
+
+#include "audio_route.h"
+#include "latency.h"
+#include "config.h"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <string.h>
+
+#define STREAM_FRAMES  3000
+#define MAX_BLOCK      300
+
+// ノードごとの遅延（組み合わせで有効にした時の値、補償の合計は 190 フレーム）
+static const uint32_t node_frames[LATENCY_NODE_COUNT] = {
+    16,    // バリスピード（VARISPEED_TAPS / 2 相当）
+    3,     // ラウドネス
+    37,    // エフェクト
+    1,     // ルーパー
+    64,    // サンプラー
+    88,    // バスコンプレッサー（2ms の先読み）
+};
+
+static const char *const node_names[LATENCY_NODE_COUNT] = {
+    "vari", "loud", "fx", "loop", "smp", "bus",
+};
+
+// ============================================================================
+// 記録用の出力
+// ============================================================================
+
+static int16_t dry_l[STREAM_FRAMES], dry_r[STREAM_FRAMES];
+static int16_t wet_l[STREAM_FRAMES], wet_r[STREAM_FRAMES];
+static uint32_t dry_count, wet_count;
+
+static uint32_t capture(int16_t *dst_l, int16_t *dst_r, uint32_t *count,
+                       const int16_t *left, const int16_t *right, uint32_t n) {
+    for (uint32_t i = 0; i < n && *count < STREAM_FRAMES; i++) {
+        dst_l[*count] = left[i];
+        dst_r[*count] = right[i];
+        (*count)++;
+    }
+    return n;
+}
+
+static uint32_t dry_write(const int16_t *l, const int16_t *r, uint32_t n) {
+    return capture(dry_l, dry_r, &dry_count, l, r, n);
+}
+
+static uint32_t wet_write(const int16_t *l, const int16_t *r, uint32_t n) {
+    return capture(wet_l, wet_r, &wet_count, l, r, n);
+}
+
+// ============================================================================
+// チェーンの模擬
+// ============================================================================
+
+static latency_delay_t node_delay[LATENCY_NODE_COUNT];
+static bool node_enabled[LATENCY_NODE_COUNT];
+
+/**
+ * @brief 入力フレーム（L = 通し番号、R = 反転した番号。0 は遅延線の初期値と区別する）
+ */
+static void input_frame(uint32_t index, int16_t *l, int16_t *r) {
+    *l = (int16_t)((index % 30000) + 1);
+    *r = (int16_t)-*l;
+}
+
+/**
+ * @brief ノードの遅延を組み合わせて申告し、各ノードの遅延線を確保する
+ * @param frames ノードごとの遅延（0 = 遅延なし）
+ */
+static bool setup_chain(const uint32_t *frames) {
+    latency_init();
+    for (int node = 0; node < LATENCY_NODE_COUNT; node++) {
+        node_enabled[node] = frames[node] > 0;
+        if (!node_enabled[node]) continue;
+        if (!latency_delay_alloc(&node_delay[node], frames[node])) return false;
+        latency_delay_set(&node_delay[node], frames[node]);
+        latency_declare((latency_node_t)node, frames[node]);
+    }
+    dry_count = 0;
+    wet_count = 0;
+    return true;
+}
+
+static void run_node(latency_node_t node, int16_t *l, int16_t *r, uint32_t n) {
+    if (node_enabled[node]) {
+        latency_delay_process(&node_delay[node], l, r, l, r, n);
+    }
+}
+
+/**
+ * @brief STREAM_FRAMES フレームをランダムな大きさのブロックで流す
+ */
+static void run_stream(uint32_t *rng) {
+    static int16_t l[MAX_BLOCK], r[MAX_BLOCK];
+
+    for (uint32_t pos = 0; pos < STREAM_FRAMES;) {
+        uint32_t n = 1 + test_rand(rng) % MAX_BLOCK;
+        if (n > STREAM_FRAMES - pos) n = STREAM_FRAMES - pos;
+        for (uint32_t i = 0; i < n; i++) input_frame(pos + i, &l[i], &r[i]);
+
+        run_node(LATENCY_NODE_VARISPEED, l, r, n);
+        run_node(LATENCY_NODE_LOUDNESS, l, r, n);
+        audio_route_process(AUDIO_TAP_PRE_EFFECT, l, r, n);
+        run_node(LATENCY_NODE_EFFECT, l, r, n);
+        run_node(LATENCY_NODE_LOOPER, l, r, n);
+        run_node(LATENCY_NODE_SAMPLER, l, r, n);
+        run_node(LATENCY_NODE_BUS_COMPRESSOR, l, r, n);
+        audio_route_process(AUDIO_TAP_POST_EFFECT, l, r, n);
+        pos += n;
+    }
+}
+
+/**
+ * @brief 記録が「入力を delay フレーム遅らせたもの」と一致しないフレーム数
+ */
+static uint32_t count_mismatch(const int16_t *out_l, const int16_t *out_r, uint32_t count,
+                               uint32_t delay) {
+    uint32_t bad = (count == STREAM_FRAMES) ? 0 : STREAM_FRAMES;
+    for (uint32_t t = 0; t < count; t++) {
+        int16_t l = 0, r = 0;
+        if (t >= delay) input_frame(t - delay, &l, &r);
+        if (out_l[t] != l || out_r[t] != r) bad++;
+    }
+    return bad;
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_all_combinations(void) {
+    printf("Dry/wet alignment for every combination of node latencies:\n");
+
+    uint32_t rng = 5;
+    uint32_t failed = 0, max_total = 0, max_pool = 0;
+    for (uint32_t mask = 0; mask < (1u << LATENCY_NODE_COUNT); mask++) {
+        uint32_t frames[LATENCY_NODE_COUNT];
+        uint32_t total = 0, after_tap = 0;
+        for (int node = 0; node < LATENCY_NODE_COUNT; node++) {
+            frames[node] = (mask & (1u << node)) ? node_frames[node] : 0;
+            total += frames[node];
+            if (node >= LATENCY_NODE_EFFECT) after_tap += frames[node];
+        }
+
+        CHECK(setup_chain(frames));
+        CHECK(latency_get_total() == total);
+        CHECK(latency_get_compensation(AUDIO_TAP_PRE_EFFECT) == after_tap);
+        CHECK(latency_get_compensation(AUDIO_TAP_POST_EFFECT) == 0);
+        run_stream(&rng);
+
+        uint32_t dry_bad = count_mismatch(dry_l, dry_r, dry_count, total);
+        uint32_t wet_bad = count_mismatch(wet_l, wet_r, wet_count, total);
+        uint32_t pair_bad = (dry_count == wet_count) ? 0 : STREAM_FRAMES;
+        for (uint32_t t = 0; t < dry_count && t < wet_count; t++) {
+            if (dry_l[t] != wet_l[t] || dry_r[t] != wet_r[t]) pair_bad++;
+        }
+
+        if (dry_bad || wet_bad || pair_bad) {
+            printf("  FAIL mask 0x%02lx:", mask);
+            for (int node = 0; node < LATENCY_NODE_COUNT; node++) {
+                if (frames[node]) printf(" %s=%lu", node_names[node], frames[node]);
+            }
+            printf(" -> dry %lu, wet %lu, dry vs. wet %lu mismatched frames\n",
+                   dry_bad, wet_bad, pair_bad);
+            failed++;
+        }
+        if (total > max_total) max_total = total;
+        if (latency_get_pool_used() > max_pool) max_pool = latency_get_pool_used();
+    }
+    printf("  %u combinations, %u misaligned; total latency up to %lu frames, pool up to %lu of %d frames\n",
+           1u << LATENCY_NODE_COUNT, failed, max_total, max_pool, LATENCY_POOL_FRAMES);
+    CHECK(failed == 0);
+}
+
+static void test_over_compensation_limit(void) {
+    printf("Latency after the dry tap beyond LATENCY_MAX_COMPENSATION (%d frames):\n",
+           LATENCY_MAX_COMPENSATION);
+
+    const uint32_t excess = 32;
+    uint32_t frames[LATENCY_NODE_COUNT] = { 0 };
+    frames[LATENCY_NODE_EFFECT] = LATENCY_MAX_COMPENSATION + excess - node_frames[LATENCY_NODE_BUS_COMPRESSOR];
+    frames[LATENCY_NODE_BUS_COMPRESSOR] = node_frames[LATENCY_NODE_BUS_COMPRESSOR];
+    CHECK(setup_chain(frames));
+    CHECK(latency_get_compensation(AUDIO_TAP_PRE_EFFECT) == LATENCY_MAX_COMPENSATION);
+
+    uint32_t rng = 8;
+    run_stream(&rng);
+
+    // ドライは上限までしか遅れない（ウェットより excess フレーム早い）
+    uint32_t total = LATENCY_MAX_COMPENSATION + excess;
+    uint32_t dry_bad = count_mismatch(dry_l, dry_r, dry_count, LATENCY_MAX_COMPENSATION);
+    uint32_t wet_bad = count_mismatch(wet_l, wet_r, wet_count, total);
+    printf("  total %lu frames: dry delayed by %lu (%lu mismatched), wet by %lu (%lu mismatched)\n",
+           total, latency_get_compensation(AUDIO_TAP_PRE_EFFECT), dry_bad, total, wet_bad);
+    CHECK(dry_bad == 0);
+    CHECK(wet_bad == 0);
+}
+
+int main(void) {
+    host_sdk_reset();
+    latency_init();
+
+    CHECK(audio_route_add_output("dry", dry_write, AUDIO_TAP_PRE_EFFECT) == 0);
+    CHECK(audio_route_add_output("wet", wet_write, AUDIO_TAP_POST_EFFECT) == 1);
+
+    test_all_combinations();
+    test_over_compensation_limit();
+    return test_summary("test_latency");
+}
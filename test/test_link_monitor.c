@@ -0,0 +1,279 @@
+/**
+ * @file test_link_monitor.c
+ * @brief リンク監視（適応バッファ深さ）の制御則のホストテスト（合成した到着間隔のトレース）
+ *
+ * 実機で記録した到着間隔のトレースは手元にないので、よく見るパターンを合成する。
+ *   clean    : パケット長ごとに ±1 ms 揺れて届く
+ *   bursty   : 3パケットずつまとめて届く（規則的なバースト受信）
+ *   coex     : Wi-Fi との共存で 2 秒前後ごとに 80〜150 ms 途切れ、まとめて届く
+ *   degrade  : 20 秒きれい → 20 秒 RSSI が弱く 250 ms までの途切れ → 40 秒きれい
+ * どのトレースもソースのクロックは +200 ppm ずれている。
+ *
+ * 出力は audio_out_i2s と同じ作りで模擬する: 一定速度で消費するリング、目標深さ + DMA
+ * バッファ2面分たまるまで鳴らさない（アンダーラン後も同じ）、書き込みごとにフィルの
+ * 平均（1/64）が目標 ± DMA 半面を外れていれば 256 フレームに1フレーム間引く/重複させる。
+ * main.c と同じく LINK_UPDATE_MS ごとに目標深さを反映し、アンダーランを通知する。
+ *
+ * 制御則について確かめること:
+ * - きれいなリンクでは目標が下限付近まで下がり、固定の既定深さより遅延が小さい
+ * - バースト受信や途切れのあるリンクでも定常状態ではアンダーランしない
+ * - 劣化したリンクで目標が上がり、回復後は少しずつ下がる
+ */
+
+#include "link_monitor.h"
+#include "config.h"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS              44100
+#define PACKET_FRAMES   640
+#define DMA_BLOCK       512      // I2S_DMA_BUFFER_SIZE
+#define SLIP_SPACING    I2S_DEPTH_SLIP_SPACING
+#define SOURCE_PPM      200.0
+
+typedef enum {
+    TRACE_CLEAN = 0,
+    TRACE_BURSTY,
+    TRACE_COEX,
+    TRACE_DEGRADE,
+    TRACE_COUNT,
+} trace_kind_t;
+
+static const char *const trace_names[TRACE_COUNT] = { "clean", "bursty", "coex", "degrade" };
+
+// ============================================================================
+// 到着間隔のトレース
+// ============================================================================
+
+typedef struct {
+    trace_kind_t kind;
+    uint32_t rng;
+    uint32_t index;          // 次のパケットの番号
+    double gap_end_us;       // 途切れの終わり（それまでのパケットはここでまとめて届く）
+    double next_gap_us;      // 次に途切れる時刻
+    double last_us;          // 前のパケットの到着時刻（到着は前後しない）
+} trace_t;
+
+static bool degraded_at(const trace_t *tr, double t_us) {
+    return tr->kind == TRACE_DEGRADE && t_us >= 20e6 && t_us < 40e6;
+}
+
+/**
+ * @brief 次のパケットの到着時刻（us）
+ */
+static double trace_next(trace_t *tr) {
+    double period = PACKET_FRAMES * 1e6 / (FS * (1.0 + SOURCE_PPM * 1e-6));
+    double nominal = tr->index * period;
+    double jitter = ((double)(test_rand(&tr->rng) % 2001) - 1000.0);   // ±1 ms
+    double t = nominal + jitter;
+    tr->index++;
+
+    if (tr->kind == TRACE_BURSTY) {
+        // 3パケットごとに、最後のパケットの時刻でまとめて届く
+        uint32_t group_last = (tr->index - 1) / 3 * 3 + 2;
+        t = group_last * period + jitter;
+        if ((tr->index - 1) % 3 != 0) t = tr->last_us + 50.0;
+    }
+
+    if (tr->kind == TRACE_COEX || degraded_at(tr, t)) {
+        if (t >= tr->next_gap_us && t >= tr->gap_end_us) {
+            double len = (tr->kind == TRACE_COEX) ? 80e3 + test_rand(&tr->rng) % 70000
+                                                  : 100e3 + test_rand(&tr->rng) % 150000;
+            tr->gap_end_us = t + len;
+            tr->next_gap_us = t + 1.5e6 + test_rand(&tr->rng) % 1000000;
+        }
+        if (t < tr->gap_end_us) {
+            t = tr->gap_end_us;
+        }
+    }
+
+    // 途切れの後のパケットは 50 us 間隔で続けて届く
+    if (t < tr->last_us + 50.0) t = tr->last_us + 50.0;
+    tr->last_us = t;
+    return t;
+}
+
+// ============================================================================
+// 出力の模擬
+// ============================================================================
+
+typedef struct {
+    uint32_t underruns;
+    double latency_ms_sum;         // 鳴っている間のフィル（ms）の合計
+    uint32_t latency_samples;
+    uint32_t target_min;           // 測定区間での目標深さの範囲
+    uint32_t target_max;
+    uint32_t final_target;
+    uint32_t steady_underruns;     // 最初の 10 秒より後のアンダーラン
+    uint32_t degrade_peak;         // degrade: 劣化区間での目標の最大
+} sim_result_t;
+
+/**
+ * @brief トレースを流して出力を模擬する
+ * @param adaptive false なら目標深さを LINK_TARGET_INITIAL_MS に固定
+ */
+static sim_result_t simulate(trace_kind_t kind, uint32_t seconds, bool adaptive) {
+    sim_result_t res = { 0, 0.0, 0, UINT32_MAX, 0, 0, 0, 0 };
+    trace_t tr = { kind, 17 + kind, 0, 0.0, 1e6, -1e9 };
+
+    link_monitor_init(FS);
+    if (kind == TRACE_DEGRADE) link_monitor_on_rssi(-60);
+
+    uint32_t target = (uint32_t)((uint64_t)LINK_TARGET_INITIAL_MS * FS / 1000);
+    double fill = 0.0;
+    double fill_avg = target;
+    bool priming = true;
+    uint32_t reported_underruns = 0;
+    double next_packet = trace_next(&tr);
+
+    for (uint32_t ms = 0; ms < seconds * 1000; ms++) {
+        double now_us = ms * 1000.0;
+
+        // パケットの到着（bt_audio: デコードしてリングへ書く、その前に到着を記録）
+        while (next_packet <= now_us) {
+            uint32_t arrival = (uint32_t)(next_packet < 0.0 ? 0.0 : next_packet);
+            link_monitor_on_packet(arrival, PACKET_FRAMES);
+
+            double written = PACKET_FRAMES;
+            if (!priming) {
+                fill_avg += (fill - fill_avg) / 64.0;
+                double slips = (PACKET_FRAMES + SLIP_SPACING - 1) / SLIP_SPACING;
+                if (fill_avg > target + DMA_BLOCK / 2) written -= slips;
+                else if (fill_avg + DMA_BLOCK / 2 < target) written += slips;
+            }
+            fill += written;
+            next_packet = trace_next(&tr);
+        }
+
+        // RSSI（劣化区間だけ弱い）
+        if (kind == TRACE_DEGRADE && ms % LINK_RSSI_INTERVAL_MS == 0) {
+            link_monitor_on_rssi(degraded_at(&tr, now_us) ? -82 : -60);
+        }
+
+        // DMA の消費
+        if (priming) {
+            if (fill >= target + 2 * DMA_BLOCK) {
+                priming = false;
+                fill_avg = target;
+            }
+        } else {
+            fill -= FS / 1000.0;
+            if (fill < 0.0) {
+                fill = 0.0;
+                priming = true;
+                res.underruns++;
+                if (ms >= 10000) res.steady_underruns++;
+            }
+        }
+
+        // main.c の update_link_buffering()
+        if (ms % LINK_UPDATE_MS == 0) {
+            if (res.underruns > reported_underruns) {
+                link_monitor_on_underrun((uint32_t)now_us);
+                reported_underruns = res.underruns;
+            }
+            if (adaptive) {
+                target = link_monitor_get_target_frames();
+                if (target < DMA_BLOCK) target = DMA_BLOCK;
+            }
+            if (ms >= 10000) {
+                if (target < res.target_min) res.target_min = target;
+                if (target > res.target_max) res.target_max = target;
+            }
+            if (degraded_at(&tr, now_us) && target > res.degrade_peak) res.degrade_peak = target;
+        }
+
+        if (!priming && ms >= 10000) {
+            res.latency_ms_sum += fill * 1000.0 / FS;
+            res.latency_samples++;
+        }
+    }
+    res.final_target = target;
+    return res;
+}
+
+static double frames_ms(uint32_t frames) {
+    return frames * 1000.0 / FS;
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static sim_result_t run(trace_kind_t kind, uint32_t seconds) {
+    sim_result_t a = simulate(kind, seconds, true);
+    sim_result_t f = simulate(kind, seconds, false);
+    printf("  %-7s adaptive: %2lu underruns (%lu after 10 s), buffer %5.1f ms, target %5.1f-%5.1f ms, final %5.1f ms"
+           " | fixed %d ms: %2lu underruns, buffer %5.1f ms\n",
+           trace_names[kind], a.underruns, a.steady_underruns,
+           a.latency_ms_sum / a.latency_samples, frames_ms(a.target_min), frames_ms(a.target_max),
+           frames_ms(a.final_target), LINK_TARGET_INITIAL_MS, f.underruns,
+           f.latency_ms_sum / f.latency_samples);
+    return a;
+}
+
+static void test_traces(void) {
+    printf("Control law on synthesized arrival traces (%d-frame packets, source %+.0f ppm, 60-80 s each):\n",
+           PACKET_FRAMES, SOURCE_PPM);
+
+    sim_result_t clean = run(TRACE_CLEAN, 60);
+    sim_result_t clean_fixed = simulate(TRACE_CLEAN, 60, false);
+    CHECK(clean.underruns == 0);
+    CHECK(frames_ms(clean.final_target) < LINK_TARGET_MIN_MS + 20);
+    CHECK(clean.latency_ms_sum / clean.latency_samples <
+          clean_fixed.latency_ms_sum / clean_fixed.latency_samples - 50.0);
+
+    sim_result_t bursty = run(TRACE_BURSTY, 60);
+    CHECK(bursty.steady_underruns == 0);
+    CHECK(frames_ms(bursty.final_target) < LINK_TARGET_INITIAL_MS);
+
+    sim_result_t coex = run(TRACE_COEX, 60);
+    CHECK(coex.steady_underruns == 0);
+    // 途切れ（最大 150 ms）の分より深く保つ
+    CHECK(frames_ms(coex.target_min) > 150.0);
+
+    sim_result_t degrade = run(TRACE_DEGRADE, 80);
+    printf("  degrade: target peak %.1f ms while degraded, %.1f ms after 40 s clean\n",
+           frames_ms(degrade.degrade_peak), frames_ms(degrade.final_target));
+    // 劣化の最初の途切れでアンダーランしても、その後は深くして持ちこたえる
+    CHECK(degrade.steady_underruns <= 2);
+    CHECK(frames_ms(degrade.degrade_peak) > 250.0);
+    CHECK(degrade.final_target < degrade.degrade_peak);
+    CHECK(frames_ms(degrade.final_target) < LINK_TARGET_INITIAL_MS);
+}
+
+static void test_event_margins(void) {
+    printf("Event margins:\n");
+
+    // 規則的なパケットで下限まで下げてから、フロー系イベントでマージンが上乗せされる
+    link_monitor_init(FS);
+    uint32_t t = 0;
+    double period = PACKET_FRAMES * 1e6 / FS;
+    for (uint32_t k = 0; k < 40000000 / period; k++) {
+        t = (uint32_t)(k * period);
+        link_monitor_on_packet(t, PACKET_FRAMES);
+    }
+    uint32_t floor_frames = link_monitor_get_target_frames();
+    link_monitor_on_flow_event(t);
+    uint32_t raised = link_monitor_get_target_frames();
+    printf("  after 40 s clean: %.1f ms; flow event: %.1f ms\n", frames_ms(floor_frames), frames_ms(raised));
+    CHECK(floor_frames == (uint32_t)((uint64_t)LINK_TARGET_MIN_MS * FS / 1000));
+    CHECK(raised == floor_frames + (uint32_t)((uint64_t)LINK_EVENT_MARGIN_MS * FS / 1000));
+
+    link_monitor_stats_t st;
+    link_monitor_get_stats(&st);
+    CHECK(st.flow_events == 1);
+    CHECK(st.gaps == 0);
+    CHECK(st.target_frames == raised);
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_traces();
+    test_event_margins();
+    return test_summary("test_link_monitor");
+}
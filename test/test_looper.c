@@ -0,0 +1,431 @@
+/**
+ * @file test_looper.c
+ * @brief ルーパーのホスト測定（メモリ、エンコード/デコードのコスト、オーバーダブのノイズの蓄積）
+ *
+ * looper.c を取り込み、
+ * - 圧縮メモリの使い方（ブロックの大きさ、小節あたりのバイト数、テンポごとの最大小節数）と、
+ *   スライスバッファと同じ大きさの提供元からの借り方（90 BPM の4小節は半レート、
+ *   借りられなければ録音しない、消去で返す）
+ * - 半レートの間引き/補間フィルタの周波数特性（通過域の平坦さ、折り返しの減衰、遅延）と、
+ *   90 BPM の4小節を半レートで録音したループの SNR
+ * - 1ブロックのエンコード/デコードのホストサイクル数と、再生/オーバーダブ中の
+ *   looper_process() のフレームあたりのコスト
+ * - 録音したループの SNR と、入力なしでオーバーダブを重ねた時に再エンコードの
+ *   量子化ノイズがどれだけ溜まるか（フィードバック 1.0 と既定の 0.9）
+ * を測る。ターゲットのサイクル数は [LOOPER] のステータスログ（looper_get_stats()）で見る。
+ */
+
+#include "../src/looper.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS          44100
+#define BPM         120.0f
+#define BAR_FRAMES  (FS * 2)       // 120 BPM の1小節
+#define BLOCK       512
+#define PASSES      16
+
+#define BARS_90       4
+#define LOOP_90       (FS * 60 * 4 * BARS_90 / 90)     // 90 BPM の4小節（470400 フレーム、割り切れる）
+#define SLICE_BYTES   (FS * 2 * 2)     // Beat-Repeat のスライスバッファ（1秒 × L/R × 16ビット）
+
+// ============================================================================
+// 圧縮メモリの提供元（Beat-Repeat のスライスバッファの代わり）
+// ============================================================================
+
+static uint8_t provider_memory[SLICE_BYTES];
+static bool provider_busy = false;      // true = エフェクトが有効で貸せない
+static bool provider_lent = false;
+static uint32_t provider_acquires = 0;
+static uint32_t provider_releases = 0;
+
+static void *provider_acquire(void) {
+    if (provider_busy || provider_lent) return NULL;
+    provider_lent = true;
+    provider_acquires++;
+    return provider_memory;
+}
+
+static void provider_release(void) {
+    provider_lent = false;
+    provider_releases++;
+}
+
+// ============================================================================
+// 入力信号（2音 + 減衰するノイズのバースト、-10 dBFS 前後）
+// ============================================================================
+
+static int16_t signal_buf[BAR_FRAMES];
+
+static void make_signal(void) {
+    uint32_t rng = 9;
+    for (uint32_t t = 0; t < BAR_FRAMES; t++) {
+        uint32_t since_hit = t % (FS / 2);
+        double burst = exp(-(double)since_hit / 800.0);
+        double noise = ((double)(test_rand(&rng) >> 16) / 32768.0 - 1.0) * 9000.0 * burst;
+        double tone = 5000.0 * sin(2.0 * M_PI * 110.0 * t / FS) +
+                      2500.0 * sin(2.0 * M_PI * 1375.0 * t / FS);
+        signal_buf[t] = (int16_t)lrint(noise + tone);
+    }
+}
+
+static double rms_db(double sum_sq, uint32_t n) {
+    return 10.0 * log10(sum_sq / n / (32768.0 * 32768.0) + 1e-20);
+}
+
+/**
+ * @brief frames フレームを流す（input が NULL なら無音）。出力（左）を out に返す
+ */
+static void run_frames(const int16_t *input, int16_t *out, uint32_t frames) {
+    static int16_t l[BLOCK], r[BLOCK];
+    for (uint32_t pos = 0; pos < frames; pos += BLOCK) {
+        uint32_t n = frames - pos;
+        if (n > BLOCK) n = BLOCK;
+        for (uint32_t i = 0; i < n; i++) {
+            l[i] = r[i] = input ? input[pos + i] : 0;
+        }
+        looper_process(l, r, n);
+        beat_clock_advance(n);
+        if (out) memcpy(&out[pos], l, n * sizeof(int16_t));
+    }
+}
+
+static void run_bar(const int16_t *input, int16_t *out) {
+    run_frames(input, out, BAR_FRAMES);
+}
+
+// ============================================================================
+// メモリ
+// ============================================================================
+
+static void test_memory(void) {
+    printf("Compressed memory (%d ch, %d-frame blocks):\n", LOOPER_CHANNELS, LOOPER_BLOCK_FRAMES);
+
+    double bits_per_sample = 8.0 * ADPCM_BLOCK_BYTES / LOOPER_BLOCK_FRAMES;
+    printf("  %u bytes (slice buffer) = %u blocks x %u bytes, %.3f bits/sample (%.2fx smaller than 16-bit PCM)\n",
+           (unsigned)memory_bytes, (unsigned)num_blocks, (unsigned)LOOPER_BLOCK_STRIDE,
+           bits_per_sample, 16.0 / bits_per_sample);
+
+    static const float tempos[] = { 90.0f, 120.0f, 140.0f };
+    for (uint32_t t = 0; t < sizeof(tempos) / sizeof(tempos[0]); t++) {
+        double bar = (double)BEATS_PER_BAR * 60.0 / tempos[t] * FS;
+        uint32_t blocks_per_bar = (uint32_t)ceil(bar / LOOPER_BLOCK_FRAMES);
+        printf("  %5.1f BPM: %6.0f frames/bar, %6u bytes/bar, max %lu bar(s); 4 bars need %u bytes\n",
+               tempos[t], bar, blocks_per_bar * LOOPER_BLOCK_STRIDE,
+               looper_get_max_bars(tempos[t]), (unsigned)((uint32_t)ceil(4.0 * bar / LOOPER_BLOCK_FRAMES) *
+                                                          LOOPER_BLOCK_STRIDE));
+    }
+    CHECK(looper_get_max_bars(90.0f) >= BARS_90);
+    CHECK(looper_get_max_bars(120.0f) >= 2);
+
+    // 収まらない小節数は収まる数に減らす
+    beat_clock_init(FS);
+    beat_clock_set_bpm(BPM);
+    looper_clear();
+    CHECK(looper_record(8));
+    looper_stats_t st;
+    looper_get_stats(&st);
+    printf("  record(8) at %.0f BPM: %lu frames, %lu of %lu bytes used\n",
+           BPM, st.loop_frames, st.used_bytes, st.memory_bytes);
+    CHECK(st.loop_frames == looper_get_max_bars(BPM) * BAR_FRAMES);
+    CHECK(st.used_bytes <= st.memory_bytes);
+    CHECK(st.loop_frames <= st.capacity_frames);
+    looper_clear();
+
+    // 90 BPM: 2小節は原レート、4小節は半レートで収まる
+    beat_clock_set_bpm(90.0f);
+    static const uint32_t bars_90[2] = { 2, BARS_90 };
+    for (uint32_t b = 0; b < 2; b++) {
+        CHECK(looper_record(bars_90[b]));
+        looper_get_stats(&st);
+        printf("  record(%lu) at 90 BPM: %lu frames, %s rate, %lu of %lu bytes used\n",
+               bars_90[b], st.loop_frames, st.half_rate ? "half" : "full", st.used_bytes, st.memory_bytes);
+        CHECK(st.loop_frames == (uint32_t)(FS * 60.0 / 90.0 * 4.0 * bars_90[b] + 0.5));
+        CHECK(st.half_rate == (bars_90[b] == BARS_90));
+        CHECK(st.used_bytes <= st.memory_bytes);
+        CHECK(st.memory_held && provider_lent);
+        looper_clear();
+    }
+
+    // 消去で返し、次の録音でまた借りる（録音し直しは借りたまま）
+    uint32_t acquires = provider_acquires, releases = provider_releases;
+    CHECK(looper_record(1));
+    CHECK(looper_record(2));
+    looper_clear();
+    CHECK(provider_acquires == acquires + 1 && provider_releases == releases + 1);
+    CHECK(!provider_lent);
+
+    // エフェクトが有効で借りられなければ録音しない
+    provider_busy = true;
+    CHECK(!looper_record(1));
+    CHECK(looper_get_state() == LOOPER_IDLE);
+    looper_get_stats(&st);
+    CHECK(!st.memory_held);
+    provider_busy = false;
+    looper_clear();
+    CHECK(provider_releases == releases + 1);
+}
+
+// ============================================================================
+// 半レート
+// ============================================================================
+
+/**
+ * @brief 正弦波を間引き→補間だけに通した時のゲイン（dB、遅延を合わせた入力との比）
+ * @param out_db 出力のレベル（dB、入力比、周波数を問わない）
+ */
+static double half_rate_gain(double freq, double *out_db) {
+    const uint32_t frames = 8192;
+    const uint32_t settle = 256;
+    const uint32_t delay = RS_TAPS - 1;
+    const double amp = 16000.0;
+
+    decimation = 2;
+    reset_resampler();
+
+    double in_sum = 0.0, out_sum = 0.0, dot = 0.0, ref_sum = 0.0;
+    for (uint32_t t = 0; t < frames; t++) {
+        int32_t in[LOOPER_CHANNELS];
+        for (uint32_t ch = 0; ch < LOOPER_CHANNELS; ch++) {
+            in[ch] = (int32_t)lrint(amp * sin(2.0 * M_PI * freq * t / FS));
+        }
+        push_decimator(in);
+        uint32_t phase = t & 1;
+        if (phase == 0) {
+            if (++up_pos >= RS_HIST_SAMPLES) up_pos = 0;
+            push_interpolator(0, decimate(0));
+        }
+        int16_t y = interpolate(0, phase);
+        if (t >= settle) {
+            double ref = amp * sin(2.0 * M_PI * freq * ((double)t - delay) / FS);
+            in_sum += amp * amp / 2.0;
+            out_sum += (double)y * y;
+            dot += (double)y * ref;
+            ref_sum += ref * ref;
+        }
+    }
+    decimation = 1;
+    *out_db = 10.0 * log10(out_sum / in_sum + 1e-20);
+    return 20.0 * log10(fabs(dot) / ref_sum + 1e-20);
+}
+
+static void test_half_rate_filter(void) {
+    printf("Half-rate filter (%d-tap halfband, decimate + interpolate, delay %d frames):\n",
+           RS_TAPS, RS_TAPS - 1);
+
+    int32_t sum = 0;
+    for (uint32_t j = 0; j < RS_TAPS; j++) sum += rs_coeffs[j];
+    CHECK(sum == 32768);
+
+    static const double pass[] = { 100.0, 1000.0, 4000.0, 8000.0, 9000.0, 9300.0 };
+    printf("  passband gain (dB):");
+    for (uint32_t f = 0; f < sizeof(pass) / sizeof(pass[0]); f++) {
+        double level;
+        double g = half_rate_gain(pass[f], &level);
+        printf(" %.0f Hz %+.2f", pass[f], g);
+        CHECK(fabs(g) < ((pass[f] <= 8000.0) ? 0.2 : 1.0));
+    }
+    printf("\n");
+
+    // 半レートのナイキスト（11025 Hz）より上は折り返さずに落とす
+    static const double stop[] = { 13500.0, 15000.0, 18000.0, 21000.0 };
+    printf("  output level above half-rate Nyquist (dB):");
+    for (uint32_t f = 0; f < sizeof(stop) / sizeof(stop[0]); f++) {
+        double level;
+        half_rate_gain(stop[f], &level);
+        printf(" %.0f Hz %.1f", stop[f], level);
+        CHECK(level < -55.0);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief 90 BPM の4小節を半レートで録音し、再生を遅延を合わせた入力と比べる
+ */
+static void test_half_rate_loop(void) {
+    static int16_t in[LOOP_90], out[LOOP_90];
+    const uint32_t delay = RS_TAPS - 1;
+
+    // 3音（最高 7 kHz）+ 減衰するノイズのバースト
+    uint32_t rng = 5;
+    for (uint32_t t = 0; t < LOOP_90; t++) {
+        uint32_t since_hit = t % (FS * 2 / 3);
+        double burst = exp(-(double)since_hit / 800.0);
+        double noise = ((double)(test_rand(&rng) >> 16) / 32768.0 - 1.0) * 6000.0 * burst;
+        double tone = 5000.0 * sin(2.0 * M_PI * 110.0 * t / FS) +
+                      2500.0 * sin(2.0 * M_PI * 1375.0 * t / FS) +
+                      1000.0 * sin(2.0 * M_PI * 7000.0 * t / FS);
+        in[t] = (int16_t)lrint(noise + tone);
+    }
+
+    beat_clock_init(FS);
+    beat_clock_set_bpm(90.0f);
+    looper_clear();
+    looper_set_level(1.0f);
+    CHECK(looper_record(BARS_90));
+    run_frames(in, NULL, LOOP_90);
+    CHECK(looper_get_state() == LOOPER_PLAYING);
+    run_frames(NULL, out, LOOP_90);
+
+    looper_stats_t st;
+    looper_get_stats(&st);
+
+    // 頭の遅延分（録音前の無音から立ち上がる）は比べない
+    double sig = 0.0, err = 0.0;
+    for (uint32_t t = 2 * delay; t < LOOP_90; t++) {
+        double d = out[t] - in[t - delay];
+        sig += (double)in[t - delay] * in[t - delay];
+        err += d * d;
+    }
+    double snr = 10.0 * log10(sig / err);
+    printf("Half-rate loop (%d bars at 90 BPM = %lu frames, %lu bytes): SNR %.1f dB vs. input delayed %lu frames\n",
+           BARS_90, st.loop_frames, st.used_bytes, snr, delay);
+    CHECK(st.half_rate);
+    CHECK(snr > 15.0);
+    looper_clear();
+}
+
+// ============================================================================
+// オーバーダブのノイズ
+// ============================================================================
+
+/**
+ * @brief 1小節録音し、入力なしで PASSES 回オーバーダブした時の誤差（対 信号 × F^n）
+ * @return 最後のパスの誤差（dBFS）
+ */
+static double overdub_noise(float feedback, double *first_snr) {
+    static int16_t out[BAR_FRAMES];
+
+    beat_clock_init(FS);
+    beat_clock_set_bpm(BPM);
+    looper_clear();
+    looper_set_level(1.0f);
+    looper_set_feedback(feedback);
+    looper_record(1);
+    looper_set_overdub(true);
+
+    // 録音
+    run_bar(signal_buf, NULL);
+    CHECK(looper_get_state() == LOOPER_RECORDING || looper_get_state() == LOOPER_PLAYING);
+
+    printf("  feedback %.2f: error vs. signal x F^n by pass (dBFS):", feedback);
+    double err_db = 0.0;
+    double sig_sum = 0.0;
+    for (uint32_t t = 0; t < BAR_FRAMES; t++) sig_sum += (double)signal_buf[t] * signal_buf[t];
+
+    // パス p の出力 = p - 1 回オーバーダブしたループ
+    for (uint32_t p = 1; p <= PASSES; p++) {
+        run_bar(NULL, out);
+        double gain = pow((double)(int32_t)(feedback * 32768.0f) / 32768.0, (double)(p - 1));
+        double err = 0.0;
+        for (uint32_t t = 0; t < BAR_FRAMES; t++) {
+            double d = out[t] - signal_buf[t] * gain;
+            err += d * d;
+        }
+        err_db = rms_db(err, BAR_FRAMES);
+        if (p == 1) *first_snr = 10.0 * log10(sig_sum / err);
+        if (p == 1 || p == 2 || p == 4 || p == 8 || p == 16) printf(" %u:%.1f", p - 1, err_db);
+    }
+    printf("\n");
+    CHECK(looper_get_state() == LOOPER_OVERDUB);
+    looper_clear();
+    return err_db;
+}
+
+static void test_overdub_noise(void) {
+    double sig = 0.0;
+    for (uint32_t t = 0; t < BAR_FRAMES; t++) sig += (double)signal_buf[t] * signal_buf[t];
+    printf("Overdub noise accumulation (1 bar at %.0f BPM, signal %.1f dBFS, no input while overdubbing):\n",
+           BPM, rms_db(sig, BAR_FRAMES));
+
+    double snr_unity, snr_default;
+    double last_unity = overdub_noise(1.0f, &snr_unity);
+    double last_default = overdub_noise(LOOPER_FEEDBACK, &snr_default);
+    printf("  recorded loop SNR %.1f dB; after %u overdubs: %.1f dBFS (F=1.0), %.1f dBFS (F=%.2f)\n",
+           snr_unity, PASSES - 1, last_unity, last_default, LOOPER_FEEDBACK);
+
+    CHECK(snr_unity > 20.0);
+    // 再エンコードのノイズは溜まるが、F=1.0 で15回重ねても信号より十分小さい
+    CHECK(last_unity < rms_db(sig, BAR_FRAMES) - 10.0);
+    // F < 1 では古い層のノイズも減衰するので F=1.0 より大きくならない
+    CHECK(last_default <= last_unity + 1.0);
+}
+
+// ============================================================================
+// コスト
+// ============================================================================
+
+static void bench(void) {
+    printf("Encode/decode cost (host):\n");
+
+    static uint8_t block[ADPCM_BLOCK_BYTES];
+    static int16_t pcm[LOOPER_BLOCK_FRAMES];
+    const int reps = 20000;
+    uint64_t best_enc = UINT64_MAX, best_dec = UINT64_MAX;
+    for (int round = 0; round < 5; round++) {
+        uint8_t index = 0;
+        uint64_t c0 = bench_cycles();
+        for (int r = 0; r < reps; r++) {
+            uint32_t off = (uint32_t)(r * 97) % (BAR_FRAMES - LOOPER_BLOCK_FRAMES);
+            adpcm_encode_block(&signal_buf[off], LOOPER_BLOCK_FRAMES, block, &index);
+        }
+        uint64_t c1 = bench_cycles();
+        for (int r = 0; r < reps; r++) {
+            adpcm_decode_block(block, LOOPER_BLOCK_FRAMES, pcm);
+        }
+        uint64_t c2 = bench_cycles();
+        bench_sink(block, sizeof(block));
+        bench_sink(pcm, sizeof(pcm));
+        if (c1 - c0 < best_enc) best_enc = c1 - c0;
+        if (c2 - c1 < best_dec) best_dec = c2 - c1;
+    }
+    double enc = (double)best_enc / reps, dec = (double)best_dec / reps;
+    printf("  encode %.0f, decode %.0f host cycles per %d-frame block (%.1f / %.1f per sample)\n",
+           enc, dec, LOOPER_BLOCK_FRAMES, enc / LOOPER_BLOCK_FRAMES, dec / LOOPER_BLOCK_FRAMES);
+
+    // 再生/オーバーダブ中のブロック処理（デコード/エンコードとミックスを含む）
+    double per_frame[2];
+    for (int overdub = 0; overdub < 2; overdub++) {
+        beat_clock_init(FS);
+        beat_clock_set_bpm(BPM);
+        looper_clear();
+        looper_set_feedback(LOOPER_FEEDBACK);
+        looper_record(1);
+        looper_set_overdub(overdub);
+        run_bar(signal_buf, NULL);
+        run_bar(NULL, NULL);   // 切り替えがブロック境界で反映されるまで
+
+        uint64_t best = UINT64_MAX;
+        for (int round = 0; round < 5; round++) {
+            uint64_t c0 = bench_cycles();
+            run_bar(signal_buf, NULL);
+            uint64_t c1 = bench_cycles();
+            if (c1 - c0 < best) best = c1 - c0;
+        }
+        CHECK(looper_get_state() == (overdub ? LOOPER_OVERDUB : LOOPER_PLAYING));
+        per_frame[overdub] = (double)best / BAR_FRAMES;
+        looper_clear();
+    }
+    printf("  looper_process(): %.1f host cycles/frame playing, %.1f overdubbing (incl. input copy)\n",
+           per_frame[0], per_frame[1]);
+    printf("  (target cycles: [LOOPER] status log, encode/decode cycles per block)\n");
+
+    CHECK(dec <= enc);
+}
+
+int main(void) {
+    host_sdk_reset();
+    make_signal();
+    looper_init(FS);
+    looper_set_memory(SLICE_BYTES, provider_acquire, provider_release);
+
+    test_memory();
+    test_half_rate_filter();
+    test_half_rate_loop();
+    test_overdub_noise();
+    bench();
+    return test_summary("test_looper");
+}
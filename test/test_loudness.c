@@ -0,0 +1,200 @@
+/**
+ * @file test_loudness.c
+ * @brief ラウドネスメーターのホストテスト（EBU Tech 3341 の適合試験とブロックあたりのコスト）
+ *
+ * Tech 3341 の試験信号のうち、ステレオでモーメンタリー/ショートタームに関係するものを
+ * 生成して確かめる（統合ラウドネスと LRA は実装していないので対象外）。
+ *   - 試験1/2: 1kHz 正弦波 -23 / -33 dBFS → M, S = -23.0 / -33.0 ±0.1 LU
+ *   - 試験9:   -20 dBFS 1.34秒 / -30 dBFS 1.66秒 の繰り返し → 3秒以降の S = -23.0 ±0.1 LU
+ *   - 0.4秒のバースト（-23 LUFS）→ M の最大値 = -23.0 ±0.1 LU
+ *     （メーターの更新は 100ms ごとなので、バーストの開始が 100ms 境界からずれると最大値は
+ *       下がる。ずれの影響は数字で表示し、Tech 3341 の最低更新レート 10Hz の範囲で許容する）
+ * あわせて、48kHz の Kウェイティング係数が ITU-R BS.1770 の表の値と一致すること、
+ * 無音のゲート、AGC のスルーレートを確かめ、ブロックあたりのコストを測る。
+ */
+
+#include "../src/loudness.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS        44100
+#define BLOCK     256
+
+static uint32_t sample_pos = 0;
+
+/**
+ * @brief 1kHz の正弦波（ピーク dbfs）を frames フレーム流し、各サブブロックの M/S を記録する
+ */
+static void feed_sine(double dbfs, double seconds, float *max_m, float *last_m, float *last_s) {
+    int16_t l[BLOCK], r[BLOCK];
+    double amp = pow(10.0, dbfs / 20.0) * 32768.0;
+    uint32_t frames = (uint32_t)lround(seconds * FS);
+
+    for (uint32_t done = 0; done < frames; done += BLOCK) {
+        uint32_t n = frames - done;
+        if (n > BLOCK) n = BLOCK;
+        for (uint32_t i = 0; i < n; i++) {
+            double v = (dbfs <= -200.0) ? 0.0 : amp * sin(2.0 * M_PI * 1000.0 * (double)(sample_pos + i) / FS);
+            long q = lround(v);
+            if (q > 32767) q = 32767;
+            l[i] = (int16_t)q;
+            r[i] = (int16_t)q;
+        }
+        sample_pos += n;
+        loudness_process(l, r, n);
+        if (max_m && loudness_get_momentary() > *max_m) *max_m = loudness_get_momentary();
+    }
+    if (last_m) *last_m = loudness_get_momentary();
+    if (last_s) *last_s = loudness_get_short_term();
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_coefficients(void) {
+    printf("K-weighting coefficients at 48 kHz (ITU-R BS.1770 table):\n");
+
+    design_k_weighting(48000);
+    CHECK_NEAR(k_shelf.b0, 1.53512485958697, 1e-5);
+    CHECK_NEAR(k_shelf.b1, -2.69169618940638, 1e-5);
+    CHECK_NEAR(k_shelf.b2, 1.19839281085285, 1e-5);
+    CHECK_NEAR(k_shelf.a1, -1.69065929318241, 1e-5);
+    CHECK_NEAR(k_shelf.a2, 0.73248077421585, 1e-5);
+    CHECK_NEAR(k_highpass.a1, -1.99004745483398, 1e-5);
+    CHECK_NEAR(k_highpass.a2, 0.99007225036621, 1e-5);
+    printf("  shelf b = %.8f %.8f %.8f, a = %.8f %.8f\n",
+           k_shelf.b0, k_shelf.b1, k_shelf.b2, k_shelf.a1, k_shelf.a2);
+    printf("  high-pass a = %.8f %.8f\n", k_highpass.a1, k_highpass.a2);
+
+    loudness_init(FS);
+}
+
+static void test_steady_sine(double dbfs) {
+    float m, s;
+    loudness_reset();
+    feed_sine(dbfs, 20.0, NULL, &m, &s);
+    printf("  1 kHz %.0f dBFS, 20 s: M %.2f, S %.2f LUFS\n", dbfs, m, s);
+    CHECK_NEAR(m, dbfs, 0.1);
+    CHECK_NEAR(s, dbfs, 0.1);
+}
+
+static void test_case_9(void) {
+    // -20 dBFS 1.34秒 + -30 dBFS 1.66秒 = 3秒周期。3秒窓の S は常に -23 LUFS になる
+    float worst = 0.0f;
+    loudness_reset();
+    for (int rep = 0; rep < 5; rep++) {
+        float s;
+        feed_sine(-20.0, 1.34, NULL, NULL, &s);
+        if (rep > 0 && fabsf(s + 23.0f) > fabsf(worst)) worst = s + 23.0f;
+        feed_sine(-30.0, 1.66, NULL, NULL, &s);
+        if (rep > 0 && fabsf(s + 23.0f) > fabsf(worst)) worst = s + 23.0f;
+    }
+    printf("  case 9 (-20/-30 dBFS, 1.34/1.66 s): S deviation after 3 s %+.3f LU\n", worst);
+    CHECK(fabsf(worst) <= 0.1f);
+}
+
+static void test_momentary_bursts(void) {
+    // 0.4秒のバースト: 100ms 境界にそろえたときは最大 M が -23 LUFS ちょうど
+    float worst_aligned = 0.0f;
+    float worst_unaligned = 0.0f;
+    for (int offset_ms = 0; offset_ms < 100; offset_ms += 10) {
+        float max_m = LOUDNESS_SILENCE_LUFS;
+        loudness_reset();
+        sample_pos = 0;
+        feed_sine(-300.0, 1.0 + offset_ms / 1000.0, NULL, NULL, NULL);
+        feed_sine(-23.0, 0.4, &max_m, NULL, NULL);
+        feed_sine(-300.0, 1.0, &max_m, NULL, NULL);
+        float dev = max_m + 23.0f;
+        if (offset_ms == 0) {
+            worst_aligned = dev;
+        } else if (fabsf(dev) > fabsf(worst_unaligned)) {
+            worst_unaligned = dev;
+        }
+    }
+    printf("  0.4 s bursts at -23 LUFS: max M deviation %+.3f LU aligned, %+.3f LU worst unaligned\n",
+           worst_aligned, worst_unaligned);
+    CHECK(fabsf(worst_aligned) <= 0.1f);
+    // 100ms 更新: 最悪でも窓の 1/4 が欠ける程度（10*log10(0.75) = -1.25 LU）
+    CHECK(worst_unaligned >= -1.3f && worst_unaligned <= 0.1f);
+}
+
+static void test_conformance(void) {
+    printf("EBU Tech 3341 (stereo, momentary / short-term):\n");
+    test_steady_sine(-23.0);
+    test_steady_sine(-33.0);
+    test_case_9();
+    test_momentary_bursts();
+
+    // 無音はゲートされて -120 LUFS（表示の下限）
+    float m, s;
+    loudness_reset();
+    feed_sine(-300.0, 4.0, NULL, &m, &s);
+    CHECK(m == LOUDNESS_SILENCE_LUFS && s == LOUDNESS_SILENCE_LUFS);
+}
+
+static void test_agc(void) {
+    printf("AGC:\n");
+
+    // -30 LUFS の入力: 目標 -16 LUFS との差 14dB は最大ブーストで制限され、
+    // ゲインは 1dB/秒のスルーレートで上がる
+    loudness_reset();
+    loudness_set_agc_enabled(true);
+    float m, s;
+    feed_sine(-30.0, 5.0, NULL, &m, &s);
+    float gain_5s = loudness_get_agc_gain_db();
+    feed_sine(-30.0, 15.0, NULL, &m, &s);
+    float gain_20s = loudness_get_agc_gain_db();
+    printf("  -30 LUFS input: gain %.2f dB after 5 s, %.2f dB after 20 s\n", gain_5s, gain_20s);
+    // 最初の 100ms はサブブロックが確定していない
+    CHECK_NEAR(gain_5s, 4.9, 0.15);
+    CHECK_NEAR(gain_20s, LOUDNESS_AGC_MAX_GAIN_DB, 0.01);
+    loudness_set_agc_enabled(false);
+}
+
+static void bench_block(void) {
+    printf("Cost per %d-frame block (host):\n", BLOCK);
+
+    // AGC はブロックを上書きするので、毎回元の信号をコピーして処理する
+    int16_t src_l[BLOCK], src_r[BLOCK], l[BLOCK], r[BLOCK];
+    uint32_t rng = 7;
+    for (int i = 0; i < BLOCK; i++) {
+        src_l[i] = (int16_t)(test_rand(&rng) >> 4);
+        src_r[i] = (int16_t)(test_rand(&rng) >> 4);
+    }
+
+    for (int agc = 0; agc < 2; agc++) {
+        loudness_reset();
+        agc_enabled = agc;
+        const int blocks = 20000;
+        uint64_t t0 = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        for (int b = 0; b < blocks; b++) {
+            memcpy(l, src_l, sizeof(l));
+            memcpy(r, src_r, sizeof(r));
+            loudness_process(l, r, BLOCK);
+        }
+        uint64_t c1 = bench_cycles();
+        uint64_t t1 = bench_now_ns();
+        bench_sink(l, sizeof(l));
+        printf("  AGC %-3s: %.0f ns/block, %.0f host cycles/block (%.1f/frame)\n",
+               agc ? "on" : "off", (double)(t1 - t0) / blocks, (double)(c1 - c0) / blocks,
+               (double)(c1 - c0) / blocks / BLOCK);
+    }
+    agc_enabled = false;
+    printf("  (target cycles: loudness_get_cycles() on the device, [LOUDNESS] status log)\n");
+}
+
+int main(void) {
+    host_sdk_reset();
+    loudness_init(FS);
+
+    test_coefficients();
+    test_conformance();
+    test_agc();
+    bench_block();
+    return test_summary("test_loudness");
+}
@@ -0,0 +1,159 @@
+/**
+ * @file test_mod_matrix.c
+ * @brief モジュレーションマトリクスのホストテストと、アクティブなルート数ごとのコスト
+ *
+ * - サイン/ノコギリの LFO が拍位置に位相ロックしていること、エンベロープの AD、
+ *   同じ行き先へのルートが足し合わされることを確かめる
+ * - ルートを 0〜MOD_MATRIX_MAX_ROUTES 本にして mod_matrix_process() 1回あたりの
+ *   ホストのサイクル数を測り、モジュレーター + ルート、ルートだけの増分を求める
+ *   （ターゲットの数字は mod_matrix_get_cycles() が time_us_32() の差の合計から報告する）
+ */
+
+#include "../src/mod_matrix.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS          44100
+#define SUB_BLOCK   256
+
+// 1拍 = 0.5秒（120 BPM）を 32.32 の拍位置で
+static uint64_t beat_q32_at(uint64_t frame) {
+    return (uint64_t)((double)frame / (FS / 2.0) * 4294967296.0);
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_phase_lock(void) {
+    printf("LFO phase lock and route sums:\n");
+
+    mod_matrix_init(FS);
+    mod_source_params_t sine = { MOD_SHAPE_SINE, 1.0f, 0.25f, 0.0f, 0.0f };
+    mod_source_params_t saw = { MOD_SHAPE_SAW, 4.0f, 0.0f, 0.0f, 0.0f };
+    mod_matrix_set_source(0, &sine);
+    mod_matrix_set_source(1, &saw);
+    CHECK(mod_matrix_add_route(0, MOD_DEST_WET_MIX, 10.0f) >= 0);
+    CHECK(mod_matrix_add_route(1, MOD_DEST_WET_MIX, 5.0f) >= 0);
+    CHECK(mod_matrix_get_active_routes() == 2);
+
+    double worst = 0.0;
+    for (uint64_t frame = SUB_BLOCK; frame < FS * 10; frame += SUB_BLOCK) {
+        mod_matrix_process(beat_q32_at(frame), SUB_BLOCK);
+        float start, end;
+        CHECK(mod_matrix_get_ramp(MOD_DEST_WET_MIX, &start, &end));
+
+        double beats = (double)frame / (FS / 2.0);
+        double expected = 10.0 * sin(2.0 * M_PI * (beats + 0.25)) +
+                          5.0 * (2.0 * fmod(beats / 4.0, 1.0) - 1.0);
+        double err = fabs(end - expected);
+        // ノコギリの最後のテーブル1区間は先頭（-1）へ補間するので除く
+        if (fmod(beats / 4.0, 1.0) < 255.0 / 256.0 && err > worst) worst = err;
+    }
+    printf("  sine (1 beat, phase 0.25) x10 + saw (4 beats) x5: max error %.4f\n", worst);
+    CHECK(worst < 0.01);
+
+    // 使っていない行き先はランプなし
+    float start, end;
+    CHECK(!mod_matrix_get_ramp(MOD_DEST_PITCH_SHIFT, &start, &end));
+    CHECK(start == 0.0f && end == 0.0f);
+}
+
+static void test_envelope(void) {
+    printf("AD envelope:\n");
+
+    mod_matrix_init(FS);
+    mod_source_params_t env = { MOD_SHAPE_ENVELOPE, 1.0f, 0.0f, 10.0f, 100.0f };
+    mod_matrix_set_source(2, &env);
+    mod_matrix_add_route(2, MOD_DEST_LOOP_START, 1.0f);
+
+    float start, end;
+    mod_matrix_process(0, SUB_BLOCK);
+    mod_matrix_get_ramp(MOD_DEST_LOOP_START, &start, &end);
+    CHECK(end == 0.0f);
+
+    // アタック 10ms = 441 フレーム → 2 サブブロックで頂点
+    mod_matrix_trigger();
+    uint32_t blocks_to_peak = 0, blocks_to_zero = 0;
+    for (uint32_t b = 1; b < 100; b++) {
+        mod_matrix_process(0, SUB_BLOCK);
+        mod_matrix_get_ramp(MOD_DEST_LOOP_START, &start, &end);
+        if (!blocks_to_peak && end >= 1.0f) blocks_to_peak = b;
+        if (blocks_to_peak && !blocks_to_zero && end <= 0.0f) blocks_to_zero = b - blocks_to_peak;
+    }
+    printf("  peak after %u sub-blocks, back to 0 after %u more\n", blocks_to_peak, blocks_to_zero);
+    CHECK(blocks_to_peak == 2);
+    // ディケイ 100ms = 4410 フレーム → 18 サブブロック
+    CHECK(blocks_to_zero == 18);
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench_routes(void) {
+    printf("mod_matrix_process() cost by active routes (host, %d-frame sub-blocks):\n", SUB_BLOCK);
+
+    static const mod_source_params_t sources_p[MOD_MATRIX_NUM_SOURCES] = {
+        { MOD_SHAPE_SINE, 1.0f, 0.0f, 0.0f, 0.0f },
+        { MOD_SHAPE_TRIANGLE, 0.5f, 0.3f, 0.0f, 0.0f },
+        { MOD_SHAPE_SAMPLE_HOLD, 0.25f, 0.0f, 0.0f, 0.0f },
+        { MOD_SHAPE_ENVELOPE, 1.0f, 0.0f, 5.0f, 200.0f },
+    };
+
+    // ターゲットの time_us_32() はタイマーのレジスタを読むだけなので、ホストも仮想時刻にして
+    // 計測の呼び出し（ホストの実時間は clock_gettime）を評価のコストに混ぜない
+    host_time_set_virtual(true);
+
+    double cycles[MOD_MATRIX_MAX_ROUTES + 1];
+    for (uint32_t n = 0; n <= MOD_MATRIX_MAX_ROUTES; n++) {
+        mod_matrix_init(FS);
+        for (uint32_t s = 0; s < MOD_MATRIX_NUM_SOURCES; s++) mod_matrix_set_source(s, &sources_p[s]);
+        for (uint32_t r = 0; r < n; r++) {
+            mod_matrix_add_route(r % MOD_MATRIX_NUM_SOURCES, (mod_dest_t)(r % MOD_NUM_DESTS), 0.5f);
+        }
+        CHECK(mod_matrix_get_active_routes() == n);
+
+        const uint32_t evals = 200000;
+        uint64_t best = UINT64_MAX;
+        for (int rep = 0; rep < 3; rep++) {
+            uint64_t frame = 0;
+            uint64_t c0 = bench_cycles();
+            for (uint32_t i = 0; i < evals; i++) {
+                frame += SUB_BLOCK;
+                if ((i & 63) == 0) mod_matrix_trigger();
+                mod_matrix_process(beat_q32_at(frame), SUB_BLOCK);
+            }
+            uint64_t c1 = bench_cycles();
+            if (c1 - c0 < best) best = c1 - c0;
+        }
+        bench_sink(dest_end, sizeof(dest_end));
+        cycles[n] = (double)best / evals;
+        printf("  %u route(s), %u source(s): %.1f host cycles/eval\n",
+               n, (unsigned)__builtin_popcount(used_sources), cycles[n]);
+    }
+
+    // ルート 1〜4 本はモジュレーターも 1 つずつ増え、5 本目からはルートだけ増える
+    double per_source = (cycles[MOD_MATRIX_NUM_SOURCES] - cycles[1]) / (MOD_MATRIX_NUM_SOURCES - 1);
+    double per_route = (cycles[MOD_MATRIX_MAX_ROUTES] - cycles[MOD_MATRIX_NUM_SOURCES]) /
+                       (MOD_MATRIX_MAX_ROUTES - MOD_MATRIX_NUM_SOURCES);
+    printf("  ~%.1f host cycles per extra source + route, ~%.1f per extra route on used sources "
+           "(%.3f cycles/frame at %d routes)\n",
+           per_source, per_route, cycles[MOD_MATRIX_MAX_ROUTES] / SUB_BLOCK, MOD_MATRIX_MAX_ROUTES);
+    printf("  (time_us_32() on the virtual clock; target: [MOD] status log)\n");
+    host_time_set_virtual(false);
+
+    CHECK(cycles[MOD_MATRIX_MAX_ROUTES] >= cycles[1]);
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_phase_lock();
+    test_envelope();
+    bench_routes();
+    return test_summary("test_mod_matrix");
+}
@@ -0,0 +1,137 @@
+/**
+ * @file test_pcm_batch.c
+ * @brief デコード済み PCM のバッチ処理のベンチマーク（パケット単位 vs SBC フレーム単位）
+ *
+ * bt_audio.c を取り込み、1メディアパケット = 8 SBC フレーム（各128フレーム、インターリーブ）を
+ * handle_pcm_data() に流す。処理チェーン（ボリューム、ラウドネス、ルーティング、エフェクト、
+ * トランスゲート、サンプラー、ビートクロック、出力コールバック）を
+ *   - パケットごとに1回（現在の実装: flush_pcm_batch() をパケットのデコード後に呼ぶ）
+ *   - 2 / 4 SBC フレームごと
+ *   - SBC フレームごと（PCM_BATCH_MAX_FRAMES = 128 と同じ）
+ * で回し、パケットあたりのコストと、呼び出し1回あたりの固定コストを求める。
+ * 出力コールバックに届いたフレーム数が入力と一致することも確かめる。
+ *
+ * ホストではフレームあたりの処理（約110サイクル/フレーム）が支配的で、呼び出し1回あたりの
+ * 固定コストは1パケットの数%、測定の揺らぎと同程度にしかならない。ターゲットでの差は
+ * 各モジュールの *_get_cycles() で見る。
+ */
+
+#include "../src/bt_audio.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "sample_bank.h"
+
+#include <math.h>
+#include <string.h>
+
+#define SBC_FRAME          128
+#define FRAMES_PER_PACKET  8
+#define PACKET_FRAMES      (SBC_FRAME * FRAMES_PER_PACKET)
+
+// サンプルバンクは空（ワンショットは鳴らさず、sampler_process() の素通りのコストだけ含める）
+const sample_t sample_bank[1];
+const uint32_t sample_bank_count = 0;
+
+static uint64_t delivered_frames = 0;
+static uint32_t delivered_calls = 0;
+
+static void sink(const int16_t *left, const int16_t *right, uint32_t num_samples, uint32_t sample_rate) {
+    (void)sample_rate;
+    bench_sink(left, num_samples * sizeof(int16_t));
+    bench_sink(right, num_samples * sizeof(int16_t));
+    delivered_frames += num_samples;
+    delivered_calls++;
+}
+
+/**
+ * @brief 1パケット分を流し、flush_every SBC フレームごとに処理チェーンを回す
+ */
+static void feed_packet(const int16_t *packet, uint32_t flush_every) {
+    int16_t frame[SBC_FRAME * 2];
+    for (uint32_t f = 0; f < FRAMES_PER_PACKET; f++) {
+        // デコーダーは出力バッファを使い回すので、毎回コピーしてから渡す
+        memcpy(frame, &packet[f * SBC_FRAME * 2], sizeof(frame));
+        handle_pcm_data(frame, SBC_FRAME, 2, AUDIO_SAMPLE_RATE, NULL);
+        if ((f + 1) % flush_every == 0) {
+            flush_pcm_batch();
+        }
+    }
+    flush_pcm_batch();
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    printf("Processing chain cost per %d-frame media packet (host):\n", PACKET_FRAMES);
+
+    static int16_t packet[PACKET_FRAMES * 2];
+    for (uint32_t i = 0; i < PACKET_FRAMES; i++) {
+        // -12 dBFS 前後の2音（ラウドネスの AGC やゲートが無音扱いしない程度）
+        packet[2 * i] = (int16_t)lround(8000.0 * sin(2.0 * M_PI * 440.0 * i / AUDIO_SAMPLE_RATE));
+        packet[2 * i + 1] = (int16_t)lround(8000.0 * sin(2.0 * M_PI * 660.0 * i / AUDIO_SAMPLE_RATE));
+    }
+
+    static const uint32_t flush_every[] = { FRAMES_PER_PACKET, 4, 2, 1 };
+    double per_packet_ns[4] = { 0 };
+    double per_packet_cycles[4] = { 0 };
+
+    // ホストの揺らぎを均すため、モードを交互に何周か回して最小値を取る
+    for (int round = 0; round < 5; round++) {
+        for (uint32_t m = 0; m < 4; m++) {
+            const int packets = 1000;
+            // 立ち上がり（ラウドネスの窓など）を済ませてから測る
+            for (int p = 0; p < 50; p++) feed_packet(packet, flush_every[m]);
+
+            delivered_frames = 0;
+            delivered_calls = 0;
+            uint64_t t0 = bench_now_ns();
+            uint64_t c0 = bench_cycles();
+            for (int p = 0; p < packets; p++) feed_packet(packet, flush_every[m]);
+            uint64_t c1 = bench_cycles();
+            uint64_t t1 = bench_now_ns();
+
+            double ns = (double)(t1 - t0) / packets;
+            double cycles = (double)(c1 - c0) / packets;
+            if (round == 0 || cycles < per_packet_cycles[m]) {
+                per_packet_ns[m] = ns;
+                per_packet_cycles[m] = cycles;
+            }
+            uint32_t calls = FRAMES_PER_PACKET / flush_every[m];
+            CHECK(delivered_calls == (uint32_t)packets * calls);
+            CHECK(delivered_frames == (uint64_t)packets * PACKET_FRAMES);
+        }
+    }
+
+    for (uint32_t m = 0; m < 4; m++) {
+        printf("  flush every %u SBC frame(s) (%u call(s)/packet): %.0f ns, %.0f host cycles/packet (%.1f/frame)\n",
+               flush_every[m], FRAMES_PER_PACKET / flush_every[m], per_packet_ns[m], per_packet_cycles[m],
+               per_packet_cycles[m] / PACKET_FRAMES);
+    }
+
+    // 固定コスト: 呼び出しを 8 → 1 回にまとめて減った 7 回分
+    double saved_cycles = per_packet_cycles[3] - per_packet_cycles[0];
+    double saved_ns = per_packet_ns[3] - per_packet_ns[0];
+    printf("  batching saves %.0f ns, %.0f host cycles/packet (%.1f%%), %.0f host cycles per chain call\n",
+           saved_ns, saved_cycles, 100.0 * saved_cycles / per_packet_cycles[3],
+           saved_cycles / (FRAMES_PER_PACKET - 1));
+    printf("  (target cycles: per-module *_get_cycles() in the status log on the device)\n");
+
+    // まとめても遅くならない（ホストの揺らぎを見込んで 15% の余裕）
+    CHECK(per_packet_cycles[0] <= per_packet_cycles[3] * 1.15);
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    if (!bt_audio_init()) {
+        printf("init failed\n");
+        return 1;
+    }
+    bt_audio_set_pcm_callback(sink);
+
+    bench();
+    return test_summary("test_pcm_batch");
+}
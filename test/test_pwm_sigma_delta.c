@@ -0,0 +1,210 @@
+/**
+ * @file test_pwm_sigma_delta.c
+ * @brief PWM Σ-Δ 出力のホストテスト（SNR と安定性）
+ *
+ * audio_out_pwm.c をそのまま取り込み、リング → fill_dma_buffer() → PWM レベル列を
+ * 取り出して評価する。PWM レベル列は fs × PWM_OVERSAMPLE のサンプル列とみなし、
+ * 可聴帯域（20kHz まで）の SNR と、極端な入力で誤差が発散しないことを確かめる。
+ */
+
+#include "../src/audio_out_pwm.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define FS          44100.0
+#define OS_RATE     (FS * PWM_OVERSAMPLE)
+#define FFT_POINTS  (1u << 17)
+#define BLOCK       PWM_DMA_BUFFER_SIZE
+
+// 入力の1ブロック分を作る関数（i = 通しのフレーム番号）
+typedef void (*signal_fn_t)(uint32_t i, int16_t *l, int16_t *r);
+
+static double sine_hz = 1000.0;
+static double sine_amp = 0.0;
+
+static void sine_signal(uint32_t i, int16_t *l, int16_t *r) {
+    double v = sine_amp * 32767.0 * sin(2.0 * M_PI * sine_hz * (double)i / FS);
+    *l = (int16_t)lrint(v);
+    *r = (int16_t)lrint(-v);
+}
+
+static void silence_signal(uint32_t i, int16_t *l, int16_t *r) {
+    (void)i;
+    *l = 0;
+    *r = 0;
+}
+
+static uint32_t rand_state = 12345;
+
+static void full_scale_noise(uint32_t i, int16_t *l, int16_t *r) {
+    (void)i;
+    *l = (int16_t)test_rand(&rand_state);
+    *r = (int16_t)test_rand(&rand_state);
+}
+
+static void rail_square(uint32_t i, int16_t *l, int16_t *r) {
+    // 正負のフルスケールを交互に（クランプが続く最悪ケース）
+    bool high = (i / 37) & 1;
+    *l = high ? 32767 : -32768;
+    *r = high ? -32768 : 32767;
+}
+
+/**
+ * @brief 信号をリング経由で変調し、PWM レベル列（L/R）を返す
+ *
+ * リングは半分の量を保ち、レート差補正のスリップが起きないようにする。
+ */
+static void render(signal_fn_t signal, uint32_t frames, double *out_l, double *out_r,
+                   int32_t *min_level, int32_t *max_level, int32_t *max_err) {
+    static uint32_t words[BLOCK * PWM_OVERSAMPLE];
+    int16_t in_l[BLOCK], in_r[BLOCK];
+    uint32_t pos = 0;
+
+    audio_out_pwm_clear_buffer();
+    for (uint32_t i = 0; i < PWM_BUFFER_SIZE / 2; i++) {
+        int16_t z = 0;
+        audio_out_pwm_write(&z, &z, 1);
+    }
+
+    *min_level = INT32_MAX;
+    *max_level = INT32_MIN;
+    *max_err = 0;
+
+    for (uint32_t done = 0; done < frames; done += BLOCK) {
+        for (uint32_t k = 0; k < BLOCK; k++) signal(pos + k, &in_l[k], &in_r[k]);
+        pos += BLOCK;
+        audio_out_pwm_write(in_l, in_r, BLOCK);
+        fill_dma_buffer(words, BLOCK);
+
+        for (uint32_t k = 0; k < BLOCK * PWM_OVERSAMPLE; k++) {
+            int32_t ll = (int32_t)(words[k] & 0xFFFFu);
+            int32_t lr = (int32_t)(words[k] >> 16);
+            if (ll < *min_level) *min_level = ll;
+            if (lr < *min_level) *min_level = lr;
+            if (ll > *max_level) *max_level = ll;
+            if (lr > *max_level) *max_level = lr;
+
+            // リングに入れた半分の無音の後ろが信号
+            uint32_t n = done * PWM_OVERSAMPLE + k;
+            if (out_l && n >= (PWM_BUFFER_SIZE / 2) * PWM_OVERSAMPLE) {
+                uint32_t m = n - (PWM_BUFFER_SIZE / 2) * PWM_OVERSAMPLE;
+                if (m < FFT_POINTS) {
+                    out_l[m] = (double)ll;
+                    out_r[m] = (double)lr;
+                }
+            }
+        }
+        for (int ch = 0; ch < 2; ch++) {
+            int32_t e = abs(sd_state[ch].e1);
+            if (e > *max_err) *max_err = e;
+        }
+    }
+}
+
+static double measure_snr(double amp, double hz) {
+    static double out_l[FFT_POINTS], out_r[FFT_POINTS], power[FFT_POINTS / 2 + 1];
+    int32_t lo, hi, err;
+
+    sine_amp = amp;
+    sine_hz = hz;
+    uint32_t frames = PWM_BUFFER_SIZE / 2 + FFT_POINTS / PWM_OVERSAMPLE + BLOCK;
+    render(sine_signal, frames, out_l, out_r, &lo, &hi, &err);
+
+    power_spectrum(out_l, FFT_POINTS, power);
+    double snr_l = spectrum_snr_db(power, FFT_POINTS, OS_RATE, hz, 20000.0);
+    power_spectrum(out_r, FFT_POINTS, power);
+    double snr_r = spectrum_snr_db(power, FFT_POINTS, OS_RATE, hz, 20000.0);
+    return (snr_l < snr_r) ? snr_l : snr_r;
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_snr(void) {
+    printf("SNR (20 Hz - 20 kHz, %u levels, x%d oversampling):\n", pwm_top + 1, PWM_OVERSAMPLE);
+
+    // ノイズシェーピングなしの再量子化なら 20*log10(levels) + 1.76 dB 程度
+    double flat_db = 20.0 * log10((double)(pwm_top + 1)) + 1.76;
+
+    const double tones[] = { 100.0, 1000.0, 5000.0, 12000.0 };
+    for (unsigned t = 0; t < sizeof(tones) / sizeof(tones[0]); t++) {
+        double snr = measure_snr(0.89, tones[t]);   // -1 dBFS
+        double bits = (snr - 1.76) / 6.02;
+        printf("  %6.0f Hz, -1 dBFS: %.1f dB (%.1f bits; flat requantisation %.1f dB)\n",
+               tones[t], snr, bits, flat_db);
+        CHECK_MSG(bits >= 12.0, "%.0f Hz: %.1f bits", tones[t], bits);
+    }
+
+    double snr_low = measure_snr(0.01, 1000.0);     // -40 dBFS
+    printf("  1000 Hz, -40 dBFS: %.1f dB\n", snr_low);
+    CHECK(snr_low >= 12.0 * 6.02 + 1.76 - 40.0 - 1.0);
+}
+
+static void test_stability(void) {
+    static double out_l[FFT_POINTS], out_r[FFT_POINTS];
+    int32_t lo, hi, err;
+
+    printf("Stability:\n");
+
+    // レールの矩形波: クランプが続いても誤差は ±1 LSB に収まり、出力はレベル範囲内
+    render(rail_square, 44100, NULL, NULL, &lo, &hi, &err);
+    printf("  rail square: levels %d..%d, max |e| %.2f LSB\n", lo, hi, err / 65536.0);
+    CHECK(lo >= 0 && hi <= (int32_t)pwm_top);
+    CHECK(err <= (1 << 16));
+
+    // フルスケールの白色雑音
+    render(full_scale_noise, 44100, NULL, NULL, &lo, &hi, &err);
+    printf("  full-scale noise: levels %d..%d, max |e| %.2f LSB\n", lo, hi, err / 65536.0);
+    CHECK(lo >= 0 && hi <= (int32_t)pwm_top);
+    CHECK(err <= (1 << 16));
+
+    // 極端な入力の後の無音: 誤差が残って発振しない（無音の平均が中点、揺れは数 LSB）
+    uint32_t frames = PWM_BUFFER_SIZE / 2 + FFT_POINTS / PWM_OVERSAMPLE + BLOCK;
+    render(silence_signal, frames, out_l, out_r, &lo, &hi, &err);
+    double mid = (double)(pcm_to_level_q16(0) >> 16);
+    double mean = 0.0;
+    for (uint32_t i = 0; i < FFT_POINTS; i++) mean += out_l[i];
+    mean /= FFT_POINTS;
+    printf("  silence: levels %d..%d (mid %.0f), mean %.3f\n", lo, hi, mid, mean);
+    CHECK(lo >= mid - 3 && hi <= mid + 3);
+    CHECK_NEAR(mean, mid + ((pcm_to_level_q16(0) & 0xFFFF) / 65536.0), 0.01);
+
+    // DC のステップ: 直流の平均が入力に追従する
+    for (int32_t dc = -32768; dc <= 32767; dc += 8191) {
+        int16_t v = (int16_t)dc;
+        audio_out_pwm_clear_buffer();
+        for (uint32_t i = 0; i < PWM_BUFFER_SIZE / 2; i++) audio_out_pwm_write(&v, &v, 1);
+        static uint32_t words[BLOCK * PWM_OVERSAMPLE];
+        double sum = 0.0;
+        uint32_t count = 0;
+        for (int b = 0; b < 16; b++) {
+            int16_t blk[BLOCK];
+            for (uint32_t k = 0; k < BLOCK; k++) blk[k] = v;
+            audio_out_pwm_write(blk, blk, BLOCK);
+            fill_dma_buffer(words, BLOCK);
+            if (b < 4) continue;   // 補間の立ち上がりを除く
+            for (uint32_t k = 0; k < BLOCK * PWM_OVERSAMPLE; k++) {
+                sum += (double)(words[k] & 0xFFFFu);
+                count++;
+            }
+        }
+        double expected = (double)pcm_to_level_q16(v) / 65536.0;
+        CHECK_NEAR(sum / count, expected, 0.01);
+    }
+}
+
+int main(void) {
+    host_sdk_reset();
+    if (!audio_out_pwm_init(44100)) {
+        printf("init failed\n");
+        return 1;
+    }
+    test_snr();
+    test_stability();
+    return test_summary("test_pwm_sigma_delta");
+}
@@ -0,0 +1,541 @@
+/**
+ * @file test_recorder.c
+ * @brief SD カード録音（ステージングとマルチブロック書き込み）のホストテスト
+ *
+ * recorder.c と sd_card.c をそのまま使い、SPI の向こうに SD カードの模擬をつなぐ。
+ * カードはブロックを一時ファイルに読み書きするブロックデバイスで、SPI の1バイトごとに
+ * 仮想時刻を進め（25MHz で約 0.32 us）、ブロックごとの書き込み時間（ビジー）に
+ * 遅延のスパイク（カード内部の消去や整理）を入れられる。FAT32 はファイルの範囲だけを返す代替。
+ *
+ * AUDIO_SAMPLE_RATE で 128 フレームずつ録音し、メインループと同じく
+ * 100 us ごとに recorder_poll() を呼んで確かめること:
+ * - ステージングに収まるスパイクでは1フレームも落とさず、ファイルの中身とヘッダーのデータ長が一致する
+ * - 収まらないスパイクではブロック単位で捨てて数え、残りは順序どおりに書かれる
+ * - CMD25 の前のビジー、書き込みの拒否、タイムアウト（打ち切り）でも recorder_poll() の
+ *   1回がメインループを止めない（SPI の数十バイト分で戻る）
+ * - 書き込みを開始できない時は止めてテイクを閉じる
+ * - 未使用のファイルがない時は DMA チャンネルを返す
+ */
+
+#include "../src/sd_card.c"
+#include "../src/recorder.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+
+#include <stdlib.h>
+
+#define BLOCK_FRAMES     128
+#define FILE_SECONDS     40
+#define FILE_BLOCKS      (1 + FILE_SECONDS * AUDIO_SAMPLE_RATE * BYTES_PER_FRAME / SD_BLOCK_SIZE)
+#define FILE0_LBA        8192
+#define POLL_INTERVAL_US 100
+#define MAX_POLL_US      100      // recorder_poll() 1回の上限（仮想時刻）
+
+// ============================================================================
+// SD カードの模擬（SPI モード、ブロックは一時ファイル）
+// ============================================================================
+
+typedef struct {
+    // 遅延の設定
+    uint32_t block_busy_us;       // 1ブロックの書き込み（ビジー）
+    uint32_t stop_busy_us;        // Stop Tran の後
+    uint32_t spike_us;            // スパイクの長さ（0 = なし）
+    uint32_t spike_every_us;      // スパイクの間隔
+    uint32_t command_busy_us;     // CMD25 の前（CS を選択した時）のビジー
+    uint32_t command_busy_every;  // その間隔（CMD25 n 回ごと、0 = なし）
+    int32_t reject_block;         // このブロック（書き込みの通し番号）を拒否する（-1 = なし）
+    int32_t hang_block;           // このブロックの書き込みが 700 ms かかる（-1 = なし）
+} card_config_t;
+
+static struct {
+    FILE *image;
+    card_config_t cfg;
+    bool selected;
+    bool ready;                   // ACMD41 が終わった
+    bool app_command;
+    uint32_t acmd41_count;
+    uint8_t command[6];
+    uint32_t command_len;
+    uint8_t out[SD_BLOCK_SIZE + 8];
+    uint32_t out_len, out_pos;
+    uint64_t busy_until_us;
+    uint64_t busy_after_out_us;   // 応答を送り終えてからのビジー
+    bool writing;                 // CMD25 の後
+    int32_t data_pos;             // -1 = トークン待ち
+    uint32_t write_lba;
+    uint8_t block[SD_BLOCK_SIZE + 2];
+    uint32_t blocks_written;
+    uint32_t cmd25_count;
+    uint64_t next_spike_us;
+    uint32_t byte_count;          // 仮想時刻を進めるため（3バイトで 1 us）
+} card;
+
+static uint64_t now_us(void) {
+    return time_us_64();
+}
+
+static void card_queue(const uint8_t *bytes, uint32_t n) {
+    card.out_len = 0;
+    card.out_pos = 0;
+    for (uint32_t i = 0; i < n; i++) card.out[card.out_len++] = bytes[i];
+}
+
+static void card_block_io(uint32_t lba, uint8_t *data, bool write) {
+    fseek(card.image, (long)lba * SD_BLOCK_SIZE, SEEK_SET);
+    if (write) {
+        fwrite(data, 1, SD_BLOCK_SIZE, card.image);
+    } else if (fread(data, 1, SD_BLOCK_SIZE, card.image) != SD_BLOCK_SIZE) {
+        memset(data, 0, SD_BLOCK_SIZE);
+    }
+}
+
+static void card_command(void) {
+    uint8_t cmd = card.command[0] & 0x3F;
+    uint32_t arg = ((uint32_t)card.command[1] << 24) | ((uint32_t)card.command[2] << 16) |
+                   ((uint32_t)card.command[3] << 8) | card.command[4];
+    bool app = card.app_command;
+    card.app_command = false;
+
+    if (cmd == CMD0) {
+        card.ready = false;
+        card_queue((const uint8_t[]){ 0xFF, R1_IDLE }, 2);
+    } else if (cmd == CMD8) {
+        card_queue((const uint8_t[]){ 0xFF, R1_IDLE, 0x00, 0x00, 0x01, 0xAA }, 6);
+    } else if (cmd == CMD55) {
+        card.app_command = true;
+        card_queue((const uint8_t[]){ 0xFF, card.ready ? 0x00 : R1_IDLE }, 2);
+    } else if (app && cmd == ACMD41) {
+        card.ready = ++card.acmd41_count >= 3;
+        card_queue((const uint8_t[]){ 0xFF, card.ready ? 0x00 : R1_IDLE }, 2);
+    } else if (cmd == CMD58) {
+        card_queue((const uint8_t[]){ 0xFF, 0x00, 0xC0, 0xFF, 0x80, 0x00 }, 6);   // CCS = 1
+    } else if (cmd == CMD17) {
+        card.out[0] = 0xFF;
+        card.out[1] = 0x00;
+        card.out[2] = 0xFF;
+        card.out[3] = TOKEN_START_BLOCK;
+        card_block_io(arg, &card.out[4], false);
+        card.out[4 + SD_BLOCK_SIZE] = 0xFF;
+        card.out[5 + SD_BLOCK_SIZE] = 0xFF;
+        card.out_len = SD_BLOCK_SIZE + 6;
+        card.out_pos = 0;
+    } else if (cmd == CMD25) {
+        card.writing = true;
+        card.data_pos = -1;
+        card.write_lba = arg;
+        card.cmd25_count++;
+        card_queue((const uint8_t[]){ 0xFF, 0x00 }, 2);
+    } else {
+        card_queue((const uint8_t[]){ 0xFF, R1_ILLEGAL_CMD }, 2);
+    }
+}
+
+/**
+ * @brief 1ブロックのデータを受け取った: データ応答を返し、書き込みの間ビジーにする
+ */
+static void card_block_received(void) {
+    int32_t index = (int32_t)card.blocks_written++;
+    if (index == card.cfg.reject_block) {
+        card_queue((const uint8_t[]){ 0x0D }, 1);   // 書き込みエラー
+        return;
+    }
+
+    card_block_io(card.write_lba++, card.block, true);
+    uint64_t busy = card.cfg.block_busy_us;
+    if (index == card.cfg.hang_block) {
+        busy = 700000;
+    } else if (card.cfg.spike_us && now_us() >= card.next_spike_us) {
+        busy = card.cfg.spike_us;
+        card.next_spike_us = now_us() + card.cfg.spike_every_us;
+    }
+    card_queue((const uint8_t[]){ 0xE5 }, 1);       // 受け付けた（下位5ビット = 0x05）
+    card.busy_after_out_us = busy;
+}
+
+static uint8_t card_xfer(uint8_t in) {
+    if (++card.byte_count % 3 == 0) host_time_advance_us(1);
+
+    bool selected = !host_gpio_get_out(SD_CS_PIN);
+    if (!selected) {
+        card.selected = false;
+        card.command_len = 0;
+        card.out_len = card.out_pos = 0;
+        card.writing = false;
+        return 0xFF;
+    }
+    if (!card.selected) {
+        card.selected = true;
+        // 書き込みの前（CMD25 を送る CS の選択）に時々ビジーになる
+        if (card.cfg.command_busy_every && card.ready &&
+            card.cmd25_count % card.cfg.command_busy_every == card.cfg.command_busy_every - 1) {
+            card.busy_until_us = now_us() + card.cfg.command_busy_us;
+        }
+    }
+
+    if (now_us() < card.busy_until_us) {
+        return 0x00;
+    }
+    if (card.out_pos < card.out_len) {
+        uint8_t out = card.out[card.out_pos++];
+        if (card.out_pos == card.out_len && card.busy_after_out_us) {
+            card.busy_until_us = now_us() + card.busy_after_out_us;
+            card.busy_after_out_us = 0;
+        }
+        return out;
+    }
+
+    if (card.writing) {
+        if (card.data_pos < 0) {
+            if (in == TOKEN_START_MULTI) {
+                card.data_pos = 0;
+            } else if (in == TOKEN_STOP_TRAN) {
+                card.writing = false;
+                card.busy_until_us = now_us() + card.cfg.stop_busy_us;
+            }
+            return 0xFF;
+        }
+        card.block[card.data_pos++] = in;
+        if (card.data_pos == SD_BLOCK_SIZE + 2) {
+            card.data_pos = -1;
+            card_block_received();
+        }
+        return 0xFF;
+    }
+
+    if (card.command_len == 0 && (in & 0xC0) != 0x40) {
+        return 0xFF;
+    }
+    card.command[card.command_len++] = in;
+    if (card.command_len == 6) {
+        card.command_len = 0;
+        card_command();
+    }
+    return 0xFF;
+}
+
+/**
+ * @brief SPI に向けた DMA を動かす（送信側のデータをカードに渡して、両方を完了させる）
+ */
+static void service_spi_dma(void) {
+    volatile void *dr = &spi_get_hw(SD_SPI_INSTANCE)->dr;
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (!host_dma[ch].busy || host_dma[ch].write_addr != dr) continue;
+        const uint8_t *src = (const uint8_t *)host_dma[ch].read_addr;
+        for (uint32_t i = 0; i < host_dma[ch].trans_count; i++) card_xfer(src[i]);
+        host_dma_complete(ch);
+    }
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (host_dma[ch].busy && host_dma[ch].read_addr == dr) host_dma_complete(ch);
+    }
+}
+
+// ============================================================================
+// FAT32 の代替（事前確保した2つのファイル）
+// ============================================================================
+
+static bool fat_present = true;
+
+bool fat32_mount(void) {
+    return fat_present;
+}
+
+int fat32_find_extents(const char *prefix, const char *ext, fat32_extent_t *extents, int max_extents) {
+    (void)prefix; (void)ext;
+    int n = max_extents < 2 ? max_extents : 2;
+    for (int i = 0; i < n; i++) {
+        snprintf(extents[i].name, sizeof(extents[i].name), "REC%02d.WAV", i);
+        extents[i].first_lba = FILE0_LBA + (uint32_t)i * (FILE_BLOCKS + 64);
+        extents[i].blocks = FILE_BLOCKS;
+    }
+    return n;
+}
+
+/**
+ * @brief カードを作り直す（tools/sd_prealloc.py と同じく、未使用のヘッダーを置く）
+ * @param recorded_bytes ヘッダーのデータ長（0 = 未使用）
+ */
+static void setup_card(const card_config_t *cfg, uint32_t recorded_bytes) {
+    if (card.image) fclose(card.image);
+    memset(&card, 0, sizeof(card));
+    card.image = tmpfile();
+    card.cfg = *cfg;
+    card.next_spike_us = cfg->spike_every_us;
+
+    fat32_extent_t ext[2];
+    fat32_find_extents("REC", "WAV", ext, 2);
+    uint8_t header[SD_BLOCK_SIZE];
+    build_wav_header(header, recorded_bytes);
+    for (int i = 0; i < 2; i++) card_block_io(ext[i].first_lba, header, true);
+
+    host_sdk_reset();
+    host_time_set_virtual(true);
+    host_spi_set_device(card_xfer);
+    fat_present = true;
+}
+
+static uint32_t claimed_dma_channels(void) {
+    uint32_t n = 0;
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) n += host_dma[ch].claimed;
+    return n;
+}
+
+// ============================================================================
+// 録音の模擬
+// ============================================================================
+
+typedef struct {
+    uint32_t produced_frames;
+    uint32_t dropped_frames;      // recorder_write() が 0 を返したフレーム
+    uint32_t max_poll_us;         // recorder_poll() 1回の最大（仮想時刻）
+    uint32_t file_frames;         // ヘッダーのデータ長
+    uint32_t order_errors;        // ファイルの中でフレームの順序が崩れた箇所
+    uint32_t missing_frames;      // ファイルにないフレーム（途中の穴 + 最後）
+    recorder_stats_t stats;
+} take_result_t;
+
+static void make_block(uint32_t first, int16_t *l, int16_t *r) {
+    for (uint32_t i = 0; i < BLOCK_FRAMES; i++) {
+        uint32_t index = first + i;
+        l[i] = (int16_t)(index & 0xFFFF);
+        r[i] = (int16_t)(index >> 16);
+    }
+}
+
+static uint32_t timed_poll(void) {
+    uint64_t t0 = now_us();
+    recorder_poll();
+    return (uint32_t)(now_us() - t0);
+}
+
+/**
+ * @brief seconds 秒録音して止め、ファイルを読み直す
+ * @param before_poll 毎回の recorder_poll() の前に呼ぶ（NULL = なし）
+ */
+static take_result_t record_take(uint32_t seconds, void (*before_poll)(void)) {
+    take_result_t res;
+    memset(&res, 0, sizeof(res));
+
+    CHECK(recorder_start());
+    uint64_t start = now_us();
+    uint64_t end = start + (uint64_t)seconds * 1000000;
+    int16_t l[BLOCK_FRAMES], r[BLOCK_FRAMES];
+
+    for (uint64_t tick = start; now_us() < end; tick += POLL_INTERVAL_US) {
+        if (now_us() < tick) host_time_set_us(tick);
+
+        // オーディオ処理（128 フレームずつ）
+        while (state == RECORDER_STATE_RECORDING &&
+               (uint64_t)res.produced_frames * 1000000 / AUDIO_SAMPLE_RATE <= now_us() - start) {
+            make_block(res.produced_frames, l, r);
+            if (recorder_write(l, r, BLOCK_FRAMES) == 0) res.dropped_frames += BLOCK_FRAMES;
+            res.produced_frames += BLOCK_FRAMES;
+        }
+
+        if (before_poll) before_poll();
+        uint32_t us = timed_poll();
+        if (us > res.max_poll_us) res.max_poll_us = us;
+        service_spi_dma();
+    }
+
+    recorder_stop();
+    for (uint32_t i = 0; i < 200000 && state != RECORDER_STATE_IDLE; i++) {
+        host_time_advance_us(POLL_INTERVAL_US);
+        if (before_poll) before_poll();
+        uint32_t us = timed_poll();
+        if (us > res.max_poll_us) res.max_poll_us = us;
+        service_spi_dma();
+    }
+    CHECK(state == RECORDER_STATE_IDLE);
+    recorder_get_stats(&res.stats);
+
+    // ファイルを読み直す: ヘッダーのデータ長と、フレームの通し番号
+    uint8_t block[SD_BLOCK_SIZE];
+    uint32_t lba = files[file_index].first_lba;
+    card_block_io(lba, block, false);
+    res.file_frames = (block[WAV_DATA_OFFSET - 4] | (block[WAV_DATA_OFFSET - 3] << 8) |
+                       (block[WAV_DATA_OFFSET - 2] << 16) | ((uint32_t)block[WAV_DATA_OFFSET - 1] << 24)) /
+                      BYTES_PER_FRAME;
+    uint32_t expected = 0;
+    for (uint32_t f = 0; f < res.file_frames; f++) {
+        if (f % (SD_BLOCK_SIZE / BYTES_PER_FRAME) == 0) card_block_io(++lba, block, false);
+        const uint8_t *p = &block[(f % (SD_BLOCK_SIZE / BYTES_PER_FRAME)) * BYTES_PER_FRAME];
+        uint32_t index = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        if (index < expected || (index - expected) % BLOCK_FRAMES != 0) {
+            res.order_errors++;
+        } else {
+            res.missing_frames += index - expected;
+        }
+        expected = index + 1;
+    }
+    res.missing_frames += res.produced_frames - expected;
+    return res;
+}
+
+static void print_take(const char *name, const take_result_t *t) {
+    printf("  %-22s %6.1f s written, dropped %5lu frames in %2lu events, staging peak %5lu/%d, "
+           "max write %6.1f ms, max poll %3lu us, errors %lu\n",
+           name, (double)t->file_frames / AUDIO_SAMPLE_RATE, t->stats.dropped_frames,
+           t->stats.drop_events, t->stats.staging_peak, RECORDER_STAGING_BYTES,
+           t->stats.max_write_us / 1000.0, t->max_poll_us, t->stats.write_errors);
+}
+
+static const card_config_t CARD_NORMAL = {
+    .block_busy_us = 300, .stop_busy_us = 500, .reject_block = -1, .hang_block = -1,
+};
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_latency_spikes(void) {
+    printf("Recording through the SD card model (%d KB staging, %d blocks per write):\n",
+           RECORDER_STAGING_BYTES / 1024, RECORDER_WRITE_BLOCKS);
+
+    // 遅延なし: 全部そのまま書ける
+    setup_card(&CARD_NORMAL, 0);
+    CHECK(recorder_init());
+    take_result_t t = record_take(10, NULL);
+    print_take("steady", &t);
+    CHECK(t.dropped_frames == 0 && t.stats.dropped_frames == 0);
+    CHECK(t.file_frames == t.produced_frames);
+    CHECK(t.order_errors == 0 && t.missing_frames == 0);
+    CHECK(t.stats.write_errors == 0);
+    CHECK(t.max_poll_us <= MAX_POLL_US);
+
+    // ステージング（約 186 ms）に収まるスパイク: 落とさない
+    card_config_t cfg = CARD_NORMAL;
+    cfg.spike_us = 120000;
+    cfg.spike_every_us = 1500000;
+    setup_card(&cfg, 0);
+    CHECK(recorder_init());
+    t = record_take(20, NULL);
+    print_take("120 ms spikes / 1.5 s", &t);
+    CHECK(t.stats.dropped_frames == 0);
+    CHECK(t.file_frames == t.produced_frames);
+    CHECK(t.order_errors == 0 && t.missing_frames == 0);
+    CHECK(t.stats.max_write_us >= 120000);
+    CHECK(t.max_poll_us <= MAX_POLL_US);
+
+    // 収まらないスパイク: ブロック単位で捨てて数え、残りは順序どおり
+    cfg.spike_us = 400000;
+    cfg.spike_every_us = 3000000;
+    setup_card(&cfg, 0);
+    CHECK(recorder_init());
+    t = record_take(20, NULL);
+    print_take("400 ms spikes / 3 s", &t);
+    CHECK(t.stats.dropped_frames > 0);
+    CHECK(t.stats.dropped_frames == t.dropped_frames);
+    CHECK(t.order_errors == 0);
+    CHECK(t.missing_frames == t.dropped_frames);
+    CHECK(t.file_frames + t.dropped_frames == t.produced_frames);
+    CHECK(t.stats.write_errors == 0);
+    CHECK(t.max_poll_us <= MAX_POLL_US);
+
+    // CMD25 の前のビジー（5回に1回 60 ms）: 待たずに戻り、落とさない
+    cfg = CARD_NORMAL;
+    cfg.command_busy_us = 60000;
+    cfg.command_busy_every = 5;
+    setup_card(&cfg, 0);
+    CHECK(recorder_init());
+    t = record_take(10, NULL);
+    print_take("60 ms busy before CMD25", &t);
+    CHECK(t.stats.dropped_frames == 0);
+    CHECK(t.file_frames == t.produced_frames && t.missing_frames == 0);
+    CHECK(t.max_poll_us <= MAX_POLL_US);
+}
+
+static void test_write_failures(void) {
+    printf("Write failures:\n");
+
+    // データ応答でブロックを拒否: 打ち切って止まり、それまでの分でヘッダーを閉じる
+    card_config_t cfg = CARD_NORMAL;
+    cfg.reject_block = 1000;
+    setup_card(&cfg, 0);
+    CHECK(recorder_init());
+    take_result_t t = record_take(10, NULL);
+    print_take("rejected block", &t);
+    CHECK(t.stats.write_errors == 1);
+    CHECK(t.file_frames > 0 && t.file_frames * BYTES_PER_FRAME == t.stats.data_bytes);
+    CHECK(t.file_frames * BYTES_PER_FRAME <= 1000 * SD_BLOCK_SIZE);
+    CHECK(t.order_errors == 0);
+    CHECK(t.max_poll_us <= MAX_POLL_US);
+
+    // ブロックの書き込みが SD_WRITE_TIMEOUT_MS を超える: 打ち切りのビジーも待たずに戻る
+    cfg = CARD_NORMAL;
+    cfg.hang_block = 300;
+    setup_card(&cfg, 0);
+    CHECK(recorder_init());
+    t = record_take(5, NULL);
+    print_take("write timeout", &t);
+    CHECK(t.stats.write_errors == 1);
+    CHECK(t.file_frames * BYTES_PER_FRAME == t.stats.data_bytes);
+    CHECK(t.order_errors == 0);
+    CHECK(t.max_poll_us <= MAX_POLL_US);
+}
+
+// 録音とは別の書き込みを先に始めて、カードを塞ぐ
+static uint8_t other_block[SD_BLOCK_SIZE];
+static bool card_taken = false;
+
+static void take_card(void) {
+    if (!card_taken && head - tail >= CHUNK_BYTES) {
+        card_taken = sd_card_write_start(FILE0_LBA - 1, other_block, 1);
+    }
+}
+
+static void test_start_refused(void) {
+    printf("Write start refused by the card driver:\n");
+
+    setup_card(&CARD_NORMAL, 0);
+    CHECK(recorder_init());
+    card_taken = false;
+    take_result_t t = record_take(1, take_card);
+    printf("  data and header writes refused: state %d, errors %lu, file marked used %d\n",
+           state, t.stats.write_errors, file_used[0]);
+    CHECK(card_taken);
+    CHECK(t.stats.write_errors == 2);
+    CHECK(state == RECORDER_STATE_IDLE);
+    CHECK(file_used[0]);
+
+    // 次のテイクは次のファイルに書ける
+    while (sd_card_write_poll() == SD_WRITE_BUSY) service_spi_dma();
+    t = record_take(2, NULL);
+    CHECK(file_index == 1);
+    CHECK(t.file_frames == t.produced_frames && t.stats.write_errors == 0);
+}
+
+static void test_no_free_file(void) {
+    printf("No unused file / no volume:\n");
+
+    setup_card(&CARD_NORMAL, 4096);
+    CHECK(!recorder_init());
+    printf("  all files recorded: init fails, %lu DMA channels still claimed\n", claimed_dma_channels());
+    CHECK(claimed_dma_channels() == 0);
+    CHECK(state == RECORDER_STATE_NO_CARD);
+    CHECK(!sd_card_write_start(FILE0_LBA, other_block, 1));
+
+    setup_card(&CARD_NORMAL, 0);
+    fat_present = false;
+    CHECK(!recorder_init());
+    CHECK(claimed_dma_channels() == 0);
+
+    // カードを戻せば初期化できる
+    setup_card(&CARD_NORMAL, 0);
+    CHECK(recorder_init());
+    CHECK(claimed_dma_channels() == 2);
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_latency_spikes();
+    test_write_failures();
+    test_start_refused();
+    test_no_free_file();
+
+    if (card.image) fclose(card.image);
+    return test_summary("test_recorder");
+}
@@ -0,0 +1,278 @@
+/**
+ * @file test_sampler.c
+ * @brief サンプルプレーヤーの先読みスケジューラーのホストテスト（遅いフラッシュの模擬）
+ *
+ * sampler.c を取り込み、偽の DMA の転送を「フラッシュ」モデルで完了させる。
+ * 1回の転送は 固定の遅延 + バイト数 / 帯域 で終わり、その時刻にデータをコピーして
+ * 完了割り込みを処理する（完了ハンドラーが次の要求を始めた時刻もそこから数える）。
+ * - 遅いフラッシュでアンダーランしても、サンプルを読み飛ばさずに続きから鳴らすこと
+ *   （無音を除いた出力が PCM16 / ADPCM の参照と一致し、無音のフレーム数 = アンダーラン数）
+ * - ボイスを奪った時、転送中・キュー中の古い要求のデータが新しいサンプルに混ざらないこと、
+ *   最も古いボイスから順に奪うこと
+ * - 4ボイスを鳴らし続けた時の、帯域ごとのアンダーランと先読みキューの最大長
+ * 実機の QSPI フラッシュ（キャッシュなしの XIP から DMA）は数十 MB/s 出るので、
+ * 遅い条件は XIP のコード読み込みと取り合う場合などの余裕を見るためのもの。
+ */
+
+#include "../src/sampler.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/irq.h"
+
+#include <math.h>
+
+#define FS           44100
+#define BLOCK        128
+#define PCM_FRAMES   12000
+#define ADPCM_FRAMES 20000
+#define TRANSFER_LATENCY_US  20.0
+
+// ============================================================================
+// サンプルバンク（正の値だけの信号。出力の 0 をアンダーランの無音と区別できる）
+// ============================================================================
+
+static uint8_t pcm_data[PCM_FRAMES * 2] __attribute__((aligned(4)));
+static uint8_t adpcm_data[ADPCM_FRAMES / 2] __attribute__((aligned(4)));
+static int16_t pcm_ref[PCM_FRAMES];
+static int16_t adpcm_ref[ADPCM_FRAMES];
+
+const sample_t sample_bank[] = {
+    { "pcm_tone",   pcm_data,   sizeof(pcm_data),   PCM_FRAMES,   SAMPLE_FORMAT_PCM16 },
+    { "adpcm_tone", adpcm_data, sizeof(adpcm_data), ADPCM_FRAMES, SAMPLE_FORMAT_IMA_ADPCM },
+};
+const uint32_t sample_bank_count = 2;
+
+static void make_bank(void) {
+    for (uint32_t i = 0; i < PCM_FRAMES; i++) {
+        int16_t s = (int16_t)lrint(2000.0 + 1000.0 * sin(2.0 * M_PI * 300.0 * i / FS));
+        memcpy(&pcm_data[i * 2], &s, sizeof(s));
+        pcm_ref[i] = s;
+    }
+
+    // wav2bank.py と同じく予測値 0 / ステップ位置 0 から、下位ニブルが先
+    adpcm_state_t enc = { 0, 0 }, dec = { 0, 0 };
+    for (uint32_t i = 0; i < ADPCM_FRAMES; i++) {
+        int16_t s = (int16_t)lrint(4000.0 + 2500.0 * sin(2.0 * M_PI * 170.0 * i / FS));
+        uint8_t code = adpcm_encode_sample(&enc, s);
+        adpcm_data[i >> 1] |= (i & 1) ? (uint8_t)(code << 4) : code;
+        adpcm_ref[i] = adpcm_decode_sample(&dec, code);
+    }
+}
+
+// ============================================================================
+// フラッシュのモデル
+// ============================================================================
+
+static double flash_bytes_per_us;     // 帯域
+static double now_us;                 // 現在時刻
+static double xfer_start_us;          // 転送中の要求の開始時刻
+static uint32_t seen_starts;
+
+// 転送が始まっていたら開始時刻を記録する
+static void flash_note_start(double t) {
+    if (host_dma[dma_channel].starts != seen_starts) {
+        seen_starts = host_dma[dma_channel].starts;
+        xfer_start_us = t;
+    }
+}
+
+/**
+ * @brief t までに終わる転送を順に完了させる（データをコピーして完了割り込み）
+ */
+static void flash_run_until(double t) {
+    flash_note_start(now_us);
+    while (host_dma[dma_channel].busy) {
+        host_dma_channel_t *ch = &host_dma[dma_channel];
+        uint32_t bytes = ch->trans_count * 4;
+        double done = xfer_start_us + TRANSFER_LATENCY_US + bytes / flash_bytes_per_us;
+        if (done > t) break;
+
+        memcpy((void *)ch->write_addr, (const void *)ch->read_addr, bytes);
+        host_dma_complete(dma_channel);
+        while (host_irq_service(DMA_IRQ_0, 1)) {
+        }
+        flash_note_start(done);
+    }
+    now_us = t;
+}
+
+/**
+ * @brief 1ブロック分進めて処理（ブロックの頭までの転送を済ませてから sampler_process()）
+ */
+static void run_block(int16_t *out) {
+    static int16_t l[BLOCK], r[BLOCK];
+    flash_run_until(now_us + BLOCK * 1e6 / FS);
+    memset(l, 0, sizeof(l));
+    memset(r, 0, sizeof(r));
+    sampler_process(l, r, BLOCK);
+    flash_note_start(now_us);
+    if (out) memcpy(out, l, sizeof(l));
+}
+
+static int trigger(uint32_t index, float gain) {
+    int v = sampler_trigger(index, gain);
+    flash_note_start(now_us);
+    return v;
+}
+
+/**
+ * @brief 全ボイスを止めて残りの転送を済ませ、統計を消す
+ */
+static void reset_sampler(double mb_per_s) {
+    sampler_stop_all();
+    flash_run_until(now_us + 1e9);
+    queue_head = 0;
+    queue_count = 0;
+    stat_transfers = 0;
+    stat_triggers = 0;
+    stat_underruns = 0;
+    stat_max_queue = 0;
+    flash_bytes_per_us = mb_per_s;
+}
+
+/**
+ * @brief 1ボイスの出力から無音を除いて参照と比べる
+ * @return 一致しないフレーム数（長さの違いを含む）
+ */
+static uint32_t compare_gapless(const int16_t *out, uint32_t out_frames, const int16_t *ref,
+                                uint32_t ref_frames, int32_t gain_q15, uint32_t *gaps) {
+    uint32_t k = 0, mismatches = 0;
+    *gaps = 0;
+    for (uint32_t i = 0; i < out_frames; i++) {
+        if (out[i] == 0) {
+            if (k < ref_frames) (*gaps)++;
+            continue;
+        }
+        if (k >= ref_frames || out[i] != (int16_t)((ref[k] * gain_q15) >> 15)) mismatches++;
+        k++;
+    }
+    return mismatches + (ref_frames - (k < ref_frames ? k : ref_frames));
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_slow_flash_continuity(void) {
+    printf("One voice, no skipping on underrun (output without silence == reference):\n");
+
+    static const double bandwidths[] = { 25.0, 0.2, 0.05, 0.02 };   // MB/s
+    static int16_t out[(ADPCM_FRAMES * 8 / BLOCK + 1) * BLOCK];
+    const uint32_t blocks = sizeof(out) / sizeof(out[0]) / BLOCK;
+
+    for (uint32_t fmt = 0; fmt < 2; fmt++) {
+        const int16_t *ref = fmt ? adpcm_ref : pcm_ref;
+        uint32_t ref_frames = fmt ? ADPCM_FRAMES : PCM_FRAMES;
+        for (uint32_t b = 0; b < sizeof(bandwidths) / sizeof(bandwidths[0]); b++) {
+            reset_sampler(bandwidths[b]);
+            int v = trigger(fmt, 1.0f);
+            CHECK(v >= 0);
+            for (uint32_t k = 0; k < blocks; k++) run_block(&out[k * BLOCK]);
+
+            uint32_t gaps;
+            uint32_t bad = compare_gapless(out, blocks * BLOCK, ref, ref_frames, 32767, &gaps);
+            sampler_stats_t st;
+            sampler_get_stats(&st);
+            printf("  %-5s %6.2f MB/s: %5lu underrun frames (%5u silent), %u mismatches, %lu transfers\n",
+                   fmt ? "ADPCM" : "PCM16", bandwidths[b], st.underruns, gaps, bad, st.transfers);
+            CHECK(bad == 0);
+            CHECK(st.underruns == gaps);
+            CHECK(!voices[v].active);
+            if (b == 0) CHECK(st.underruns == 0);
+        }
+    }
+}
+
+static void test_voice_stealing(void) {
+    printf("Voice stealing with transfers in flight:\n");
+
+    reset_sampler(0.5);
+
+    // 4ボイスを無音（ゲイン 0）の PCM で埋める。先頭の転送はまだ終わっていない
+    for (uint32_t i = 0; i < SAMPLER_NUM_VOICES; i++) {
+        CHECK(trigger(0, 0.0f) == (int)i);
+    }
+    CHECK(dma_busy && in_flight.voice == 0);
+    CHECK(queue_count == SAMPLER_QUEUE_SIZE - 1);
+
+    // 5つ目は最も古いボイス 0 を奪う（転送中の要求とキュー中の要求が古くなる）
+    int stolen = trigger(1, 1.0f);
+    CHECK(stolen == 0);
+    CHECK(in_flight.generation != voices[0].generation);
+    sampler_stats_t st;
+    sampler_get_stats(&st);
+    printf("  5th trigger took voice %d, queue depth max %lu of %d\n",
+           stolen, st.max_queue_depth, SAMPLER_QUEUE_SIZE);
+    CHECK(st.max_queue_depth <= SAMPLER_QUEUE_SIZE);
+
+    // 次は2番目に古いボイス 1
+    CHECK(trigger(1, 0.0f) == 1);
+
+    // ボイス 0 の出力は ADPCM の参照だけ（古い PCM のデータが混ざらない）
+    static int16_t out[(ADPCM_FRAMES * 4 / BLOCK + 1) * BLOCK];
+    const uint32_t blocks = sizeof(out) / sizeof(out[0]) / BLOCK;
+    for (uint32_t k = 0; k < blocks; k++) run_block(&out[k * BLOCK]);
+
+    uint32_t gaps;
+    uint32_t bad = compare_gapless(out, blocks * BLOCK, adpcm_ref, ADPCM_FRAMES, 32767, &gaps);
+    sampler_get_stats(&st);
+    printf("  stolen voice: %u mismatches, %u silent frames, %lu underrun frames over all voices\n",
+           bad, gaps, st.underruns);
+    CHECK(bad == 0);
+    CHECK(st.underruns >= gaps);
+    CHECK(st.triggers == SAMPLER_NUM_VOICES + 2);
+}
+
+static void test_polyphony_load(void) {
+    printf("%d voices retriggered for 10 s (PCM16 %.0f KB/s per voice, %.0f us per transfer + bytes/bandwidth):\n",
+           SAMPLER_NUM_VOICES, FS * 2 / 1000.0, TRANSFER_LATENCY_US);
+
+    static const double bandwidths[] = { 25.0, 2.0, 0.5, 0.3, 0.15 };
+    const uint32_t blocks = 10 * FS / BLOCK;
+    uint32_t prev_underruns = 0;
+
+    for (uint32_t b = 0; b < sizeof(bandwidths) / sizeof(bandwidths[0]); b++) {
+        reset_sampler(bandwidths[b]);
+        uint64_t cycles = 0;
+        for (uint32_t k = 0; k < blocks; k++) {
+            // 終わったボイスをずらしながら鳴らし直す
+            if (k % 8 == 0) {
+                for (uint32_t v = 0; v < SAMPLER_NUM_VOICES; v++) {
+                    if (!voices[v].active) {
+                        trigger(0, 0.25f);
+                        break;
+                    }
+                }
+            }
+            uint64_t c0 = bench_cycles();
+            run_block(NULL);
+            cycles += bench_cycles() - c0;
+        }
+
+        sampler_stats_t st;
+        sampler_get_stats(&st);
+        printf("  %6.2f MB/s: %lu triggers, %6lu underrun frames, queue max %lu, %.1f host cycles/frame\n",
+               bandwidths[b], st.triggers, st.underruns, st.max_queue_depth,
+               (double)cycles / (blocks * BLOCK));
+        CHECK(st.max_queue_depth <= SAMPLER_QUEUE_SIZE);
+        if (b == 0) CHECK(st.underruns == 0);
+        if (b > 0) CHECK(st.underruns >= prev_underruns);
+        prev_underruns = st.underruns;
+    }
+    CHECK(prev_underruns > 0);
+}
+
+int main(void) {
+    host_sdk_reset();
+    make_bank();
+    if (!sampler_init()) {
+        printf("init failed\n");
+        return 1;
+    }
+
+    test_slow_flash_continuity();
+    test_voice_stealing();
+    test_polyphony_load();
+    return test_summary("test_sampler");
+}
@@ -0,0 +1,264 @@
+/**
+ * @file test_slicer.c
+ * @brief Beat-Slicer のホストテスト（並び順、継ぎ目、小節頭への整列、履歴に収まらない時の扱い）
+ *
+ * audio_effect.c を取り込み、ビートクロックの小節をステップごとに振幅の違う正弦波で埋めた
+ * 既知のパターンを流す（ウェット 100%）。
+ * - 小節の途中でスライサーを ON にしても、次の小節頭まではドライのまま、最初の1小節は
+ *   並べ替えずに通り、ステップの境界が小節頭から floor(k × スライス長) に並ぶこと
+ * - 各ステップの出力がどのスライスか（直前の小節の8ステップと突き合わせる）が
+ *   逆順 / ユーザーパターン / シャッフル（小節ごとに各スライス1回）の並びと一致すること
+ * - ADPCM の履歴から復号したスライスが元の入力に近い（SNR）こと
+ * - 継ぎ目（ステップ境界の前後）のサンプル間の差が、入力の正弦波そのものの差程度に収まること
+ * - 1小節が履歴に収まらないスライス長ではステップを減らさず、ドライのまま通すこと
+ */
+
+#include "../src/audio_effect.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS            44100
+#define MAX_BLOCK     1024
+#define ENABLE_FRAME  30000    // 最初の小節の途中で ON にする
+#define RUN_BARS      7
+#define TONE_HZ       190.0    // ステップ長の整数倍の周期にならない周波数（継ぎ目で位相が飛ぶ）
+
+// ============================================================================
+// グリッドと入力
+// ============================================================================
+
+static uint32_t bar0;                       // スライサーが始まる小節頭のフレーム
+static uint64_t step_q32;                   // ステップ長（32.32）
+#define MAX_STEPS  ((RUN_BARS + 1) * SLICER_NUM_STEPS)
+static uint32_t grid[MAX_STEPS + 1];        // k 番目のステップの開始フレーム
+
+static void make_grid(float bpm, uint32_t slice_length, uint32_t slice_frac) {
+    // ビートクロックと同じ 0.32 の増分で、最初の小節頭（4拍目の終わり）を越える最初のフレーム
+    uint32_t increment = (uint32_t)((double)bpm / 60.0 / FS * 4294967296.0 + 0.5);
+    uint64_t bar_q32 = (uint64_t)BEATS_PER_BAR << 32;
+    bar0 = (uint32_t)((bar_q32 + increment - 1) / increment);
+
+    step_q32 = ((uint64_t)slice_length << 32) | slice_frac;
+    for (uint32_t k = 0; k <= MAX_STEPS; k++) {
+        grid[k] = bar0 + (uint32_t)((step_q32 * k) >> 32);
+    }
+}
+
+// ステップごとに振幅の違う正弦波（小節内のステップ番号で決まる）
+static int16_t input_at(uint32_t frame, int ch) {
+    double amp = 8000.0;
+    if (frame >= bar0) {
+        uint32_t k = 0;
+        while (k < MAX_STEPS && grid[k + 1] <= frame) k++;
+        amp = 2000.0 * (double)(k % SLICER_NUM_STEPS + 1);
+    }
+    double s = amp * sin(2.0 * M_PI * TONE_HZ * frame / FS + (ch ? 1.0 : 0.0));
+    return (int16_t)lrint(s);
+}
+
+#define MAX_FRAMES  ((RUN_BARS + 2) * FS * 2)
+static int16_t in_l[MAX_FRAMES], in_r[MAX_FRAMES];
+static int16_t out_l[MAX_FRAMES], out_r[MAX_FRAMES];
+static uint32_t run_frames;
+
+/**
+ * @brief スライサーを ENABLE_FRAME で ON にしてランダムなブロック長で回す
+ */
+static void run(float bpm, uint32_t slice_length, uint32_t slice_frac, slicer_pattern_t pattern) {
+    make_grid(bpm, slice_length, slice_frac);
+    run_frames = grid[RUN_BARS * SLICER_NUM_STEPS];
+    if (run_frames > MAX_FRAMES) run_frames = MAX_FRAMES;
+    for (uint32_t f = 0; f < run_frames; f++) {
+        in_l[f] = input_at(f, 0);
+        in_r[f] = input_at(f, 1);
+    }
+
+    beat_clock_init(FS);
+    beat_clock_set_bpm(bpm);
+    audio_effect_reset();
+
+    beat_repeat_params_t p;
+    audio_effect_get_params(&p);
+    p.enabled = true;
+    p.slice_length = slice_length;
+    p.slice_length_frac = slice_frac;
+    p.clock_divider = 1;
+    p.wet_mix = 100;
+    p.stutter_enabled = false;
+    p.multiband_enabled = false;
+    p.slicer_enabled = false;
+    p.slicer_pattern = pattern;
+    audio_effect_update_params(&p);
+
+    uint32_t rng = 42;
+    uint32_t pos = 0;
+    while (pos < run_frames) {
+        if (pos >= ENABLE_FRAME && !p.slicer_enabled) {
+            p.slicer_enabled = true;
+            audio_effect_update_params(&p);
+        }
+        uint32_t n = 1 + test_rand(&rng) % MAX_BLOCK;
+        if (pos < ENABLE_FRAME && n > ENABLE_FRAME - pos) n = ENABLE_FRAME - pos;
+        if (n > run_frames - pos) n = run_frames - pos;
+
+        memcpy(&out_l[pos], &in_l[pos], n * sizeof(int16_t));
+        memcpy(&out_r[pos], &in_r[pos], n * sizeof(int16_t));
+        audio_effect_process(&out_l[pos], &out_r[pos], n);
+        beat_clock_advance(n);
+        pos += n;
+    }
+}
+
+// ============================================================================
+// 検証
+// ============================================================================
+
+// 出力のステップ k を、直前の小節のスライス j（ステップ k - 8 - s + j）として復元した時の SNR
+static double slice_snr(uint32_t k, uint32_t j) {
+    uint32_t bar_first = (k / SLICER_NUM_STEPS - 1) * SLICER_NUM_STEPS;
+    uint32_t src = grid[bar_first + j];
+    uint32_t src_len = grid[bar_first + j + 1] - src;
+    uint32_t len = grid[k + 1] - grid[k];
+
+    double sig = 0.0, err = 0.0;
+    for (uint32_t p = 0; p < len; p++) {
+        uint32_t off = (p < src_len) ? p : src_len - 1;
+        int32_t fade = slicer_fade_gain(p, len);
+        for (int ch = 0; ch < 2; ch++) {
+            double expected = (double)(((int32_t)(ch ? in_r : in_l)[src + off] * fade) >> 15);
+            double got = ch ? out_r[grid[k] + p] : out_l[grid[k] + p];
+            sig += expected * expected;
+            err += (got - expected) * (got - expected);
+        }
+    }
+    return 10.0 * log10(sig / (err + 1e-9));
+}
+
+/**
+ * @brief 並べ替えた小節を調べ、ステップごとのスライス番号を order に返す
+ * @return 最も低い SNR（選ばれたスライスについて）
+ */
+static double check_bars(uint32_t order[][SLICER_NUM_STEPS], double *max_seam_delta) {
+    double worst_snr = 1e9;
+    double seam = 0.0;
+
+    // ON にしてから最初の小節が終わるまではドライのまま（ON にする前は Beat-Repeat）
+    uint32_t dry_errors = 0;
+    for (uint32_t f = ENABLE_FRAME; f < grid[SLICER_NUM_STEPS]; f++) {
+        if (out_l[f] != in_l[f] || out_r[f] != in_r[f]) dry_errors++;
+    }
+    CHECK_MSG(dry_errors == 0, "%u frames before the first reordered bar differ from the input", dry_errors);
+
+    for (uint32_t bar = 2; bar < RUN_BARS; bar++) {
+        for (uint32_t s = 0; s < SLICER_NUM_STEPS; s++) {
+            uint32_t k = bar * SLICER_NUM_STEPS + s;
+
+            // ステップの両端はフェードで 0（グリッドに並んでいる）
+            CHECK(out_l[grid[k]] == 0 && out_r[grid[k]] == 0);
+            CHECK(out_l[grid[k + 1] - 1] == 0 && out_r[grid[k + 1] - 1] == 0);
+
+            // 直前の小節のどのスライスか
+            double best = -1e9;
+            uint32_t best_j = 0;
+            for (uint32_t j = 0; j < SLICER_NUM_STEPS; j++) {
+                double snr = slice_snr(k, j);
+                if (snr > best) {
+                    best = snr;
+                    best_j = j;
+                }
+            }
+            order[bar - 2][s] = best_j;
+            if (best < worst_snr) worst_snr = best;
+
+            // 継ぎ目の前後 SLICER_FADE_FRAMES のサンプル間の差
+            for (uint32_t f = grid[k] - SLICER_FADE_FRAMES; f < grid[k] + SLICER_FADE_FRAMES; f++) {
+                double dl = fabs((double)out_l[f + 1] - out_l[f]);
+                double dr = fabs((double)out_r[f + 1] - out_r[f]);
+                if (dl > seam) seam = dl;
+                if (dr > seam) seam = dr;
+            }
+        }
+    }
+    *max_seam_delta = seam;
+    return worst_snr;
+}
+
+static void test_patterns(void) {
+    // 最大振幅の正弦波そのもののサンプル間の差
+    const double tone_delta = 2000.0 * SLICER_NUM_STEPS * 2.0 * M_PI * TONE_HZ / FS;
+
+    static const struct {
+        const char *name;
+        float bpm;
+        uint32_t slice_length;
+        double frac;
+        slicer_pattern_t pattern;
+    } cases[] = {
+        { "reverse, 120 BPM 8ths",   120.0f, 11025, 0.0,            SLICER_PATTERN_REVERSE },
+        { "user, 120 BPM 8ths",      120.0f, 11025, 0.0,            SLICER_PATTERN_USER },
+        { "shuffle, 93.7 BPM 16ths", 93.7f,  7059,  0.76520811099,  SLICER_PATTERN_SHUFFLE },
+        { "reverse, 174.2 BPM 8ths", 174.2f, 7594,  0.71871412170,  SLICER_PATTERN_REVERSE },
+    };
+    static const uint8_t user[SLICER_NUM_STEPS] = { 3, 3, 0, 7, 1, 1, 6, 2 };
+
+    printf("Slice order and seams (enabled mid-bar, %.0f Hz tone, step amplitude 2000 x (n+1)):\n",
+           TONE_HZ);
+    for (uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        slicer_set_user_pattern(user, SLICER_NUM_STEPS);
+        run(cases[c].bpm, cases[c].slice_length, (uint32_t)(cases[c].frac * 4294967296.0),
+            cases[c].pattern);
+
+        uint32_t order[RUN_BARS - 2][SLICER_NUM_STEPS];
+        double seam;
+        double snr = check_bars(order, &seam);
+
+        uint32_t wrong = 0;
+        for (uint32_t b = 0; b < RUN_BARS - 2; b++) {
+            uint32_t used = 0;
+            for (uint32_t s = 0; s < SLICER_NUM_STEPS; s++) {
+                used |= 1u << order[b][s];
+                if (cases[c].pattern == SLICER_PATTERN_REVERSE && order[b][s] != SLICER_NUM_STEPS - 1 - s) wrong++;
+                if (cases[c].pattern == SLICER_PATTERN_USER && order[b][s] != user[s]) wrong++;
+            }
+            // シャッフルは各スライス1回ずつ
+            if (cases[c].pattern == SLICER_PATTERN_SHUFFLE && used != (1u << SLICER_NUM_STEPS) - 1) wrong++;
+        }
+
+        printf("  %-24s bar at frame %u, step %.2f: order", cases[c].name, bar0,
+               (double)step_q32 / 4294967296.0);
+        for (uint32_t s = 0; s < SLICER_NUM_STEPS; s++) printf(" %u", order[0][s]);
+        printf(", %u wrong, worst SNR %.1f dB, seam delta %.0f (tone %.0f)\n",
+               wrong, snr, seam, tone_delta);
+        CHECK(wrong == 0);
+        CHECK(snr > 25.0);
+        CHECK(seam < tone_delta * 1.5);
+    }
+}
+
+static void test_refuse(void) {
+    printf("Bar that does not fit the history:\n");
+
+    // 120 BPM の4分音符 x 8 ステップ: (2 x 8 - 1) x 22051 > 4秒
+    run(120.0f, 22050, 0, SLICER_PATTERN_REVERSE);
+
+    uint32_t changed = 0;
+    for (uint32_t f = ENABLE_FRAME; f < run_frames; f++) {
+        if (out_l[f] != in_l[f] || out_r[f] != in_r[f]) changed++;
+    }
+    printf("  step 22050: %u of %u frames changed, waiting for a bar that fits: %s\n",
+           changed, run_frames - ENABLE_FRAME, slicer_waiting ? "yes" : "no");
+    CHECK(changed == 0);
+    CHECK(slicer_active && slicer_waiting && !slicer_has_bar);
+}
+
+int main(void) {
+    host_sdk_reset();
+    audio_effect_init(FS);
+
+    test_patterns();
+    test_refuse();
+    return test_summary("test_slicer");
+}
@@ -0,0 +1,266 @@
+/**
+ * @file test_trace.c
+ * @brief タイムライントレースのホストテストとベンチマーク
+ *
+ * trace.c を取り込み、
+ * - リングの上書き（lost の数）、トリガー後 TRACE_POST_TRIGGER_EVENTS 個で止まること、
+ *   ダンプ中は記録しないこと、ダンプの後に記録を再開すること
+ * - 1イベントの記録コスト（記録中 / 停止中、ホストのサイクル数と ns）
+ * を確かめる。引数にファイル名を渡すと、既知のシナリオ（32ビットのタイムスタンプの
+ * 折り返し、割り込み中の記録、開始が上書きで消えた終了イベント、カウンター）のダンプを
+ * そのファイルに書き、変換後に期待するイベントを "# expect" 行として同じファイルに残す。
+ * tools/trace2json.py --check が、変換して書き出した JSON を読み直して突き合わせる。
+ */
+
+#include "../src/trace.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/irq.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#define DMA_CH  3
+
+// ============================================================================
+// ヘルパー
+// ============================================================================
+
+/**
+ * @brief ダンプを最後まで進める
+ * @param log 出力先（NULL なら捨てる）
+ * @return trace_poll() の呼び出し回数
+ */
+static uint32_t run_dump(FILE *log) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    FILE *sink = log ? log : fopen("/dev/null", "w");
+    dup2(fileno(sink), STDOUT_FILENO);
+
+    trace_dump_start();
+    uint32_t polls = 0;
+    while (trace_is_dumping() && polls < 100000) {
+        trace_poll();
+        polls++;
+    }
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    if (!log) fclose(sink);
+    return polls;
+}
+
+// 割り込みハンドラー（DMA 完了で呼ばれ、IRQ フラグ付きで記録する）
+static uint16_t irq_arg = 0;
+
+static void dma_handler(void) {
+    dma_channel_acknowledge_irq0(DMA_CH);
+    TRACE_BEGIN(TRACE_EV_DMA_IRQ, irq_arg);
+    host_time_advance_us(3);
+    TRACE_COUNTER(TRACE_EV_RING_FILL, irq_arg);
+    TRACE_END(TRACE_EV_DMA_IRQ, irq_arg);
+}
+
+static void fire_irq(void) {
+    host_dma_complete(DMA_CH);
+    host_irq_service(DMA_IRQ_0, 1);
+}
+
+// ============================================================================
+// テスト
+// ============================================================================
+
+static void test_ring_and_trigger(void) {
+    printf("Ring overwrite, trigger and dump:\n");
+
+    host_time_set_virtual(true);
+    clear_buffers();
+    recording = true;
+
+    // 上書き: 最新の TRACE_EVENTS_PER_CORE 個だけ残る
+    const uint32_t n = TRACE_EVENTS_PER_CORE + 300;
+    for (uint32_t i = 0; i < n; i++) {
+        TRACE_INSTANT(TRACE_EV_PARAM_CHANGE, i);
+    }
+    CHECK(buffers[0].head == n);
+    uint32_t oldest = buffers[0].records[n & (TRACE_EVENTS_PER_CORE - 1)].arg;
+    CHECK(oldest == n - TRACE_EVENTS_PER_CORE);
+
+    // 引数は 65535 で飽和
+    TRACE_INSTANT(TRACE_EV_PARAM_CHANGE, 100000);
+    CHECK(buffers[0].records[n & (TRACE_EVENTS_PER_CORE - 1)].arg == 0xFFFF);
+
+    // トリガー後は TRACE_POST_TRIGGER_EVENTS 個で止まり、2回目のトリガーは無視
+    clear_buffers();
+    recording = true;
+    for (uint32_t i = 0; i < 50; i++) TRACE_INSTANT(TRACE_EV_RING_WRITE, i);
+    TRACE_TRIGGER();
+    for (uint32_t i = 0; i < TRACE_POST_TRIGGER_EVENTS + 500; i++) {
+        if (i == 10) TRACE_TRIGGER();
+        TRACE_INSTANT(TRACE_EV_RING_WRITE, i);
+    }
+    printf("  after trigger: %lu events kept (50 before + %d after), recording %s\n",
+           buffers[0].head, TRACE_POST_TRIGGER_EVENTS, recording ? "on" : "off");
+    CHECK(buffers[0].head == 50 + TRACE_POST_TRIGGER_EVENTS);
+    CHECK(!recording);
+
+    // 止まった記録はダンプまで保持し、ダンプが終わると空にして再開する
+    uint32_t polls = run_dump(NULL);
+    printf("  dump of %lu events took %lu polls (%d lines each)\n",
+           50ul + TRACE_POST_TRIGGER_EVENTS, polls, TRACE_DUMP_LINES_PER_POLL);
+    CHECK(polls >= (50 + TRACE_POST_TRIGGER_EVENTS) / TRACE_DUMP_LINES_PER_POLL);
+    CHECK(recording && !triggered && buffers[0].head == 0);
+
+    // ダンプ中は記録しない
+    trace_dump_start();
+    TRACE_INSTANT(TRACE_EV_RING_WRITE, 1);
+    CHECK(buffers[0].head == 0);
+    run_dump(NULL);
+}
+
+/**
+ * @brief 変換を確かめるシナリオのダンプを書く
+ */
+static void write_scenario(const char *path) {
+    printf("Scenario dump for tools/trace2json.py -> %s:\n", path);
+
+    FILE *log = fopen(path, "w");
+    CHECK(log != NULL);
+    if (!log) return;
+
+    // タイムスタンプが途中で 32ビットを折り返す
+    host_time_set_virtual(true);
+    host_time_set_us(0xFFFFFFFFull - 100000);
+    clear_buffers();
+    recording = true;
+
+    dma_channel_set_irq0_enabled(DMA_CH, true);
+    irq_set_exclusive_handler(DMA_IRQ_0, dma_handler);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    // 最初の decode の開始は上書きで消える（終了だけ残り、変換で捨てられる）
+    TRACE_BEGIN(TRACE_EV_DECODE, 0);
+    host_time_advance_us(5);
+
+    // メインループ: パケット → デコード → エフェクト → リング書き込み、合間に DMA 割り込み
+    uint32_t packets = 0;
+    while (buffers[0].head < TRACE_EVENTS_PER_CORE + 40) {
+        TRACE_INSTANT(TRACE_EV_MEDIA_PACKET, 600 + packets % 7);
+        host_time_advance_us(2);
+        if (packets > 0) TRACE_BEGIN(TRACE_EV_DECODE, 0);
+        host_time_advance_us(40);
+        TRACE_END(TRACE_EV_DECODE, 0);
+        TRACE_BEGIN(TRACE_EV_EFFECT, 128);
+        host_time_advance_us(25);
+        if (packets % 3 == 0) {
+            irq_arg = (uint16_t)(4000 + packets);
+            fire_irq();
+        }
+        TRACE_END(TRACE_EV_EFFECT, 128);
+        TRACE_BEGIN(TRACE_EV_RING_WRITE, 128);
+        host_time_advance_us(4);
+        TRACE_END(TRACE_EV_RING_WRITE, (uint16_t)(4100 + packets));
+        host_time_advance_us(1500);
+        packets++;
+    }
+    // 最後の1つは decode の途中でダンプ（終了のない開始）
+    TRACE_BEGIN(TRACE_EV_DECODE, 0);
+    host_time_advance_us(10);
+
+    // 残っているレコードから、変換後に期待するイベントを書く（古い順）
+    uint32_t head = buffers[0].head;
+    uint32_t first = head - TRACE_EVENTS_PER_CORE;
+    uint32_t origin = buffers[0].records[first & (TRACE_EVENTS_PER_CORE - 1)].ts_us;
+    uint32_t irq_records = 0, dropped_ends = 0;
+    int open[TRACE_EV_COUNT][2];
+    memset(open, 0, sizeof(open));
+    static const char phases[4] = { 'B', 'E', 'i', 'C' };
+
+    for (uint32_t i = first; i < head; i++) {
+        const trace_record_t *r = &buffers[0].records[i & (TRACE_EVENTS_PER_CORE - 1)];
+        uint32_t phase = r->flags & 0x03;
+        uint32_t irq = (r->flags & TRACE_FLAG_IRQ) ? 1 : 0;
+        irq_records += irq;
+        if (phase == TRACE_PHASE_BEGIN) open[r->event][irq]++;
+        if (phase == TRACE_PHASE_END) {
+            if (open[r->event][irq] == 0) {
+                dropped_ends++;
+                continue;
+            }
+            open[r->event][irq]--;
+        }
+        fprintf(log, "# expect %s %c %lu %lu %u\n", event_names[r->event], phases[phase],
+                (unsigned long)(uint32_t)(r->ts_us - origin), irq, r->arg);
+    }
+    fprintf(log, "# expect-lost %lu\n", (unsigned long)first);
+
+    // ダンプ（記録は止まる）。前後にログのテキストが混ざっていてもよい
+    fprintf(log, "Buffer: 8820/44100 (20.0%%)\n");
+    fflush(log);
+    run_dump(log);
+    fprintf(log, "[LATENCY] Total: 0 frames\n");
+    fclose(log);
+
+    printf("  %lu packets, %d records kept (%lu lost), %lu in IRQ, %lu orphan end(s), first ts %08lx\n",
+           packets, TRACE_EVENTS_PER_CORE, first, irq_records, dropped_ends, (unsigned long)origin);
+    CHECK(irq_records > 0);
+    CHECK(dropped_ends >= 1);
+    CHECK(buffers[0].records[(head - 1) & (TRACE_EVENTS_PER_CORE - 1)].ts_us < origin);
+
+    irq_set_enabled(DMA_IRQ_0, false);
+    host_time_set_virtual(false);
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    printf("trace_record() cost per event (host):\n");
+
+    host_time_set_virtual(false);
+    const int reps = 1000000;
+    double cycles[2], ns[2];
+
+    for (int on = 1; on >= 0; on--) {
+        uint64_t best_c = UINT64_MAX, best_ns = UINT64_MAX;
+        for (int round = 0; round < 5; round++) {
+            clear_buffers();
+            recording = (on != 0);
+            uint64_t t0 = bench_now_ns();
+            uint64_t c0 = bench_cycles();
+            for (int i = 0; i < reps; i++) {
+                TRACE_INSTANT(TRACE_EV_PARAM_CHANGE, (uint32_t)i);
+            }
+            uint64_t c1 = bench_cycles();
+            uint64_t t1 = bench_now_ns();
+            if (c1 - c0 < best_c) best_c = c1 - c0;
+            if (t1 - t0 < best_ns) best_ns = t1 - t0;
+        }
+        bench_sink(buffers, sizeof(buffers));
+        cycles[on] = (double)best_c / reps;
+        ns[on] = (double)best_ns / reps;
+    }
+    printf("  recording: %.1f host cycles (%.1f ns); stopped: %.1f cycles (%.1f ns)\n",
+           cycles[1], ns[1], cycles[0], ns[0]);
+    printf("  (includes time_us_32(), which is clock_gettime() on the host; "
+           "target ns/event: [TRACE] log line of trace_init())\n");
+    CHECK(cycles[0] <= cycles[1]);
+
+    clear_buffers();
+    recording = true;
+}
+
+int main(int argc, char **argv) {
+    host_sdk_reset();
+
+    test_ring_and_trigger();
+    if (argc > 1) {
+        write_scenario(argv[1]);
+    } else {
+        bench();
+    }
+    return test_summary("test_trace");
+}
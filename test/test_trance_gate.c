@@ -0,0 +1,198 @@
+/**
+ * @file test_trance_gate.c
+ * @brief トランスゲートのステップタイミングのホストテストと、フレームあたりのコスト
+ *
+ * trance_gate.c を取り込み、本物のビートクロック（beat_clock.c）で拍位置を進める。
+ * - 端数のある BPM（とバリスピードの速度）で、DC に掛けたゲートの切り替わり（ランプの頭）を
+ *   出力から検出し、
+ *   - ビートクロックの拍位置が境目に届く最初のフレームとすべて一致すること
+ *     （ブロックの長さはバリスピードの出力のように 1〜1024 フレームでばらつかせる）
+ *   - 正確なテンポから求めた時刻とのずれが、増分の丸め（1フレームあたり 2^-33 拍以下）の
+ *     累積 + 1フレーム以内に収まること（10分間）
+ *   を確かめる
+ * - 無効（素通り）、デプス 1.0（閉じた区間は 0 埋め）、デプス 0.5（乗算）で
+ *   trance_gate_process() のフレームあたりのホストのサイクル数を測る
+ *   （ターゲットの数字は trance_gate_get_cycles() が実機で報告する）
+ */
+
+#include "../src/trance_gate.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+
+#define FS          44100
+#define MAX_BLOCK   1024
+#define DC          16384
+
+// ============================================================================
+// ステップタイミング
+// ============================================================================
+
+typedef struct {
+    float bpm;
+    float speed;              // バリスピード（ビートクロックの速度）
+    uint32_t rate;            // 1拍あたりのステップ数
+} timing_case_t;
+
+typedef struct {
+    uint32_t transitions;
+    uint32_t mismatches;      // ビートクロックから予測したフレームと違う切り替わり
+    double max_error;         // 正確なテンポとのずれの最大（フレーム）
+    double bound;             // 増分の丸めの累積 + 1 フレーム
+} timing_result_t;
+
+/**
+ * @brief minutes 分流し、切り替わりを予測・理想と比べる
+ */
+static timing_result_t run_timing(const timing_case_t *tc, uint32_t minutes) {
+    static int16_t l[MAX_BLOCK], r[MAX_BLOCK];
+    timing_result_t res = { 0, 0, 0.0, 0.0 };
+
+    beat_clock_init(FS);
+    beat_clock_set_bpm(tc->bpm);
+    beat_clock_set_speed(tc->speed);
+
+    static const uint8_t open[1] = { 100 };
+    trance_gate_init();
+    trance_gate_set_pattern(open, 1);
+    trance_gate_set_depth(1.0f);
+    trance_gate_set_rate(tc->rate);
+    trance_gate_set_duty(0.75f);
+    trance_gate_set_enabled(true);
+
+    // 予測: ゲートと同じ 0.32 の境目に、拍位置が届く最初のフレーム
+    uint64_t inc = beat_clock_get_position_at(1) - beat_clock_get_position_at(0);
+    uint64_t step_q32 = ((uint64_t)1 << 32) / tc->rate;
+    uint64_t open_q32 = (step_q32 * duty_q32) >> 32;
+    // 理想: 正確なテンポでの時刻（フレーム）
+    double frames_per_step = 60.0 * FS / ((double)tc->bpm * (double)tc->speed * tc->rate);
+
+    uint32_t rng = 7 + tc->rate;
+    uint64_t frame = 0;
+    uint64_t total = (uint64_t)minutes * 60 * FS;
+    uint32_t k = 0;                 // 次の切り替わり: 偶数 = ステップ k/2 が閉じる、奇数 = 次のステップが開く
+    int16_t prev = DC;
+    bool plateau = true;            // 直前の2フレームが同じ値（ランプ中でない）
+
+    while (frame < total) {
+        uint32_t n = 1 + test_rand(&rng) % MAX_BLOCK;
+        for (uint32_t i = 0; i < n; i++) l[i] = r[i] = DC;
+        trance_gate_process(l, r, n);
+        beat_clock_advance(n);
+
+        for (uint32_t i = 0; i < n; i++) {
+            // ランプの1フレーム目はまだ元のゲインなので、値が変わったフレームの1つ前が境目
+            if (plateau && l[i] != prev) {
+                uint64_t detected = frame + i - 1;
+                uint64_t step = k / 2;
+                uint64_t boundary = (k % 2 == 0) ? step * step_q32 + open_q32 : (step + 1) * step_q32;
+                uint64_t predicted = (boundary + inc - 1) / inc;
+                double ideal = (k % 2 == 0) ? (step + 0.75) * frames_per_step : (step + 1) * frames_per_step;
+
+                if (detected != predicted) res.mismatches++;
+                double err = fabs((double)detected - ideal);
+                if (err > res.max_error) res.max_error = err;
+                res.transitions++;
+                k++;
+            }
+            plateau = (l[i] == prev);
+            prev = l[i];
+        }
+        frame += n;
+    }
+
+    // 増分の丸めは 1フレームあたり 2^-33 拍以下、最後のフレームまでの累積をフレームに直す
+    res.bound = 1.0 + (double)total * ldexp(1.0, -33) * frames_per_step * tc->rate;
+    return res;
+}
+
+static void test_step_timing(void) {
+    static const timing_case_t cases[] = {
+        { 120.0f,  1.0f,  4 },
+        { 127.37f, 1.0f,  4 },
+        { 133.33f, 1.0f,  8 },
+        { 174.96f, 1.0f,  2 },
+        { 87.5f,   1.0f,  4 },
+        { 127.37f, 0.96f, 4 },     // バリスピード中（ビートクロックに速度が掛かる）
+    };
+    const uint32_t minutes = 10;
+
+    printf("Step timing over %lu min (duty 0.75, blocks of 1-%d frames):\n", minutes, MAX_BLOCK);
+    for (uint32_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const timing_case_t *tc = &cases[c];
+        timing_result_t res = run_timing(tc, minutes);
+        double expected = minutes * 60.0 * tc->bpm * tc->speed / 60.0 * tc->rate * 2.0;
+
+        printf("  %7.2f BPM x %.2f, 1/%lu beat: %6lu edges, %lu off the clock, "
+               "max %.2f frames (%.3f ms) from exact tempo (bound %.2f)\n",
+               (double)tc->bpm, (double)tc->speed, tc->rate, res.transitions, res.mismatches,
+               res.max_error, res.max_error * 1000.0 / FS, res.bound);
+        CHECK(res.mismatches == 0);
+        CHECK(fabs(res.transitions - expected) <= 2.0);
+        CHECK(res.max_error <= res.bound);
+    }
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    static int16_t l[MAX_BLOCK], r[MAX_BLOCK];
+    const uint32_t block = 128;
+    const uint32_t blocks = 20000;
+
+    printf("trance_gate_process() cost per frame (%lu-frame blocks, 1/16 steps at 127.37 BPM, host):\n",
+           block);
+
+    static const struct {
+        const char *name;
+        bool enabled;
+        float depth;
+    } modes[] = {
+        { "disabled", false, 1.0f },
+        { "depth 1.0", true, 1.0f },
+        { "depth 0.5", true, 0.5f },
+    };
+
+    double cycles[3];
+    for (uint32_t m = 0; m < 3; m++) {
+        trance_gate_init();
+        trance_gate_set_depth(modes[m].depth);
+        trance_gate_set_enabled(modes[m].enabled);
+        beat_clock_init(FS);
+        beat_clock_set_bpm(127.37f);
+
+        uint64_t best_c = UINT64_MAX, best_ns = UINT64_MAX;
+        for (int round = 0; round < 5; round++) {
+            uint64_t t = 0, c = 0;
+            for (uint32_t b = 0; b < blocks; b++) {
+                for (uint32_t i = 0; i < block; i++) l[i] = r[i] = (int16_t)(i * 97);
+                uint64_t t0 = bench_now_ns();
+                uint64_t c0 = bench_cycles();
+                trance_gate_process(l, r, block);
+                c += bench_cycles() - c0;
+                t += bench_now_ns() - t0;
+                beat_clock_advance(block);
+            }
+            bench_sink(l, sizeof(l));
+            if (c < best_c) best_c = c;
+            if (t < best_ns) best_ns = t;
+        }
+        cycles[m] = (double)best_c / ((double)blocks * block);
+        printf("  %-9s: %5.2f host cycles/frame (%.2f ns)\n",
+               modes[m].name, cycles[m], (double)best_ns / ((double)blocks * block));
+    }
+    printf("  (includes time_us_32() twice per block; target: trance_gate_get_cycles())\n");
+    CHECK(cycles[0] <= cycles[2]);
+}
+
+int main(void) {
+    host_sdk_reset();
+
+    test_step_timing();
+    bench();
+    return test_summary("test_trance_gate");
+}
@@ -0,0 +1,444 @@
+/**
+ * @file test_transient.c
+ * @brief トランジェントトリガーのホストテスト（ラベル付きの合成ドラムループ）とベンチマーク
+ *
+ * audio_effect.c を取り込む（検出器は transient_detector.c）。
+ * - 5種類のドラムループ（ハウス、ブレイク、ドラムンベース、スイングしたヒップホップ、
+ *   四つ打ち）を合成し、キックとスネアの位置をラベルとして残す。ゴーストノートと
+ *   ハイハット（クローズ / オープン）、ベースとパッド、ノイズを混ぜ、ベロシティを ±2 dB 揺らす。
+ *   検出を ±10 ms 以内のキック / スネアと突き合わせて適合率（precision）と再現率（recall）、
+ *   返した位置とラベルのずれを求める（ゴーストやハットで検出したら誤検出）
+ * - Beat-Repeat をトランジェントトリガーにして、スネアの少し前から取り直したスライスが
+ *   繰り返されること（スライスの頭 = トランジェントの TRANSIENT_PREROLL_FRAMES 前）
+ * - 検出器のブロック（EFFECT_CHUNK_FRAMES）あたりのホストのサイクル数
+ *   （ターゲットの数字は audio_effect_get_transient_stats() が実機で報告する）
+ */
+
+#include "../src/audio_effect.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#define FS           44100
+#define LOOP_SECONDS 60
+#define LOOP_FRAMES  (FS * LOOP_SECONDS)
+#define MAX_LABELS   4096
+#define TOLERANCE    (FS / 100)      // 10 ms
+
+// ============================================================================
+// ドラムループの合成
+// ============================================================================
+
+typedef enum {
+    HIT_KICK = 0,
+    HIT_SNARE,
+    HIT_GHOST,
+    HIT_HAT,
+    HIT_OPEN_HAT,
+} hit_t;
+
+typedef struct {
+    int32_t pos;
+    bool strong;            // キック / スネア（検出すべきもの）
+} label_t;
+
+static float mix_l[LOOP_FRAMES], mix_r[LOOP_FRAMES];
+static int16_t pcm_l[LOOP_FRAMES], pcm_r[LOOP_FRAMES];
+static label_t labels[MAX_LABELS];
+static uint32_t num_labels = 0;
+static uint32_t rng = 1;
+
+static float rnd(void) {
+    return (float)(test_rand(&rng) >> 8) / 8388608.0f - 1.0f;
+}
+
+/**
+ * @brief 1打を足す（ラベルも残す）
+ */
+static void add_hit(hit_t type, int32_t at, float v, float pan) {
+    float ph = 0.0f, prev = 0.0f, prev_d = 0.0f, lp = 0.0f;
+    int32_t len = (type == HIT_HAT) ? FS / 10 : FS / 2;
+
+    for (int32_t n = 0; n < len && at + n < LOOP_FRAMES; n++) {
+        float t = (float)n / FS;
+        float w = rnd();
+        float d1 = w - prev;          // 1次の差分（高域寄りのノイズ）
+        float d2 = d1 - prev_d;       // 2次の差分（ハット）
+        prev = w;
+        prev_d = d1;
+
+        float x = 0.0f;
+        switch (type) {
+            case HIT_KICK: {
+                // 160 Hz → 50 Hz に落ちるサイン + 短いクリック
+                float f = 50.0f + 110.0f * expf(-t / 0.035f);
+                ph += 2.0f * (float)M_PI * f / FS;
+                x = v * (sinf(ph) * expf(-t / 0.13f) + 0.25f * w * expf(-t / 0.0015f));
+                break;
+            }
+            case HIT_SNARE:
+            case HIT_GHOST:
+                // 胴鳴り（190 Hz）+ スナッピー（ノイズ）
+                ph += 2.0f * (float)M_PI * 190.0f / FS;
+                lp += 0.5f * (d1 - lp);
+                x = v * (0.5f * sinf(ph) * expf(-t / 0.045f) + 0.7f * lp * expf(-t / 0.09f));
+                break;
+            case HIT_HAT:
+                x = v * 0.5f * d2 * expf(-t / 0.02f);
+                break;
+            case HIT_OPEN_HAT:
+                x = v * 0.5f * d2 * expf(-t / 0.16f);
+                break;
+        }
+        mix_l[at + n] += x * (1.0f - pan);
+        mix_r[at + n] += x * (1.0f + pan);
+    }
+
+    if (num_labels < MAX_LABELS) {
+        labels[num_labels].pos = at;
+        labels[num_labels].strong = (type == HIT_KICK || type == HIT_SNARE);
+        num_labels++;
+    }
+}
+
+/**
+ * @brief 背景（拍ごとに音の変わるレガートのベース、パッド、ノイズ）
+ */
+static void add_bed(float bpm, float bass, float pad) {
+    static const float notes[8] = { 55.0f, 55.0f, 65.4f, 73.4f, 55.0f, 82.4f, 73.4f, 65.4f };
+    int32_t beat = (int32_t)(FS * 60.0f / bpm);
+    float ph = 0.0f, lp = 0.0f, p1 = 0.0f, p2 = 0.0f, p3 = 0.0f;
+
+    for (int32_t n = 0; n < LOOP_FRAMES; n++) {
+        int32_t k = (n / beat) % 8;
+        float env = fminf(1.0f, (float)(n % beat) / (0.012f * FS));   // 柔らかい立ち上がり
+        ph += notes[k] / FS;
+        if (ph >= 1.0f) ph -= 1.0f;
+        lp += 0.05f * ((2.0f * ph - 1.0f) - lp);
+        p1 += 2.0f * (float)M_PI * 220.0f / FS;
+        p2 += 2.0f * (float)M_PI * 277.2f / FS;
+        p3 += 2.0f * (float)M_PI * 329.6f / FS;
+        float x = bass * env * lp + pad * (sinf(p1) + sinf(p2) + sinf(p3)) / 3.0f + 0.001f * rnd();
+        mix_l[n] += x;
+        mix_r[n] += x;
+    }
+}
+
+static float velocity(float v) {
+    return v * powf(10.0f, 2.0f * rnd() / 20.0f);
+}
+
+static int compare_labels(const void *a, const void *b) {
+    return ((const label_t *)a)->pos - ((const label_t *)b)->pos;
+}
+
+/**
+ * @brief ループの定義
+ *
+ * パターンは16分音符ごと: K キック、S スネア、B キック + スネア（ラベル1つ）、g ゴースト、
+ * o オープンハット。hat_every ステップごとに（キック / スネアのないところに）クローズドハット。
+ */
+typedef struct {
+    const char *name;
+    float bpm;
+    const char *pattern;
+    uint32_t hat_every;
+    float hat_velocity;
+    float swing;            // 裏の16分を遅らせる割合
+    float bass;
+    float pad;
+} loop_t;
+
+static const loop_t loops[] = {
+    { "house",     124.0f, "K...S...K...S..o", 2, 0.12f, 0.00f, 0.25f, 0.04f },
+    { "break",      92.0f, "K.g.S..K.KS.g.Sg", 1, 0.08f, 0.00f, 0.15f, 0.02f },
+    { "dnb",       174.0f, "K...S.....K.S...", 2, 0.12f, 0.00f, 0.30f, 0.05f },
+    { "hiphop",     88.0f, "K..gS..gK.K.S.gg", 1, 0.18f, 0.16f, 0.20f, 0.06f },
+    { "fourfloor", 130.0f, "K...B...K...B...", 1, 0.14f, 0.00f, 0.35f, 0.08f },
+};
+
+static void make_loop(const loop_t *loop, uint32_t seed) {
+    memset(mix_l, 0, sizeof(mix_l));
+    memset(mix_r, 0, sizeof(mix_r));
+    num_labels = 0;
+    rng = seed;
+
+    add_bed(loop->bpm, loop->bass, loop->pad);
+
+    double step = FS * 60.0 / loop->bpm / 4.0;
+    uint32_t len = (uint32_t)strlen(loop->pattern);
+    for (uint32_t s = 0; ; s++) {
+        int32_t at = (int32_t)(s * step + ((s & 1) ? loop->swing * step : 0.0));
+        if (at + FS / 2 >= LOOP_FRAMES) break;
+
+        char c = loop->pattern[s % len];
+        if (c == 'K') add_hit(HIT_KICK, at, velocity(0.8f), 0.0f);
+        if (c == 'S') add_hit(HIT_SNARE, at, velocity(0.7f), 0.1f);
+        if (c == 'B') {
+            add_hit(HIT_KICK, at, velocity(0.8f), 0.0f);
+            add_hit(HIT_SNARE, at, velocity(0.7f), 0.1f);
+            num_labels--;
+        }
+        if (c == 'g') add_hit(HIT_GHOST, at, velocity(0.12f), 0.1f);
+        if (c == 'o') {
+            add_hit(HIT_OPEN_HAT, at, velocity(loop->hat_velocity), -0.3f);
+        } else if (loop->hat_every && s % loop->hat_every == 0 && c != 'S' && c != 'K' && c != 'B') {
+            add_hit(HIT_HAT, at, velocity(loop->hat_velocity), -0.3f);
+        }
+    }
+    qsort(labels, num_labels, sizeof(label_t), compare_labels);
+
+    for (int32_t n = 0; n < LOOP_FRAMES; n++) {
+        pcm_l[n] = (int16_t)fmaxf(-32768.0f, fminf(32767.0f, mix_l[n] * 0.8f * 32767.0f));
+        pcm_r[n] = (int16_t)fmaxf(-32768.0f, fminf(32767.0f, mix_r[n] * 0.8f * 32767.0f));
+    }
+}
+
+// ============================================================================
+// 適合率 / 再現率
+// ============================================================================
+
+typedef struct {
+    uint32_t strong;
+    uint32_t weak;
+    uint32_t tp;
+    uint32_t fp;
+    uint32_t fp_on_weak;     // ゴースト / ハットで検出した
+    uint32_t fn;
+    double err_sum;          // 返した位置 - ラベル（フレーム）
+    int32_t err_min;
+    int32_t err_max;
+} score_t;
+
+static void score_loop(score_t *sc) {
+    static bool used[MAX_LABELS];
+    memset(used, 0, sizeof(used));
+
+    transient_detector_t det;
+    transient_detector_init(&det, TRANSIENT_DEFAULT_THRESHOLD, TRANSIENT_DEFAULT_REFRACTORY_MS, FS);
+
+    for (uint32_t k = 0; k < num_labels; k++) {
+        if (labels[k].strong) sc->strong++;
+        else sc->weak++;
+    }
+
+    for (uint32_t b = 0; b < LOOP_FRAMES; b += EFFECT_CHUNK_FRAMES) {
+        uint32_t n = (LOOP_FRAMES - b < EFFECT_CHUNK_FRAMES) ? LOOP_FRAMES - b : EFFECT_CHUNK_FRAMES;
+        int32_t onset;
+        if (!transient_detector_process(&det, &pcm_l[b], &pcm_r[b], n, &onset)) continue;
+
+        // いちばん近いラベル（±10 ms 以内）
+        int32_t pos = (int32_t)b + onset;
+        int32_t best = -1;
+        int32_t best_dist = TOLERANCE + 1;
+        for (uint32_t k = 0; k < num_labels; k++) {
+            int32_t d = abs(labels[k].pos - pos);
+            if (d < best_dist) {
+                best_dist = d;
+                best = (int32_t)k;
+            }
+        }
+
+        if (best >= 0 && labels[best].strong && !used[best]) {
+            used[best] = true;
+            sc->tp++;
+            int32_t err = pos - labels[best].pos;
+            sc->err_sum += err;
+            if (err < sc->err_min) sc->err_min = err;
+            if (err > sc->err_max) sc->err_max = err;
+        } else {
+            sc->fp++;
+            if (best >= 0 && !labels[best].strong) sc->fp_on_weak++;
+        }
+    }
+
+    for (uint32_t k = 0; k < num_labels; k++) {
+        if (labels[k].strong && !used[k]) sc->fn++;
+    }
+}
+
+static void test_precision_recall(void) {
+    printf("Detector on labelled drum loops (%d s each, threshold %.1f, refractory %.0f ms, match within %d ms):\n",
+           LOOP_SECONDS, (double)TRANSIENT_DEFAULT_THRESHOLD, (double)TRANSIENT_DEFAULT_REFRACTORY_MS,
+           TOLERANCE * 1000 / FS);
+
+    score_t total = { 0, 0, 0, 0, 0, 0, 0.0, INT32_MAX, INT32_MIN };
+    for (uint32_t i = 0; i < sizeof(loops) / sizeof(loops[0]); i++) {
+        make_loop(&loops[i], 1234 + i);
+
+        score_t sc = { 0, 0, 0, 0, 0, 0, 0.0, INT32_MAX, INT32_MIN };
+        score_loop(&sc);
+        printf("  %-9s %3.0f BPM: %3lu kick/snare, %3lu ghost/hat | TP %3lu FP %2lu (%lu on ghost/hat) FN %2lu"
+               " | P %.3f R %.3f | onset %+6.1f [%+ld, %+ld] frames\n",
+               loops[i].name, (double)loops[i].bpm, sc.strong, sc.weak, sc.tp, sc.fp, sc.fp_on_weak, sc.fn,
+               sc.tp / (double)(sc.tp + sc.fp), sc.tp / (double)(sc.tp + sc.fn),
+               sc.err_sum / sc.tp, (long)sc.err_min, (long)sc.err_max);
+
+        // ループごとにも大きく外さない
+        CHECK(sc.tp / (double)(sc.tp + sc.fp) >= 0.9);
+        CHECK(sc.tp / (double)(sc.tp + sc.fn) >= 0.85);
+
+        total.tp += sc.tp;
+        total.fp += sc.fp;
+        total.fn += sc.fn;
+        total.err_sum += sc.err_sum;
+        if (sc.err_min < total.err_min) total.err_min = sc.err_min;
+        if (sc.err_max > total.err_max) total.err_max = sc.err_max;
+    }
+
+    double precision = total.tp / (double)(total.tp + total.fp);
+    double recall = total.tp / (double)(total.tp + total.fn);
+    printf("  total: TP %lu FP %lu FN %lu | precision %.3f recall %.3f | onset mean %+.1f frames\n",
+           total.tp, total.fp, total.fn, precision, recall, total.err_sum / total.tp);
+    CHECK(precision >= 0.95);
+    CHECK(recall >= 0.93);
+}
+
+// ============================================================================
+// Beat-Repeat のトランジェントトリガー
+// ============================================================================
+
+#define TRIGGER_FRAMES  (FS * 4)
+#define SLICE_FRAMES    11025
+
+static void test_repeat_trigger(void) {
+    static const int32_t snares[3] = { 30011, 80777, 131003 };
+    static int16_t in_l[TRIGGER_FRAMES], in_r[TRIGGER_FRAMES];
+    static int16_t out_l[TRIGGER_FRAMES], out_r[TRIGGER_FRAMES];
+
+    printf("Beat-Repeat triggered by transients (3 snares over a 60 Hz bed, %d-frame slices):\n",
+           SLICE_FRAMES);
+
+    // 60 Hz の下地にノイズのスネア
+    rng = 1;
+    for (int32_t i = 0; i < TRIGGER_FRAMES; i++) {
+        in_l[i] = in_r[i] = (int16_t)lrint(600.0 * sin(2.0 * M_PI * 60.0 * i / FS));
+    }
+    for (int s = 0; s < 3; s++) {
+        for (int32_t k = 0; k < 6000; k++) {
+            int32_t i = snares[s] + k;
+            double v = in_l[i] + 12000.0 * exp(-k / 1500.0) * rnd();
+            in_l[i] = in_r[i] = (int16_t)lrint(v);
+        }
+    }
+
+    beat_clock_init(FS);
+    audio_effect_reset();
+    beat_repeat_params_t p;
+    audio_effect_get_params(&p);
+    p.enabled = true;
+    p.wet_mix = 100;
+    p.repeat_count = 1;
+    p.slice_length = SLICE_FRAMES;
+    p.slice_length_frac = 0;
+    p.window_shape = 0.0f;
+    p.pitch_shift = 1.0f;
+    p.pitch_mode = PITCH_MODE_FIXED_REVERSE;
+    p.stutter_enabled = false;
+    p.reverse = false;
+    p.loop_start = 0.0f;
+    p.loop_size_decay = 0.0f;
+    p.clock_divider = 1;
+    p.duck_enabled = false;
+    p.multiband_enabled = false;
+    p.slicer_enabled = false;
+    p.freeze = false;
+    p.repeat_trigger = REPEAT_TRIGGER_TRANSIENT;
+    audio_effect_update_params(&p);
+
+    memcpy(out_l, in_l, sizeof(in_l));
+    memcpy(out_r, in_r, sizeof(in_r));
+    uint32_t block_rng = 5;
+    for (uint32_t pos = 0; pos < TRIGGER_FRAMES; ) {
+        uint32_t n = 1 + test_rand(&block_rng) % 1024;
+        if (n > TRIGGER_FRAMES - pos) n = TRIGGER_FRAMES - pos;
+        audio_effect_process(&out_l[pos], &out_r[pos], n);
+        beat_clock_advance(n);
+        pos += n;
+    }
+
+    // 出力が入力と違うところ = リピート。その頭の 2000 フレームと一致する入力の位置を探す
+    uint32_t regions = 0, aligned = 0;
+    for (int32_t i = 0; i < TRIGGER_FRAMES - 2000; ) {
+        if (out_l[i] == in_l[i]) {
+            i++;
+            continue;
+        }
+        int32_t source = -1;
+        for (int32_t d = (i > 20000) ? i - 20000 : 0; d < i && source < 0; d++) {
+            if (memcmp(&out_l[i], &in_l[d], 2000 * sizeof(int16_t)) == 0) source = d;
+        }
+        regions++;
+        for (int s = 0; s < 3; s++) {
+            if (source < 0 || abs(source - snares[s]) > 1000) continue;
+            int32_t lead = snares[s] - source;
+            printf("  snare at %6ld: repeat from %6ld starts %ld frames before it (preroll %d)\n",
+                   (long)snares[s], (long)i, (long)lead, TRANSIENT_PREROLL_FRAMES);
+            // 返す位置はホップ単位なので、プリロールにホップ1つ分の前後を許す
+            if (lead >= TRANSIENT_PREROLL_FRAMES - TRANSIENT_HOP_FRAMES &&
+                lead <= TRANSIENT_PREROLL_FRAMES + 2 * TRANSIENT_HOP_FRAMES) {
+                aligned++;
+            }
+        }
+        i += SLICE_FRAMES;
+    }
+
+    uint32_t detections, triggers;
+    audio_effect_get_transient_stats(&detections, &triggers, NULL, NULL);
+    printf("  %lu repeats, %lu aligned to a snare, %lu detections, %lu triggers\n",
+           regions, aligned, detections, triggers);
+    CHECK(regions == 3);
+    CHECK(aligned == 3);
+    CHECK(triggers == 3);
+}
+
+// ============================================================================
+// ベンチマーク
+// ============================================================================
+
+static void bench(void) {
+    printf("transient_detector_process() cost (%d-frame blocks of the break loop, host):\n",
+           EFFECT_CHUNK_FRAMES);
+
+    make_loop(&loops[1], 1235);
+    const uint32_t blocks = LOOP_FRAMES / EFFECT_CHUNK_FRAMES;
+    uint64_t best_c = UINT64_MAX, best_ns = UINT64_MAX;
+    uint32_t hits = 0;
+
+    for (int round = 0; round < 5; round++) {
+        transient_detector_t det;
+        transient_detector_init(&det, TRANSIENT_DEFAULT_THRESHOLD, TRANSIENT_DEFAULT_REFRACTORY_MS, FS);
+        hits = 0;
+        uint64_t t0 = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        for (uint32_t b = 0; b < blocks; b++) {
+            int32_t onset;
+            hits += transient_detector_process(&det, &pcm_l[b * EFFECT_CHUNK_FRAMES],
+                                               &pcm_r[b * EFFECT_CHUNK_FRAMES], EFFECT_CHUNK_FRAMES, &onset);
+        }
+        uint64_t c1 = bench_cycles();
+        uint64_t t1 = bench_now_ns();
+        if (c1 - c0 < best_c) best_c = c1 - c0;
+        if (t1 - t0 < best_ns) best_ns = t1 - t0;
+    }
+    bench_sink(&hits, sizeof(hits));
+
+    double per_block = (double)best_c / blocks;
+    printf("  %.0f host cycles/block (%.2f cycles/frame, %.0f ns/block), %lu detections\n",
+           per_block, per_block / EFFECT_CHUNK_FRAMES, (double)best_ns / blocks, hits);
+    printf("  (target: avg/max cycles of audio_effect_get_transient_stats() in the buffer status log)\n");
+    CHECK(hits > 0);
+}
+
+int main(void) {
+    host_sdk_reset();
+    audio_effect_init(FS);
+
+    test_precision_recall();
+    test_repeat_trigger();
+    bench();
+    return test_summary("test_transient");
+}
@@ -0,0 +1,132 @@
+/**
+ * @file test_util.c
+ * @brief ホストテスト共通のヘルパーの実装
+ */
+
+#include "test_util.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+int test_failures = 0;
+
+int test_summary(const char *name) {
+    if (test_failures) {
+        printf("%s: %d check(s) FAILED\n", name, test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// ============================================================================
+// 計時
+// ============================================================================
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return bench_now_ns();
+#endif
+}
+
+void bench_sink(const void *p, uint32_t bytes) {
+    __asm__ volatile("" : : "r"(p), "r"(bytes) : "memory");
+}
+
+// ============================================================================
+// 信号・スペクトル
+// ============================================================================
+
+void fft(double *re, double *im, uint32_t n) {
+    // ビット反転の並べ替え
+    for (uint32_t i = 1, j = 0; i < n; i++) {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (uint32_t len = 2; len <= n; len <<= 1) {
+        double ang = -2.0 * M_PI / (double)len;
+        double wr = cos(ang), wi = sin(ang);
+        for (uint32_t i = 0; i < n; i += len) {
+            double cr = 1.0, ci = 0.0;
+            for (uint32_t k = 0; k < len / 2; k++) {
+                uint32_t a = i + k, b = i + k + len / 2;
+                double tr = re[b] * cr - im[b] * ci;
+                double ti = re[b] * ci + im[b] * cr;
+                re[b] = re[a] - tr; im[b] = im[a] - ti;
+                re[a] += tr; im[a] += ti;
+                double nr = cr * wr - ci * wi;
+                ci = cr * wi + ci * wr;
+                cr = nr;
+            }
+        }
+    }
+}
+
+void power_spectrum(const double *x, uint32_t n, double *power) {
+    double *re = malloc(n * sizeof(double));
+    double *im = calloc(n, sizeof(double));
+    double wsum = 0.0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        double t = 2.0 * M_PI * (double)i / (double)n;
+        double w = 0.35875 - 0.48829 * cos(t) + 0.14128 * cos(2 * t) - 0.01168 * cos(3 * t);
+        re[i] = x[i] * w;
+        wsum += w * w;
+    }
+    fft(re, im, n);
+    for (uint32_t k = 0; k <= n / 2; k++) {
+        power[k] = (re[k] * re[k] + im[k] * im[k]) / (wsum * (double)n);
+    }
+
+    free(re);
+    free(im);
+}
+
+double spectrum_snr_db(const double *power, uint32_t n, double fs, double signal_hz, double band_hz) {
+    // Blackman-Harris のメインローブは ±4 ビン
+    const int32_t width = 5;
+    int32_t sig_bin = (int32_t)lround(signal_hz * (double)n / fs);
+    int32_t band_bin = (int32_t)(band_hz * (double)n / fs);
+    if (band_bin > (int32_t)(n / 2)) band_bin = (int32_t)(n / 2);
+
+    double sig = 0.0, noise = 0.0;
+    for (int32_t k = width; k <= band_bin; k++) {
+        if (k >= sig_bin - width && k <= sig_bin + width) {
+            sig += power[k];
+        } else {
+            noise += power[k];
+        }
+    }
+    return 10.0 * log10(sig / (noise > 0.0 ? noise : 1e-30));
+}
+
+uint32_t test_rand(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
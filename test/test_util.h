@@ -0,0 +1,103 @@
+/**
+ * @file test_util.h
+ * @brief ホストテスト共通のヘルパー（チェック、計時、スペクトル）
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// ============================================================================
+// チェック
+// ============================================================================
+
+extern int test_failures;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_MSG(cond, ...) do { \
+    if (!(cond)) { \
+        printf("  FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define CHECK_NEAR(a, b, tol) do { \
+    double a_ = (double)(a), b_ = (double)(b); \
+    if (!(a_ - b_ <= (tol) && b_ - a_ <= (tol))) { \
+        printf("  FAIL %s:%d: %s = %g, expected %g +/- %g\n", \
+               __FILE__, __LINE__, #a, a_, b_, (double)(tol)); \
+        test_failures++; \
+    } \
+} while (0)
+
+/**
+ * @brief テストの結果を表示して終了コードを返す
+ */
+int test_summary(const char *name);
+
+// ============================================================================
+// 計時
+// ============================================================================
+
+/**
+ * @brief 単調増加のナノ秒
+ */
+uint64_t bench_now_ns(void);
+
+/**
+ * @brief ホストのサイクルカウンタ（x86 は TSC、それ以外はナノ秒）
+ *
+ * 数字はホストのもの。ターゲット（Cortex-M33）のサイクル数は各モジュールの
+ * *_get_cycles() が実機で報告する。
+ */
+uint64_t bench_cycles(void);
+
+/**
+ * @brief 最適化で計算が消えないように値を捨てる
+ */
+void bench_sink(const void *p, uint32_t bytes);
+
+// ============================================================================
+// 信号・スペクトル
+// ============================================================================
+
+/**
+ * @brief 複素 FFT（n は2のべき、in-place）
+ */
+void fft(double *re, double *im, uint32_t n);
+
+/**
+ * @brief 窓（Blackman-Harris 4項）付きのパワースペクトル（n/2 + 1 本）
+ * @param x 入力（n 点）
+ * @param power 出力（n/2 + 1 点、窓のパワーで正規化）
+ */
+void power_spectrum(const double *x, uint32_t n, double *power);
+
+/**
+ * @brief スペクトルから SNR を求める（信号 = 指定ビン ± width、雑音 = 帯域内の残り、DC は除く）
+ * @param power パワースペクトル（n/2 + 1 点）
+ * @param n FFT 点数
+ * @param fs サンプリングレート
+ * @param signal_hz 信号の周波数
+ * @param band_hz 雑音を数える上限周波数
+ * @return SNR（dB）
+ */
+double spectrum_snr_db(const double *power, uint32_t n, double fs, double signal_hz, double band_hz);
+
+/**
+ * @brief 32ビットの簡易乱数（xorshift）
+ */
+uint32_t test_rand(uint32_t *state);
+
+#endif // TEST_UTIL_H
@@ -0,0 +1,393 @@
+/**
+ * @file test_varispeed.c
+ * @brief バリスピードの品質・コストのベンチマークと、適応バッファとの協調のホストテスト
+ *
+ * varispeed.c を取り込み、出力リングは本物の audio_out_i2s.c（ステレオ）を使う。
+ * - 品質: 一定速度で正弦波を通し、出力を速度倍の周波数の正弦波に最小二乗で当てはめて
+ *   SINAD とゲインを求める（遮断周波数より上のトーンは折り返しの漏れとして測る）
+ * - コスト: 1バッチ（PCM_BATCH_MAX_FRAMES）あたりのホストのサイクル数 / フレーム
+ * - リングの模擬: リンクの目標深さ（LINK_TARGET_INITIAL_MS、main.c が設定する値）を持つ
+ *   リングに、+150 ppm のソースからバッチを書き、DMA が 512 フレームずつ消費する。
+ *   原速を外れている間に寄せ込みが起きないこと、オーバーラン / アンダーランしないこと、
+ *   原速に戻った後は寄せ込みでフィルが目標深さへ戻ることを確かめる。
+ *   寄せ込みを止めない場合（以前の動作）と寄せ込みの数を比べる。
+ */
+
+#include "../src/varispeed.c"
+
+#include "test_util.h"
+#include "host_sdk.h"
+#include "hardware/irq.h"
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FS              44100.0
+#define BATCH           PCM_BATCH_MAX_FRAMES
+#define DMA_BLOCK       512          // audio_out_i2s の I2S_DMA_BUFFER_SIZE
+#define SOURCE_PPM      150.0
+#define FIT_FRAMES      65536
+
+static int16_t in_l[BATCH], in_r[BATCH];
+static int16_t out_l[VARISPEED_MAX_OUTPUT(BATCH)], out_r[VARISPEED_MAX_OUTPUT(BATCH)];
+
+// ============================================================================
+// ヘルパー
+// ============================================================================
+
+static int saved_stdout = -1;
+
+/**
+ * @brief audio_out_i2s の書き込みログを捨てる / 戻す
+ */
+static void quiet(bool on) {
+    fflush(stdout);
+    if (on) {
+        saved_stdout = dup(STDOUT_FILENO);
+        FILE *sink = fopen("/dev/null", "w");
+        dup2(fileno(sink), STDOUT_FILENO);
+        fclose(sink);
+    } else if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+/**
+ * @brief DMA の転送中のバッファを完了させる（次のバッファをリングから埋める）
+ */
+static void complete_dma(void) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (host_dma[ch].claimed && host_dma[ch].busy) {
+            host_dma_complete(ch);
+            host_irq_service(DMA_IRQ_0, 4);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief リングを空にして、n フレームの無音を溜めた状態にする（DMA は進めない）
+ */
+static void ring_prefill(uint32_t n) {
+    audio_out_i2s_stop();
+    audio_out_i2s_clear_buffer();
+    memset(in_l, 0, sizeof(in_l));
+    memset(in_r, 0, sizeof(in_r));
+    while (audio_out_i2s_get_buffered_samples() + BATCH <= n) {
+        audio_out_i2s_write(in_l, in_r, BATCH);
+    }
+}
+
+// ============================================================================
+// 品質
+// ============================================================================
+
+/**
+ * @brief 一定速度で正弦波を通し、SINAD（dB）を返す
+ * @param gain_db 当てはめた正弦波のゲイン（dB）
+ * @param out_db 出力全体のパワー（入力比の dB、NULL 可）
+ */
+static double run_sine(double freq, float speed, double *gain_db, double *out_db) {
+    static double out[FIT_FRAMES * 2];
+    uint32_t n_out = 0;
+    double power = 0.0;
+    double phase = 0.0;
+    double amp = 0.89 * 32767.0;
+
+    varispeed_reset();
+    varispeed_set_speed(speed);
+
+    // 速度が落ち着くまで（スムージング 150 ms の10倍以上）流してから当てはめる区間を取る
+    for (uint32_t b = 0; n_out < FIT_FRAMES * 2; b++) {
+        for (uint32_t i = 0; i < BATCH; i++) {
+            in_l[i] = (int16_t)lrint(amp * sin(phase));
+            in_r[i] = in_l[i];
+            phase += 2.0 * M_PI * freq / FS;
+            if (phase > 2.0 * M_PI) phase -= 2.0 * M_PI;
+        }
+        uint32_t n = varispeed_process(in_l, in_r, BATCH, out_l, out_r);
+        if (b < 2 * FS / BATCH) continue;
+        for (uint32_t i = 0; i < n && n_out < FIT_FRAMES * 2; i++) {
+            if (n_out >= FIT_FRAMES) power += (double)out_l[i] * out_l[i];
+            out[n_out++] = out_l[i];
+        }
+    }
+    if (out_db) *out_db = 10.0 * log10(power / FIT_FRAMES / (amp * amp / 2.0) + 1e-30);
+    CHECK(fabsf(varispeed_get_current_speed() - speed) < 1e-4f);
+
+    // 後半 FIT_FRAMES を A sin + B cos に当てはめる（周波数は実際の読み位置の刻みから）
+    const double *x = &out[FIT_FRAMES];
+    double step = (double)(int64_t)((double)current_speed * (double)Q32_ONE) / (double)Q32_ONE;
+    double w = 2.0 * M_PI * freq * step / FS;
+    double xs = 0, xc = 0, ss = 0, cc = 0, sc = 0;
+    for (uint32_t i = 0; i < FIT_FRAMES; i++) {
+        double s = sin(w * i), c = cos(w * i);
+        xs += x[i] * s;
+        xc += x[i] * c;
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (xs * cc - xc * sc) / det;
+    double b = (xc * ss - xs * sc) / det;
+
+    double sig = 0.0, err = 0.0;
+    for (uint32_t i = 0; i < FIT_FRAMES; i++) {
+        double m = a * sin(w * i) + b * cos(w * i);
+        sig += m * m;
+        err += (x[i] - m) * (x[i] - m);
+    }
+    *gain_db = 10.0 * log10(sig / FIT_FRAMES / (amp * amp / 2.0));
+    return 10.0 * log10(sig / (err + 1e-9));
+}
+
+static void test_quality(void) {
+    static const float speeds[] = { 0.92f, 0.96f, 1.0f, 1.04f, 1.08f };
+    static const double freqs[] = { 1000, 5000, 10000, 15000, 18000 };
+
+    printf("SINAD (gain) of a -1 dBFS tone at steady speed (%d taps x %u phases, cutoff %.2f):\n",
+           VARISPEED_TAPS, NUM_PHASES, (double)VARISPEED_CUTOFF);
+
+    for (uint32_t si = 0; si < sizeof(speeds) / sizeof(speeds[0]); si++) {
+        printf("  %.2f:", (double)speeds[si]);
+        for (uint32_t fi = 0; fi < sizeof(freqs) / sizeof(freqs[0]); fi++) {
+            double gain;
+            double sinad = run_sine(freqs[fi], speeds[si], &gain, NULL);
+            printf("  %5.0f Hz %5.1f dB (%+.2f)", freqs[fi], sinad, gain);
+
+            if (speeds[si] == 1.0f) {
+                // 原速は遅延を合わせたコピー（量子化の誤差だけ）
+                CHECK(sinad > 90.0);
+            } else if (freqs[fi] <= 15000) {
+                CHECK(sinad > 75.0);
+                CHECK(fabs(gain) < 0.1);
+            } else {
+                // 遮断（0.88 × ナイキスト）の手前は少し減衰する
+                CHECK(sinad > 60.0);
+                CHECK(gain > -1.5 && gain < 0.1);
+            }
+        }
+        printf("\n");
+    }
+
+    // 速度を上げると出力でナイキストを超えるトーン（fs / 2 / 1.08 より上）は折り返す。
+    // 出力に残る分（= 折り返し）は出力全体のパワーで測る。遮断は速度で動かさないので、
+    // 抑えは遷移帯（0.88〜1.0 × ナイキスト）の減衰だけ（ナイキストの手前ほど効く）
+    printf("  aliasing at 1.08 (output power of a tone that would fold back):");
+    double worst = -200.0;
+    for (double f = 21000; f <= 22000; f += 500) {
+        double gain, out_db;
+        run_sine(f, 1.08f, &gain, &out_db);
+        printf("  %5.0f Hz %6.1f dB", f, out_db);
+        if (out_db > worst) worst = out_db;
+    }
+    printf("\n");
+    CHECK(worst < -20.0);
+}
+
+// ============================================================================
+// コスト
+// ============================================================================
+
+static void bench(void) {
+    printf("varispeed_process() cost per output frame (%d-frame batches, host):\n", BATCH);
+
+    for (uint32_t i = 0; i < BATCH; i++) {
+        in_l[i] = (int16_t)(10000.0 * sin(i * 0.07));
+        in_r[i] = (int16_t)(10000.0 * cos(i * 0.05));
+    }
+
+    static const float speeds[] = { 1.0f, 0.92f, 1.08f };
+    double cycles[3];
+    for (uint32_t si = 0; si < 3; si++) {
+        varispeed_reset();
+        varispeed_set_speed(speeds[si]);
+        for (uint32_t b = 0; b < FS / BATCH; b++) {
+            varispeed_process(in_l, in_r, BATCH, out_l, out_r);
+        }
+
+        const uint32_t blocks = 200;
+        uint64_t best_c = UINT64_MAX, best_ns = UINT64_MAX;
+        uint64_t frames = 0;
+        for (int round = 0; round < 5; round++) {
+            frames = 0;
+            uint64_t t0 = bench_now_ns();
+            uint64_t c0 = bench_cycles();
+            for (uint32_t b = 0; b < blocks; b++) {
+                frames += varispeed_process(in_l, in_r, BATCH, out_l, out_r);
+            }
+            uint64_t c1 = bench_cycles();
+            uint64_t t1 = bench_now_ns();
+            bench_sink(out_l, sizeof(out_l));
+            if (c1 - c0 < best_c) best_c = c1 - c0;
+            if (t1 - t0 < best_ns) best_ns = t1 - t0;
+        }
+        cycles[si] = (double)best_c / frames;
+        printf("  speed %.2f: %6.1f host cycles/frame (%.1f ns)\n",
+               (double)speeds[si], cycles[si], (double)best_ns / frames);
+    }
+    printf("  (target cycles per batch: [VARISPEED] avg/max in the buffer status log)\n");
+    // 原速はコピーだけ
+    CHECK(cycles[0] * 4.0 < cycles[1]);
+    CHECK(cycles[0] * 4.0 < cycles[2]);
+}
+
+// ============================================================================
+// リングの模擬（バリスピード + 適応バッファの寄せ込み）
+// ============================================================================
+
+typedef struct {
+    float speed;
+    uint32_t seconds;
+    bool settle;          // 区間の終わりまでにフィルが目標深さに戻るはず
+} segment_t;
+
+typedef struct {
+    uint32_t held_slips;        // 原速を外れている間の寄せ込み（間引き + 重複のフレーム数）
+    uint32_t unity_slips;       // 原速の間の寄せ込み
+    uint32_t underruns;
+    uint32_t overruns;
+    uint32_t fill_min;
+    uint32_t fill_max;
+    uint32_t capped_blocks;
+    uint32_t unsettled;         // settle の区間の終わりで目標深さに戻っていなかった数
+} ring_result_t;
+
+static const segment_t segments[] = {
+    { 1.00f, 10, true  },
+    { 0.96f,  3, false },      // 短いナッジ（遅く）
+    { 1.00f, 45, true  },
+    { 1.04f,  3, false },      // 短いナッジ（速く）
+    { 1.00f, 45, true  },
+    { 0.92f, 40, false },      // 長く掛けて余裕の限界まで
+    { 1.08f, 40, false },
+    { 1.00f, 60, true  },
+};
+
+static ring_result_t simulate_ring(bool hold, bool verbose) {
+    ring_result_t res = { 0, 0, 0, 0, UINT32_MAX, 0, 0, 0 };
+    const uint32_t target = (uint32_t)(LINK_TARGET_INITIAL_MS * FS / 1000);
+    const uint32_t tolerance = DMA_BLOCK / 2;
+
+    quiet(true);
+    audio_out_i2s_stop();
+    audio_out_i2s_clear_buffer();
+    quiet(false);
+    audio_out_i2s_set_target_depth(target);
+    varispeed_reset();
+    capped_blocks = 0;
+
+    double source_period = BATCH / (FS * (1.0 + SOURCE_PPM * 1e-6));
+    double dma_period = DMA_BLOCK / FS;
+    double t = 0.0, next_batch = 0.0, next_dma = 0.0, end = 0.0;
+    double phase = 0.0;
+    double fill_avg = target;      // audio_out_i2s と同じ 1/64 の平均
+
+    for (uint32_t s = 0; s < sizeof(segments) / sizeof(segments[0]); s++) {
+        varispeed_set_speed(segments[s].speed);
+        end += segments[s].seconds;
+
+        quiet(true);
+        while (t < end) {
+            if (next_dma <= next_batch) {
+                // DMA は開始後だけ進む（開始閾値まで溜まるのを待つ）
+                t = next_dma;
+                next_dma += dma_period;
+                complete_dma();
+                continue;
+            }
+            t = next_batch;
+            next_batch += source_period;
+
+            for (uint32_t i = 0; i < BATCH; i++) {
+                in_l[i] = (int16_t)(8000.0 * sin(phase));
+                in_r[i] = in_l[i];
+                phase += 2.0 * M_PI * 440.0 / FS;
+            }
+            uint32_t n = varispeed_process(in_l, in_r, BATCH, out_l, out_r);
+            if (!hold) audio_out_i2s_hold_depth(false);   // 以前の動作: 常に寄せ込む
+
+            // 平均は audio_out_i2s と同じく書き込み直前のフィルで取る
+            uint32_t before = audio_out_i2s_get_buffered_samples();
+            fill_avg += (before - fill_avg) / 64.0;
+            uint32_t count = audio_out_i2s_write(out_l, out_r, n);
+            uint32_t written = audio_out_i2s_get_buffered_samples() - before;
+            uint32_t slips = (written > count) ? written - count : count - written;
+            if (depth_held) res.held_slips += slips;
+            else res.unity_slips += slips;
+
+            uint32_t fill = audio_out_i2s_get_buffered_samples();
+            if (t > 5.0) {
+                if (fill < res.fill_min) res.fill_min = fill;
+                if (fill > res.fill_max) res.fill_max = fill;
+            }
+        }
+        quiet(false);
+
+        uint32_t fill = audio_out_i2s_get_buffered_samples();
+        int32_t off = (int32_t)lrint(fill_avg) - (int32_t)target;
+        if (segments[s].settle && (off > (int32_t)tolerance + DMA_BLOCK || off < -(int32_t)tolerance - DMA_BLOCK)) {
+            res.unsettled++;
+        }
+        if (verbose) {
+            printf("    %5.0f s  speed %.2f: fill %5lu (average %+6ld from target), current speed %.4f\n",
+                   end, (double)segments[s].speed, fill, (long)off, (double)current_speed);
+        }
+    }
+
+    audio_out_i2s_get_stats(&res.underruns, &res.overruns);
+    res.capped_blocks = capped_blocks;
+    return res;
+}
+
+static void print_ring(const char *name, const ring_result_t *r) {
+    printf("  %-10s slips %4lu while off unity, %4lu at unity; fill %lu-%lu; "
+           "%lu underruns, %lu overruns, %lu capped blocks, %lu unsettled\n",
+           name, r->held_slips, r->unity_slips, r->fill_min, r->fill_max,
+           r->underruns, r->overruns, r->capped_blocks, r->unsettled);
+}
+
+static void test_ring(void) {
+    printf("Ring with link target %d ms and varispeed (source %+.0f ppm, %d-frame batches):\n",
+           LINK_TARGET_INITIAL_MS, SOURCE_PPM, BATCH);
+
+    ring_result_t held = simulate_ring(true, true);
+    ring_result_t fight = simulate_ring(false, false);
+    print_ring("held", &held);
+    print_ring("not held", &fight);
+
+    // 原速を外れている間は寄せ込まない（以前の動作では打ち消し合っていた）
+    CHECK(held.held_slips == 0);
+    CHECK(fight.held_slips > 0);
+    // 原速では寄せ込みが働き、ソースのずれと、速度で伸び縮みした分を目標深さへ戻す
+    CHECK(held.unity_slips > 0);
+    CHECK(held.unsettled == 0);
+    CHECK(held.underruns == 0 && held.overruns == 0);
+    // 長く掛けた区間は余裕の限界で抑える
+    CHECK(held.capped_blocks > 0);
+    CHECK(held.fill_max < (uint32_t)AUDIO_BUFFER_SIZE);
+}
+
+int main(void) {
+    host_sdk_reset();
+    host_time_set_virtual(false);
+
+    quiet(true);
+    beat_clock_init(44100);
+    bool ok = varispeed_init(44100) && audio_out_i2s_init(44100, 16, 2);
+    quiet(false);
+    CHECK(ok);
+
+    // 品質とコストは余裕のあるリング（半分）で測る（速度の限界に掛からない）
+    quiet(true);
+    ring_prefill(AUDIO_BUFFER_SIZE / 2);
+    quiet(false);
+    test_quality();
+    bench();
+    test_ring();
+    return test_summary("test_varispeed");
+}
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""
+ELF のシンボル表（nm -S）から、名前が正規表現に合う関数のコードサイズを表示する。
+
+- 特殊化カーネル（repeat_kernel_*）のように、まとめて生成した関数群の合計を見る用
+- ファームウェアの ELF には arm-none-eabi-nm を、ホストテストのバイナリには nm を使う
+- --expect-count N で数が合わなければ終了コード 1（カーネル表の組み合わせ数の確認用）
+
+使い方:
+    python3 tools/code_size.py --nm arm-none-eabi-nm build/pico2w_bt_a2dp_receiver.elf --match '^repeat_kernel_'
+    python3 tools/code_size.py build-test/test_effect_kernels --match '^repeat_kernel_' --expect-count 32
+"""
+
+import argparse
+import re
+import subprocess
+import sys
+
+
+def read_symbols(nm, elf):
+    """(名前, サイズ) のリスト（コードのシンボルだけ）"""
+    out = subprocess.run([nm, '-S', '--defined-only', elf], check=True,
+                         stdout=subprocess.PIPE, universal_newlines=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        parts = line.split()
+        # アドレス サイズ 型 名前（サイズのないシンボルは3列）
+        if len(parts) != 4 or parts[2] not in 'tTwW':
+            continue
+        symbols.append((parts[3], int(parts[1], 16)))
+    return symbols
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Report the code size of functions matching a pattern')
+    parser.add_argument('elf', help='ELF file (firmware or host test binary)')
+    parser.add_argument('--nm', default='nm', help='nm to use (arm-none-eabi-nm for the firmware)')
+    parser.add_argument('--match', required=True, help='regular expression for function names')
+    parser.add_argument('--expect-count', type=int, help='fail unless this many functions match')
+    args = parser.parse_args()
+
+    pattern = re.compile(args.match)
+    # -O2 では静的関数名に .isra.0 などが付くことがある
+    matched = sorted((s for s in read_symbols(args.nm, args.elf) if pattern.search(s[0])),
+                     key=lambda s: s[0])
+
+    total = sum(size for _, size in matched)
+    for name, size in matched:
+        print('  %6d  %s' % (size, name))
+    if matched:
+        sizes = [size for _, size in matched]
+        print('%d functions, %d bytes total (%d-%d each)' % (len(matched), total, min(sizes), max(sizes)))
+    else:
+        print('no functions match %r' % args.match)
+
+    if args.expect_count is not None and len(matched) != args.expect_count:
+        print('FAIL: %d functions match, expected %d' % (len(matched), args.expect_count), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,729 @@
+#!/usr/bin/env python3
+"""
+i2s.pio の I2S 出力プログラムをホストでサイクル単位にエミュレートし、タイミングとビット配置を検証する。
+
+- src/i2s.pio をアセンブル（I2S に使う命令のサブセット）するか、ビルドで生成された
+  i2s.pio.h の命令配列を読み込む
+- ステートマシンを1サイクルずつ実行（side-set、遅延、wrap、autopull、FIFO 枯渇でのストール）
+- DMA と同じワード列（audio_block_pack_i2s / interleave_slot と同じパック）を FIFO に流す
+- ピン波形を VCD（GTKWave など）に出力し、先頭のフレームを文字で表示
+- BCLK の立ち上がりで DATA を読む受信側モデルで L/R のワードを復元し、元のサンプルと比較
+- 検証項目:
+    1フレームのサイクル数（config.h の PIO_CYCLES_PER_STEREO_SAMPLE）
+    1フレームの BCLK 数、BCLK のデューティ（High/Low のサイクル数）
+    LRCLK のデューティと、LRCLK が BCLK の立ち下がりで変わること
+    LRCLK とデータの位置関係（I2S: MSB は LRCLK の変化から1 BCLK 遅れ / 左詰め: 遅れなし）
+    復元したワードが元のサンプルと一致すること、FIFO 枯渇でストールしないこと
+
+ピンは相対番号: DATA = 0 から（データ線の数だけ）、side-set のベース = BCLK、その次 = LRCLK。
+どれかの検証に失敗すると終了コード 1（CI 用）。
+
+使い方:
+    python3 tools/pio_emu.py
+    python3 tools/pio_emu.py --program i2s_output_dual --data-lines 2 --vcd i2s_dual.vcd
+    python3 tools/pio_emu.py --header build/i2s.pio.h --format i2s
+    python3 tools/pio_emu.py --program i2s_output --words i2s_stereo_words.txt --tagged
+    python3 tools/pio_emu.py --program i2s_output_dual --data-lines 2 --words i2s_quad_words.txt --tagged
+
+--words には DMA が送るワード列（16進、1行に1フレーム分、# はコメント）を渡せる
+（test/test_i2s_stereo、test/test_i2s_quad が audio_out_i2s のステレオ / 4チャンネルの
+ワード列を書き出す）。
+--tagged は各サンプルの下位2ビットがチャンネル番号、残りがフレームの通し番号の列とみなし、
+復元した各フレームの全チャンネルが同じ通し番号を持つこと（フレームの整列）も検証する。
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+# ============================================================================
+# アセンブラ（pioasm と同じエンコード）
+# ============================================================================
+
+OP_JMP, OP_WAIT, OP_IN, OP_OUT, OP_PUSHPULL, OP_MOV, OP_IRQ, OP_SET = range(8)
+
+JMP_COND = {'': 0, '!x': 1, 'x--': 2, '!y': 3, 'y--': 4, 'x!=y': 5, 'pin': 6, '!osre': 7}
+OUT_DEST = {'pins': 0, 'x': 1, 'y': 2, 'null': 3, 'pindirs': 4, 'pc': 5, 'isr': 6, 'exec': 7}
+IN_SRC = {'pins': 0, 'x': 1, 'y': 2, 'null': 3, 'isr': 6, 'osr': 7}
+MOV_DEST = {'pins': 0, 'x': 1, 'y': 2, 'exec': 4, 'pc': 5, 'isr': 6, 'osr': 7}
+MOV_SRC = {'pins': 0, 'x': 1, 'y': 2, 'null': 3, 'status': 5, 'isr': 6, 'osr': 7}
+SET_DEST = {'pins': 0, 'x': 1, 'y': 2, 'pindirs': 4}
+
+
+class Program:
+    """アセンブル済みのプログラム"""
+
+    def __init__(self, name):
+        self.name = name
+        self.instructions = []
+        self.sideset_bits = 0       # opt の有効ビットを含まない
+        self.sideset_opt = False
+        self.wrap_target = 0
+        self.wrap = None
+        self.public = {}
+
+    def delay_bits(self):
+        return 5 - self.sideset_bits - (1 if self.sideset_opt else 0)
+
+
+def parse_value(text):
+    text = text.strip()
+    if text.startswith('0b'):
+        return int(text[2:], 2)
+    return int(text, 0)
+
+
+def assemble(path, name):
+    """.pio ファイルから指定のプログラムをアセンブル"""
+    with open(path) as f:
+        lines = f.read().splitlines()
+
+    prog = None
+    body = []
+    in_c_block = False
+    for line in lines:
+        if line.startswith('% c-sdk'):
+            in_c_block = True
+            continue
+        if in_c_block:
+            if line.startswith('%}'):
+                in_c_block = False
+            continue
+        line = line.split(';')[0].split('//')[0].strip()
+        if not line:
+            continue
+        if line.startswith('.program'):
+            if prog is not None and prog.name == name:
+                break
+            prog = Program(line.split()[1]) if line.split()[1] == name else None
+            continue
+        if prog is None:
+            continue
+        body.append(line)
+
+    if prog is None:
+        raise ValueError('%s: program %s not found' % (path, name))
+
+    # 1パス目: ラベルと指示子
+    labels = {}
+    pc = 0
+    for line in body:
+        if line.startswith('.side_set'):
+            parts = line.split()
+            prog.sideset_bits = int(parts[1])
+            prog.sideset_opt = 'opt' in parts[2:]
+            if 'pindirs' in parts[2:]:
+                raise ValueError('side_set pindirs is not supported')
+        elif line == '.wrap_target':
+            prog.wrap_target = pc
+        elif line == '.wrap':
+            prog.wrap = pc - 1
+        elif line.startswith('.'):
+            raise ValueError('unsupported directive: %s' % line)
+        elif line.endswith(':'):
+            label = line[:-1].split()
+            if label[0] == 'public':
+                prog.public[label[1]] = pc
+            labels[label[-1]] = pc
+        else:
+            pc += 1
+    if prog.wrap is None:
+        prog.wrap = pc - 1
+
+    # 2パス目: エンコード
+    for line in body:
+        if line.startswith('.') or line.endswith(':'):
+            continue
+        prog.instructions.append(encode(prog, line, labels))
+    return prog
+
+
+def encode(prog, line, labels):
+    """1命令をエンコード"""
+    side = None
+    delay = 0
+    m = re.search(r'\[(\d+)\]\s*$', line)
+    if m:
+        delay = int(m.group(1))
+        line = line[:m.start()].strip()
+    m = re.search(r'\bside\s+(\S+)\s*$', line)
+    if m:
+        side = parse_value(m.group(1))
+        line = line[:m.start()].strip()
+
+    mnemonic, _, rest = line.partition(' ')
+    args = [a.strip() for a in rest.split(',')] if rest.strip() else []
+
+    if mnemonic == 'nop':
+        op = (OP_MOV << 13) | (MOV_DEST['y'] << 5) | MOV_SRC['y']
+    elif mnemonic == 'jmp':
+        tokens = rest.replace(',', ' ').split()
+        cond = tokens[0] if len(tokens) == 2 else ''
+        target = tokens[-1]
+        addr = labels[target] if target in labels else parse_value(target)
+        op = (OP_JMP << 13) | (JMP_COND[cond] << 5) | addr
+    elif mnemonic == 'out':
+        bits = parse_value(args[1])
+        op = (OP_OUT << 13) | (OUT_DEST[args[0]] << 5) | (bits & 0x1F)
+    elif mnemonic == 'in':
+        bits = parse_value(args[1])
+        op = (OP_IN << 13) | (IN_SRC[args[0]] << 5) | (bits & 0x1F)
+    elif mnemonic == 'set':
+        op = (OP_SET << 13) | (SET_DEST[args[0]] << 5) | (parse_value(args[1]) & 0x1F)
+    elif mnemonic == 'mov':
+        src = args[1]
+        mov_op = 0
+        if src.startswith('!') or src.startswith('~'):
+            mov_op, src = 1, src[1:]
+        elif src.startswith('::'):
+            mov_op, src = 2, src[2:]
+        op = (OP_MOV << 13) | (MOV_DEST[args[0]] << 5) | (mov_op << 3) | MOV_SRC[src]
+    elif mnemonic in ('pull', 'push'):
+        flags = rest.split()
+        block = 0 if 'noblock' in flags else 1
+        cond = 1 if ('ifempty' in flags or 'iffull' in flags) else 0
+        op = (OP_PUSHPULL << 13) | ((1 if mnemonic == 'pull' else 0) << 7) | (cond << 6) | (block << 5)
+    else:
+        raise ValueError('unsupported instruction: %s' % line)
+
+    # side-set と遅延（side-set は遅延/サイドセット欄の上位ビット）
+    field = 0
+    delay_bits = prog.delay_bits()
+    if delay >= (1 << delay_bits):
+        raise ValueError('delay too large: %s' % line)
+    if side is not None:
+        if prog.sideset_bits == 0 or side >= (1 << prog.sideset_bits):
+            raise ValueError('bad side-set: %s' % line)
+        if prog.sideset_opt:
+            field = (1 << 4) | (side << (4 - prog.sideset_bits))
+        else:
+            field = side << (5 - prog.sideset_bits)
+    elif prog.sideset_bits and not prog.sideset_opt:
+        raise ValueError('side-set required: %s' % line)
+    field |= delay
+    return op | (field << 8)
+
+
+def load_header(path, name):
+    """pioasm が生成したヘッダーから命令配列と設定を読む"""
+    with open(path) as f:
+        text = f.read()
+    m = re.search(r'%s_program_instructions\[\]\s*=\s*\{(.*?)\};' % re.escape(name), text, re.S)
+    if not m:
+        raise ValueError('%s: %s_program_instructions not found' % (path, name))
+    body = re.sub(r'//.*', '', m.group(1))
+    prog = Program(name)
+    prog.instructions = [int(v, 16) for v in re.findall(r'0x[0-9a-fA-F]+', body)]
+    prog.wrap_target = int(re.search(r'#define %s_wrap_target (\d+)' % name, text).group(1))
+    prog.wrap = int(re.search(r'#define %s_wrap (\d+)' % name, text).group(1))
+    m = re.search(r'%s_program_get_default_config.*?sm_config_set_sideset\(&c, (\d+), (true|false)' % name,
+                  text, re.S)
+    if m:
+        total = int(m.group(1))
+        prog.sideset_opt = m.group(2) == 'true'
+        prog.sideset_bits = total - (1 if prog.sideset_opt else 0)
+    for label, value in re.findall(r'#define %s_offset_(\w+) (\d+)u?' % name, text):
+        prog.public[label] = int(value)
+    return prog
+
+
+# ============================================================================
+# ステートマシン
+# ============================================================================
+
+class StateMachine:
+    """1つのステートマシン（出力に使う機能だけ）"""
+
+    def __init__(self, prog, out_base, out_count, set_base, set_count, sideset_base,
+                 shift_right=False, autopull=True, pull_threshold=32, pc=0):
+        self.prog = prog
+        self.out_base, self.out_count = out_base, out_count
+        self.set_base, self.set_count = set_base, set_count
+        self.sideset_base = sideset_base
+        self.shift_right = shift_right
+        self.autopull = autopull
+        self.threshold = pull_threshold
+        self.pc = pc
+        self.x = 0
+        self.y = 0
+        self.osr = 0
+        self.osr_count = 32          # 空（最初の OUT で autopull）
+        self.isr = 0
+        self.isr_count = 0
+        self.delay = 0
+        self.fifo = []
+        self.pins = 0
+        self.stalls = 0
+        self.words_pulled = 0
+
+    def set_pins(self, base, count, value):
+        mask = ((1 << count) - 1) << base
+        self.pins = (self.pins & ~mask) | ((value << base) & mask)
+
+    def refill(self):
+        if self.fifo:
+            self.osr = self.fifo.pop(0)
+            self.osr_count = 0
+            self.words_pulled += 1
+            return True
+        return False
+
+    def shift_out(self, bits):
+        bits = bits or 32
+        if self.shift_right:
+            value = self.osr & ((1 << bits) - 1)
+            self.osr = (self.osr >> bits) if bits < 32 else 0
+        else:
+            value = (self.osr >> (32 - bits)) & ((1 << bits) - 1)
+            self.osr = (self.osr << bits) & 0xFFFFFFFF
+        self.osr_count = min(32, self.osr_count + bits)
+        return value
+
+    def apply_sideset(self, field):
+        prog = self.prog
+        if prog.sideset_bits == 0:
+            return
+        if prog.sideset_opt:
+            if not field & 0x10:
+                return
+            value = (field >> (4 - prog.sideset_bits)) & ((1 << prog.sideset_bits) - 1)
+        else:
+            value = field >> (5 - prog.sideset_bits)
+        self.set_pins(self.sideset_base, prog.sideset_bits, value)
+
+    def advance(self):
+        self.pc = self.prog.wrap_target if self.pc == self.prog.wrap else self.pc + 1
+
+    def step(self):
+        """1サイクル実行"""
+        if self.delay > 0:
+            self.delay -= 1
+            return
+
+        instr = self.prog.instructions[self.pc]
+        op = instr >> 13
+        field = (instr >> 8) & 0x1F
+        delay = field & ((1 << self.prog.delay_bits()) - 1)
+        arg1 = (instr >> 5) & 0x7
+        arg2 = instr & 0x1F
+
+        # side-set は命令の開始時（ストール中も）に効く
+        self.apply_sideset(field)
+
+        jumped = False
+        if op == OP_JMP:
+            cond = arg1
+            take = {
+                0: True,
+                1: self.x == 0,
+                2: self.x != 0,
+                3: self.y == 0,
+                4: self.y != 0,
+                5: self.x != self.y,
+                7: self.osr_count < self.threshold,
+            }.get(cond)
+            if take is None:
+                raise ValueError('jmp pin is not supported')
+            if cond == 2:
+                self.x = (self.x - 1) & 0xFFFFFFFF
+            if cond == 4:
+                self.y = (self.y - 1) & 0xFFFFFFFF
+            if take:
+                self.pc = arg2
+                jumped = True
+        elif op == OP_OUT:
+            if self.autopull and self.osr_count >= self.threshold and not self.refill():
+                self.stalls += 1
+                return
+            value = self.shift_out(arg2)
+            if arg1 == 0:
+                self.set_pins(self.out_base, self.out_count, value)
+            elif arg1 == 1:
+                self.x = value
+            elif arg1 == 2:
+                self.y = value
+            elif arg1 == 3:
+                pass
+            elif arg1 == 5:
+                self.pc = value & 0x1F
+                jumped = True
+            else:
+                raise ValueError('unsupported out destination %d' % arg1)
+            # 空になったら FIFO から先に補充しておく（サイクルは消費しない）
+            if self.autopull and self.osr_count >= self.threshold:
+                self.refill()
+        elif op == OP_SET:
+            if arg1 == 0:
+                self.set_pins(self.set_base, self.set_count, arg2)
+            elif arg1 == 1:
+                self.x = arg2
+            elif arg1 == 2:
+                self.y = arg2
+            elif arg1 == 4:
+                pass
+            else:
+                raise ValueError('unsupported set destination %d' % arg1)
+        elif op == OP_MOV:
+            src = arg2 & 0x7
+            value = {0: self.pins >> self.out_base, 1: self.x, 2: self.y, 3: 0,
+                     6: self.isr, 7: self.osr}.get(src)
+            if value is None:
+                raise ValueError('unsupported mov source %d' % src)
+            mov_op = (instr >> 3) & 0x3
+            if mov_op == 1:
+                value = ~value & 0xFFFFFFFF
+            elif mov_op == 2:
+                value = int('{:032b}'.format(value & 0xFFFFFFFF)[::-1], 2)
+            if arg1 == 0:
+                self.set_pins(self.out_base, self.out_count, value)
+            elif arg1 == 1:
+                self.x = value
+            elif arg1 == 2:
+                self.y = value
+            elif arg1 == 7:
+                self.osr = value
+                self.osr_count = 0
+            elif arg1 == 6:
+                self.isr = value
+                self.isr_count = 0
+            else:
+                raise ValueError('unsupported mov destination %d' % arg1)
+        elif op == OP_PUSHPULL:
+            if instr & 0x80:
+                if not self.refill():
+                    if instr & 0x20:
+                        self.stalls += 1
+                        return
+                    self.osr = self.x
+                    self.osr_count = 0
+            else:
+                raise ValueError('push is not supported')
+        else:
+            raise ValueError('unsupported instruction 0x%04x' % instr)
+
+        if not jumped:
+            self.advance()
+        self.delay = delay
+
+
+# ============================================================================
+# テストパターンとパック（audio_block_pack_i2s / interleave_slot と同じ）
+# ============================================================================
+
+def test_pattern(frames, channels):
+    """ビットずれを見つけやすい値を並べたサンプル列（チャンネルごと）"""
+    edge = [0x0000, 0xFFFF, 0x8000, 0x7FFF, 0x0001, 0xFFFE, 0x5555, 0xAAAA]
+    walking = [1 << b for b in range(16)]
+    out = []
+    for ch in range(channels):
+        values = []
+        seed = 0x1234 + 0x1111 * ch
+        for i in range(frames):
+            if i < len(edge):
+                v = edge[(i + ch) % len(edge)]
+            elif i < len(edge) + 16:
+                v = walking[(i - len(edge) + 5 * ch) % 16]
+            else:
+                seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+                v = (seed >> 8) & 0xFFFF
+            values.append(v)
+        out.append(values)
+    return out
+
+
+def spread(v):
+    s = 0
+    for b in range(16):
+        if v & (1 << b):
+            s |= 1 << (2 * b)
+    return s
+
+
+def pack_words(samples, data_lines):
+    """FIFO に流すワード列（1本: 上位16ビット=左、2本: スロットごとにビットインターリーブ）"""
+    words = []
+    frames = len(samples[0])
+    for i in range(frames):
+        if data_lines == 1:
+            words.append((samples[0][i] << 16) | samples[1][i])
+        else:
+            # 左スロット: DATA_A = ペア0の左、DATA_B = ペア1の左
+            words.append(spread(samples[0][i]) | (spread(samples[2][i]) << 1))
+            words.append(spread(samples[1][i]) | (spread(samples[3][i]) << 1))
+    return words
+
+
+def unspread(w):
+    v = 0
+    for b in range(16):
+        if w & (1 << (2 * b)):
+            v |= 1 << b
+    return v
+
+
+def read_words(path):
+    """ワード列のファイル（16進、空白区切り、# 以降はコメント）"""
+    words = []
+    with open(path) as f:
+        for line in f:
+            words.extend(int(t, 16) for t in line.split('#')[0].split())
+    return words
+
+
+def unpack_words(words, data_lines):
+    """pack_words の逆: ワード列からチャンネルごとのサンプル列に戻す"""
+    if data_lines == 1:
+        return [[w >> 16 for w in words], [w & 0xFFFF for w in words]]
+    samples = [[] for _ in range(4)]
+    for i in range(0, len(words) - 1, 2):
+        left, right = words[i], words[i + 1]
+        samples[0].append(unspread(left))
+        samples[1].append(unspread(right))
+        samples[2].append(unspread(left >> 1))
+        samples[3].append(unspread(right >> 1))
+    return samples
+
+
+# ============================================================================
+# 受信側モデルと検証
+# ============================================================================
+
+def run(prog, entry, words, data_lines, cycles):
+    """エミュレートしてピンの値をサイクルごとに記録"""
+    bclk_pin = 8
+    lrclk_pin = 9
+    sm = StateMachine(prog, out_base=0, out_count=data_lines, set_base=0, set_count=data_lines,
+                      sideset_base=bclk_pin, pc=entry)
+    sm.fifo = list(words)
+    trace = []
+    for _ in range(cycles):
+        sm.step()
+        trace.append(sm.pins)
+        if not sm.fifo and sm.osr_count >= 32:
+            break
+    return trace, sm
+
+
+def bit(v, n):
+    return (v >> n) & 1
+
+
+def analyse(trace, data_lines, fmt, bits_per_slot, skip_frames):
+    """波形から BCLK / LRCLK のタイミングとワードを取り出す"""
+    bclk = [bit(v, 8) for v in trace]
+    lrclk = [bit(v, 9) for v in trace]
+    data = [[bit(v, d) for v in trace] for d in range(data_lines)]
+
+    rising = [i for i in range(1, len(trace)) if bclk[i] and not bclk[i - 1]]
+    falling = [i for i in range(1, len(trace)) if not bclk[i] and bclk[i - 1]]
+    lr_edges = [i for i in range(1, len(trace)) if lrclk[i] != lrclk[i - 1]]
+
+    # BCLK の High / Low の長さ（最初と最後の不完全な区間を除く）
+    highs = [f - r for r, f in zip(rising, [f for f in falling if f > rising[0]])]
+    lows = [r - f for f, r in zip(falling, [r for r in rising if r > falling[0]])]
+
+    # フレーム = LRCLK の立ち下がりから次の立ち下がり（左スロットの始まり）
+    lr_fall = [i for i in lr_edges if lrclk[i] == 0]
+    frame_cycles = [b - a for a, b in zip(lr_fall, lr_fall[1:])]
+    frame_bclks = [sum(1 for r in rising if a <= r < b) for a, b in zip(lr_fall, lr_fall[1:])]
+    lr_high = [sum(lrclk[a:b]) for a, b in zip(lr_fall, lr_fall[1:])]
+
+    # LRCLK が変わるのは BCLK の立ち下がりと同じサイクルか（I2S / 左詰めの送信側の規則）
+    misaligned = [i for i in lr_edges if i not in set(falling)]
+
+    # 受信側: BCLK の立ち上がりで LRCLK と DATA を読む
+    samples = [(lrclk[r], [data[d][r] for d in range(data_lines)]) for r in rising]
+    delay = 1 if fmt == 'i2s' else 0
+    slots = []
+    for k in range(1, len(samples)):
+        if samples[k][0] != samples[k - 1][0]:
+            start = k + delay
+            if start + bits_per_slot > len(samples):
+                break
+            words = []
+            for d in range(data_lines):
+                w = 0
+                for b in range(bits_per_slot):
+                    w = (w << 1) | samples[start + b][1][d]
+                words.append(w)
+            slots.append((samples[k][0], words))
+
+    return {
+        'highs': highs, 'lows': lows,
+        'frame_cycles': frame_cycles[skip_frames:],
+        'frame_bclks': frame_bclks[skip_frames:],
+        'lr_high': lr_high[skip_frames:],
+        'misaligned': misaligned,
+        'slots': slots,
+    }
+
+
+def decode_channels(slots, data_lines):
+    """スロット列を左/右（データ線ごと）のサンプル列に並べる（最初の左スロットから）"""
+    while slots and slots[0][0] != 0:
+        slots = slots[1:]
+    channels = [[] for _ in range(2 * data_lines)]
+    for i in range(0, len(slots) - 1, 2):
+        (lr_l, left), (lr_r, right) = slots[i], slots[i + 1]
+        if lr_l != 0 or lr_r != 1:
+            break
+        for d in range(data_lines):
+            channels[2 * d].append(left[d])
+            channels[2 * d + 1].append(right[d])
+    return channels
+
+
+def ascii_waveform(trace, data_lines, cycles):
+    """先頭のサイクルを文字で表示"""
+    rows = [('BCLK ', 8), ('LRCLK', 9)] + [('DATA%d' % d, d) for d in range(data_lines)]
+    out = []
+    for label, pin in rows:
+        out.append('%-6s %s' % (label, ''.join('‾' if bit(v, pin) else '_' for v in trace[:cycles])))
+    return '\n'.join(out)
+
+
+def write_vcd(path, trace, data_lines, pio_hz):
+    """ピン波形を VCD に出力（1サイクル = PIO クロックの1周期）"""
+    signals = [('bclk', 8, '!'), ('lrclk', 9, '"')] + \
+              [('data%d' % d, d, chr(ord('#') + d)) for d in range(data_lines)]
+    period_ps = int(round(1e12 / pio_hz))
+    with open(path, 'w') as f:
+        f.write('$timescale 1ps $end\n$scope module i2s $end\n')
+        for name, _, code in signals:
+            f.write('$var wire 1 %s %s $end\n' % (code, name))
+        f.write('$upscope $end\n$enddefinitions $end\n')
+        last = None
+        for t, v in enumerate(trace):
+            changes = [(code, bit(v, pin)) for name, pin, code in signals
+                       if last is None or bit(v, pin) != bit(last, pin)]
+            if changes:
+                f.write('#%d\n' % (t * period_ps))
+                for code, b in changes:
+                    f.write('%d%s\n' % (b, code))
+            last = v
+        f.write('#%d\n' % (len(trace) * period_ps))
+
+
+def config_value(name):
+    """src/config.h の #define の値（数値のみ）"""
+    with open(os.path.join(ROOT, 'src', 'config.h')) as f:
+        m = re.search(r'#define\s+%s\s+(\d+)' % name, f.read())
+    return int(m.group(1)) if m else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Emulate the I2S PIO program and check its timing')
+    parser.add_argument('--pio', default=os.path.join(ROOT, 'src', 'i2s.pio'), help='.pio source to assemble')
+    parser.add_argument('--header', help='load the pioasm-generated header instead of assembling')
+    parser.add_argument('--program', default='i2s_output', help='program name')
+    parser.add_argument('--entry', default='entry_point',
+                        help='public label to start from (start of the program if missing)')
+    parser.add_argument('--data-lines', type=int, default=1, help='number of DATA pins (out pins, N)')
+    parser.add_argument('--format', choices=['i2s', 'lj'], default='i2s',
+                        help='DAC format: i2s (MSB one BCLK after LRCLK, PCM5102A FMT=GND) or lj (left-justified)')
+    parser.add_argument('--frames', type=int, default=64, help='stereo frames to stream')
+    parser.add_argument('--bits', type=int, default=16, help='bits per slot')
+    parser.add_argument('--cycles-per-frame', type=int, default=config_value('PIO_CYCLES_PER_STEREO_SAMPLE'),
+                        help='expected PIO cycles per stereo frame (default: config.h)')
+    parser.add_argument('--bclk-high', type=int, default=1, help='expected BCLK high time (cycles)')
+    parser.add_argument('--bclk-low', type=int, default=1, help='expected BCLK low time (cycles)')
+    parser.add_argument('--sample-rate', type=int, default=44100, help='sample rate for the VCD time base')
+    parser.add_argument('--vcd', help='write pin waveforms to this VCD file')
+    parser.add_argument('--show', type=int, default=2, help='frames to print as ASCII waveform')
+    parser.add_argument('--words', help='stream DMA words from this file instead of the test pattern')
+    parser.add_argument('--tagged', action='store_true',
+                        help='samples carry (frame index << 2 | channel): check every frame is aligned')
+    args = parser.parse_args()
+
+    if args.header:
+        prog = load_header(args.header, args.program)
+    else:
+        prog = assemble(args.pio, args.program)
+    entry = prog.public.get(args.entry, 0)
+
+    print('%s: %d instructions, side-set %d%s, wrap %d..%d, entry %d' %
+          (prog.name, len(prog.instructions), prog.sideset_bits, ' opt' if prog.sideset_opt else '',
+           prog.wrap_target, prog.wrap, entry))
+    print('  ' + ' '.join('%04x' % i for i in prog.instructions))
+
+    channels = 2 * args.data_lines
+    if args.words:
+        words = read_words(args.words)
+        samples = unpack_words(words, args.data_lines)
+        args.frames = len(samples[0])
+        print('%s: %d words, %d frames' % (args.words, len(words), args.frames))
+    else:
+        samples = test_pattern(args.frames, channels)
+        words = pack_words(samples, args.data_lines)
+    cpf = args.cycles_per_frame or 64
+    trace, sm = run(prog, entry, words, args.data_lines, cycles=cpf * (args.frames + 4))
+
+    if args.show:
+        print(ascii_waveform(trace, args.data_lines, cpf * args.show + 4))
+    if args.vcd:
+        write_vcd(args.vcd, trace, args.data_lines, args.sample_rate * cpf)
+        print('wrote %s' % args.vcd)
+
+    result = analyse(trace, args.data_lines, args.format, args.bits, skip_frames=1)
+    decoded = decode_channels(result['slots'], args.data_lines)
+
+    failures = []
+
+    def check(ok, text):
+        print('  [%s] %s' % ('OK' if ok else 'FAIL', text))
+        if not ok:
+            failures.append(text)
+
+    fc = sorted(set(result['frame_cycles']))
+    fb = sorted(set(result['frame_bclks']))
+    hi = sorted(set(result['highs']))
+    lo = sorted(set(result['lows']))
+    lh = sorted(set(result['lr_high']))
+    print('checks (%s format, %d frames):' % (args.format, args.frames))
+    check(fc == [args.cycles_per_frame], 'cycles per frame %s (expected %s)' % (fc, args.cycles_per_frame))
+    check(fb == [2 * args.bits], 'BCLK per frame %s (expected %d)' % (fb, 2 * args.bits))
+    check(hi == [args.bclk_high] and lo == [args.bclk_low],
+          'BCLK high %s / low %s cycles (expected %d / %d)' % (hi, lo, args.bclk_high, args.bclk_low))
+    check(len(lh) == 1 and lh[0] * 2 == fc[0] if fc else False,
+          'LRCLK high %s of %s cycles (expected 50%%)' % (lh, fc))
+    check(not result['misaligned'], 'LRCLK changes on BCLK falling edges (%d misaligned)' % len(result['misaligned']))
+    check(sm.stalls == 0 or not sm.fifo, 'no autopull stall while the FIFO has data (%d stalls)' % sm.stalls)
+
+    # 最初のフレームは起動時の半端なので、復元できたフレームの並びを元のサンプル列の中で探す
+    n = len(decoded[0])
+    match = False
+    offset = None
+    for off in range(0, 3):
+        if n >= 8 and all(decoded[c][:n] == samples[c][off:off + n] for c in range(channels)):
+            match, offset = True, off
+            break
+    check(match and n >= args.frames - 4,
+          'decoded %d frames match the DMA stream%s' % (n, '' if offset is None else ' (from frame %d)' % offset))
+    if not match and n:
+        for c in range(channels):
+            print('    ch%d sent %s' % (c, ' '.join('%04x' % v for v in samples[c][:6])))
+            print('    ch%d got  %s' % (c, ' '.join('%04x' % v for v in decoded[c][:6])))
+
+    if args.tagged:
+        # 全チャンネルが無音か、同じ通し番号で下位2ビットがチャンネル番号
+        misaligned = 0
+        for i in range(n):
+            frame = [decoded[c][i] for c in range(channels)]
+            if not any(frame):
+                continue
+            if any(v & 3 != c or v >> 2 != frame[0] >> 2 for c, v in enumerate(frame)):
+                misaligned += 1
+        check(n > 0 and misaligned == 0,
+              'all %d channels of each frame carry the same frame index (%d misaligned)' % (channels, misaligned))
+
+    if failures:
+        print('FAILED: %d check(s)' % len(failures))
+        sys.exit(1)
+    print('OK')
+
+
+if __name__ == '__main__':
+    main()
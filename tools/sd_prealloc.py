@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+SD カード録音用のファイル（RECnn.WAV）を事前に確保する。
+
+- マウントした FAT32 のカードのルートに、指定した長さ分のファイルを 0 で埋めて作る
+  （ファームウェアは FAT を書き換えずにこの範囲へ直接書くので、あらかじめ領域が要る）
+- 先頭 512 バイトは WAV ヘッダー（データ長 0 = 未使用）、PCM データは 512 バイト目から
+  （src/recorder.c の build_wav_header と同じ形、JUNK チャンクで埋める）
+- ファームウェアはクラスタが連続したファイルだけを使う。フォーマット直後の
+  カードに作れば連続になる（断片化したファイルは起動時のログに出る）
+- --reset で録音済みのファイルのヘッダーを未使用に戻す（領域はそのまま再利用する）
+
+録音したファイルはそのまま WAV として読める（ヘッダーのデータ長より後ろは無視される）。
+
+使い方:
+    python3 tools/sd_prealloc.py /media/SDCARD --files 8 --minutes 90
+    python3 tools/sd_prealloc.py /media/SDCARD --reset
+"""
+
+import argparse
+import glob
+import os
+import struct
+import sys
+
+BLOCK_SIZE = 512
+JUNK_BYTES = 460
+CHUNK_BYTES = 1024 * 1024
+FAT32_MAX_FILE = 0xFFFFFFFF
+
+
+def wav_header(sample_rate, pcm_bytes=0):
+    """録音ファイルのヘッダー（1ブロック）"""
+    header = b'RIFF' + struct.pack('<I', BLOCK_SIZE - 8 + pcm_bytes) + b'WAVE'
+    header += b'fmt ' + struct.pack('<IHHIIHH', 16, 1, 2, sample_rate, sample_rate * 4, 4, 16)
+    header += b'JUNK' + struct.pack('<I', JUNK_BYTES) + bytes(JUNK_BYTES)
+    header += b'data' + struct.pack('<I', pcm_bytes)
+    assert len(header) == BLOCK_SIZE
+    return header
+
+
+def create(path, size, sample_rate):
+    """ヘッダー + 0 で size バイトのファイルを作る"""
+    with open(path, 'wb') as f:
+        f.write(wav_header(sample_rate))
+        remaining = size - BLOCK_SIZE
+        zeros = bytes(CHUNK_BYTES)
+        while remaining > 0:
+            n = min(remaining, CHUNK_BYTES)
+            f.write(zeros[:n])
+            remaining -= n
+        f.flush()
+        os.fsync(f.fileno())
+
+
+def reset(path, sample_rate):
+    """ヘッダーだけを未使用に戻す（ファイルの領域は変えない）"""
+    with open(path, 'r+b') as f:
+        f.write(wav_header(sample_rate))
+        f.flush()
+        os.fsync(f.fileno())
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Preallocate contiguous recording files on an SD card')
+    parser.add_argument('card', help='mount point of the FAT32 card')
+    parser.add_argument('--files', type=int, default=4, help='number of files (RECnn.WAV)')
+    parser.add_argument('--minutes', type=float, default=60.0, help='length of each file (minutes)')
+    parser.add_argument('--rate', type=int, default=44100, help='sample rate (AUDIO_SAMPLE_RATE)')
+    parser.add_argument('--prefix', default='REC', help='file name prefix (RECORDER_FILE_PREFIX)')
+    parser.add_argument('--reset', action='store_true', help='mark existing files as unused')
+    args = parser.parse_args()
+
+    if args.reset:
+        paths = sorted(glob.glob(os.path.join(args.card, args.prefix + '*.WAV')))
+        if not paths:
+            sys.exit('no %s*.WAV files in %s' % (args.prefix, args.card))
+        for path in paths:
+            reset(path, args.rate)
+            print('%s: reset' % path)
+        return
+
+    if len(args.prefix) + 2 > 8:
+        sys.exit('prefix too long for an 8.3 name')
+
+    pcm_bytes = int(args.minutes * 60 * args.rate) * 4
+    size = (BLOCK_SIZE + pcm_bytes + BLOCK_SIZE - 1) // BLOCK_SIZE * BLOCK_SIZE
+    if size > FAT32_MAX_FILE:
+        sys.exit('%.1f minutes exceeds the FAT32 file size limit' % args.minutes)
+
+    for i in range(args.files):
+        path = os.path.join(args.card, '%s%02d.WAV' % (args.prefix, i))
+        if os.path.exists(path):
+            print('%s: exists, skipped (use --reset to reuse it)' % path)
+            continue
+        create(path, size, args.rate)
+        print('%s: %d MB (%.1f min)' % (path, size // (1024 * 1024), args.minutes))
+
+
+if __name__ == '__main__':
+    main()
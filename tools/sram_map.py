@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+リンカーマップ（build/pico2w_bt_a2dp_receiver.elf.map）から SRAM のバンクごとの配置を表示する。
+
+- RP2350 の SRAM を src/sram_layout.h と同じ4つの領域に分ける
+  （SRAM0-3 / SRAM4-7 はストライプ、scratch X / scratch Y はストライプなし 4KB）
+- 領域ごとの使用量と、大きい順の配置（入力セクション単位）を出す
+- -fdata-sections で static 変数も .bss.<名前> になるので、名前はセクション名から取る
+  （scratch に置いたものは .scratch_x.<グループ名> になる）
+- 主なバッファ（I2S の DMA ピンポン・リング、スライスバッファ、スタック）がどこにあるかを出す
+- --expect NAME=REGION で配置を確認し、違えば終了コード 1（CI やビルド後の確認用）
+
+使い方:
+    python3 tools/sram_map.py build/pico2w_bt_a2dp_receiver.elf.map
+    python3 tools/sram_map.py --expect i2s_dma=scratch_x --expect i2s_state=scratch_y build/*.elf.map
+"""
+
+import argparse
+import re
+import sys
+
+# (id, 表示名, 先頭, 終端) - src/sram_layout.h と同じ境界
+REGIONS = [
+    ('sram0-3', 'SRAM0-3', 0x20000000, 0x20040000),
+    ('sram4-7', 'SRAM4-7', 0x20040000, 0x20080000),
+    ('scratch_x', 'scratch X', 0x20080000, 0x20081000),
+    ('scratch_y', 'scratch Y', 0x20081000, 0x20082000),
+]
+
+# 表示する主なバッファ（入力セクション名の末尾）
+HOT_BUFFERS = [
+    ('i2s_dma', 'I2S DMA ping-pong (SRAM_PLACEMENT_ENABLED)'),
+    ('dma_buffer', 'I2S DMA ping-pong (default placement)'),
+    ('i2s_state', 'I2S DMA IRQ state'),
+    ('ring_buffer', 'I2S ring'),
+    ('slice_buffer_l', 'Beat-Repeat slice L'),
+    ('slice_buffer_r', 'Beat-Repeat slice R'),
+    ('stack', 'core0 stack'),
+    ('stack1', 'core1 stack'),
+]
+
+RE_OUTPUT = re.compile(r'^(\.\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)')
+RE_INPUT_FULL = re.compile(r'^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(\S*)')
+RE_INPUT_NAME = re.compile(r'^ (\S+)\s*$')
+RE_INPUT_ADDR = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(\S*)')
+RE_SYMBOL = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_]\w*)\s*$')
+
+# 名前がセクション名から分からない入力セクション（中のシンボル名を使う）
+GENERIC_SECTIONS = {'.bss', '.data', 'COMMON', '.scratch_x', '.scratch_y'}
+
+
+def region_of(addr):
+    for rid, _, start, end in REGIONS:
+        if start <= addr < end:
+            return rid
+    return None
+
+
+def short_name(section):
+    """入力セクション名から変数名（またはグループ名）を取り出す"""
+    for prefix in ('.bss.', '.data.', '.scratch_x.', '.scratch_y.', '.time_critical.'):
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    return section.lstrip('.')
+
+
+def object_name(path):
+    """オブジェクトファイルのパスを短くする（src/foo.c.obj → foo.c）"""
+    path = path.split('/')[-1]
+    return path[:-4] if path.endswith('.obj') else path
+
+
+def parse_map(lines):
+    """マップの「Linker script and memory map」以降から SRAM 上の入力セクションを取り出す"""
+    entries = []
+    in_map = False
+    output = None
+    pending = None      # 名前だけの行（アドレスは次の行）
+    last = None         # 直前の入力セクション（中のシンボル名で名前を補う）
+
+    def add(section, addr, size, obj):
+        if size == 0 or region_of(addr) is None or section.startswith('*'):
+            return None
+        e = {'section': section, 'name': short_name(section), 'addr': addr, 'size': size,
+             'obj': object_name(obj), 'output': output}
+        entries.append(e)
+        return e
+
+    for line in lines:
+        line = line.rstrip('\n')
+        if not in_map:
+            in_map = line.startswith('Linker script and memory map')
+            continue
+
+        m = RE_OUTPUT.match(line)
+        if m:
+            output = m.group(1)
+            pending = last = None
+            continue
+        if line.startswith('.') and ' ' not in line.strip():
+            output = line.strip()   # 出力セクション名だけの行
+            pending = last = None
+            continue
+
+        if pending is not None:
+            m = RE_INPUT_ADDR.match(line)
+            if m:
+                last = add(pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3))
+                pending = None
+                continue
+            pending = None
+
+        m = RE_INPUT_FULL.match(line)
+        if m:
+            last = add(m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4))
+            continue
+        m = RE_INPUT_NAME.match(line)
+        if m:
+            pending = m.group(1)
+            continue
+
+        m = RE_SYMBOL.match(line)
+        if m and last is not None and last['section'] in GENERIC_SECTIONS:
+            if last['name'] == last['section'].lstrip('.'):
+                last['name'] = m.group(2)
+
+    return entries
+
+
+def usage_by_region(entries):
+    """領域ごとの使用バイト数（境界をまたぐものは分けて数える）"""
+    used = {rid: 0 for rid, _, _, _ in REGIONS}
+    for e in entries:
+        start, end = e['addr'], e['addr'] + e['size']
+        for rid, _, rstart, rend in REGIONS:
+            overlap = min(end, rend) - max(start, rstart)
+            if overlap > 0:
+                used[rid] += overlap
+    return used
+
+
+def regions_spanned(e):
+    """エントリがかかる領域の id のリスト"""
+    start, end = e['addr'], e['addr'] + e['size']
+    return [rid for rid, _, rstart, rend in REGIONS if start < rend and end > rstart]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Report SRAM bank placement from a linker map')
+    parser.add_argument('map', help='linker map file (*.elf.map)')
+    parser.add_argument('--top', type=int, default=8, help='largest entries to list per region')
+    parser.add_argument('--expect', action='append', default=[], metavar='NAME=REGION',
+                        help='fail unless NAME is entirely in REGION (%s)' %
+                        ', '.join(r[0] for r in REGIONS))
+    args = parser.parse_args()
+
+    with open(args.map, 'r', errors='replace') as f:
+        entries = parse_map(f)
+    if not entries:
+        sys.exit('no SRAM sections found (is this a GNU ld map of the firmware?)')
+
+    used = usage_by_region(entries)
+    labels = {rid: label for rid, label, _, _ in REGIONS}
+
+    print('%-10s %-23s %8s %8s %6s' % ('Region', 'Range', 'Used', 'Size', 'Use'))
+    for rid, label, start, end in REGIONS:
+        size = end - start
+        print('%-10s 0x%08x-0x%08x %8d %8d %5.1f%%' %
+              (label, start, end - 1, used[rid], size, 100.0 * used[rid] / size))
+
+    for rid, label, _, _ in REGIONS:
+        inside = [e for e in entries if rid in regions_spanned(e)]
+        if not inside:
+            continue
+        inside.sort(key=lambda e: -e['size'])
+        print('\n%s (%d sections):' % (label, len(inside)))
+        for e in inside[:args.top]:
+            print('  0x%08x %8d  %-28s %-10s %s' %
+                  (e['addr'], e['size'], e['name'], e['output'] or '', e['obj']))
+
+    print('\nHot buffers:')
+    by_name = {}
+    for e in entries:
+        by_name.setdefault(e['name'], []).append(e)
+    for name, desc in HOT_BUFFERS:
+        for e in by_name.get(name, []):
+            where = ' + '.join(labels[r] for r in regions_spanned(e))
+            print('  %-14s 0x%08x %8d  %-10s  %s' % (name, e['addr'], e['size'], where, desc))
+
+    failed = False
+    for spec in args.expect:
+        name, _, region = spec.partition('=')
+        if region not in labels:
+            sys.exit('unknown region %r in --expect %s' % (region, spec))
+        found = by_name.get(name, [])
+        if not found:
+            print('FAIL: %s not found in the map' % name, file=sys.stderr)
+            failed = True
+            continue
+        for e in found:
+            spanned = regions_spanned(e)
+            if spanned != [region]:
+                print('FAIL: %s is in %s, expected %s' %
+                      (name, ' + '.join(labels[r] for r in spanned), labels[region]),
+                      file=sys.stderr)
+                failed = True
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""
+シリアルログのトレースダンプ（src/trace.h）を Chrome / Perfetto のトレース JSON に変換する。
+
+- ログ中の [TRACE] begin 〜 [TRACE] end を1つのダンプとして読む（既定は最後のダンプ）
+- イベント名はダンプに含まれる表を使う（ファームウェアと表を二重に持たない）
+- タイムスタンプ（32ビット us）はダンプ時刻からさかのぼって戻し、最古のイベントを 0 にする
+- コアごとにメインループと割り込み（IRQ フラグ）を別トラックにする
+- 開始が上書きで消えた終了イベントは捨てる
+- --port を指定すると制御プロトコルで TRACE_DUMP を送り、ダンプを受信して変換する
+  （pyserial が必要）
+
+出力は chrome://tracing または https://ui.perfetto.dev で開く。
+
+使い方:
+    python3 tools/trace2json.py -o trace.json serial.log
+    python3 tools/trace2json.py -o trace.json --port /dev/ttyACM0
+    python3 tools/trace2json.py -o trace.json --check trace_scenario.log
+
+--check はログ中の "# expect <名前> <フェーズ> <ts> <irq> <arg>" 行と "# expect-lost <数>" 行
+（test/test_trace が書く）を、書き出した JSON を読み直したイベントと突き合わせる。
+不一致があれば終了コード 1（CI 用）。
+"""
+
+import argparse
+import json
+import re
+import sys
+
+PHASES = {0: 'B', 1: 'E', 2: 'i', 3: 'C'}
+FLAG_IRQ = 0x80
+
+CONTROL_MSG_TRACE_DUMP = 0x08
+
+RE_BEGIN = re.compile(r'\[TRACE\] begin now=([0-9a-fA-F]+) cores=(\d+)')
+RE_EVENT = re.compile(r'\[TRACE\] event (\d+) (\S+)')
+RE_CORE = re.compile(r'\[TRACE\] core (\d+) events (\d+) lost (\d+)')
+RE_RECORD = re.compile(r'\[TR\] (\d+) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{2}) ([0-9a-fA-F]{2}) ([0-9a-fA-F]{4})')
+RE_END = re.compile(r'\[TRACE\] end')
+RE_EXPECT = re.compile(r'^# expect (\S+) ([BEiC]) (\d+) ([01]) (\d+)')
+RE_EXPECT_LOST = re.compile(r'^# expect-lost (\d+)')
+
+
+def parse_dumps(lines):
+    """ログからダンプを順に取り出す（途中で切れたダンプは捨てる）"""
+    dumps = []
+    current = None
+    for line in lines:
+        # 制御プロトコルのバイナリフレームが同じ行に混ざることがあるので search で探す
+        m = RE_BEGIN.search(line)
+        if m:
+            current = {'now': int(m.group(1), 16), 'cores': int(m.group(2)),
+                       'names': {}, 'lost': {}, 'records': []}
+            continue
+        if current is None:
+            continue
+        m = RE_RECORD.search(line)
+        if m:
+            current['records'].append((int(m.group(1)), int(m.group(2), 16), int(m.group(3), 16),
+                                       int(m.group(4), 16), int(m.group(5), 16)))
+            continue
+        m = RE_EVENT.search(line)
+        if m:
+            current['names'][int(m.group(1))] = m.group(2)
+            continue
+        m = RE_CORE.search(line)
+        if m:
+            current['lost'][int(m.group(1))] = int(m.group(3))
+            continue
+        if RE_END.search(line):
+            dumps.append(current)
+            current = None
+    return dumps
+
+
+def to_chrome(dump):
+    """ダンプを Chrome トレースのイベント列に変換"""
+    now = dump['now']
+    events = []
+    tids = set()
+
+    # ダンプ時刻からの経過で並べる（32ビットの折り返しを戻す）
+    records = []
+    for seq, (core, ts, event, flags, arg) in enumerate(dump['records']):
+        age = (now - ts) & 0xFFFFFFFF
+        records.append((-age, seq, core, event, flags, arg))
+    records.sort()
+    origin = records[0][0] if records else 0
+
+    open_slices = {}
+    for t, _, core, event, flags, arg in records:
+        name = dump['names'].get(event, 'event%d' % event)
+        ph = PHASES[flags & 0x03]
+        irq = bool(flags & FLAG_IRQ)
+        tid = core * 2 + (1 if irq else 0)
+        ts = t - origin
+
+        if ph == 'C':
+            events.append({'name': name, 'ph': 'C', 'ts': ts, 'pid': 0, 'args': {'frames': arg}})
+            continue
+
+        key = (tid, name)
+        if ph == 'B':
+            open_slices[key] = open_slices.get(key, 0) + 1
+        elif ph == 'E':
+            if open_slices.get(key, 0) == 0:
+                continue  # 開始イベントは上書きで消えた
+            open_slices[key] -= 1
+
+        e = {'name': name, 'ph': ph, 'ts': ts, 'pid': 0, 'tid': tid, 'args': {'arg': arg}}
+        if ph == 'i':
+            e['s'] = 't'
+        events.append(e)
+        tids.add(tid)
+
+    meta = [{'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'Pico 2W audio'}}]
+    for tid in sorted(tids):
+        label = 'core%d %s' % (tid // 2, 'IRQ' if tid % 2 else 'main')
+        meta.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': tid, 'args': {'name': label}})
+        meta.append({'name': 'thread_sort_index', 'ph': 'M', 'pid': 0, 'tid': tid,
+                     'args': {'sort_index': tid}})
+
+    span = (records[-1][0] - origin) if records else 0
+    return meta + events, span
+
+
+def check_expected(lines, path, lost):
+    """書き出した JSON を読み直し、ログの期待値と比べる（不一致の数を返す）"""
+    expected = []
+    expected_lost = None
+    for line in lines:
+        m = RE_EXPECT.match(line)
+        if m:
+            expected.append((m.group(1), m.group(2), int(m.group(3)), int(m.group(4)), int(m.group(5))))
+            continue
+        m = RE_EXPECT_LOST.match(line)
+        if m:
+            expected_lost = int(m.group(1))
+
+    with open(path) as f:
+        events = [e for e in json.load(f)['traceEvents'] if e['ph'] != 'M']
+
+    actual = []
+    for e in events:
+        if e['ph'] == 'C':
+            # カウンターはトラックを持たない（IRQ かどうかは比べない）
+            actual.append((e['name'], 'C', e['ts'], None, e['args']['frames']))
+        else:
+            actual.append((e['name'], e['ph'], e['ts'], e['tid'] % 2, e['args']['arg']))
+
+    errors = 0
+    if not expected:
+        print('check: no "# expect" lines in the log', file=sys.stderr)
+        errors += 1
+    if len(actual) != len(expected):
+        print('check: %d events, expected %d' % (len(actual), len(expected)), file=sys.stderr)
+        errors += 1
+    for i, (a, x) in enumerate(zip(actual, expected)):
+        if a[3] is None:
+            x = x[:3] + (None,) + x[4:]
+        if a != x:
+            if errors < 10:
+                print('check: event %d is %s, expected %s' % (i, a, x), file=sys.stderr)
+            errors += 1
+    if expected_lost is not None and lost != expected_lost:
+        print('check: %d lost, expected %d' % (lost, expected_lost), file=sys.stderr)
+        errors += 1
+
+    print('check: %d events compared, %d mismatches' % (len(expected), errors), file=sys.stderr)
+    return errors
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE（src/control_frame.c と同じ）"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(msg):
+    """メッセージを制御プロトコルのフレーム（0x00 | COBS(msg | CRC) | 0x00）にする"""
+    crc = crc16(msg)
+    data = bytes(msg) + bytes([crc & 0xFF, crc >> 8])
+    out = bytearray([0])
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block = bytearray()
+        else:
+            block.append(b)
+            if len(block) == 254:
+                out.append(255)
+                out += block
+                block = bytearray()
+    out.append(len(block) + 1)
+    out += block
+    out.append(0)
+    return bytes(out)
+
+
+def capture_from_port(port, timeout):
+    """TRACE_DUMP を送ってダンプの終わりまで受信し、行のリストを返す"""
+    try:
+        import serial
+    except ImportError:
+        sys.exit('pyserial is required for --port (pip install pyserial)')
+
+    lines = []
+    with serial.Serial(port, 115200, timeout=timeout) as s:
+        s.reset_input_buffer()
+        s.write(encode_frame([CONTROL_MSG_TRACE_DUMP, 0]))
+        seen_begin = False
+        while True:
+            raw = s.readline()
+            if not raw:
+                sys.exit('timeout while waiting for the trace dump')
+            line = raw.decode('utf-8', errors='replace')
+            lines.append(line)
+            if RE_BEGIN.search(line):
+                seen_begin = True
+            if seen_begin and RE_END.search(line):
+                return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert a trace dump to Chrome trace JSON')
+    parser.add_argument('log', nargs='?', help='serial log file (- for stdin)')
+    parser.add_argument('-o', '--output', default='trace.json', help='output JSON file')
+    parser.add_argument('--dump', type=int, default=-1, help='dump index in the log (default: last)')
+    parser.add_argument('--port', help='request a dump over the control protocol on this serial port')
+    parser.add_argument('--timeout', type=float, default=5.0, help='serial read timeout (s)')
+    parser.add_argument('--check', action='store_true',
+                        help='compare the written JSON with the "# expect" lines in the log')
+    args = parser.parse_args()
+
+    if args.port:
+        lines = capture_from_port(args.port, args.timeout)
+    elif args.log == '-' or args.log is None:
+        lines = sys.stdin.buffer.read().decode('utf-8', errors='replace').splitlines()
+    else:
+        with open(args.log, 'rb') as f:
+            lines = f.read().decode('utf-8', errors='replace').splitlines()
+
+    dumps = parse_dumps(lines)
+    if not dumps:
+        sys.exit('no complete trace dump found')
+    try:
+        dump = dumps[args.dump]
+    except IndexError:
+        sys.exit('dump %d not found (%d dumps in log)' % (args.dump, len(dumps)))
+
+    events, span = to_chrome(dump)
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
+
+    counts = {}
+    for _, _, event, _, _ in dump['records']:
+        name = dump['names'].get(event, 'event%d' % event)
+        counts[name] = counts.get(name, 0) + 1
+    lost = sum(dump['lost'].values())
+    print('%s: %d events over %.1f ms (%d overwritten before the window)' %
+          (args.output, len(dump['records']), span / 1000.0, lost), file=sys.stderr)
+    for name in sorted(counts):
+        print('  %-14s %6d' % (name, counts[name]), file=sys.stderr)
+
+    if args.check and check_expected(lines, args.output, lost) > 0:
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
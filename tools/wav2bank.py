@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""
+samples/*.wav からサンプルバンク（sample_bank_data.c）を生成する。
+
+- モノラルに変換（複数チャンネルは平均）
+- AUDIO_SAMPLE_RATE に線形補間でリサンプル
+- 既定で IMA-ADPCM（4ビット、下位ニブルが先）にエンコード（src/adpcm.h と同じ計算）
+- データは 4 バイト境界・4 の倍数のバイト数にそろえる（DMA の 32 ビット転送のため）
+
+WAV がなければ空のバンク（sample_bank_count = 0）を生成する。
+
+使い方:
+    python3 tools/wav2bank.py -o build/sample_bank_data.c samples/kick.wav samples/siren.wav
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+import wave
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def read_wav_mono(path):
+    """WAV を読み込み、モノラルの int サンプル列とサンプリングレートを返す"""
+    with wave.open(path, 'rb') as w:
+        channels = w.getnchannels()
+        width = w.getsampwidth()
+        rate = w.getframerate()
+        raw = w.readframes(w.getnframes())
+
+    if width == 1:
+        values = [b - 128 << 8 for b in raw]
+    elif width == 2:
+        values = list(struct.unpack('<%dh' % (len(raw) // 2), raw))
+    elif width == 3:
+        values = [int.from_bytes(raw[i:i + 3], 'little', signed=True) >> 8
+                  for i in range(0, len(raw), 3)]
+    elif width == 4:
+        values = [v >> 16 for v in struct.unpack('<%di' % (len(raw) // 4), raw)]
+    else:
+        raise ValueError('%s: unsupported sample width %d' % (path, width))
+
+    mono = [sum(values[i:i + channels]) // channels
+            for i in range(0, len(values), channels)]
+    return mono, rate
+
+
+def resample(samples, src_rate, dst_rate):
+    """線形補間でリサンプル"""
+    if src_rate == dst_rate or not samples:
+        return samples
+    out_len = int(len(samples) * dst_rate / src_rate)
+    step = src_rate / dst_rate
+    out = []
+    for i in range(out_len):
+        pos = i * step
+        idx = int(pos)
+        frac = pos - idx
+        a = samples[idx]
+        b = samples[idx + 1] if idx + 1 < len(samples) else a
+        out.append(int(round(a + (b - a) * frac)))
+    return out
+
+
+def adpcm_encode(samples):
+    """IMA-ADPCM エンコード（予測値 0 / ステップ位置 0 から開始）"""
+    predictor = 0
+    index = 0
+    codes = []
+    for s in samples:
+        step = STEP_TABLE[index]
+        diff = s - predictor
+        code = 0
+        if diff < 0:
+            code = 8
+            diff = -diff
+        if diff >= step:
+            code |= 4
+            diff -= step
+        if diff >= step >> 1:
+            code |= 2
+            diff -= step >> 1
+        if diff >= step >> 2:
+            code |= 1
+
+        delta = step >> 3
+        if code & 4:
+            delta += step
+        if code & 2:
+            delta += step >> 1
+        if code & 1:
+            delta += step >> 2
+        predictor += -delta if code & 8 else delta
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + INDEX_TABLE[code]))
+        codes.append(code)
+
+    if len(codes) % 2:
+        codes.append(0)
+    return bytes(codes[i] | (codes[i + 1] << 4) for i in range(0, len(codes), 2))
+
+
+def pcm16_encode(samples):
+    return struct.pack('<%dh' % len(samples), *[max(-32768, min(32767, s)) for s in samples])
+
+
+def c_identifier(name):
+    ident = re.sub(r'[^0-9A-Za-z_]', '_', name)
+    if ident[:1].isdigit():
+        ident = '_' + ident
+    return ident
+
+
+def emit_c(entries, out):
+    out.write('// tools/wav2bank.py が生成（編集しないこと）\n\n')
+    out.write('#include "sample_bank.h"\n\n')
+
+    for ident, _, data, _, _ in entries:
+        out.write('static const uint8_t sample_%s[%d] __attribute__((aligned(4))) = {\n'
+                  % (ident, len(data)))
+        for i in range(0, len(data), 16):
+            out.write('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',\n')
+        out.write('};\n\n')
+
+    if entries:
+        out.write('const sample_t sample_bank[] = {\n')
+        for ident, name, data, frames, fmt in entries:
+            out.write('    { "%s", sample_%s, %d, %d, %s },\n'
+                      % (name, ident, len(data), frames, fmt))
+        out.write('};\n\n')
+    else:
+        # 空配列は C で書けないので、ダミーを1つ置いて数を 0 にする
+        out.write('const sample_t sample_bank[1] = { { "", 0, 0, 0, SAMPLE_FORMAT_PCM16 } };\n\n')
+
+    out.write('const uint32_t sample_bank_count = %d;\n' % len(entries))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build sample bank C source from WAV files')
+    parser.add_argument('wavs', nargs='*', help='input WAV files')
+    parser.add_argument('-o', '--output', required=True, help='output C file')
+    parser.add_argument('-r', '--rate', type=int, default=44100, help='target sample rate')
+    parser.add_argument('-f', '--format', choices=['adpcm', 'pcm16'], default='adpcm')
+    args = parser.parse_args()
+
+    entries = []
+    used = set()
+    for path in sorted(args.wavs):
+        name = os.path.splitext(os.path.basename(path))[0]
+        ident = c_identifier(name)
+        while ident in used:
+            ident += '_'
+        used.add(ident)
+
+        samples, rate = read_wav_mono(path)
+        samples = resample(samples, rate, args.rate)
+
+        if args.format == 'adpcm':
+            data = adpcm_encode(samples)
+            fmt = 'SAMPLE_FORMAT_IMA_ADPCM'
+        else:
+            data = pcm16_encode(samples)
+            fmt = 'SAMPLE_FORMAT_PCM16'
+        data += bytes((-len(data)) % 4)
+
+        entries.append((ident, name, data, len(samples), fmt))
+        print('wav2bank: %s -> %d frames, %d bytes' % (name, len(samples), len(data)),
+              file=sys.stderr)
+
+    out_dir = os.path.dirname(args.output)
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+    with open(args.output, 'w', encoding='utf-8') as out:
+        emit_c(entries, out)
+
+
+if __name__ == '__main__':
+    main()